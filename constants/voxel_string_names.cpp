@@ -82,7 +82,7 @@ VoxelStringNames::VoxelStringNames() {
 #endif
 
 	_rpc_receive_blocks = StringName("_rpc_receive_blocks");
-	_rpc_receive_area = StringName("_rpc_receive_area");
+	_rpc_receive_areas = StringName("_rpc_receive_areas");
 
 	unnamed = StringName("unnamed");
 	air = StringName("air");
@@ -116,6 +116,8 @@ VoxelStringNames::VoxelStringNames() {
 
 	_on_async_search_completed = StringName("_on_async_search_completed");
 	async_search_completed = StringName("async_search_completed");
+	_on_async_batch_completed = StringName("_on_async_batch_completed");
+	async_batch_completed = StringName("async_batch_completed");
 
 	file_selected = StringName("file_selected");
 }
@@ -77,7 +77,7 @@ public:
 #endif
 
 	StringName _rpc_receive_blocks;
-	StringName _rpc_receive_area;
+	StringName _rpc_receive_areas;
 
 	StringName unnamed;
 	StringName air;
@@ -103,6 +103,8 @@ public:
 
 	StringName _on_async_search_completed;
 	StringName async_search_completed;
+	StringName _on_async_batch_completed;
+	StringName async_batch_completed;
 
 	StringName file_selected;
 };
@@ -1,11 +1,14 @@
 #include "mesh_sdf.h"
+#include "../util/containers/fixed_array.h"
 #include "../util/math/box3i.h"
 #include "../util/math/conv.h"
+#include "../util/math/simd.h"
 #include "../util/math/triangle.h"
 #include "../util/math/vector3d.h"
 #include "../util/profiling.h"
 #include "../util/string/format.h" // Debug
 #include "../util/voxel_raycast.h"
+#include <algorithm>
 
 // Debug
 // #define ZN_MESH_SDF_DEBUG_SLICES
@@ -1004,6 +1007,327 @@ void generate_mesh_sdf_partitioned(
 	generate_mesh_sdf_partitioned(sdf_grid, res, Box3i(Vector3i(), res), min_pos, max_pos, chunk_grid);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BVH
+
+namespace {
+
+const unsigned int BVH_MAX_LEAF_TRIANGLES = 8;
+// Large enough for any amount of triangles, since nodes are split in halves
+const unsigned int BVH_MAX_DEPTH = 64;
+// Nodes further than this many times their radius are approximated when computing winding numbers. Higher values are
+// more accurate, but slower.
+const float BVH_WINDING_NUMBER_ACCURACY = 2.f;
+
+struct BVHBuildItem {
+	Vector3f center;
+	uint32_t triangle_index;
+};
+
+void build_bvh_node(TriangleBVH &bvh, Span<const Triangle> triangles, Span<BVHBuildItem> items, uint32_t begin) {
+	const uint32_t node_index = bvh.nodes.size();
+	bvh.nodes.push_back(TriangleBVH::Node());
+
+	TriangleBVH::Node node;
+	node.min_pos = triangles[items[0].triangle_index].v1;
+	node.max_pos = node.min_pos;
+	Vector3f center_min_pos = items[0].center;
+	Vector3f center_max_pos = center_min_pos;
+	node.dipole_normal = Vector3f();
+	Vector3f weighted_center_sum;
+	float area_sum = 0.f;
+
+	for (const BVHBuildItem &item : items) {
+		const Triangle &t = triangles[item.triangle_index];
+		node.min_pos = math::min(node.min_pos, math::min(t.v1, math::min(t.v2, t.v3)));
+		node.max_pos = math::max(node.max_pos, math::max(t.v1, math::max(t.v2, t.v3)));
+		center_min_pos = math::min(center_min_pos, item.center);
+		center_max_pos = math::max(center_max_pos, item.center);
+
+		// The length of `nor` is twice the area of the triangle
+		const float area = 0.5f * math::length(t.nor);
+		node.dipole_normal += t.nor * 0.5f;
+		weighted_center_sum += item.center * area;
+		area_sum += area;
+	}
+
+	node.dipole_center = weighted_center_sum / area_sum;
+	node.radius = 0.f;
+	for (const BVHBuildItem &item : items) {
+		const Triangle &t = triangles[item.triangle_index];
+		node.radius = math::max(node.radius, math::distance_squared(node.dipole_center, t.v1));
+		node.radius = math::max(node.radius, math::distance_squared(node.dipole_center, t.v2));
+		node.radius = math::max(node.radius, math::distance_squared(node.dipole_center, t.v3));
+	}
+	node.radius = Math::sqrt(node.radius);
+
+	if (items.size() <= BVH_MAX_LEAF_TRIANGLES) {
+		node.first = begin;
+		node.count = items.size();
+		bvh.nodes[node_index] = node;
+		return;
+	}
+
+	// Split in halves along the longest axis. Even if all centers are the same, this still splits.
+	const Vector3f center_extent = center_max_pos - center_min_pos;
+	unsigned int axis = center_extent.x > center_extent.y ? 0 : 1;
+	if (center_extent.z > center_extent[axis]) {
+		axis = 2;
+	}
+	const uint32_t half_count = items.size() / 2;
+	std::nth_element(
+			items.data(),
+			items.data() + half_count,
+			items.data() + items.size(),
+			[axis](const BVHBuildItem &a, const BVHBuildItem &b) { return a.center[axis] < b.center[axis]; }
+	);
+
+	build_bvh_node(bvh, triangles, items.sub(0, half_count), begin);
+	node.first = bvh.nodes.size();
+	node.count = 0;
+	build_bvh_node(bvh, triangles, items.sub(half_count), begin + half_count);
+
+	bvh.nodes[node_index] = node;
+}
+
+inline float get_distance_squared_to_box(const Vector3f pos, const Vector3f min_pos, const Vector3f max_pos) {
+	return math::length_squared(math::max(math::max(min_pos - pos, pos - max_pos), Vector3f()));
+}
+
+// Returns the index of the closest triangle. The hint is a triangle likely to be close, which allows to skip more
+// nodes.
+uint32_t find_closest_triangle(
+		const TriangleBVH &bvh,
+		const Vector3f pos,
+		uint32_t hint_triangle_index,
+		float &out_distance_squared
+) {
+	float min_distance_squared = get_distance_to_triangle_squared_precalc(bvh.triangles[hint_triangle_index], pos);
+	uint32_t closest_triangle_index = hint_triangle_index;
+
+	struct StackItem {
+		uint32_t node_index;
+		float distance_squared;
+	};
+	FixedArray<StackItem, BVH_MAX_DEPTH> stack;
+	unsigned int stack_size = 0;
+
+	FixedArray<float, BVH_MAX_LEAF_TRIANGLES> leaf_distances_squared;
+	const unsigned int coords_stride = bvh.triangles.size();
+
+	const TriangleBVH::Node &root = bvh.nodes[0];
+	stack[stack_size++] = StackItem{ 0, get_distance_squared_to_box(pos, root.min_pos, root.max_pos) };
+
+	while (stack_size > 0) {
+		const StackItem item = stack[--stack_size];
+		if (item.distance_squared >= min_distance_squared) {
+			// A closer triangle was found since the node was pushed
+			continue;
+		}
+
+		const TriangleBVH::Node &node = bvh.nodes[item.node_index];
+
+		if (node.count > 0) {
+			math::simd::triangle_distance_squared(
+					pos.x,
+					pos.y,
+					pos.z,
+					bvh.vertex_coords.data() + node.first,
+					coords_stride,
+					leaf_distances_squared.data(),
+					node.count
+			);
+			for (unsigned int i = 0; i < node.count; ++i) {
+				if (leaf_distances_squared[i] < min_distance_squared) {
+					min_distance_squared = leaf_distances_squared[i];
+					closest_triangle_index = node.first + i;
+				}
+			}
+			continue;
+		}
+
+		const uint32_t child0_index = item.node_index + 1;
+		const uint32_t child1_index = node.first;
+		const TriangleBVH::Node &child0 = bvh.nodes[child0_index];
+		const TriangleBVH::Node &child1 = bvh.nodes[child1_index];
+		StackItem near_item{ child0_index, get_distance_squared_to_box(pos, child0.min_pos, child0.max_pos) };
+		StackItem far_item{ child1_index, get_distance_squared_to_box(pos, child1.min_pos, child1.max_pos) };
+		if (far_item.distance_squared < near_item.distance_squared) {
+			std::swap(near_item, far_item);
+		}
+
+		ZN_ASSERT(stack_size + 2 <= stack.size());
+		// The nearest child is pushed last so it gets visited first
+		if (far_item.distance_squared < min_distance_squared) {
+			stack[stack_size++] = far_item;
+		}
+		if (near_item.distance_squared < min_distance_squared) {
+			stack[stack_size++] = near_item;
+		}
+	}
+
+	out_distance_squared = min_distance_squared;
+	return closest_triangle_index;
+}
+
+// Signed solid angle of a triangle seen from a position, positive when seeing its back face.
+inline float get_solid_angle(const Triangle &t, const Vector3f pos) {
+	// https://en.wikipedia.org/wiki/Solid_angle#Tetrahedron
+	const Vector3f a = t.v1 - pos;
+	const Vector3f b = t.v2 - pos;
+	const Vector3f c = t.v3 - pos;
+	const float la = math::length(a);
+	const float lb = math::length(b);
+	const float lc = math::length(c);
+	// Triangles are clockwise when seen from their front face
+	const float numerator = math::dot(a, math::cross(c, b));
+	const float denominator = la * lb * lc + math::dot(a, b) * lc + math::dot(b, c) * la + math::dot(c, a) * lb;
+	return 2.f * Math::atan2(numerator, denominator);
+}
+
+} // namespace
+
+void build_triangle_bvh(Span<const Triangle> triangles, TriangleBVH &bvh) {
+	ZN_PROFILE_SCOPE();
+
+	bvh.nodes.clear();
+	bvh.triangles.clear();
+	bvh.vertex_coords.clear();
+
+	StdVector<BVHBuildItem> items;
+	items.reserve(triangles.size());
+	for (unsigned int i = 0; i < triangles.size(); ++i) {
+		const Triangle &t = triangles[i];
+		// Degenerate triangles have no area, so they never are the only closest triangle and don't contribute to
+		// winding numbers
+		if (!(math::length_squared(t.nor) > 0.f)) {
+			continue;
+		}
+		items.push_back(BVHBuildItem{ (t.v1 + t.v2 + t.v3) / 3.f, i });
+	}
+
+	if (items.size() == 0) {
+		return;
+	}
+
+	build_bvh_node(bvh, triangles, to_span(items), 0);
+
+	const unsigned int count = items.size();
+	bvh.triangles.resize(count);
+	bvh.vertex_coords.resize(9 * count);
+	for (unsigned int i = 0; i < count; ++i) {
+		const Triangle &t = triangles[items[i].triangle_index];
+		bvh.triangles[i] = t;
+		float *coords = bvh.vertex_coords.data() + i;
+		coords[0] = t.v1.x;
+		coords[count] = t.v1.y;
+		coords[2 * count] = t.v1.z;
+		coords[3 * count] = t.v2.x;
+		coords[4 * count] = t.v2.y;
+		coords[5 * count] = t.v2.z;
+		coords[6 * count] = t.v3.x;
+		coords[7 * count] = t.v3.y;
+		coords[8 * count] = t.v3.z;
+	}
+}
+
+float get_winding_number(const TriangleBVH &bvh, const Vector3f pos) {
+	// Fast Winding Numbers for Soups and Clouds, Barill et al. 2018, using only the first order of the approximation
+	// https://www.dgp.toronto.edu/projects/fast-winding-numbers/
+
+	if (bvh.nodes.size() == 0) {
+		return 0.f;
+	}
+
+	float solid_angle_sum = 0.f;
+
+	FixedArray<uint32_t, BVH_MAX_DEPTH> stack;
+	unsigned int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0) {
+		const uint32_t node_index = stack[--stack_size];
+		const TriangleBVH::Node &node = bvh.nodes[node_index];
+
+		const Vector3f to_center = node.dipole_center - pos;
+		const float distance_squared = math::length_squared(to_center);
+
+		if (distance_squared > math::squared(BVH_WINDING_NUMBER_ACCURACY * node.radius)) {
+			// Far enough to use the approximation
+			const float distance_cubed = distance_squared * Math::sqrt(distance_squared);
+			solid_angle_sum += math::dot(node.dipole_normal, to_center) / distance_cubed;
+
+		} else if (node.count > 0) {
+			for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+				solid_angle_sum += get_solid_angle(bvh.triangles[i], pos);
+			}
+
+		} else {
+			ZN_ASSERT(stack_size + 2 <= stack.size());
+			stack[stack_size++] = node_index + 1;
+			stack[stack_size++] = node.first;
+		}
+	}
+
+	return solid_angle_sum / (4.f * math::PI_32);
+}
+
+void generate_mesh_sdf_bvh(
+		Span<float> sdf_grid,
+		const Vector3i res,
+		const Box3i sub_box,
+		const Vector3f min_pos,
+		const Vector3f max_pos,
+		const TriangleBVH &bvh
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT(Box3i(Vector3i(), res).contains(sub_box));
+	ZN_ASSERT(int64_t(sdf_grid.size()) == Vector3iUtil::get_volume(res));
+	ZN_ASSERT_RETURN(bvh.nodes.size() > 0);
+
+	const Vector3f mesh_size = max_pos - min_pos;
+	const Vector3f cell_size = mesh_size / Vector3f(res.x, res.y, res.z);
+	const GridToSpaceConverter grid_to_space(res, min_pos, mesh_size, cell_size * 0.5f);
+
+	const Vector3i sub_box_end = sub_box.position + sub_box.size;
+
+	// Neighbor cells are often closest to the same triangle
+	uint32_t hint_triangle_index = 0;
+
+	Vector3i grid_pos;
+	for (grid_pos.z = sub_box.position.z; grid_pos.z < sub_box_end.z; ++grid_pos.z) {
+		for (grid_pos.x = sub_box.position.x; grid_pos.x < sub_box_end.x; ++grid_pos.x) {
+			grid_pos.y = sub_box.position.y;
+			size_t grid_index = Vector3iUtil::get_zxy_index(grid_pos, res);
+
+			for (; grid_pos.y < sub_box_end.y; ++grid_pos.y) {
+				const Vector3f pos = grid_to_space(grid_pos);
+
+				float distance_squared;
+				hint_triangle_index = find_closest_triangle(bvh, pos, hint_triangle_index, distance_squared);
+				const float d = Math::sqrt(distance_squared);
+
+				ZN_ASSERT(grid_index < sdf_grid.size());
+				sdf_grid[grid_index] = get_winding_number(bvh, pos) > 0.5f ? -d : d;
+
+				++grid_index;
+			}
+		}
+	}
+}
+
+void generate_mesh_sdf_bvh(
+		Span<float> sdf_grid,
+		const Vector3i res,
+		Span<const Triangle> triangles,
+		const Vector3f min_pos,
+		const Vector3f max_pos
+) {
+	TriangleBVH bvh;
+	build_triangle_bvh(triangles, bvh);
+	generate_mesh_sdf_bvh(sdf_grid, res, Box3i(Vector3i(), res), min_pos, max_pos, bvh);
+}
+
 CheckResult check_sdf(
 		Span<const float> sdf_grid,
 		Vector3i res,
@@ -1173,7 +1497,11 @@ void GenMeshSDFSubBoxTask::run(ThreadedTaskContext &ctx) {
 	Span<float> sdf_grid;
 	ZN_ASSERT(buffer.get_channel_data(channel, sdf_grid));
 
-	if (shared_data->use_chunk_grid) {
+	if (shared_data->use_bvh) {
+		generate_mesh_sdf_bvh(
+				sdf_grid, buffer.get_size(), box, shared_data->min_pos, shared_data->max_pos, shared_data->bvh
+		);
+	} else if (shared_data->use_chunk_grid) {
 		generate_mesh_sdf_partitioned(
 				sdf_grid, buffer.get_size(), box, shared_data->min_pos, shared_data->max_pos, shared_data->chunk_grid
 		);
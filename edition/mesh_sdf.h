@@ -48,6 +48,31 @@ struct ChunkGrid {
 	float chunk_size; // Size of a cubic cell in space units
 };
 
+// Bounding volume hierarchy of triangles. Allows to find the closest triangle and to compute winding numbers without
+// checking every triangle.
+struct TriangleBVH {
+	struct Node {
+		Vector3f min_pos;
+		Vector3f max_pos;
+		// For leaves, index of the first triangle of the node. Otherwise, index of the second child node (the first
+		// child always comes right after its parent).
+		uint32_t first;
+		// Number of triangles in leaves, 0 otherwise.
+		uint32_t count;
+		// Triangles of the node seen from far away are approximated as one dipole, with the sum of their area-weighted
+		// normals located at their area-weighted center. Only used beyond a few times the radius of the node.
+		Vector3f dipole_normal;
+		Vector3f dipole_center;
+		float radius;
+	};
+
+	StdVector<Node> nodes;
+	// Triangles sorted such that each leaf references a contiguous range.
+	StdVector<Triangle> triangles;
+	// Vertices of the same triangles in structure-of-arrays layout, see `math::simd::triangle_distance_squared`.
+	StdVector<float> vertex_coords;
+};
+
 class GenMeshSDFSubBoxTask : public IThreadedTask {
 public:
 	struct SharedData {
@@ -58,6 +83,8 @@ public:
 		Vector3f max_pos;
 		ChunkGrid chunk_grid;
 		bool use_chunk_grid = false;
+		TriangleBVH bvh;
+		bool use_bvh = false;
 		bool boundary_sign_fix = false;
 
 		SharedData() : buffer(VoxelBuffer::ALLOCATOR_DEFAULT) {}
@@ -123,6 +150,25 @@ void generate_mesh_sdf_partitioned(
 		int subdiv
 );
 
+// Builds a bounding volume hierarchy from triangles prepared with `prepare_triangles()`. Degenerate triangles are
+// left out.
+void build_triangle_bvh(Span<const Triangle> triangles, TriangleBVH &bvh);
+
+// Gets the generalized winding number of the mesh at the given position: close to 1 inside, close to 0 outside, and
+// still meaningful if the mesh has holes or overlapping parts. Triangles far from the position are approximated.
+float get_winding_number(const TriangleBVH &bvh, Vector3f pos);
+
+// Computes the SDF with the same distances as the naive method, using a bounding volume hierarchy to skip triangles
+// that can't be the closest, and SIMD to check several triangles at once. Signs are found with winding numbers instead
+// of the closest triangle, so they don't suffer from ambiguities where triangles meet.
+void generate_mesh_sdf_bvh(
+		Span<float> sdf_grid,
+		const Vector3i res,
+		Span<const Triangle> triangles,
+		const Vector3f min_pos,
+		const Vector3f max_pos
+);
+
 // Generates an approximation.
 // Subdivides the grid into nodes spanning 4*4*4 cells each.
 // If a node's corner distances are close to the surface, the SDF is fully evaluated. Otherwise, it is interpolated.
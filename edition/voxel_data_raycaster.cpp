@@ -0,0 +1,299 @@
+#include "voxel_data_raycaster.h"
+#include "../constants/voxel_constants.h"
+#include "../storage/voxel_buffer.h"
+#include "../storage/voxel_data.h"
+#include "../util/math/conv.h"
+#include "../util/profiling.h"
+#include "../util/voxel_raycast.h"
+
+namespace zylann::voxel {
+
+VoxelDataRaycaster::VoxelDataRaycaster(VoxelData &data, Mode mode, bool occupancy_enabled) :
+		_data(data), _mode(mode) {
+	_block_size_po2 = data.get_block_size_po2();
+	_occupancy_enabled = occupancy_enabled && _block_size_po2 > OCCUPANCY_CELL_SIZE_PO2 &&
+			_block_size_po2 <= MAX_OCCUPANCY_BLOCK_SIZE_PO2;
+	_cell_size_po2 = _occupancy_enabled ? OCCUPANCY_CELL_SIZE_PO2 : _block_size_po2;
+}
+
+VoxelDataRaycaster::~VoxelDataRaycaster() {
+	leave_block();
+}
+
+void VoxelDataRaycaster::set_blocky_models(
+		const VoxelBlockyLibraryBase::BakedData &baked_data,
+		uint32_t collision_mask
+) {
+	// Block information depends on it
+	ZN_ASSERT_RETURN(_blocks.size() == 0);
+	_baked_data = &baked_data;
+	_collision_mask = collision_mask;
+}
+
+bool VoxelDataRaycaster::raycast(Vector3 origin, Vector3 direction, float max_distance, Hit &out_hit) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(_mode != MODE_BLOCKY || _baked_data != nullptr, false);
+
+	_ray_from = origin;
+	_ray_to = origin + direction * max_distance;
+
+	Vector3i hit_position;
+	Vector3i prev_position;
+	float hit_distance;
+	float prev_distance;
+
+	const bool hit = voxel_raycast_hierarchical(
+			origin,
+			direction,
+			_cell_size_po2,
+			[this](Vector3i cell_position) { return is_cell_relevant(cell_position); },
+			[this](const VoxelRaycastState &rs) { return is_voxel_hit(rs.hit_position); },
+			max_distance,
+			hit_position,
+			prev_position,
+			hit_distance,
+			prev_distance
+	);
+
+	leave_block();
+	_block = nullptr;
+
+	if (hit) {
+		out_hit.position = hit_position;
+		out_hit.previous_position = prev_position;
+		out_hit.distance = hit_distance;
+		out_hit.previous_distance = prev_distance;
+	}
+	return hit;
+}
+
+bool VoxelDataRaycaster::is_cell_relevant(Vector3i cell_position) {
+	const unsigned int cells_per_block_po2 = _block_size_po2 - _cell_size_po2;
+	const Vector3i block_position = cell_position >> cells_per_block_po2;
+
+	if (_block == nullptr || block_position != _block_position) {
+		enter_block(block_position);
+	}
+
+	switch (_block->state) {
+		case BlockInfo::STATE_EMPTY:
+			return false;
+
+		case BlockInfo::STATE_QUERY:
+			return true;
+
+		case BlockInfo::STATE_VOXELS: {
+			if (!_block->has_occupancy) {
+				return true;
+			}
+			const Vector3i rpos = cell_position - (block_position << cells_per_block_po2);
+			const unsigned int i =
+					rpos.x | (rpos.y << cells_per_block_po2) | (rpos.z << (2 * cells_per_block_po2));
+			return (_block->occupancy[i >> 6] & (uint64_t(1) << (i & 63))) != 0;
+		}
+
+		default:
+			ZN_PRINT_ERROR("Unhandled state");
+			return true;
+	}
+}
+
+bool VoxelDataRaycaster::is_voxel_hit(Vector3i position) {
+#ifdef DEV_ENABLED
+	ZN_ASSERT(_block != nullptr);
+	ZN_ASSERT((position >> _block_size_po2) == _block_position);
+#endif
+
+	switch (_block->state) {
+		case BlockInfo::STATE_EMPTY:
+			return false;
+
+		case BlockInfo::STATE_VOXELS: {
+			const Vector3i rpos = position - (_block_position << _block_size_po2);
+			if (_mode == MODE_BLOCKY) {
+				return is_blocky_model_hit(_block->voxels->get_voxel(rpos, VoxelBuffer::CHANNEL_TYPE), position);
+			}
+			return is_voxel_value_hit(*_block->voxels, rpos);
+		}
+
+		case BlockInfo::STATE_QUERY: {
+			// This is not particularly optimized, but such blocks are not common
+			switch (_mode) {
+				case MODE_SDF: {
+					VoxelSingleValue defval;
+					defval.f = constants::SDF_FAR_OUTSIDE;
+					return _data.get_voxel(position, VoxelBuffer::CHANNEL_SDF, defval).f < 0;
+				}
+				case MODE_COLOR: {
+					VoxelSingleValue defval;
+					defval.i = 0;
+					return _data.get_voxel(position, VoxelBuffer::CHANNEL_COLOR, defval).i != 0;
+				}
+				case MODE_BLOCKY: {
+					VoxelSingleValue defval;
+					defval.i = 0;
+					const uint64_t v = _data.get_voxel(position, VoxelBuffer::CHANNEL_TYPE, defval).i;
+					return is_blocky_model_hit(v, position);
+				}
+				default:
+					ZN_PRINT_ERROR("Unhandled mode");
+					return false;
+			}
+		}
+
+		default:
+			ZN_PRINT_ERROR("Unhandled state");
+			return false;
+	}
+}
+
+void VoxelDataRaycaster::enter_block(Vector3i block_position) {
+	leave_block();
+	_block_position = block_position;
+
+	auto it = _blocks.find(block_position);
+	if (it != _blocks.end()) {
+		_block = &it->second;
+		if (_block->state == BlockInfo::STATE_VOXELS) {
+			_data.get_spatial_lock(0).lock_read(BoxBounds3i::from_position(block_position));
+			_block_locked = true;
+		}
+		return;
+	}
+
+	BlockInfo &info = _blocks[block_position];
+	_block = &info;
+	init_block_info(info, block_position);
+}
+
+void VoxelDataRaycaster::leave_block() {
+	if (_block_locked) {
+		_data.get_spatial_lock(0).unlock_read(BoxBounds3i::from_position(_block_position));
+		_block_locked = false;
+	}
+}
+
+void VoxelDataRaycaster::init_block_info(BlockInfo &info, Vector3i block_position) {
+	const Box3i box_in_voxels(block_position << _block_size_po2, Vector3iUtil::create(1 << _block_size_po2));
+	if (!_data.get_bounds().intersects(box_in_voxels)) {
+		info.state = BlockInfo::STATE_EMPTY;
+		return;
+	}
+
+	SpatialLock3D &spatial_lock = _data.get_spatial_lock(0);
+	spatial_lock.lock_read(BoxBounds3i::from_position(block_position));
+
+	info.voxels = _data.try_get_block_voxels(block_position);
+
+	if (info.voxels == nullptr) {
+		spatial_lock.unlock_read(BoxBounds3i::from_position(block_position));
+
+		if (_data.is_streaming_enabled() && _data.get_lod_count() == 1 && !_data.has_block(block_position, 0)) {
+			// Not loaded, queries would return default values, which are empty
+			info.state = BlockInfo::STATE_EMPTY;
+		} else {
+			info.state = BlockInfo::STATE_QUERY;
+		}
+		return;
+	}
+
+	// Kept locked while the ray is in the block
+	_block_locked = true;
+
+	const VoxelBuffer &voxels = *info.voxels;
+	bool empty = false;
+	switch (_mode) {
+		case MODE_SDF:
+			empty = voxels.get_channel_compression(VoxelBuffer::CHANNEL_SDF) == VoxelBuffer::COMPRESSION_UNIFORM &&
+					voxels.get_voxel_f(Vector3i(), VoxelBuffer::CHANNEL_SDF) >= 0.f;
+			break;
+		case MODE_COLOR:
+			empty = voxels.get_channel_compression(VoxelBuffer::CHANNEL_COLOR) == VoxelBuffer::COMPRESSION_UNIFORM &&
+					voxels.get_voxel(Vector3i(), VoxelBuffer::CHANNEL_COLOR) == 0;
+			break;
+		case MODE_BLOCKY:
+			empty = voxels.get_channel_compression(VoxelBuffer::CHANNEL_TYPE) == VoxelBuffer::COMPRESSION_UNIFORM &&
+					!is_blocky_model_colliding(voxels.get_voxel(Vector3i(), VoxelBuffer::CHANNEL_TYPE));
+			break;
+		default:
+			ZN_PRINT_ERROR("Unhandled mode");
+			break;
+	}
+
+	if (empty) {
+		info.state = BlockInfo::STATE_EMPTY;
+		info.voxels.reset();
+		leave_block();
+		return;
+	}
+
+	info.state = BlockInfo::STATE_VOXELS;
+
+	if (_occupancy_enabled) {
+		compute_occupancy(info);
+	}
+}
+
+void VoxelDataRaycaster::compute_occupancy(BlockInfo &info) const {
+	ZN_PROFILE_SCOPE();
+
+	const VoxelBuffer &voxels = *info.voxels;
+	const unsigned int cells_per_block_po2 = _block_size_po2 - _cell_size_po2;
+	const int block_size = 1 << _block_size_po2;
+
+	fill(info.occupancy, uint64_t(0));
+
+	Vector3i rpos;
+	for (rpos.z = 0; rpos.z < block_size; ++rpos.z) {
+		for (rpos.x = 0; rpos.x < block_size; ++rpos.x) {
+			for (rpos.y = 0; rpos.y < block_size; ++rpos.y) {
+				const bool solid = _mode == MODE_BLOCKY
+						? is_blocky_model_colliding(voxels.get_voxel(rpos, VoxelBuffer::CHANNEL_TYPE))
+						: is_voxel_value_hit(voxels, rpos);
+				if (solid) {
+					const Vector3i cpos = rpos >> _cell_size_po2;
+					const unsigned int i =
+							cpos.x | (cpos.y << cells_per_block_po2) | (cpos.z << (2 * cells_per_block_po2));
+					info.occupancy[i >> 6] |= uint64_t(1) << (i & 63);
+				}
+			}
+		}
+	}
+
+	info.has_occupancy = true;
+}
+
+bool VoxelDataRaycaster::is_voxel_value_hit(const VoxelBuffer &voxels, Vector3i rpos) const {
+	switch (_mode) {
+		case MODE_SDF:
+			return voxels.get_voxel_f(rpos, VoxelBuffer::CHANNEL_SDF) < 0.f;
+		case MODE_COLOR:
+			return voxels.get_voxel(rpos, VoxelBuffer::CHANNEL_COLOR) != 0;
+		default:
+			ZN_PRINT_ERROR("Unhandled mode");
+			return false;
+	}
+}
+
+bool VoxelDataRaycaster::is_blocky_model_colliding(uint32_t model_index) const {
+	if (!_baked_data->has_model(model_index)) {
+		return false;
+	}
+	const VoxelBlockyModel::BakedData &model = _baked_data->models[model_index];
+	return (model.box_collision_mask & _collision_mask) != 0 && model.box_collision_aabbs.size() > 0;
+}
+
+bool VoxelDataRaycaster::is_blocky_model_hit(uint32_t model_index, Vector3i position) const {
+	if (!is_blocky_model_colliding(model_index)) {
+		return false;
+	}
+	const VoxelBlockyModel::BakedData &model = _baked_data->models[model_index];
+	for (const AABB &aabb : model.box_collision_aabbs) {
+		if (AABB(aabb.position + position, aabb.size).intersects_segment(_ray_from, _ray_to)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,109 @@
+#ifndef VOXEL_DATA_RAYCASTER_H
+#define VOXEL_DATA_RAYCASTER_H
+
+#include "../meshers/blocky/voxel_blocky_library_base.h"
+#include "../util/containers/fixed_array.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/math/vector3.h"
+#include "../util/math/vector3i.h"
+
+#include <memory>
+
+namespace zylann::voxel {
+
+class VoxelData;
+class VoxelBuffer;
+
+// Casts rays against the voxels of a `VoxelData`.
+//
+// Rays first go through blocks, and whole blocks are skipped when they are known to be empty (missing with streaming,
+// outside bounds, or uniformly filled with empty voxels). Voxels of other blocks are read directly from their buffer,
+// locking the block once while the ray is inside, instead of looking up and locking the block at every step.
+//
+// Optionally, an occupancy bitmask can be computed for each block the first time a ray enters it, telling which groups
+// of 4x4x4 voxels contain something. Rays then skip empty groups too. This requires going through all voxels of the
+// block, so it only pays off when many rays are cast with the same instance, such as with `VoxelTool.raycast_many`.
+// Information about blocks is kept for the lifetime of the instance, so it should not be kept longer than the batch of
+// rays it is used for.
+class VoxelDataRaycaster {
+public:
+	enum Mode {
+		// Hits voxels with negative SDF
+		MODE_SDF,
+		// Hits voxels with non-zero color
+		MODE_COLOR,
+		// Hits collision boxes of blocky models
+		MODE_BLOCKY,
+	};
+
+	struct Hit {
+		Vector3i position;
+		Vector3i previous_position;
+		float distance;
+		float previous_distance;
+	};
+
+	VoxelDataRaycaster(VoxelData &data, Mode mode, bool occupancy_enabled);
+	~VoxelDataRaycaster();
+
+	// Required in blocky mode. Only models having collision boxes matching the mask can be hit.
+	void set_blocky_models(const VoxelBlockyLibraryBase::BakedData &baked_data, uint32_t collision_mask);
+
+	// Direction must be normalized. Coordinates are in voxels.
+	bool raycast(Vector3 origin, Vector3 direction, float max_distance, Hit &out_hit);
+
+private:
+	// Occupancy is stored per group of 4x4x4 voxels, and supports blocks up to 32 voxels.
+	static constexpr unsigned int OCCUPANCY_CELL_SIZE_PO2 = 2;
+	static constexpr unsigned int MAX_OCCUPANCY_BLOCK_SIZE_PO2 = 5;
+	static constexpr unsigned int OCCUPANCY_WORD_COUNT =
+			1 << (3 * (MAX_OCCUPANCY_BLOCK_SIZE_PO2 - OCCUPANCY_CELL_SIZE_PO2) - 6);
+
+	struct BlockInfo {
+		enum State : uint8_t {
+			// Nothing can be hit in the block
+			STATE_EMPTY,
+			// Voxels can be read from the buffer
+			STATE_VOXELS,
+			// Voxels must be queried one by one, they may come from the generator or another LOD
+			STATE_QUERY,
+		};
+		State state = STATE_EMPTY;
+		bool has_occupancy = false;
+		std::shared_ptr<VoxelBuffer> voxels;
+		FixedArray<uint64_t, OCCUPANCY_WORD_COUNT> occupancy;
+	};
+
+	bool is_cell_relevant(Vector3i cell_position);
+	bool is_voxel_hit(Vector3i position);
+	void enter_block(Vector3i block_position);
+	void leave_block();
+	void init_block_info(BlockInfo &info, Vector3i block_position);
+	void compute_occupancy(BlockInfo &info) const;
+	bool is_voxel_value_hit(const VoxelBuffer &voxels, Vector3i rpos) const;
+	bool is_blocky_model_colliding(uint32_t model_index) const;
+	bool is_blocky_model_hit(uint32_t model_index, Vector3i position) const;
+
+	VoxelData &_data;
+	const Mode _mode;
+	bool _occupancy_enabled;
+	const VoxelBlockyLibraryBase::BakedData *_baked_data = nullptr;
+	uint32_t _collision_mask = 0;
+
+	unsigned int _block_size_po2;
+	unsigned int _cell_size_po2;
+
+	StdUnorderedMap<Vector3i, BlockInfo> _blocks;
+	// Block the ray is currently in
+	BlockInfo *_block = nullptr;
+	Vector3i _block_position;
+	bool _block_locked = false;
+
+	// Segment of the current ray, used in blocky mode
+	Vector3 _ray_from;
+	Vector3 _ray_to;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_DATA_RAYCASTER_H
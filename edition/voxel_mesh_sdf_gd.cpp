@@ -145,6 +145,9 @@ void VoxelMeshSDF::bake() {
 		case BAKE_MODE_APPROX_INTERP:
 			mesh_sdf::generate_mesh_sdf_approx_interp(sdf_grid, res, to_span(triangles), box_min_pos, box_max_pos);
 			break;
+		case BAKE_MODE_ACCURATE_BVH:
+			mesh_sdf::generate_mesh_sdf_bvh(sdf_grid, res, to_span(triangles), box_min_pos, box_max_pos);
+			break;
 		case BAKE_MODE_APPROX_FLOODFILL: {
 			mesh_sdf::ChunkGrid chunk_grid;
 			mesh_sdf::partition_triangles(_partition_subdiv, to_span(triangles), box_min_pos, box_max_pos, chunk_grid);
@@ -249,8 +252,9 @@ void VoxelMeshSDF::bake_async(SceneTree *scene_tree) {
 
 			switch (bake_mode) {
 				case BAKE_MODE_ACCURATE_NAIVE:
-				case BAKE_MODE_ACCURATE_PARTITIONED: {
-					// These two approaches are better parallelized
+				case BAKE_MODE_ACCURATE_PARTITIONED:
+				case BAKE_MODE_ACCURATE_BVH: {
+					// These approaches are better parallelized
 
 					const bool partitioned = bake_mode == BAKE_MODE_ACCURATE_PARTITIONED;
 					if (partitioned) {
@@ -265,6 +269,11 @@ void VoxelMeshSDF::bake_async(SceneTree *scene_tree) {
 					}
 					shared_data->use_chunk_grid = partitioned;
 
+					if (bake_mode == BAKE_MODE_ACCURATE_BVH) {
+						mesh_sdf::build_triangle_bvh(to_span(shared_data->triangles), shared_data->bvh);
+						shared_data->use_bvh = true;
+					}
+
 					shared_data->boundary_sign_fix = boundary_sign_fix;
 
 					// Spawn a parallel task for every Z slice of the grid.
@@ -387,8 +396,11 @@ std::shared_ptr<ComputeShaderResource> VoxelMeshSDF::get_gpu_resource() {
 	if (_gpu_resource == nullptr && _voxel_buffer.is_valid()) {
 		const VoxelBuffer &buffer = _voxel_buffer->get_buffer();
 
+		StdVector<uint8_t> decoded_sdf;
 		Span<const float> sdf_grid;
-		ZN_ASSERT_RETURN_V(buffer.get_channel_data_read_only(VoxelBuffer::CHANNEL_SDF, sdf_grid), _gpu_resource);
+		ZN_ASSERT_RETURN_V(
+				buffer.get_channel_data_read_only(VoxelBuffer::CHANNEL_SDF, sdf_grid, decoded_sdf), _gpu_resource
+		);
 
 		std::shared_ptr<ComputeShaderResource> resource = make_shared_instance<ComputeShaderResource>();
 		resource->create_texture_3d_zxy(sdf_grid, buffer.get_size());
@@ -404,8 +416,9 @@ Array VoxelMeshSDF::debug_check_sdf(Ref<Mesh> mesh) {
 	ZN_ASSERT_RETURN_V(is_baked(), result);
 	ZN_ASSERT(_voxel_buffer.is_valid());
 	const VoxelBuffer &buffer = _voxel_buffer->get_buffer();
+	StdVector<uint8_t> decoded_sdf;
 	Span<const float> sdf_grid;
-	ZN_ASSERT_RETURN_V(buffer.get_channel_data_read_only(VoxelBuffer::CHANNEL_SDF, sdf_grid), result);
+	ZN_ASSERT_RETURN_V(buffer.get_channel_data_read_only(VoxelBuffer::CHANNEL_SDF, sdf_grid, decoded_sdf), result);
 
 	ZN_ASSERT_RETURN_V(mesh.is_valid(), result);
 	StdVector<mesh_sdf::Triangle> triangles;
@@ -446,11 +459,14 @@ Dictionary VoxelMeshSDF::_b_get_data() const {
 
 	d["res"] = vb.get_size();
 
+	ERR_FAIL_COND_V(vb.get_channel_depth(VoxelBuffer::CHANNEL_SDF) != VoxelBuffer::DEPTH_32_BIT, Dictionary());
 	PackedFloat32Array sdf_f32;
 	sdf_f32.resize(Vector3iUtil::get_volume(vb.get_size()));
-	Span<const float> channel;
-	ERR_FAIL_COND_V(!vb.get_channel_data_read_only(VoxelBuffer::CHANNEL_SDF, channel), Dictionary());
-	memcpy(sdf_f32.ptrw(), channel.data(), channel.size() * sizeof(float));
+	// Decodes palette-compressed channels as well
+	vb.copy_channel_to_bytes(
+			VoxelBuffer::CHANNEL_SDF,
+			Span<uint8_t>(reinterpret_cast<uint8_t *>(sdf_f32.ptrw()), sdf_f32.size() * sizeof(float))
+	);
 	d["sdf_f32"] = sdf_f32;
 
 	d["min_pos"] = to_vec3(_min_pos);
@@ -559,7 +575,7 @@ void VoxelMeshSDF::_bind_methods() {
 					Variant::INT,
 					"bake_mode",
 					PROPERTY_HINT_ENUM,
-					"AccurateNaive,AccuratePartitioned,ApproxInterp,FloodFill"
+					"AccurateNaive,AccuratePartitioned,ApproxInterp,FloodFill,AccurateBVH"
 			),
 			"set_bake_mode",
 			"get_bake_mode"
@@ -595,6 +611,7 @@ void VoxelMeshSDF::_bind_methods() {
 	BIND_ENUM_CONSTANT(BAKE_MODE_ACCURATE_PARTITIONED);
 	BIND_ENUM_CONSTANT(BAKE_MODE_APPROX_INTERP);
 	BIND_ENUM_CONSTANT(BAKE_MODE_APPROX_FLOODFILL);
+	BIND_ENUM_CONSTANT(BAKE_MODE_ACCURATE_BVH);
 	BIND_ENUM_CONSTANT(BAKE_MODE_COUNT);
 }
 
@@ -91,6 +91,20 @@ Ref<VoxelRaycastResult> VoxelTool::raycast(Vector3 pos, Vector3 dir, float max_d
 	// See derived classes for implementations
 }
 
+void VoxelTool::raycast_many(
+		Span<const Vector3> origins,
+		Span<const Vector3> directions,
+		Span<const float> max_distances,
+		uint32_t collision_mask,
+		Span<float> out_distances
+) {
+	// Generic implementation, derived classes may do it more efficiently
+	for (unsigned int i = 0; i < origins.size(); ++i) {
+		Ref<VoxelRaycastResult> res = raycast(origins[i], directions[i], max_distances[i], collision_mask);
+		out_distances[i] = res.is_valid() ? res->distance_along_ray : -1.f;
+	}
+}
+
 uint64_t VoxelTool::get_voxel(Vector3i pos) const {
 	return _get_voxel(pos);
 }
@@ -427,6 +441,26 @@ void VoxelTool::_b_do_box(Vector3i begin, Vector3i end) {
 	do_box(begin, end);
 }
 
+PackedFloat32Array VoxelTool::_b_raycast_many(
+		PackedVector3Array origins,
+		PackedVector3Array directions,
+		PackedFloat32Array max_distances,
+		uint32_t collision_mask
+) {
+	PackedFloat32Array distances;
+	ERR_FAIL_COND_V(origins.size() != directions.size(), distances);
+	ERR_FAIL_COND_V(origins.size() != max_distances.size(), distances);
+	distances.resize(origins.size());
+	raycast_many(
+			to_span(origins),
+			to_span(directions),
+			to_span(max_distances),
+			collision_mask,
+			Span<float>(distances.ptrw(), distances.size())
+	);
+	return distances;
+}
+
 void VoxelTool::_b_do_path(PackedVector3Array positions, PackedFloat32Array radii) {
 	do_path(to_span(positions), to_span(radii));
 }
@@ -575,6 +609,11 @@ void VoxelTool::_bind_methods() {
 			DEFVAL(10.0),
 			DEFVAL(0xffffffff)
 	);
+	ClassDB::bind_method(
+			D_METHOD("raycast_many", "origins", "directions", "max_distances", "collision_mask"),
+			&VoxelTool::_b_raycast_many,
+			DEFVAL(0xffffffff)
+	);
 
 	ClassDB::bind_method(D_METHOD("is_area_editable", "box"), &VoxelTool::_b_is_area_editable);
 
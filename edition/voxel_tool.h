@@ -101,6 +101,15 @@ public:
 	void grow_sphere(Vector3 sphere_center, float sphere_radius, float strength);
 
 	virtual Ref<VoxelRaycastResult> raycast(Vector3 pos, Vector3 dir, float max_distance, uint32_t collision_mask);
+	// Casts many rays at once, which is cheaper than calling `raycast` for each of them. Hit distances are written to
+	// `out_distances`, or -1 for rays that didn't hit anything.
+	virtual void raycast_many(
+			Span<const Vector3> origins,
+			Span<const Vector3> directions,
+			Span<const float> max_distances,
+			uint32_t collision_mask,
+			Span<float> out_distances
+	);
 
 	// Checks if an edit affecting the given box can be applied, fully or partially
 	virtual bool is_area_editable(const Box3i &box) const;
@@ -128,6 +137,12 @@ private:
 	void _b_set_voxel(Vector3i pos, uint64_t v);
 	void _b_set_voxel_f(Vector3i pos, float v);
 	Ref<VoxelRaycastResult> _b_raycast(Vector3 pos, Vector3 dir, float max_distance, uint32_t collision_mask);
+	PackedFloat32Array _b_raycast_many(
+			PackedVector3Array origins,
+			PackedVector3Array directions,
+			PackedFloat32Array max_distances,
+			uint32_t collision_mask
+	);
 	void _b_do_point(Vector3i pos);
 	void _b_do_sphere(Vector3 pos, float radius);
 	void _b_do_box(Vector3i begin, Vector3i end);
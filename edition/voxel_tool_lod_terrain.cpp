@@ -17,8 +17,8 @@
 #include "../util/math/conv.h"
 #include "../util/string/format.h"
 #include "../util/tasks/async_dependency_tracker.h"
-#include "../util/voxel_raycast.h"
 #include "funcs.h"
+#include "voxel_data_raycaster.h"
 #include "voxel_mesh_sdf_gd.h"
 
 namespace zylann::voxel {
@@ -91,35 +91,65 @@ Ref<VoxelRaycastResult> VoxelToolLodTerrain::raycast(
 		float max_distance,
 		uint32_t collision_mask
 ) {
+	ERR_FAIL_COND_V(_terrain == nullptr, Ref<VoxelRaycastResult>());
+
 	// TODO Transform input if the terrain is rotated
 	// TODO Implement reverse raycast? (going from inside ground to air, could be useful for undigging)
 
-	// TODO Optimization: voxel raycast uses `get_voxel` which is the slowest, but could be made faster.
-	// Instead, do a broad-phase on blocks. If a block's voxels need to be parsed, get all positions the ray could go
-	// through in that block, then query them all at once (better for bulk processing without going again through
-	// locking and data structures, and allows SIMD). Then check results in order.
-	// If no hit is found, carry on with next blocks.
-
-	struct RaycastPredicate {
-		VoxelData &data;
-
-		bool operator()(const VoxelRaycastState &rs) {
-			// This is not particularly optimized, but runs fast enough for player raycasts
-			VoxelSingleValue defval;
-			defval.f = constants::SDF_FAR_OUTSIDE;
-			const VoxelSingleValue v = data.get_voxel(rs.hit_position, VoxelBuffer::CHANNEL_SDF, defval);
-			return v.f < 0;
-		}
-	};
-
 	Ref<VoxelRaycastResult> res;
 
-	// We use grid-raycast as a middle-phase to roughly detect where the hit will be
-	RaycastPredicate predicate = { _terrain->get_storage() };
+	VoxelDataRaycaster raycaster(_terrain->get_storage(), VoxelDataRaycaster::MODE_SDF, false);
+	float distance;
 	Vector3i hit_pos;
 	Vector3i prev_pos;
-	float hit_distance;
-	float hit_distance_prev;
+	if (raycast_sdf(raycaster, pos, dir, max_distance, distance, hit_pos, prev_pos)) {
+		res.instantiate();
+		res->position = hit_pos;
+		res->previous_position = prev_pos;
+		res->distance_along_ray = distance;
+	}
+
+	return res;
+}
+
+void VoxelToolLodTerrain::raycast_many(
+		Span<const Vector3> origins,
+		Span<const Vector3> directions,
+		Span<const float> max_distances,
+		uint32_t collision_mask,
+		Span<float> out_distances
+) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+	ZN_ASSERT_RETURN(origins.size() == directions.size());
+	ZN_ASSERT_RETURN(origins.size() == max_distances.size());
+	ZN_ASSERT_RETURN(origins.size() == out_distances.size());
+
+	// Rays share information about blocks, so with enough of them it is worth computing occupancy
+	VoxelDataRaycaster raycaster(_terrain->get_storage(), VoxelDataRaycaster::MODE_SDF, origins.size() > 1);
+
+	for (unsigned int i = 0; i < origins.size(); ++i) {
+		float distance;
+		Vector3i hit_pos;
+		Vector3i prev_pos;
+		if (raycast_sdf(raycaster, origins[i], directions[i], max_distances[i], distance, hit_pos, prev_pos)) {
+			out_distances[i] = distance;
+		} else {
+			out_distances[i] = -1.f;
+		}
+	}
+}
+
+bool VoxelToolLodTerrain::raycast_sdf(
+		VoxelDataRaycaster &raycaster,
+		Vector3 pos,
+		Vector3 dir,
+		float max_distance,
+		float &out_distance,
+		Vector3i &out_hit_pos,
+		Vector3i &out_prev_pos
+) const {
+	// We use grid-raycast as a middle-phase to roughly detect where the hit will be.
 	// Voxels polygonized using marching cubes influence a region centered on their lower corner,
 	// and extend up to 0.5 units in all directions.
 	//
@@ -133,45 +163,46 @@ Ref<VoxelRaycastResult> VoxelToolLodTerrain::raycast(
 	//   | C      |     D  |
 	//   o--------o--------o
 	//
-	// `voxel_raycast` operates on a discrete grid of cubic voxels, so to account for the smooth interpolation,
+	// Grid raycast operates on a discrete grid of cubic voxels, so to account for the smooth interpolation,
 	// we may offset the ray so that cubes act as if they were centered on the filtered result.
 	const Vector3 offset(0.5, 0.5, 0.5);
-	if (voxel_raycast(pos + offset, dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev)) {
-		// Approximate surface
+	VoxelDataRaycaster::Hit hit;
+	if (!raycaster.raycast(pos + offset, dir, max_distance, hit)) {
+		return false;
+	}
 
-		float d = hit_distance;
+	// Approximate surface
 
-		if (_raycast_binary_search_iterations > 0) {
-			// This is not particularly optimized, but runs fast enough for player raycasts
-			struct VolumeSampler {
-				VoxelData &data;
+	float d = hit.distance;
 
-				inline float operator()(const Vector3i &pos) const {
-					VoxelSingleValue defval;
-					defval.f = constants::SDF_FAR_OUTSIDE;
-					const VoxelSingleValue value = data.get_voxel(pos, VoxelBuffer::CHANNEL_SDF, defval);
-					return value.f;
-				}
-			};
-
-			VolumeSampler sampler{ _terrain->get_storage() };
-			d = hit_distance_prev +
-					approximate_distance_to_isosurface_binary_search(
-							sampler,
-							pos + dir * hit_distance_prev,
-							dir,
-							hit_distance - hit_distance_prev,
-							_raycast_binary_search_iterations
-					);
-		}
+	if (_raycast_binary_search_iterations > 0) {
+		// This is not particularly optimized, but runs fast enough for player raycasts
+		struct VolumeSampler {
+			VoxelData &data;
 
-		res.instantiate();
-		res->position = hit_pos;
-		res->previous_position = prev_pos;
-		res->distance_along_ray = d;
+			inline float operator()(const Vector3i &pos) const {
+				VoxelSingleValue defval;
+				defval.f = constants::SDF_FAR_OUTSIDE;
+				const VoxelSingleValue value = data.get_voxel(pos, VoxelBuffer::CHANNEL_SDF, defval);
+				return value.f;
+			}
+		};
+
+		VolumeSampler sampler{ _terrain->get_storage() };
+		d = hit.previous_distance +
+				approximate_distance_to_isosurface_binary_search(
+						sampler,
+						pos + dir * hit.previous_distance,
+						dir,
+						hit.distance - hit.previous_distance,
+						_raycast_binary_search_iterations
+				);
 	}
 
-	return res;
+	out_distance = d;
+	out_hit_pos = hit.position;
+	out_prev_pos = hit.previous_position;
+	return true;
 }
 
 void VoxelToolLodTerrain::do_box(Vector3i begin, Vector3i end) {
@@ -983,7 +1014,9 @@ void VoxelToolLodTerrain::stamp_sdf(
 	op.shape.sdf_scale = sdf_scale;
 	// Note, the passed buffer must not be shared with another thread.
 	// buffer.decompress_channel(channel);
-	ZN_ASSERT_RETURN(buffer.get_channel_data_read_only(channel, op.shape.buffer));
+	// Only used if the channel is palette-compressed
+	StdVector<uint8_t> decoded_sdf;
+	ZN_ASSERT_RETURN(buffer.get_channel_data_read_only(channel, op.shape.buffer, decoded_sdf));
 
 	VoxelDataGrid grid;
 	data.get_blocks_grid(grid, voxel_box, 0);
@@ -13,6 +13,7 @@ class VoxelLodTerrain;
 class VoxelDataMap;
 class VoxelMeshSDF;
 class VoxelGeneratorGraph;
+class VoxelDataRaycaster;
 
 class VoxelToolLodTerrain : public VoxelTool {
 	GDCLASS(VoxelToolLodTerrain, VoxelTool)
@@ -22,6 +23,13 @@ public:
 
 	bool is_area_editable(const Box3i &box) const override;
 	Ref<VoxelRaycastResult> raycast(Vector3 pos, Vector3 dir, float max_distance, uint32_t collision_mask) override;
+	void raycast_many(
+			Span<const Vector3> origins,
+			Span<const Vector3> directions,
+			Span<const float> max_distances,
+			uint32_t collision_mask,
+			Span<float> out_distances
+	) override;
 	void do_box(Vector3i begin, Vector3i end) override;
 	void do_sphere(Vector3 center, float radius) override;
 	void copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const override;
@@ -60,6 +68,16 @@ protected:
 	void _post_edit(const Box3i &box) override;
 
 private:
+	bool raycast_sdf(
+			VoxelDataRaycaster &raycaster,
+			Vector3 pos,
+			Vector3 dir,
+			float max_distance,
+			float &out_distance,
+			Vector3i &out_hit_pos,
+			Vector3i &out_prev_pos
+	) const;
+
 	static void _bind_methods();
 
 	VoxelLodTerrain *_terrain = nullptr;
@@ -9,7 +9,8 @@
 #include "../util/godot/core/array.h"
 #include "../util/godot/core/packed_arrays.h"
 #include "../util/math/conv.h"
-#include "../util/voxel_raycast.h"
+#include "../util/profiling.h"
+#include "voxel_data_raycaster.h"
 
 using namespace zylann::godot;
 
@@ -31,75 +32,57 @@ bool VoxelToolTerrain::is_area_editable(const Box3i &box) const {
 	return _terrain->get_storage().is_area_loaded(box);
 }
 
-Ref<VoxelRaycastResult> VoxelToolTerrain::raycast(
-		Vector3 p_pos,
-		Vector3 p_dir,
-		float p_max_distance,
-		uint32_t p_collision_mask
-) {
-	// TODO Implement broad-phase on blocks to minimize locking and increase performance
-
-	// TODO Optimization: voxel raycast uses `get_voxel` which is the slowest, but could be made faster.
-	// See `VoxelToolLodTerrain` for information about how to implement improvements.
+namespace {
 
-	struct RaycastPredicateColor {
-		const VoxelData &data;
+// Configures a raycaster depending on the mesher used by the terrain. Returns null if it can't be used.
+std::unique_ptr<VoxelDataRaycaster> create_raycaster(
+		VoxelTerrain &terrain,
+		uint32_t collision_mask,
+		bool occupancy_enabled
+) {
+	Ref<VoxelMesherBlocky> mesher_blocky;
+	Ref<VoxelMesherCubes> mesher_cubes;
 
-		bool operator()(const VoxelRaycastState &rs) const {
-			VoxelSingleValue defval;
-			defval.i = 0;
-			const uint64_t v = data.get_voxel(rs.hit_position, VoxelBuffer::CHANNEL_COLOR, defval).i;
-			return v != 0;
+	if (try_get_as(terrain.get_mesher(), mesher_blocky)) {
+		Ref<VoxelBlockyLibraryBase> library_ref = mesher_blocky->get_library();
+		if (library_ref.is_null()) {
+			return nullptr;
 		}
-	};
+		std::unique_ptr<VoxelDataRaycaster> raycaster = std::make_unique<VoxelDataRaycaster>(
+				terrain.get_storage(), VoxelDataRaycaster::MODE_BLOCKY, occupancy_enabled
+		);
+		// The library is kept alive by the mesher, itself referenced by the terrain
+		raycaster->set_blocky_models(library_ref->get_baked_data(), collision_mask);
+		return raycaster;
 
-	struct RaycastPredicateSDF {
-		const VoxelData &data;
+	} else if (try_get_as(terrain.get_mesher(), mesher_cubes)) {
+		return std::make_unique<VoxelDataRaycaster>(
+				terrain.get_storage(), VoxelDataRaycaster::MODE_COLOR, occupancy_enabled
+		);
 
-		bool operator()(const VoxelRaycastState &rs) const {
-			const float v = data.get_voxel_f(rs.hit_position, VoxelBuffer::CHANNEL_SDF);
-			return v < 0;
-		}
-	};
-
-	struct RaycastPredicateBlocky {
-		const VoxelData &data;
-		const VoxelBlockyLibraryBase::BakedData &baked_data;
-		const uint32_t collision_mask;
-		const Vector3 p_from;
-		const Vector3 p_to;
-
-		bool operator()(const VoxelRaycastState &rs) const {
-			VoxelSingleValue defval;
-			defval.i = 0;
-			const int v = data.get_voxel(rs.hit_position, VoxelBuffer::CHANNEL_TYPE, defval).i;
-
-			if (baked_data.has_model(v) == false) {
-				return false;
-			}
-
-			const VoxelBlockyModel::BakedData &model = baked_data.models[v];
-			if ((model.box_collision_mask & collision_mask) == 0) {
-				return false;
-			}
-
-			for (const AABB &aabb : model.box_collision_aabbs) {
-				if (AABB(aabb.position + rs.hit_position, aabb.size).intersects_segment(p_from, p_to)) {
-					return true;
-				}
-			}
+	} else {
+		return std::make_unique<VoxelDataRaycaster>(
+				terrain.get_storage(), VoxelDataRaycaster::MODE_SDF, occupancy_enabled
+		);
+	}
+}
 
-			return false;
-		}
-	};
+} // namespace
 
-	Ref<VoxelRaycastResult> res;
+Ref<VoxelRaycastResult> VoxelToolTerrain::raycast(
+		Vector3 p_pos,
+		Vector3 p_dir,
+		float p_max_distance,
+		uint32_t p_collision_mask
+) {
+	ERR_FAIL_COND_V(_terrain == nullptr, Ref<VoxelRaycastResult>());
 
-	Ref<VoxelMesherBlocky> mesher_blocky;
-	Ref<VoxelMesherCubes> mesher_cubes;
+	Ref<VoxelRaycastResult> res;
 
-	Vector3i hit_pos;
-	Vector3i prev_pos;
+	std::unique_ptr<VoxelDataRaycaster> raycaster = create_raycaster(*_terrain, p_collision_mask, false);
+	if (raycaster == nullptr) {
+		return res;
+	}
 
 	const Transform3D to_world = _terrain->get_global_transform();
 	const Transform3D to_local = to_world.affine_inverse();
@@ -108,55 +91,53 @@ Ref<VoxelRaycastResult> VoxelToolTerrain::raycast(
 	const float to_world_scale = to_world.basis.get_column(Vector3::AXIS_X).length();
 	const float max_distance = p_max_distance / to_world_scale;
 
-	if (try_get_as(_terrain->get_mesher(), mesher_blocky)) {
-		Ref<VoxelBlockyLibraryBase> library_ref = mesher_blocky->get_library();
-		if (library_ref.is_null()) {
-			return res;
-		}
-		RaycastPredicateBlocky predicate{ _terrain->get_storage(),
-										  library_ref->get_baked_data(),
-										  p_collision_mask,
-										  local_pos,
-										  local_pos + local_dir * max_distance };
-		float hit_distance;
-		float hit_distance_prev;
-		if (zylann::voxel_raycast(
-					local_pos, local_dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev
-			)) {
-			res.instantiate();
-			res->position = hit_pos;
-			res->previous_position = prev_pos;
-			res->distance_along_ray = hit_distance * to_world_scale;
-		}
+	VoxelDataRaycaster::Hit hit;
+	if (raycaster->raycast(local_pos, local_dir, max_distance, hit)) {
+		res.instantiate();
+		res->position = hit.position;
+		res->previous_position = hit.previous_position;
+		res->distance_along_ray = hit.distance * to_world_scale;
+	}
 
-	} else if (try_get_as(_terrain->get_mesher(), mesher_cubes)) {
-		RaycastPredicateColor predicate{ _terrain->get_storage() };
-		float hit_distance;
-		float hit_distance_prev;
-		if (zylann::voxel_raycast(
-					local_pos, local_dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev
-			)) {
-			res.instantiate();
-			res->position = hit_pos;
-			res->previous_position = prev_pos;
-			res->distance_along_ray = hit_distance * to_world_scale;
-		}
+	return res;
+}
 
-	} else {
-		RaycastPredicateSDF predicate{ _terrain->get_storage() };
-		float hit_distance;
-		float hit_distance_prev;
-		if (zylann::voxel_raycast(
-					local_pos, local_dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev
-			)) {
-			res.instantiate();
-			res->position = hit_pos;
-			res->previous_position = prev_pos;
-			res->distance_along_ray = hit_distance * to_world_scale;
-		}
+void VoxelToolTerrain::raycast_many(
+		Span<const Vector3> origins,
+		Span<const Vector3> directions,
+		Span<const float> max_distances,
+		uint32_t collision_mask,
+		Span<float> out_distances
+) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+	ZN_ASSERT_RETURN(origins.size() == directions.size());
+	ZN_ASSERT_RETURN(origins.size() == max_distances.size());
+	ZN_ASSERT_RETURN(origins.size() == out_distances.size());
+
+	// Rays share information about blocks, so with enough of them it is worth computing occupancy
+	std::unique_ptr<VoxelDataRaycaster> raycaster = create_raycaster(*_terrain, collision_mask, origins.size() > 1);
+	if (raycaster == nullptr) {
+		out_distances.fill(-1.f);
+		return;
 	}
 
-	return res;
+	const Transform3D to_world = _terrain->get_global_transform();
+	const Transform3D to_local = to_world.affine_inverse();
+	const float to_world_scale = to_world.basis.get_column(Vector3::AXIS_X).length();
+
+	for (unsigned int i = 0; i < origins.size(); ++i) {
+		const Vector3 local_pos = to_local.xform(origins[i]);
+		const Vector3 local_dir = to_local.basis.xform(directions[i]).normalized();
+		const float max_distance = max_distances[i] / to_world_scale;
+
+		VoxelDataRaycaster::Hit hit;
+		if (raycaster->raycast(local_pos, local_dir, max_distance, hit)) {
+			out_distances[i] = hit.distance * to_world_scale;
+		} else {
+			out_distances[i] = -1.f;
+		}
+	}
 }
 
 void VoxelToolTerrain::copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const {
@@ -19,6 +19,13 @@ public:
 	bool is_area_editable(const Box3i &box) const override;
 	Ref<VoxelRaycastResult> raycast(Vector3 p_pos, Vector3 p_dir, float p_max_distance, uint32_t p_collision_mask)
 			override;
+	void raycast_many(
+			Span<const Vector3> origins,
+			Span<const Vector3> directions,
+			Span<const float> max_distances,
+			uint32_t collision_mask,
+			Span<float> out_distances
+	) override;
 
 	void set_voxel_metadata(Vector3i pos, Variant meta) override;
 	Variant get_voxel_metadata(Vector3i pos) const override;
@@ -59,9 +59,20 @@ VoxelEngine::VoxelEngine(Config config) {
 	}
 
 	_general_thread_pool.set_name("Voxel general");
+	if (config.work_stealing_enabled) {
+		_general_thread_pool.set_scheduler_mode(ThreadedTaskRunner::SCHEDULER_WORK_STEALING);
+	}
 	_general_thread_pool.set_thread_count(thread_count);
 	_general_thread_pool.set_priority_update_period(200);
 
+	if (config.async_file_reads_enabled && AsyncFileReader::is_supported()) {
+		if (_async_file_reader.start(config.async_file_reads_queue_depth)) {
+			ZN_PRINT_VERBOSE("Voxel: using io_uring for asynchronous file reads");
+		} else {
+			ZN_PRINT_VERBOSE("Voxel: could not start asynchronous file reader, files will be read from threads");
+		}
+	}
+
 	// Init world
 	_world.shared_priority_dependency = make_shared_instance<PriorityDependency::ViewersData>();
 	// Give initial capacity to make invalidation less likely
@@ -98,6 +109,15 @@ VoxelEngine::VoxelEngine(Config config) {
 	}
 
 	set_main_thread_time_budget_usec(config.main_thread_budget_usec);
+	set_threaded_collision_shape_building_enabled(config.threaded_collision_shape_building_enabled);
+	set_palette_compression_enabled(config.palette_compression_enabled);
+
+	_generator_output_cache.configure(
+			config.generator_cache_memory_budget_bytes,
+			config.generator_cache_directory,
+			config.generator_cache_disk_budget_bytes
+	);
+	_mesh_output_cache.configure(config.mesh_cache_directory, config.mesh_cache_begin_lod_index);
 }
 
 void VoxelEngine::load_shaders() {
@@ -144,6 +164,7 @@ VoxelEngine::~VoxelEngine() {
 	// See https://github.com/Zylann/godot_voxel/issues/189
 	wait_and_clear_all_tasks(true);
 
+	_async_file_reader.stop();
 	_gpu_task_runner.stop();
 
 	if (_rendering_device != nullptr) {
@@ -172,7 +193,11 @@ VoxelEngine::~VoxelEngine() {
 }
 
 void VoxelEngine::wait_and_clear_all_tasks(bool warn) {
-	_general_thread_pool.wait_for_all_tasks();
+	// Completed file reads schedule tasks, and tasks can start new reads
+	do {
+		_async_file_reader.wait_for_all_requests();
+		_general_thread_pool.wait_for_all_tasks();
+	} while (_async_file_reader.get_pending_count() > 0);
 
 	_general_thread_pool.dequeue_completed_tasks([warn](zylann::IThreadedTask *task) {
 		if (warn) {
@@ -304,6 +329,22 @@ bool VoxelEngine::is_threaded_graphics_resource_building_enabled() const {
 	return _threaded_graphics_resource_building_enabled;
 }
 
+void VoxelEngine::set_threaded_collision_shape_building_enabled(bool enable) {
+	_threaded_collision_shape_building_enabled = enable;
+}
+
+bool VoxelEngine::is_threaded_collision_shape_building_enabled() const {
+	return _threaded_collision_shape_building_enabled;
+}
+
+void VoxelEngine::set_palette_compression_enabled(bool enable) {
+	_palette_compression_enabled = enable;
+}
+
+bool VoxelEngine::is_palette_compression_enabled() const {
+	return _palette_compression_enabled;
+}
+
 void VoxelEngine::push_async_task(zylann::IThreadedTask *task) {
 	_general_thread_pool.enqueue(task, false);
 }
@@ -427,6 +468,8 @@ VoxelEngine::Stats VoxelEngine::get_stats() const {
 	s.meshing_tasks = MeshBlockTask::debug_get_running_count();
 	s.streaming_tasks = LoadBlockDataTask::debug_get_running_count() + SaveBlockDataTask::debug_get_running_count();
 	s.main_thread_tasks = _time_spread_task_runner.get_pending_count() + _progressive_task_runner.get_pending_count();
+	s.generator_cache = _generator_output_cache.get_stats();
+	s.mesh_cache = _mesh_output_cache.get_stats();
 	return s;
 }
 
@@ -1,11 +1,15 @@
 #ifndef VOXEL_ENGINE_H
 #define VOXEL_ENGINE_H
 
+#include "../generators/voxel_generator_output_cache.h"
+#include "../meshers/voxel_mesh_output_cache.h"
 #include "../meshers/voxel_mesher.h"
 #include "../streams/instance_data.h"
 #include "../util/containers/slot_map.h"
 #include "../util/containers/std_vector.h"
 #include "../util/godot/classes/rendering_device.h"
+#include "../util/godot/classes/shape_3d.h"
+#include "../util/io/async_file_reader.h"
 #include "../util/io/file_locker.h"
 #include "../util/memory/memory.h"
 #include "../util/string/std_string.h"
@@ -55,6 +59,12 @@ public:
 		bool has_mesh_resource;
 		// Tells if the meshing task was required to build a rendering mesh if possible.
 		bool visual_was_required;
+		// Only used if `has_collision_shape` is true (usually when collision shapes are allowed to be built in
+		// threads). Can be null if the mesh had no collidable triangles.
+		Ref<Shape3D> collision_shape;
+		// Tells if the collision shape was built as part of the task. If not, you need to build it on the main thread
+		// if it is needed.
+		bool has_collision_shape;
 		// Can be null. Attached to meshing output so it is tracked more easily, because it is baked asynchronously
 		// starting from the mesh task, and it might complete earlier or later than the mesh.
 		std::shared_ptr<DetailTextureOutput> detail_textures;
@@ -137,6 +147,25 @@ public:
 		// Portion of available CPU threads to attempt using
 		float thread_count_ratio_over_max = 0.5;
 		unsigned int main_thread_budget_usec = DEFAULT_MAIN_THREAD_BUDGET_USEC;
+		// Use per-thread task queues with work stealing instead of a single sorted queue
+		bool work_stealing_enabled = false;
+		// Memory budget of the cache of generated blocks. Zero disables the cache.
+		size_t generator_cache_memory_budget_bytes = 0;
+		// Directory where blocks evicted from the generator cache can be written. Empty means they are discarded.
+		String generator_cache_directory;
+		size_t generator_cache_disk_budget_bytes = 0;
+		// Directory where meshes of unedited blocks can be cached across runs. Empty disables the cache.
+		String mesh_cache_directory;
+		// Meshes of LODs below this index are not cached, they are cheaper to build and more likely to be edited
+		unsigned int mesh_cache_begin_lod_index = 2;
+		// Read blocks from files asynchronously with io_uring, when the stream and the platform support it.
+		bool async_file_reads_enabled = true;
+		// Maximum number of asynchronous file reads in flight
+		unsigned int async_file_reads_queue_depth = 64;
+		// Build collision shapes in meshing tasks instead of the main thread
+		bool threaded_collision_shape_building_enabled = true;
+		// Store channels of loaded and generated blocks as palettes when they have few distinct values
+		bool palette_compression_enabled = false;
 	};
 
 	static VoxelEngine &get_singleton();
@@ -188,6 +217,18 @@ public:
 	// This should be fast and safe to access from multiple threads.
 	bool is_threaded_graphics_resource_building_enabled() const;
 
+	// Allows/disallows building collision shapes from inside threads. Godot's physics servers support creating shapes
+	// from other threads, but it can be turned off in case a physics engine doesn't.
+	void set_threaded_collision_shape_building_enabled(bool enable);
+	// This should be fast and safe to access from multiple threads.
+	bool is_threaded_collision_shape_building_enabled() const;
+
+	// Allows/disallows compressing channels of blocks into palettes when they become resident in a volume (after they
+	// got loaded or generated). This reduces memory usage, but may slow down accessing them.
+	void set_palette_compression_enabled(bool enable);
+	// This should be fast and safe to access from multiple threads.
+	bool is_palette_compression_enabled() const;
+
 	void push_main_thread_progressive_task(IProgressiveTask *task);
 
 	// Thread-safe.
@@ -207,6 +248,20 @@ public:
 		return _file_locker;
 	}
 
+	inline VoxelGeneratorOutputCache &get_generator_output_cache() {
+		return _generator_output_cache;
+	}
+
+	inline VoxelMeshOutputCache &get_mesh_output_cache() {
+		return _mesh_output_cache;
+	}
+
+	// Returns null if asynchronous file reads are not available, in which case files should be read from the general
+	// thread pool.
+	inline AsyncFileReader *get_async_file_reader() {
+		return _async_file_reader.is_running() ? &_async_file_reader : nullptr;
+	}
+
 	static inline int get_octree_lod_block_region_extent(float lod_distance, float block_size) {
 		// This is a bounding radius of blocks around a viewer within which we may load them.
 		// `lod_distance` is the distance under which a block should subdivide into a smaller one.
@@ -227,6 +282,8 @@ public:
 		int streaming_tasks;
 		int meshing_tasks;
 		int main_thread_tasks;
+		VoxelGeneratorOutputCache::Stats generator_cache;
+		VoxelMeshOutputCache::Stats mesh_cache;
 	};
 
 	Stats get_stats() const;
@@ -335,8 +392,13 @@ private:
 	ProgressiveTaskRunner _progressive_task_runner;
 
 	FileLocker _file_locker;
+	VoxelGeneratorOutputCache _generator_output_cache;
+	VoxelMeshOutputCache _mesh_output_cache;
+	AsyncFileReader _async_file_reader;
 
 	bool _threaded_graphics_resource_building_enabled = false;
+	bool _threaded_collision_shape_building_enabled = true;
+	bool _palette_compression_enabled = false;
 
 	// Rendering device used for compute shaders. May not be available depending on the chosen renderer.
 	RenderingDevice *_rendering_device = nullptr;
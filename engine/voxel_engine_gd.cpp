@@ -49,6 +49,32 @@ VoxelEngine::Config VoxelEngine::get_config_from_godot() {
 	add_custom_project_setting(
 			Variant::INT, "voxel/threads/main/time_budget_ms", PROPERTY_HINT_RANGE, "0,1000", 8, true
 	);
+	add_custom_project_setting(Variant::BOOL, "voxel/threads/work_stealing", PROPERTY_HINT_NONE, "", false, true);
+	add_custom_project_setting(Variant::BOOL, "voxel/threads/async_file_reads", PROPERTY_HINT_NONE, "", true, true);
+	add_custom_project_setting(
+			Variant::BOOL, "voxel/threads/threaded_collision_shapes", PROPERTY_HINT_NONE, "", true, true
+	);
+
+	add_custom_project_setting(
+			Variant::INT, "voxel/generator_cache/memory_budget_mb", PROPERTY_HINT_RANGE, "0,16384", 0, true
+	);
+	add_custom_project_setting(Variant::STRING, "voxel/generator_cache/directory", PROPERTY_HINT_DIR, "", "", true);
+	add_custom_project_setting(
+			Variant::INT, "voxel/generator_cache/disk_budget_mb", PROPERTY_HINT_RANGE, "0,65536", 1024, true
+	);
+
+	add_custom_project_setting(Variant::STRING, "voxel/mesh_cache/directory", PROPERTY_HINT_DIR, "", "", true);
+	add_custom_project_setting(
+			Variant::INT, "voxel/mesh_cache/begin_lod_index", PROPERTY_HINT_RANGE, "0,31", 2, true
+	);
+
+	add_custom_project_setting(Variant::BOOL, "voxel/memory_pool/thread_caches", PROPERTY_HINT_NONE, "", true, true);
+	add_custom_project_setting(Variant::BOOL, "voxel/memory_pool/arenas", PROPERTY_HINT_NONE, "", false, true);
+	add_custom_project_setting(Variant::BOOL, "voxel/memory_pool/huge_pages", PROPERTY_HINT_NONE, "", false, true);
+
+	add_custom_project_setting(
+			Variant::BOOL, "voxel/storage/palette_compression", PROPERTY_HINT_NONE, "", false, true
+	);
 
 	add_custom_project_setting(Variant::BOOL, "voxel/ownership_checks", PROPERTY_HINT_NONE, "", true, true);
 
@@ -63,6 +89,26 @@ VoxelEngine::Config VoxelEngine::get_config_from_godot() {
 	config.inner.thread_count_ratio_over_max =
 			math::clamp(float(ps.get("voxel/threads/count/ratio_over_max")), 0.f, 1.f);
 
+	config.inner.work_stealing_enabled = ps.get("voxel/threads/work_stealing");
+	config.inner.async_file_reads_enabled = ps.get("voxel/threads/async_file_reads");
+	config.inner.threaded_collision_shape_building_enabled = ps.get("voxel/threads/threaded_collision_shapes");
+
+	const size_t mb = 1024 * 1024;
+	config.inner.generator_cache_memory_budget_bytes =
+			math::max(int(ps.get("voxel/generator_cache/memory_budget_mb")), 0) * mb;
+	config.inner.generator_cache_directory = ps.get("voxel/generator_cache/directory");
+	config.inner.generator_cache_disk_budget_bytes =
+			math::max(int(ps.get("voxel/generator_cache/disk_budget_mb")), 0) * mb;
+
+	config.inner.mesh_cache_directory = ps.get("voxel/mesh_cache/directory");
+	config.inner.mesh_cache_begin_lod_index = math::max(int(ps.get("voxel/mesh_cache/begin_lod_index")), 0);
+
+	config.memory_pool_thread_caches = ps.get("voxel/memory_pool/thread_caches");
+	config.memory_pool_arenas = ps.get("voxel/memory_pool/arenas");
+	config.memory_pool_huge_pages = ps.get("voxel/memory_pool/huge_pages");
+
+	config.inner.palette_compression_enabled = ps.get("voxel/storage/palette_compression");
+
 	config.ownership_checks = ps.get("voxel/ownership_checks");
 
 	return config;
@@ -128,6 +174,12 @@ Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats &stats) {
 	mem["voxel_total"] = ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_total_memory());
 	mem["voxel_used"] = ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_used_memory());
 	mem["block_count"] = VoxelMemoryPool::get_singleton().debug_get_used_blocks();
+	mem["voxel_used_capacity"] = ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_used_capacity());
+	mem["voxel_peak_used"] = ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_peak_used_memory());
+	mem["voxel_peak_total"] = ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_peak_total_memory());
+	mem["voxel_thread_cached"] =
+			ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_thread_cached_memory());
+	mem["voxel_arenas"] = ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_arena_memory());
 #ifdef DEBUG_ENABLED
 	const uint64_t std_allocated = static_cast<int64_t>(StdDefaultAllocatorCounters::g_allocated);
 	const uint64_t std_deallocated = static_cast<int64_t>(StdDefaultAllocatorCounters::g_deallocated);
@@ -140,10 +192,26 @@ Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats &stats) {
 	mem["std_current"] = -1;
 #endif
 
+	Dictionary generator_cache;
+	generator_cache["memory_usage"] = ZN_SIZE_T_TO_VARIANT(stats.generator_cache.memory_usage);
+	generator_cache["disk_usage"] = ZN_SIZE_T_TO_VARIANT(stats.generator_cache.disk_usage);
+	generator_cache["memory_block_count"] = stats.generator_cache.memory_entry_count;
+	generator_cache["disk_block_count"] = stats.generator_cache.disk_entry_count;
+	generator_cache["hits"] = static_cast<int64_t>(stats.generator_cache.hit_count);
+	generator_cache["misses"] = static_cast<int64_t>(stats.generator_cache.miss_count);
+
+	Dictionary mesh_cache;
+	mesh_cache["hits"] = static_cast<int64_t>(stats.mesh_cache.hit_count);
+	mesh_cache["misses"] = static_cast<int64_t>(stats.mesh_cache.miss_count);
+	mesh_cache["stores"] = static_cast<int64_t>(stats.mesh_cache.store_count);
+	mesh_cache["open_regions"] = stats.mesh_cache.open_region_count;
+
 	Dictionary d;
 	d["thread_pools"] = pools;
 	d["tasks"] = tasks;
 	d["memory_pools"] = mem;
+	d["generator_cache"] = generator_cache;
+	d["mesh_cache"] = mesh_cache;
 	return d;
 }
 
@@ -21,6 +21,10 @@ public:
 	struct Config {
 		zylann::voxel::VoxelEngine::Config inner;
 		bool ownership_checks;
+		// Applied to `VoxelMemoryPool`
+		bool memory_pool_thread_caches;
+		bool memory_pool_arenas;
+		bool memory_pool_huge_pages;
 	};
 
 	static Config get_config_from_godot();
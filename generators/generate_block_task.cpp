@@ -127,9 +127,21 @@ void GenerateBlockTask::run_cpu_generation() {
 
 	Ref<VoxelGenerator> generator = _stream_dependency->generator;
 
+	VoxelGeneratorOutputCache &cache = VoxelEngine::get_singleton().get_generator_output_cache();
+	const uint64_t generator_hash = cache.is_enabled() ? generator->get_output_hash() : 0;
+	const VoxelGeneratorOutputCache::Key cache_key{ generator_hash, _position, _lod_index, _block_size };
+
 	VoxelGenerator::VoxelQueryData query_data{ *_voxels, origin_in_voxels, _lod_index };
-	const VoxelGenerator::Result result = generator->generate_block(query_data);
-	_max_lod_hint = result.max_lod_hint;
+
+	if (generator_hash == 0 || !cache.load(cache_key, *_voxels, _max_lod_hint)) {
+		const VoxelGenerator::Result result = generator->generate_block(query_data);
+		_max_lod_hint = result.max_lod_hint;
+
+		if (generator_hash != 0) {
+			// Modifiers are not included, they can change independently
+			cache.store(cache_key, *_voxels, _max_lod_hint);
+		}
+	}
 
 	if (_data != nullptr) {
 		_data->get_modifiers().apply(
@@ -165,6 +177,11 @@ void GenerateBlockTask::run_stream_saving_and_finish() {
 		}
 	}
 
+	if (VoxelEngine::get_singleton().is_palette_compression_enabled()) {
+		// Done last so the generator and the saved copy work with regular channels
+		_voxels->compress_palette_channels();
+	}
+
 	_has_run = true;
 }
 
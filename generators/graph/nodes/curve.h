@@ -1,4 +1,6 @@
+#include "../../../util/containers/std_vector.h"
 #include "../../../util/godot/classes/curve.h"
+#include "../../../util/math/simd.h"
 #include "../../../util/profiling.h"
 #include "../node_type_db.h"
 #include "../range_utility.h"
@@ -9,10 +11,15 @@ void register_curve_node(Span<NodeType> types) {
 	using namespace math;
 
 	{
+		// Copy of the baked curve, which can be sampled with vectorized code
+		struct CurveSamples {
+			StdVector<float> values;
+		};
 		struct Params {
 			// TODO Should be `const` but isn't because it auto-bakes, and it's a concern for multithreading
 			Curve *curve;
 			const CurveRangeData *curve_range_data;
+			const CurveSamples *samples;
 		};
 		NodeType &t = types[VoxelGraphFunction::NODE_CURVE];
 		t.name = "Curve";
@@ -41,20 +48,29 @@ void register_curve_node(Span<NodeType> types) {
 			curve->bake();
 			CurveRangeData *curve_range_data = ZN_NEW(CurveRangeData);
 			get_curve_monotonic_sections(**curve, curve_range_data->sections);
+			// Sampling at the same positions as the baked cache, so linear interpolation between them gives the same
+			// results as `sample_baked`
+			CurveSamples *samples = ZN_NEW(CurveSamples);
+			const int res = math::max(curve->get_bake_resolution(), 2);
+			samples->values.resize(res);
+			for (int i = 0; i < res; ++i) {
+				samples->values[i] = curve->sample_baked(static_cast<float>(i) / (res - 1));
+			}
 			Params p;
 			p.curve_range_data = curve_range_data;
 			p.curve = *curve;
+			p.samples = samples;
 			ctx.set_params(p);
 			ctx.add_delete_cleanup(curve_range_data);
+			ctx.add_delete_cleanup(samples);
 		};
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
 			ZN_PROFILE_SCOPE_NAMED("NODE_CURVE");
 			const Runtime::Buffer &a = ctx.get_input(0);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = p.curve->sample_baked(a.data[i]);
-			}
+			const StdVector<float> &values = p.samples->values;
+			math::simd::sample_table(a.data, values.data(), values.size(), 0.f, 1.f, out.data, out.size);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -179,7 +179,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return min(a, b); });
+			do_commutative_binop_simd(ctx, math::simd::min, math::simd::min_constant);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -202,7 +202,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return max(a, b); });
+			do_commutative_binop_simd(ctx, math::simd::max, math::simd::max_constant);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -230,9 +230,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &minv = ctx.get_input(1);
 			const Runtime::Buffer &maxv = ctx.get_input(2);
 			Runtime::Buffer &out = ctx.get_output(0);
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = clamp(a.data[i], minv.data[i], maxv.data[i]);
-			}
+			math::simd::clamp(a.data, minv.data, maxv.data, out.data, out.size);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -271,9 +269,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &a = ctx.get_input(0);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = clamp(a.data[i], p.min, p.max);
-			}
+			math::simd::clamp_constant(a.data, p.min, p.max, out.data, out.size);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -343,9 +339,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 						out.data[i] = a.data[i];
 					}
 				} else {
-					for (uint32_t i = 0; i < buffer_size; ++i) {
-						out.data[i] = Math::lerp(a.data[i], b.data[i], r.data[i]);
-					}
+					math::simd::lerp(a.data, b.data, r.data, out.data, buffer_size);
 				}
 			}
 		};
@@ -62,7 +62,7 @@ void register_math_ops_nodes(Span<NodeType> types) {
 		t.outputs.push_back(NodeType::Port("out"));
 		t.compile_func = nullptr;
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a + b; });
+			do_commutative_binop_simd(ctx, math::simd::add, math::simd::add_constant);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -81,7 +81,9 @@ void register_math_ops_nodes(Span<NodeType> types) {
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a - b; });
+			do_binop_simd(
+					ctx, math::simd::subtract, math::simd::subtract_from_constant, math::simd::subtract_constant
+			);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -100,7 +102,7 @@ void register_math_ops_nodes(Span<NodeType> types) {
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a * b; });
+			do_commutative_binop_simd(ctx, math::simd::multiply, math::simd::multiply_constant);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -16,7 +16,9 @@ void register_sdf_nodes(Span<NodeType> types) {
 		t.inputs.push_back(NodeType::Port("height"));
 		t.outputs.push_back(NodeType::Port("sdf"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a - b; });
+			do_binop_simd(
+					ctx, math::simd::subtract, math::simd::subtract_from_constant, math::simd::subtract_constant
+			);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -56,10 +58,7 @@ void register_sdf_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &z = ctx.get_input(2);
 			const Params p = ctx.get_params<Params>();
 			Runtime::Buffer &out = ctx.get_output(0);
-			const Vector3 size(p.size_x, p.size_y, p.size_z);
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = math::sdf_box(Vector3(x.data[i], y.data[i], z.data[i]), size);
-			}
+			math::simd::sdf_box(x.data, y.data, z.data, p.size_x, p.size_y, p.size_z, out.data, out.size);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval x = ctx.get_input(0);
@@ -105,9 +104,7 @@ void register_sdf_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &z = ctx.get_input(2);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = Math::sqrt(squared(x.data[i]) + squared(y.data[i]) + squared(z.data[i])) - p.radius;
-			}
+			math::simd::sdf_sphere(x.data, y.data, z.data, p.radius, out.data, out.size);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval x = ctx.get_input(0);
@@ -205,14 +202,10 @@ void register_sdf_nodes(Span<NodeType> types) {
 					out.data[i] = a.data[i];
 				}
 			} else if (params.smoothness > 0.0001f) {
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] = math::sdf_smooth_union(a.data[i], b.data[i], params.smoothness);
-				}
+				math::simd::sdf_smooth_union(a.data, b.data, params.smoothness, out.data, out.size);
 			} else {
 				// Fallback on hard-union, smooth union does not support zero smoothness
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] = math::sdf_union(a.data[i], b.data[i]);
-				}
+				math::simd::min(a.data, b.data, out.data, out.size);
 			}
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -1,6 +1,7 @@
 #ifndef VOXEL_GRAPH_NODES_UTIL_H
 #define VOXEL_GRAPH_NODES_UTIL_H
 
+#include "../../../util/math/simd.h"
 #include "../voxel_graph_runtime.h"
 
 namespace zylann::voxel::pg {
@@ -59,6 +60,60 @@ inline void do_binop(pg::Runtime::ProcessBufferContext &ctx, F f) {
 	}
 }
 
+typedef void (*SimdBinopFunc)(const float *a, const float *b, float *out, unsigned int count);
+typedef void (*SimdBinopConstantBFunc)(const float *a, float b, float *out, unsigned int count);
+typedef void (*SimdBinopConstantAFunc)(float a, const float *b, float *out, unsigned int count);
+
+// Same as `do_binop`, using vectorized kernels from `math::simd`.
+inline void do_binop_simd(
+		pg::Runtime::ProcessBufferContext &ctx,
+		SimdBinopFunc f,
+		SimdBinopConstantAFunc f_constant_a,
+		SimdBinopConstantBFunc f_constant_b
+) {
+	const Runtime::Buffer &a = ctx.get_input(0);
+	const Runtime::Buffer &b = ctx.get_input(1);
+	Runtime::Buffer &out = ctx.get_output(0);
+	const uint32_t buffer_size = out.size;
+
+	if (a.is_constant || b.is_constant) {
+		if (!b.is_constant) {
+			f_constant_a(a.constant_value, b.data, out.data, buffer_size);
+
+		} else if (!a.is_constant) {
+			f_constant_b(a.data, b.constant_value, out.data, buffer_size);
+
+		} else {
+			// Normally this case should have been optimized out at compile-time
+			float c;
+			f_constant_b(&a.constant_value, b.constant_value, &c, 1);
+			for (uint32_t i = 0; i < buffer_size; ++i) {
+				out.data[i] = c;
+			}
+		}
+
+	} else {
+		f(a.data, b.data, out.data, buffer_size);
+	}
+}
+
+// Variant for operations where operands can be swapped
+inline void do_commutative_binop_simd(
+		pg::Runtime::ProcessBufferContext &ctx,
+		SimdBinopFunc f,
+		SimdBinopConstantBFunc f_constant
+) {
+	const Runtime::Buffer &a = ctx.get_input(0);
+	const Runtime::Buffer &b = ctx.get_input(1);
+	Runtime::Buffer &out = ctx.get_output(0);
+
+	if (a.is_constant && !b.is_constant) {
+		f_constant(b.data, a.constant_value, out.data, out.size);
+	} else {
+		do_binop_simd(ctx, f, nullptr, f_constant);
+	}
+}
+
 } // namespace zylann::voxel::pg
 
 #endif // VOXEL_GRAPH_NODES_UTIL_H
@@ -93,6 +93,27 @@ int VoxelGeneratorGraph::get_used_channels_mask() const {
 	return mask;
 }
 
+uint64_t VoxelGeneratorGraph::get_output_hash() const {
+	std::shared_ptr<const Runtime> runtime_ptr;
+	{
+		RWLockRead rlock(_runtime_lock);
+		runtime_ptr = _runtime;
+	}
+	if (runtime_ptr == nullptr) {
+		return 0;
+	}
+	// Settings that can change results without recompiling the graph
+	uint64_t hash = hash_djb2_one_64(runtime_ptr->output_graph_hash);
+	hash = hash_djb2_one_64(_output_graph_resources_hash.load(), hash);
+	// Quantized, we only need to distinguish distinct settings
+	hash = hash_djb2_one_64(static_cast<int64_t>(_sdf_clip_threshold * 1000.f), hash);
+	hash = hash_djb2_one_64(_use_subdivision ? _subdivision_size : 0, hash);
+	hash = hash_djb2_one_64(_use_optimized_execution_map, hash);
+	hash = hash_djb2_one_64(_use_xz_caching, hash);
+	hash = hash_djb2_one_64(_debug_clipped_blocks, hash);
+	return hash;
+}
+
 void VoxelGeneratorGraph::set_use_subdivision(bool use) {
 	_use_subdivision = use;
 }
@@ -1127,6 +1148,10 @@ pg::CompilationResult VoxelGeneratorGraph::compile(bool debug) {
 		r->spare_texture_indices = spare_indices;
 	}
 
+	r->output_graph_hash = _main_function->get_output_graph_hash();
+	_main_function->get_output_graph_resources(r->output_graph_resources);
+	_output_graph_resources_hash = get_resources_hash(to_span(r->output_graph_resources));
+
 	// Store valid result
 	RWLockWrite wlock(_runtime_lock);
 	_runtime = r;
@@ -1939,9 +1964,27 @@ float VoxelGeneratorGraph::_b_debug_measure_microseconds_per_voxel(bool singular
 }
 
 void VoxelGeneratorGraph::_on_subresource_changed() {
+	std::shared_ptr<const Runtime> runtime_ptr;
+	{
+		RWLockRead rlock(_runtime_lock);
+		runtime_ptr = _runtime;
+	}
+	if (runtime_ptr != nullptr) {
+		// A resource used by the compiled graph may have been modified (like noise parameters), which changes the
+		// output without recompiling. Structural changes don't matter here since they require to recompile.
+		_output_graph_resources_hash = get_resources_hash(to_span(runtime_ptr->output_graph_resources));
+	}
 	emit_changed();
 }
 
+uint64_t VoxelGeneratorGraph::get_resources_hash(Span<const Ref<Resource>> resources) {
+	uint64_t hash = hash_djb2_one_64(0);
+	for (const Ref<Resource> &resource : resources) {
+		hash = hash_djb2_one_64(godot::get_deep_hash(*resource.ptr()), hash);
+	}
+	return hash;
+}
+
 Dictionary VoxelGeneratorGraph::get_graph_as_variant_data() const {
 	ERR_FAIL_COND_V(_main_function.is_null(), Dictionary());
 	return _main_function->get_graph_as_variant_data();
@@ -16,6 +16,7 @@
 #include "voxel_graph_function.h"
 #include "voxel_graph_runtime.h"
 
+#include <atomic>
 #include <memory>
 
 ZN_GODOT_FORWARD_DECLARE(class Image)
@@ -76,6 +77,8 @@ public:
 	void generate_series(Span<const float> positions_x, Span<const float> positions_y, Span<const float> positions_z,
 			unsigned int channel, Span<float> out_values, Vector3f min_pos, Vector3f max_pos) override;
 
+	uint64_t get_output_hash() const override;
+
 	// Ref<Resource> duplicate(bool p_subresources) const ZN_OVERRIDE_UNLESS_GODOT_EXTENSION;
 
 	// Utility
@@ -128,6 +131,7 @@ public:
 
 private:
 	void _on_subresource_changed();
+	static uint64_t get_resources_hash(Span<const Ref<Resource>> resources);
 	float _b_generate_single(Vector3 pos);
 	Vector2 _b_debug_analyze_range(Vector3 min_pos, Vector3 max_pos) const;
 	Dictionary _b_compile();
@@ -204,6 +208,11 @@ private:
 		// List of indices to feed queries. The order doesn't matter, can be different from `weight_outputs`.
 		FixedArray<unsigned int, 16> weight_output_indices;
 		unsigned int weight_outputs_count = 0;
+
+		// Hash of the graph this runtime was compiled from
+		uint64_t output_graph_hash = 0;
+		// Resources used by nodes. They can be modified after compilation, and the runtime will use them as they are.
+		StdVector<Ref<Resource>> output_graph_resources;
 	};
 
 	// Helper to setup inputs for runtime queries
@@ -236,6 +245,10 @@ private:
 	std::shared_ptr<Runtime> _runtime = nullptr;
 	RWLock _runtime_lock;
 
+	// Hash of the current contents of `Runtime::output_graph_resources`. Updated when one of them changes, because
+	// that affects generated voxels without needing to recompile the graph.
+	std::atomic_uint64_t _output_graph_resources_hash = { 0 };
+
 	struct Cache {
 		StdVector<float> x_cache;
 		StdVector<float> y_cache;
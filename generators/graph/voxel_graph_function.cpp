@@ -646,19 +646,7 @@ unsigned int VoxelGraphFunction::get_nodes_count() const {
 	return _graph.get_nodes_count();
 }
 
-#ifdef TOOLS_ENABLED
-
-void VoxelGraphFunction::get_configuration_warnings(PackedStringArray &out_warnings) const {
-	if (_last_compiling_result.success == false) {
-		if (_last_compiling_result.message.is_empty()) {
-			out_warnings.append("The graph isn't compiled.");
-		} else {
-			out_warnings.append(String("Compiling failed: {0}").format(_last_compiling_result.message));
-		}
-	}
-}
-
-uint64_t VoxelGraphFunction::get_output_graph_hash() const {
+void VoxelGraphFunction::get_output_graph_order(StdVector<uint32_t> &out_order) const {
 	const NodeTypeDB &type_db = NodeTypeDB::get_singleton();
 	StdVector<uint32_t> terminal_nodes;
 
@@ -673,10 +661,13 @@ uint64_t VoxelGraphFunction::get_output_graph_hash() const {
 	// Sort for determinism
 	std::sort(terminal_nodes.begin(), terminal_nodes.end());
 
+	_graph.find_dependencies(terminal_nodes, out_order);
+}
+
+uint64_t VoxelGraphFunction::get_output_graph_hash() const {
 	StdVector<uint32_t> order;
-	_graph.find_dependencies(terminal_nodes, order);
+	get_output_graph_order(order);
 
-	StdVector<uint64_t> node_hashes;
 	uint64_t hash = hash_djb2_one_64(0);
 
 	for (uint32_t node_id : order) {
@@ -710,6 +701,33 @@ uint64_t VoxelGraphFunction::get_output_graph_hash() const {
 	return hash;
 }
 
+void VoxelGraphFunction::get_output_graph_resources(StdVector<Ref<Resource>> &out_resources) const {
+	StdVector<uint32_t> order;
+	get_output_graph_order(order);
+
+	for (uint32_t node_id : order) {
+		const ProgramGraph::Node &node = _graph.get_node(node_id);
+		for (const Variant &v : node.params) {
+			Ref<Resource> resource = v;
+			if (resource.is_valid()) {
+				out_resources.push_back(resource);
+			}
+		}
+	}
+}
+
+#ifdef TOOLS_ENABLED
+
+void VoxelGraphFunction::get_configuration_warnings(PackedStringArray &out_warnings) const {
+	if (_last_compiling_result.success == false) {
+		if (_last_compiling_result.message.is_empty()) {
+			out_warnings.append("The graph isn't compiled.");
+		} else {
+			out_warnings.append(String("Compiling failed: {0}").format(_last_compiling_result.message));
+		}
+	}
+}
+
 #endif
 
 void VoxelGraphFunction::find_dependencies(uint32_t node_id, StdVector<uint32_t> &out_dependencies) const {
@@ -181,15 +181,18 @@ public:
 
 	unsigned int get_nodes_count() const;
 
+	// Gets a hash that attempts to only change if the output of the graph is different.
+	// This is computed from the editable graph data, not the compiled result.
+	uint64_t get_output_graph_hash() const;
+	// Gets resources used as parameters by nodes contributing to outputs. Their contents can change without the graph
+	// being recompiled (noise, curves...).
+	void get_output_graph_resources(StdVector<Ref<Resource>> &out_resources) const;
+
 	// Editor
 
 #ifdef TOOLS_ENABLED
 	void get_configuration_warnings(PackedStringArray &out_warnings) const;
 
-	// Gets a hash that attempts to only change if the output of the graph is different.
-	// This is computed from the editable graph data, not the compiled result.
-	uint64_t get_output_graph_hash() const;
-
 	bool can_load_default_graph() const {
 		return _can_load_default_graph;
 	}
@@ -267,6 +270,8 @@ public:
 	static RuntimeCache &get_runtime_cache_tls();
 
 private:
+	void get_output_graph_order(StdVector<uint32_t> &out_order) const;
+
 	void register_subresource(Resource &resource);
 	void unregister_subresource(Resource &resource);
 	void register_subresources();
@@ -104,6 +104,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 				// Unregister task from the column
 				Column &column = column_it->second;
 				column.pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+				schedule_waiting_tasks(column, _subpass_index, false, task_scheduler);
 
 				if (_subpass_index == final_subpass_index) {
 					// Schedule pending block requests to make them handle cancellation
@@ -119,6 +120,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 	const int pass_index = VoxelGeneratorMultipassCB::get_pass_index_from_subpass(_subpass_index);
 	const Pass &pass = _generator_internal->passes[pass_index];
+	PassStats &pass_stats = _generator_internal->pass_stats[pass_index];
 
 	if (_subpass_index == 0) {
 		// The first subpass can't depend on another subpass
@@ -148,6 +150,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		// SpatialLock3D::Write swlock(map->spatial_lock, neighbors_box);
 		if (!map.spatial_lock.try_lock_write(neighbors_box)) {
 			// Try later
+			++pass_stats.lock_retry_count;
 			ctx.status = ThreadedTaskContext::STATUS_POSTPONED;
 			return;
 		}
@@ -179,6 +182,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		Column *main_column = columns[central_block_index];
 
 		bool spawned_subtasks = false;
+		bool waiting = false;
 		bool postpone = false;
 
 		// Check loading levels
@@ -190,7 +194,8 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 			const Vector2i cpos_min = neighbors_box.position;
 			const Vector2i cpos_max = neighbors_box.position + neighbors_box.size;
 
-			std::shared_ptr<std::atomic_int> dependency_counter = nullptr;
+			// All dependencies of the previous run of this task must have finished
+			ZN_ASSERT(_dependency_counter == nullptr || *_dependency_counter == 0);
 
 			for (Column *column : columns) {
 				if (column == nullptr) {
@@ -198,6 +203,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 					if (main_column != nullptr) {
 						main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+						schedule_waiting_tasks(*main_column, _subpass_index, false, task_scheduler);
 
 						if (_subpass_index == final_subpass_index) {
 							// Schedule pending block requests to make them handle cancellation
@@ -232,20 +238,25 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 							postpone = true;
 
 						} else if ((column->pending_subpass_tasks_mask & (1 << prev_subpass_index)) != 0) {
-							// A task is pending to work on the dependency, so we wait.
-							// TODO Ideally we should subscribe to the completion of that task.
-							// We can do that
-							// println(format("O {} {} {} {} {}", int(_subpass_index), _column_position.x, 0,
-							// 		_column_position.y, Time::get_singleton()->get_ticks_usec()));
-							postpone = true;
+							// A task is pending to work on the dependency. Subscribe to its completion, it will
+							// schedule us again when it finishes.
+							if (_dependency_counter == nullptr) {
+								_dependency_counter = make_shared_instance<std::atomic_int>();
+							}
+							++(*_dependency_counter);
+
+							column->subpass_waiting_tasks[prev_subpass_index].push_back(this);
+							++pass_stats.dependency_wait_count;
+
+							waiting = true;
 
 						} else {
 							// No task is pending to work on the dependency, spawn one.
 
-							if (dependency_counter == nullptr) {
-								dependency_counter = make_shared_instance<std::atomic_int>();
+							if (_dependency_counter == nullptr) {
+								_dependency_counter = make_shared_instance<std::atomic_int>();
 							}
-							++(*dependency_counter);
+							++(*_dependency_counter);
 
 							GenerateColumnMultipassTask *subtask = ZN_NEW(GenerateColumnMultipassTask(
 									cpos,
@@ -255,7 +266,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 									_generator,
 									_priority,
 									this,
-									dependency_counter
+									_dependency_counter
 							));
 							subtask->_caller_mp_task = this;
 							task_scheduler.push_main_task(subtask);
@@ -278,7 +289,10 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 			}
 		}
 
-		if (spawned_subtasks) {
+		if (spawned_subtasks || waiting) {
+			// Ownership is now shared by the subtasks and columns we wait for. The last one to finish will schedule
+			// us again. That can't happen before we release the region lock, because they need to lock their
+			// column too.
 			ctx.status = ThreadedTaskContext::STATUS_TAKEN_OUT;
 
 		} else if (postpone) {
@@ -336,8 +350,13 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 					input.pass_index = pass_index;
 					input.block_size = _block_size;
 
+					const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+
 					// This should be the ONLY place where `_generator` is used.
 					_generator->generate_pass(input);
+
+					pass_stats.time_usec += Time::get_singleton()->get_ticks_usec() - time_before;
+					++pass_stats.column_count;
 				}
 
 				// Update levels
@@ -354,6 +373,9 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 			main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
 
+			// Neighbor columns waiting for this one may now proceed
+			schedule_waiting_tasks(*main_column, _subpass_index, true, task_scheduler);
+
 			if (main_column->subpass_index == final_subpass_index) {
 				// All tasks that were waiting for this column to be complete (and did not spawn column subtasks
 				// themselves) may now resume
@@ -379,6 +401,31 @@ void GenerateColumnMultipassTask::schedule_final_block_tasks(Column &column, Buf
 	}
 }
 
+void GenerateColumnMultipassTask::schedule_waiting_tasks(
+		Column &column,
+		unsigned int subpass_index,
+		bool success,
+		BufferedTaskScheduler &task_scheduler
+) {
+	StdVector<GenerateColumnMultipassTask *> &waiting_tasks = column.subpass_waiting_tasks[subpass_index];
+	for (GenerateColumnMultipassTask *task : waiting_tasks) {
+		task->on_dependency_finished(success, task_scheduler);
+	}
+	waiting_tasks.clear();
+}
+
+void GenerateColumnMultipassTask::on_dependency_finished(bool success, BufferedTaskScheduler &task_scheduler) {
+	ZN_ASSERT(_dependency_counter != nullptr);
+	if (!success) {
+		_cancelled = true;
+	}
+	const int counter = --(*_dependency_counter);
+	ZN_ASSERT(counter >= 0);
+	if (counter == 0) {
+		task_scheduler.push_main_task(this);
+	}
+}
+
 void GenerateColumnMultipassTask::return_to_caller(bool success) {
 	ZN_ASSERT(_caller_task != nullptr);
 	ZN_ASSERT(_caller_task_dependency_counter != nullptr);
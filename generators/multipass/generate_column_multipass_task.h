@@ -13,10 +13,11 @@ class BufferedTaskScheduler;
 // If at least one column isn't found in the map, the task is cancelled, and so should be all its callers.
 // Otherwise:
 // If a column doesn't fulfills dependency requirements:
-//     - If another task is working on that column, the current task is postponed to run later.
+//     - If another task is working on that column, the current task subscribes to its completion.
 //     - Otherwise, a subtask is spawned to work on the dependency.
-//       The current task is queued after every subtask spawned this way.
-// Otherwise, the task runs the pass, re-schedules its caller, and returns.
+//       The current task is taken out, and queued again once every task it subscribed to or spawned has finished.
+//       This way, columns advance to the next subpass as soon as their neighbors are ready, without polling.
+// Otherwise, the task runs the pass, re-schedules its caller and tasks subscribed to it, and returns.
 //
 // One reason to use this pattern instead of "pyramid diffs", is that it can be invoked without assumptions. It will
 // return a result if necessary, even if the map is in inconsistent state. We can even decide to override states.
@@ -48,6 +49,15 @@ public:
 		return _priority;
 	}
 
+	// Schedules tasks that were waiting for the given column to complete a subpass. If `success` is false, they will
+	// cancel. Must be called while the column is locked for writing.
+	static void schedule_waiting_tasks(
+			VoxelGeneratorMultipassCBStructs::Column &column,
+			unsigned int subpass_index,
+			bool success,
+			BufferedTaskScheduler &task_scheduler
+	);
+
 	// Cancellation cannot use this API for now (it would prevent the task from running) because the task must run in
 	// order to re-schedule its caller. Eventually we may find a way to integrate this pattern into the framework.
 	// bool is_cancelled() {}
@@ -58,6 +68,7 @@ private:
 			BufferedTaskScheduler &task_scheduler
 	);
 	void return_to_caller(bool success);
+	void on_dependency_finished(bool success, BufferedTaskScheduler &task_scheduler);
 
 	Vector2i _column_position;
 	TaskPriority _priority;
@@ -73,6 +84,9 @@ private:
 	// processed".
 	std::shared_ptr<std::atomic_int> _caller_task_dependency_counter;
 	GenerateColumnMultipassTask *_caller_mp_task = nullptr;
+	// Counts subtasks spawned by the current task, and tasks of other columns it waits for. The current task is
+	// scheduled again when it reaches zero.
+	std::shared_ptr<std::atomic_int> _dependency_counter;
 };
 
 } // namespace zylann::voxel
@@ -5,9 +5,11 @@
 #include "../../util/godot/check_ref_ownership.h"
 #include "../../util/godot/classes/time.h"
 #include "../../util/godot/core/array.h"
+#include "../../util/godot/core/dictionary.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 #include "generate_block_multipass_cb_task.h"
+#include "generate_column_multipass_task.h"
 
 namespace zylann::voxel {
 
@@ -331,6 +333,13 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 						}
 					}
 
+					// Tasks of neighbor columns waiting for this one can't complete anymore
+					for (unsigned int subpass_index = 0; subpass_index < MAX_SUBPASSES; ++subpass_index) {
+						GenerateColumnMultipassTask::schedule_waiting_tasks(
+								column, subpass_index, false, task_scheduler
+						);
+					}
+
 					// TODO Implement saving tasks
 					// We remove immediately for now
 					map.columns.erase(it);
@@ -408,6 +417,39 @@ bool VoxelGeneratorMultipassCB::debug_try_get_column_states(StdVector<DebugColum
 	return true;
 }
 
+void VoxelGeneratorMultipassCB::get_pass_stats(StdVector<PassStatsSnapshot> &out_stats) const {
+	std::shared_ptr<Internal> internal = get_internal();
+	out_stats.resize(internal->passes.size());
+	for (unsigned int pass_index = 0; pass_index < out_stats.size(); ++pass_index) {
+		const PassStats &src = internal->pass_stats[pass_index];
+		PassStatsSnapshot &dst = out_stats[pass_index];
+		dst.column_count = src.column_count;
+		dst.time_usec = src.time_usec;
+		dst.dependency_wait_count = src.dependency_wait_count;
+		dst.lock_retry_count = src.lock_retry_count;
+	}
+}
+
+Array VoxelGeneratorMultipassCB::debug_get_pass_stats() const {
+	StdVector<PassStatsSnapshot> stats;
+	get_pass_stats(stats);
+
+	Array stats_array;
+	stats_array.resize(stats.size());
+
+	for (unsigned int pass_index = 0; pass_index < stats.size(); ++pass_index) {
+		const PassStatsSnapshot &s = stats[pass_index];
+		Dictionary d;
+		d["column_count"] = s.column_count;
+		d["time_usec"] = s.time_usec;
+		d["dependency_wait_count"] = s.dependency_wait_count;
+		d["lock_retry_count"] = s.lock_retry_count;
+		stats_array[pass_index] = d;
+	}
+
+	return stats_array;
+}
+
 #ifdef TOOLS_ENABLED
 
 void VoxelGeneratorMultipassCB::get_configuration_warnings(PackedStringArray &out_warnings) const {
@@ -634,6 +676,7 @@ void VoxelGeneratorMultipassCB::_bind_methods() {
 			D_METHOD("debug_generate_test_column", "column_position_blocks"),
 			&VoxelGeneratorMultipassCB::debug_generate_test_column
 	);
+	ClassDB::bind_method(D_METHOD("debug_get_pass_stats"), &VoxelGeneratorMultipassCB::debug_get_pass_stats);
 
 #if defined(ZN_GODOT)
 	// TODO Test if GDVIRTUAL can print errors properly when GDScript fails inside a different thread.
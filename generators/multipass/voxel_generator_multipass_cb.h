@@ -115,6 +115,17 @@ public:
 
 	bool debug_try_get_column_states(StdVector<DebugColumnState> &out_states);
 
+	struct PassStatsSnapshot {
+		uint32_t column_count;
+		uint64_t time_usec;
+		uint32_t dependency_wait_count;
+		uint32_t lock_retry_count;
+	};
+
+	// Gets counters accumulated by generation tasks for each pass, since the cache was last reset.
+	void get_pass_stats(StdVector<PassStatsSnapshot> &out_stats) const;
+	Array debug_get_pass_stats() const;
+
 protected:
 	bool _set(const StringName &p_name, const Variant &p_value);
 	bool _get(const StringName &p_name, Variant &r_ret) const;
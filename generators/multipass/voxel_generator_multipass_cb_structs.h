@@ -2,6 +2,7 @@
 #define VOXEL_GENERATOR_MULTIPASS_CB_STRUCTS_H
 
 #include "../../storage/voxel_buffer.h"
+#include "../../util/containers/fixed_array.h"
 #include "../../util/containers/small_vector.h"
 #include "../../util/containers/span.h"
 #include "../../util/containers/std_unordered_map.h"
@@ -12,6 +13,7 @@
 #include "../../util/thread/mutex.h"
 #include "../../util/thread/spatial_lock_2d.h"
 
+#include <atomic>
 #include <utility>
 
 // Data structures used internally in multipass generation.
@@ -25,6 +27,9 @@ namespace zylann {
 class IThreadedTask;
 
 namespace voxel {
+
+class GenerateColumnMultipassTask;
+
 namespace VoxelGeneratorMultipassCBStructs {
 
 // Pass limit is pretty low because in practice not that many should be needed, and it gets expensive really quick
@@ -77,6 +82,11 @@ struct Column {
 	// Each bit is set to 1 when a task is pending to process this block at a given subpass.
 	uint8_t pending_subpass_tasks_mask = 0;
 
+	// For each subpass, tasks of neighbor columns waiting for the pending task of this column to complete that
+	// subpass. They are scheduled when it does (or when it cancels, or when the column is unloaded), so they don't
+	// have to poll. Only filled while the corresponding bit of `pending_subpass_tasks_mask` is set.
+	FixedArray<StdVector<GenerateColumnMultipassTask *>, MAX_SUBPASSES> subpass_waiting_tasks;
+
 	// Currently unused, because if chunks get removed from the cache or don't get saved for any reason,
 	// it can become out of sync and we wouldn't know. It would be a nice optimization tho...
 	//
@@ -124,6 +134,18 @@ struct Pass {
 	int8_t dependency_extents = 0;
 };
 
+// Counters updated by tasks, for profiling purposes.
+struct PassStats {
+	// How many times the pass ran on a column
+	std::atomic_uint32_t column_count = { 0 };
+	// Time spent running the pass, summed over all threads
+	std::atomic_uint64_t time_usec = { 0 };
+	// How many times a task had to wait for neighbor columns to complete the previous subpass
+	std::atomic_uint32_t dependency_wait_count = { 0 };
+	// How many times a task had to be postponed because another task was locking the area it needs
+	std::atomic_uint32_t lock_retry_count = { 0 };
+};
+
 // Internal state of the generator.
 struct Internal {
 	// Map used solely for generation purposes. It acts like a cache so we don't recompute the same passes many
@@ -143,6 +165,8 @@ struct Internal {
 	// tasks can end faster if they check this boolean.
 	bool expired = false;
 
+	FixedArray<PassStats, MAX_PASSES> pass_stats;
+
 	Internal() {
 		// 1 pass minimum
 		passes.push_back(Pass());
@@ -175,6 +175,14 @@ public:
 
 	virtual void clear_cache();
 
+	// Gets a hash identifying the voxels this generator produces. Generators returning the same hash are expected to
+	// produce the same voxels, so their output can be cached (see `VoxelGeneratorOutputCache`). Returning 0 means it
+	// is not supported.
+	// Must be thread-safe.
+	virtual uint64_t get_output_hash() const {
+		return 0;
+	}
+
 	// Editor
 
 #ifdef TOOLS_ENABLED
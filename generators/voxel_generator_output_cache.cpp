@@ -0,0 +1,502 @@
+#include "voxel_generator_output_cache.h"
+#include "../storage/voxel_buffer.h"
+#include "../streams/voxel_block_serializer.h"
+#include "../util/godot/classes/directory.h"
+#include "../util/godot/classes/file_access.h"
+#include "../util/godot/file_utils.h"
+#include "../util/hash_funcs.h"
+#include "../util/io/log.h"
+#include "../util/io/serialization.h"
+#include "../util/profiling.h"
+#include "../util/string/format.h"
+
+#include <cstring>
+
+namespace zylann::voxel {
+
+namespace {
+
+const char *FILE_EXTENSION = "vxgc";
+// Files are written with this extension first, and renamed once complete
+const char *TEMP_FILE_EXTENSION = "vxgctmp";
+
+const uint8_t FILE_MAGIC[4] = { 'V', 'X', 'G', 'C' };
+const uint8_t FILE_VERSION = 1;
+// Magic, version, generator hash, position, LOD index, block size, data size, checksum
+const unsigned int FILE_HEADER_SIZE = 4 + 1 + 8 + 3 * 4 + 1 + 1 + 4 + 4;
+
+// Files only live for the duration of the session, so this doesn't have to be the same across platforms
+uint32_t compute_checksum(Span<const uint8_t> data) {
+	uint32_t h = HASH_MURMUR3_SEED;
+	size_t i = 0;
+	for (; i + sizeof(uint32_t) <= data.size(); i += sizeof(uint32_t)) {
+		uint32_t v;
+		memcpy(&v, data.data() + i, sizeof(v));
+		h = hash_murmur3_one_32(v, h);
+	}
+	for (; i < data.size(); ++i) {
+		h = hash_murmur3_one_32(data[i], h);
+	}
+	return hash_fmix32(h ^ static_cast<uint32_t>(data.size()));
+}
+
+void write_file_header(StdVector<uint8_t> &dst, const VoxelGeneratorOutputCache::Key &key, Span<const uint8_t> data) {
+	MemoryWriter f(dst, ENDIANNESS_LITTLE_ENDIAN);
+	f.store_buffer(Span<const uint8_t>(FILE_MAGIC, sizeof(FILE_MAGIC)));
+	f.store_8(FILE_VERSION);
+	f.store_64(key.generator_hash);
+	f.store_32(key.position.x);
+	f.store_32(key.position.y);
+	f.store_32(key.position.z);
+	f.store_8(key.lod_index);
+	f.store_8(key.block_size);
+	f.store_32(data.size());
+	f.store_32(compute_checksum(data));
+}
+
+// Checks the header of a file is for the given key and that its data is intact, and gets that data.
+bool read_file_header(
+		Span<const uint8_t> file_data,
+		const VoxelGeneratorOutputCache::Key &key,
+		Span<const uint8_t> &out_data
+) {
+	if (file_data.size() < FILE_HEADER_SIZE) {
+		return false;
+	}
+	if (memcmp(file_data.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+		return false;
+	}
+
+	MemoryReader f(file_data, ENDIANNESS_LITTLE_ENDIAN);
+	f.pos = sizeof(FILE_MAGIC);
+
+	if (f.get_8() != FILE_VERSION) {
+		return false;
+	}
+
+	VoxelGeneratorOutputCache::Key file_key;
+	file_key.generator_hash = f.get_64();
+	file_key.position.x = static_cast<int32_t>(f.get_32());
+	file_key.position.y = static_cast<int32_t>(f.get_32());
+	file_key.position.z = static_cast<int32_t>(f.get_32());
+	file_key.lod_index = f.get_8();
+	file_key.block_size = f.get_8();
+	if (!(file_key == key)) {
+		return false;
+	}
+
+	const uint32_t data_size = f.get_32();
+	const uint32_t checksum = f.get_32();
+	if (data_size != file_data.size() - FILE_HEADER_SIZE) {
+		return false;
+	}
+
+	const Span<const uint8_t> data = file_data.sub(FILE_HEADER_SIZE, data_size);
+	if (compute_checksum(data) != checksum) {
+		return false;
+	}
+
+	out_data = data;
+	return true;
+}
+
+StdVector<uint8_t> &get_tls_data() {
+	static thread_local StdVector<uint8_t> tls_data;
+	return tls_data;
+}
+
+} // namespace
+
+VoxelGeneratorOutputCache::~VoxelGeneratorOutputCache() {
+	clear();
+}
+
+void VoxelGeneratorOutputCache::configure(size_t memory_budget_bytes, String directory, size_t disk_budget_bytes) {
+	clear();
+
+	_memory_budget = memory_budget_bytes;
+	_disk_budget = disk_budget_bytes;
+	_directory = "";
+
+	if (_memory_budget == 0 || directory.is_empty() || _disk_budget == 0) {
+		return;
+	}
+
+	const Error err = zylann::godot::check_directory_created(directory);
+	if (err != OK) {
+		ZN_PRINT_ERROR(format(
+				"Could not create generator cache directory {}, blocks won't be written to files",
+				zylann::godot::to_std_string(directory)
+		));
+		return;
+	}
+
+	_directory = directory;
+	remove_leftover_files();
+}
+
+bool VoxelGeneratorOutputCache::load(const Key &key, VoxelBuffer &out_voxels, bool &out_max_lod_hint) {
+	ZN_PROFILE_SCOPE();
+
+	// Copying compressed data so decompression can run without holding the lock
+	StdVector<uint8_t> &data = get_tls_data();
+	bool on_disk = false;
+	{
+		MutexLock mlock(_mutex);
+
+		auto it = _map.find(key);
+		if (it == _map.end()) {
+			++_miss_count;
+			return false;
+		}
+
+		const uint32_t index = it->second;
+		Entry &entry = _entries[index];
+		out_max_lod_hint = entry.max_lod_hint;
+
+		if (entry.on_disk) {
+			on_disk = true;
+			data.resize(entry.size);
+		} else {
+			data = entry.data;
+			lru_remove(_memory_lru, index);
+			lru_push_front(_memory_lru, index);
+		}
+	}
+
+	Span<const uint8_t> compressed_data = to_span_const(data);
+
+	if (on_disk) {
+		// The file could have been removed or rewritten by another thread meanwhile, in which case we consider it a
+		// miss
+		Error err;
+		Ref<FileAccess> f = zylann::godot::open_file(get_file_path(key), FileAccess::READ, err);
+		if (f.is_null() || f->get_length() != data.size() ||
+			zylann::godot::get_buffer(**f, to_span(data)) != data.size()) {
+			ZN_PRINT_VERBOSE(
+					format("Could not read cached generator block {} lod {}", key.position, int(key.lod_index))
+			);
+			++_miss_count;
+			return false;
+		}
+		if (!read_file_header(to_span_const(data), key, compressed_data)) {
+			ZN_PRINT_ERROR(format(
+					"Cached generator block file {} lod {} is invalid or corrupted", key.position, int(key.lod_index)
+			));
+			++_miss_count;
+			return false;
+		}
+	}
+
+	if (!BlockSerializer::decompress_and_deserialize(compressed_data, out_voxels)) {
+		ZN_PRINT_ERROR("Failed to decompress cached generator block");
+		++_miss_count;
+		return false;
+	}
+
+	if (on_disk) {
+		// Bring it back in memory, the file is not needed anymore
+		store_compressed(key, compressed_data, out_max_lod_hint);
+	}
+
+	++_hit_count;
+	return true;
+}
+
+void VoxelGeneratorOutputCache::store(const Key &key, const VoxelBuffer &voxels, bool max_lod_hint) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(is_enabled());
+
+	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(voxels);
+	ZN_ASSERT_RETURN(result.success);
+
+	store_compressed(key, to_span_const(result.data), max_lod_hint);
+}
+
+void VoxelGeneratorOutputCache::store_compressed(const Key &key, Span<const uint8_t> data, bool max_lod_hint) {
+	StdVector<FileToWrite> files_to_write;
+	StdVector<Key> files_to_remove;
+	{
+		MutexLock mlock(_mutex);
+
+		uint32_t index;
+		auto it = _map.find(key);
+		if (it == _map.end()) {
+			index = allocate_entry();
+			_map.insert({ key, index });
+			++_memory_entry_count;
+		} else {
+			index = it->second;
+			Entry &entry = _entries[index];
+			if (entry.on_disk) {
+				lru_remove(_disk_lru, index);
+				_disk_usage -= entry.size;
+				--_disk_entry_count;
+				++_memory_entry_count;
+				files_to_remove.push_back(key);
+			} else {
+				lru_remove(_memory_lru, index);
+				_memory_usage -= entry.size;
+			}
+		}
+
+		Entry &entry = _entries[index];
+		entry.key = key;
+		entry.data.resize(data.size());
+		memcpy(entry.data.data(), data.data(), data.size());
+		entry.size = data.size();
+		entry.max_lod_hint = max_lod_hint;
+		entry.on_disk = false;
+		lru_push_front(_memory_lru, index);
+		_memory_usage += entry.size;
+
+		evict_from_memory(files_to_write);
+	}
+
+	if (files_to_remove.size() > 0) {
+		remove_files(to_span(files_to_remove));
+	}
+	if (files_to_write.size() > 0) {
+		write_files(to_span(files_to_write));
+	}
+}
+
+void VoxelGeneratorOutputCache::clear() {
+	StdVector<Key> files_to_remove;
+	{
+		MutexLock mlock(_mutex);
+
+		uint32_t index = _disk_lru.head;
+		while (index != NULL_INDEX) {
+			const Entry &entry = _entries[index];
+			files_to_remove.push_back(entry.key);
+			index = entry.next;
+		}
+
+		_map.clear();
+		_entries.clear();
+		_free_entries.clear();
+		_memory_lru = LRUList();
+		_disk_lru = LRUList();
+		_memory_usage = 0;
+		_disk_usage = 0;
+		_memory_entry_count = 0;
+		_disk_entry_count = 0;
+	}
+
+	if (files_to_remove.size() > 0) {
+		remove_files(to_span(files_to_remove));
+	}
+}
+
+VoxelGeneratorOutputCache::Stats VoxelGeneratorOutputCache::get_stats() const {
+	Stats stats;
+	{
+		MutexLock mlock(_mutex);
+		stats.memory_usage = _memory_usage;
+		stats.disk_usage = _disk_usage;
+		stats.memory_entry_count = _memory_entry_count;
+		stats.disk_entry_count = _disk_entry_count;
+	}
+	stats.hit_count = _hit_count;
+	stats.miss_count = _miss_count;
+	return stats;
+}
+
+uint32_t VoxelGeneratorOutputCache::allocate_entry() {
+	if (_free_entries.size() > 0) {
+		const uint32_t index = _free_entries.back();
+		_free_entries.pop_back();
+		return index;
+	}
+	const uint32_t index = _entries.size();
+	_entries.push_back(Entry());
+	return index;
+}
+
+void VoxelGeneratorOutputCache::remove_entry(uint32_t index) {
+	Entry &entry = _entries[index];
+	_map.erase(entry.key);
+	if (entry.on_disk) {
+		lru_remove(_disk_lru, index);
+		_disk_usage -= entry.size;
+		--_disk_entry_count;
+	} else {
+		lru_remove(_memory_lru, index);
+		_memory_usage -= entry.size;
+		--_memory_entry_count;
+	}
+	entry = Entry();
+	_free_entries.push_back(index);
+}
+
+void VoxelGeneratorOutputCache::lru_push_front(LRUList &list, uint32_t index) {
+	Entry &entry = _entries[index];
+	entry.prev = NULL_INDEX;
+	entry.next = list.head;
+	if (list.head != NULL_INDEX) {
+		_entries[list.head].prev = index;
+	} else {
+		list.tail = index;
+	}
+	list.head = index;
+}
+
+void VoxelGeneratorOutputCache::lru_remove(LRUList &list, uint32_t index) {
+	Entry &entry = _entries[index];
+	if (entry.prev != NULL_INDEX) {
+		_entries[entry.prev].next = entry.next;
+	} else {
+		list.head = entry.next;
+	}
+	if (entry.next != NULL_INDEX) {
+		_entries[entry.next].prev = entry.prev;
+	} else {
+		list.tail = entry.prev;
+	}
+	entry.prev = NULL_INDEX;
+	entry.next = NULL_INDEX;
+}
+
+void VoxelGeneratorOutputCache::evict_from_memory(StdVector<FileToWrite> &out_files_to_write) {
+	const bool spill_to_disk = !_directory.is_empty();
+
+	while (_memory_usage > _memory_budget && _memory_lru.tail != NULL_INDEX) {
+		const uint32_t index = _memory_lru.tail;
+		Entry &entry = _entries[index];
+		if (spill_to_disk) {
+			out_files_to_write.push_back(FileToWrite{ entry.key, std::move(entry.data), entry.max_lod_hint });
+		}
+		remove_entry(index);
+	}
+}
+
+void VoxelGeneratorOutputCache::evict_from_disk(StdVector<Key> &out_files_to_remove) {
+	while (_disk_usage > _disk_budget && _disk_lru.tail != NULL_INDEX) {
+		const uint32_t index = _disk_lru.tail;
+		out_files_to_remove.push_back(_entries[index].key);
+		remove_entry(index);
+	}
+}
+
+void VoxelGeneratorOutputCache::write_files(Span<FileToWrite> files) {
+	ZN_PROFILE_SCOPE();
+
+	Ref<DirAccess> dir = zylann::godot::open_directory(_directory);
+	ZN_ASSERT_RETURN(dir.is_valid());
+
+	// Files are written without holding the lock, and only become visible to `load` once they are complete.
+	// Another thread could be writing the same block, so each write goes to its own temporary file, which is then
+	// renamed. That way the file always contains one complete write.
+	StdVector<uint8_t> header;
+	for (FileToWrite &file : files) {
+		const String file_path = get_file_path(file.key);
+		const String temp_file_path = file_path.get_basename() + "_" +
+				String::num_uint64(_temp_file_counter.fetch_add(1, std::memory_order_relaxed)) + "." +
+				TEMP_FILE_EXTENSION;
+
+		header.clear();
+		write_file_header(header, file.key, to_span_const(file.data));
+
+		{
+			Error err;
+			Ref<FileAccess> f = zylann::godot::open_file(temp_file_path, FileAccess::WRITE, err);
+			if (f.is_null()) {
+				ZN_PRINT_ERROR(format("Could not write cached generator block: error {}", int(err)));
+				// Don't register it
+				file.data.clear();
+				continue;
+			}
+			zylann::godot::store_buffer(**f, to_span_const(header));
+			zylann::godot::store_buffer(**f, to_span_const(file.data));
+			// The file gets closed here, before renaming it
+		}
+
+		const Error rename_err = dir->rename(temp_file_path, file_path);
+		if (rename_err != OK) {
+			ZN_PRINT_ERROR(format("Could not rename cached generator block file: error {}", int(rename_err)));
+			dir->remove(temp_file_path);
+			file.data.clear();
+			continue;
+		}
+	}
+
+	StdVector<Key> files_to_remove;
+	{
+		MutexLock mlock(_mutex);
+
+		for (const FileToWrite &file : files) {
+			if (file.data.size() == 0) {
+				continue;
+			}
+			if (_map.find(file.key) != _map.end()) {
+				// The block was stored again while we were writing the file
+				files_to_remove.push_back(file.key);
+				continue;
+			}
+			const uint32_t index = allocate_entry();
+			_map.insert({ file.key, index });
+			Entry &entry = _entries[index];
+			entry.key = file.key;
+			entry.size = FILE_HEADER_SIZE + file.data.size();
+			entry.max_lod_hint = file.max_lod_hint;
+			entry.on_disk = true;
+			lru_push_front(_disk_lru, index);
+			_disk_usage += entry.size;
+			++_disk_entry_count;
+		}
+
+		evict_from_disk(files_to_remove);
+	}
+
+	if (files_to_remove.size() > 0) {
+		remove_files(to_span(files_to_remove));
+	}
+}
+
+void VoxelGeneratorOutputCache::remove_files(Span<const Key> keys) const {
+	ZN_PROFILE_SCOPE();
+
+	Ref<DirAccess> dir = zylann::godot::open_directory(_directory);
+	ZN_ASSERT_RETURN(dir.is_valid());
+
+	for (const Key &key : keys) {
+		dir->remove(get_file_path(key));
+	}
+}
+
+void VoxelGeneratorOutputCache::remove_leftover_files() {
+	// Files from a previous session are not tracked, so they would only take space
+	Ref<DirAccess> dir = zylann::godot::open_directory(_directory);
+	ZN_ASSERT_RETURN(dir.is_valid());
+	ZN_ASSERT_RETURN(dir->change_dir(_directory) == OK);
+
+	StdVector<String> file_names;
+	dir->list_dir_begin();
+	String file_name = dir->get_next();
+	while (!file_name.is_empty()) {
+		if (!dir->current_is_dir() &&
+			(file_name.get_extension() == FILE_EXTENSION || file_name.get_extension() == TEMP_FILE_EXTENSION)) {
+			file_names.push_back(file_name);
+		}
+		file_name = dir->get_next();
+	}
+	dir->list_dir_end();
+
+	for (const String &name : file_names) {
+		dir->remove(name);
+	}
+
+	if (file_names.size() > 0) {
+		ZN_PRINT_VERBOSE(format("Removed {} leftover generator cache files", file_names.size()));
+	}
+}
+
+String VoxelGeneratorOutputCache::get_file_path(const Key &key) const {
+	const String file_name = String::num_uint64(key.generator_hash, 16) + "_" + String::num_int64(key.position.x) +
+			"_" + String::num_int64(key.position.y) + "_" + String::num_int64(key.position.z) + "_" +
+			String::num_int64(key.lod_index) + "_" + String::num_int64(key.block_size) + "." + FILE_EXTENSION;
+	return _directory.path_join(file_name);
+}
+
+} // namespace zylann::voxel
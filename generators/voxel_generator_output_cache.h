@@ -0,0 +1,140 @@
+#ifndef VOXEL_GENERATOR_OUTPUT_CACHE_H
+#define VOXEL_GENERATOR_OUTPUT_CACHE_H
+
+#include "../util/containers/span.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/containers/std_vector.h"
+#include "../util/godot/core/string.h"
+#include "../util/math/vector3i.h"
+#include "../util/thread/mutex.h"
+
+#include <atomic>
+
+namespace zylann::voxel {
+
+class VoxelBuffer;
+
+// Bounded cache of compressed blocks produced by generators, so blocks that get unloaded and requested again later
+// don't have to be generated from scratch. Blocks are identified by the output hash of their generator (see
+// `VoxelGenerator::get_output_hash`), so when a generator is modified, old entries are no longer hit and eventually
+// get evicted.
+//
+// When the memory budget is exceeded, least recently used blocks are evicted. If a directory is set, evicted blocks
+// are written to files in it instead of being discarded, up to a separate budget, and can be loaded back from there.
+// Files are only tracked for the duration of the session. They start with a header holding their key and a checksum,
+// which are verified when loading them back.
+//
+// Thread-safe.
+class VoxelGeneratorOutputCache {
+public:
+	struct Key {
+		uint64_t generator_hash;
+		Vector3i position;
+		uint8_t lod_index;
+		uint8_t block_size;
+
+		inline bool operator==(const Key &other) const {
+			return generator_hash == other.generator_hash && position == other.position &&
+					lod_index == other.lod_index && block_size == other.block_size;
+		}
+	};
+
+	struct Stats {
+		size_t memory_usage = 0;
+		size_t disk_usage = 0;
+		unsigned int memory_entry_count = 0;
+		unsigned int disk_entry_count = 0;
+		uint64_t hit_count = 0;
+		uint64_t miss_count = 0;
+	};
+
+	~VoxelGeneratorOutputCache();
+
+	// Not thread-safe, should be called before the cache gets used.
+	// A budget of zero disables the cache. An empty directory disables writing evicted blocks to files.
+	void configure(size_t memory_budget_bytes, String directory, size_t disk_budget_bytes);
+
+	inline bool is_enabled() const {
+		return _memory_budget > 0;
+	}
+
+	// Gets a block from the cache. Returns false if it wasn't found.
+	bool load(const Key &key, VoxelBuffer &out_voxels, bool &out_max_lod_hint);
+	// Stores a copy of a block in the cache.
+	void store(const Key &key, const VoxelBuffer &voxels, bool max_lod_hint);
+
+	void clear();
+
+	Stats get_stats() const;
+
+private:
+	static const uint32_t NULL_INDEX = 0xffffffff;
+
+	struct KeyHasher {
+		inline size_t operator()(const Key &key) const {
+			uint64_t h = hash_djb2_one_64(key.generator_hash);
+			h = hash_djb2_one_64(Vector3iHasher::hash(key.position), h);
+			return hash_djb2_one_64(uint64_t(key.lod_index) | (uint64_t(key.block_size) << 8), h);
+		}
+	};
+
+	// Intrusive doubly-linked list of entries, from most recently used to least recently used
+	struct LRUList {
+		uint32_t head = NULL_INDEX;
+		uint32_t tail = NULL_INDEX;
+	};
+
+	struct Entry {
+		Key key;
+		// Compressed voxels. Empty if the block is stored in a file.
+		StdVector<uint8_t> data;
+		// Size of the data in memory or in the file
+		uint32_t size = 0;
+		bool max_lod_hint = false;
+		bool on_disk = false;
+		uint32_t prev = NULL_INDEX;
+		uint32_t next = NULL_INDEX;
+	};
+
+	struct FileToWrite {
+		Key key;
+		StdVector<uint8_t> data;
+		bool max_lod_hint;
+	};
+
+	void store_compressed(const Key &key, Span<const uint8_t> data, bool max_lod_hint);
+	uint32_t allocate_entry();
+	void remove_entry(uint32_t index);
+	void lru_push_front(LRUList &list, uint32_t index);
+	void lru_remove(LRUList &list, uint32_t index);
+	void evict_from_memory(StdVector<FileToWrite> &out_files_to_write);
+	void evict_from_disk(StdVector<Key> &out_files_to_remove);
+	void write_files(Span<FileToWrite> files);
+	void remove_files(Span<const Key> keys) const;
+	void remove_leftover_files();
+	String get_file_path(const Key &key) const;
+
+	size_t _memory_budget = 0;
+	size_t _disk_budget = 0;
+	String _directory;
+
+	StdUnorderedMap<Key, uint32_t, KeyHasher> _map;
+	StdVector<Entry> _entries;
+	StdVector<uint32_t> _free_entries;
+	LRUList _memory_lru;
+	LRUList _disk_lru;
+	size_t _memory_usage = 0;
+	size_t _disk_usage = 0;
+	unsigned int _memory_entry_count = 0;
+	unsigned int _disk_entry_count = 0;
+	Mutex _mutex;
+
+	std::atomic_uint64_t _hit_count = { 0 };
+	std::atomic_uint64_t _miss_count = { 0 };
+	// Makes temporary file names unique when several threads write files
+	std::atomic_uint32_t _temp_file_counter = { 0 };
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_GENERATOR_OUTPUT_CACHE_H
@@ -240,6 +240,44 @@ void VoxelBlockyModel::set_collision_mask(uint32_t mask) {
 	_collision_mask = mask;
 }
 
+namespace {
+
+unsigned int get_side_normal_axis(const Cube::Side side) {
+	const Vector3i normal = Cube::g_side_normals[side];
+	return normal.x != 0 ? Vector3i::AXIS_X : (normal.y != 0 ? Vector3i::AXIS_Y : Vector3i::AXIS_Z);
+}
+
+// Tells if a side is a quad with one vertex on each corner of the side of the unit cube
+bool is_full_side_quad(const VoxelBlockyModel::BakedData::SideSurface &side_surface, const Cube::Side side) {
+	if (side_surface.positions.size() != 4 || side_surface.indices.size() != 6) {
+		return false;
+	}
+
+	const unsigned int normal_axis = get_side_normal_axis(side);
+	const unsigned int u_axis = (normal_axis + 1) % Vector3iUtil::AXIS_COUNT;
+	const unsigned int v_axis = (normal_axis + 2) % Vector3iUtil::AXIS_COUNT;
+	const float plane = Cube::g_side_normals[side][normal_axis] > 0 ? 1.f : 0.f;
+	const float tolerance = 0.0001f;
+
+	uint8_t corners_mask = 0;
+	for (const Vector3f &p : side_surface.positions) {
+		if (!Math::is_equal_approx(p[normal_axis], plane, tolerance)) {
+			return false;
+		}
+		const float u = p[u_axis];
+		const float v = p[v_axis];
+		if ((!Math::is_equal_approx(u, 0.f, tolerance) && !Math::is_equal_approx(u, 1.f, tolerance)) ||
+			(!Math::is_equal_approx(v, 0.f, tolerance) && !Math::is_equal_approx(v, 1.f, tolerance))) {
+			return false;
+		}
+		corners_mask |= 1 << ((u > 0.5f ? 1 : 0) | (v > 0.5f ? 2 : 0));
+	}
+
+	return corners_mask == 0b1111;
+}
+
+} // namespace
+
 void VoxelBlockyModel::bake(BakedData &baked_data, bool bake_tangents, MaterialIndexer &materials) const {
 	// TODO That's a bit iffy, design something better?
 	// The following logic must run after derived classes, should not be called directly
@@ -270,6 +308,25 @@ void VoxelBlockyModel::bake(BakedData &baked_data, bool bake_tangents, MaterialI
 		}
 	}
 
+	// Set full sides mask
+	model.full_sides_mask = 0;
+	for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+		if ((model.empty_sides_mask & (1 << side)) != 0) {
+			continue;
+		}
+		bool full = true;
+		for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+			const BakedData::SideSurface &side_surface = model.surfaces[surface_index].sides[side];
+			if (side_surface.indices.size() > 0 && !is_full_side_quad(side_surface, Cube::Side(side))) {
+				full = false;
+				break;
+			}
+		}
+		if (full) {
+			model.full_sides_mask |= (1 << side);
+		}
+	}
+
 	// Assign material overrides if any
 	for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
 		if (surface_index < _surface_count) {
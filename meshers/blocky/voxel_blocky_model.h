@@ -82,6 +82,9 @@ public:
 			unsigned int surface_count = 0;
 			// Cached information to check this case early
 			uint8_t empty_sides_mask = 0;
+			// Sides made of a single quad covering the whole side of the cube, in every surface that isn't empty.
+			// Such sides can be merged with their neighbors when greedy meshing is used.
+			uint8_t full_sides_mask = 0;
 
 			// Tells what is the "shape" of each side in order to cull them quickly when in contact with neighbors.
 			// Side patterns are still determined based on a combination of all surfaces.
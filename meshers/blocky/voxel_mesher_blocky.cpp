@@ -1,6 +1,7 @@
 #include "voxel_mesher_blocky.h"
 #include "../../constants/cube_tables.h"
 #include "../../storage/voxel_buffer.h"
+#include "../../util/containers/container_funcs.h"
 #include "../../util/containers/span.h"
 #include "../../util/godot/core/array.h"
 #include "../../util/godot/core/packed_arrays.h"
@@ -59,8 +60,238 @@ StdVector<int> &get_tls_index_offsets() {
 	return tls_index_offsets;
 }
 
+// For each side, faces that can be merged, in ZXY order within the meshed area. Zero means no face.
+StdVector<uint32_t> &get_tls_greedy_mask() {
+	static thread_local StdVector<uint32_t> tls_greedy_mask;
+	return tls_greedy_mask;
+}
+
+// Cells of the padded block that can collide as part of a box, in ZXY order. See `append_box_collision`.
+StdVector<uint8_t> &get_tls_box_collision_mask() {
+	static thread_local StdVector<uint8_t> tls_box_collision_mask;
+	return tls_box_collision_mask;
+}
+
+// Tells if a model fills its whole cell and collides, so its collision can be merged with neighbors into boxes
+inline bool is_box_collider(const VoxelBlockyModel::BakedData &voxel) {
+	const VoxelBlockyModel::BakedData::Model &model = voxel.model;
+	if (model.full_sides_mask != 0b111111) {
+		return false;
+	}
+	for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+		if (!model.surfaces[surface_index].collision_enabled) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Faces can only be merged if their model and ambient occlusion are the same. Occlusion must also be the same on all
+// corners, otherwise it would be stretched over the merged face.
+inline uint32_t make_greedy_mask_value(uint32_t voxel_id, uint32_t shade) {
+	return ((voxel_id << 2) | shade) + 1;
+}
+
+inline uint32_t get_greedy_mask_voxel_id(uint32_t v) {
+	return (v - 1) >> 2;
+}
+
+inline uint32_t get_greedy_mask_shade(uint32_t v) {
+	return (v - 1) & 0b11;
+}
+
+// Vertices that don't come from merged faces use their regular UVs, so that wrapping has no effect on them
+void fill_missing_uvs2(VoxelMesherBlocky::Arrays &arrays) {
+	const size_t begin = arrays.uvs2.size();
+	arrays.uvs2.resize(arrays.uvs.size());
+	for (size_t i = begin; i < arrays.uvs.size(); ++i) {
+		arrays.uvs2[i] = arrays.uvs[i];
+	}
+}
+
 } // namespace
 
+// Generates faces gathered in the greedy mask, merging neighbor faces that are the same into larger quads.
+// Texture coordinates are extended over merged faces as if the texture was repeating, so the texture of one face
+// repeats on every voxel. Because textures are often part of an atlas, the origin of the tile in UV space is also
+// provided in UV2, so shaders can wrap coordinates within the tile.
+void append_greedy_faces(
+		StdVector<VoxelMesherBlocky::Arrays> &out_arrays_per_material,
+		VoxelMesher::Output::CollisionSurface *collision_surface,
+		Span<uint32_t> mask,
+		const Vector3i mask_size,
+		const VoxelBlockyLibraryBase::BakedData &library,
+		bool bake_occlusion,
+		float baked_occlusion_darkness,
+		bool box_collision
+) {
+	ZN_PROFILE_SCOPE();
+
+	const unsigned int mask_volume = Vector3iUtil::get_volume(mask_size);
+
+	// Note: the mask is indexed in ZXY order
+	FixedArray<unsigned int, Vector3iUtil::AXIS_COUNT> strides;
+	strides[Vector3i::AXIS_X] = mask_size.y;
+	strides[Vector3i::AXIS_Y] = 1;
+	strides[Vector3i::AXIS_Z] = mask_size.x * mask_size.y;
+
+	struct L {
+		static inline bool is_row_equal(
+				Span<const uint32_t> side_mask,
+				unsigned int begin,
+				unsigned int count,
+				unsigned int stride,
+				uint32_t v
+		) {
+			for (unsigned int i = 0; i < count; ++i) {
+				if (side_mask[begin + i * stride] != v) {
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+
+	for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+		Span<uint32_t> side_mask = mask.sub(side * mask_volume, mask_volume);
+
+		const Vector3i normal = Cube::g_side_normals[side];
+		const unsigned int za =
+				normal.x != 0 ? Vector3i::AXIS_X : (normal.y != 0 ? Vector3i::AXIS_Y : Vector3i::AXIS_Z);
+		const unsigned int xa = (za + 1) % Vector3iUtil::AXIS_COUNT;
+		const unsigned int ya = (za + 2) % Vector3iUtil::AXIS_COUNT;
+
+		// For each deck
+		for (int d = 0; d < mask_size[za]; ++d) {
+			for (int fy = 0; fy < mask_size[ya]; ++fy) {
+				for (int fx = 0; fx < mask_size[xa]; ++fx) {
+					const unsigned int mask_index = d * strides[za] + fx * strides[xa] + fy * strides[ya];
+					const uint32_t m = side_mask[mask_index];
+
+					if (m == 0) {
+						continue;
+					}
+
+					// Check if the next faces are the same along X
+					int rx = fx + 1;
+					while (rx < mask_size[xa] && side_mask[mask_index + (rx - fx) * strides[xa]] == m) {
+						++rx;
+					}
+					const unsigned int width = rx - fx;
+
+					// Check if the next rows of faces are the same along Y
+					int ry = fy + 1;
+					while (ry < mask_size[ya] &&
+						   L::is_row_equal(side_mask, mask_index + (ry - fy) * strides[ya], width, strides[xa], m)) {
+						++ry;
+					}
+					const unsigned int height = ry - fy;
+
+					for (unsigned int j = 0; j < height; ++j) {
+						for (unsigned int i = 0; i < width; ++i) {
+							side_mask[mask_index + i * strides[xa] + j * strides[ya]] = 0;
+						}
+					}
+
+					// Commit face to the mesh
+
+					const VoxelBlockyModel::BakedData &voxel = library.models[get_greedy_mask_voxel_id(m)];
+					const VoxelBlockyModel::BakedData::Model &model = voxel.model;
+
+					VoxelMesher::Output::CollisionSurface *face_collision_surface =
+							box_collision && is_box_collider(voxel) ? nullptr : collision_surface;
+
+					Color color = voxel.color;
+					const uint32_t shade = get_greedy_mask_shade(m);
+					if (bake_occlusion && shade > 0) {
+						const float gs = 1.f - baked_occlusion_darkness * static_cast<float>(shade);
+						color = Color(gs, gs, gs) * color;
+					}
+
+					Vector3f pos;
+					pos[za] = d;
+					pos[xa] = fx;
+					pos[ya] = fy;
+
+					for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+						const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+						const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
+
+						if (side_surface.indices.size() == 0) {
+							continue;
+						}
+
+						// The side is known to be a quad with one vertex on each corner
+						ZN_ASSERT(side_surface.positions.size() == 4);
+
+						FixedArray<Vector2f, 4> corner_uvs;
+						FixedArray<uint8_t, 4> vertex_corners;
+						for (unsigned int i = 0; i < 4; ++i) {
+							const Vector3f p = side_surface.positions[i];
+							const uint8_t corner = (p[xa] > 0.5f ? 1 : 0) | (p[ya] > 0.5f ? 2 : 0);
+							vertex_corners[i] = corner;
+							corner_uvs[corner] = side_surface.uvs[i];
+						}
+						const Vector2f uv_step_x = corner_uvs[1] - corner_uvs[0];
+						const Vector2f uv_step_y = corner_uvs[2] - corner_uvs[0];
+						const Vector2f tile_origin(
+								math::min(corner_uvs[0].x, corner_uvs[1].x, corner_uvs[2].x, corner_uvs[3].x),
+								math::min(corner_uvs[0].y, corner_uvs[1].y, corner_uvs[2].y, corner_uvs[3].y)
+						);
+
+						FixedArray<Vector3f, 4> positions;
+						for (unsigned int i = 0; i < 4; ++i) {
+							Vector3f p = side_surface.positions[i] + pos;
+							if ((vertex_corners[i] & 1) != 0) {
+								p[xa] += width - 1;
+							}
+							if ((vertex_corners[i] & 2) != 0) {
+								p[ya] += height - 1;
+							}
+							positions[i] = p;
+						}
+
+						VoxelMesherBlocky::Arrays &arrays = out_arrays_per_material[surface.material_id];
+						fill_missing_uvs2(arrays);
+
+						const unsigned int index_offset = arrays.positions.size();
+
+						for (unsigned int i = 0; i < 4; ++i) {
+							const uint8_t corner = vertex_corners[i];
+							const float tx = (corner & 1) != 0 ? width - 1 : 0;
+							const float ty = (corner & 2) != 0 ? height - 1 : 0;
+
+							arrays.positions.push_back(positions[i]);
+							arrays.uvs.push_back(side_surface.uvs[i] + uv_step_x * tx + uv_step_y * ty);
+							arrays.uvs2.push_back(tile_origin);
+							arrays.normals.push_back(to_vec3f(normal));
+							arrays.colors.push_back(color);
+						}
+
+						if (side_surface.tangents.size() > 0) {
+							append_array(arrays.tangents, side_surface.tangents);
+						}
+
+						for (const int i : side_surface.indices) {
+							arrays.indices.push_back(index_offset + i);
+						}
+
+						if (face_collision_surface != nullptr && surface.collision_enabled) {
+							const unsigned int collision_index_offset = face_collision_surface->positions.size();
+							for (const Vector3f &p : positions) {
+								face_collision_surface->positions.push_back(p);
+							}
+							for (const int i : side_surface.indices) {
+								face_collision_surface->indices.push_back(collision_index_offset + i);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
 template <typename Type_T>
 void generate_blocky_mesh( //
 		StdVector<VoxelMesherBlocky::Arrays> &out_arrays_per_material, //
@@ -69,7 +300,9 @@ void generate_blocky_mesh( //
 		const Vector3i block_size, //
 		const VoxelBlockyLibraryBase::BakedData &library, //
 		bool bake_occlusion, //
-		float baked_occlusion_darkness //
+		float baked_occlusion_darkness, //
+		bool greedy_meshing, //
+		bool box_collision //
 ) {
 	// TODO Optimization: not sure if this mandates a template function. There is so much more happening in this
 	// function other than reading voxels, although reading is on the hottest path. It needs to be profiled. If
@@ -97,6 +330,16 @@ void generate_blocky_mesh( //
 
 	int collision_surface_index_offset = 0;
 
+	const Vector3i greedy_mask_size = max - min;
+	const unsigned int greedy_mask_volume = Vector3iUtil::get_volume(greedy_mask_size);
+	Span<uint32_t> greedy_mask;
+	if (greedy_meshing) {
+		StdVector<uint32_t> &tls_greedy_mask = get_tls_greedy_mask();
+		tls_greedy_mask.clear();
+		tls_greedy_mask.resize(Cube::SIDE_COUNT * greedy_mask_volume, 0);
+		greedy_mask = to_span(tls_greedy_mask);
+	}
+
 	FixedArray<int, Cube::SIDE_COUNT> side_neighbor_lut;
 	side_neighbor_lut[Cube::SIDE_LEFT] = row_size;
 	side_neighbor_lut[Cube::SIDE_RIGHT] = -row_size;
@@ -169,6 +412,10 @@ void generate_blocky_mesh( //
 				const VoxelBlockyModel::BakedData &voxel = library.models[voxel_id];
 				const VoxelBlockyModel::BakedData::Model &model = voxel.model;
 
+				// With box collision, models filling their cell are handled separately
+				VoxelMesher::Output::CollisionSurface *voxel_collision_surface =
+						box_collision && is_box_collider(voxel) ? nullptr : collision_surface;
+
 				// Hybrid approach: extract cube faces and decimate those that aren't visible,
 				// and still allow voxels to have geometry that is not a cube.
 
@@ -220,6 +467,19 @@ void generate_blocky_mesh( //
 						}
 					}
 
+					if (greedy_meshing && (model.full_sides_mask & (1 << side)) != 0) {
+						const int shade = shaded_corner[Cube::g_side_corners[side][0]];
+						if (shaded_corner[Cube::g_side_corners[side][1]] == shade &&
+							shaded_corner[Cube::g_side_corners[side][2]] == shade &&
+							shaded_corner[Cube::g_side_corners[side][3]] == shade) {
+							// The face will be generated later, possibly merged with its neighbors
+							const unsigned int mask_index = side * greedy_mask_volume +
+									Vector3iUtil::get_zxy_index(Vector3i(x, y, z) - min, greedy_mask_size);
+							greedy_mask[mask_index] = make_greedy_mask_value(voxel_id, shade);
+							continue;
+						}
+					}
+
 					// Subtracting 1 because the data is padded
 					const Vector3f pos(x - 1, y - 1, z - 1);
 
@@ -328,9 +588,9 @@ void generate_blocky_mesh( //
 							}
 						}
 
-						if (collision_surface != nullptr && surface.collision_enabled) {
-							StdVector<Vector3f> &dst_positions = collision_surface->positions;
-							StdVector<int> &dst_indices = collision_surface->indices;
+						if (voxel_collision_surface != nullptr && surface.collision_enabled) {
+							StdVector<Vector3f> &dst_positions = voxel_collision_surface->positions;
+							StdVector<int> &dst_indices = voxel_collision_surface->indices;
 
 							{
 								const unsigned int append_index = dst_positions.size();
@@ -403,9 +663,9 @@ void generate_blocky_mesh( //
 						arrays.indices.push_back(index_offset + indices[i]);
 					}
 
-					if (collision_surface != nullptr && surface.collision_enabled) {
-						StdVector<Vector3f> &dst_positions = collision_surface->positions;
-						StdVector<int> &dst_indices = collision_surface->indices;
+					if (voxel_collision_surface != nullptr && surface.collision_enabled) {
+						StdVector<Vector3f> &dst_positions = voxel_collision_surface->positions;
+						StdVector<int> &dst_indices = voxel_collision_surface->indices;
 
 						for (unsigned int i = 0; i < vertex_count; ++i) {
 							dst_positions.push_back(positions[i] + pos);
@@ -422,6 +682,143 @@ void generate_blocky_mesh( //
 			}
 		}
 	}
+
+	if (greedy_meshing) {
+		append_greedy_faces(
+				out_arrays_per_material,
+				collision_surface,
+				greedy_mask,
+				greedy_mask_size,
+				library,
+				bake_occlusion,
+				baked_occlusion_darkness,
+				box_collision
+		);
+	}
+}
+
+// Generates collision for models filling their whole cell by merging them into boxes, like greedy meshing but in 3D.
+// Only sides of boxes that are not fully covered by other solid cells are generated. This produces a lot less
+// triangles than using the sides of every voxel, which makes collision shapes faster to build and to query.
+// Other models are expected to have their collision generated from their triangles.
+template <typename Type_T>
+void append_box_collision(
+		VoxelMesher::Output::CollisionSurface &collision_surface,
+		const Span<const Type_T> type_buffer,
+		const Vector3i block_size,
+		const VoxelBlockyLibraryBase::BakedData &library
+) {
+	ZN_PROFILE_SCOPE();
+
+	const int row_size = block_size.y;
+	const int deck_size = block_size.x * row_size;
+	const unsigned int volume = Vector3iUtil::get_volume(block_size);
+	ZN_ASSERT_RETURN(type_buffer.size() >= volume);
+
+	// Cell values
+	static const uint8_t EMPTY = 0;
+	static const uint8_t SOLID = 1;
+	static const uint8_t SOLID_IN_BOX = 2;
+
+	StdVector<uint8_t> &tls_mask = get_tls_box_collision_mask();
+	tls_mask.resize(volume);
+	Span<uint8_t> mask = to_span(tls_mask);
+
+	// Padding cells are included, so sides touching neighbor blocks can be culled too
+	for (unsigned int i = 0; i < volume; ++i) {
+		const uint32_t voxel_id = type_buffer[i];
+		mask[i] = library.has_model(voxel_id) && is_box_collider(library.models[voxel_id]) ? SOLID : EMPTY;
+	}
+
+	// Tells if all cells in an area are solid. If `free_only` is true, they must also not be part of a box already.
+	const auto is_solid = [mask, row_size, deck_size](Vector3i from, Vector3i to, bool free_only) {
+		for (int z = from.z; z < to.z; ++z) {
+			for (int x = from.x; x < to.x; ++x) {
+				const int begin = x * row_size + z * deck_size;
+				for (int y = from.y; y < to.y; ++y) {
+					const uint8_t m = mask[begin + y];
+					if (m == EMPTY || (free_only && m != SOLID)) {
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	};
+
+	// Data must be padded, hence the off-by-one
+	const Vector3i min = Vector3iUtil::create(VoxelMesherBlocky::PADDING);
+	const Vector3i max = block_size - Vector3iUtil::create(VoxelMesherBlocky::PADDING);
+
+	StdVector<Vector3f> &dst_positions = collision_surface.positions;
+	StdVector<int> &dst_indices = collision_surface.indices;
+
+	for (int z = min.z; z < max.z; ++z) {
+		for (int x = min.x; x < max.x; ++x) {
+			for (int y = min.y; y < max.y; ++y) {
+				if (mask[y + x * row_size + z * deck_size] != SOLID) {
+					continue;
+				}
+
+				// Grow a box along Y, then X, then Z
+				const Vector3i box_min(x, y, z);
+				Vector3i box_max(x + 1, y + 1, z + 1);
+				while (box_max.y < max.y && is_solid(Vector3i(x, box_max.y, z), box_max + Vector3i(0, 1, 0), true)) {
+					++box_max.y;
+				}
+				while (box_max.x < max.x &&
+					   is_solid(Vector3i(box_max.x, y, z), box_max + Vector3i(1, 0, 0), true)) {
+					++box_max.x;
+				}
+				while (box_max.z < max.z &&
+					   is_solid(Vector3i(x, y, box_max.z), box_max + Vector3i(0, 0, 1), true)) {
+					++box_max.z;
+				}
+
+				for (int bz = box_min.z; bz < box_max.z; ++bz) {
+					for (int bx = box_min.x; bx < box_max.x; ++bx) {
+						const int begin = bx * row_size + bz * deck_size;
+						for (int by = box_min.y; by < box_max.y; ++by) {
+							mask[begin + by] = SOLID_IN_BOX;
+						}
+					}
+				}
+
+				const Vector3f box_size = to_vec3f(box_max - box_min);
+				const Vector3f box_origin = to_vec3f(box_min - Vector3iUtil::create(VoxelMesherBlocky::PADDING));
+
+				for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+					// Cells touching that side
+					const Vector3i normal = Cube::g_side_normals[side];
+					const unsigned int axis =
+							normal.x != 0 ? Vector3i::AXIS_X : (normal.y != 0 ? Vector3i::AXIS_Y : Vector3i::AXIS_Z);
+					Vector3i from = box_min;
+					Vector3i to = box_max;
+					if (normal[axis] > 0) {
+						from[axis] = box_max[axis];
+						to[axis] = box_max[axis] + 1;
+					} else {
+						from[axis] = box_min[axis] - 1;
+						to[axis] = box_min[axis];
+					}
+
+					if (is_solid(from, to, false)) {
+						// Fully covered
+						continue;
+					}
+
+					const unsigned int index_offset = dst_positions.size();
+					for (unsigned int i = 0; i < 4; ++i) {
+						const Vector3f corner = Cube::g_corner_position[Cube::g_side_corners[side][i]];
+						dst_positions.push_back(box_origin + corner * box_size);
+					}
+					for (unsigned int i = 0; i < 6; ++i) {
+						dst_indices.push_back(index_offset + Cube::g_side_quad_triangles[side][i]);
+					}
+				}
+			}
+		}
+	}
 }
 
 Vector3f side_to_block_coordinates(const Vector3f v, const VoxelBlockyModel::Side side) {
@@ -663,6 +1060,27 @@ bool VoxelMesherBlocky::get_occlusion_enabled() const {
 	return _parameters.bake_occlusion;
 }
 
+void VoxelMesherBlocky::set_greedy_meshing_enabled(bool enable) {
+	RWLockWrite wlock(_parameters_lock);
+	_parameters.greedy_meshing = enable;
+}
+
+bool VoxelMesherBlocky::is_greedy_meshing_enabled() const {
+	RWLockRead rlock(_parameters_lock);
+	return _parameters.greedy_meshing;
+}
+
+void VoxelMesherBlocky::set_collision_mode(CollisionMode mode) {
+	ERR_FAIL_INDEX(mode, COLLISION_MODE_COUNT);
+	RWLockWrite wlock(_parameters_lock);
+	_parameters.collision_mode = mode;
+}
+
+VoxelMesherBlocky::CollisionMode VoxelMesherBlocky::get_collision_mode() const {
+	RWLockRead rlock(_parameters_lock);
+	return _parameters.collision_mode;
+}
+
 void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::Input &input) {
 	const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_TYPE;
 	Parameters params;
@@ -692,12 +1110,11 @@ void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::In
 	}
 
 	// The technique is Culled faces.
-	// Could be improved with greedy meshing: https://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
-	// However I don't feel it's worth it yet:
+	// Optionally, greedy meshing can be used on top of it: https://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
+	// It isn't the default:
 	// - Not so much gain for organic worlds with lots of texture variations
-	// - Works well with cubes but not with any shape
-	// - Slower
-	// => Could be implemented in a separate class?
+	// - Only applies to sides covering a whole side of the cube
+	// - Requires a shader to wrap UVs when using an atlas
 
 	const VoxelBuffer &voxels = input.voxels;
 
@@ -716,14 +1133,17 @@ void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::In
 		// error), decompress into a backing array to still allow the use of the same algorithm.
 		return;
 
-	} else if (voxels.get_channel_compression(channel) != VoxelBuffer::COMPRESSION_NONE) {
+	} else if (voxels.get_channel_compression(channel) != VoxelBuffer::COMPRESSION_NONE &&
+			   voxels.get_channel_compression(channel) != VoxelBuffer::COMPRESSION_PALETTE) {
 		// No other form of compression is allowed
 		ERR_PRINT("VoxelMesherBlocky received unsupported voxel compression");
 		return;
 	}
 
+	// Palette-compressed channels are decoded into this buffer
+	StdVector<uint8_t> decoded_channel;
 	Span<const uint8_t> raw_channel;
-	if (!voxels.get_channel_as_bytes_read_only(channel, raw_channel)) {
+	if (!voxels.get_channel_as_bytes_read_only(channel, raw_channel, decoded_channel)) {
 		// Case supposedly handled before...
 		ERR_PRINT("Something wrong happened");
 		return;
@@ -736,6 +1156,7 @@ void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::In
 	if (input.collision_hint) {
 		collision_surface = &output.collision_surface;
 	}
+	const bool box_collision = collision_surface != nullptr && params.collision_mode == COLLISION_MODE_BOXES;
 
 	unsigned int material_count = 0;
 	{
@@ -758,8 +1179,13 @@ void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::In
 						block_size, //
 						library_baked_data, //
 						params.bake_occlusion, //
-						baked_occlusion_darkness //
+						baked_occlusion_darkness, //
+						params.greedy_meshing, //
+						box_collision //
 				);
+				if (box_collision) {
+					append_box_collision(*collision_surface, raw_channel, block_size, library_baked_data);
+				}
 				if (input.lod_index > 0) {
 					append_seams(raw_channel, block_size, arrays_per_material, library_baked_data);
 				}
@@ -774,8 +1200,13 @@ void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::In
 						block_size,
 						library_baked_data,
 						params.bake_occlusion,
-						baked_occlusion_darkness
+						baked_occlusion_darkness,
+						params.greedy_meshing,
+						box_collision
 				);
+				if (box_collision) {
+					append_box_collision(*collision_surface, model_ids, block_size, library_baked_data);
+				}
 				if (input.lod_index > 0) {
 					append_seams(model_ids, block_size, arrays_per_material, library_baked_data);
 				}
@@ -802,6 +1233,13 @@ void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::In
 		}
 	}
 
+	if (params.greedy_meshing) {
+		// Done after generation because more vertices can be added after merged faces
+		for (unsigned int material_index = 0; material_index < material_count; ++material_index) {
+			fill_missing_uvs2(arrays_per_material[material_index]);
+		}
+	}
+
 	// TODO Optimization: we could return a single byte array and use Mesh::add_surface down the line?
 	// That API does not seem to exist yet though.
 
@@ -838,6 +1276,12 @@ void VoxelMesherBlocky::build(VoxelMesher::Output &output, const VoxelMesher::In
 				}
 			}
 
+			if (params.greedy_meshing) {
+				PackedVector2Array uvs2;
+				copy_to(uvs2, arrays.uvs2);
+				mesh_arrays[Mesh::ARRAY_TEX_UV2] = uvs2;
+			}
+
 			output.surfaces.push_back(Output::Surface());
 			Output::Surface &surface = output.surfaces.back();
 			surface.arrays = mesh_arrays;
@@ -927,6 +1371,14 @@ void VoxelMesherBlocky::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_occlusion_darkness", "value"), &VoxelMesherBlocky::set_occlusion_darkness);
 	ClassDB::bind_method(D_METHOD("get_occlusion_darkness"), &VoxelMesherBlocky::get_occlusion_darkness);
 
+	ClassDB::bind_method(
+			D_METHOD("set_greedy_meshing_enabled", "enable"), &VoxelMesherBlocky::set_greedy_meshing_enabled
+	);
+	ClassDB::bind_method(D_METHOD("is_greedy_meshing_enabled"), &VoxelMesherBlocky::is_greedy_meshing_enabled);
+
+	ClassDB::bind_method(D_METHOD("set_collision_mode", "mode"), &VoxelMesherBlocky::set_collision_mode);
+	ClassDB::bind_method(D_METHOD("get_collision_mode"), &VoxelMesherBlocky::get_collision_mode);
+
 	ADD_PROPERTY(
 			PropertyInfo(
 					Variant::OBJECT,
@@ -947,6 +1399,20 @@ void VoxelMesherBlocky::_bind_methods() {
 			"set_occlusion_darkness",
 			"get_occlusion_darkness"
 	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "greedy_meshing_enabled"),
+			"set_greedy_meshing_enabled",
+			"is_greedy_meshing_enabled"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "collision_mode", PROPERTY_HINT_ENUM, "Faces,Boxes"),
+			"set_collision_mode",
+			"get_collision_mode"
+	);
+
+	BIND_ENUM_CONSTANT(COLLISION_MODE_FACES);
+	BIND_ENUM_CONSTANT(COLLISION_MODE_BOXES);
+	BIND_ENUM_CONSTANT(COLLISION_MODE_COUNT);
 }
 
 } // namespace zylann::voxel
@@ -18,6 +18,14 @@ class VoxelMesherBlocky : public VoxelMesher {
 public:
 	static const int PADDING = 1;
 
+	enum CollisionMode {
+		// Collision uses the visible faces of every model
+		COLLISION_MODE_FACES = 0,
+		// Models filling their whole cell are merged into boxes, other models use their faces
+		COLLISION_MODE_BOXES,
+		COLLISION_MODE_COUNT
+	};
+
 	VoxelMesherBlocky();
 	~VoxelMesherBlocky();
 
@@ -30,6 +38,12 @@ public:
 	void set_occlusion_enabled(bool enable);
 	bool get_occlusion_enabled() const;
 
+	void set_greedy_meshing_enabled(bool enable);
+	bool is_greedy_meshing_enabled() const;
+
+	void set_collision_mode(CollisionMode mode);
+	CollisionMode get_collision_mode() const;
+
 	void build(VoxelMesher::Output &output, const VoxelMesher::Input &input) override;
 
 	// TODO GDX: Resource::duplicate() cannot be overriden (while it can in modules).
@@ -55,6 +69,9 @@ public:
 		StdVector<Vector3f> positions;
 		StdVector<Vector3f> normals;
 		StdVector<Vector2f> uvs;
+		// Only used with greedy meshing. Origin of the texture tile in UV space, so shaders can wrap UVs of merged
+		// faces within their tile. Vertices of faces that were not merged have the same value as `uvs`.
+		StdVector<Vector2f> uvs2;
 		StdVector<Color> colors;
 		StdVector<int> indices;
 		StdVector<float> tangents;
@@ -63,6 +80,7 @@ public:
 			positions.clear();
 			normals.clear();
 			uvs.clear();
+			uvs2.clear();
 			colors.clear();
 			indices.clear();
 			tangents.clear();
@@ -84,6 +102,8 @@ private:
 	struct Parameters {
 		float baked_occlusion_darkness = 0.8;
 		bool bake_occlusion = true;
+		bool greedy_meshing = false;
+		CollisionMode collision_mode = COLLISION_MODE_FACES;
 		Ref<VoxelBlockyLibraryBase> library;
 	};
 
@@ -101,4 +121,6 @@ private:
 
 } // namespace zylann::voxel
 
+VARIANT_ENUM_CAST(zylann::voxel::VoxelMesherBlocky::CollisionMode);
+
 #endif // VOXEL_MESHER_BLOCKY_H
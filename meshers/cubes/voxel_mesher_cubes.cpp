@@ -769,14 +769,17 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 		// If it's all air, nothing to do. If it's all cubes, nothing to do either.
 		return;
 
-	} else if (voxels.get_channel_compression(channel) != VoxelBuffer::COMPRESSION_NONE) {
+	} else if (voxels.get_channel_compression(channel) != VoxelBuffer::COMPRESSION_NONE &&
+			   voxels.get_channel_compression(channel) != VoxelBuffer::COMPRESSION_PALETTE) {
 		// No other form of compression is allowed
 		ERR_PRINT("VoxelMesherCubes received unsupported voxel compression");
 		return;
 	}
 
+	// Palette-compressed channels are decoded into this buffer
+	StdVector<uint8_t> decoded_channel;
 	Span<const uint8_t> raw_channel;
-	if (!voxels.get_channel_as_bytes_read_only(channel, raw_channel)) {
+	if (!voxels.get_channel_as_bytes_read_only(channel, raw_channel, decoded_channel)) {
 		// Case supposedly handled before...
 		ERR_PRINT("Something wrong happened");
 		return;
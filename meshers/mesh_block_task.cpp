@@ -304,6 +304,46 @@ int MeshBlockTask::debug_get_running_count() {
 	return g_debug_mesh_tasks_count;
 }
 
+IncrementalMeshHistory::Snapshot IncrementalMeshHistory::take_snapshot() {
+	MutexLock mlock(_mutex);
+	Snapshot snapshot;
+	snapshot.state = _state;
+	snapshot.dirty_box = _dirty_box;
+	snapshot.version = _version;
+	return snapshot;
+}
+
+void IncrementalMeshHistory::add_dirty_box(const Box3i box) {
+	MutexLock mlock(_mutex);
+	if (_dirty_box.is_empty()) {
+		_dirty_box = box;
+	} else {
+		_dirty_box.merge_with(box);
+	}
+	++_version;
+}
+
+void IncrementalMeshHistory::invalidate() {
+	MutexLock mlock(_mutex);
+	_state.reset();
+	_dirty_box = Box3i();
+	++_version;
+}
+
+void IncrementalMeshHistory::store(
+		std::shared_ptr<const VoxelMesher::IncrementalState> state,
+		uint32_t snapshot_version
+) {
+	MutexLock mlock(_mutex);
+	if (_version != snapshot_version) {
+		// Voxels were edited while the build was running. The state it started from remains valid as long as it is
+		// combined with the whole area edited since then.
+		return;
+	}
+	_state = state;
+	_dirty_box = Box3i();
+}
+
 void MeshBlockTask::run(zylann::ThreadedTaskContext &ctx) {
 	ZN_DSTACK();
 	ZN_PROFILE_SCOPE();
@@ -315,6 +355,21 @@ void MeshBlockTask::run(zylann::ThreadedTaskContext &ctx) {
 	);
 #endif
 
+	if (_stage == 0) {
+		VoxelMeshOutputCache::Key cache_key;
+		if (get_mesh_cache_key(cache_key) &&
+			VoxelEngine::get_singleton().get_mesh_output_cache().load(cache_key, _surfaces_output)) {
+			// Neither voxels nor the mesher are needed
+			if (incremental_history != nullptr) {
+				// There is no incremental state to start from, the next build will process the whole block
+				incremental_history->store(nullptr, incremental_snapshot.version);
+				incremental_snapshot.state.reset();
+			}
+			build_mesh_resources();
+			return;
+		}
+	}
+
 	if (block_generation_use_gpu) {
 		if (_stage == 0) {
 			gather_voxels_gpu(ctx);
@@ -475,10 +530,27 @@ void MeshBlockTask::build_mesh() {
 		collision_hint, //
 		lod_hint, //
 		// TODO Gathering detail texture information is not always necessary
-		true // detail_texture_hint
+		true, // detail_texture_hint
+		incremental_history != nullptr, //
+		incremental_snapshot.state.get(), //
+		incremental_snapshot.dirty_box //
 	};
 	mesher->build(_surfaces_output, input);
 
+	if (incremental_history != nullptr) {
+		incremental_history->store(_surfaces_output.incremental_state, incremental_snapshot.version);
+		// No longer needed, don't keep it alive until the output is consumed
+		_surfaces_output.incremental_state.reset();
+		incremental_snapshot.state.reset();
+	}
+
+	{
+		VoxelMeshOutputCache::Key cache_key;
+		if (get_mesh_cache_key(cache_key)) {
+			VoxelEngine::get_singleton().get_mesh_output_cache().store(cache_key, _surfaces_output);
+		}
+	}
+
 	const bool mesh_is_empty = VoxelMesher::is_mesh_empty(_surfaces_output.surfaces);
 
 	// Currently, Transvoxel only is supported in combination with detail normalmap texturing, because the algorithm
@@ -535,6 +607,10 @@ void MeshBlockTask::build_mesh() {
 		VoxelEngine::get_singleton().push_async_task(nm_task);
 	}
 
+	build_mesh_resources();
+}
+
+void MeshBlockTask::build_mesh_resources() {
 	if (require_visual && VoxelEngine::get_singleton().is_threaded_graphics_resource_building_enabled()) {
 		// This can only run if the engine supports building meshes from multiple threads
 		_mesh = zylann::voxel::build_mesh(
@@ -549,9 +625,74 @@ void MeshBlockTask::build_mesh() {
 		_has_mesh_resource = false;
 	}
 
+	if (collision_hint && VoxelEngine::get_singleton().is_threaded_collision_shape_building_enabled()) {
+		// Building the shape also builds its acceleration structure, which is too expensive to do on the main thread
+		// when many blocks get meshed at once
+		_collision_shape = make_collision_shape_from_mesher_output(_surfaces_output, **meshing_dependency->mesher);
+		_has_collision_shape = true;
+
+	} else {
+		_has_collision_shape = false;
+	}
+
 	_has_run = true;
 }
 
+bool MeshBlockTask::get_mesh_cache_key(VoxelMeshOutputCache::Key &out_key) const {
+	const VoxelMeshOutputCache &cache = VoxelEngine::get_singleton().get_mesh_output_cache();
+	if (!mesh_cache_hint || !cache.is_enabled() || lod_index < cache.get_begin_lod_index()) {
+		return false;
+	}
+
+	// Detail textures need information from the mesher that isn't cached
+	if (require_detail_texture && detail_texture_settings.enabled) {
+		return false;
+	}
+
+	// Blocks present in the map were edited or loaded from a stream, only cache those generated on the fly
+	for (unsigned int i = 0; i < blocks_count; ++i) {
+		if (blocks[i] != nullptr) {
+			return false;
+		}
+	}
+
+	Ref<VoxelGenerator> generator = meshing_dependency->generator;
+	Ref<VoxelMesher> mesher = meshing_dependency->mesher;
+	if (generator.is_null()) {
+		return false;
+	}
+	const uint64_t generator_hash = generator->get_output_hash();
+	uint64_t mesher_hash = mesher->get_output_hash();
+	if (generator_hash == 0 || mesher_hash == 0) {
+		// Outputs can't be told apart
+		return false;
+	}
+	mesher_hash = hash_djb2_one_64(uint64_t(collision_hint) | (uint64_t(lod_hint) << 1), mesher_hash);
+
+	const CubicAreaInfo area_info = get_cubic_area_info_from_size(blocks_count);
+	if (!area_info.is_valid()) {
+		return false;
+	}
+	const int mesh_block_size = data->get_block_size() * area_info.mesh_block_size_factor;
+
+	// Modifiers are not part of the generator's output hash
+	const int min_padding = mesher->get_minimum_padding();
+	const int max_padding = mesher->get_maximum_padding();
+	const Vector3i origin_in_voxels = (mesh_block_position * mesh_block_size - Vector3iUtil::create(min_padding))
+			<< lod_index;
+	const Vector3i size_in_voxels = Vector3iUtil::create(mesh_block_size + min_padding + max_padding) << lod_index;
+	if (data->get_modifiers().has_modifiers_in(AABB(to_vec3(origin_in_voxels), to_vec3(size_in_voxels)))) {
+		return false;
+	}
+
+	out_key.generator_hash = generator_hash;
+	out_key.mesher_hash = mesher_hash;
+	out_key.position = mesh_block_position;
+	out_key.lod_index = lod_index;
+	out_key.block_size_po2 = math::get_shift_from_power_of_two_32(mesh_block_size);
+	return true;
+}
+
 TaskPriority MeshBlockTask::get_priority() {
 	float closest_viewer_distance_sq;
 	const TaskPriority p =
@@ -590,6 +731,8 @@ void MeshBlockTask::apply_result() {
 			o.mesh_material_indices = std::move(_mesh_material_indices);
 			o.has_mesh_resource = _has_mesh_resource;
 			o.visual_was_required = require_visual;
+			o.collision_shape = _collision_shape;
+			o.has_collision_shape = _has_collision_shape;
 			o.detail_textures = _detail_textures;
 
 			VoxelEngine::VolumeCallbacks callbacks = VoxelEngine::get_singleton().get_volume_callbacks(volume_id);
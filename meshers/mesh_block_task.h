@@ -7,16 +7,46 @@
 #include "../engine/meshing_dependency.h"
 #include "../engine/priority_dependency.h"
 #include "../generators/generate_block_gpu_task.h"
+#include "../meshers/voxel_mesh_output_cache.h"
 #include "../storage/voxel_buffer.h"
 #include "../util/containers/std_vector.h"
 #include "../util/godot/classes/array_mesh.h"
+#include "../util/godot/classes/shape_3d.h"
 #include "../util/tasks/cancellation_token.h"
 #include "../util/tasks/threaded_task.h"
+#include "../util/thread/mutex.h"
 
 namespace zylann::voxel {
 
 class VoxelData;
 
+// Keeps the incremental state output by the last build of a mesh block, along with the area edited since then, so
+// the next build only has to process that area. Shared between a terrain and the tasks meshing the block.
+// Thread-safe.
+class IncrementalMeshHistory {
+public:
+	struct Snapshot {
+		std::shared_ptr<const VoxelMesher::IncrementalState> state;
+		// In voxels of the block's LOD, relative to the block
+		Box3i dirty_box;
+		uint32_t version = 0;
+	};
+
+	// Should be taken before voxels get gathered for meshing
+	Snapshot take_snapshot();
+	void add_dirty_box(const Box3i box);
+	// Forces the next build to process the whole block
+	void invalidate();
+	// Stores the result of a build. Discarded if voxels changed since the snapshot the build started from.
+	void store(std::shared_ptr<const VoxelMesher::IncrementalState> state, uint32_t snapshot_version);
+
+private:
+	Mutex _mutex;
+	std::shared_ptr<const VoxelMesher::IncrementalState> _state;
+	Box3i _dirty_box;
+	uint32_t _version = 0;
+};
+
 // Asynchronous task generating a mesh from voxel blocks and their neighbors, in a particular volume
 class MeshBlockTask : public IGeneratingVoxelsThreadedTask {
 public:
@@ -36,6 +66,10 @@ public:
 
 	static int debug_get_running_count();
 
+	// Exposed for testing.
+	// Gets the key of the block in the mesh cache. Returns false if the block should not use the cache.
+	bool get_mesh_cache_key(VoxelMeshOutputCache::Key &out_key) const;
+
 	// 3x3x3 or 4x4x4 grid of voxel blocks.
 	FixedArray<std::shared_ptr<VoxelBuffer>, constants::MAX_BLOCK_COUNT_PER_REQUEST> blocks;
 	// TODO Need to provide format
@@ -57,25 +91,34 @@ public:
 	uint8_t detail_texture_generator_override_begin_lod_index = 0;
 	bool detail_texture_use_gpu = false;
 	bool block_generation_use_gpu = false;
+	// If true, the mesh may be loaded from or stored into the mesh cache, if it is enabled and the block only
+	// contains generated voxels.
+	bool mesh_cache_hint = false;
 	PriorityDependency priority_dependency;
 	std::shared_ptr<MeshingDependency> meshing_dependency;
 	std::shared_ptr<VoxelData> data;
 	DetailRenderingSettings detail_texture_settings;
 	Ref<VoxelGenerator> detail_texture_generator_override;
 	TaskCancellationToken cancellation_token;
+	// If set, the mesher may build incrementally from the snapshot, and its new state will be stored in the history.
+	std::shared_ptr<IncrementalMeshHistory> incremental_history;
+	IncrementalMeshHistory::Snapshot incremental_snapshot;
 
 private:
 	void gather_voxels_gpu(zylann::ThreadedTaskContext &ctx);
 	void gather_voxels_cpu();
 	void build_mesh();
+	void build_mesh_resources();
 
 	bool _has_run = false;
 	bool _too_far = false;
 	bool _has_mesh_resource = false;
+	bool _has_collision_shape = false;
 	uint8_t _stage = 0;
 	VoxelBuffer _voxels;
 	VoxelMesher::Output _surfaces_output;
 	Ref<Mesh> _mesh;
+	Ref<Shape3D> _collision_shape;
 	StdVector<uint16_t> _mesh_material_indices; // Indexed by mesh surface
 	std::shared_ptr<DetailTextureOutput> _detail_textures;
 	StdVector<GenerateBlockGPUTaskResult> _gpu_generation_results;
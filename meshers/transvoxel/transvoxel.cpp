@@ -366,7 +366,10 @@ void build_regular_mesh(
 		MeshArrays &output,
 		const IDeepSDFSampler *deep_sdf_sampler,
 		StdVector<CellInfo> *cell_info,
-		const float edge_clamp_margin
+		const float edge_clamp_margin,
+		const unsigned int slab_begin,
+		const unsigned int slab_end,
+		StdVector<SlabRange> *out_slab_ranges
 ) {
 	ZN_PROFILE_SCOPE();
 
@@ -397,9 +400,30 @@ void build_regular_mesh(
 	// Get direct representation of the isolevel (not always zero since we are not using signed integers yet)
 	const Sdf_T isolevel = get_isolevel<Sdf_T>();
 
+	// When building in slabs, only some of the decks are iterated, and vertex reuse doesn't cross slab boundaries
+	int begin_z = min_pos.z;
+	int end_z = max_pos.z;
+	if (out_slab_ranges != nullptr) {
+		begin_z = math::min(min_pos.z + static_cast<int>(slab_begin * SLAB_SIZE), max_pos.z);
+		end_z = math::min(min_pos.z + static_cast<int>(slab_end * SLAB_SIZE), max_pos.z);
+	}
+	int slab_min_z = begin_z;
+
 	// Iterate all cells with padding (expected to be neighbors)
 	Vector3i pos;
-	for (pos.z = min_pos.z; pos.z < max_pos.z; ++pos.z) {
+	for (pos.z = begin_z; pos.z < end_z; ++pos.z) {
+		if (out_slab_ranges != nullptr && (pos.z - min_pos.z) % SLAB_SIZE == 0) {
+			if (pos.z != begin_z) {
+				cache.reset_reuse_cells(block_size_with_padding);
+			}
+			slab_min_z = pos.z;
+			SlabRange range;
+			range.vertex_begin = output.vertices.size();
+			range.index_begin = output.indices.size();
+			range.cell_info_begin = cell_info != nullptr ? cell_info->size() : 0;
+			out_slab_ranges->push_back(range);
+		}
+
 		for (pos.y = min_pos.y; pos.y < max_pos.y; ++pos.y) {
 			// TODO Optimization: change iteration to be ZXY? (Data is laid out with Y as deepest coordinate)
 			unsigned int data_index =
@@ -510,7 +534,7 @@ void build_regular_mesh(
 				// While iterating through the cells in a block, a 3-bit mask is maintained whose bits indicate
 				// whether corresponding bits in a direction code are valid
 				const uint8_t direction_validity_mask = (pos.x > min_pos.x ? 1 : 0) |
-						((pos.y > min_pos.y ? 1 : 0) << 1) | ((pos.z > min_pos.z ? 1 : 0) << 2);
+						((pos.y > min_pos.y ? 1 : 0) << 1) | ((pos.z > slab_min_z ? 1 : 0) << 2);
 
 				const uint8_t regular_cell_class_index = tables::get_regular_cell_class(case_code);
 				const tables::RegularCellData &regular_cell_data =
@@ -1371,6 +1395,11 @@ Span<const T> get_or_decompress_channel(const VoxelBuffer &voxels, StdVector<T>
 		}
 		return to_span_const(backing_buffer);
 
+	} else if (voxels.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_PALETTE) {
+		backing_buffer.resize(Vector3iUtil::get_volume(voxels.get_size()));
+		voxels.copy_channel_to_bytes(channel, to_span(backing_buffer).template reinterpret_cast_to<uint8_t>());
+		return to_span_const(backing_buffer);
+
 	} else {
 		Span<const uint8_t> data_bytes;
 		ZN_ASSERT(voxels.get_channel_as_bytes_read_only(channel, data_bytes) == true);
@@ -1381,7 +1410,8 @@ Span<const T> get_or_decompress_channel(const VoxelBuffer &voxels, StdVector<T>
 TextureIndicesData get_texture_indices_data(
 		const VoxelBuffer &voxels,
 		unsigned int channel,
-		DefaultTextureIndicesData &out_default_texture_indices_data
+		DefaultTextureIndicesData &out_default_texture_indices_data,
+		StdVector<uint8_t> &decoded_buffer
 ) {
 	ZN_ASSERT_RETURN_V(voxels.get_channel_depth(channel) == VoxelBuffer::DEPTH_16_BIT, TextureIndicesData());
 
@@ -1398,7 +1428,7 @@ TextureIndicesData get_texture_indices_data(
 
 	} else {
 		Span<const uint8_t> data_bytes;
-		ZN_ASSERT(voxels.get_channel_as_bytes_read_only(channel, data_bytes) == true);
+		ZN_ASSERT(voxels.get_channel_as_bytes_read_only(channel, data_bytes, decoded_buffer) == true);
 		data.buffer = data_bytes.reinterpret_cast_to<const uint16_t>();
 
 		out_default_texture_indices_data.use = false;
@@ -1484,6 +1514,8 @@ Span<const Sdf_T> apply_zero_sdf_fix(Span<const Sdf_T> p_sdf_data) {
 	return to_span_const(sdf_data);
 }*/
 
+namespace {
+
 DefaultTextureIndicesData build_regular_mesh(
 		const VoxelBuffer &voxels,
 		const unsigned int sdf_channel,
@@ -1493,13 +1525,20 @@ DefaultTextureIndicesData build_regular_mesh(
 		MeshArrays &output,
 		const IDeepSDFSampler *deep_sdf_sampler,
 		StdVector<CellInfo> *cell_infos,
-		const float edge_clamp_margin
+		const float edge_clamp_margin,
+		const unsigned int slab_begin,
+		const unsigned int slab_end,
+		StdVector<SlabRange> *out_slab_ranges
 ) {
 	ZN_PROFILE_SCOPE();
 	// From this point, we expect the buffer to contain allocated data in the relevant channels.
 
+	// Only used if channels are palette-compressed
+	StdVector<uint8_t> sdf_decoded_buffer;
+	StdVector<uint8_t> indices_decoded_buffer;
+
 	Span<const uint8_t> sdf_data_raw;
-	ZN_ASSERT(voxels.get_channel_as_bytes_read_only(sdf_channel, sdf_data_raw) == true);
+	ZN_ASSERT(voxels.get_channel_as_bytes_read_only(sdf_channel, sdf_data_raw, sdf_decoded_buffer) == true);
 
 	const unsigned int voxels_count = Vector3iUtil::get_volume(voxels.get_size());
 
@@ -1511,7 +1550,9 @@ DefaultTextureIndicesData build_regular_mesh(
 	if (texturing_mode == TEXTURES_BLEND_4_OVER_16) {
 		// From this point we know SDF is not uniform so it has an allocated buffer,
 		// but it might have uniform indices or weights so we need to ensure there is a backing buffer.
-		indices_data = get_texture_indices_data(voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data);
+		indices_data = get_texture_indices_data(
+				voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data, indices_decoded_buffer
+		);
 		weights_data.u8_data0 =
 				get_or_decompress_channel(voxels, s_weights_backing_buffer_u8_0, VoxelBuffer::CHANNEL_WEIGHTS);
 		weights_data.u8_data1 =
@@ -1527,7 +1568,9 @@ DefaultTextureIndicesData build_regular_mesh(
 	if (texturing_mode == TEXTURES_BLEND_4_OVER_16) {
 		// From this point we know SDF is not uniform so it has an allocated buffer,
 		// but it might have uniform indices or weights so we need to ensure there is a backing buffer.
-		indices_data = get_texture_indices_data(voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data);
+		indices_data = get_texture_indices_data(
+				voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data, indices_decoded_buffer
+		);
 		weights_data.u16_data =
 				get_or_decompress_channel(voxels, get_tls_weights_backing_buffer_u16(), VoxelBuffer::CHANNEL_WEIGHTS);
 		ZN_ASSERT_RETURN_V(weights_data.u16_data.size() == voxels_count, default_texture_indices_data);
@@ -1550,7 +1593,10 @@ DefaultTextureIndicesData build_regular_mesh(
 					output,
 					deep_sdf_sampler,
 					cell_infos,
-					edge_clamp_margin
+					edge_clamp_margin,
+					slab_begin,
+					slab_end,
+					out_slab_ranges
 			);
 		} break;
 
@@ -1567,7 +1613,10 @@ DefaultTextureIndicesData build_regular_mesh(
 					output,
 					deep_sdf_sampler,
 					cell_infos,
-					edge_clamp_margin
+					edge_clamp_margin,
+					slab_begin,
+					slab_end,
+					out_slab_ranges
 			);
 		} break;
 
@@ -1587,7 +1636,10 @@ DefaultTextureIndicesData build_regular_mesh(
 					output,
 					deep_sdf_sampler,
 					cell_infos,
-					edge_clamp_margin
+					edge_clamp_margin,
+					slab_begin,
+					slab_end,
+					out_slab_ranges
 			);
 		} break;
 
@@ -1604,6 +1656,151 @@ DefaultTextureIndicesData build_regular_mesh(
 	return default_texture_indices_data;
 }
 
+template <typename T>
+void append_array_range(StdVector<T> &dst, const StdVector<T> &src, uint32_t begin, uint32_t end) {
+	dst.insert(dst.end(), src.begin() + begin, src.begin() + end);
+}
+
+// Copies slabs [slab_begin, slab_end) from a previous build
+void append_slabs(
+		const SlabbedMesh &src,
+		unsigned int slab_begin,
+		unsigned int slab_end,
+		MeshArrays &output,
+		StdVector<CellInfo> &out_cell_infos,
+		StdVector<SlabRange> &out_ranges
+) {
+	if (slab_begin >= slab_end) {
+		return;
+	}
+	const SlabRange src_begin = src.ranges[slab_begin];
+	const SlabRange src_end = src.ranges[slab_end];
+
+	// Vertices of the copied slabs may now start at a different index
+	const int32_t vertex_offset = static_cast<int32_t>(output.vertices.size()) - src_begin.vertex_begin;
+	const int32_t index_offset = static_cast<int32_t>(output.indices.size()) - src_begin.index_begin;
+	const int32_t cell_info_offset = static_cast<int32_t>(out_cell_infos.size()) - src_begin.cell_info_begin;
+
+	for (unsigned int i = slab_begin; i < slab_end; ++i) {
+		SlabRange r = src.ranges[i];
+		r.vertex_begin += vertex_offset;
+		r.index_begin += index_offset;
+		r.cell_info_begin += cell_info_offset;
+		out_ranges.push_back(r);
+	}
+
+	const MeshArrays &src_arrays = src.arrays;
+	append_array_range(output.vertices, src_arrays.vertices, src_begin.vertex_begin, src_end.vertex_begin);
+	append_array_range(output.normals, src_arrays.normals, src_begin.vertex_begin, src_end.vertex_begin);
+	append_array_range(output.lod_data, src_arrays.lod_data, src_begin.vertex_begin, src_end.vertex_begin);
+	if (src_arrays.texturing_data.size() > 0) {
+		append_array_range(
+				output.texturing_data, src_arrays.texturing_data, src_begin.vertex_begin, src_end.vertex_begin
+		);
+	}
+
+	const size_t indices_begin = output.indices.size();
+	append_array_range(output.indices, src_arrays.indices, src_begin.index_begin, src_end.index_begin);
+	if (vertex_offset != 0) {
+		for (size_t i = indices_begin; i < output.indices.size(); ++i) {
+			output.indices[i] += vertex_offset;
+		}
+	}
+
+	append_array_range(out_cell_infos, src.cell_infos, src_begin.cell_info_begin, src_end.cell_info_begin);
+}
+
+} // namespace
+
+DefaultTextureIndicesData build_regular_mesh(
+		const VoxelBuffer &voxels,
+		const unsigned int sdf_channel,
+		const uint32_t lod_index,
+		const TexturingMode texturing_mode,
+		Cache &cache,
+		MeshArrays &output,
+		const IDeepSDFSampler *deep_sdf_sampler,
+		StdVector<CellInfo> *cell_infos,
+		const float edge_clamp_margin
+) {
+	return build_regular_mesh(
+			voxels,
+			sdf_channel,
+			lod_index,
+			texturing_mode,
+			cache,
+			output,
+			deep_sdf_sampler,
+			cell_infos,
+			edge_clamp_margin,
+			0,
+			0,
+			nullptr
+	);
+}
+
+DefaultTextureIndicesData build_regular_mesh_in_slabs(
+		const VoxelBuffer &voxels,
+		const unsigned int sdf_channel,
+		const uint32_t lod_index,
+		const TexturingMode texturing_mode,
+		Cache &cache,
+		const IDeepSDFSampler *deep_sdf_sampler,
+		const float edge_clamp_margin,
+		const SlabbedMesh *previous,
+		unsigned int slab_begin,
+		unsigned int slab_end,
+		MeshArrays &output,
+		StdVector<CellInfo> &out_cell_infos,
+		StdVector<SlabRange> &out_ranges
+) {
+	ZN_PROFILE_SCOPE();
+
+	output.clear();
+	out_cell_infos.clear();
+	out_ranges.clear();
+
+	const unsigned int slab_count = get_slab_count(voxels.get_size());
+
+	if (previous == nullptr) {
+		slab_begin = 0;
+		slab_end = slab_count;
+	} else {
+		ZN_ASSERT(previous->ranges.size() == slab_count + 1);
+		slab_end = math::min(slab_end, slab_count);
+		slab_begin = math::min(slab_begin, slab_end);
+		append_slabs(*previous, 0, slab_begin, output, out_cell_infos, out_ranges);
+	}
+
+	// Texture indices are gathered from the whole buffer, so they have to be computed even if no slab gets rebuilt
+	const DefaultTextureIndicesData default_texture_indices_data = build_regular_mesh(
+			voxels,
+			sdf_channel,
+			lod_index,
+			texturing_mode,
+			cache,
+			output,
+			deep_sdf_sampler,
+			&out_cell_infos,
+			edge_clamp_margin,
+			slab_begin,
+			slab_end,
+			&out_ranges
+	);
+
+	if (previous != nullptr) {
+		append_slabs(*previous, slab_end, slab_count, output, out_cell_infos, out_ranges);
+	}
+
+	SlabRange end_range;
+	end_range.vertex_begin = output.vertices.size();
+	end_range.index_begin = output.indices.size();
+	end_range.cell_info_begin = out_cell_infos.size();
+	out_ranges.push_back(end_range);
+
+	return default_texture_indices_data;
+}
+
 void build_transition_mesh(
 		const VoxelBuffer &voxels,
 		const unsigned int sdf_channel,
@@ -1618,8 +1815,12 @@ void build_transition_mesh(
 	ZN_PROFILE_SCOPE();
 	// From this point, we expect the buffer to contain allocated data in the relevant channels.
 
+	// Only used if channels are palette-compressed
+	StdVector<uint8_t> sdf_decoded_buffer;
+	StdVector<uint8_t> indices_decoded_buffer;
+
 	Span<const uint8_t> sdf_data_raw;
-	ZN_ASSERT(voxels.get_channel_as_bytes_read_only(sdf_channel, sdf_data_raw) == true);
+	ZN_ASSERT(voxels.get_channel_as_bytes_read_only(sdf_channel, sdf_data_raw, sdf_decoded_buffer) == true);
 
 	const unsigned int voxels_count = Vector3iUtil::get_volume(voxels.get_size());
 
@@ -1635,7 +1836,9 @@ void build_transition_mesh(
 			// From this point we know SDF is not uniform so it has an allocated buffer,
 			// but it might have uniform indices or weights so we need to ensure there is a backing buffer.
 			// TODO Is it worth doing conditionnals instead during meshing?
-			indices_data = get_texture_indices_data(voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data);
+			indices_data = get_texture_indices_data(
+					voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data, indices_decoded_buffer
+			);
 		}
 		weights_data.u8_data0 =
 				get_or_decompress_channel(voxels, s_weights_backing_buffer_u8_0, VoxelBuffer::CHANNEL_WEIGHTS);
@@ -1657,7 +1860,9 @@ void build_transition_mesh(
 			// From this point we know SDF is not uniform so it has an allocated buffer,
 			// but it might have uniform indices or weights so we need to ensure there is a backing buffer.
 			// TODO Is it worth doing conditionnals instead during meshing?
-			indices_data = get_texture_indices_data(voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data);
+			indices_data = get_texture_indices_data(
+					voxels, VoxelBuffer::CHANNEL_INDICES, default_texture_indices_data, indices_decoded_buffer
+			);
 		}
 		weights_data.u16_data =
 				get_or_decompress_channel(voxels, get_tls_weights_backing_buffer_u16(), VoxelBuffer::CHANNEL_WEIGHTS);
@@ -164,6 +164,30 @@ struct CellInfo {
 	uint32_t triangle_count;
 };
 
+// How many cells along the Z axis are grouped into one slab, when building a regular mesh in slabs
+static const unsigned int SLAB_SIZE = 4;
+
+inline unsigned int get_slab_count(const Vector3i block_size_with_padding) {
+	const int cells_z = block_size_with_padding.z - MIN_PADDING - MAX_PADDING;
+	return (cells_z + SLAB_SIZE - 1) / SLAB_SIZE;
+}
+
+// Where the output of a slab of cells starts in mesh arrays
+struct SlabRange {
+	uint32_t vertex_begin;
+	uint32_t index_begin;
+	uint32_t cell_info_begin;
+};
+
+// Regular mesh built in slabs of cells along the Z axis. Vertices are never shared across slabs, so the output of any
+// slab can be rebuilt and replaced without touching the others.
+struct SlabbedMesh {
+	MeshArrays arrays;
+	StdVector<CellInfo> cell_infos;
+	// Start of each slab, followed by the end of the last slab
+	StdVector<SlabRange> ranges;
+};
+
 DefaultTextureIndicesData build_regular_mesh(
 		const VoxelBuffer &voxels,
 		const unsigned int sdf_channel,
@@ -176,6 +200,25 @@ DefaultTextureIndicesData build_regular_mesh(
 		const float edge_clamp_margin
 );
 
+// Builds a regular mesh in slabs. Only slabs in [slab_begin, slab_end) are polygonized, others are copied from
+// `previous`, which must have been built from voxels of the same size. If `previous` is null, all slabs are built.
+// `output` and `out_cell_infos` are cleared first.
+DefaultTextureIndicesData build_regular_mesh_in_slabs(
+		const VoxelBuffer &voxels,
+		const unsigned int sdf_channel,
+		const uint32_t lod_index,
+		const TexturingMode texturing_mode,
+		Cache &cache,
+		const IDeepSDFSampler *deep_sdf_sampler,
+		const float edge_clamp_margin,
+		const SlabbedMesh *previous,
+		unsigned int slab_begin,
+		unsigned int slab_end,
+		MeshArrays &output,
+		StdVector<CellInfo> &out_cell_infos,
+		StdVector<SlabRange> &out_ranges
+);
+
 void build_transition_mesh(
 		const VoxelBuffer &voxels,
 		const unsigned int sdf_channel,
@@ -1,6 +1,7 @@
 #include "voxel_mesher_transvoxel.h"
 #include "../../engine/voxel_engine.h"
 #include "../../generators/voxel_generator.h"
+#include "../../shaders/transvoxel_minimal_compact_shader.h"
 #include "../../shaders/transvoxel_minimal_shader.h"
 #include "../../storage/voxel_buffer_gd.h"
 #include "../../storage/voxel_data.h"
@@ -10,7 +11,9 @@
 #include "../../util/godot/classes/shader.h"
 #include "../../util/godot/classes/shader_material.h"
 #include "../../util/godot/core/packed_arrays.h"
+#include "../../util/godot/core/version.h"
 #include "../../util/math/conv.h"
+#include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
 #include "transvoxel_tables.cpp"
 
@@ -20,6 +23,7 @@ namespace zylann::voxel {
 
 namespace {
 Ref<ShaderMaterial> g_minimal_shader_material;
+Ref<ShaderMaterial> g_minimal_compact_shader_material;
 } // namespace
 
 namespace transvoxel {
@@ -52,10 +56,17 @@ void VoxelMesherTransvoxel::load_static_resources() {
 	shader->set_code(g_transvoxel_minimal_shader);
 	g_minimal_shader_material.instantiate();
 	g_minimal_shader_material->set_shader(shader);
+
+	Ref<Shader> compact_shader;
+	compact_shader.instantiate();
+	compact_shader->set_code(g_transvoxel_minimal_compact_shader);
+	g_minimal_compact_shader_material.instantiate();
+	g_minimal_compact_shader_material->set_shader(compact_shader);
 }
 
 void VoxelMesherTransvoxel::free_static_resources() {
 	g_minimal_shader_material.unref();
+	g_minimal_compact_shader_material.unref();
 }
 
 VoxelMesherTransvoxel::VoxelMesherTransvoxel() {
@@ -112,6 +123,70 @@ void fill_surface_arrays(Array &arrays, const transvoxel::MeshArrays &src) {
 	arrays[Mesh::ARRAY_INDEX] = indices;
 }
 
+// Same as `fill_surface_arrays`, but packs LOD data into two RGBA8 attributes, written directly into the arrays that
+// will be uploaded:
+// - CUSTOM0 (unorm): cell border mask, vertex border mask, transition mask, LOD index
+// - CUSTOM2 (snorm): offset from the vertex to its secondary position, in cells of the LOD (it never exceeds one cell)
+void fill_surface_arrays_compact(Array &arrays, const transvoxel::MeshArrays &src, uint8_t lod_index) {
+	ZN_PROFILE_SCOPE();
+
+	const unsigned int vertex_count = src.vertices.size();
+	ZN_ASSERT(src.lod_data.size() == vertex_count);
+
+	PackedVector3Array vertices;
+	PackedByteArray lod_data;
+	PackedByteArray lod_offsets;
+	PackedInt32Array indices;
+
+	copy_to(vertices, src.vertices);
+	copy_to(indices, src.indices);
+
+	lod_data.resize(vertex_count * 4);
+	lod_offsets.resize(vertex_count * 4);
+	uint8_t *lod_data_w = lod_data.ptrw();
+	int8_t *lod_offsets_w = reinterpret_cast<int8_t *>(lod_offsets.ptrw());
+
+	const float inv_cell_size = 1.f / float(1 << lod_index);
+
+	for (unsigned int vi = 0; vi < vertex_count; ++vi) {
+		const transvoxel::LodAttrib &attrib = src.lod_data[vi];
+
+		lod_data_w[0] = attrib.cell_border_mask;
+		lod_data_w[1] = attrib.vertex_border_mask;
+		lod_data_w[2] = attrib.transition;
+		lod_data_w[3] = lod_index;
+		lod_data_w += 4;
+
+		// The secondary position is not computed for cells that don't touch any side
+		const Vector3f offset = attrib.cell_border_mask != 0
+				? (attrib.secondary_position - src.vertices[vi]) * inv_cell_size
+				: Vector3f();
+		lod_offsets_w[0] = math::clamp(int(Math::round(offset.x * 127.f)), -127, 127);
+		lod_offsets_w[1] = math::clamp(int(Math::round(offset.y * 127.f)), -127, 127);
+		lod_offsets_w[2] = math::clamp(int(Math::round(offset.z * 127.f)), -127, 127);
+		lod_offsets_w[3] = 0;
+		lod_offsets_w += 4;
+	}
+
+	arrays.resize(Mesh::ARRAY_MAX);
+	arrays[Mesh::ARRAY_VERTEX] = vertices;
+	if (src.normals.size() != 0) {
+		PackedVector3Array normals;
+		copy_to(normals, src.normals);
+		arrays[Mesh::ARRAY_NORMAL] = normals;
+	}
+	if (src.texturing_data.size() != 0) {
+		// Already packed as 8 bytes per vertex
+		PackedFloat32Array texturing_data;
+		texturing_data.resize(src.texturing_data.size() * 2);
+		memcpy(texturing_data.ptrw(), src.texturing_data.data(), texturing_data.size() * sizeof(float));
+		arrays[Mesh::ARRAY_CUSTOM1] = texturing_data;
+	}
+	arrays[Mesh::ARRAY_CUSTOM0] = lod_data;
+	arrays[Mesh::ARRAY_CUSTOM2] = lod_offsets;
+	arrays[Mesh::ARRAY_INDEX] = indices;
+}
+
 template <typename T>
 void remap_vertex_array(
 		const StdVector<T> &src_data,
@@ -242,6 +317,106 @@ struct DeepSampler : transvoxel::IDeepSDFSampler {
 	}
 };
 
+struct TransvoxelIncrementalState : VoxelMesher::IncrementalState {
+	struct Settings {
+		Vector3i voxels_size;
+		uint8_t lod_index;
+		uint8_t texturing_mode;
+		bool deep_sampling;
+		float edge_clamp_margin;
+
+		bool operator==(const Settings &other) const {
+			return voxels_size == other.voxels_size && lod_index == other.lod_index &&
+					texturing_mode == other.texturing_mode && deep_sampling == other.deep_sampling &&
+					edge_clamp_margin == other.edge_clamp_margin;
+		}
+	};
+
+	Settings settings;
+	transvoxel::SlabbedMesh mesh;
+};
+
+// Gets which slabs of cells have to be polygonized again after voxels changed in the given box
+void get_dirty_slabs(
+		const Box3i dirty_box,
+		const Vector3i voxels_size,
+		unsigned int &out_slab_begin,
+		unsigned int &out_slab_end
+) {
+	out_slab_begin = 0;
+	out_slab_end = 0;
+	if (dirty_box.is_empty()) {
+		return;
+	}
+	const Vector3i block_size =
+			voxels_size - Vector3iUtil::create(transvoxel::MIN_PADDING + transvoxel::MAX_PADDING);
+	// A cell reads the voxels at its corners, and their neighbors to compute gradients
+	const Vector3i min_cell_pos = dirty_box.position - Vector3i(2, 2, 2);
+	const Vector3i max_cell_pos = dirty_box.position + dirty_box.size + Vector3i(1, 1, 1);
+	const Box3i cells_box = Box3i::from_min_max(min_cell_pos, max_cell_pos).clipped(block_size);
+	if (cells_box.is_empty()) {
+		return;
+	}
+	const int slab_size = transvoxel::SLAB_SIZE;
+	out_slab_begin = cells_box.position.z / slab_size;
+	out_slab_end = math::ceildiv(cells_box.position.z + cells_box.size.z, slab_size);
+}
+
+// Builds the regular mesh in slabs, reusing slabs of the previous state which were not affected by edits
+transvoxel::DefaultTextureIndicesData build_regular_mesh_incremental(
+		const VoxelMesher::Input &input,
+		const uint64_t mesher_id,
+		const TransvoxelIncrementalState::Settings &settings,
+		transvoxel::Cache &cache,
+		const transvoxel::IDeepSDFSampler *deep_sdf_sampler,
+		transvoxel::MeshArrays &mesh_arrays,
+		StdVector<transvoxel::CellInfo> &cell_infos,
+		std::shared_ptr<VoxelMesher::IncrementalState> &out_state
+) {
+	ZN_PROFILE_SCOPE();
+
+	const transvoxel::SlabbedMesh *previous_mesh = nullptr;
+	unsigned int slab_begin = 0;
+	unsigned int slab_end = 0;
+
+	if (input.previous_state != nullptr && input.previous_state->mesher_id == mesher_id) {
+		const TransvoxelIncrementalState &previous_state =
+				static_cast<const TransvoxelIncrementalState &>(*input.previous_state);
+		if (previous_state.settings == settings) {
+			previous_mesh = &previous_state.mesh;
+			get_dirty_slabs(input.dirty_box, settings.voxels_size, slab_begin, slab_end);
+		}
+	}
+
+	std::shared_ptr<TransvoxelIncrementalState> state = make_shared_instance<TransvoxelIncrementalState>();
+	state->mesher_id = mesher_id;
+	state->settings = settings;
+
+	const transvoxel::DefaultTextureIndicesData default_texture_indices_data =
+			transvoxel::build_regular_mesh_in_slabs(
+					input.voxels,
+					VoxelBuffer::CHANNEL_SDF,
+					input.lod_index,
+					static_cast<transvoxel::TexturingMode>(settings.texturing_mode),
+					cache,
+					deep_sdf_sampler,
+					settings.edge_clamp_margin,
+					previous_mesh,
+					slab_begin,
+					slab_end,
+					mesh_arrays,
+					cell_infos,
+					state->mesh.ranges
+			);
+
+	// Transition meshes get appended to the arrays later, so the state needs its own copy
+	state->mesh.arrays = mesh_arrays;
+	state->mesh.cell_infos = cell_infos;
+	out_state = state;
+
+	return default_texture_indices_data;
+}
+
 } // namespace
 
 void VoxelMesherTransvoxel::build(VoxelMesher::Output &output, const VoxelMesher::Input &input) {
@@ -275,7 +450,46 @@ void VoxelMesherTransvoxel::build(VoxelMesher::Output &output, const VoxelMesher
 		cell_infos = &transvoxel::get_tls_cell_infos();
 	}
 
-	if (_deep_sampling_enabled && input.generator != nullptr && input.data != nullptr && input.lod_index > 0) {
+	const bool deep_sampling =
+			_deep_sampling_enabled && input.generator != nullptr && input.data != nullptr && input.lod_index > 0;
+
+	// Simplification changes the whole mesh, so it can't be reused partially
+	if (input.incremental_hint && _incremental_build_enabled && !_mesh_optimization_params.enabled) {
+		TransvoxelIncrementalState::Settings settings;
+		settings.voxels_size = voxels.get_size();
+		settings.lod_index = input.lod_index;
+		settings.texturing_mode = _texture_mode;
+		settings.deep_sampling = deep_sampling;
+		settings.edge_clamp_margin = _edge_clamp_margin;
+
+		const uint64_t mesher_id = get_instance_id();
+
+		if (deep_sampling) {
+			const DeepSampler ds(*input.generator, *input.data, sdf_channel, input.origin_in_voxels);
+			default_texture_indices_data = build_regular_mesh_incremental(
+					input,
+					mesher_id,
+					settings,
+					tls_cache,
+					&ds,
+					mesh_arrays,
+					transvoxel::get_tls_cell_infos(),
+					output.incremental_state
+			);
+		} else {
+			default_texture_indices_data = build_regular_mesh_incremental(
+					input,
+					mesher_id,
+					settings,
+					tls_cache,
+					nullptr,
+					mesh_arrays,
+					transvoxel::get_tls_cell_infos(),
+					output.incremental_state
+			);
+		}
+
+	} else if (deep_sampling) {
 		const DeepSampler ds(*input.generator, *input.data, sdf_channel, input.origin_in_voxels);
 		// TODO Optimization: "area scope" feature on generators to optimize certain uses of `generate_single`.
 		// The idea is to call `begin_area(box)` and `end_area()`, so the generator can optimize random calls to
@@ -356,15 +570,31 @@ void VoxelMesherTransvoxel::build(VoxelMesher::Output &output, const VoxelMesher
 	}
 
 	Array gd_arrays;
-	fill_surface_arrays(gd_arrays, *combined_mesh_arrays);
+	if (_compact_vertex_format_enabled) {
+		fill_surface_arrays_compact(gd_arrays, *combined_mesh_arrays, input.lod_index);
+	} else {
+		fill_surface_arrays(gd_arrays, *combined_mesh_arrays);
+	}
 	output.surfaces.push_back({ gd_arrays, 0 });
 
 	// const uint64_t time_spent = Time::get_singleton()->get_ticks_usec() - time_before;
 	// print_line(String("VoxelMesherTransvoxel spent {0} us").format(varray(time_spent)));
 
 	output.primitive_type = Mesh::PRIMITIVE_TRIANGLES;
-	output.mesh_flags = //
-			(RenderingServer::ARRAY_CUSTOM_RGBA_FLOAT << Mesh::ARRAY_FORMAT_CUSTOM0_SHIFT);
+
+	if (_compact_vertex_format_enabled) {
+		output.mesh_flags = //
+				(RenderingServer::ARRAY_CUSTOM_RGBA8_UNORM << Mesh::ARRAY_FORMAT_CUSTOM0_SHIFT) |
+				(RenderingServer::ARRAY_CUSTOM_RGBA8_SNORM << Mesh::ARRAY_FORMAT_CUSTOM2_SHIFT);
+#if !(GODOT_VERSION_MAJOR == 4 && GODOT_VERSION_MINOR <= 1)
+		// Positions are stored as 16-bit values relative to the bounds of the mesh, and normals are
+		// octahedral-encoded
+		output.mesh_flags |= Mesh::ARRAY_FLAG_COMPRESS_ATTRIBUTES;
+#endif
+	} else {
+		output.mesh_flags = //
+				(RenderingServer::ARRAY_CUSTOM_RGBA_FLOAT << Mesh::ARRAY_FORMAT_CUSTOM0_SHIFT);
+	}
 
 	if (_texture_mode == TEXTURES_BLEND_4_OVER_16) {
 		output.mesh_flags |= (RenderingServer::ARRAY_CUSTOM_RG_FLOAT << Mesh::ARRAY_FORMAT_CUSTOM1_SHIFT);
@@ -408,9 +638,16 @@ Ref<ArrayMesh> VoxelMesherTransvoxel::build_transition_mesh(Ref<godot::VoxelBuff
 	}
 
 	Array arrays;
-	fill_surface_arrays(arrays, s_mesh_arrays);
+	uint32_t mesh_flags = 0;
+	if (_compact_vertex_format_enabled) {
+		fill_surface_arrays_compact(arrays, s_mesh_arrays, 0);
+		mesh_flags = (RenderingServer::ARRAY_CUSTOM_RGBA8_UNORM << Mesh::ARRAY_FORMAT_CUSTOM0_SHIFT) |
+				(RenderingServer::ARRAY_CUSTOM_RGBA8_SNORM << Mesh::ARRAY_FORMAT_CUSTOM2_SHIFT);
+	} else {
+		fill_surface_arrays(arrays, s_mesh_arrays);
+	}
 	mesh.instantiate();
-	mesh->add_surface_from_arrays(Mesh::PRIMITIVE_TRIANGLES, arrays);
+	mesh->add_surface_from_arrays(Mesh::PRIMITIVE_TRIANGLES, arrays, Array(), Dictionary(), mesh_flags);
 	return mesh;
 }
 
@@ -466,7 +703,7 @@ bool VoxelMesherTransvoxel::get_transitions_enabled() const {
 }
 
 Ref<ShaderMaterial> VoxelMesherTransvoxel::get_default_lod_material() const {
-	return g_minimal_shader_material;
+	return _compact_vertex_format_enabled ? g_minimal_compact_shader_material : g_minimal_shader_material;
 }
 
 void VoxelMesherTransvoxel::set_edge_clamp_margin(float margin) {
@@ -477,6 +714,44 @@ float VoxelMesherTransvoxel::get_edge_clamp_margin() const {
 	return _edge_clamp_margin;
 }
 
+void VoxelMesherTransvoxel::set_incremental_build_enabled(bool enable) {
+	_incremental_build_enabled = enable;
+}
+
+bool VoxelMesherTransvoxel::is_incremental_build_enabled() const {
+	return _incremental_build_enabled;
+}
+
+void VoxelMesherTransvoxel::set_compact_vertex_format_enabled(bool enable) {
+	if (enable != _compact_vertex_format_enabled) {
+		_compact_vertex_format_enabled = enable;
+		// The default material depends on it
+		emit_changed();
+	}
+}
+
+bool VoxelMesherTransvoxel::is_compact_vertex_format_enabled() const {
+	return _compact_vertex_format_enabled;
+}
+
+uint64_t VoxelMesherTransvoxel::get_output_hash() const {
+	// Incremental builds are not included, they produce the same results as full builds.
+	// Changes to the algorithm itself should change this initial value.
+	uint64_t hash = hash_djb2_one_64(0x7a5f1e01);
+	hash = hash_djb2_one_64(_texture_mode, hash);
+	hash = hash_djb2_one_64(_mesh_optimization_params.enabled, hash);
+	if (_mesh_optimization_params.enabled) {
+		// Quantized, we only need to distinguish distinct settings
+		hash = hash_djb2_one_64(static_cast<int64_t>(_mesh_optimization_params.error_threshold * 100000.f), hash);
+		hash = hash_djb2_one_64(static_cast<int64_t>(_mesh_optimization_params.target_ratio * 100000.f), hash);
+	}
+	hash = hash_djb2_one_64(_deep_sampling_enabled, hash);
+	hash = hash_djb2_one_64(static_cast<int64_t>(_edge_clamp_margin * 100000.f), hash);
+	hash = hash_djb2_one_64(_transitions_enabled, hash);
+	hash = hash_djb2_one_64(_compact_vertex_format_enabled, hash);
+	return hash;
+}
+
 void VoxelMesherTransvoxel::_bind_methods() {
 	using Self = VoxelMesherTransvoxel;
 
@@ -509,6 +784,14 @@ void VoxelMesherTransvoxel::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_edge_clamp_margin"), &Self::get_edge_clamp_margin);
 	ClassDB::bind_method(D_METHOD("set_edge_clamp_margin", "margin"), &Self::set_edge_clamp_margin);
 
+	ClassDB::bind_method(D_METHOD("set_incremental_build_enabled", "enabled"), &Self::set_incremental_build_enabled);
+	ClassDB::bind_method(D_METHOD("is_incremental_build_enabled"), &Self::is_incremental_build_enabled);
+
+	ClassDB::bind_method(
+			D_METHOD("set_compact_vertex_format_enabled", "enabled"), &Self::set_compact_vertex_format_enabled
+	);
+	ClassDB::bind_method(D_METHOD("is_compact_vertex_format_enabled"), &Self::is_compact_vertex_format_enabled);
+
 	ADD_PROPERTY(
 			PropertyInfo(Variant::INT, "texturing_mode", PROPERTY_HINT_ENUM, "None,4-blend over 16 textures (4 bits)"),
 			"set_texturing_mode",
@@ -545,6 +828,16 @@ void VoxelMesherTransvoxel::_bind_methods() {
 	);
 
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "edge_clamp_margin"), "set_edge_clamp_margin", "get_edge_clamp_margin");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "incremental_build_enabled"),
+			"set_incremental_build_enabled",
+			"is_incremental_build_enabled"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "compact_vertex_format_enabled"),
+			"set_compact_vertex_format_enabled",
+			"is_compact_vertex_format_enabled"
+	);
 
 	BIND_ENUM_CONSTANT(TEXTURES_NONE);
 	// TODO Rename MIXEL
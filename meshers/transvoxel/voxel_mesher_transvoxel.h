@@ -54,6 +54,14 @@ public:
 	void set_edge_clamp_margin(float margin);
 	float get_edge_clamp_margin() const;
 
+	void set_incremental_build_enabled(bool enable);
+	bool is_incremental_build_enabled() const override;
+
+	void set_compact_vertex_format_enabled(bool enable);
+	bool is_compact_vertex_format_enabled() const;
+
+	uint64_t get_output_hash() const override;
+
 	Ref<ShaderMaterial> get_default_lod_material() const override;
 
 	// Internal
@@ -103,6 +111,14 @@ private:
 	float _edge_clamp_margin = 0.02f;
 
 	bool _transitions_enabled = true;
+
+	// If enabled, the regular mesh is built in slabs, which are kept after each build so the next build of the same
+	// block only has to polygonize slabs touched by edits. Costs extra memory per block.
+	bool _incremental_build_enabled = false;
+
+	// If enabled, LOD data is packed in 8-bit attributes instead of floats, and Godot is asked to compress positions
+	// and normals when uploading meshes. Shaders must then use the compact variant of the transvoxel snippet.
+	bool _compact_vertex_format_enabled = false;
 };
 
 } // namespace zylann::voxel
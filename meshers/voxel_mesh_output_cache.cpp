@@ -0,0 +1,909 @@
+#include "voxel_mesh_output_cache.h"
+#include "../streams/compressed_data.h"
+#include "../thirdparty/meshoptimizer/meshoptimizer.h"
+#include "../util/godot/classes/file_access.h"
+#include "../util/godot/file_utils.h"
+#include "../util/io/log.h"
+#include "../util/io/serialization.h"
+#include "../util/math/conv.h"
+#include "../util/math/funcs.h"
+#include "../util/memory/memory.h"
+#include "../util/profiling.h"
+#include "../util/string/format.h"
+
+#include <cstring>
+
+namespace zylann::voxel {
+
+namespace {
+
+const char *FILE_EXTENSION = "vxmc";
+const uint8_t REGION_FORMAT_VERSION = 0;
+const uint8_t OUTPUT_FORMAT_VERSION = 0;
+// Magic, version, region size, size of `real_t` and one reserved byte
+const unsigned int REGION_HEADER_PREFIX_SIZE = 8;
+// Offset and size of each block
+const unsigned int REGION_HEADER_ENTRY_SIZE = 8;
+
+enum StreamEncoding : uint8_t {
+	STREAM_RAW = 0,
+	STREAM_MESHOPT_VERTICES,
+	STREAM_MESHOPT_INDICES
+};
+
+StdVector<uint8_t> &get_tls_data() {
+	static thread_local StdVector<uint8_t> tls_data;
+	return tls_data;
+}
+
+StdVector<uint8_t> &get_tls_compressed_data() {
+	static thread_local StdVector<uint8_t> tls_data;
+	return tls_data;
+}
+
+StdVector<uint8_t> &get_tls_encoded_data() {
+	static thread_local StdVector<uint8_t> tls_data;
+	return tls_data;
+}
+
+inline bool can_read(const MemoryReader &r, size_t size) {
+	return r.pos + size <= r.data.size();
+}
+
+template <typename TPackedArray>
+Span<const uint8_t> get_bytes(const TPackedArray &a) {
+	if (a.size() == 0) {
+		return Span<const uint8_t>();
+	}
+	return Span<const uint8_t>(reinterpret_cast<const uint8_t *>(a.ptr()), a.size() * sizeof(a[0]));
+}
+
+template <typename TPackedArray>
+bool set_bytes(TPackedArray &a, Span<const uint8_t> bytes) {
+	const size_t element_size = sizeof(a[0]);
+	if (bytes.size() % element_size != 0) {
+		return false;
+	}
+	a.resize(bytes.size() / element_size);
+	if (bytes.size() > 0) {
+		memcpy(reinterpret_cast<uint8_t *>(a.ptrw()), bytes.data(), bytes.size());
+	}
+	return true;
+}
+
+// Vertex streams are encoded with meshoptimizer when their element size allows it. It works best when elements are
+// vertices, so arrays holding several values per vertex are grouped accordingly.
+void write_vertex_stream(MemoryWriter &w, Span<const uint8_t> bytes, unsigned int element_size) {
+	ZN_ASSERT(element_size > 0 && bytes.size() % element_size == 0);
+	const unsigned int element_count = bytes.size() / element_size;
+	w.store_32(element_count);
+	w.store_16(element_size);
+	if (element_count == 0) {
+		return;
+	}
+	if (element_size % 4 == 0 && element_size <= 256) {
+		StdVector<uint8_t> &encoded = get_tls_encoded_data();
+		encoded.resize(zylannmeshopt::meshopt_encodeVertexBufferBound(element_count, element_size));
+		const size_t encoded_size = zylannmeshopt::meshopt_encodeVertexBuffer(
+				encoded.data(), encoded.size(), bytes.data(), element_count, element_size
+		);
+		w.store_8(STREAM_MESHOPT_VERTICES);
+		w.store_32(encoded_size);
+		w.store_buffer(Span<const uint8_t>(encoded.data(), encoded_size));
+	} else {
+		w.store_8(STREAM_RAW);
+		w.store_buffer(bytes);
+	}
+}
+
+bool read_vertex_stream(MemoryReader &r, StdVector<uint8_t> &out_bytes, unsigned int &out_element_size) {
+	if (!can_read(r, 6)) {
+		return false;
+	}
+	const unsigned int element_count = r.get_32();
+	out_element_size = r.get_16();
+	if (out_element_size == 0) {
+		return false;
+	}
+	const size_t size = size_t(element_count) * out_element_size;
+	out_bytes.resize(size);
+	if (element_count == 0) {
+		return true;
+	}
+	if (!can_read(r, 1)) {
+		return false;
+	}
+	const uint8_t encoding = r.get_8();
+	switch (encoding) {
+		case STREAM_RAW:
+			if (!can_read(r, size)) {
+				return false;
+			}
+			r.get_buffer(to_span(out_bytes));
+			return true;
+
+		case STREAM_MESHOPT_VERTICES: {
+			if (!can_read(r, 4)) {
+				return false;
+			}
+			const uint32_t encoded_size = r.get_32();
+			if (!can_read(r, encoded_size)) {
+				return false;
+			}
+			const int res = zylannmeshopt::meshopt_decodeVertexBuffer(
+					out_bytes.data(), element_count, out_element_size, &r.data[r.pos], encoded_size
+			);
+			r.pos += encoded_size;
+			return res == 0;
+		}
+
+		default:
+			return false;
+	}
+}
+
+void write_positions(MemoryWriter &w, const PackedVector3Array &positions) {
+	const Span<const Vector3> src(positions.ptr(), positions.size());
+
+	Vector3f min_pos;
+	Vector3f max_pos;
+	if (src.size() > 0) {
+		min_pos = to_vec3f(src[0]);
+		max_pos = min_pos;
+		for (const Vector3 p : src) {
+			min_pos = math::min(min_pos, to_vec3f(p));
+			max_pos = math::max(max_pos, to_vec3f(p));
+		}
+	}
+	const Vector3f extent = max_pos - min_pos;
+
+	w.store_float(min_pos.x);
+	w.store_float(min_pos.y);
+	w.store_float(min_pos.z);
+	w.store_float(extent.x);
+	w.store_float(extent.y);
+	w.store_float(extent.z);
+
+	const Vector3f scale(
+			extent.x > 0.f ? 65535.f / extent.x : 0.f,
+			extent.y > 0.f ? 65535.f / extent.y : 0.f,
+			extent.z > 0.f ? 65535.f / extent.z : 0.f
+	);
+
+	// Padded to 4 components, as meshoptimizer requires vertex sizes to be multiples of 4
+	StdVector<uint8_t> &data = get_tls_data();
+	data.resize(src.size() * 4 * sizeof(uint16_t));
+	uint16_t *quantized = reinterpret_cast<uint16_t *>(data.data());
+	for (const Vector3 p : src) {
+		const Vector3f q = (to_vec3f(p) - min_pos) * scale;
+		quantized[0] = math::clamp(int(Math::round(q.x)), 0, 65535);
+		quantized[1] = math::clamp(int(Math::round(q.y)), 0, 65535);
+		quantized[2] = math::clamp(int(Math::round(q.z)), 0, 65535);
+		quantized[3] = 0;
+		quantized += 4;
+	}
+
+	write_vertex_stream(w, to_span_const(data), 4 * sizeof(uint16_t));
+}
+
+bool read_positions(MemoryReader &r, PackedVector3Array &out_positions) {
+	if (!can_read(r, 6 * sizeof(float))) {
+		return false;
+	}
+	Vector3f min_pos;
+	min_pos.x = r.get_float();
+	min_pos.y = r.get_float();
+	min_pos.z = r.get_float();
+	Vector3f extent;
+	extent.x = r.get_float();
+	extent.y = r.get_float();
+	extent.z = r.get_float();
+	const Vector3f scale = extent / 65535.f;
+
+	StdVector<uint8_t> &data = get_tls_data();
+	unsigned int element_size;
+	if (!read_vertex_stream(r, data, element_size) || element_size != 4 * sizeof(uint16_t)) {
+		return false;
+	}
+
+	const unsigned int count = data.size() / element_size;
+	out_positions.resize(count);
+	Vector3 *dst = out_positions.ptrw();
+	const uint16_t *quantized = reinterpret_cast<const uint16_t *>(data.data());
+	for (unsigned int i = 0; i < count; ++i) {
+		const Vector3f p = min_pos + Vector3f(quantized[0], quantized[1], quantized[2]) * scale;
+		dst[i] = to_vec3(p);
+		quantized += 4;
+	}
+	return true;
+}
+
+void write_normals(MemoryWriter &w, const PackedVector3Array &normals) {
+	StdVector<uint8_t> &data = get_tls_data();
+	data.resize(normals.size() * 4 * sizeof(int16_t));
+	int16_t *quantized = reinterpret_cast<int16_t *>(data.data());
+	for (const Vector3 n : Span<const Vector3>(normals.ptr(), normals.size())) {
+		quantized[0] = math::clamp(int(Math::round(n.x * 32767.f)), -32767, 32767);
+		quantized[1] = math::clamp(int(Math::round(n.y * 32767.f)), -32767, 32767);
+		quantized[2] = math::clamp(int(Math::round(n.z * 32767.f)), -32767, 32767);
+		quantized[3] = 0;
+		quantized += 4;
+	}
+	write_vertex_stream(w, to_span_const(data), 4 * sizeof(int16_t));
+}
+
+bool read_normals(MemoryReader &r, PackedVector3Array &out_normals) {
+	StdVector<uint8_t> &data = get_tls_data();
+	unsigned int element_size;
+	if (!read_vertex_stream(r, data, element_size) || element_size != 4 * sizeof(int16_t)) {
+		return false;
+	}
+
+	const unsigned int count = data.size() / element_size;
+	out_normals.resize(count);
+	Vector3 *dst = out_normals.ptrw();
+	const int16_t *quantized = reinterpret_cast<const int16_t *>(data.data());
+	for (unsigned int i = 0; i < count; ++i) {
+		const Vector3 n(quantized[0], quantized[1], quantized[2]);
+		const real_t len = n.length();
+		dst[i] = len > 0 ? n / len : n;
+		quantized += 4;
+	}
+	return true;
+}
+
+void write_indices(MemoryWriter &w, const PackedInt32Array &indices, unsigned int vertex_count, bool triangles) {
+	bool valid = triangles && indices.size() % 3 == 0;
+	if (valid) {
+		for (const int32_t i : Span<const int32_t>(indices.ptr(), indices.size())) {
+			if (i < 0 || i >= int32_t(vertex_count)) {
+				valid = false;
+				break;
+			}
+		}
+	}
+	if (!valid) {
+		w.store_8(STREAM_RAW);
+		write_vertex_stream(w, get_bytes(indices), sizeof(int32_t));
+		return;
+	}
+
+	StdVector<uint8_t> &encoded = get_tls_encoded_data();
+	encoded.resize(zylannmeshopt::meshopt_encodeIndexBufferBound(indices.size(), vertex_count));
+	const size_t encoded_size = zylannmeshopt::meshopt_encodeIndexBuffer(
+			encoded.data(),
+			encoded.size(),
+			reinterpret_cast<const unsigned int *>(indices.ptr()),
+			indices.size()
+	);
+	w.store_8(STREAM_MESHOPT_INDICES);
+	w.store_32(indices.size());
+	w.store_32(encoded_size);
+	w.store_buffer(Span<const uint8_t>(encoded.data(), encoded_size));
+}
+
+bool read_indices(MemoryReader &r, PackedInt32Array &out_indices, unsigned int vertex_count) {
+	if (!can_read(r, 1)) {
+		return false;
+	}
+	const uint8_t encoding = r.get_8();
+
+	if (encoding == STREAM_RAW) {
+		StdVector<uint8_t> &data = get_tls_data();
+		unsigned int element_size;
+		if (!read_vertex_stream(r, data, element_size) || element_size != sizeof(int32_t)) {
+			return false;
+		}
+		return set_bytes(out_indices, to_span_const(data));
+	}
+
+	if (encoding != STREAM_MESHOPT_INDICES || !can_read(r, 8)) {
+		return false;
+	}
+	const uint32_t count = r.get_32();
+	const uint32_t encoded_size = r.get_32();
+	if (!can_read(r, encoded_size) || count % 3 != 0) {
+		return false;
+	}
+	out_indices.resize(count);
+	const int res = zylannmeshopt::meshopt_decodeIndexBuffer(
+			out_indices.ptrw(), count, sizeof(int32_t), &r.data[r.pos], encoded_size
+	);
+	r.pos += encoded_size;
+	if (res != 0) {
+		return false;
+	}
+	// Corrupted data can decode into garbage, which must not reach the renderer
+	for (const int32_t i : Span<const int32_t>(out_indices.ptr(), out_indices.size())) {
+		if (i < 0 || i >= int32_t(vertex_count)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Writes a generic packed array. Returns false if its type is not supported.
+bool write_array(MemoryWriter &w, const Variant &v, unsigned int vertex_count) {
+	Span<const uint8_t> bytes;
+	size_t base_element_size;
+
+	switch (v.get_type()) {
+		case Variant::PACKED_BYTE_ARRAY: {
+			const PackedByteArray a = v;
+			bytes = get_bytes(a);
+			base_element_size = 1;
+		} break;
+		case Variant::PACKED_INT32_ARRAY: {
+			const PackedInt32Array a = v;
+			bytes = get_bytes(a);
+			base_element_size = sizeof(int32_t);
+		} break;
+		case Variant::PACKED_FLOAT32_ARRAY: {
+			const PackedFloat32Array a = v;
+			bytes = get_bytes(a);
+			base_element_size = sizeof(float);
+		} break;
+		case Variant::PACKED_VECTOR2_ARRAY: {
+			const PackedVector2Array a = v;
+			bytes = get_bytes(a);
+			base_element_size = sizeof(Vector2);
+		} break;
+		case Variant::PACKED_VECTOR3_ARRAY: {
+			const PackedVector3Array a = v;
+			bytes = get_bytes(a);
+			base_element_size = sizeof(Vector3);
+		} break;
+		case Variant::PACKED_COLOR_ARRAY: {
+			const PackedColorArray a = v;
+			bytes = get_bytes(a);
+			base_element_size = sizeof(Color);
+		} break;
+		default:
+			return false;
+	}
+
+	// Note, the packed arrays are still referenced by the Variant so `bytes` remains valid
+	size_t element_size = base_element_size;
+	if (vertex_count > 0 && bytes.size() % vertex_count == 0 && bytes.size() > 0) {
+		element_size = bytes.size() / vertex_count;
+		if (element_size % base_element_size != 0 || element_size > 0xffff) {
+			element_size = base_element_size;
+		}
+	}
+
+	w.store_8(v.get_type());
+	write_vertex_stream(w, bytes, element_size);
+	return true;
+}
+
+bool read_array(MemoryReader &r, Variant &out_v) {
+	if (!can_read(r, 1)) {
+		return false;
+	}
+	const uint8_t type = r.get_8();
+
+	StdVector<uint8_t> &data = get_tls_data();
+	unsigned int element_size;
+	if (!read_vertex_stream(r, data, element_size)) {
+		return false;
+	}
+	const Span<const uint8_t> bytes = to_span_const(data);
+
+	switch (type) {
+		case Variant::PACKED_BYTE_ARRAY: {
+			PackedByteArray a;
+			ZN_ASSERT_RETURN_V(set_bytes(a, bytes), false);
+			out_v = a;
+		} break;
+		case Variant::PACKED_INT32_ARRAY: {
+			PackedInt32Array a;
+			ZN_ASSERT_RETURN_V(set_bytes(a, bytes), false);
+			out_v = a;
+		} break;
+		case Variant::PACKED_FLOAT32_ARRAY: {
+			PackedFloat32Array a;
+			ZN_ASSERT_RETURN_V(set_bytes(a, bytes), false);
+			out_v = a;
+		} break;
+		case Variant::PACKED_VECTOR2_ARRAY: {
+			PackedVector2Array a;
+			ZN_ASSERT_RETURN_V(set_bytes(a, bytes), false);
+			out_v = a;
+		} break;
+		case Variant::PACKED_VECTOR3_ARRAY: {
+			PackedVector3Array a;
+			ZN_ASSERT_RETURN_V(set_bytes(a, bytes), false);
+			out_v = a;
+		} break;
+		case Variant::PACKED_COLOR_ARRAY: {
+			PackedColorArray a;
+			ZN_ASSERT_RETURN_V(set_bytes(a, bytes), false);
+			out_v = a;
+		} break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+bool write_surface(MemoryWriter &w, const VoxelMesher::Output::Surface &surface, bool triangles) {
+	w.store_16(surface.material_index);
+
+	const Array &arrays = surface.arrays;
+	if (arrays.size() == 0) {
+		w.store_32(0);
+		return true;
+	}
+	ZN_ASSERT_RETURN_V(arrays.size() == Mesh::ARRAY_MAX, false);
+
+	uint32_t mask = 0;
+	for (int i = 0; i < arrays.size(); ++i) {
+		if (arrays[i].get_type() != Variant::NIL) {
+			mask |= (1 << i);
+		}
+	}
+	w.store_32(mask);
+
+	unsigned int vertex_count = 0;
+
+	for (int i = 0; i < arrays.size(); ++i) {
+		const Variant v = arrays[i];
+		if (v.get_type() == Variant::NIL) {
+			continue;
+		}
+
+		if (i == Mesh::ARRAY_VERTEX) {
+			if (v.get_type() != Variant::PACKED_VECTOR3_ARRAY) {
+				return false;
+			}
+			const PackedVector3Array positions = v;
+			vertex_count = positions.size();
+			write_positions(w, positions);
+
+		} else if (i == Mesh::ARRAY_NORMAL) {
+			if (v.get_type() != Variant::PACKED_VECTOR3_ARRAY) {
+				return false;
+			}
+			write_normals(w, v);
+
+		} else if (i == Mesh::ARRAY_INDEX) {
+			if (v.get_type() != Variant::PACKED_INT32_ARRAY) {
+				return false;
+			}
+			write_indices(w, v, vertex_count, triangles);
+
+		} else if (!write_array(w, v, vertex_count)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool read_surface(MemoryReader &r, VoxelMesher::Output::Surface &out_surface) {
+	if (!can_read(r, 6)) {
+		return false;
+	}
+	out_surface.material_index = r.get_16();
+
+	const uint32_t mask = r.get_32();
+	if (mask == 0) {
+		out_surface.arrays = Array();
+		return true;
+	}
+	if (mask >= (1 << Mesh::ARRAY_MAX)) {
+		return false;
+	}
+
+	Array arrays;
+	arrays.resize(Mesh::ARRAY_MAX);
+	unsigned int vertex_count = 0;
+
+	for (int i = 0; i < arrays.size(); ++i) {
+		if ((mask & (1 << i)) == 0) {
+			continue;
+		}
+
+		if (i == Mesh::ARRAY_VERTEX) {
+			PackedVector3Array positions;
+			if (!read_positions(r, positions)) {
+				return false;
+			}
+			vertex_count = positions.size();
+			arrays[i] = positions;
+
+		} else if (i == Mesh::ARRAY_NORMAL) {
+			PackedVector3Array normals;
+			if (!read_normals(r, normals)) {
+				return false;
+			}
+			arrays[i] = normals;
+
+		} else if (i == Mesh::ARRAY_INDEX) {
+			PackedInt32Array indices;
+			if (!read_indices(r, indices, vertex_count)) {
+				return false;
+			}
+			arrays[i] = indices;
+
+		} else {
+			Variant v;
+			if (!read_array(r, v)) {
+				return false;
+			}
+			arrays[i] = v;
+		}
+	}
+
+	out_surface.arrays = arrays;
+	return true;
+}
+
+bool write_surfaces(MemoryWriter &w, const StdVector<VoxelMesher::Output::Surface> &surfaces, bool triangles) {
+	w.store_16(surfaces.size());
+	for (const VoxelMesher::Output::Surface &surface : surfaces) {
+		if (!write_surface(w, surface, triangles)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool read_surfaces(MemoryReader &r, StdVector<VoxelMesher::Output::Surface> &out_surfaces) {
+	if (!can_read(r, 2)) {
+		return false;
+	}
+	out_surfaces.resize(r.get_16());
+	for (VoxelMesher::Output::Surface &surface : out_surfaces) {
+		if (!read_surface(r, surface)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+VoxelMeshOutputCache::~VoxelMeshOutputCache() {
+	clear();
+}
+
+void VoxelMeshOutputCache::configure(String directory, unsigned int begin_lod_index) {
+	clear();
+
+	_directory = "";
+	_begin_lod_index = begin_lod_index;
+
+	if (directory.is_empty()) {
+		return;
+	}
+
+	const Error err = zylann::godot::check_directory_created(directory);
+	if (err != OK) {
+		ZN_PRINT_ERROR(format(
+				"Could not create mesh cache directory {}, meshes won't be cached",
+				zylann::godot::to_std_string(directory)
+		));
+		return;
+	}
+
+	_directory = directory;
+}
+
+bool VoxelMeshOutputCache::load(const Key &key, VoxelMesher::Output &out_output) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(is_enabled(), false);
+
+	unsigned int block_index;
+	const RegionKey region_key = get_region_key(key, block_index);
+	std::shared_ptr<Region> region = get_or_load_region(region_key);
+
+	BlockLocation location;
+	{
+		MutexLock mlock(region->mutex);
+		location = region->blocks[block_index];
+	}
+
+	if (location.offset == 0) {
+		++_miss_count;
+		return false;
+	}
+
+	StdVector<uint8_t> &compressed_data = get_tls_compressed_data();
+	compressed_data.resize(location.size);
+	{
+		Error err;
+		Ref<FileAccess> f = zylann::godot::open_file(region->file_path, FileAccess::READ, err);
+		if (f.is_null()) {
+			ZN_PRINT_VERBOSE(
+					format("Could not open mesh cache file {}", zylann::godot::to_std_string(region->file_path))
+			);
+			++_miss_count;
+			return false;
+		}
+		f->seek(location.offset);
+		if (zylann::godot::get_buffer(**f, to_span(compressed_data)) != compressed_data.size()) {
+			ZN_PRINT_VERBOSE(format("Could not read cached mesh block {} lod {}", key.position, int(key.lod_index)));
+			++_miss_count;
+			return false;
+		}
+	}
+
+	StdVector<uint8_t> &data = get_tls_data();
+	if (!CompressedData::decompress(to_span_const(compressed_data), data)) {
+		ZN_PRINT_ERROR("Failed to decompress cached mesh block");
+		++_miss_count;
+		return false;
+	}
+
+	// `deserialize` uses the same thread-local buffer as `data`, so a copy is needed
+	const StdVector<uint8_t> serialized_data = std::move(data);
+	if (!deserialize(to_span_const(serialized_data), out_output)) {
+		ZN_PRINT_ERROR(format("Failed to deserialize cached mesh block {} lod {}", key.position, int(key.lod_index)));
+		++_miss_count;
+		return false;
+	}
+
+	++_hit_count;
+	return true;
+}
+
+void VoxelMeshOutputCache::store(const Key &key, const VoxelMesher::Output &output) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(is_enabled());
+
+	// `serialize` uses the thread-local data buffer internally
+	StdVector<uint8_t> serialized_data;
+	if (!serialize(output, serialized_data)) {
+		return;
+	}
+
+	StdVector<uint8_t> &compressed_data = get_tls_compressed_data();
+	ZN_ASSERT_RETURN(
+			CompressedData::compress(to_span_const(serialized_data), compressed_data, CompressedData::COMPRESSION_LZ4)
+	);
+
+	unsigned int block_index;
+	const RegionKey region_key = get_region_key(key, block_index);
+	std::shared_ptr<Region> region = get_or_load_region(region_key);
+
+	MutexLock mlock(region->mutex);
+
+	Error err;
+	Ref<FileAccess> f;
+
+	if (region->file_exists) {
+		f = zylann::godot::open_file(region->file_path, FileAccess::READ_WRITE, err);
+	} else {
+		err = zylann::godot::check_directory_created(region->file_path.get_base_dir());
+		if (err != OK) {
+			ZN_PRINT_ERROR(format(
+					"Could not create mesh cache directory {}",
+					zylann::godot::to_std_string(region->file_path.get_base_dir())
+			));
+			return;
+		}
+
+		f = zylann::godot::open_file(region->file_path, FileAccess::WRITE, err);
+
+		if (f.is_valid()) {
+			const uint8_t prefix[REGION_HEADER_PREFIX_SIZE] = {
+				'V', 'X', 'M', 'C', REGION_FORMAT_VERSION, REGION_SIZE_PO2, sizeof(real_t), 0
+			};
+			zylann::godot::store_buffer(**f, Span<const uint8_t>(prefix, REGION_HEADER_PREFIX_SIZE));
+			for (unsigned int i = 0; i < REGION_VOLUME; ++i) {
+				f->store_32(0);
+				f->store_32(0);
+			}
+			fill(region->blocks, BlockLocation());
+			region->file_exists = true;
+		}
+	}
+
+	if (f.is_null()) {
+		ZN_PRINT_ERROR(format(
+				"Could not open mesh cache file {}, error {}", zylann::godot::to_std_string(region->file_path), int(err)
+		));
+		return;
+	}
+
+	f->seek_end();
+	const uint64_t offset = f->get_position();
+	if (offset + compressed_data.size() > 0xffffffff) {
+		ZN_PRINT_VERBOSE(format("Mesh cache file {} is full", zylann::godot::to_std_string(region->file_path)));
+		return;
+	}
+	zylann::godot::store_buffer(**f, to_span_const(compressed_data));
+
+	// Data is written before the header entry pointing to it, so an interrupted write leaves the file valid
+	BlockLocation location;
+	location.offset = offset;
+	location.size = compressed_data.size();
+	f->seek(REGION_HEADER_PREFIX_SIZE + block_index * REGION_HEADER_ENTRY_SIZE);
+	f->store_32(location.offset);
+	f->store_32(location.size);
+
+	// Close the file before readers can see the new block
+	f.unref();
+	region->blocks[block_index] = location;
+
+	++_store_count;
+}
+
+void VoxelMeshOutputCache::clear() {
+	MutexLock mlock(_regions_mutex);
+	_regions.clear();
+}
+
+VoxelMeshOutputCache::Stats VoxelMeshOutputCache::get_stats() const {
+	Stats stats;
+	stats.hit_count = _hit_count;
+	stats.miss_count = _miss_count;
+	stats.store_count = _store_count;
+	{
+		MutexLock mlock(_regions_mutex);
+		stats.open_region_count = _regions.size();
+	}
+	return stats;
+}
+
+VoxelMeshOutputCache::RegionKey VoxelMeshOutputCache::get_region_key(const Key &key, unsigned int &out_block_index) {
+	const Vector3i region_position(
+			key.position.x >> REGION_SIZE_PO2, key.position.y >> REGION_SIZE_PO2, key.position.z >> REGION_SIZE_PO2
+	);
+	const Vector3i rpos = key.position - (region_position << REGION_SIZE_PO2);
+	out_block_index = Vector3iUtil::get_zxy_index(rpos, Vector3iUtil::create(REGION_SIZE));
+	return RegionKey{ key.generator_hash, key.mesher_hash, region_position, key.lod_index, key.block_size_po2 };
+}
+
+std::shared_ptr<VoxelMeshOutputCache::Region> VoxelMeshOutputCache::get_or_load_region(const RegionKey &key) {
+	std::shared_ptr<Region> region;
+	{
+		MutexLock mlock(_regions_mutex);
+		auto it = _regions.find(key);
+		if (it != _regions.end()) {
+			return it->second;
+		}
+		region = make_shared_instance<Region>();
+		region->file_path = get_region_file_path(key);
+		_regions.insert({ key, region });
+		// Lock the region before other threads can find it, so they wait until its header is loaded
+		region->mutex.lock();
+	}
+
+	Error err;
+	Ref<FileAccess> f = zylann::godot::open_file(region->file_path, FileAccess::READ, err);
+
+	if (f.is_valid()) {
+		FixedArray<uint8_t, REGION_HEADER_PREFIX_SIZE + REGION_VOLUME * REGION_HEADER_ENTRY_SIZE> header;
+		if (zylann::godot::get_buffer(**f, to_span(header)) == header.size() && header[0] == 'V' &&
+			header[1] == 'X' && header[2] == 'M' && header[3] == 'C' && header[4] == REGION_FORMAT_VERSION &&
+			header[5] == REGION_SIZE_PO2 && header[6] == sizeof(real_t)) {
+			//
+			MemoryReader r(to_span(header), ENDIANNESS_LITTLE_ENDIAN);
+			r.pos = REGION_HEADER_PREFIX_SIZE;
+			for (BlockLocation &location : region->blocks) {
+				location.offset = r.get_32();
+				location.size = r.get_32();
+			}
+			region->file_exists = true;
+
+		} else {
+			// The file will be overwritten
+			ZN_PRINT_VERBOSE(format(
+					"Mesh cache file {} is invalid or has a different format",
+					zylann::godot::to_std_string(region->file_path)
+			));
+		}
+	}
+
+	region->mutex.unlock();
+	return region;
+}
+
+String VoxelMeshOutputCache::get_region_file_path(const RegionKey &key) const {
+	const String dir_name = String::num_uint64(key.generator_hash, 16) + "_" +
+			String::num_uint64(key.mesher_hash, 16) + "_" + String::num_int64(key.block_size_po2);
+	const String file_name = String::num_int64(key.lod_index) + "_" + String::num_int64(key.position.x) + "_" +
+			String::num_int64(key.position.y) + "_" + String::num_int64(key.position.z) + "." + FILE_EXTENSION;
+	return _directory.path_join(dir_name).path_join(file_name);
+}
+
+bool VoxelMeshOutputCache::serialize(const VoxelMesher::Output &output, StdVector<uint8_t> &dst) {
+	ZN_PROFILE_SCOPE();
+
+	if (output.atlas_image.is_valid()) {
+		// Not supported
+		return false;
+	}
+
+	dst.clear();
+	MemoryWriter w(dst, ENDIANNESS_LITTLE_ENDIAN);
+
+	w.store_8(OUTPUT_FORMAT_VERSION);
+	w.store_8(sizeof(real_t));
+	w.store_8(output.primitive_type);
+	w.store_32(output.mesh_flags);
+
+	const bool triangles = output.primitive_type == Mesh::PRIMITIVE_TRIANGLES;
+
+	if (!write_surfaces(w, output.surfaces, triangles)) {
+		return false;
+	}
+	for (const StdVector<VoxelMesher::Output::Surface> &surfaces : output.transition_surfaces) {
+		if (!write_surfaces(w, surfaces, triangles)) {
+			return false;
+		}
+	}
+
+	const VoxelMesher::Output::CollisionSurface &cs = output.collision_surface;
+	w.store_32(cs.submesh_vertex_end);
+	w.store_32(cs.submesh_index_end);
+	write_vertex_stream(w, Span<const uint8_t>(reinterpret_cast<const uint8_t *>(cs.positions.data()),
+											   cs.positions.size() * sizeof(Vector3f)), sizeof(Vector3f));
+	write_vertex_stream(w, Span<const uint8_t>(reinterpret_cast<const uint8_t *>(cs.indices.data()),
+											   cs.indices.size() * sizeof(int)), sizeof(int));
+
+	return true;
+}
+
+bool VoxelMeshOutputCache::deserialize(Span<const uint8_t> src, VoxelMesher::Output &out_output) {
+	ZN_PROFILE_SCOPE();
+
+	MemoryReader r(src, ENDIANNESS_LITTLE_ENDIAN);
+
+	if (!can_read(r, 7)) {
+		return false;
+	}
+	if (r.get_8() != OUTPUT_FORMAT_VERSION || r.get_8() != sizeof(real_t)) {
+		return false;
+	}
+	const uint8_t primitive_type = r.get_8();
+	if (primitive_type >= Mesh::PRIMITIVE_MAX) {
+		return false;
+	}
+	out_output.primitive_type = static_cast<Mesh::PrimitiveType>(primitive_type);
+	out_output.mesh_flags = r.get_32();
+
+	if (!read_surfaces(r, out_output.surfaces)) {
+		return false;
+	}
+	for (StdVector<VoxelMesher::Output::Surface> &surfaces : out_output.transition_surfaces) {
+		if (!read_surfaces(r, surfaces)) {
+			return false;
+		}
+	}
+
+	VoxelMesher::Output::CollisionSurface &cs = out_output.collision_surface;
+	if (!can_read(r, 8)) {
+		return false;
+	}
+	cs.submesh_vertex_end = r.get_32();
+	cs.submesh_index_end = r.get_32();
+
+	StdVector<uint8_t> &data = get_tls_data();
+	unsigned int element_size;
+
+	if (!read_vertex_stream(r, data, element_size) || element_size != sizeof(Vector3f)) {
+		return false;
+	}
+	cs.positions.resize(data.size() / sizeof(Vector3f));
+	if (data.size() > 0) {
+		memcpy(cs.positions.data(), data.data(), data.size());
+	}
+
+	if (!read_vertex_stream(r, data, element_size) || element_size != sizeof(int)) {
+		return false;
+	}
+	cs.indices.resize(data.size() / sizeof(int));
+	if (data.size() > 0) {
+		memcpy(cs.indices.data(), data.data(), data.size());
+	}
+
+	out_output.atlas_image.unref();
+	out_output.incremental_state.reset();
+
+	return true;
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,138 @@
+#ifndef VOXEL_MESH_OUTPUT_CACHE_H
+#define VOXEL_MESH_OUTPUT_CACHE_H
+
+#include "../util/containers/fixed_array.h"
+#include "../util/containers/span.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/containers/std_vector.h"
+#include "../util/godot/core/string.h"
+#include "../util/math/vector3i.h"
+#include "../util/thread/mutex.h"
+#include "voxel_mesher.h"
+
+#include <atomic>
+#include <memory>
+
+namespace zylann::voxel {
+
+// Persistent cache of meshes built from voxels that were not edited, so far-away terrain doesn't have to be generated
+// and meshed again every time it comes back into view, or every time the game starts. Blocks are identified by the
+// output hashes of their generator and mesher (see `VoxelGenerator::get_output_hash` and
+// `VoxelMesher::get_output_hash`), so when either is modified, old entries are no longer hit.
+//
+// Meshes are stored in region files, each containing a fixed grid of blocks of the same LOD, in a subdirectory
+// specific to the generator and mesher. Vertex positions and normals are quantized to 16 bits, vertex and index
+// buffers are encoded with meshoptimizer, and the result is compressed with LZ4.
+//
+// Files are only appended to. Storing a block again (which only happens after it failed to load) leaves its previous
+// data unused in the file. Clearing the cache means removing its directory.
+//
+// Thread-safe.
+class VoxelMeshOutputCache {
+public:
+	struct Key {
+		uint64_t generator_hash;
+		uint64_t mesher_hash;
+		// In mesh blocks
+		Vector3i position;
+		uint8_t lod_index;
+		uint8_t block_size_po2;
+	};
+
+	struct Stats {
+		uint64_t hit_count = 0;
+		uint64_t miss_count = 0;
+		uint64_t store_count = 0;
+		unsigned int open_region_count = 0;
+	};
+
+	~VoxelMeshOutputCache();
+
+	// Not thread-safe, should be called before the cache gets used.
+	// An empty directory disables the cache. Only blocks of LOD index `begin_lod_index` and higher will be cached.
+	void configure(String directory, unsigned int begin_lod_index);
+
+	inline bool is_enabled() const {
+		return !_directory.is_empty();
+	}
+
+	inline unsigned int get_begin_lod_index() const {
+		return _begin_lod_index;
+	}
+
+	// Gets a mesh from the cache. Returns false if it wasn't found.
+	bool load(const Key &key, VoxelMesher::Output &out_output);
+	// Stores a mesh in the cache. Outputs using features the cache doesn't support are ignored.
+	void store(const Key &key, const VoxelMesher::Output &output);
+
+	// Forgets about regions loaded so far. Doesn't remove files.
+	void clear();
+
+	Stats get_stats() const;
+
+	// Exposed for testing.
+	// Returns false if the output uses features that cannot be serialized.
+	static bool serialize(const VoxelMesher::Output &output, StdVector<uint8_t> &dst);
+	static bool deserialize(Span<const uint8_t> src, VoxelMesher::Output &out_output);
+
+private:
+	static const unsigned int REGION_SIZE_PO2 = 3;
+	static const unsigned int REGION_SIZE = 1 << REGION_SIZE_PO2;
+	static const unsigned int REGION_VOLUME = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+	struct RegionKey {
+		uint64_t generator_hash;
+		uint64_t mesher_hash;
+		Vector3i position;
+		uint8_t lod_index;
+		uint8_t block_size_po2;
+
+		inline bool operator==(const RegionKey &other) const {
+			return generator_hash == other.generator_hash && mesher_hash == other.mesher_hash &&
+					position == other.position && lod_index == other.lod_index &&
+					block_size_po2 == other.block_size_po2;
+		}
+	};
+
+	struct RegionKeyHasher {
+		inline size_t operator()(const RegionKey &key) const {
+			uint64_t h = hash_djb2_one_64(key.generator_hash);
+			h = hash_djb2_one_64(key.mesher_hash, h);
+			h = hash_djb2_one_64(Vector3iHasher::hash(key.position), h);
+			return hash_djb2_one_64(uint64_t(key.lod_index) | (uint64_t(key.block_size_po2) << 8), h);
+		}
+	};
+
+	struct BlockLocation {
+		// Zero if the block is not in the file
+		uint32_t offset = 0;
+		uint32_t size = 0;
+	};
+
+	struct Region {
+		String file_path;
+		// Locks the header and writing to the file. Data of blocks never moves once written, so reading it doesn't
+		// need the lock.
+		Mutex mutex;
+		FixedArray<BlockLocation, REGION_VOLUME> blocks;
+		bool file_exists = false;
+	};
+
+	static RegionKey get_region_key(const Key &key, unsigned int &out_block_index);
+	std::shared_ptr<Region> get_or_load_region(const RegionKey &key);
+	String get_region_file_path(const RegionKey &key) const;
+
+	String _directory;
+	unsigned int _begin_lod_index = 0;
+
+	StdUnorderedMap<RegionKey, std::shared_ptr<Region>, RegionKeyHasher> _regions;
+	Mutex _regions_mutex;
+
+	std::atomic_uint64_t _hit_count = { 0 };
+	std::atomic_uint64_t _miss_count = { 0 };
+	std::atomic_uint64_t _store_count = { 0 };
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_MESH_OUTPUT_CACHE_H
@@ -8,6 +8,9 @@
 #include "../util/godot/classes/image.h"
 #include "../util/godot/classes/mesh.h"
 #include "../util/macros.h"
+#include "../util/math/box3i.h"
+
+#include <memory>
 
 ZN_GODOT_FORWARD_DECLARE(class ShaderMaterial)
 
@@ -25,6 +28,16 @@ class VoxelData;
 class VoxelMesher : public Resource {
 	GDCLASS(VoxelMesher, Resource)
 public:
+	// Data a mesher can keep from the build of a block, so the next build of the same block can reuse the parts that
+	// were not affected by edits. Contents are specific to each mesher. Not modified after being output.
+	class IncrementalState {
+	public:
+		virtual ~IncrementalState() {}
+
+		// Instance ID of the mesher that produced the state. Meshers must ignore states they didn't produce.
+		uint64_t mesher_id = 0;
+	};
+
 	struct Input {
 		// Voxels to be used as the primary source of data.
 		const VoxelBuffer &voxels;
@@ -46,6 +59,14 @@ public:
 		// If true, the mesher can collect some extra information which can be useful to speed up detail texture
 		// baking. Depends on the mesher.
 		bool detail_texture_hint = false;
+		// If true, the mesher may output an incremental state to speed up the next build of the same block.
+		bool incremental_hint = false;
+		// State output by the previous build of the same block, if any. Voxels are expected to be the same as back
+		// then, except inside `dirty_box`.
+		const IncrementalState *previous_state = nullptr;
+		// Area where voxels changed since `previous_state` was output, relative to the meshed area (not including
+		// padding).
+		Box3i dirty_box;
 	};
 
 	struct Output {
@@ -73,6 +94,9 @@ public:
 		// May be used to store extra information needed in shader to render the mesh properly
 		// (currently used only by the cubes mesher when baking colors)
 		Ref<Image> atlas_image;
+
+		// Set if the mesher supports incremental builds and `incremental_hint` was true.
+		std::shared_ptr<IncrementalState> incremental_state;
 	};
 
 	static bool is_mesh_empty(const StdVector<Output::Surface> &surfaces);
@@ -102,6 +126,19 @@ public:
 		return true;
 	}
 
+	// Returns true if this mesher can output an incremental state in its current configuration.
+	virtual bool is_incremental_build_enabled() const {
+		return false;
+	}
+
+	// Gets a hash identifying the meshes this mesher produces from given voxels. Meshers returning the same hash are
+	// expected to produce the same output, so it can be cached (see `VoxelMeshOutputCache`). Returning 0 means it is
+	// not supported.
+	// Must be thread-safe.
+	virtual uint64_t get_output_hash() const {
+		return 0;
+	}
+
 	// Some meshers can provide materials themselves. The index may come from the built output. Returns null if the
 	// index does not have a material assigned. If not provided here, a default material may be used.
 	// An error can be produced if the index is out of bounds.
@@ -1,4 +1,5 @@
 #include "voxel_modifier.h"
+#include "voxel_modifier_stack.h"
 
 namespace zylann::voxel {
 
@@ -12,4 +13,14 @@ void VoxelModifier::set_transform(Transform3D t) {
 	update_aabb();
 }
 
+void VoxelModifier::set_aabb(const AABB &aabb) {
+	if (aabb == _aabb) {
+		return;
+	}
+	_aabb = aabb;
+	if (_owner != nullptr) {
+		_owner->on_modifier_aabb_changed(*this);
+	}
+}
+
 } // namespace zylann::voxel
@@ -7,6 +7,8 @@
 
 namespace zylann::voxel {
 
+class VoxelModifierStack;
+
 struct VoxelModifierContext {
 	Span<float> sdf;
 	Span<const Vector3> positions;
@@ -44,15 +46,22 @@ public:
 
 protected:
 	virtual void update_aabb() = 0;
+	// Must be used by implementations to change bounds, so the stack owning the modifier can update its spatial index
+	void set_aabb(const AABB &aabb);
 
 	RWLock _rwlock;
-	AABB _aabb;
 
 	std::shared_ptr<ComputeShaderParameters> _shader_data;
 	bool _shader_data_need_update = false;
 
 private:
+	friend class VoxelModifierStack;
+
 	Transform3D _transform;
+	AABB _aabb;
+	// Set while the modifier is in a stack
+	VoxelModifierStack *_owner = nullptr;
+	uint32_t _index_item = 0;
 };
 
 } // namespace zylann::voxel
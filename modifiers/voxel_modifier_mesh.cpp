@@ -51,8 +51,10 @@ void VoxelModifierMesh::apply(VoxelModifierContext ctx) const {
 			Transform3D(Basis().scaled(to_vec3(max_pos - min_pos) / to_vec3(buffer.get_size())), to_vec3(min_pos));
 	const Transform3D buffer_to_world = model_to_world * buffer_to_model;
 
+	// Only used if the channel is palette-compressed
+	StdVector<uint8_t> decoded_sdf;
 	Span<const float> buffer_sdf;
-	ZN_ASSERT_RETURN(buffer.get_channel_data_read_only(VoxelBuffer::CHANNEL_SDF, buffer_sdf));
+	ZN_ASSERT_RETURN(buffer.get_channel_data_read_only(VoxelBuffer::CHANNEL_SDF, buffer_sdf, decoded_sdf));
 	const float smoothness = get_smoothness();
 
 	ops::SdfBufferShape shape;
@@ -88,7 +90,7 @@ void VoxelModifierMesh::update_aabb() {
 		return;
 	}
 	const Transform3D &model_to_world = get_transform();
-	_aabb = model_to_world.xform(_mesh_sdf->get_aabb());
+	set_aabb(model_to_world.xform(_mesh_sdf->get_aabb()));
 }
 
 void VoxelModifierMesh::get_shader_data(ShaderData &out_shader_data) {
@@ -24,7 +24,7 @@ real_t VoxelModifierSphere::get_radius() const {
 void VoxelModifierSphere::update_aabb() {
 	const float extent = _radius * 1.25f + get_smoothness();
 	const float extent2 = 2.0 * extent;
-	_aabb = AABB(get_transform().origin - Vector3(extent, extent, extent), Vector3(extent2, extent2, extent2));
+	set_aabb(AABB(get_transform().origin - Vector3(extent, extent, extent), Vector3(extent2, extent2, extent2)));
 }
 
 void VoxelModifierSphere::apply(VoxelModifierContext ctx) const {
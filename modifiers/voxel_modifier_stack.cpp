@@ -1,7 +1,9 @@
 #include "voxel_modifier_stack.h"
 #include "../edition/funcs.h"
 #include "../util/dstack.h"
+#include "../util/math/conv.h"
 #include "../util/profiling.h"
+#include <algorithm>
 
 namespace zylann::voxel {
 
@@ -130,6 +132,24 @@ void VoxelModifierStack::move_from_noclear(VoxelModifierStack &other) {
 		_modifiers = std::move(other._modifiers);
 		_stack = std::move(other._stack);
 	}
+	{
+		MutexLock lock(other._index_mutex);
+		_index_tree = std::move(other._index_tree);
+		_index_items = std::move(other._index_items);
+		_free_index_items = std::move(other._free_index_items);
+		_next_order = other._next_order;
+		other._index_tree.clear();
+		other._index_items.clear();
+		other._free_index_items.clear();
+		other.publish_index_snapshot();
+	}
+	{
+		MutexLock lock(_index_mutex);
+		publish_index_snapshot();
+	}
+	for (auto it = _modifiers.begin(); it != _modifiers.end(); ++it) {
+		it->second->_owner = this;
+	}
 	_next_id = other._next_id;
 }
 
@@ -137,13 +157,98 @@ uint32_t VoxelModifierStack::allocate_id() {
 	return ++_next_id;
 }
 
+void VoxelModifierStack::add_modifier(uint32_t id, std::shared_ptr<VoxelModifier> modifier) {
+	VoxelModifier *ptr = modifier.get();
+	{
+		MutexLock lock(_index_mutex);
+
+		uint32_t item_index;
+		if (_free_index_items.size() > 0) {
+			item_index = _free_index_items.back();
+			_free_index_items.pop_back();
+		} else {
+			item_index = _index_items.size();
+			_index_items.push_back(IndexItem());
+		}
+
+		const AABB aabb = ptr->get_aabb();
+		IndexItem &item = _index_items[item_index];
+		item.modifier = modifier;
+		item.order = _next_order++;
+		item.leaf = _index_tree.create_leaf(to_vec3f(aabb.position), to_vec3f(aabb.position + aabb.size), item_index);
+
+		ptr->_index_item = item_index;
+		ptr->_owner = this;
+		publish_index_snapshot();
+	}
+	{
+		RWLockWrite lock(_stack_lock);
+		_stack.push_back(ptr);
+	}
+	_modifiers[id] = std::move(modifier);
+}
+
+void VoxelModifierStack::on_modifier_aabb_changed(VoxelModifier &modifier) {
+	// Called from the modifier, which is locked for writing
+	MutexLock lock(_index_mutex);
+	ZN_ASSERT_RETURN(modifier._index_item < _index_items.size());
+	const IndexItem &item = _index_items[modifier._index_item];
+	ZN_ASSERT_RETURN(item.modifier.get() == &modifier);
+	const AABB aabb = modifier.get_aabb();
+	if (_index_tree.move_leaf(item.leaf, to_vec3f(aabb.position), to_vec3f(aabb.position + aabb.size))) {
+		publish_index_snapshot();
+	}
+	// Otherwise the modifier still fits in the box it is indexed with, and queries test its actual box anyways
+}
+
+void VoxelModifierStack::publish_index_snapshot() {
+	ZN_PROFILE_SCOPE();
+
+	std::shared_ptr<const IndexSnapshot> snapshot;
+	if (_index_tree.get_leaf_count() > 0) {
+		std::shared_ptr<IndexSnapshot> new_snapshot = make_shared_instance<IndexSnapshot>();
+		new_snapshot->tree = _index_tree;
+		new_snapshot->items = _index_items;
+		snapshot = std::move(new_snapshot);
+	}
+	{
+		MutexLock lock(_index_snapshot_mutex);
+		_index_snapshot.swap(snapshot);
+	}
+	// The previous snapshot gets released here, outside of the lock. Threads still using it keep it alive.
+}
+
+std::shared_ptr<const VoxelModifierStack::IndexSnapshot> VoxelModifierStack::get_index_snapshot() const {
+	MutexLock lock(_index_snapshot_mutex);
+	return _index_snapshot;
+}
+
+void VoxelModifierStack::IndexSnapshot::query(AABB aabb, StdVector<const IndexItem *> &out_items) const {
+	out_items.clear();
+	if (tree.get_leaf_count() == 0) {
+		return;
+	}
+
+	tree.query(to_vec3f(aabb.position), to_vec3f(aabb.position + aabb.size), [this, &aabb, &out_items](uint32_t i) {
+		const IndexItem &item = items[i];
+		// The tree has enlarged boxes, check the actual one
+		if (item.modifier->get_aabb().intersects(aabb)) {
+			out_items.push_back(&item);
+		}
+	});
+
+	std::sort(out_items.begin(), out_items.end(), [](const IndexItem *a, const IndexItem *b) {
+		return a->order < b->order;
+	});
+}
+
 void VoxelModifierStack::remove_modifier(uint32_t id) {
 	RWLockWrite lock(_stack_lock);
 
 	auto map_it = _modifiers.find(id);
 	ZN_ASSERT_RETURN(map_it != _modifiers.end());
 
-	const VoxelModifier *ptr = map_it->second.get();
+	VoxelModifier *ptr = map_it->second.get();
 	for (auto stack_it = _stack.begin(); stack_it != _stack.end(); ++stack_it) {
 		if (*stack_it == ptr) {
 			_stack.erase(stack_it);
@@ -151,6 +256,17 @@ void VoxelModifierStack::remove_modifier(uint32_t id) {
 		}
 	}
 
+	{
+		MutexLock index_lock(_index_mutex);
+		IndexItem &item = _index_items[ptr->_index_item];
+		_index_tree.destroy_leaf(item.leaf);
+		item.modifier.reset();
+		_free_index_items.push_back(ptr->_index_item);
+		ptr->_owner = nullptr;
+		publish_index_snapshot();
+	}
+
+	// Threads still using an older snapshot keep the modifier alive until they are done with it
 	_modifiers.erase(map_it);
 }
 
@@ -158,6 +274,16 @@ bool VoxelModifierStack::has_modifier(uint32_t id) const {
 	return _modifiers.find(id) != _modifiers.end();
 }
 
+bool VoxelModifierStack::has_modifiers_in(AABB aabb) const {
+	const std::shared_ptr<const IndexSnapshot> index = get_index_snapshot();
+	if (index == nullptr) {
+		return false;
+	}
+	thread_local StdVector<const IndexItem *> tls_items;
+	index->query(aabb, tls_items);
+	return tls_items.size() > 0;
+}
+
 VoxelModifier *VoxelModifierStack::get_modifier(uint32_t id) const {
 	auto it = _modifiers.find(id);
 	if (it != _modifiers.end()) {
@@ -168,9 +294,15 @@ VoxelModifier *VoxelModifierStack::get_modifier(uint32_t id) const {
 
 void VoxelModifierStack::apply(VoxelBuffer &voxels, AABB aabb) const {
 	ZN_PROFILE_SCOPE();
-	RWLockRead lock(_stack_lock);
 
-	if (_stack.size() == 0) {
+	const std::shared_ptr<const IndexSnapshot> index = get_index_snapshot();
+	if (index == nullptr) {
+		return;
+	}
+
+	thread_local StdVector<const IndexItem *> tls_items;
+	index->query(aabb, tls_items);
+	if (tls_items.size() == 0) {
 		return;
 	}
 
@@ -195,46 +327,43 @@ void VoxelModifierStack::apply(VoxelBuffer &voxels, AABB aabb) const {
 	const Vector3 w_to_v = Vector3(voxels.get_size()) / aabb.size;
 	const Vector3i origin_voxels = Vector3i(math::floor(aabb.position * w_to_v));
 
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		const VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
+	for (const IndexItem *item : tls_items) {
+		const VoxelModifier *modifier = item->modifier.get();
 
 		const AABB modifier_aabb = modifier->get_aabb();
-		if (modifier_aabb.intersects(aabb)) {
-			ZN_PROFILE_SCOPE_NAMED("Intersecting modifier");
+		ZN_PROFILE_SCOPE_NAMED("Intersecting modifier");
 
-			if (any_intersection == false) {
-				ZN_PROFILE_SCOPE_NAMED("Read block");
-				any_intersection = true;
+		if (any_intersection == false) {
+			ZN_PROFILE_SCOPE_NAMED("Read block");
+			any_intersection = true;
 
-				decompress_sdf_to_buffer(voxels, tls_block_sdf_initial);
+			decompress_sdf_to_buffer(voxels, tls_block_sdf_initial);
 
-				tls_block_sdf.resize(tls_block_sdf_initial.size());
-				memcpy(tls_block_sdf.data(), tls_block_sdf_initial.data(), tls_block_sdf.size() * sizeof(float));
-			}
+			tls_block_sdf.resize(tls_block_sdf_initial.size());
+			memcpy(tls_block_sdf.data(), tls_block_sdf_initial.data(), tls_block_sdf.size() * sizeof(float));
+		}
 
-			// Get modifier bounds in voxels
-			Box3i modifier_box(math::floor(modifier_aabb.position * w_to_v), math::ceil(modifier_aabb.size * w_to_v));
-			modifier_box.clip(Box3i(origin_voxels, voxels.get_size()));
-			const Vector3i local_origin_in_voxels = modifier_box.position - origin_voxels;
+		// Get modifier bounds in voxels
+		Box3i modifier_box(math::floor(modifier_aabb.position * w_to_v), math::ceil(modifier_aabb.size * w_to_v));
+		modifier_box.clip(Box3i(origin_voxels, voxels.get_size()));
+		const Vector3i local_origin_in_voxels = modifier_box.position - origin_voxels;
 
-			const int64_t volume = Vector3iUtil::get_volume(modifier_box.size);
-			area_sdf.resize(volume);
-			copy_3d_region_zxy(to_span(area_sdf), modifier_box.size, Vector3i(), to_span_const(tls_block_sdf),
-					voxels.get_size(), local_origin_in_voxels, local_origin_in_voxels + modifier_box.size);
+		const int64_t volume = Vector3iUtil::get_volume(modifier_box.size);
+		area_sdf.resize(volume);
+		copy_3d_region_zxy(to_span(area_sdf), modifier_box.size, Vector3i(), to_span_const(tls_block_sdf),
+				voxels.get_size(), local_origin_in_voxels, local_origin_in_voxels + modifier_box.size);
 
-			get_positions_buffer(
-					modifier_box.size, v_to_w * modifier_box.position, v_to_w * modifier_box.size, area_positions);
+		get_positions_buffer(
+				modifier_box.size, v_to_w * modifier_box.position, v_to_w * modifier_box.size, area_positions);
 
-			ctx.positions = to_span(area_positions);
-			ctx.sdf = to_span(area_sdf);
-			modifier->apply(ctx);
+		ctx.positions = to_span(area_positions);
+		ctx.sdf = to_span(area_sdf);
+		modifier->apply(ctx);
 
-			// Write modifications back to the full-block decompressed buffer
-			// TODO Maybe use an unchecked version for a bit more speed?
-			copy_3d_region_zxy(to_span(tls_block_sdf), voxels.get_size(), local_origin_in_voxels,
-					Span<const float>(ctx.sdf), modifier_box.size, Vector3i(), modifier_box.size);
-		}
+		// Write modifications back to the full-block decompressed buffer
+		// TODO Maybe use an unchecked version for a bit more speed?
+		copy_3d_region_zxy(to_span(tls_block_sdf), voxels.get_size(), local_origin_in_voxels,
+				Span<const float>(ctx.sdf), modifier_box.size, Vector3i(), modifier_box.size);
 	}
 
 	if (any_intersection) {
@@ -246,34 +375,40 @@ void VoxelModifierStack::apply(VoxelBuffer &voxels, AABB aabb) const {
 
 void VoxelModifierStack::apply(float &sdf, Vector3 position) const {
 	ZN_PROFILE_SCOPE();
-	RWLockRead lock(_stack_lock);
 
-	if (_stack.size() == 0) {
+	const std::shared_ptr<const IndexSnapshot> index = get_index_snapshot();
+	if (index == nullptr) {
 		return;
 	}
 
+	const AABB aabb(position, Vector3(1, 1, 1));
+
+	thread_local StdVector<const IndexItem *> tls_items;
+	index->query(aabb, tls_items);
+
 	VoxelModifierContext ctx;
 	ctx.positions = Span<Vector3>(&position, 1);
 	ctx.sdf = Span<float>(&sdf, 1);
 
-	const AABB aabb(position, Vector3(1, 1, 1));
-
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		const VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
-
-		if (modifier->get_aabb().intersects(aabb)) {
-			modifier->apply(ctx);
-		}
+	for (const IndexItem *item : tls_items) {
+		item->modifier->apply(ctx);
 	}
 }
 
 void VoxelModifierStack::apply(Span<const float> x_buffer, Span<const float> y_buffer, Span<const float> z_buffer,
 		Span<float> sdf_buffer, Vector3f min_pos, Vector3f max_pos) const {
 	ZN_PROFILE_SCOPE();
-	RWLockRead lock(_stack_lock);
 
-	if (_stack.size() == 0) {
+	const std::shared_ptr<const IndexSnapshot> index = get_index_snapshot();
+	if (index == nullptr) {
+		return;
+	}
+
+	const AABB aabb(to_vec3(min_pos), to_vec3(max_pos - min_pos));
+
+	thread_local StdVector<const IndexItem *> tls_items;
+	index->query(aabb, tls_items);
+	if (tls_items.size() == 0) {
 		return;
 	}
 
@@ -281,43 +416,44 @@ void VoxelModifierStack::apply(Span<const float> x_buffer, Span<const float> y_b
 	ctx.positions = get_positions_temporary(x_buffer, y_buffer, z_buffer);
 	ctx.sdf = sdf_buffer;
 
-	const AABB aabb(to_vec3(min_pos), to_vec3(max_pos - min_pos));
-
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		const VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
-
-		if (modifier->get_aabb().intersects(aabb)) {
-			modifier->apply(ctx);
-		}
+	for (const IndexItem *item : tls_items) {
+		item->modifier->apply(ctx);
 	}
 }
 
 void VoxelModifierStack::apply_for_gpu_rendering(
 		StdVector<VoxelModifier::ShaderData> &out_data, AABB aabb, VoxelModifier::ShaderData::Type type) const {
 	ZN_PROFILE_SCOPE();
-	RWLockRead lock(_stack_lock);
 
-	if (_stack.size() == 0) {
+	const std::shared_ptr<const IndexSnapshot> index = get_index_snapshot();
+	if (index == nullptr) {
 		return;
 	}
 
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
+	thread_local StdVector<const IndexItem *> tls_items;
+	index->query(aabb, tls_items);
 
-		if (modifier->get_aabb().intersects(aabb)) {
-			VoxelModifier::ShaderData sd;
-			modifier->get_shader_data(sd);
-			if (sd.shader_rids[type].is_valid()) {
-				out_data.push_back(sd);
-			}
+	for (const IndexItem *item : tls_items) {
+		VoxelModifier::ShaderData sd;
+		item->modifier->get_shader_data(sd);
+		if (sd.shader_rids[type].is_valid()) {
+			out_data.push_back(sd);
 		}
 	}
 }
 
 void VoxelModifierStack::clear() {
 	RWLockWrite lock(_stack_lock);
+	{
+		MutexLock index_lock(_index_mutex);
+		_index_tree.clear();
+		_index_items.clear();
+		_free_index_items.clear();
+		publish_index_snapshot();
+	}
+	for (auto it = _modifiers.begin(); it != _modifiers.end(); ++it) {
+		it->second->_owner = nullptr;
+	}
 	_stack.clear();
 	_modifiers.clear();
 }
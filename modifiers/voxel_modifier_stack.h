@@ -3,8 +3,10 @@
 
 #include "../util/containers/std_unordered_map.h"
 #include "../util/containers/std_vector.h"
+#include "../util/dynamic_aabb_tree.h"
 #include "../util/math/vector3f.h"
 #include "../util/memory/memory.h"
+#include "../util/thread/mutex.h"
 #include "voxel_modifier.h"
 
 namespace zylann::voxel {
@@ -23,17 +25,17 @@ public:
 	template <typename T>
 	T *add_modifier(uint32_t id) {
 		ZN_ASSERT(!has_modifier(id));
-		UniquePtr<VoxelModifier> &uptr = _modifiers[id];
-		uptr = make_unique_instance<T>();
-		VoxelModifier *ptr = uptr.get();
-		RWLockWrite lock(_stack_lock);
-		_stack.push_back(ptr);
-		return static_cast<T *>(ptr);
+		std::shared_ptr<T> modifier = make_shared_instance<T>();
+		T *ptr = modifier.get();
+		add_modifier(id, std::move(modifier));
+		return ptr;
 	}
 
 	void remove_modifier(uint32_t id);
 	bool has_modifier(uint32_t id) const;
 	VoxelModifier *get_modifier(uint32_t id) const;
+	// Tells if any modifier affects the given box
+	bool has_modifiers_in(AABB aabb) const;
 	void apply(VoxelBuffer &voxels, AABB aabb) const;
 	void apply(float &sdf, Vector3 position) const;
 	void apply(Span<const float> x_buffer, Span<const float> y_buffer, Span<const float> z_buffer,
@@ -51,13 +53,51 @@ public:
 	}
 
 private:
+	friend class VoxelModifier;
+
+	struct IndexItem {
+		// Shared so modifiers removed from the stack remain valid for threads still using an older snapshot
+		std::shared_ptr<VoxelModifier> modifier;
+		// Modifiers are applied in increasing order
+		uint32_t order;
+		uint32_t leaf;
+	};
+
+	// Copy of the spatial index that doesn't change once published, so threads can query it without locking
+	struct IndexSnapshot {
+		DynamicAABBTree tree;
+		StdVector<IndexItem> items;
+
+		// Gets modifiers intersecting the given box, sorted in the order they must be applied
+		void query(AABB aabb, StdVector<const IndexItem *> &out_items) const;
+	};
+
+	void add_modifier(uint32_t id, std::shared_ptr<VoxelModifier> modifier);
+	void on_modifier_aabb_changed(VoxelModifier &modifier);
+	// Must be called with `_index_mutex` locked, after the index changed
+	void publish_index_snapshot();
+	std::shared_ptr<const IndexSnapshot> get_index_snapshot() const;
 	void move_from_noclear(VoxelModifierStack &other);
 
-	StdUnorderedMap<uint32_t, UniquePtr<VoxelModifier>> _modifiers;
+	StdUnorderedMap<uint32_t, std::shared_ptr<VoxelModifier>> _modifiers;
 	uint32_t _next_id = 1;
-	// TODO Later, replace this with a spatial acceleration structure based on AABBs, like BVH
+	// Ordered list of modifiers
 	StdVector<VoxelModifier *> _stack;
 	RWLock _stack_lock;
+
+	// Spatial index of modifiers, updated incrementally when modifiers are added, moved or removed.
+	// Items are indexed by `VoxelModifier::_index_item`.
+	DynamicAABBTree _index_tree;
+	StdVector<IndexItem> _index_items;
+	StdVector<uint32_t> _free_index_items;
+	uint32_t _next_order = 0;
+	// Protects the index. Only modifications use it.
+	Mutex _index_mutex;
+	// Published by modifications of the index, so queries never have to copy it. Copying the index is much cheaper
+	// than what queries are used for. Null when there are no modifiers.
+	std::shared_ptr<const IndexSnapshot> _index_snapshot;
+	// Only held to swap or grab the current snapshot
+	mutable Mutex _index_snapshot_mutex;
 };
 
 } // namespace zylann::voxel
@@ -342,6 +342,9 @@ void initialize_voxel_module(ModuleInitializationLevel p_level) {
 
 		const zylann::voxel::godot::VoxelEngine::Config config =
 				zylann::voxel::godot::VoxelEngine::get_config_from_godot();
+		VoxelMemoryPool &memory_pool = VoxelMemoryPool::get_singleton();
+		memory_pool.set_thread_caches_enabled(config.memory_pool_thread_caches);
+		memory_pool.set_arenas_enabled(config.memory_pool_arenas, config.memory_pool_huge_pages);
 #ifdef TOOLS_ENABLED
 		CheckRefCountDoesNotChange::set_enabled(config.ownership_checks);
 #endif
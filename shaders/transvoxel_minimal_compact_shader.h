@@ -0,0 +1,49 @@
+// Generated file
+
+// clang-format off
+const char *g_transvoxel_minimal_compact_shader =
+"shader_type spatial;\n"
+"\n"
+"// From Voxel Tools API\n"
+"uniform int u_transition_mask;\n"
+"\n"
+"float get_transvoxel_secondary_factor(int cell_border_mask, int vertex_border_mask) {\n"
+"	int transition_mask = u_transition_mask & 0xff;\n"
+"\n"
+"	// If the vertex is near a side where there is a low-resolution neighbor,\n"
+"	// move it to secondary position\n"
+"	int m = transition_mask & cell_border_mask;\n"
+"	float t = float(m != 0);\n"
+"	// If the vertex lies on one or more sides, and at least one side has no low-resolution neighbor,\n"
+"	// don't move the vertex.\n"
+"	t *= float((vertex_border_mask & ~transition_mask) == 0);\n"
+"\n"
+"	return t;\n"
+"}\n"
+"\n"
+"// Variant used when `compact_vertex_format_enabled` is true.\n"
+"// `lod_data` is CUSTOM0: which sides the cell is touching, which sides the vertex is touching, which transition the\n"
+"// vertex belongs to, and LOD index.\n"
+"// `lod_offset` is CUSTOM2: offset to the secondary position, in cells of the LOD.\n"
+"vec3 get_transvoxel_position(vec3 vertex_pos, vec4 lod_data, vec4 lod_offset) {\n"
+"	ivec4 idata = ivec4(round(lod_data * 255.0));\n"
+"\n"
+"	// Move vertices to smooth transitions\n"
+"	float secondary_factor = get_transvoxel_secondary_factor(idata.x, idata.y);\n"
+"	vec3 secondary_offset = lod_offset.xyz * exp2(float(idata.w));\n"
+"	vec3 pos = vertex_pos + secondary_offset * secondary_factor;\n"
+"\n"
+"	// If the mesh combines transitions and the vertex belongs to a transition,\n"
+"	// when that transition isn't active we change the position of the vertices so\n"
+"	// all triangles will be degenerate and won't be visible.\n"
+"	int itransition = idata.z; // Is the vertex on a transition mesh?\n"
+"	float transition_cull = float(itransition == 0 || (itransition & u_transition_mask) != 0);\n"
+"	pos *= transition_cull;\n"
+"\n"
+"	return pos;\n"
+"}\n"
+"\n"
+"void vertex() {\n"
+"	VERTEX = get_transvoxel_position(VERTEX, CUSTOM0, CUSTOM2);\n"
+"}\n";
+// clang-format on
@@ -37,6 +37,94 @@ inline void free_channel_data(uint8_t *data, uint32_t size, VoxelBuffer::Allocat
 	}
 }
 
+// Palette-compressed channels store `2^bits` palette entries of the channel's depth, followed by voxel indices packed
+// with `bits` bits each. Since `bits` is a divisor of 8, indices never straddle two bytes.
+
+inline unsigned int get_palette_index_bits(unsigned int palette_size) {
+	if (palette_size <= 2) {
+		return 1;
+	}
+	if (palette_size <= 4) {
+		return 2;
+	}
+	if (palette_size <= 16) {
+		return 4;
+	}
+	return 8;
+}
+
+inline size_t get_palette_header_size_in_bytes(unsigned int index_bits, VoxelBuffer::Depth depth) {
+	return (size_t(1) << index_bits) * VoxelBuffer::get_depth_byte_count(depth);
+}
+
+inline size_t get_palette_channel_size_in_bytes(size_t volume, unsigned int index_bits, VoxelBuffer::Depth depth) {
+	return get_palette_header_size_in_bytes(index_bits, depth) + (volume * index_bits + 7) / 8;
+}
+
+inline uint64_t read_raw_value(const uint8_t *data, VoxelBuffer::Depth depth, size_t i) {
+	switch (depth) {
+		case VoxelBuffer::DEPTH_8_BIT:
+			return data[i];
+		case VoxelBuffer::DEPTH_16_BIT:
+			return reinterpret_cast<const uint16_t *>(data)[i];
+		case VoxelBuffer::DEPTH_32_BIT:
+			return reinterpret_cast<const uint32_t *>(data)[i];
+		case VoxelBuffer::DEPTH_64_BIT:
+			return reinterpret_cast<const uint64_t *>(data)[i];
+		default:
+			ZN_CRASH();
+			return 0;
+	}
+}
+
+inline void write_raw_value(uint8_t *data, VoxelBuffer::Depth depth, size_t i, uint64_t value) {
+	switch (depth) {
+		case VoxelBuffer::DEPTH_8_BIT:
+			data[i] = value;
+			break;
+		case VoxelBuffer::DEPTH_16_BIT:
+			reinterpret_cast<uint16_t *>(data)[i] = value;
+			break;
+		case VoxelBuffer::DEPTH_32_BIT:
+			reinterpret_cast<uint32_t *>(data)[i] = value;
+			break;
+		case VoxelBuffer::DEPTH_64_BIT:
+			reinterpret_cast<uint64_t *>(data)[i] = value;
+			break;
+		default:
+			ZN_CRASH();
+	}
+}
+
+inline unsigned int read_packed_index(const uint8_t *indices, unsigned int bits, size_t i) {
+	const size_t bit_index = i * bits;
+	const unsigned int mask = (1 << bits) - 1;
+	return (indices[bit_index >> 3] >> (bit_index & 7)) & mask;
+}
+
+inline void write_packed_index(uint8_t *indices, unsigned int bits, size_t i, unsigned int index) {
+	const size_t bit_index = i * bits;
+	const unsigned int shift = bit_index & 7;
+	const unsigned int mask = ((1 << bits) - 1) << shift;
+	uint8_t &b = indices[bit_index >> 3];
+	b = (b & ~mask) | ((index << shift) & mask);
+}
+
+// Returns the index of the value in the palette, or -1 if not found.
+inline int find_palette_index(
+		const uint8_t *palette,
+		VoxelBuffer::Depth depth,
+		unsigned int palette_size,
+		uint64_t v
+) {
+	for (unsigned int i = 0; i < palette_size; ++i) {
+		if (read_raw_value(palette, depth, i) == v) {
+			return i;
+		}
+	}
+	return -1;
+}
+
 // uint64_t g_depth_max_values[] = {
 // 	0xff, // 8
 // 	0xffff, // 16
@@ -268,6 +356,9 @@ uint64_t VoxelBuffer::get_voxel(int x, int y, int z, unsigned int channel_index)
 	if (channel.compression == COMPRESSION_UNIFORM) {
 		return channel.defval;
 
+	} else if (channel.compression == COMPRESSION_PALETTE) {
+		return get_palette_voxel(channel, get_index(x, y, z));
+
 	} else {
 #ifdef DEV_ENABLED
 		ZN_ASSERT(channel.data != nullptr);
@@ -310,6 +401,12 @@ void VoxelBuffer::set_voxel(uint64_t value, int x, int y, int z, unsigned int ch
 		} else {
 			do_set = false;
 		}
+
+	} else if (channel.compression == COMPRESSION_PALETTE) {
+		// Falls back to the dense path if the palette could not hold the new value
+		do_set = !set_palette_voxel(channel, get_index(x, y, z), value);
+		// Decompressing can fail too
+		ZN_ASSERT_RETURN(!do_set || channel.compression == COMPRESSION_NONE);
 	}
 
 	if (do_set) {
@@ -372,6 +469,12 @@ void VoxelBuffer::fill(uint64_t defval, unsigned int channel_index) {
 		return;
 	}
 
+	if (channel.compression == COMPRESSION_PALETTE) {
+		// The whole channel gets the same value, no need to keep the palette
+		clear_channel(channel, defval, _allocator);
+		return;
+	}
+
 	const size_t volume = get_volume();
 #ifdef DEBUG_ENABLED
 	ZN_ASSERT(channel.size_in_bytes == get_size_in_bytes_for_volume(_size, channel.depth));
@@ -429,6 +532,9 @@ void VoxelBuffer::fill_area(uint64_t defval, Vector3i min, Vector3i max, unsigne
 		} else {
 			ZN_ASSERT_RETURN(create_channel(channel_index, channel.defval));
 		}
+
+	} else if (channel.compression == COMPRESSION_PALETTE) {
+		decompress_palette(channel);
 	}
 
 #ifdef DEV_ENABLED
@@ -497,12 +603,29 @@ bool VoxelBuffer::is_uniform(unsigned int channel_index) const {
 	return is_uniform(channel);
 }
 
-bool VoxelBuffer::is_uniform(const Channel &channel) {
+bool VoxelBuffer::is_uniform(const Channel &channel) const {
 	if (channel.compression == COMPRESSION_UNIFORM) {
 		// Channel has been optimized
 		return true;
 	}
 
+	if (channel.compression == COMPRESSION_PALETTE) {
+		if (channel.palette_size <= 1) {
+			return true;
+		}
+		// Compare indices rather than values, since the palette only contains distinct values
+		const unsigned int bits = get_palette_index_bits(channel.palette_size);
+		const uint8_t *indices = channel.data + get_palette_header_size_in_bytes(bits, channel.depth);
+		const size_t volume = get_volume();
+		const unsigned int first = read_packed_index(indices, bits, 0);
+		for (size_t i = 1; i < volume; ++i) {
+			if (read_packed_index(indices, bits, i) != first) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	// Channel isn't optimized, so must look at each voxel
 	switch (channel.depth) {
 		case DEPTH_8_BIT:
@@ -527,6 +650,12 @@ uint64_t get_first_voxel(const VoxelBuffer::Channel &channel) {
 	ZN_ASSERT(channel.data != nullptr);
 #endif
 
+	if (channel.compression == VoxelBuffer::COMPRESSION_PALETTE) {
+		const unsigned int bits = get_palette_index_bits(channel.palette_size);
+		const uint8_t *indices = channel.data + get_palette_header_size_in_bytes(bits, channel.depth);
+		return read_raw_value(channel.data, channel.depth, read_packed_index(indices, bits, 0));
+	}
+
 	switch (channel.depth) {
 		case VoxelBuffer::DEPTH_8_BIT:
 			return channel.data[0];
@@ -560,6 +689,191 @@ void VoxelBuffer::compress_if_uniform(Channel &channel) {
 	}
 }
 
+void VoxelBuffer::compress_palette_channels() {
+	ZN_PROFILE_SCOPE();
+	for (unsigned int i = 0; i < MAX_CHANNELS; ++i) {
+		Channel &channel = _channels[i];
+		compress_if_uniform(channel);
+		if (channel.compression == COMPRESSION_NONE) {
+			compress_channel_to_palette(i);
+		}
+	}
+}
+
+bool VoxelBuffer::compress_channel_to_palette(unsigned int channel_index) {
+	ZN_DSTACK();
+	ZN_ASSERT_RETURN_V(channel_index < MAX_CHANNELS, false);
+	Channel &channel = _channels[channel_index];
+
+	if (channel.compression != COMPRESSION_NONE) {
+		// Uniform is already smaller, and palette is already done
+		return channel.compression == COMPRESSION_PALETTE;
+	}
+
+#ifdef DEV_ENABLED
+	ZN_ASSERT(channel.data != nullptr);
+#endif
+
+	const size_t volume = get_volume();
+
+	// Gather distinct values. Voxels often come in runs, so the last found value is checked first.
+	FixedArray<uint64_t, MAX_PALETTE_SIZE> palette;
+	unsigned int palette_size = 0;
+	{
+		uint64_t last_value = 0;
+		bool has_last_value = false;
+		for (size_t i = 0; i < volume; ++i) {
+			const uint64_t v = read_raw_value(channel.data, channel.depth, i);
+			if (has_last_value && v == last_value) {
+				continue;
+			}
+			last_value = v;
+			has_last_value = true;
+			bool found = false;
+			for (unsigned int pi = 0; pi < palette_size; ++pi) {
+				if (palette[pi] == v) {
+					found = true;
+					break;
+				}
+			}
+			if (!found) {
+				if (palette_size == MAX_PALETTE_SIZE) {
+					// Too many distinct values
+					return false;
+				}
+				palette[palette_size] = v;
+				++palette_size;
+			}
+		}
+	}
+
+	const unsigned int bits = get_palette_index_bits(palette_size);
+	const size_t size_in_bytes = get_palette_channel_size_in_bytes(volume, bits, channel.depth);
+	if (size_in_bytes >= channel.size_in_bytes) {
+		// Wouldn't save any memory
+		return false;
+	}
+
+	uint8_t *data = allocate_channel_data(size_in_bytes, _allocator);
+	ZN_ASSERT_RETURN_V(data != nullptr, false);
+	// Unused palette entries and trailing bits must be zero so that byte-wise comparisons remain valid
+	memset(data, 0, size_in_bytes);
+
+	for (unsigned int pi = 0; pi < palette_size; ++pi) {
+		write_raw_value(data, channel.depth, pi, palette[pi]);
+	}
+
+	uint8_t *indices = data + get_palette_header_size_in_bytes(bits, channel.depth);
+	{
+		uint64_t last_value = palette[0];
+		unsigned int last_index = 0;
+		for (size_t i = 0; i < volume; ++i) {
+			const uint64_t v = read_raw_value(channel.data, channel.depth, i);
+			if (v != last_value) {
+				last_index = find_palette_index(data, channel.depth, palette_size, v);
+				last_value = v;
+			}
+			write_packed_index(indices, bits, i, last_index);
+		}
+	}
+
+	free_channel_data(channel.data, channel.size_in_bytes, _allocator);
+	channel.data = data;
+	channel.size_in_bytes = size_in_bytes;
+	channel.palette_size = palette_size;
+	channel.compression = COMPRESSION_PALETTE;
+	return true;
+}
+
+uint64_t VoxelBuffer::get_palette_voxel(const Channel &channel, size_t voxel_index) {
+#ifdef DEV_ENABLED
+	ZN_ASSERT(channel.compression == COMPRESSION_PALETTE);
+	ZN_ASSERT(channel.data != nullptr);
+#endif
+	const unsigned int bits = get_palette_index_bits(channel.palette_size);
+	const uint8_t *indices = channel.data + get_palette_header_size_in_bytes(bits, channel.depth);
+	return read_raw_value(channel.data, channel.depth, read_packed_index(indices, bits, voxel_index));
+}
+
+bool VoxelBuffer::set_palette_voxel(Channel &channel, size_t voxel_index, uint64_t value) {
+#ifdef DEV_ENABLED
+	ZN_ASSERT(channel.compression == COMPRESSION_PALETTE);
+	ZN_ASSERT(channel.data != nullptr);
+#endif
+	unsigned int bits = get_palette_index_bits(channel.palette_size);
+	int palette_index = find_palette_index(channel.data, channel.depth, channel.palette_size, value);
+
+	if (palette_index == -1) {
+		if (channel.palette_size == MAX_PALETTE_SIZE) {
+			// Palette is full, go back to storing values directly
+			decompress_palette(channel);
+			return false;
+		}
+
+		const unsigned int new_palette_size = channel.palette_size + 1;
+		const unsigned int new_bits = get_palette_index_bits(new_palette_size);
+
+		if (new_bits != bits) {
+			// Widen indices
+			const size_t volume = get_volume();
+			const size_t new_size_in_bytes = get_palette_channel_size_in_bytes(volume, new_bits, channel.depth);
+			uint8_t *new_data = allocate_channel_data(new_size_in_bytes, _allocator);
+			if (new_data == nullptr) {
+				// Bad alloc, try storing values directly instead
+				decompress_palette(channel);
+				return false;
+			}
+			memset(new_data, 0, new_size_in_bytes);
+
+			memcpy(new_data, channel.data, channel.palette_size * get_depth_byte_count(channel.depth));
+
+			const uint8_t *src_indices = channel.data + get_palette_header_size_in_bytes(bits, channel.depth);
+			uint8_t *dst_indices = new_data + get_palette_header_size_in_bytes(new_bits, channel.depth);
+			for (size_t i = 0; i < volume; ++i) {
+				write_packed_index(dst_indices, new_bits, i, read_packed_index(src_indices, bits, i));
+			}
+
+			free_channel_data(channel.data, channel.size_in_bytes, _allocator);
+			channel.data = new_data;
+			channel.size_in_bytes = new_size_in_bytes;
+			bits = new_bits;
+		}
+
+		palette_index = channel.palette_size;
+		write_raw_value(channel.data, channel.depth, palette_index, value);
+		channel.palette_size = new_palette_size;
+	}
+
+	uint8_t *indices = channel.data + get_palette_header_size_in_bytes(bits, channel.depth);
+	write_packed_index(indices, bits, voxel_index, palette_index);
+	return true;
+}
+
+void VoxelBuffer::decompress_palette(Channel &channel) {
+	ZN_DSTACK();
+#ifdef DEV_ENABLED
+	ZN_ASSERT(channel.compression == COMPRESSION_PALETTE);
+	ZN_ASSERT(channel.data != nullptr);
+#endif
+	const size_t volume = get_volume();
+	const size_t size_in_bytes = get_size_in_bytes_for_volume(_size, channel.depth);
+	uint8_t *data = allocate_channel_data(size_in_bytes, _allocator);
+	ZN_ASSERT_RETURN(data != nullptr);
+
+	const unsigned int bits = get_palette_index_bits(channel.palette_size);
+	const uint8_t *indices = channel.data + get_palette_header_size_in_bytes(bits, channel.depth);
+	for (size_t i = 0; i < volume; ++i) {
+		const unsigned int palette_index = read_packed_index(indices, bits, i);
+		write_raw_value(data, channel.depth, i, read_raw_value(channel.data, channel.depth, palette_index));
+	}
+
+	free_channel_data(channel.data, channel.size_in_bytes, _allocator);
+	channel.data = data;
+	channel.size_in_bytes = size_in_bytes;
+	channel.palette_size = 0;
+	channel.compression = COMPRESSION_NONE;
+}
+
 void VoxelBuffer::decompress_channel(unsigned int channel_index) {
 	ZN_DSTACK();
 	ZN_ASSERT_RETURN(channel_index < MAX_CHANNELS);
@@ -567,6 +881,8 @@ void VoxelBuffer::decompress_channel(unsigned int channel_index) {
 	Channel &channel = _channels[channel_index];
 	if (channel.compression == COMPRESSION_UNIFORM) {
 		ZN_ASSERT_RETURN(create_channel(channel_index, channel.defval));
+	} else if (channel.compression == COMPRESSION_PALETTE) {
+		decompress_palette(channel);
 	}
 }
 
@@ -576,6 +892,16 @@ VoxelBuffer::Compression VoxelBuffer::get_channel_compression(unsigned int chann
 	return channel.compression;
 }
 
+size_t VoxelBuffer::get_channels_size_in_bytes() const {
+	size_t size_in_bytes = 0;
+	for (const Channel &channel : _channels) {
+		if (channel.compression != COMPRESSION_UNIFORM) {
+			size_in_bytes += channel.size_in_bytes;
+		}
+	}
+	return size_in_bytes;
+}
+
 void VoxelBuffer::copy_format(const VoxelBuffer &other) {
 	for (unsigned int i = 0; i < MAX_CHANNELS; ++i) {
 		set_channel_depth(i, other.get_channel_depth(i));
@@ -599,8 +925,23 @@ void VoxelBuffer::copy_channel_from(const VoxelBuffer &other, unsigned int chann
 
 	ZN_ASSERT_RETURN(other_channel.depth == channel.depth);
 
-	if (other_channel.compression != COMPRESSION_UNIFORM) {
+	if (other_channel.compression == COMPRESSION_PALETTE) {
+		// Copy the palette as-is
+		if (channel.compression != COMPRESSION_UNIFORM) {
+			delete_channel(channel_index);
+		}
+		channel.data = allocate_channel_data(other_channel.size_in_bytes, _allocator);
+		ZN_ASSERT_RETURN(channel.data != nullptr);
+		memcpy(channel.data, other_channel.data, other_channel.size_in_bytes);
+		channel.size_in_bytes = other_channel.size_in_bytes;
+		channel.palette_size = other_channel.palette_size;
+		channel.compression = COMPRESSION_PALETTE;
+
+	} else if (other_channel.compression != COMPRESSION_UNIFORM) {
 		// Other is not uniform, make sure we allocate our channel
+		if (channel.compression == COMPRESSION_PALETTE) {
+			delete_channel(channel_index);
+		}
 		if (channel.compression == COMPRESSION_UNIFORM) {
 			ZN_ASSERT_RETURN(create_channel_noinit(channel_index, _size));
 		}
@@ -650,7 +991,37 @@ void VoxelBuffer::copy_channel_from(
 		return;
 	}
 
-	if (other_channel.compression != COMPRESSION_UNIFORM) {
+	if (channel.compression == COMPRESSION_PALETTE && other_channel.compression != COMPRESSION_UNIFORM) {
+		// Pasting arbitrary data, a dense destination is simpler.
+		// It is also preferable for buffers receiving many copies, such as the input of meshers.
+		decompress_palette(channel);
+	}
+
+	if (other_channel.compression == COMPRESSION_PALETTE) {
+		if (channel.compression == COMPRESSION_UNIFORM) {
+			ZN_ASSERT_RETURN(create_channel(channel_index, channel.defval));
+		}
+#ifdef DEV_ENABLED
+		ZN_ASSERT(channel.data != nullptr);
+#endif
+		Vector3iUtil::sort_min_max(src_min, src_max);
+		clip_copy_region(src_min, src_max, other._size, dst_min, _size);
+		Vector3i pos;
+		for (pos.z = src_min.z; pos.z < src_max.z; ++pos.z) {
+			for (pos.x = src_min.x; pos.x < src_max.x; ++pos.x) {
+				pos.y = src_min.y;
+				size_t src_i = other.get_index(pos.x, pos.y, pos.z);
+				const Vector3i dst_pos = dst_min + pos - src_min;
+				size_t dst_i = get_index(dst_pos.x, dst_pos.y, dst_pos.z);
+				for (; pos.y < src_max.y; ++pos.y) {
+					write_raw_value(channel.data, channel.depth, dst_i, get_palette_voxel(other_channel, src_i));
+					++src_i;
+					++dst_i;
+				}
+			}
+		}
+
+	} else if (other_channel.compression != COMPRESSION_UNIFORM) {
 		if (channel.compression == COMPRESSION_UNIFORM) {
 			// Note, we do this even if the pasted data happens to be all the same value as our current channel.
 			// We assume that this case is not frequent enough to bother, and compression can happen later
@@ -713,11 +1084,15 @@ void VoxelBuffer::move_to(VoxelBuffer &dst) {
 		channel.data = nullptr;
 		channel.compression = COMPRESSION_UNIFORM;
 		channel.size_in_bytes = 0;
+		channel.palette_size = 0;
 	}
 }
 
 bool VoxelBuffer::get_channel_as_bytes(unsigned int channel_index, Span<uint8_t> &slice) {
 	const Channel &channel = _channels[channel_index];
+	if (channel.compression == COMPRESSION_PALETTE) {
+		decompress_channel(channel_index);
+	}
 	if (channel.compression != COMPRESSION_UNIFORM) {
 #ifdef DEV_ENABLED
 		ZN_ASSERT(channel.data != nullptr);
@@ -732,6 +1107,11 @@ bool VoxelBuffer::get_channel_as_bytes(unsigned int channel_index, Span<uint8_t>
 
 bool VoxelBuffer::get_channel_as_bytes_read_only(unsigned int channel_index, Span<const uint8_t> &slice) const {
 	const Channel &channel = _channels[channel_index];
+	if (channel.compression == COMPRESSION_PALETTE) {
+		ZN_PRINT_ERROR("Can't get raw bytes of a palette-compressed channel");
+		slice = Span<const uint8_t>();
+		return false;
+	}
 	if (channel.compression != COMPRESSION_UNIFORM) {
 #ifdef DEV_ENABLED
 		ZN_ASSERT(channel.data != nullptr);
@@ -744,6 +1124,51 @@ bool VoxelBuffer::get_channel_as_bytes_read_only(unsigned int channel_index, Spa
 	return false;
 }
 
+bool VoxelBuffer::get_channel_as_bytes_read_only(
+		unsigned int channel_index,
+		Span<const uint8_t> &slice,
+		StdVector<uint8_t> &temp
+) const {
+	ZN_ASSERT_RETURN_V(channel_index < MAX_CHANNELS, false);
+	const Channel &channel = _channels[channel_index];
+	if (channel.compression == COMPRESSION_PALETTE) {
+		temp.resize(get_size_in_bytes_for_volume(_size, channel.depth));
+		copy_channel_to_bytes(channel_index, to_span(temp));
+		slice = to_span_const(temp);
+		return true;
+	}
+	return get_channel_as_bytes_read_only(channel_index, slice);
+}
+
+void VoxelBuffer::copy_channel_to_bytes(unsigned int channel_index, Span<uint8_t> dst) const {
+	ZN_ASSERT_RETURN(channel_index < MAX_CHANNELS);
+	const Channel &channel = _channels[channel_index];
+	ZN_ASSERT_RETURN(dst.size() == get_size_in_bytes_for_volume(_size, channel.depth));
+
+	switch (channel.compression) {
+		case COMPRESSION_NONE:
+			memcpy(dst.data(), channel.data, dst.size());
+			break;
+
+		case COMPRESSION_UNIFORM: {
+			const size_t volume = get_volume();
+			for (size_t i = 0; i < volume; ++i) {
+				write_raw_value(dst.data(), channel.depth, i, channel.defval);
+			}
+		} break;
+
+		case COMPRESSION_PALETTE: {
+			const size_t volume = get_volume();
+			for (size_t i = 0; i < volume; ++i) {
+				write_raw_value(dst.data(), channel.depth, i, get_palette_voxel(channel, i));
+			}
+		} break;
+
+		default:
+			ZN_CRASH_MSG("Unhandled compression");
+	}
+}
+
 bool VoxelBuffer::create_channel(int i, uint64_t defval) {
 	ZN_DSTACK();
 	if (!create_channel_noinit(i, _size)) {
@@ -787,6 +1212,7 @@ void VoxelBuffer::delete_channel(Channel &channel, Allocator allocator) {
 	channel.data = nullptr;
 	channel.compression = COMPRESSION_UNIFORM;
 	channel.size_in_bytes = 0;
+	channel.palette_size = 0;
 }
 
 void VoxelBuffer::downscale_to(VoxelBuffer &dst, Vector3i src_min, Vector3i src_max, Vector3i dst_min) const {
@@ -847,12 +1273,33 @@ bool VoxelBuffer::equals(const VoxelBuffer &p_other) const {
 		const Channel &channel = _channels[channel_index];
 		const Channel &other_channel = p_other._channels[channel_index];
 
-		if (channel.compression != other_channel.compression) {
-			// Note: they could still logically be equal if one channel contains uniform voxel memory.
+		if (channel.depth != other_channel.depth) {
 			return false;
 		}
 
-		if (channel.depth != other_channel.depth) {
+		if (channel.compression == COMPRESSION_PALETTE || other_channel.compression == COMPRESSION_PALETTE) {
+			// Palette layouts depend on the order values were inserted in, so compare decoded values
+			if (channel.compression == other_channel.compression &&
+				channel.palette_size == other_channel.palette_size &&
+				channel.size_in_bytes == other_channel.size_in_bytes &&
+				memcmp(channel.data, other_channel.data, channel.size_in_bytes) == 0) {
+				continue;
+			}
+			const size_t size_in_bytes = get_size_in_bytes_for_volume(_size, channel.depth);
+			StdVector<uint8_t> decoded;
+			StdVector<uint8_t> other_decoded;
+			decoded.resize(size_in_bytes);
+			other_decoded.resize(size_in_bytes);
+			copy_channel_to_bytes(channel_index, to_span(decoded));
+			p_other.copy_channel_to_bytes(channel_index, to_span(other_decoded));
+			if (decoded != other_decoded) {
+				return false;
+			}
+			continue;
+		}
+
+		if (channel.compression != other_channel.compression) {
+			// Note: they could still logically be equal if one channel contains uniform voxel memory.
 			return false;
 		}
 
@@ -862,6 +1309,10 @@ bool VoxelBuffer::equals(const VoxelBuffer &p_other) const {
 			}
 
 		} else {
+			if (channel.palette_size != other_channel.palette_size) {
+				// Note: palettes could still be logically equal if their entries are in a different order.
+				return false;
+			}
 			ZN_ASSERT_RETURN_V(channel.size_in_bytes == other_channel.size_in_bytes, false);
 #ifdef DEV_ENABLED
 			ZN_ASSERT(channel.data != nullptr);
@@ -922,6 +1373,18 @@ void VoxelBuffer::get_range_f(float &out_min, float &out_max, ChannelId channel_
 		return;
 	}
 
+	if (channel.compression == COMPRESSION_PALETTE) {
+		// Only looks at the palette. This may be conservative if some entries are no longer referenced.
+		for (unsigned int i = 0; i < channel.palette_size; ++i) {
+			const float v = raw_voxel_to_real(read_raw_value(channel.data, channel.depth, i), channel.depth);
+			min_value = math::min(v, min_value);
+			max_value = math::max(v, max_value);
+		}
+		out_min = min_value;
+		out_max = max_value;
+		return;
+	}
+
 	const uint64_t volume = get_volume();
 
 #ifdef DEV_ENABLED
@@ -1100,10 +1563,13 @@ void get_unscaled_sdf(const VoxelBuffer &voxels, Span<float> sdf) {
 		return;
 	}
 
+	// Only used if the channel is palette-compressed
+	StdVector<uint8_t> decoded;
+
 	switch (depth) {
 		case VoxelBuffer::DEPTH_8_BIT: {
 			Span<const int8_t> raw;
-			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw, decoded));
 			for (unsigned int i = 0; i < sdf.size(); ++i) {
 				sdf[i] = s8_to_snorm(raw[i]);
 			}
@@ -1111,7 +1577,7 @@ void get_unscaled_sdf(const VoxelBuffer &voxels, Span<float> sdf) {
 
 		case VoxelBuffer::DEPTH_16_BIT: {
 			Span<const int16_t> raw;
-			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw, decoded));
 			for (unsigned int i = 0; i < sdf.size(); ++i) {
 				sdf[i] = s16_to_snorm(raw[i]);
 			}
@@ -1119,13 +1585,13 @@ void get_unscaled_sdf(const VoxelBuffer &voxels, Span<float> sdf) {
 
 		case VoxelBuffer::DEPTH_32_BIT: {
 			Span<const float> raw;
-			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw, decoded));
 			memcpy(sdf.data(), raw.data(), sizeof(float) * sdf.size());
 		} break;
 
 		case VoxelBuffer::DEPTH_64_BIT: {
 			Span<const double> raw;
-			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw, decoded));
 			for (unsigned int i = 0; i < sdf.size(); ++i) {
 				sdf[i] = raw[i];
 			}
@@ -4,6 +4,7 @@
 #include "../util/containers/fixed_array.h"
 #include "../util/containers/flat_map.h"
 #include "../util/containers/small_vector.h"
+#include "../util/containers/std_vector.h"
 #include "../util/math/box3i.h"
 #include "funcs.h"
 #include "metadata/voxel_metadata.h"
@@ -39,6 +40,9 @@ public:
 	enum Compression : uint8_t {
 		COMPRESSION_NONE = 0,
 		COMPRESSION_UNIFORM, // aka "no voxels allocated"
+		// Values are stored as bit-packed indices into a small per-channel palette of distinct values.
+		// Only used in memory, never serialized as such.
+		COMPRESSION_PALETTE,
 		COMPRESSION_COUNT
 	};
 
@@ -107,7 +111,9 @@ public:
 
 		Depth depth = DEFAULT_CHANNEL_DEPTH;
 		Compression compression = COMPRESSION_UNIFORM;
-		// [...] 2 unused bytes
+		// Number of entries used in the palette, when compression is `COMPRESSION_PALETTE`.
+		// `data` then starts with the palette (capacity entries of `depth` size), followed by packed indices.
+		uint16_t palette_size = 0;
 
 		// Storing gigabytes in a single buffer is neither supported nor practical.
 		uint32_t size_in_bytes = 0;
@@ -115,6 +121,9 @@ public:
 		static const size_t MAX_SIZE_IN_BYTES = std::numeric_limits<uint32_t>::max();
 	};
 
+	// Maximum amount of distinct values a palette-compressed channel can hold. Beyond that, it gets decompressed.
+	static const unsigned int MAX_PALETTE_SIZE = 256;
+
 	// VoxelBuffer();
 	VoxelBuffer(Allocator allocator);
 	VoxelBuffer(VoxelBuffer &&src);
@@ -169,8 +178,15 @@ public:
 	bool is_uniform(unsigned int channel_index) const;
 
 	void compress_uniform_channels();
+	// Compresses uniform channels, then attempts to store remaining channels as a palette of distinct values with
+	// bit-packed indices, if that uses less memory. Voxels can still be accessed with `get_voxel` and `set_voxel`,
+	// but functions requiring raw access will decompress the channel.
+	void compress_palette_channels();
+	bool compress_channel_to_palette(unsigned int channel_index);
 	void decompress_channel(unsigned int channel_index);
 	Compression get_channel_compression(unsigned int channel_index) const;
+	// Gets how many bytes are allocated for voxels of all channels. Doesn't include metadata.
+	size_t get_channels_size_in_bytes() const;
 
 	static size_t get_size_in_bytes_for_volume(Vector3i size, Depth depth);
 
@@ -245,6 +261,24 @@ public:
 
 		if (channel.compression == COMPRESSION_UNIFORM) {
 			fill_3d_region_zxy<T>(dst, dst_size, dst_min, dst_min + (src_max - src_min), channel.defval);
+
+		} else if (channel.compression == COMPRESSION_PALETTE) {
+			Vector3iUtil::sort_min_max(src_min, src_max);
+			clip_copy_region(src_min, src_max, _size, dst_min, dst_size);
+			Vector3i pos;
+			for (pos.z = src_min.z; pos.z < src_max.z; ++pos.z) {
+				for (pos.x = src_min.x; pos.x < src_max.x; ++pos.x) {
+					pos.y = src_min.y;
+					size_t src_i = get_index(pos.x, pos.y, pos.z);
+					size_t dst_i = Vector3iUtil::get_zxy_index(dst_min + pos - src_min, dst_size);
+					for (; pos.y < src_max.y; ++pos.y) {
+						dst[dst_i] = get_palette_voxel(channel, src_i);
+						++src_i;
+						++dst_i;
+					}
+				}
+			}
+
 		} else {
 			Span<const T> src(static_cast<const T *>(channel.data), channel.size_in_bytes / sizeof(T));
 			copy_3d_region_zxy<T>(dst, dst_size, dst_min, src, _size, src_min, src_max);
@@ -435,8 +469,20 @@ public:
 		return Vector3iUtil::get_volume(_size);
 	}
 
+	// Palette-compressed channels are decompressed first.
 	bool get_channel_as_bytes(unsigned int channel_index, Span<uint8_t> &slice);
+	// Fails if the channel is palette-compressed. Use `decompress_channel` or `copy_channel_to_bytes` in that case.
 	bool get_channel_as_bytes_read_only(unsigned int channel_index, Span<const uint8_t> &slice) const;
+	// Same as above, but palette-compressed channels are decoded into `temp`, which the returned slice then points to.
+	// `temp` must outlive the use of `slice`. The buffer itself is not modified, so this is safe to use concurrently.
+	bool get_channel_as_bytes_read_only(
+			unsigned int channel_index,
+			Span<const uint8_t> &slice,
+			StdVector<uint8_t> &temp
+	) const;
+	// Writes all values of the channel in raw form, regardless of its compression.
+	// `dst` must have the size returned by `get_size_in_bytes_for_volume`.
+	void copy_channel_to_bytes(unsigned int channel_index, Span<uint8_t> dst) const;
 
 	template <typename T>
 	bool get_channel_data(unsigned int channel_index, Span<T> &dst) {
@@ -454,6 +500,14 @@ public:
 		return true;
 	}
 
+	template <typename T>
+	bool get_channel_data_read_only(unsigned int channel_index, Span<const T> &dst, StdVector<uint8_t> &temp) const {
+		Span<const uint8_t> dst8;
+		ZN_ASSERT_RETURN_V(get_channel_as_bytes_read_only(channel_index, dst8, temp), false);
+		dst = dst8.reinterpret_cast_to<const T>();
+		return true;
+	}
+
 	void downscale_to(VoxelBuffer &dst, Vector3i src_min, Vector3i src_max, Vector3i dst_min) const;
 
 	bool equals(const VoxelBuffer &p_other) const;
@@ -525,7 +579,11 @@ private:
 	void compress_if_uniform(Channel &channel);
 	static void delete_channel(Channel &channel, Allocator allocator);
 	static void clear_channel(Channel &channel, uint64_t clear_value, Allocator allocator);
-	static bool is_uniform(const Channel &channel);
+	bool is_uniform(const Channel &channel) const;
+	static uint64_t get_palette_voxel(const Channel &channel, size_t voxel_index);
+	// Returns false if the palette was full and the channel had to be decompressed instead.
+	bool set_palette_voxel(Channel &channel, size_t voxel_index, uint64_t value);
+	void decompress_palette(Channel &channel);
 
 private:
 	// Each channel can store arbitrary data.
@@ -62,7 +62,7 @@ void op_buffer_value_f(
 template <typename F>
 void op_buffer_buffer_f(
 		VoxelBuffer &dst,
-		const VoxelBuffer &src,
+		VoxelBuffer &src,
 		VoxelBuffer::ChannelId channel,
 		F f // (float a, float b) -> float
 ) {
@@ -76,11 +76,14 @@ void op_buffer_buffer_f(
 		dst.decompress_channel(channel);
 	}
 
+	// Only used if the source channel is palette-compressed
+	StdVector<uint8_t> decoded_src;
+
 	switch (src.get_channel_depth(channel)) {
 		case VoxelBuffer::DEPTH_8_BIT: {
 			Span<const int8_t> src_data;
 			Span<int8_t> dst_data;
-			ZN_ASSERT(src.get_channel_data_read_only(channel, src_data));
+			ZN_ASSERT(src.get_channel_data_read_only(channel, src_data, decoded_src));
 			ZN_ASSERT(dst.get_channel_data(channel, dst_data));
 			for (unsigned int i = 0; i < src_data.size(); ++i) {
 				const float a = s8_to_snorm(dst_data[i]) * constants::QUANTIZED_SDF_8_BITS_SCALE_INV;
@@ -92,7 +95,7 @@ void op_buffer_buffer_f(
 		case VoxelBuffer::DEPTH_16_BIT: {
 			Span<const int16_t> src_data;
 			Span<int16_t> dst_data;
-			ZN_ASSERT(src.get_channel_data_read_only(channel, src_data));
+			ZN_ASSERT(src.get_channel_data_read_only(channel, src_data, decoded_src));
 			ZN_ASSERT(dst.get_channel_data(channel, dst_data));
 			for (unsigned int i = 0; i < src_data.size(); ++i) {
 				const float a = s16_to_snorm(dst_data[i]) * constants::QUANTIZED_SDF_16_BITS_SCALE_INV;
@@ -104,7 +107,7 @@ void op_buffer_buffer_f(
 		case VoxelBuffer::DEPTH_32_BIT: {
 			Span<const float> src_data;
 			Span<float> dst_data;
-			ZN_ASSERT(src.get_channel_data_read_only(channel, src_data));
+			ZN_ASSERT(src.get_channel_data_read_only(channel, src_data, decoded_src));
 			ZN_ASSERT(dst.get_channel_data(channel, dst_data));
 			for (unsigned int i = 0; i < src_data.size(); ++i) {
 				dst_data[i] = f(dst_data[i], src_data[i]);
@@ -222,6 +225,10 @@ void VoxelBuffer::compress_uniform_channels() {
 	_buffer->compress_uniform_channels();
 }
 
+void VoxelBuffer::compress_palette_channels() {
+	_buffer->compress_palette_channels();
+}
+
 VoxelBuffer::Compression VoxelBuffer::get_channel_compression(int channel_index) const {
 	ERR_FAIL_INDEX_V(channel_index, MAX_CHANNELS, VoxelBuffer::COMPRESSION_NONE);
 	return VoxelBuffer::Compression(_buffer->get_channel_compression(channel_index));
@@ -420,8 +427,10 @@ void VoxelBuffer::op_select_less_src_f_dst_i_values(
 		} else {
 			dst.decompress_channel(dst_channel);
 
+			// Only used if the source channel is palette-compressed
+			StdVector<uint8_t> decoded_src;
 			Span<const float> src_data;
-			src.get_channel_data_read_only(src_channel, src_data);
+			src.get_channel_data_read_only(src_channel, src_data, decoded_src);
 
 			Span<uint16_t> dst_data;
 			dst.get_channel_data(dst_channel, dst_data);
@@ -680,6 +689,7 @@ void VoxelBuffer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("is_uniform", "channel"), &VoxelBuffer::is_uniform);
 	ClassDB::bind_method(D_METHOD("optimize"), &VoxelBuffer::_b_deprecated_optimize);
 	ClassDB::bind_method(D_METHOD("compress_uniform_channels"), &VoxelBuffer::compress_uniform_channels);
+	ClassDB::bind_method(D_METHOD("compress_palette_channels"), &VoxelBuffer::compress_palette_channels);
 	ClassDB::bind_method(D_METHOD("get_channel_compression", "channel"), &VoxelBuffer::get_channel_compression);
 	ClassDB::bind_method(D_METHOD("decompress_channel", "channel"), &VoxelBuffer::decompress_channel);
 
@@ -743,6 +753,7 @@ void VoxelBuffer::_bind_methods() {
 
 	BIND_ENUM_CONSTANT(COMPRESSION_NONE);
 	BIND_ENUM_CONSTANT(COMPRESSION_UNIFORM);
+	BIND_ENUM_CONSTANT(COMPRESSION_PALETTE);
 	BIND_ENUM_CONSTANT(COMPRESSION_COUNT);
 
 	BIND_ENUM_CONSTANT(ALLOCATOR_DEFAULT);
@@ -43,6 +43,7 @@ public:
 	enum Compression {
 		COMPRESSION_NONE = zylann::voxel::VoxelBuffer::COMPRESSION_NONE,
 		COMPRESSION_UNIFORM = zylann::voxel::VoxelBuffer::COMPRESSION_UNIFORM,
+		COMPRESSION_PALETTE = zylann::voxel::VoxelBuffer::COMPRESSION_PALETTE,
 		// COMPRESSION_RLE,
 		COMPRESSION_COUNT = zylann::voxel::VoxelBuffer::COMPRESSION_COUNT
 	};
@@ -139,6 +140,7 @@ public:
 	bool is_uniform(int channel_index) const;
 
 	void compress_uniform_channels();
+	void compress_palette_channels();
 	Compression get_channel_compression(int channel_index) const;
 	void decompress_channel(int channel_index);
 
@@ -87,6 +87,8 @@ void VoxelData::reset_maps() {
 }
 
 void VoxelData::reset_maps_no_settings_lock() {
+	invalidate_modified_areas_log();
+
 	for (unsigned int lod_index = 0; lod_index < _lods.size(); ++lod_index) {
 		Lod &data_lod = _lods[lod_index];
 
@@ -111,8 +113,12 @@ void VoxelData::set_bounds(Box3i bounds) {
 }
 
 void VoxelData::set_generator(Ref<VoxelGenerator> generator) {
-	MutexLock wlock(_settings_mutex);
-	_generator = generator;
+	{
+		MutexLock wlock(_settings_mutex);
+		_generator = generator;
+	}
+	// Voxels of areas without edited blocks come from the generator
+	invalidate_modified_areas_log();
 }
 
 void VoxelData::set_stream(Ref<VoxelStream> stream) {
@@ -624,6 +630,8 @@ void VoxelData::clear_cached_blocks_in_voxel_area(Box3i p_voxel_box) {
 			block->clear_voxels();
 		});
 	}
+
+	add_modified_area_to_log(p_voxel_box);
 }
 
 void VoxelData::mark_area_modified(
@@ -671,6 +679,43 @@ void VoxelData::mark_area_modified(
 			}
 		});
 	}
+
+	add_modified_area_to_log(p_voxel_box);
+}
+
+void VoxelData::add_modified_area_to_log(Box3i voxel_box) {
+	MutexLock mlock(_modified_areas_log_mutex);
+	_modified_areas_log[_modification_count % MODIFIED_AREAS_LOG_SIZE] = voxel_box;
+	++_modification_count;
+}
+
+void VoxelData::add_blocks_to_modified_areas_log(Box3i lod0_blocks_box) {
+	const int block_size = get_block_size();
+	add_modified_area_to_log(Box3i(lod0_blocks_box.position * block_size, lod0_blocks_box.size * block_size));
+}
+
+void VoxelData::invalidate_modified_areas_log() {
+	MutexLock mlock(_modified_areas_log_mutex);
+	// Readers consider everything as modified when more entries were added than the log can hold
+	_modification_count += MODIFIED_AREAS_LOG_SIZE + 1;
+}
+
+uint64_t VoxelData::get_modification_count() const {
+	MutexLock mlock(_modified_areas_log_mutex);
+	return _modification_count;
+}
+
+bool VoxelData::get_modified_areas_since(uint64_t &inout_count, StdVector<Box3i> &out_voxel_boxes) const {
+	MutexLock mlock(_modified_areas_log_mutex);
+	const uint64_t since_count = inout_count;
+	inout_count = _modification_count;
+	if (since_count > _modification_count || _modification_count - since_count > MODIFIED_AREAS_LOG_SIZE) {
+		return false;
+	}
+	for (uint64_t i = since_count; i < _modification_count; ++i) {
+		out_voxel_boxes.push_back(_modified_areas_log[i % MODIFIED_AREAS_LOG_SIZE]);
+	}
+	return true;
 }
 
 bool VoxelData::try_set_block(Vector3i block_position, const VoxelDataBlock &block) {
@@ -913,16 +958,21 @@ void VoxelData::update_lods(Span<const Vector3i> modified_lod0_blocks, StdVector
 
 void VoxelData::unload_blocks(Box3i bbox, unsigned int lod_index, StdVector<BlockToSave> *to_save) {
 	Lod &lod = _lods[lod_index];
-	SpatialLock3D::Write swlock(lod.spatial_lock, bbox);
-	RWLockWrite wlock(lod.map_lock);
-	if (to_save == nullptr) {
-		bbox.for_each_cell_zxy([&lod](Vector3i bpos) { //
-			lod.map.remove_block(bpos, VoxelDataMap::NoAction());
-		});
-	} else {
-		bbox.for_each_cell_zxy([&lod, lod_index, to_save](Vector3i bpos) {
-			lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, lod_index });
-		});
+	{
+		SpatialLock3D::Write swlock(lod.spatial_lock, bbox);
+		RWLockWrite wlock(lod.map_lock);
+		if (to_save == nullptr) {
+			bbox.for_each_cell_zxy([&lod](Vector3i bpos) { //
+				lod.map.remove_block(bpos, VoxelDataMap::NoAction());
+			});
+		} else {
+			bbox.for_each_cell_zxy([&lod, lod_index, to_save](Vector3i bpos) {
+				lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, lod_index });
+			});
+		}
+	}
+	if (lod_index == 0) {
+		add_blocks_to_modified_areas_log(bbox);
 	}
 }
 
@@ -1145,32 +1195,40 @@ void VoxelData::unview_area(
 
 	Lod &lod = _lods[lod_index];
 
-	// Locking for write because we are modifying states on blocks.
-	// TODO Could use atomics if contention is too much? However if we do, we need to ensure no other thread is holding
-	// a pointer to any of the blocks we could remove.
-	SpatialLock3D::Write swlock(lod.spatial_lock, blocks_box);
+	bool any_removed = false;
+	{
+		// Locking for write because we are modifying states on blocks.
+		// TODO Could use atomics if contention is too much? However if we do, we need to ensure no other thread is
+		// holding a pointer to any of the blocks we could remove.
+		SpatialLock3D::Write swlock(lod.spatial_lock, blocks_box);
 
-	// Locking for write because we are potentially going to remove blocks from the map.
-	RWLockWrite wlock(lod.map_lock);
+		// Locking for write because we are potentially going to remove blocks from the map.
+		RWLockWrite wlock(lod.map_lock);
 
-	blocks_box.for_each_cell_zxy([&lod, missing_blocks, removed_blocks, to_save](Vector3i bpos) {
-		VoxelDataBlock *block = lod.map.get_block(bpos);
-		if (block != nullptr) {
-			block->viewers.remove();
-			if (block->viewers.get() == 0) {
-				if (to_save == nullptr) {
-					lod.map.remove_block(bpos, VoxelDataMap::NoAction());
-				} else {
-					lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, 0 });
-				}
-				if (removed_blocks != nullptr) {
-					removed_blocks->push_back(bpos);
+		blocks_box.for_each_cell_zxy([&lod, missing_blocks, removed_blocks, to_save, &any_removed](Vector3i bpos) {
+			VoxelDataBlock *block = lod.map.get_block(bpos);
+			if (block != nullptr) {
+				block->viewers.remove();
+				if (block->viewers.get() == 0) {
+					if (to_save == nullptr) {
+						lod.map.remove_block(bpos, VoxelDataMap::NoAction());
+					} else {
+						lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, 0 });
+					}
+					if (removed_blocks != nullptr) {
+						removed_blocks->push_back(bpos);
+					}
+					any_removed = true;
 				}
+			} else if (missing_blocks != nullptr) {
+				missing_blocks->push_back(bpos);
 			}
-		} else if (missing_blocks != nullptr) {
-			missing_blocks->push_back(bpos);
-		}
-	});
+		});
+	}
+
+	if (any_removed && lod_index == 0) {
+		add_blocks_to_modified_areas_log(blocks_box);
+	}
 }
 
 std::shared_ptr<VoxelBuffer> VoxelData::try_get_block_voxels(Vector3i bpos) {
@@ -155,6 +155,14 @@ public:
 	// Optionally, returns a list of affected block positions which did not require LOD updates before.
 	void mark_area_modified(Box3i p_voxel_box, StdVector<Vector3i> *lod0_new_blocks_to_lod, bool require_lod_updates);
 
+	// Areas marked as modified are also kept in a short log, so systems caching information derived from voxels can
+	// find which parts became outdated. Blocks of LOD0 getting set or unloaded are logged too.
+	uint64_t get_modification_count() const;
+	// Gets voxel boxes of areas modified since `inout_count`, and updates it to the current count.
+	// Returns false if too many modifications occurred since then for the log to have them all. In that case, callers
+	// should consider everything as modified.
+	bool get_modified_areas_since(uint64_t &inout_count, StdVector<Box3i> &out_voxel_boxes) const;
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Block-aware API
 
@@ -174,15 +182,23 @@ public:
 			ZN_ASSERT(block.get_voxels_const().get_size() == Vector3iUtil::create(get_block_size()));
 		}
 #endif
-		RWLockWrite wlock(lod.map_lock);
-		VoxelDataBlock *existing_block = lod.map.get_block(block_position);
-		if (existing_block != nullptr) {
-			action_when_exists(*existing_block, block);
-			return false;
-		} else {
-			lod.map.set_block(block_position, block);
-			return true;
+		bool inserted;
+		{
+			RWLockWrite wlock(lod.map_lock);
+			VoxelDataBlock *existing_block = lod.map.get_block(block_position);
+			if (existing_block != nullptr) {
+				action_when_exists(*existing_block, block);
+				inserted = false;
+			} else {
+				lod.map.set_block(block_position, block);
+				inserted = true;
+			}
+		}
+		if (block.get_lod_index() == 0) {
+			// Voxels read there can differ now. If the block existed, `action_when_exists` may have changed it too.
+			add_blocks_to_modified_areas_log(Box3i(block_position, Vector3i(1, 1, 1)));
 		}
+		return inserted;
 	}
 
 	template <typename F>
@@ -346,6 +362,10 @@ public:
 
 private:
 	void reset_maps_no_settings_lock();
+	void add_modified_area_to_log(Box3i voxel_box);
+	void add_blocks_to_modified_areas_log(Box3i lod0_blocks_box);
+	// Makes readers of the log consider everything as modified
+	void invalidate_modified_areas_log();
 
 	struct Lod {
 		// Storage for edited and cached voxels.
@@ -448,6 +468,13 @@ private:
 	// There are times where locking can take longer, but it only happens rarely, when changing LOD count for
 	// example.
 	Mutex _settings_mutex;
+
+	// Ring buffer of the last modified areas, in voxels. Loading blocks adds one entry per block, so it is large enough
+	// to not overflow too often when terrain streams around.
+	static const unsigned int MODIFIED_AREAS_LOG_SIZE = 256;
+	FixedArray<Box3i, MODIFIED_AREAS_LOG_SIZE> _modified_areas_log;
+	uint64_t _modification_count = 0;
+	Mutex _modified_areas_log_mutex;
 };
 
 } // namespace zylann::voxel
@@ -7,10 +7,31 @@
 #include "../util/memory/memory.h"
 #include "../util/string/format.h"
 
+#include <algorithm>
+#include <functional>
 #include <limits>
 
 namespace zylann::voxel {
 
+namespace {
+
+// Returns an index in a table of `1 << capacity_po2` entries.
+inline uint32_t hash_block_position(Vector3i bpos, uint32_t capacity_po2) {
+	// Coordinates are packed into 64 bits, which tells apart blocks within a million blocks from the origin. Blocks
+	// further away can hash the same, but are still told apart by comparing positions.
+	const uint64_t mask = (1 << 21) - 1;
+	const uint64_t packed = (uint64_t(uint32_t(bpos.x)) & mask) | ((uint64_t(uint32_t(bpos.y)) & mask) << 21) |
+			((uint64_t(uint32_t(bpos.z)) & mask) << 42);
+	// Fibonacci hashing. High bits are the best mixed, so we keep as many of them as the capacity needs.
+	return uint32_t((packed * 0x9e3779b97f4a7c15ull) >> (64 - capacity_po2));
+}
+
+inline uint32_t get_probe_distance(Vector3i bpos, uint32_t entry_index, uint32_t capacity_po2, uint32_t mask) {
+	return (entry_index - hash_block_position(bpos, capacity_po2)) & mask;
+}
+
+} // namespace
+
 VoxelDataMap::VoxelDataMap() {
 	// This is not planned to change at runtime at the moment.
 	// set_block_size_pow2(constants::DEFAULT_BLOCK_SIZE_PO2);
@@ -63,7 +84,7 @@ VoxelDataBlock *VoxelDataMap::create_default_block(Vector3i bpos) {
 #ifdef DEBUG_ENABLED
 	ZN_ASSERT_RETURN_V(!has_block(bpos), nullptr);
 #endif
-	VoxelDataBlock &map_block = _blocks_map[bpos];
+	VoxelDataBlock &map_block = get_or_add_block(bpos);
 	map_block = VoxelDataBlock(buffer, _lod_index);
 	return &map_block;
 }
@@ -106,28 +127,224 @@ void VoxelDataMap::set_voxel_f(real_t value, Vector3i pos, unsigned int c) {
 }
 
 VoxelDataBlock *VoxelDataMap::get_block(Vector3i bpos) {
-	auto it = _blocks_map.find(bpos);
-	if (it != _blocks_map.end()) {
-		return &it->second;
+	const uint32_t entry_index = find_index_entry(bpos);
+	if (entry_index != NULL_INDEX) {
+		return &get_slot(_index[entry_index].slot_index).block;
 	}
 	return nullptr;
 }
 
 const VoxelDataBlock *VoxelDataMap::get_block(Vector3i bpos) const {
-	auto it = _blocks_map.find(bpos);
-	if (it != _blocks_map.end()) {
-		return &it->second;
+	const uint32_t entry_index = find_index_entry(bpos);
+	if (entry_index != NULL_INDEX) {
+		return &get_slot(_index[entry_index].slot_index).block;
 	}
 	return nullptr;
 }
 
+bool VoxelDataMap::try_get_block_handle(Vector3i bpos, BlockHandle &out_handle) const {
+	const uint32_t entry_index = find_index_entry(bpos);
+	if (entry_index == NULL_INDEX) {
+		return false;
+	}
+	const uint32_t slot_index = _index[entry_index].slot_index;
+	out_handle = BlockHandle{ slot_index, get_slot(slot_index).version };
+	return true;
+}
+
+VoxelDataBlock *VoxelDataMap::get_block(BlockHandle handle) {
+	if (handle.index >= _slot_count) {
+		return nullptr;
+	}
+	Slot &slot = get_slot(handle.index);
+	if (slot.version != handle.version) {
+		return nullptr;
+	}
+	return &slot.block;
+}
+
+const VoxelDataBlock *VoxelDataMap::get_block(BlockHandle handle) const {
+	if (handle.index >= _slot_count) {
+		return nullptr;
+	}
+	const Slot &slot = get_slot(handle.index);
+	if (slot.version != handle.version) {
+		return nullptr;
+	}
+	return &slot.block;
+}
+
+VoxelDataBlock &VoxelDataMap::get_or_add_block(Vector3i bpos) {
+	const uint32_t entry_index = find_index_entry(bpos);
+	if (entry_index != NULL_INDEX) {
+		return get_slot(_index[entry_index].slot_index).block;
+	}
+	const uint32_t slot_index = allocate_slot(bpos);
+	add_index_entry(IndexEntry{ bpos, slot_index });
+	return get_slot(slot_index).block;
+}
+
+uint32_t VoxelDataMap::allocate_slot(Vector3i bpos) {
+	uint32_t slot_index;
+	if (_free_slots.size() > 0) {
+		// Reuse the lowest free slot, so the last pages end up empty when many blocks get removed, and can be released
+		std::pop_heap(_free_slots.begin(), _free_slots.end(), std::greater<uint32_t>());
+		slot_index = _free_slots.back();
+		_free_slots.pop_back();
+		get_slot(slot_index).version.make_valid();
+	} else {
+		slot_index = _slot_count;
+		if ((slot_index >> SLOTS_PER_PAGE_PO2) == _pages.size()) {
+			_pages.push_back(make_unique_instance<Page>());
+		}
+		++_slot_count;
+		get_slot(slot_index).version.value = _new_slot_version;
+	}
+	get_slot(slot_index).position = bpos;
+	++_pages[slot_index >> SLOTS_PER_PAGE_PO2]->used_slot_count;
+	return slot_index;
+}
+
+void VoxelDataMap::free_slot(uint32_t slot_index) {
+	Slot &slot = get_slot(slot_index);
+	// Release voxels now rather than when the slot gets reused
+	slot.block = VoxelDataBlock();
+	slot.version.make_invalid();
+	_free_slots.push_back(slot_index);
+	std::push_heap(_free_slots.begin(), _free_slots.end(), std::greater<uint32_t>());
+
+	const uint32_t page_index = slot_index >> SLOTS_PER_PAGE_PO2;
+	Page &page = *_pages[page_index];
+	--page.used_slot_count;
+	if (page.used_slot_count == 0 && page_index == _pages.size() - 1) {
+		release_empty_pages();
+	}
+}
+
+void VoxelDataMap::release_empty_pages() {
+	ZN_PROFILE_SCOPE();
+
+	// Only the last pages can be released, other pages must stay where they are
+	while (_pages.size() > 0 && _pages.back()->used_slot_count == 0) {
+		for (const Slot &slot : _pages.back()->slots) {
+			// These slots may be created again later. Their version must not be one that handles may still refer to.
+			_new_slot_version = math::max(_new_slot_version, slot.version.value & SlotMapVersion<uint32_t>::MASK);
+		}
+		_pages.pop_back();
+	}
+
+	_slot_count = math::min(_slot_count, uint32_t(_pages.size()) << SLOTS_PER_PAGE_PO2);
+
+	const uint32_t slot_count = _slot_count;
+	_free_slots.erase(
+			std::remove_if(
+					_free_slots.begin(),
+					_free_slots.end(),
+					[slot_count](uint32_t slot_index) { return slot_index >= slot_count; }
+			),
+			_free_slots.end()
+	);
+	std::make_heap(_free_slots.begin(), _free_slots.end(), std::greater<uint32_t>());
+}
+
+uint32_t VoxelDataMap::find_index_entry(Vector3i bpos) const {
+	if (_block_count == 0) {
+		return NULL_INDEX;
+	}
+	const uint32_t mask = _index.size() - 1;
+	uint32_t entry_index = hash_block_position(bpos, _index_capacity_po2);
+	for (uint32_t distance = 0;; ++distance) {
+		const IndexEntry &entry = _index[entry_index];
+		if (entry.slot_index == NULL_INDEX) {
+			return NULL_INDEX;
+		}
+		if (entry.position == bpos) {
+			return entry_index;
+		}
+		// With Robin Hood probing, entries are sorted by distance to their ideal position along the probe sequence. If
+		// we are further than the current one, the position can't be found beyond.
+		if (distance > get_probe_distance(entry.position, entry_index, _index_capacity_po2, mask)) {
+			return NULL_INDEX;
+		}
+		entry_index = (entry_index + 1) & mask;
+	}
+}
+
+void VoxelDataMap::add_index_entry(IndexEntry entry) {
+	// Keep the load factor under 3/4 so probe sequences remain short
+	if ((_block_count + 1) * 4 > _index.size() * 3) {
+		rehash_index(math::max(uint32_t(_index.size()) * 2, MIN_INDEX_CAPACITY));
+	}
+
+	const uint32_t mask = _index.size() - 1;
+	uint32_t entry_index = hash_block_position(entry.position, _index_capacity_po2);
+	uint32_t distance = 0;
+	while (true) {
+		IndexEntry &other = _index[entry_index];
+		if (other.slot_index == NULL_INDEX) {
+			other = entry;
+			break;
+		}
+		// Take the place of entries closer to their ideal position than we are, and carry on with them instead
+		const uint32_t other_distance = get_probe_distance(other.position, entry_index, _index_capacity_po2, mask);
+		if (other_distance < distance) {
+			std::swap(other, entry);
+			distance = other_distance;
+		}
+		entry_index = (entry_index + 1) & mask;
+		++distance;
+	}
+	++_block_count;
+}
+
+void VoxelDataMap::remove_index_entry(uint32_t entry_index) {
+	// Shift back following entries, so lookups don't need tombstones
+	const uint32_t mask = _index.size() - 1;
+	uint32_t next_index = (entry_index + 1) & mask;
+	while (true) {
+		const IndexEntry &next = _index[next_index];
+		if (next.slot_index == NULL_INDEX ||
+			get_probe_distance(next.position, next_index, _index_capacity_po2, mask) == 0) {
+			break;
+		}
+		_index[entry_index] = next;
+		entry_index = next_index;
+		next_index = (next_index + 1) & mask;
+	}
+	_index[entry_index].slot_index = NULL_INDEX;
+	--_block_count;
+
+	// Shrink when mostly empty, after many blocks were unloaded. The load factor is then 1/4 at most, far enough from
+	// the growth threshold.
+	if (_index.size() > MIN_INDEX_CAPACITY && _block_count * 8 < _index.size()) {
+		rehash_index(_index.size() / 2);
+	}
+}
+
+void VoxelDataMap::rehash_index(uint32_t capacity) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT(math::is_power_of_two(capacity));
+
+	StdVector<IndexEntry> old_index;
+	old_index.swap(_index);
+	_index.resize(capacity, IndexEntry{ Vector3i(), NULL_INDEX });
+	_index_capacity_po2 = math::get_shift_from_power_of_two_32(capacity);
+	_block_count = 0;
+
+	for (const IndexEntry &entry : old_index) {
+		if (entry.slot_index != NULL_INDEX) {
+			add_index_entry(entry);
+		}
+	}
+}
+
 VoxelDataBlock *VoxelDataMap::set_block_buffer(Vector3i bpos, std::shared_ptr<VoxelBuffer> &buffer, bool overwrite) {
 	ZN_ASSERT_RETURN_V(buffer != nullptr, nullptr);
 
 	VoxelDataBlock *block = get_block(bpos);
 
 	if (block == nullptr) {
-		VoxelDataBlock &map_block = _blocks_map[bpos];
+		VoxelDataBlock &map_block = get_or_add_block(bpos);
 		map_block = VoxelDataBlock(buffer, _lod_index);
 		block = &map_block;
 
@@ -148,14 +365,14 @@ void VoxelDataMap::set_block(Vector3i bpos, const VoxelDataBlock &block) {
 #ifdef DEBUG_ENABLED
 	ZN_ASSERT(block.get_lod_index() == _lod_index);
 #endif
-	_blocks_map[bpos] = block;
+	get_or_add_block(bpos) = block;
 }
 
 VoxelDataBlock *VoxelDataMap::set_empty_block(Vector3i bpos, bool overwrite) {
 	VoxelDataBlock *block = get_block(bpos);
 
 	if (block == nullptr) {
-		VoxelDataBlock &map_block = _blocks_map[bpos];
+		VoxelDataBlock &map_block = get_or_add_block(bpos);
 		map_block = VoxelDataBlock(_lod_index);
 		block = &map_block;
 
@@ -173,7 +390,7 @@ VoxelDataBlock *VoxelDataMap::set_empty_block(Vector3i bpos, bool overwrite) {
 }
 
 bool VoxelDataMap::has_block(Vector3i pos) const {
-	return _blocks_map.find(pos) != _blocks_map.end();
+	return find_index_entry(pos) != NULL_INDEX;
 }
 
 bool VoxelDataMap::is_block_surrounded(Vector3i pos) const {
@@ -372,11 +589,16 @@ void VoxelDataMap::paste_masked( //
 }
 
 void VoxelDataMap::clear() {
-	_blocks_map.clear();
+	_pages.clear();
+	_free_slots.clear();
+	_slot_count = 0;
+	_index.clear();
+	_index_capacity_po2 = 0;
+	_block_count = 0;
 }
 
 int VoxelDataMap::get_block_count() const {
-	return _blocks_map.size();
+	return _block_count;
 }
 
 bool VoxelDataMap::is_area_fully_loaded(const Box3i voxels_box) const {
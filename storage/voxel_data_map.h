@@ -3,9 +3,11 @@
 
 #include "../constants/voxel_constants.h"
 #include "../util/containers/fixed_array.h"
+#include "../util/containers/slot_map.h"
 #include "../util/containers/span.h"
-#include "../util/containers/std_unordered_map.h"
+#include "../util/containers/std_vector.h"
 #include "../util/math/box3i.h"
+#include "../util/memory/memory.h"
 #include "../util/profiling.h"
 #include "voxel_buffer.h" // Used in template methods
 #include "voxel_data_block.h"
@@ -111,16 +113,27 @@ public:
 
 	template <typename Action_T>
 	void remove_block(Vector3i bpos, Action_T pre_delete) {
-		auto it = _blocks_map.find(bpos);
-		if (it != _blocks_map.end()) {
-			pre_delete(it->second);
-			_blocks_map.erase(it);
+		const uint32_t entry_index = find_index_entry(bpos);
+		if (entry_index != NULL_INDEX) {
+			const uint32_t slot_index = _index[entry_index].slot_index;
+			pre_delete(get_slot(slot_index).block);
+			remove_index_entry(entry_index);
+			free_slot(slot_index);
 		}
 	}
 
 	VoxelDataBlock *get_block(Vector3i bpos);
 	const VoxelDataBlock *get_block(Vector3i bpos) const;
 
+	// Identifies a block without having to hash its position. Handles of removed blocks are never reused, so they can
+	// be kept around and checked later.
+	typedef SlotMapKey<uint32_t, uint32_t> BlockHandle;
+
+	bool try_get_block_handle(Vector3i bpos, BlockHandle &out_handle) const;
+	// Returns null if the block was removed
+	VoxelDataBlock *get_block(BlockHandle handle);
+	const VoxelDataBlock *get_block(BlockHandle handle) const;
+
 	bool has_block(Vector3i pos) const;
 	bool is_block_surrounded(Vector3i pos) const;
 
@@ -128,27 +141,38 @@ public:
 
 	int get_block_count() const;
 
+	// Blocks are visited in storage order, which is not related to their position.
+
 	// op(Vector3i bpos)
 	template <typename Op_T>
 	inline void for_each_block_position(Op_T op) const {
-		for (auto it = _blocks_map.begin(); it != _blocks_map.end(); ++it) {
-			op(it->first);
+		for (uint32_t slot_index = 0; slot_index < _slot_count; ++slot_index) {
+			const Slot &slot = get_slot(slot_index);
+			if (slot.version.is_valid()) {
+				op(slot.position);
+			}
 		}
 	}
 
 	// op(Vector3i bpos, VoxelDataBlock &block)
 	template <typename Op_T>
 	inline void for_each_block(Op_T op) {
-		for (auto it = _blocks_map.begin(); it != _blocks_map.end(); ++it) {
-			op(it->first, it->second);
+		for (uint32_t slot_index = 0; slot_index < _slot_count; ++slot_index) {
+			Slot &slot = get_slot(slot_index);
+			if (slot.version.is_valid()) {
+				op(slot.position, slot.block);
+			}
 		}
 	}
 
 	// void op(Vector3i bpos, const VoxelDataBlock &block)
 	template <typename Op_T>
 	inline void for_each_block(Op_T op) const {
-		for (auto it = _blocks_map.begin(); it != _blocks_map.end(); ++it) {
-			op(it->first, it->second);
+		for (uint32_t slot_index = 0; slot_index < _slot_count; ++slot_index) {
+			const Slot &slot = get_slot(slot_index);
+			if (slot.version.is_valid()) {
+				op(slot.position, slot.block);
+			}
 		}
 	}
 
@@ -206,19 +230,75 @@ public:
 	}
 
 private:
+	static const uint32_t NULL_INDEX = 0xffffffff;
+	static const unsigned int SLOTS_PER_PAGE_PO2 = 8;
+	static const unsigned int SLOTS_PER_PAGE = 1 << SLOTS_PER_PAGE_PO2;
+	static const unsigned int SLOTS_PER_PAGE_MASK = SLOTS_PER_PAGE - 1;
+	static const uint32_t MIN_INDEX_CAPACITY = 64;
+
+	struct Slot {
+		VoxelDataBlock block;
+		Vector3i position;
+		SlotMapVersion<uint32_t> version;
+	};
+
+	struct Page {
+		FixedArray<Slot, SLOTS_PER_PAGE> slots;
+		uint32_t used_slot_count = 0;
+	};
+
+	struct IndexEntry {
+		Vector3i position;
+		// NULL_INDEX if the entry is empty
+		uint32_t slot_index;
+	};
+
 	// void set_block(Vector3i bpos, VoxelDataBlock *block);
 	VoxelDataBlock *get_or_create_block_at_voxel_pos(Vector3i pos);
 	VoxelDataBlock *create_default_block(Vector3i bpos);
+	// Returns the existing block, or adds a default one
+	VoxelDataBlock &get_or_add_block(Vector3i bpos);
+
+	inline Slot &get_slot(uint32_t slot_index) {
+		return _pages[slot_index >> SLOTS_PER_PAGE_PO2]->slots[slot_index & SLOTS_PER_PAGE_MASK];
+	}
+
+	inline const Slot &get_slot(uint32_t slot_index) const {
+		return _pages[slot_index >> SLOTS_PER_PAGE_PO2]->slots[slot_index & SLOTS_PER_PAGE_MASK];
+	}
+
+	uint32_t allocate_slot(Vector3i bpos);
+	void free_slot(uint32_t slot_index);
+	void release_empty_pages();
+
+	uint32_t find_index_entry(Vector3i bpos) const;
+	void add_index_entry(IndexEntry entry);
+	void remove_index_entry(uint32_t entry_index);
+	void rehash_index(uint32_t capacity);
 
 	// void set_block_size_pow2(unsigned int p);
 
 private:
-	// Blocks stored with a spatial hash in all 3D directions.
-	// Before I used Godot 3's HashMap with RELATIONSHIP = 2 because that delivers better performance compared to
-	// defaults, but it sometimes has very long stalls on removal, which std::unordered_map doesn't seem to have
-	// (not as badly). Also overall performance is slightly better.
-	// Note: pointers to elements remain valid when inserting or removing others (only iterators may be invalidated)
-	StdUnorderedMap<Vector3i, VoxelDataBlock> _blocks_map;
+	// Blocks are stored in pages of slots. Pages are never moved, so pointers to blocks remain valid when inserting or
+	// removing others (only the ones removed become invalid). Some code relies on this, because blocks are accessed
+	// under spatial locks while other threads may modify the map. Removed slots get reused by the next added blocks,
+	// so iterating them stays mostly dense.
+	// Before I used StdUnorderedMap, and before that Godot 3's HashMap, but their nodes are allocated individually and
+	// iterating them is slow when there are many.
+	// When the last pages become empty, they are released.
+	StdVector<UniquePtr<Page>> _pages;
+	// Min-heap, so the lowest free slots are reused first
+	StdVector<uint32_t> _free_slots;
+	uint32_t _slot_count = 0;
+	// Version given to slots created at the end. Starts at 1 like SlotMap, and goes up when slots are released so
+	// handles to them can't match slots created again at the same index.
+	uint32_t _new_slot_version = 1;
+
+	// Open-addressing hash table using Robin Hood probing, mapping block positions to slots. Its size is a power of
+	// two, and shrinks when it gets mostly empty.
+	StdVector<IndexEntry> _index;
+	uint32_t _index_capacity_po2 = 0;
+	uint32_t _block_count = 0;
 
 	// This was a possible optimization in a single-threaded scenario, but it's not in multithread.
 	// We want to be able to do shared read-accesses but this is a mutable variable.
@@ -1,14 +1,71 @@
 #include "voxel_memory_pool.h"
+#include "../util/containers/container_funcs.h"
 #include "../util/macros.h"
 #include "../util/memory/memory.h"
 #include "../util/profiling.h"
 #include "../util/string/format.h"
 #include "../util/string/std_string.h"
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#define ZN_VOXEL_MEMORY_POOL_MMAP
+#endif
+
 namespace zylann::voxel {
 
 namespace {
+
 VoxelMemoryPool *g_memory_pool = nullptr;
+
+// Protects registration of thread caches to pools
+BinaryMutex g_thread_caches_mutex;
+
+// Multiple of the usual huge page size (2 MB), and large enough that the space lost at the end of each arena when the
+// next block doesn't fit remains small
+const size_t ARENA_SIZE = 16 * 1024 * 1024;
+const size_t ARENA_BLOCK_ALIGNMENT = 16;
+
+void update_peak(std::atomic_uint64_t &peak, uint64_t value) {
+	uint64_t prev = peak.load(std::memory_order_relaxed);
+	while (value > prev && !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+	}
+}
+
+uint8_t *allocate_arena_memory(size_t size, bool huge_pages) {
+#ifdef ZN_VOXEL_MEMORY_POOL_MMAP
+	void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if (huge_pages) {
+		// Only succeeds if huge pages were reserved on the system
+		mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+#endif
+	if (mem == MAP_FAILED) {
+		mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mem == MAP_FAILED) {
+			return nullptr;
+		}
+#ifdef MADV_HUGEPAGE
+		if (huge_pages) {
+			// Fallback on transparent huge pages
+			madvise(mem, size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	return static_cast<uint8_t *>(mem);
+#else
+	return static_cast<uint8_t *>(ZN_ALLOC(size));
+#endif
+}
+
+void free_arena_memory(uint8_t *mem, size_t size) {
+#ifdef ZN_VOXEL_MEMORY_POOL_MMAP
+	munmap(mem, size);
+#else
+	ZN_FREE(mem);
+#endif
+}
+
 } // namespace
 
 void VoxelMemoryPool::create_singleton() {
@@ -85,9 +142,28 @@ VoxelMemoryPool &VoxelMemoryPool::get_singleton() {
 	return *g_memory_pool;
 }
 
+VoxelMemoryPool::ThreadCache::~ThreadCache() {
+	// Called when the thread exits
+	MutexLock glock(g_thread_caches_mutex);
+	VoxelMemoryPool *registered_pool = pool.load(std::memory_order_relaxed);
+	if (registered_pool != nullptr) {
+		registered_pool->drain_thread_cache(*this);
+		unordered_remove_value(registered_pool->_thread_caches, this);
+		pool.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
 VoxelMemoryPool::VoxelMemoryPool() {}
 
 VoxelMemoryPool::~VoxelMemoryPool() {
+	{
+		MutexLock glock(g_thread_caches_mutex);
+		for (ThreadCache *cache : _thread_caches) {
+			drain_thread_cache(*cache);
+			cache->pool.store(nullptr, std::memory_order_relaxed);
+		}
+		_thread_caches.clear();
+	}
 #ifdef TOOLS_ENABLED
 	if (is_verbose_output_enabled()) {
 		debug_print();
@@ -96,6 +172,30 @@ VoxelMemoryPool::~VoxelMemoryPool() {
 	clear();
 }
 
+void VoxelMemoryPool::set_thread_caches_enabled(bool enabled) {
+	if (_thread_caches_enabled.exchange(enabled, std::memory_order_relaxed) == enabled) {
+		return;
+	}
+	if (!enabled) {
+		drain_thread_caches();
+	}
+}
+
+bool VoxelMemoryPool::is_thread_caches_enabled() const {
+	return _thread_caches_enabled.load(std::memory_order_relaxed);
+}
+
+void VoxelMemoryPool::set_arenas_enabled(bool enabled, bool huge_pages) {
+	// Blocks allocated before wouldn't be freed properly
+	ZN_ASSERT_RETURN_MSG(_total_memory == 0, "Arenas can't be toggled after blocks have been allocated");
+	_arenas_enabled = enabled;
+	_arenas_use_huge_pages = huge_pages;
+}
+
+bool VoxelMemoryPool::is_arenas_enabled() const {
+	return _arenas_enabled;
+}
+
 uint8_t *VoxelMemoryPool::allocate(size_t size) {
 	ZN_DSTACK();
 	ZN_PROFILE_SCOPE();
@@ -106,12 +206,16 @@ uint8_t *VoxelMemoryPool::allocate(size_t size) {
 	ZN_ASSERT_RETURN_V(size != 0, nullptr);
 
 	uint8_t *block = nullptr;
+	size_t capacity;
 	// Not calculating `pot` immediately because the function we use to calculate it uses 32 bits,
 	// while `size_t` can be larger than that.
 	if (size > get_highest_supported_size()) {
 		// Sorry, memory is not pooled past this size
+		capacity = size;
 		block = (uint8_t *)ZN_ALLOC(size * sizeof(uint8_t));
-		_total_memory += size;
+		if (block != nullptr) {
+			update_peak(_peak_total_memory, _total_memory += size);
+		}
 #ifdef DEBUG_ENABLED
 		if (block != nullptr) {
 			_debug_nonpooled_used_blocks.add(block);
@@ -119,23 +223,26 @@ uint8_t *VoxelMemoryPool::allocate(size_t size) {
 #endif
 	} else {
 		const unsigned int pot = get_pool_index_from_size(size);
-		Pool &pool = _pot_pools[pot];
-		pool.mutex.lock();
-		if (pool.blocks.size() > 0) {
-			block = pool.blocks.back();
-			pool.blocks.pop_back();
-			pool.mutex.unlock();
-		} else {
-			pool.mutex.unlock();
-			ZN_PROFILE_SCOPE_NAMED("new alloc");
-			// All allocations done in this pool have the same size,
-			// which must be greater or equal to `size`
-			const size_t capacity = get_size_from_pool_index(pot);
+		// All allocations done in this pool have the same size,
+		// which must be greater or equal to `size`
+		capacity = get_size_from_pool_index(pot);
 #ifdef DEBUG_ENABLED
-			ZN_ASSERT(capacity >= size);
+		ZN_ASSERT(capacity >= size);
 #endif
-			block = (uint8_t *)ZN_ALLOC(capacity * sizeof(uint8_t));
-			_total_memory += size;
+		Pool &pool = _pot_pools[pot];
+
+		if (_thread_caches_enabled.load(std::memory_order_relaxed) && get_magazine_capacity(pot) > 0) {
+			block = allocate_from_thread_cache(pot);
+		} else {
+			MutexLock lock(pool.mutex);
+			if (pool.blocks.size() > 0) {
+				block = pool.blocks.back();
+				pool.blocks.pop_back();
+			}
+		}
+
+		if (block == nullptr) {
+			block = allocate_new_block(pot);
 		}
 #ifdef DEBUG_ENABLED
 		if (block != nullptr) {
@@ -147,11 +254,103 @@ uint8_t *VoxelMemoryPool::allocate(size_t size) {
 		ZN_PRINT_ERROR("Out of memory");
 	} else {
 		++_used_blocks;
-		_used_memory += size;
+		update_peak(_peak_used_memory, _used_memory += size);
+		_used_capacity += capacity;
+	}
+	return block;
+}
+
+uint8_t *VoxelMemoryPool::allocate_new_block(unsigned int pot) {
+	ZN_PROFILE_SCOPE_NAMED("new alloc");
+	const size_t capacity = get_size_from_pool_index(pot);
+	if (_arenas_enabled) {
+		return allocate_from_arena(capacity);
 	}
+	uint8_t *block = (uint8_t *)ZN_ALLOC(capacity * sizeof(uint8_t));
+	if (block != nullptr) {
+		update_peak(_peak_total_memory, _total_memory += capacity);
+	}
+	return block;
+}
+
+uint8_t *VoxelMemoryPool::allocate_from_arena(size_t capacity) {
+	MutexLock lock(_arenas_mutex);
+
+	_arena_offset = math::alignup(_arena_offset, ARENA_BLOCK_ALIGNMENT);
+
+	if (_arenas.size() == 0 || _arena_offset + capacity > _arenas.back().size) {
+		Arena arena;
+		arena.size = ARENA_SIZE;
+		arena.data = allocate_arena_memory(arena.size, _arenas_use_huge_pages);
+		if (arena.data == nullptr) {
+			return nullptr;
+		}
+		_arenas.push_back(arena);
+		_arena_offset = 0;
+		_arena_memory += arena.size;
+		update_peak(_peak_total_memory, _total_memory += arena.size);
+	}
+
+	uint8_t *block = _arenas.back().data + _arena_offset;
+	_arena_offset += capacity;
+	_arena_carved_memory += capacity;
 	return block;
 }
 
+VoxelMemoryPool::ThreadCache *VoxelMemoryPool::get_thread_cache() {
+	static thread_local ThreadCache tls_cache;
+	const VoxelMemoryPool *registered_pool = tls_cache.pool.load(std::memory_order_relaxed);
+	if (registered_pool != this) {
+		if (registered_pool != nullptr) {
+			// The thread already caches blocks for another pool. This only happens if there are several pools, which
+			// is unusual, so the other ones don't get caches.
+			return nullptr;
+		}
+		MutexLock glock(g_thread_caches_mutex);
+		tls_cache.pool.store(this, std::memory_order_relaxed);
+		_thread_caches.push_back(&tls_cache);
+	}
+	return &tls_cache;
+}
+
+uint8_t *VoxelMemoryPool::allocate_from_thread_cache(unsigned int pot) {
+	ThreadCache *cache = get_thread_cache();
+	Pool &pool = _pot_pools[pot];
+
+	if (cache == nullptr) {
+		MutexLock lock(pool.mutex);
+		if (pool.blocks.size() == 0) {
+			return nullptr;
+		}
+		uint8_t *block = pool.blocks.back();
+		pool.blocks.pop_back();
+		return block;
+	}
+
+	const size_t capacity = get_size_from_pool_index(pot);
+	MutexLock lock(cache->mutex);
+	Magazine &magazine = cache->magazines[pot];
+
+	if (magazine.count == 0) {
+		// Refill half of the magazine at once, so the next recycles don't immediately have to flush
+		const unsigned int refill_count = get_magazine_capacity(pot) / 2;
+		MutexLock plock(pool.mutex);
+		while (magazine.count < refill_count && pool.blocks.size() > 0) {
+			magazine.blocks[magazine.count] = pool.blocks.back();
+			pool.blocks.pop_back();
+			++magazine.count;
+		}
+		_thread_cached_memory += magazine.count * capacity;
+	}
+
+	if (magazine.count == 0) {
+		return nullptr;
+	}
+	--magazine.count;
+	_thread_cached_memory -= capacity;
+	return magazine.blocks[magazine.count];
+}
+
 void VoxelMemoryPool::recycle(uint8_t *block, size_t size) {
 	// In case we have done empty allocations (we prefer not to do that, but it shouldn't warrant a crash)
 	if (block == nullptr && size == 0) {
@@ -159,6 +358,7 @@ void VoxelMemoryPool::recycle(uint8_t *block, size_t size) {
 	}
 	ZN_ASSERT(size != 0);
 	ZN_ASSERT(block != nullptr);
+	size_t capacity;
 	// Not calculating `pot` immediately because the function we use to calculate it uses 32 bits,
 	// while `size_t` can be larger than that.
 	if (size > get_highest_supported_size()) {
@@ -166,23 +366,92 @@ void VoxelMemoryPool::recycle(uint8_t *block, size_t size) {
 		// Make sure this allocation was done by this pool in this scenario
 		_debug_nonpooled_used_blocks.remove(block);
 #endif
+		capacity = size;
 		ZN_FREE(block);
 		_total_memory -= size;
 	} else {
 		const unsigned int pot = get_pool_index_from_size(size);
+		capacity = get_size_from_pool_index(pot);
 		Pool &pool = _pot_pools[pot];
 #ifdef DEBUG_ENABLED
 		// Make sure this allocation was done by this pool in this scenario
 		pool.debug_used_blocks.remove(block);
 #endif
-		MutexLock lock(pool.mutex);
-		pool.blocks.push_back(block);
+		bool recycled = false;
+		if (_thread_caches_enabled.load(std::memory_order_relaxed) && get_magazine_capacity(pot) > 0) {
+			recycled = recycle_to_thread_cache(block, pot);
+		}
+		if (!recycled) {
+			MutexLock lock(pool.mutex);
+			pool.blocks.push_back(block);
+		}
 	}
 	--_used_blocks;
 	_used_memory -= size;
+	_used_capacity -= capacity;
+}
+
+bool VoxelMemoryPool::recycle_to_thread_cache(uint8_t *block, unsigned int pot) {
+	ThreadCache *cache = get_thread_cache();
+	if (cache == nullptr) {
+		return false;
+	}
+
+	const size_t capacity = get_size_from_pool_index(pot);
+	const unsigned int magazine_capacity = get_magazine_capacity(pot);
+	MutexLock lock(cache->mutex);
+	Magazine &magazine = cache->magazines[pot];
+
+	if (magazine.count == magazine_capacity) {
+		// Flush half of the magazine at once, so the next allocations don't immediately have to refill
+		const unsigned int flush_count = magazine_capacity / 2;
+		Pool &pool = _pot_pools[pot];
+		MutexLock plock(pool.mutex);
+		for (unsigned int i = 0; i < flush_count; ++i) {
+			--magazine.count;
+			pool.blocks.push_back(magazine.blocks[magazine.count]);
+		}
+		_thread_cached_memory -= flush_count * capacity;
+	}
+
+	magazine.blocks[magazine.count] = block;
+	++magazine.count;
+	_thread_cached_memory += capacity;
+	return true;
+}
+
+void VoxelMemoryPool::drain_thread_cache(ThreadCache &cache) {
+	MutexLock lock(cache.mutex);
+	for (unsigned int pot = 0; pot < cache.magazines.size(); ++pot) {
+		Magazine &magazine = cache.magazines[pot];
+		if (magazine.count == 0) {
+			continue;
+		}
+		Pool &pool = _pot_pools[pot];
+		MutexLock plock(pool.mutex);
+		for (unsigned int i = 0; i < magazine.count; ++i) {
+			pool.blocks.push_back(magazine.blocks[i]);
+		}
+		_thread_cached_memory -= magazine.count * get_size_from_pool_index(pot);
+		magazine.count = 0;
+	}
+}
+
+void VoxelMemoryPool::drain_thread_caches() {
+	MutexLock glock(g_thread_caches_mutex);
+	for (ThreadCache *cache : _thread_caches) {
+		drain_thread_cache(*cache);
+	}
 }
 
 void VoxelMemoryPool::clear_unused_blocks() {
+	drain_thread_caches();
+
+	if (_arenas_enabled) {
+		// Blocks carved from arenas can't be freed individually
+		return;
+	}
+
 	for (unsigned int pot = 0; pot < _pot_pools.size(); ++pot) {
 		Pool &pool = _pot_pools[pot];
 		MutexLock lock(pool.mutex);
@@ -199,15 +468,29 @@ void VoxelMemoryPool::clear() {
 	for (unsigned int pot = 0; pot < _pot_pools.size(); ++pot) {
 		Pool &pool = _pot_pools[pot];
 		MutexLock lock(pool.mutex);
-		for (unsigned int i = 0; i < pool.blocks.size(); ++i) {
-			void *block = pool.blocks[i];
-			ZN_FREE(block);
+		if (!_arenas_enabled) {
+			for (unsigned int i = 0; i < pool.blocks.size(); ++i) {
+				void *block = pool.blocks[i];
+				ZN_FREE(block);
+			}
 		}
 		pool.blocks.clear();
 	}
+	{
+		MutexLock lock(_arenas_mutex);
+		for (const Arena &arena : _arenas) {
+			free_arena_memory(arena.data, arena.size);
+		}
+		_arenas.clear();
+		_arena_offset = 0;
+	}
 	_used_memory = 0;
+	_used_capacity = 0;
 	_total_memory = 0;
 	_used_blocks = 0;
+	_thread_cached_memory = 0;
+	_arena_memory = 0;
+	_arena_carved_memory = 0;
 }
 
 void VoxelMemoryPool::debug_print() {
@@ -217,6 +500,20 @@ void VoxelMemoryPool::debug_print() {
 		MutexLock lock(pool.mutex);
 		print_line(format("Pool {}: {} blocks (capacity {})", pot, pool.blocks.size(), pool.blocks.capacity()));
 	}
+	print_line(format(
+			"Used: {} bytes ({} with rounding), total: {} bytes, peak used: {} bytes, peak total: {} bytes",
+			debug_get_used_memory(),
+			debug_get_used_capacity(),
+			debug_get_total_memory(),
+			debug_get_peak_used_memory(),
+			debug_get_peak_total_memory()
+	));
+	print_line(format(
+			"Thread caches: {} bytes, arenas: {} bytes ({} carved)",
+			debug_get_thread_cached_memory(),
+			debug_get_arena_memory(),
+			debug_get_arena_carved_memory()
+	));
 }
 
 unsigned int VoxelMemoryPool::debug_get_used_blocks() const {
@@ -227,8 +524,32 @@ size_t VoxelMemoryPool::debug_get_used_memory() const {
 	return _used_memory;
 }
 
+size_t VoxelMemoryPool::debug_get_used_capacity() const {
+	return _used_capacity;
+}
+
 size_t VoxelMemoryPool::debug_get_total_memory() const {
 	return _total_memory;
 }
 
+size_t VoxelMemoryPool::debug_get_peak_used_memory() const {
+	return _peak_used_memory;
+}
+
+size_t VoxelMemoryPool::debug_get_peak_total_memory() const {
+	return _peak_total_memory;
+}
+
+size_t VoxelMemoryPool::debug_get_thread_cached_memory() const {
+	return _thread_cached_memory;
+}
+
+size_t VoxelMemoryPool::debug_get_arena_memory() const {
+	return _arena_memory;
+}
+
+size_t VoxelMemoryPool::debug_get_arena_carved_memory() const {
+	return _arena_carved_memory;
+}
+
 } // namespace zylann::voxel
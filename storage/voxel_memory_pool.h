@@ -20,6 +20,13 @@ namespace zylann::voxel {
 // The majority of VoxelBuffers use powers of two so most of the time
 // we won't waste memory. Sometimes non-power-of-two buffers are created,
 // but they are often temporary and less numerous.
+//
+// Each thread keeps a small cache ("magazine") of blocks per size, so most allocations and recycles don't have to lock
+// the shared pools. Magazines exchange blocks with the shared pools in batches.
+//
+// Optionally, new blocks can be carved out of large arenas, which reduces calls to the system allocator and page
+// faults, and may use huge pages. Blocks allocated this way are never given back to the system until the pool is
+// destroyed.
 class VoxelMemoryPool {
 private:
 #ifdef DEBUG_ENABLED
@@ -54,6 +61,32 @@ private:
 #endif
 	};
 
+	static const unsigned int POOL_COUNT = 21;
+	static const unsigned int MAGAZINE_MAX_CAPACITY = 32;
+	// Magazines of larger blocks hold fewer of them, so the memory a thread can keep for itself remains bounded
+	static const size_t MAGAZINE_MAX_BYTES = 256 * 1024;
+
+	struct Magazine {
+		FixedArray<uint8_t *, MAGAZINE_MAX_CAPACITY> blocks;
+		unsigned int count = 0;
+	};
+
+	struct ThreadCache {
+		// Only contended when another thread drains the cache (on clear or destruction of the pool)
+		BinaryMutex mutex;
+		// Pool the cache is registered to. Only set under the global mutex, but the owning thread reads it without
+		// locking, while the pool could be unregistering it from another thread.
+		std::atomic<VoxelMemoryPool *> pool = { nullptr };
+		FixedArray<Magazine, POOL_COUNT> magazines;
+
+		~ThreadCache();
+	};
+
+	struct Arena {
+		uint8_t *data = nullptr;
+		size_t size = 0;
+	};
+
 public:
 	static void create_singleton();
 	static void destroy_singleton();
@@ -62,19 +95,56 @@ public:
 	VoxelMemoryPool();
 	~VoxelMemoryPool();
 
+	// Can be changed at any time. Blocks remaining in thread caches are returned when they get cleared.
+	void set_thread_caches_enabled(bool enabled);
+	bool is_thread_caches_enabled() const;
+
+	// Must be called before any allocation is made.
+	// If `huge_pages` is true, arenas are allocated with huge pages if the system allows it.
+	void set_arenas_enabled(bool enabled, bool huge_pages);
+	bool is_arenas_enabled() const;
+
 	uint8_t *allocate(size_t size);
 	void recycle(uint8_t *block, size_t size);
 
+	// Frees blocks that are not in use, including those cached by threads. Blocks carved from arenas remain pooled.
 	void clear_unused_blocks();
 
 	void debug_print();
 	unsigned int debug_get_used_blocks() const;
+	// Sum of the sizes requested by allocations in use
 	size_t debug_get_used_memory() const;
+	// Sum of the actual sizes of blocks in use. The difference with `debug_get_used_memory` is lost to rounding up to
+	// a power of two.
+	size_t debug_get_used_capacity() const;
+	// Memory obtained from the system, including blocks in use, unused blocks and arenas
 	size_t debug_get_total_memory() const;
+	// Highest values reached by `debug_get_used_memory` and `debug_get_total_memory`
+	size_t debug_get_peak_used_memory() const;
+	size_t debug_get_peak_total_memory() const;
+	// Memory in unused blocks held by thread caches
+	size_t debug_get_thread_cached_memory() const;
+	// Memory reserved for arenas, and how much of it has been carved into blocks
+	size_t debug_get_arena_memory() const;
+	size_t debug_get_arena_carved_memory() const;
 
 private:
 	void clear();
 
+	ThreadCache *get_thread_cache();
+	void drain_thread_cache(ThreadCache &cache);
+	void drain_thread_caches();
+	uint8_t *allocate_from_thread_cache(unsigned int pot);
+	bool recycle_to_thread_cache(uint8_t *block, unsigned int pot);
+	uint8_t *allocate_new_block(unsigned int pot);
+	uint8_t *allocate_from_arena(size_t capacity);
+
+	static inline unsigned int get_magazine_capacity(unsigned int pot) {
+		const size_t capacity = math::min(MAGAZINE_MAX_BYTES >> pot, size_t(MAGAZINE_MAX_CAPACITY));
+		// Bypass magazines when they would be too small to save any locking
+		return capacity < 2 ? 0 : capacity;
+	}
+
 	inline size_t get_highest_supported_size() const {
 		return size_t(1) << (_pot_pools.size() - 1);
 	}
@@ -99,14 +169,33 @@ private:
 	// This is chosen based on practical needs.
 	// Each slot in this array corresponds to allocations
 	// that contain 2^index bytes in them.
-	FixedArray<Pool, 21> _pot_pools;
+	FixedArray<Pool, POOL_COUNT> _pot_pools;
 #ifdef DEBUG_ENABLED
 	DebugUsedBlocks _debug_nonpooled_used_blocks;
 #endif
 
+	// Read by every thread allocating or recycling blocks. A thread may still use its cache shortly after this gets
+	// disabled, in which case the blocks remain in the cache until the next drain.
+	std::atomic_bool _thread_caches_enabled = { true };
+	// Protected by a global mutex, since caches can outlive the pool and the other way around
+	StdVector<ThreadCache *> _thread_caches;
+
+	bool _arenas_enabled = false;
+	bool _arenas_use_huge_pages = false;
+	BinaryMutex _arenas_mutex;
+	StdVector<Arena> _arenas;
+	// Where the next block will be carved in the last arena
+	size_t _arena_offset = 0;
+
 	std::atomic_uint32_t _used_blocks = { 0 };
 	std::atomic_uint64_t _used_memory = { 0 };
+	std::atomic_uint64_t _used_capacity = { 0 };
 	std::atomic_uint64_t _total_memory = { 0 };
+	std::atomic_uint64_t _peak_used_memory = { 0 };
+	std::atomic_uint64_t _peak_total_memory = { 0 };
+	std::atomic_uint64_t _thread_cached_memory = { 0 };
+	std::atomic_uint64_t _arena_memory = { 0 };
+	std::atomic_uint64_t _arena_carved_memory = { 0 };
 };
 
 } // namespace zylann::voxel
@@ -1,9 +1,13 @@
 #include "compressed_data.h"
 #include "../thirdparty/lz4/lz4.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/hash_funcs.h"
 #include "../util/io/serialization.h"
+#include "../util/math/funcs.h"
 #include "../util/profiling.h"
 #include "../util/string/format.h"
 
+#include <algorithm>
 #include <limits>
 
 namespace zylann::voxel::CompressedData {
@@ -28,7 +32,54 @@ bool decompress_lz4(MemoryReader &f, Span<const uint8_t> src, StdVector<uint8_t>
 	return true;
 }
 
+bool decompress_lz4_with_dictionary(
+		MemoryReader &f,
+		Span<const uint8_t> src,
+		StdVector<uint8_t> &dst,
+		Span<const uint8_t> dictionary
+) {
+	const int decompressed_size = f.get_32();
+	ZN_ASSERT_RETURN_V(decompressed_size >= 0, false);
+	const uint32_t dictionary_id = f.get_32();
+
+	// We don't verify the ID of the provided dictionary here, because hashing it for every block would be wasteful.
+	// The caller is expected to look it up with `get_required_dictionary_id`.
+	ZN_ASSERT_RETURN_V_MSG(
+			dictionary.size() > 0, false, format("Dictionary {} is required to decompress data", dictionary_id)
+	);
+
+	const int header_size = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+	ZN_ASSERT_RETURN_V(src.size() >= static_cast<size_t>(header_size), false);
+
+	dst.resize(decompressed_size);
+
+	const int actually_decompressed_size = LZ4_decompress_safe_usingDict(
+			(const char *)src.data() + header_size,
+			(char *)dst.data(),
+			src.size() - header_size,
+			dst.size(),
+			(const char *)dictionary.data(),
+			dictionary.size()
+	);
+
+	ZN_ASSERT_RETURN_V_MSG(
+			actually_decompressed_size >= 0, false, format("LZ4 decompression error {}", actually_decompressed_size)
+	);
+
+	ZN_ASSERT_RETURN_V_MSG(
+			actually_decompressed_size == decompressed_size,
+			false,
+			format("Expected {} bytes, obtained {}", decompressed_size, actually_decompressed_size)
+	);
+
+	return true;
+}
+
 bool decompress(Span<const uint8_t> src, StdVector<uint8_t> &dst) {
+	return decompress(src, dst, Span<const uint8_t>());
+}
+
+bool decompress(Span<const uint8_t> src, StdVector<uint8_t> &dst, Span<const uint8_t> dictionary) {
 	ZN_PROFILE_SCOPE();
 
 	MemoryReader f(src, ENDIANNESS_LITTLE_ENDIAN);
@@ -54,6 +105,10 @@ bool decompress(Span<const uint8_t> src, StdVector<uint8_t> &dst) {
 			ZN_ASSERT_RETURN_V(decompress_lz4(f, src, dst), false);
 			break;
 
+		case COMPRESSION_LZ4_DICTIONARY:
+			ZN_ASSERT_RETURN_V(decompress_lz4_with_dictionary(f, src, dst, dictionary), false);
+			break;
+
 		default:
 			ZN_PRINT_ERROR("Invalid compression header");
 			return false;
@@ -81,6 +136,56 @@ bool compress_lz4(MemoryWriter &f, Span<const uint8_t> src, StdVector<uint8_t> &
 	return true;
 }
 
+bool compress_lz4_with_dictionary(
+		MemoryWriter &f,
+		Span<const uint8_t> src,
+		StdVector<uint8_t> &dst,
+		Span<const uint8_t> dictionary
+) {
+	ZN_ASSERT_RETURN_V(src.size() <= static_cast<size_t>(LZ4_MAX_INPUT_SIZE), false);
+	ZN_ASSERT_RETURN_V(dictionary.size() <= MAX_DICTIONARY_SIZE, false);
+
+	f.store_32(src.size());
+	f.store_32(get_dictionary_id(dictionary));
+
+	const uint32_t header_size = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+	dst.resize(header_size + LZ4_compressBound(src.size()));
+
+	LZ4_stream_t stream;
+	LZ4_initStream(&stream, sizeof(stream));
+	// The dictionary only gets indexed, it has to remain valid until compression is done
+	LZ4_loadDict(&stream, (const char *)dictionary.data(), dictionary.size());
+
+	const int compressed_size = LZ4_compress_fast_continue(
+			&stream,
+			(const char *)src.data(),
+			(char *)dst.data() + header_size,
+			src.size(),
+			dst.size() - header_size,
+			1
+	);
+
+	ZN_ASSERT_RETURN_V(compressed_size > 0, false);
+
+	dst.resize(header_size + compressed_size);
+
+	return true;
+}
+
+bool compress_with_dictionary(Span<const uint8_t> src, StdVector<uint8_t> &dst, Span<const uint8_t> dictionary) {
+	if (dictionary.size() == 0) {
+		return compress(src, dst, COMPRESSION_LZ4);
+	}
+
+	ZN_PROFILE_SCOPE();
+
+	// Must clear first because MemoryWriter writes from the end
+	dst.clear();
+	MemoryWriter f(dst, ENDIANNESS_LITTLE_ENDIAN);
+	f.store_8(COMPRESSION_LZ4_DICTIONARY);
+	return compress_lz4_with_dictionary(f, src, dst, dictionary);
+}
+
 bool compress(Span<const uint8_t> src, StdVector<uint8_t> &dst, Compression comp) {
 	ZN_PROFILE_SCOPE();
 
@@ -108,6 +213,10 @@ bool compress(Span<const uint8_t> src, StdVector<uint8_t> &dst, Compression comp
 			compress_lz4(f, src, dst);
 		} break;
 
+		case COMPRESSION_LZ4_DICTIONARY:
+			ZN_PRINT_ERROR("Compressing with a dictionary requires to use `compress_with_dictionary`");
+			return false;
+
 		default:
 			ZN_PRINT_ERROR("Invalid compression header");
 			return false;
@@ -116,4 +225,108 @@ bool compress(Span<const uint8_t> src, StdVector<uint8_t> &dst, Compression comp
 	return true;
 }
 
+bool get_required_dictionary_id(Span<const uint8_t> src, uint32_t &out_id) {
+	const size_t header_size = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+	if (src.size() < header_size || src[0] != COMPRESSION_LZ4_DICTIONARY) {
+		return false;
+	}
+	MemoryReader f(src, ENDIANNESS_LITTLE_ENDIAN);
+	f.get_8();
+	f.get_32();
+	out_id = f.get_32();
+	return true;
+}
+
+uint32_t get_dictionary_id(Span<const uint8_t> dictionary) {
+	uint32_t h = hash_djb2_one_32(dictionary.size());
+	for (const uint8_t b : dictionary) {
+		h = hash_djb2_one_32(b, h);
+	}
+	// 0 is reserved
+	return h == 0 ? 1 : h;
+}
+
+namespace {
+
+// Size of the chunks samples are split into when looking for repetitions. Small enough to catch patterns common to
+// many blocks, large enough for LZ4 to benefit from a match.
+static const unsigned int DICTIONARY_SEGMENT_SIZE = 16;
+
+inline uint64_t hash_segment(const uint8_t *data) {
+	uint64_t h = 5381;
+	for (unsigned int i = 0; i < DICTIONARY_SEGMENT_SIZE; i += sizeof(uint64_t)) {
+		uint64_t v;
+		memcpy(&v, data + i, sizeof(v));
+		h = hash_djb2_one_64(v, h);
+	}
+	return h;
+}
+
+} // namespace
+
+void train_dictionary(
+		Span<const Span<const uint8_t>> samples,
+		unsigned int max_size,
+		StdVector<uint8_t> &out_dictionary
+) {
+	ZN_PROFILE_SCOPE();
+
+	out_dictionary.clear();
+	max_size = math::min(max_size, MAX_DICTIONARY_SIZE);
+
+	struct Segment {
+		const uint8_t *data;
+		// In how many samples the segment was found
+		uint32_t sample_count;
+		uint32_t last_sample_index;
+	};
+
+	StdUnorderedMap<uint64_t, Segment> segments;
+
+	for (unsigned int sample_index = 0; sample_index < samples.size(); ++sample_index) {
+		const Span<const uint8_t> sample = samples[sample_index];
+
+		for (size_t offset = 0; offset + DICTIONARY_SEGMENT_SIZE <= sample.size(); offset += DICTIONARY_SEGMENT_SIZE) {
+			const uint8_t *data = sample.data() + offset;
+			const uint64_t h = hash_segment(data);
+
+			auto it = segments.find(h);
+			if (it == segments.end()) {
+				segments.insert({ h, Segment{ data, 1, sample_index } });
+
+			} else if (it->second.last_sample_index != sample_index) {
+				// Only count once per sample, otherwise large runs of the same value would take over
+				++it->second.sample_count;
+				it->second.last_sample_index = sample_index;
+			}
+		}
+	}
+
+	StdVector<const Segment *> common_segments;
+	for (auto it = segments.begin(); it != segments.end(); ++it) {
+		// Segments found in a single sample are not worth including
+		if (it->second.sample_count > 1) {
+			common_segments.push_back(&it->second);
+		}
+	}
+
+	std::sort(common_segments.begin(), common_segments.end(), [](const Segment *a, const Segment *b) {
+		if (a->sample_count != b->sample_count) {
+			return a->sample_count > b->sample_count;
+		}
+		// Keep results deterministic regardless of hashing order
+		return memcmp(a->data, b->data, DICTIONARY_SEGMENT_SIZE) < 0;
+	});
+
+	const size_t segment_count = math::min(common_segments.size(), size_t(max_size / DICTIONARY_SEGMENT_SIZE));
+	out_dictionary.resize(segment_count * DICTIONARY_SEGMENT_SIZE);
+
+	// Most common segments go last, closer to the data being compressed
+	for (size_t i = 0; i < segment_count; ++i) {
+		const Segment *segment = common_segments[i];
+		const size_t dst_offset = (segment_count - i - 1) * DICTIONARY_SEGMENT_SIZE;
+		memcpy(out_dictionary.data() + dst_offset, segment->data, DICTIONARY_SEGMENT_SIZE);
+	}
+}
+
 } // namespace zylann::voxel::CompressedData
@@ -3,6 +3,7 @@
 #include "../generators/generate_block_task.h"
 #include "../storage/voxel_buffer.h"
 #include "../util/dstack.h"
+#include "../util/io/async_file_reader.h"
 #include "../util/io/log.h"
 #include "../util/profiling.h"
 
@@ -48,23 +49,57 @@ void LoadBlockDataTask::run(zylann::ThreadedTaskContext &ctx) {
 	Ref<VoxelStream> stream = _stream_dependency->stream;
 	CRASH_COND(stream.is_null());
 
-	ERR_FAIL_COND(_voxels != nullptr);
-	_voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
-	_voxels->create(_block_size, _block_size, _block_size);
+	VoxelStream::ResultCode result;
 
-	// TODO We should consider batching this again, but it needs to be done carefully.
-	// Each task is one block, and priority depends on distance to closest viewer.
-	// If we batch blocks, we have to do it by distance too.
+	if (_stage == STAGE_LOAD) {
+		ERR_FAIL_COND(_voxels != nullptr);
+		_voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+		_voxels->create(_block_size, _block_size, _block_size);
 
-	// TODO Assign max_lod_hint when available
+		if (stream->supports_block_file_locations()) {
+			result = stream->get_voxel_block_file_location(_position, _lod_index, _file_location);
 
-	VoxelStream::VoxelQueryData voxel_query_data{ *_voxels, _position, _lod_index, VoxelStream::RESULT_ERROR };
-	stream->load_voxel_block(voxel_query_data);
+			if (result == VoxelStream::RESULT_BLOCK_FOUND) {
+				// The task will run again once the data is read. Members must not be accessed after this, as it could
+				// already be running in another thread.
+				ctx.status = ThreadedTaskContext::STATUS_TAKEN_OUT;
+				start_file_read();
+				return;
+			}
+			if (result == VoxelStream::RESULT_ERROR) {
+				// The location couldn't be determined, the stream may still be able to load the block on its own
+				result = load_voxels(**stream);
+			}
+
+		} else {
+			result = load_voxels(**stream);
+		}
 
-	if (voxel_query_data.result == VoxelStream::RESULT_ERROR) {
+	} else {
+		if (_stage == STAGE_READ_FILE) {
+			// Reading from a thread of the general pool, because the asynchronous reader isn't available
+			ZN_PROFILE_SCOPE_NAMED("Read file");
+			_file_read_success = _file_location.file->read(_file_location.offset, to_span(_file_data));
+			_stage = STAGE_DECODE;
+		}
+
+		result = VoxelStream::RESULT_ERROR;
+		if (_file_read_success) {
+			result = stream->decode_voxel_block(_file_location, to_span_const(_file_data), *_voxels);
+		}
+		if (result == VoxelStream::RESULT_ERROR) {
+			// The block could have been saved again while it was being read
+			result = load_voxels(**stream);
+		}
+
+		_file_location = VoxelStream::BlockFileLocation();
+		_file_data = StdVector<uint8_t>();
+	}
+
+	if (result == VoxelStream::RESULT_ERROR) {
 		ERR_PRINT("Error loading voxel block");
 
-	} else if (voxel_query_data.result == VoxelStream::RESULT_BLOCK_NOT_FOUND) {
+	} else if (result == VoxelStream::RESULT_BLOCK_NOT_FOUND) {
 		if (_generate_cache_data) {
 			Ref<VoxelGenerator> generator = _stream_dependency->generator;
 
@@ -94,6 +129,11 @@ void LoadBlockDataTask::run(zylann::ThreadedTaskContext &ctx) {
 		} else {
 			_voxels.reset();
 		}
+
+	} else if (result == VoxelStream::RESULT_BLOCK_FOUND) {
+		if (VoxelEngine::get_singleton().is_palette_compression_enabled()) {
+			_voxels->compress_palette_channels();
+		}
 	}
 
 	if (_request_instances && stream->supports_instance_blocks()) {
@@ -107,7 +147,7 @@ void LoadBlockDataTask::run(zylann::ThreadedTaskContext &ctx) {
 		if (instances_query.result == VoxelStream::RESULT_ERROR) {
 			ERR_PRINT("Error loading instance block");
 
-		} else if (voxel_query_data.result == VoxelStream::RESULT_BLOCK_FOUND) {
+		} else if (result == VoxelStream::RESULT_BLOCK_FOUND) {
 			_instances = std::move(instances_query.data);
 		}
 		// If not found, instances will return null,
@@ -117,6 +157,47 @@ void LoadBlockDataTask::run(zylann::ThreadedTaskContext &ctx) {
 	_has_run = true;
 }
 
+VoxelStream::ResultCode LoadBlockDataTask::load_voxels(VoxelStream &stream) {
+	// TODO We should consider batching this again, but it needs to be done carefully.
+	// Each task is one block, and priority depends on distance to closest viewer.
+	// If we batch blocks, we have to do it by distance too.
+
+	// TODO Assign max_lod_hint when available
+
+	VoxelStream::VoxelQueryData voxel_query_data{ *_voxels, _position, _lod_index, VoxelStream::RESULT_ERROR };
+	stream.load_voxel_block(voxel_query_data);
+	return voxel_query_data.result;
+}
+
+void LoadBlockDataTask::start_file_read() {
+	_stage = STAGE_READ_FILE;
+	_file_data.resize(_file_location.size);
+
+	AsyncFileReader *reader = VoxelEngine::get_singleton().get_async_file_reader();
+
+	if (reader != nullptr) {
+		AsyncFileReader::Request request;
+		request.file = _file_location.file;
+		request.offset = _file_location.offset;
+		request.buffer = to_span(_file_data);
+		request.callback = on_file_read_complete;
+		request.userdata = this;
+		reader->submit(std::move(request));
+
+	} else {
+		// Many threads of the general pool can wait on reads at the same time, unlike the I/O thread
+		VoxelEngine::get_singleton().push_async_task(this);
+	}
+}
+
+void LoadBlockDataTask::on_file_read_complete(void *userdata, bool success) {
+	LoadBlockDataTask *task = static_cast<LoadBlockDataTask *>(userdata);
+	task->_file_read_success = success;
+	task->_stage = STAGE_DECODE;
+	// Decompression is expensive, so it runs in the general pool rather than the I/O thread
+	VoxelEngine::get_singleton().push_async_task(task);
+}
+
 TaskPriority LoadBlockDataTask::get_priority() {
 	float closest_viewer_distance_sq;
 	const TaskPriority p =
@@ -4,8 +4,10 @@
 #include "../engine/ids.h"
 #include "../engine/priority_dependency.h"
 #include "../engine/streaming_dependency.h"
+#include "../util/containers/std_vector.h"
 #include "../util/memory/memory.h"
 #include "../util/tasks/threaded_task.h"
+#include "voxel_stream.h"
 
 namespace zylann::voxel {
 
@@ -32,6 +34,18 @@ public:
 	static int debug_get_running_count();
 
 private:
+	enum Stage : uint8_t {
+		STAGE_LOAD,
+		// The block is being read from its file by the asynchronous reader, or will be read when the task runs again
+		STAGE_READ_FILE,
+		// The block was read from its file and can be decoded
+		STAGE_DECODE
+	};
+
+	VoxelStream::ResultCode load_voxels(VoxelStream &stream);
+	void start_file_read();
+	static void on_file_read_complete(void *userdata, bool success);
+
 	PriorityDependency _priority_dependency;
 	std::shared_ptr<VoxelBuffer> _voxels;
 	UniquePtr<InstanceBlockData> _instances;
@@ -47,6 +61,10 @@ private:
 	bool _generate_cache_data = true;
 	bool _requested_generator_task = false;
 	bool _generator_use_gpu = false;
+	Stage _stage = STAGE_LOAD;
+	bool _file_read_success = false;
+	VoxelStream::BlockFileLocation _file_location;
+	StdVector<uint8_t> _file_data;
 	std::shared_ptr<StreamingDependency> _stream_dependency;
 	std::shared_ptr<VoxelData> _voxel_data;
 	TaskCancellationToken _cancellation_token;
@@ -1,8 +1,10 @@
 #include "region_file.h"
 #include "../../streams/voxel_block_serializer.h"
+#include "../../util/godot/classes/project_settings.h"
 #include "../../util/godot/core/array.h"
 #include "../../util/godot/core/string.h"
 #include "../../util/io/log.h"
+#include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 #include "file_utils.h"
@@ -285,6 +287,10 @@ Error RegionFile::close() {
 		_file_access.unref();
 	}
 	_sectors.clear();
+	_mapping.reset();
+	_mapping_failed = false;
+	_read_only_file.reset();
+	_has_unflushed_writes = false;
 	return err;
 }
 
@@ -300,6 +306,7 @@ void RegionFile::flush() {
 		ZN_ASSERT_RETURN(save_header(**_file_access));
 	}
 	_file_access->flush();
+	_has_unflushed_writes = false;
 }
 
 bool RegionFile::set_format(const RegionFormat &format) {
@@ -359,10 +366,107 @@ Error RegionFile::load_block(Vector3i position, VoxelBuffer &out_block) {
 	return OK;
 }
 
+Error RegionFile::get_mapped_block_data(
+		Vector3i position,
+		std::shared_ptr<const MemoryMappedFile> &out_mapping,
+		Span<const uint8_t> &out_data
+) {
+	ERR_FAIL_COND_V(_file_access.is_null(), ERR_FILE_CANT_READ);
+
+	ERR_FAIL_COND_V(!is_valid_block_position(position), ERR_INVALID_PARAMETER);
+	const unsigned int lut_index = get_block_index_in_header(position);
+	ERR_FAIL_COND_V(lut_index >= _header.blocks.size(), ERR_INVALID_PARAMETER);
+	const RegionBlockInfo &block_info = _header.blocks[lut_index];
+
+	if (block_info.data == 0) {
+		return ERR_DOES_NOT_EXIST;
+	}
+
+	if (_mapping == nullptr) {
+		if (_mapping_failed) {
+			return ERR_UNAVAILABLE;
+		}
+
+		ZN_PROFILE_SCOPE_NAMED("Map file");
+		// Make sure pending writes reach the file before we map it
+		_file_access->flush();
+		_has_unflushed_writes = false;
+
+		std::shared_ptr<MemoryMappedFile> mapping = make_shared_instance<MemoryMappedFile>();
+		const CharString fpath_utf8 = ProjectSettings::get_singleton()->globalize_path(_file_path).utf8();
+		if (!mapping->open(fpath_utf8.get_data())) {
+			ZN_PRINT_VERBOSE(zylann::format("Could not map region file {}, falling back to regular reads", _file_path));
+			_mapping_failed = true;
+			return ERR_UNAVAILABLE;
+		}
+		_mapping = mapping;
+	}
+
+	const Span<const uint8_t> file_data = _mapping->get_data();
+
+	const size_t block_begin = _blocks_begin_offset + block_info.get_sector_index() * _header.format.sector_size;
+	ERR_FAIL_COND_V(block_begin + sizeof(uint32_t) > file_data.size(), ERR_FILE_CORRUPT);
+
+	// TODO Deal with endianness, this should be little-endian
+	uint32_t block_data_size;
+	memcpy(&block_data_size, file_data.data() + block_begin, sizeof(uint32_t));
+
+	const size_t data_begin = block_begin + sizeof(uint32_t);
+	ERR_FAIL_COND_V(data_begin + block_data_size > file_data.size(), ERR_FILE_CORRUPT);
+
+	out_data = file_data.sub(data_begin, block_data_size);
+	out_mapping = _mapping;
+	return OK;
+}
+
+Error RegionFile::get_block_file_location(
+		Vector3i position,
+		std::shared_ptr<const ReadOnlyFile> &out_file,
+		uint64_t &out_offset,
+		uint32_t &out_size
+) {
+	ERR_FAIL_COND_V(_file_access.is_null(), ERR_FILE_CANT_READ);
+
+	ERR_FAIL_COND_V(!is_valid_block_position(position), ERR_INVALID_PARAMETER);
+	const unsigned int lut_index = get_block_index_in_header(position);
+	ERR_FAIL_COND_V(lut_index >= _header.blocks.size(), ERR_INVALID_PARAMETER);
+	const RegionBlockInfo &block_info = _header.blocks[lut_index];
+
+	if (block_info.data == 0) {
+		return ERR_DOES_NOT_EXIST;
+	}
+
+	if (_read_only_file == nullptr) {
+		std::shared_ptr<ReadOnlyFile> file = make_shared_instance<ReadOnlyFile>();
+		const CharString fpath_utf8 = ProjectSettings::get_singleton()->globalize_path(_file_path).utf8();
+		if (!file->open(fpath_utf8.get_data())) {
+			return ERR_FILE_CANT_READ;
+		}
+		_read_only_file = file;
+	}
+
+	// Make sure pending writes reach the file before it gets read by other means. Only needed once after a batch of
+	// writes, not for every block that gets located.
+	if (_has_unflushed_writes) {
+		ZN_PROFILE_SCOPE_NAMED("Flush");
+		_file_access->flush();
+		_has_unflushed_writes = false;
+	}
+
+	out_file = _read_only_file;
+	out_offset = _blocks_begin_offset + block_info.get_sector_index() * _header.format.sector_size;
+	out_size = block_info.get_sector_count() * _header.format.sector_size;
+	return OK;
+}
+
 Error RegionFile::save_block(Vector3i position, VoxelBuffer &block) {
 	ERR_FAIL_COND_V(_header.format.verify_block(block) == false, ERR_INVALID_PARAMETER);
 	ERR_FAIL_COND_V(!is_valid_block_position(position), ERR_INVALID_PARAMETER);
 
+	// Sectors are about to move or grow, the mapping would be outdated
+	_mapping.reset();
+	_has_unflushed_writes = true;
+
 	ERR_FAIL_COND_V(_file_access == nullptr, ERR_FILE_CANT_WRITE);
 	FileAccess &f = **_file_access;
 
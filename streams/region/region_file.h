@@ -5,9 +5,13 @@
 #include "../../util/containers/fixed_array.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/file_access.h"
+#include "../../util/io/memory_mapped_file.h"
+#include "../../util/io/read_only_file.h"
 #include "../../util/math/color8.h"
 #include "../../util/math/vector3i.h"
 
+#include <memory>
+
 namespace zylann::voxel {
 
 struct RegionFormat {
@@ -84,6 +88,28 @@ public:
 	const RegionFormat &get_format() const;
 
 	Error load_block(Vector3i position, VoxelBuffer &out_block);
+
+	// Gets the compressed data of a block directly from the file mapped in memory, instead of reading it into a
+	// temporary buffer. The file gets mapped on first use. `out_data` remains valid as long as `out_mapping` is kept
+	// alive and the block isn't saved again.
+	// Returns `ERR_UNAVAILABLE` if the file can't be mapped, in which case `load_block` should be used instead. Mapping
+	// won't be attempted again until the file is closed.
+	Error get_mapped_block_data(
+			Vector3i position,
+			std::shared_ptr<const MemoryMappedFile> &out_mapping,
+			Span<const uint8_t> &out_data
+	);
+
+	// Gets where the data of a block is in the file, so it can be read without going through this class. The data
+	// starts with its size as a 32-bit integer, followed by the compressed block, and is padded up to a multiple of the
+	// sector size. The file gets opened on first use. The location becomes invalid if the block is saved again.
+	Error get_block_file_location(
+			Vector3i position,
+			std::shared_ptr<const ReadOnlyFile> &out_file,
+			uint64_t &out_offset,
+			uint32_t &out_size
+	);
+
 	Error save_block(Vector3i position, VoxelBuffer &block);
 
 	unsigned int get_header_block_count() const;
@@ -137,6 +163,14 @@ private:
 	StdVector<Vector3u16> _sectors;
 	uint32_t _blocks_begin_offset;
 	String _file_path;
+	// Invalidated when the file is modified, so the next mapping can see the changes. Users of the previous mapping
+	// keep it alive until they are done.
+	std::shared_ptr<const MemoryMappedFile> _mapping;
+	bool _mapping_failed = false;
+	// Opened separately from `_file_access` so reads can happen from other threads
+	std::shared_ptr<const ReadOnlyFile> _read_only_file;
+	// Tells if `_file_access` has to be flushed before the file is read by other means
+	bool _has_unflushed_writes = false;
 };
 
 } // namespace zylann::voxel
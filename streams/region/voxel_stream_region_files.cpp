@@ -9,9 +9,11 @@
 #include "../../util/math/box3i.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
+#include "../voxel_block_serializer.h"
 #include "file_utils.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace zylann::voxel {
 
@@ -119,53 +121,170 @@ void VoxelStreamRegionFiles::save_voxel_blocks(Span<VoxelStream::VoxelQueryData>
 	}
 }
 
-int VoxelStreamRegionFiles::get_used_channels_mask() const {
-	// Assuming all, since that stream can store anything.
-	return VoxelBuffer::ALL_CHANNELS_MASK;
+bool VoxelStreamRegionFiles::supports_block_file_locations() const {
+	MutexLock lock(_mutex);
+	return _async_reads_enabled && ReadOnlyFile::is_supported();
 }
 
-VoxelStreamRegionFiles::EmergeResult VoxelStreamRegionFiles::_load_block(
-		VoxelBuffer &out_buffer, Vector3i block_pos, int lod) {
+VoxelStream::ResultCode VoxelStreamRegionFiles::get_voxel_block_file_location(
+		Vector3i block_pos,
+		unsigned int lod,
+		BlockFileLocation &out_location
+) {
 	ZN_PROFILE_SCOPE();
-
 	MutexLock lock(_mutex);
 
 	if (_directory_path.is_empty()) {
-		return EMERGE_OK_FALLBACK;
+		return RESULT_BLOCK_NOT_FOUND;
 	}
 
 	if (!_meta_loaded) {
 		const zylann::godot::FileResult load_res = load_meta();
 		if (load_res != zylann::godot::FILE_OK) {
 			// No block was ever saved
-			return EMERGE_OK_FALLBACK;
+			return RESULT_BLOCK_NOT_FOUND;
 		}
 	}
 
-	const Vector3i block_size = Vector3iUtil::create(1 << _meta.block_size_po2);
-	const Vector3i region_size = Vector3iUtil::create(1 << _meta.region_size_po2);
-
-	CRASH_COND(!_meta_loaded);
-	ERR_FAIL_COND_V(lod >= _meta.lod_count, EMERGE_FAILED);
-	ERR_FAIL_COND_V(block_size != out_buffer.get_size(), EMERGE_FAILED);
-
-	// Configure depths, as they might not be specified in old block data.
-	// Regions are expected to contain such depths, and use those in the buffer to know how much data to read.
-	for (unsigned int channel_index = 0; channel_index < _meta.channel_depths.size(); ++channel_index) {
-		out_buffer.set_channel_depth(channel_index, _meta.channel_depths[channel_index]);
-	}
+	ERR_FAIL_COND_V(lod >= _meta.lod_count, RESULT_ERROR);
 
 	const Vector3i region_pos = get_region_position_from_blocks(block_pos);
 
 	CachedRegion *cache = open_region(region_pos, lod, false);
 	if (cache == nullptr || !cache->file_exists) {
-		return EMERGE_OK_FALLBACK;
+		return RESULT_BLOCK_NOT_FOUND;
 	}
 
+	const Vector3i region_size = Vector3iUtil::create(1 << _meta.region_size_po2);
 	const Vector3i block_rpos = math::wrap(block_pos, region_size);
 
-	const Error err = cache->region.load_block(block_rpos, out_buffer);
+	const Error err = cache->region.get_block_file_location(
+			block_rpos, out_location.file, out_location.offset, out_location.size
+	);
 	switch (err) {
+		case OK:
+			out_location.version = _files_version;
+			return RESULT_BLOCK_FOUND;
+		case ERR_DOES_NOT_EXIST:
+			return RESULT_BLOCK_NOT_FOUND;
+		default:
+			return RESULT_ERROR;
+	}
+}
+
+VoxelStream::ResultCode VoxelStreamRegionFiles::decode_voxel_block(
+		const BlockFileLocation &location,
+		Span<const uint8_t> data,
+		VoxelBuffer &out_voxels
+) {
+	ZN_PROFILE_SCOPE();
+	{
+		MutexLock lock(_mutex);
+
+		if (location.version != _files_version) {
+			// Files were modified while the block was being read
+			ZN_PRINT_VERBOSE("Block read from region file is outdated");
+			return RESULT_ERROR;
+		}
+
+		const Vector3i block_size = Vector3iUtil::create(1 << _meta.block_size_po2);
+		ERR_FAIL_COND_V(block_size != out_voxels.get_size(), RESULT_ERROR);
+
+		// Configure depths, as they might not be specified in old block data
+		for (unsigned int channel_index = 0; channel_index < _meta.channel_depths.size(); ++channel_index) {
+			out_voxels.set_channel_depth(channel_index, _meta.channel_depths[channel_index]);
+		}
+	}
+
+	uint32_t block_data_size;
+	ERR_FAIL_COND_V(data.size() < sizeof(block_data_size), RESULT_ERROR);
+	memcpy(&block_data_size, data.data(), sizeof(block_data_size));
+	ERR_FAIL_COND_V(sizeof(block_data_size) + block_data_size > data.size(), RESULT_ERROR);
+
+	if (!BlockSerializer::decompress_and_deserialize(data.sub(sizeof(block_data_size), block_data_size), out_voxels)) {
+		ZN_PRINT_ERROR("Failed to decompress block read from region file");
+		return RESULT_ERROR;
+	}
+
+	return RESULT_BLOCK_FOUND;
+}
+
+int VoxelStreamRegionFiles::get_used_channels_mask() const {
+	// Assuming all, since that stream can store anything.
+	return VoxelBuffer::ALL_CHANNELS_MASK;
+}
+
+VoxelStreamRegionFiles::EmergeResult VoxelStreamRegionFiles::_load_block(
+		VoxelBuffer &out_buffer, Vector3i block_pos, int lod) {
+	ZN_PROFILE_SCOPE();
+
+	std::shared_ptr<const MemoryMappedFile> mapping;
+	Span<const uint8_t> mapped_data;
+	{
+		MutexLock lock(_mutex);
+
+		if (_directory_path.is_empty()) {
+			return EMERGE_OK_FALLBACK;
+		}
+
+		if (!_meta_loaded) {
+			const zylann::godot::FileResult load_res = load_meta();
+			if (load_res != zylann::godot::FILE_OK) {
+				// No block was ever saved
+				return EMERGE_OK_FALLBACK;
+			}
+		}
+
+		const Vector3i block_size = Vector3iUtil::create(1 << _meta.block_size_po2);
+		const Vector3i region_size = Vector3iUtil::create(1 << _meta.region_size_po2);
+
+		CRASH_COND(!_meta_loaded);
+		ERR_FAIL_COND_V(lod >= _meta.lod_count, EMERGE_FAILED);
+		ERR_FAIL_COND_V(block_size != out_buffer.get_size(), EMERGE_FAILED);
+
+		// Configure depths, as they might not be specified in old block data.
+		// Regions are expected to contain such depths, and use those in the buffer to know how much data to read.
+		for (unsigned int channel_index = 0; channel_index < _meta.channel_depths.size(); ++channel_index) {
+			out_buffer.set_channel_depth(channel_index, _meta.channel_depths[channel_index]);
+		}
+
+		const Vector3i region_pos = get_region_position_from_blocks(block_pos);
+
+		CachedRegion *cache = open_region(region_pos, lod, false);
+		if (cache == nullptr || !cache->file_exists) {
+			return EMERGE_OK_FALLBACK;
+		}
+
+		const Vector3i block_rpos = math::wrap(block_pos, region_size);
+
+		if (!_memory_mapped_reads_enabled || !MemoryMappedFile::is_supported()) {
+			return get_emerge_result(cache->region.load_block(block_rpos, out_buffer));
+		}
+
+		const Error err = cache->region.get_mapped_block_data(block_rpos, mapping, mapped_data);
+		if (err == ERR_UNAVAILABLE) {
+			// The file couldn't be mapped in memory
+			return get_emerge_result(cache->region.load_block(block_rpos, out_buffer));
+		}
+		if (err != OK) {
+			return get_emerge_result(err);
+		}
+
+		// Locked before releasing the main mutex, so no save can modify the file in between
+		_mapped_files_rw_lock.read_lock();
+	}
+
+	// Decompression is the expensive part. It doesn't need exclusive access to the region, so multiple threads can do
+	// it at the same time.
+	const bool success = BlockSerializer::decompress_and_deserialize(mapped_data, out_buffer);
+	_mapped_files_rw_lock.read_unlock();
+
+	ERR_FAIL_COND_V_MSG(!success, EMERGE_FAILED, String("Failed to read block {0}").format(varray(block_pos)));
+	return EMERGE_OK;
+}
+
+VoxelStreamRegionFiles::EmergeResult VoxelStreamRegionFiles::get_emerge_result(Error load_error) {
+	switch (load_error) {
 		case OK:
 			return EMERGE_OK;
 
@@ -220,6 +339,12 @@ void VoxelStreamRegionFiles::_save_block(VoxelBuffer &voxel_buffer, Vector3i blo
 
 	CachedRegion *cache = open_region(region_pos, lod, true);
 	ERR_FAIL_COND_MSG(cache == nullptr, "Could not save region file data");
+
+	// Blocks being read asynchronously may see partially written data
+	++_files_version;
+
+	// Wait for threads decompressing from mapped files
+	RWLockWrite wlock(_mapped_files_rw_lock);
 	ERR_FAIL_COND(cache->region.save_block(block_rpos, voxel_buffer) != OK);
 }
 
@@ -231,6 +356,7 @@ String VoxelStreamRegionFiles::get_directory() const {
 void VoxelStreamRegionFiles::set_directory(String dirpath) {
 	MutexLock lock(_mutex);
 	if (_directory_path != dirpath) {
+		++_files_version;
 		close_all_regions();
 		_directory_path = dirpath.strip_edges();
 		_meta_loaded = false;
@@ -581,6 +707,7 @@ void VoxelStreamRegionFiles::_convert_files(Meta new_meta) {
 	// need it
 
 	ZN_PRINT_VERBOSE("Converting region files");
+	++_files_version;
 	// This can be a very long and slow operation. Better run this in a thread.
 
 	ERR_FAIL_COND(!_meta_saved);
@@ -918,6 +1045,32 @@ void VoxelStreamRegionFiles::convert_files(Dictionary d) {
 	emit_changed();
 }
 
+void VoxelStreamRegionFiles::set_memory_mapped_reads_enabled(bool enabled) {
+	if (enabled && !MemoryMappedFile::is_supported()) {
+		ZN_PRINT_WARNING("Memory-mapped reads are not supported on this platform, regular reads will be used.");
+	}
+	MutexLock lock(_mutex);
+	_memory_mapped_reads_enabled = enabled;
+}
+
+bool VoxelStreamRegionFiles::is_memory_mapped_reads_enabled() const {
+	MutexLock lock(_mutex);
+	return _memory_mapped_reads_enabled;
+}
+
+void VoxelStreamRegionFiles::set_async_reads_enabled(bool enabled) {
+	if (enabled && !ReadOnlyFile::is_supported()) {
+		ZN_PRINT_WARNING("Asynchronous reads are not supported on this platform, regular reads will be used.");
+	}
+	MutexLock lock(_mutex);
+	_async_reads_enabled = enabled;
+}
+
+bool VoxelStreamRegionFiles::is_async_reads_enabled() const {
+	MutexLock lock(_mutex);
+	return _async_reads_enabled;
+}
+
 void VoxelStreamRegionFiles::flush() {
 	ZN_PROFILE_SCOPE();
 	MutexLock lock(_mutex);
@@ -943,7 +1096,20 @@ void VoxelStreamRegionFiles::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("convert_files", "new_settings"), &VoxelStreamRegionFiles::convert_files);
 
+	ClassDB::bind_method(D_METHOD("set_memory_mapped_reads_enabled", "enabled"),
+			&VoxelStreamRegionFiles::set_memory_mapped_reads_enabled);
+	ClassDB::bind_method(
+			D_METHOD("is_memory_mapped_reads_enabled"), &VoxelStreamRegionFiles::is_memory_mapped_reads_enabled);
+
+	ClassDB::bind_method(
+			D_METHOD("set_async_reads_enabled", "enabled"), &VoxelStreamRegionFiles::set_async_reads_enabled);
+	ClassDB::bind_method(D_METHOD("is_async_reads_enabled"), &VoxelStreamRegionFiles::is_async_reads_enabled);
+
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "directory", PROPERTY_HINT_DIR), "set_directory", "get_directory");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "memory_mapped_reads_enabled"), "set_memory_mapped_reads_enabled",
+			"is_memory_mapped_reads_enabled");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "async_reads_enabled"), "set_async_reads_enabled",
+			"is_async_reads_enabled");
 
 	ADD_GROUP("Dimensions", "");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_count"), "set_lod_count", "get_lod_count");
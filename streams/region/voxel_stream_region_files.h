@@ -5,9 +5,12 @@
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/file_utils.h"
 #include "../../util/thread/mutex.h"
+#include "../../util/thread/rw_lock.h"
 #include "../voxel_stream.h"
 #include "region_file.h"
 
+#include <atomic>
+
 namespace zylann::voxel {
 
 // TODO Rename VoxelStreamRegionForest
@@ -18,6 +21,9 @@ namespace zylann::voxel {
 // Inspired by https://www.seedofandromeda.com/blogs/1-creating-a-region-file-system-for-a-voxel-game
 //
 // Region files are not thread-safe. Because of this, internal mutexing may often constrain the use by one thread only.
+// When memory-mapped reads are enabled, only locating blocks is serialized, and decompression can run in parallel.
+// When asynchronous reads are enabled, only locating blocks is serialized, and reading and decompression are done by
+// the tasks loading them.
 //
 class VoxelStreamRegionFiles : public VoxelStream {
 	GDCLASS(VoxelStreamRegionFiles, VoxelStream)
@@ -31,6 +37,18 @@ public:
 	void load_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_blocks) override;
 	void save_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_blocks) override;
 
+	bool supports_block_file_locations() const override;
+	ResultCode get_voxel_block_file_location(
+			Vector3i position_in_blocks,
+			unsigned int lod_index,
+			BlockFileLocation &out_location
+	) override;
+	ResultCode decode_voxel_block(
+			const BlockFileLocation &location,
+			Span<const uint8_t> data,
+			VoxelBuffer &out_voxels
+	) override;
+
 	int get_used_channels_mask() const override;
 
 	String get_directory() const;
@@ -52,6 +70,19 @@ public:
 
 	void convert_files(Dictionary d);
 
+	// When enabled, region files are mapped in memory and blocks are decompressed straight from the mapped pages,
+	// instead of being read into temporary buffers. It also allows multiple threads to load blocks at the same time.
+	// Only supported on Linux and macOS, it has no effect on other platforms.
+	void set_memory_mapped_reads_enabled(bool enabled);
+	bool is_memory_mapped_reads_enabled() const;
+
+	// When enabled, blocks are read from region files by the tasks loading them, instead of this stream. This allows
+	// many reads to be in flight at once (using io_uring on Linux), and decompression to run in parallel.
+	// Only supported on Linux and macOS, it has no effect on other platforms.
+	// Takes precedence over memory-mapped reads.
+	void set_async_reads_enabled(bool enabled);
+	bool is_async_reads_enabled() const;
+
 	void flush() override;
 
 protected:
@@ -68,6 +99,7 @@ private:
 	};
 
 	EmergeResult _load_block(VoxelBuffer &out_buffer, Vector3i block_pos, int lod);
+	static EmergeResult get_emerge_result(Error load_error);
 	void _save_block(VoxelBuffer &voxel_buffer, Vector3i block_pos, int lod);
 
 	zylann::godot::FileResult save_meta();
@@ -133,8 +165,17 @@ private:
 	StdVector<CachedRegion *> _region_cache;
 	// TODO Add memory caches to increase capacity.
 	unsigned int _max_open_regions = MIN(8, FOPEN_MAX);
+	bool _memory_mapped_reads_enabled = false;
+	bool _async_reads_enabled = false;
+	// Incremented before files get modified, so blocks that were read asynchronously in the meantime can be detected as
+	// outdated.
+	std::atomic_uint64_t _files_version = { 0 };
 
 	Mutex _mutex;
+	// Held for reading while blocks are decompressed from mapped files, outside of `_mutex`.
+	// Held for writing while region files get modified, so mapped data doesn't change under readers.
+	// Must be locked after `_mutex`.
+	RWLock _mapped_files_rw_lock;
 };
 
 } // namespace zylann::voxel
@@ -1,5 +1,6 @@
 #include "connection.h"
 #include "../../thirdparty/sqlite/sqlite3.h"
+#include "../../util/math/funcs.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 
@@ -197,13 +198,30 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 	sqlite3 *db = _db;
 	char *error_message = nullptr;
 
+	// Write-ahead logging makes writes faster, as they don't have to rewrite pages of the database in place, and lets
+	// reads run while another connection is writing. With it, `synchronous=NORMAL` can't corrupt the database, it can
+	// only lose the last transactions on power loss.
+	// https://www.sqlite.org/wal.html
+	const char *pragmas[2] = { "PRAGMA journal_mode=WAL", "PRAGMA synchronous=NORMAL" };
+	for (size_t i = 0; i < 2; ++i) {
+		rc = sqlite3_exec(db, pragmas[i], nullptr, nullptr, &error_message);
+		if (rc != SQLITE_OK) {
+			// Not critical, the database remains usable
+			ZN_PRINT_WARNING(format("Failed to execute \"{}\": {}", pragmas[i], error_message));
+			sqlite3_free(error_message);
+		}
+	}
+
 	const CoordinateColumnType block_key_column_type = get_coordinate_column_type(preferred_coordinate_format);
 
 	// Create tables if they don't exist.
-	const char *tables[3] = {
+	// The dictionaries table was added without a version change, since it is only needed by databases that opted in to
+	// dictionary compression.
+	const char *tables[4] = {
 		"CREATE TABLE IF NOT EXISTS meta (version INTEGER, block_size_po2 INTEGER, coordinate_format INTEGER)",
 		"",
-		"CREATE TABLE IF NOT EXISTS channels (idx INTEGER PRIMARY KEY, depth INTEGER)"
+		"CREATE TABLE IF NOT EXISTS channels (idx INTEGER PRIMARY KEY, depth INTEGER)",
+		"CREATE TABLE IF NOT EXISTS dictionaries (idx INTEGER PRIMARY KEY AUTOINCREMENT, id INTEGER UNIQUE, data BLOB)"
 	};
 	switch (block_key_column_type) {
 		case COORDINATE_COLUMN_U64:
@@ -219,7 +237,7 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 			ZN_CRASH_MSG("Invalid column type");
 			break;
 	}
-	for (size_t i = 0; i < 3; ++i) {
+	for (size_t i = 0; i < 4; ++i) {
 		rc = sqlite3_exec(db, tables[i], nullptr, nullptr, &error_message);
 		if (rc != SQLITE_OK) {
 			ZN_PRINT_ERROR(format("Failed to create table: {}", error_message));
@@ -261,6 +279,21 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 	if (!prepare(db, &_get_instance_block_statement, "SELECT instances FROM blocks WHERE loc=:loc")) {
 		return false;
 	}
+	{
+		// Statements with a fixed amount of parameters, so they can be prepared once and reused
+		StdString params;
+		for (unsigned int i = 0; i < LOAD_BATCH_SIZE; ++i) {
+			params += i == 0 ? "?" : ",?";
+		}
+		const StdString get_voxel_blocks_sql = "SELECT loc, vb FROM blocks WHERE loc IN (" + params + ")";
+		if (!prepare(db, &_get_voxel_blocks_statement, get_voxel_blocks_sql.c_str())) {
+			return false;
+		}
+		const StdString get_instance_blocks_sql = "SELECT loc, instances FROM blocks WHERE loc IN (" + params + ")";
+		if (!prepare(db, &_get_instance_blocks_statement, get_instance_blocks_sql.c_str())) {
+			return false;
+		}
+	}
 	if (!prepare(db, &_begin_statement, "BEGIN")) {
 		return false;
 	}
@@ -303,6 +336,15 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 	if (!prepare(db, &_load_all_block_keys_statement, "SELECT loc FROM blocks")) {
 		return false;
 	}
+	if (!prepare(db, &_load_dictionaries_statement, "SELECT id, data FROM dictionaries ORDER BY idx")) {
+		return false;
+	}
+	// Replacing the row gives it a new `idx`, so a dictionary saved again becomes the current one when loaded back
+	if (!prepare(
+				db, &_save_dictionary_statement, "INSERT OR REPLACE INTO dictionaries (id, data) VALUES (:id, :data)"
+		)) {
+		return false;
+	}
 
 	// Is the database setup?
 	Meta meta = load_meta();
@@ -355,14 +397,18 @@ void Connection::close() {
 	finalize(_load_version_statement);
 	finalize(_update_voxel_block_statement);
 	finalize(_get_voxel_block_statement);
+	finalize(_get_voxel_blocks_statement);
 	finalize(_update_instance_block_statement);
 	finalize(_get_instance_block_statement);
+	finalize(_get_instance_blocks_statement);
 	finalize(_load_meta_statement);
 	finalize(_save_meta_statement);
 	finalize(_load_channels_statement);
 	finalize(_save_channel_statement);
 	finalize(_load_all_blocks_statement);
 	finalize(_load_all_block_keys_statement);
+	finalize(_load_dictionaries_statement);
+	finalize(_save_dictionary_statement);
 	sqlite3_close(_db);
 	_db = nullptr;
 	_opened_path.clear();
@@ -515,6 +561,97 @@ VoxelStream::ResultCode Connection::load_block(
 	return result;
 }
 
+bool Connection::load_blocks(
+		Span<const BlockLocation> locations,
+		Span<VoxelStream::ResultCode> out_results,
+		const BlockType type,
+		void *callback_data,
+		void (*process_block_func)(void *callback_data, unsigned int index, Span<const uint8_t> block_data)
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT(process_block_func != nullptr);
+	ZN_ASSERT_RETURN_V(locations.size() == out_results.size(), false);
+
+	sqlite3 *db = _db;
+
+	sqlite3_stmt *get_blocks_statement;
+	switch (type) {
+		case VOXELS:
+			get_blocks_statement = _get_voxel_blocks_statement;
+			break;
+		case INSTANCES:
+			get_blocks_statement = _get_instance_blocks_statement;
+			break;
+		default:
+			CRASH_NOW();
+	}
+
+	for (VoxelStream::ResultCode &result : out_results) {
+		result = VoxelStream::RESULT_BLOCK_NOT_FOUND;
+	}
+
+	const CoordinateColumnType key_column_type = get_coordinate_column_type(_meta.coordinate_format);
+
+	// Keys may be bound with SQLITE_STATIC, so their buffers must remain valid until the query is complete
+	FixedArray<BindBlockCoordinates, LOAD_BATCH_SIZE> bindings;
+
+	for (size_t batch_begin = 0; batch_begin < locations.size(); batch_begin += LOAD_BATCH_SIZE) {
+		const size_t batch_end = math::min(batch_begin + LOAD_BATCH_SIZE, locations.size());
+
+		int rc = sqlite3_reset(get_blocks_statement);
+		if (rc != SQLITE_OK) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+
+		for (unsigned int param_index = 0; param_index < LOAD_BATCH_SIZE; ++param_index) {
+			// The last batch may not use all parameters. Repeating a location doesn't change the results.
+			const size_t location_index = math::min(batch_begin + param_index, batch_end - 1);
+			if (!bindings[param_index].bind(
+						db, get_blocks_statement, param_index + 1, _meta.coordinate_format, locations[location_index]
+				)) {
+				return false;
+			}
+		}
+
+		while (true) {
+			rc = sqlite3_step(get_blocks_statement);
+
+			if (rc == SQLITE_ROW) {
+				BlockLocation loc;
+				ZN_ASSERT_CONTINUE(
+						read_block_location(_meta.coordinate_format, key_column_type, get_blocks_statement, 0, loc)
+				);
+
+				const void *blob = sqlite3_column_blob(get_blocks_statement, 1);
+				const size_t blob_size = sqlite3_column_bytes(get_blocks_statement, 1);
+				if (blob_size == 0) {
+					continue;
+				}
+				const Span<const uint8_t> block_data(static_cast<const uint8_t *>(blob), blob_size);
+
+				// Rows don't come in the order of parameters, and the same location could have been requested more
+				// than once
+				for (size_t i = batch_begin; i < batch_end; ++i) {
+					if (locations[i] == loc) {
+						out_results[i] = VoxelStream::RESULT_BLOCK_FOUND;
+						process_block_func(callback_data, i, block_data);
+					}
+				}
+
+			} else if (rc == SQLITE_DONE) {
+				break;
+
+			} else {
+				ZN_PRINT_ERROR(sqlite3_errmsg(db));
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 bool Connection::load_all_blocks(
 		void *callback_data,
 		void (*process_block_func)(
@@ -625,6 +762,128 @@ bool Connection::load_all_block_keys(
 	return true;
 }
 
+bool Connection::load_voxel_block_samples(unsigned int max_count, StdVector<StdVector<uint8_t>> &out_blocks) {
+	ZN_PROFILE_SCOPE();
+
+	// Not a prepared statement we keep around, as it is only used occasionally
+	struct Statement {
+		sqlite3_stmt *s = nullptr;
+		~Statement() {
+			finalize(s);
+		}
+	};
+
+	Statement statement;
+	ZN_ASSERT_RETURN_V(
+			prepare(_db, &statement.s, "SELECT vb FROM blocks WHERE vb IS NOT NULL ORDER BY RANDOM() LIMIT :count"),
+			false
+	);
+
+	int rc = sqlite3_bind_int(statement.s, 1, max_count);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(_db));
+		return false;
+	}
+
+	while (true) {
+		rc = sqlite3_step(statement.s);
+
+		if (rc == SQLITE_ROW) {
+			const void *blob = sqlite3_column_blob(statement.s, 0);
+			const size_t blob_size = sqlite3_column_bytes(statement.s, 0);
+			if (blob_size == 0) {
+				continue;
+			}
+			StdVector<uint8_t> &block_data = out_blocks.emplace_back();
+			block_data.resize(blob_size);
+			memcpy(block_data.data(), blob, blob_size);
+
+		} else if (rc == SQLITE_DONE) {
+			break;
+
+		} else {
+			ZN_PRINT_ERROR(sqlite3_errmsg(_db));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Connection::load_compression_dictionaries(StdVector<CompressionDictionary> &out_dictionaries) {
+	ZN_PROFILE_SCOPE();
+
+	sqlite3 *db = _db;
+	sqlite3_stmt *load_dictionaries_statement = _load_dictionaries_statement;
+
+	int rc = sqlite3_reset(load_dictionaries_statement);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	while (true) {
+		rc = sqlite3_step(load_dictionaries_statement);
+
+		if (rc == SQLITE_ROW) {
+			CompressionDictionary dictionary;
+			dictionary.id = static_cast<uint32_t>(sqlite3_column_int64(load_dictionaries_statement, 0));
+
+			const void *blob = sqlite3_column_blob(load_dictionaries_statement, 1);
+			const size_t blob_size = sqlite3_column_bytes(load_dictionaries_statement, 1);
+			dictionary.data.resize(blob_size);
+			if (blob_size > 0) {
+				memcpy(dictionary.data.data(), blob, blob_size);
+			}
+
+			out_dictionaries.push_back(std::move(dictionary));
+
+		} else if (rc == SQLITE_DONE) {
+			break;
+
+		} else {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Connection::save_compression_dictionary(const uint32_t id, Span<const uint8_t> data) {
+	ZN_PROFILE_SCOPE();
+
+	sqlite3 *db = _db;
+	sqlite3_stmt *save_dictionary_statement = _save_dictionary_statement;
+
+	int rc = sqlite3_reset(save_dictionary_statement);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	rc = sqlite3_bind_int64(save_dictionary_statement, 1, id);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	// We use SQLITE_TRANSIENT so SQLite will make its own copy of the data
+	rc = sqlite3_bind_blob(save_dictionary_statement, 2, data.data(), data.size(), SQLITE_TRANSIENT);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	rc = sqlite3_step(save_dictionary_statement);
+	if (rc != SQLITE_DONE) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	return true;
+}
+
 int Connection::load_version() {
 	sqlite3 *db = _db;
 	sqlite3_stmt *load_version_statement = _load_version_statement;
@@ -18,6 +18,9 @@ public:
 	static constexpr int VERSION_V1 = 1;
 	static constexpr int VERSION_LATEST = VERSION_V1;
 
+	// How many blocks are requested per query when loading multiple blocks
+	static constexpr unsigned int LOAD_BATCH_SIZE = 64;
+
 	struct Meta {
 		int version = -1;
 		int block_size_po2 = 0;
@@ -33,6 +36,11 @@ public:
 		FixedArray<Channel, VoxelBuffer::MAX_CHANNELS> channels;
 	};
 
+	struct CompressionDictionary {
+		uint32_t id;
+		StdVector<uint8_t> data;
+	};
+
 	enum BlockType { //
 		VOXELS,
 		INSTANCES
@@ -68,6 +76,17 @@ public:
 			const BlockType type
 	);
 
+	// Loads multiple blocks using fewer queries than calling `load_block` for each of them.
+	// `process_block_func` is called for every block found, with its index in `locations`.
+	// `out_results` must have the same size as `locations`.
+	bool load_blocks(
+			Span<const BlockLocation> locations,
+			Span<VoxelStream::ResultCode> out_results,
+			const BlockType type,
+			void *callback_data,
+			void (*process_block_func)(void *callback_data, unsigned int index, Span<const uint8_t> block_data)
+	);
+
 	bool load_all_blocks(
 			void *callback_data,
 			void (*process_block_func)(
@@ -83,6 +102,14 @@ public:
 			void (*process_block_func)(void *callback_data, BlockLocation location)
 	);
 
+	// Gets a random selection of stored voxel blocks, in their compressed form.
+	bool load_voxel_block_samples(unsigned int max_count, StdVector<StdVector<uint8_t>> &out_blocks);
+
+	// Dictionaries are returned in the order they were saved.
+	bool load_compression_dictionaries(StdVector<CompressionDictionary> &out_dictionaries);
+	// Saving a dictionary with an existing ID replaces it, and moves it last.
+	bool save_compression_dictionary(const uint32_t id, Span<const uint8_t> data);
+
 	const Meta &get_meta() const {
 		return _meta;
 	}
@@ -104,14 +131,18 @@ private:
 	sqlite3_stmt *_end_statement = nullptr;
 	sqlite3_stmt *_update_voxel_block_statement = nullptr;
 	sqlite3_stmt *_get_voxel_block_statement = nullptr;
+	sqlite3_stmt *_get_voxel_blocks_statement = nullptr;
 	sqlite3_stmt *_update_instance_block_statement = nullptr;
 	sqlite3_stmt *_get_instance_block_statement = nullptr;
+	sqlite3_stmt *_get_instance_blocks_statement = nullptr;
 	sqlite3_stmt *_load_meta_statement = nullptr;
 	sqlite3_stmt *_save_meta_statement = nullptr;
 	sqlite3_stmt *_load_channels_statement = nullptr;
 	sqlite3_stmt *_save_channel_statement = nullptr;
 	sqlite3_stmt *_load_all_blocks_statement = nullptr;
 	sqlite3_stmt *_load_all_block_keys_statement = nullptr;
+	sqlite3_stmt *_load_dictionaries_statement = nullptr;
+	sqlite3_stmt *_save_dictionary_statement = nullptr;
 };
 
 } // namespace zylann::voxel::sqlite
@@ -7,6 +7,7 @@
 #include "../compressed_data.h"
 #include "connection.h"
 
+#include <cstring>
 #include <string_view>
 #include <unordered_set>
 
@@ -46,7 +47,9 @@ bool validate_range(Vector3i pos, unsigned int lod_index, const Box3i coordinate
 
 } // namespace
 
-VoxelStreamSQLite::VoxelStreamSQLite() {}
+VoxelStreamSQLite::VoxelStreamSQLite() {
+	_compression_dictionaries = make_shared_instance<CompressionDictionaries>();
+}
 
 VoxelStreamSQLite::~VoxelStreamSQLite() {
 	ZN_PRINT_VERBOSE("~VoxelStreamSQLite");
@@ -75,7 +78,7 @@ void VoxelStreamSQLite::set_database_path(String path) {
 		// Since Godot helpfully sets the property for every character typed in the inspector.
 		// So there can be lots of errors in the editor if you type it.
 		if (con.open(_globalized_connection_path.data(), to_internal_coordinate_format(_preferred_coordinate_format))) {
-			flush_cache_to_connection(&con);
+			flush_cache_to_connection(&con, _compression_dictionaries->get_current());
 		}
 	}
 	for (auto it = _connection_pool.begin(); it != _connection_pool.end(); ++it) {
@@ -83,6 +86,8 @@ void VoxelStreamSQLite::set_database_path(String path) {
 	}
 	_block_keys_cache.clear();
 	_connection_pool.clear();
+	_compression_dictionaries = make_shared_instance<CompressionDictionaries>();
+	_compression_dictionaries_loaded = false;
 
 	_user_specified_connection_path = path;
 	// To support Godot shortcuts like `user://` and `res://` (though the latter won't work on exported builds)
@@ -137,32 +142,53 @@ void VoxelStreamSQLite::load_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_bl
 		return;
 	}
 
-	// TODO We should handle busy return codes
-	ERR_FAIL_COND(con->begin_transaction() == false);
-
-	for (unsigned int i = 0; i < blocks_to_load.size(); ++i) {
-		const unsigned int ri = blocks_to_load[i];
-		VoxelStream::VoxelQueryData &q = p_blocks[ri];
+	std::shared_ptr<const CompressionDictionaries> dictionaries = get_compression_dictionaries();
 
+	StdVector<BlockLocation> locations;
+	locations.reserve(blocks_to_load.size());
+	for (const unsigned int ri : blocks_to_load) {
+		const VoxelStream::VoxelQueryData &q = p_blocks[ri];
 		BlockLocation loc;
 		loc.position = q.position_in_blocks;
 		loc.lod = q.lod_index;
+		locations.push_back(loc);
+	}
 
-		StdVector<uint8_t> &temp_block_data = get_tls_temp_block_data();
-
-		const ResultCode res = con->load_block(loc, temp_block_data, sqlite::Connection::VOXELS);
+	StdVector<ResultCode> results;
+	results.resize(blocks_to_load.size());
 
-		if (res == RESULT_BLOCK_FOUND) {
-			// TODO Not sure if we should actually expect non-null. There can be legit not found blocks.
-			BlockSerializer::decompress_and_deserialize(to_span_const(temp_block_data), q.voxel_buffer);
+	struct Context {
+		Span<VoxelStream::VoxelQueryData> blocks;
+		const StdVector<unsigned int> &blocks_to_load;
+		const CompressionDictionaries &dictionaries;
+
+		static void process_block(void *callback_data, unsigned int index, Span<const uint8_t> block_data) {
+			Context *ctx = static_cast<Context *>(callback_data);
+			VoxelStream::VoxelQueryData &q = ctx->blocks[ctx->blocks_to_load[index]];
+			BlockSerializer::decompress_and_deserialize(
+					block_data, q.voxel_buffer, ctx->dictionaries.find_for_data(block_data)
+			);
 		}
+	};
 
-		q.result = res;
-	}
+	Context context{ p_blocks, blocks_to_load, *dictionaries };
+
+	// TODO We should handle busy return codes
+	ERR_FAIL_COND(con->begin_transaction() == false);
+
+	const bool loaded = con->load_blocks(
+			to_span(locations), to_span(results), sqlite::Connection::VOXELS, &context, Context::process_block
+	);
 
 	ERR_FAIL_COND(con->end_transaction() == false);
 
 	recycle_connection(con);
+
+	ERR_FAIL_COND(!loaded);
+
+	for (unsigned int i = 0; i < blocks_to_load.size(); ++i) {
+		p_blocks[blocks_to_load[i]].result = results[i];
+	}
 }
 
 void VoxelStreamSQLite::save_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_blocks) {
@@ -224,44 +250,64 @@ void VoxelStreamSQLite::load_instance_blocks(Span<VoxelStream::InstancesQueryDat
 	sqlite::Connection *con = get_connection();
 	ERR_FAIL_COND(con == nullptr);
 
-	// TODO We should handle busy return codes
-	// TODO recycle on error
-	ERR_FAIL_COND(con->begin_transaction() == false);
-
-	for (unsigned int i = 0; i < blocks_to_load.size(); ++i) {
-		const unsigned int ri = blocks_to_load[i];
-		VoxelStream::InstancesQueryData &q = out_blocks[ri];
-
+	StdVector<BlockLocation> locations;
+	locations.reserve(blocks_to_load.size());
+	for (const unsigned int ri : blocks_to_load) {
+		const VoxelStream::InstancesQueryData &q = out_blocks[ri];
 		BlockLocation loc;
 		loc.position = q.position_in_blocks;
 		loc.lod = q.lod_index;
+		locations.push_back(loc);
+	}
+
+	StdVector<ResultCode> results;
+	results.resize(blocks_to_load.size());
 
-		StdVector<uint8_t> &temp_compressed_block_data = get_tls_temp_compressed_block_data();
+	struct Context {
+		Span<VoxelStream::InstancesQueryData> blocks;
+		const StdVector<unsigned int> &blocks_to_load;
+		// Same storage as the results passed to `load_blocks`, so failures can override a found block
+		Span<ResultCode> results;
 
-		const ResultCode res = con->load_block(loc, temp_compressed_block_data, sqlite::Connection::INSTANCES);
+		static void process_block(void *callback_data, unsigned int index, Span<const uint8_t> block_data) {
+			Context *ctx = static_cast<Context *>(callback_data);
+			VoxelStream::InstancesQueryData &q = ctx->blocks[ctx->blocks_to_load[index]];
 
-		if (res == RESULT_BLOCK_FOUND) {
 			StdVector<uint8_t> &temp_block_data = get_tls_temp_block_data();
 
-			if (!CompressedData::decompress(to_span_const(temp_compressed_block_data), temp_block_data)) {
+			if (!CompressedData::decompress(block_data, temp_block_data)) {
 				ERR_PRINT("Failed to decompress instance block");
-				q.result = RESULT_ERROR;
-				continue;
+				ctx->results[index] = VoxelStream::RESULT_ERROR;
+				return;
 			}
 			q.data = make_unique_instance<InstanceBlockData>();
 			if (!deserialize_instance_block_data(*q.data, to_span_const(temp_block_data))) {
 				ERR_PRINT("Failed to deserialize instance block");
-				q.result = RESULT_ERROR;
-				continue;
+				ctx->results[index] = VoxelStream::RESULT_ERROR;
+				return;
 			}
 		}
+	};
 
-		q.result = res;
-	}
+	Context context{ out_blocks, blocks_to_load, to_span(results) };
+
+	// TODO We should handle busy return codes
+	// TODO recycle on error
+	ERR_FAIL_COND(con->begin_transaction() == false);
+
+	const bool loaded = con->load_blocks(
+			to_span(locations), to_span(results), sqlite::Connection::INSTANCES, &context, Context::process_block
+	);
 
 	ERR_FAIL_COND(con->end_transaction() == false);
 
 	recycle_connection(con);
+
+	ERR_FAIL_COND(!loaded);
+
+	for (unsigned int i = 0; i < blocks_to_load.size(); ++i) {
+		out_blocks[blocks_to_load[i]].result = results[i];
+	}
 }
 
 void VoxelStreamSQLite::save_instance_blocks(Span<VoxelStream::InstancesQueryData> p_blocks) {
@@ -299,6 +345,7 @@ void VoxelStreamSQLite::load_all_blocks(FullLoadingResult &result) {
 
 	struct Context {
 		FullLoadingResult &result;
+		const CompressionDictionaries &dictionaries;
 	};
 
 	// Using local function instead of a lambda for quite stupid reason admittedly:
@@ -326,7 +373,9 @@ void VoxelStreamSQLite::load_all_blocks(FullLoadingResult &result) {
 
 			if (voxel_data.size() > 0) {
 				std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
-				ERR_FAIL_COND(!BlockSerializer::decompress_and_deserialize(voxel_data, *voxels));
+				ERR_FAIL_COND(!BlockSerializer::decompress_and_deserialize(
+						voxel_data, *voxels, ctx->dictionaries.find_for_data(voxel_data)
+				));
 				result_block.voxels = voxels;
 			}
 
@@ -349,7 +398,8 @@ void VoxelStreamSQLite::load_all_blocks(FullLoadingResult &result) {
 
 	// Had to suffix `_outer`,
 	// because otherwise GCC thinks it shadows a variable inside the local function/captureless lambda
-	Context ctx_outer{ result };
+	std::shared_ptr<const CompressionDictionaries> dictionaries = get_compression_dictionaries();
+	Context ctx_outer{ result, *dictionaries };
 	const bool request_result = con->load_all_blocks(&ctx_outer, L::process_block_func);
 	ERR_FAIL_COND(request_result == false);
 }
@@ -362,7 +412,8 @@ int VoxelStreamSQLite::get_used_channels_mask() const {
 void VoxelStreamSQLite::flush_cache() {
 	sqlite::Connection *con = get_connection();
 	ERR_FAIL_COND(con == nullptr);
-	flush_cache_to_connection(con);
+	std::shared_ptr<const CompressionDictionaries> dictionaries = get_compression_dictionaries();
+	flush_cache_to_connection(con, dictionaries->get_current());
 	recycle_connection(con);
 }
 
@@ -371,7 +422,7 @@ void VoxelStreamSQLite::flush() {
 }
 
 // This function does not lock any mutex for internal use.
-void VoxelStreamSQLite::flush_cache_to_connection(sqlite::Connection *p_connection) {
+void VoxelStreamSQLite::flush_cache_to_connection(sqlite::Connection *p_connection, Span<const uint8_t> dictionary) {
 	ZN_PROFILE_SCOPE();
 	ZN_PRINT_VERBOSE(format("VoxelStreamSQLite: Flushing cache ({} elements)", _cache.get_indicative_block_count()));
 
@@ -386,7 +437,7 @@ void VoxelStreamSQLite::flush_cache_to_connection(sqlite::Connection *p_connecti
 	const unsigned int lod_count = BlockLocation::get_lod_count(coordinate_format);
 
 	// TODO Needs better error rollback handling
-	_cache.flush([p_connection, &temp_data, &temp_compressed_data, coordinate_range, lod_count](
+	_cache.flush([p_connection, &temp_data, &temp_compressed_data, coordinate_range, lod_count, dictionary](
 						 VoxelStreamCache::Block &block
 				 ) {
 		ZN_ASSERT_RETURN(validate_range(block.position, block.lod, coordinate_range, lod_count));
@@ -400,7 +451,8 @@ void VoxelStreamSQLite::flush_cache_to_connection(sqlite::Connection *p_connecti
 			if (block.voxels_deleted) {
 				p_connection->save_block(loc, Span<const uint8_t>(), sqlite::Connection::VOXELS);
 			} else {
-				BlockSerializer::SerializeResult res = BlockSerializer::serialize_and_compress(block.voxels);
+				BlockSerializer::SerializeResult res =
+						BlockSerializer::serialize_and_compress(block.voxels, dictionary);
 				ERR_FAIL_COND(!res.success);
 				p_connection->save_block(loc, to_span(res.data), sqlite::Connection::VOXELS);
 			}
@@ -459,6 +511,27 @@ Connection *VoxelStreamSQLite::get_connection() {
 			cache->add_no_lock(loc.position, loc.lod);
 		});
 	}
+	bool dictionaries_loaded;
+	{
+		MutexLock mlock(_connection_mutex);
+		dictionaries_loaded = _compression_dictionaries_loaded;
+	}
+	if (!dictionaries_loaded) {
+		StdVector<sqlite::Connection::CompressionDictionary> loaded_dictionaries;
+		if (con->load_compression_dictionaries(loaded_dictionaries)) {
+			std::shared_ptr<CompressionDictionaries> dictionaries = make_shared_instance<CompressionDictionaries>();
+			for (sqlite::Connection::CompressionDictionary &d : loaded_dictionaries) {
+				dictionaries->ids.push_back(d.id);
+				dictionaries->dictionaries.push_back(std::move(d.data));
+			}
+			MutexLock mlock(_connection_mutex);
+			// Another thread could have loaded them already, or the path could have changed in the meantime
+			if (!_compression_dictionaries_loaded && _globalized_connection_path == fpath) {
+				_compression_dictionaries = dictionaries;
+				_compression_dictionaries_loaded = true;
+			}
+		}
+	}
 	return con;
 }
 
@@ -475,6 +548,43 @@ void VoxelStreamSQLite::recycle_connection(sqlite::Connection *con) {
 	delete con;
 }
 
+std::shared_ptr<const VoxelStreamSQLite::CompressionDictionaries> VoxelStreamSQLite::get_compression_dictionaries(
+) const {
+	MutexLock mlock(_connection_mutex);
+	return _compression_dictionaries;
+}
+
+Span<const uint8_t> VoxelStreamSQLite::CompressionDictionaries::find_for_data(Span<const uint8_t> data) const {
+	uint32_t id;
+	if (!CompressedData::get_required_dictionary_id(data, id)) {
+		return Span<const uint8_t>();
+	}
+	const Span<const uint8_t> dictionary = find(id);
+	if (dictionary.size() == 0) {
+		ZN_PRINT_ERROR(format("Compression dictionary {} was not found", id));
+	}
+	return dictionary;
+}
+
+Span<const uint8_t> VoxelStreamSQLite::CompressionDictionaries::find(uint32_t id) const {
+	for (unsigned int i = 0; i < ids.size(); ++i) {
+		if (ids[i] == id) {
+			return to_span(dictionaries[i]);
+		}
+	}
+	return Span<const uint8_t>();
+}
+
+void VoxelStreamSQLite::CompressionDictionaries::remove(uint32_t id) {
+	for (unsigned int i = 0; i < ids.size(); ++i) {
+		if (ids[i] == id) {
+			ids.erase(ids.begin() + i);
+			dictionaries.erase(dictionaries.begin() + i);
+			return;
+		}
+	}
+}
+
 void VoxelStreamSQLite::set_key_cache_enabled(bool enable) {
 	_block_keys_cache_enabled = enable;
 }
@@ -524,13 +634,10 @@ bool VoxelStreamSQLite::copy_blocks_to_other_sqlite_stream(Ref<VoxelStreamSQLite
 	ZN_ASSERT_RETURN_V(dst_stream.is_valid(), false);
 	ZN_ASSERT_RETURN_V(dst_stream.ptr() != this, false);
 
-	sqlite::Connection *src_con = get_connection();
-	ZN_ASSERT_RETURN_V(src_con != nullptr, false);
-
 	ZN_ASSERT_RETURN_V(dst_stream->get_database_path() != get_database_path(), false);
 
 	ZN_ASSERT_RETURN_V_MSG(
-			dst_stream->get_block_size_po2() != get_block_size_po2(),
+			dst_stream->get_block_size_po2() == get_block_size_po2(),
 			false,
 			"Copying between streams of different block sizes is not supported"
 	);
@@ -538,6 +645,48 @@ bool VoxelStreamSQLite::copy_blocks_to_other_sqlite_stream(Ref<VoxelStreamSQLite
 	// We can skip deserialization and copy data blocks directly.
 	// We also don't use cache.
 
+	sqlite::Connection *src_con = get_connection();
+	ZN_ASSERT_RETURN_V(src_con != nullptr, false);
+
+	sqlite::Connection *dst_con = dst_stream->get_connection();
+	if (dst_con == nullptr) {
+		recycle_connection(src_con);
+		ZN_PRINT_ERROR("Could not open destination database");
+		return false;
+	}
+
+	// Blocks may be compressed with dictionaries, which must be copied too so the destination can read them
+	StdVector<sqlite::Connection::CompressionDictionary> dictionaries;
+	if (!src_con->load_compression_dictionaries(dictionaries)) {
+		recycle_connection(src_con);
+		dst_stream->recycle_connection(dst_con);
+		return false;
+	}
+	for (const sqlite::Connection::CompressionDictionary &dictionary : dictionaries) {
+		if (!dst_con->save_compression_dictionary(dictionary.id, to_span(dictionary.data))) {
+			recycle_connection(src_con);
+			dst_stream->recycle_connection(dst_con);
+			return false;
+		}
+	}
+
+	// Update dictionaries used by the destination. They end up in the same order as in its database: saved ones are
+	// moved or appended last, so the last one becomes the current one.
+	{
+		MutexLock mlock(dst_stream->_connection_mutex);
+
+		std::shared_ptr<CompressionDictionaries> new_dictionaries = make_shared_instance<CompressionDictionaries>();
+		*new_dictionaries = *dst_stream->_compression_dictionaries;
+
+		for (sqlite::Connection::CompressionDictionary &dictionary : dictionaries) {
+			new_dictionaries->remove(dictionary.id);
+			new_dictionaries->ids.push_back(dictionary.id);
+			new_dictionaries->dictionaries.push_back(std::move(dictionary.data));
+		}
+
+		dst_stream->_compression_dictionaries = new_dictionaries;
+	}
+
 	struct Context {
 		sqlite::Connection *dst_con;
 
@@ -554,9 +703,100 @@ bool VoxelStreamSQLite::copy_blocks_to_other_sqlite_stream(Ref<VoxelStreamSQLite
 	};
 
 	Context context;
-	context.dst_con = dst_stream->get_connection();
+	context.dst_con = dst_con;
+
+	const bool success = src_con->load_all_blocks(&context, Context::save);
+
+	recycle_connection(src_con);
+	dst_stream->recycle_connection(dst_con);
+
+	return success;
+}
+
+bool VoxelStreamSQLite::train_compression_dictionary(int max_samples, int max_size) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(max_samples >= 2, false);
+	ZN_ASSERT_RETURN_V(max_size > 0, false);
+
+	// Blocks still in cache should be considered too
+	flush_cache();
+
+	sqlite::Connection *con = get_connection();
+	ZN_ASSERT_RETURN_V(con != nullptr, false);
+
+	StdVector<StdVector<uint8_t>> compressed_samples;
+	if (!con->load_voxel_block_samples(max_samples, compressed_samples)) {
+		recycle_connection(con);
+		return false;
+	}
+
+	std::shared_ptr<const CompressionDictionaries> dictionaries = get_compression_dictionaries();
+
+	// Dictionaries are trained from uncompressed data
+	StdVector<StdVector<uint8_t>> samples;
+	samples.reserve(compressed_samples.size());
+	for (const StdVector<uint8_t> &compressed_sample : compressed_samples) {
+		const Span<const uint8_t> compressed_data = to_span(compressed_sample);
+		StdVector<uint8_t> sample;
+		if (CompressedData::decompress(compressed_data, sample, dictionaries->find_for_data(compressed_data))) {
+			samples.push_back(std::move(sample));
+		}
+	}
+
+	if (samples.size() < 2) {
+		ZN_PRINT_VERBOSE(format("Not enough blocks to train a compression dictionary ({})", samples.size()));
+		recycle_connection(con);
+		return false;
+	}
+
+	StdVector<Span<const uint8_t>> sample_spans;
+	sample_spans.reserve(samples.size());
+	for (const StdVector<uint8_t> &sample : samples) {
+		sample_spans.push_back(to_span(sample));
+	}
+
+	StdVector<uint8_t> dictionary;
+	CompressedData::train_dictionary(to_span(sample_spans), max_size, dictionary);
+
+	if (dictionary.size() == 0) {
+		ZN_PRINT_VERBOSE("Blocks had no patterns in common to make a compression dictionary");
+		recycle_connection(con);
+		return false;
+	}
+
+	const uint32_t id = CompressedData::get_dictionary_id(to_span(dictionary));
 
-	return src_con->load_all_blocks(&context, Context::save);
+	const Span<const uint8_t> existing_dictionary = dictionaries->find(id);
+	if (existing_dictionary.size() > 0 &&
+		(existing_dictionary.size() != dictionary.size() ||
+		 memcmp(existing_dictionary.data(), dictionary.data(), dictionary.size()) != 0)) {
+		// Replacing it would make blocks compressed with the existing one unreadable
+		ZN_PRINT_ERROR(format("Trained compression dictionary has the same ID as an existing one ({})", id));
+		recycle_connection(con);
+		return false;
+	}
+
+	// If the same dictionary was trained before, it is saved again so it becomes the current one after reopening
+	const bool saved = con->save_compression_dictionary(id, to_span(dictionary));
+	recycle_connection(con);
+	ZN_ASSERT_RETURN_V(saved, false);
+
+	std::shared_ptr<CompressionDictionaries> new_dictionaries = make_shared_instance<CompressionDictionaries>();
+	{
+		MutexLock mlock(_connection_mutex);
+		*new_dictionaries = *_compression_dictionaries;
+		// Same dictionary as an existing one, remove it so it becomes the current one
+		new_dictionaries->remove(id);
+		new_dictionaries->ids.push_back(id);
+		new_dictionaries->dictionaries.push_back(std::move(dictionary));
+		_compression_dictionaries = new_dictionaries;
+	}
+
+	return true;
+}
+
+bool VoxelStreamSQLite::has_compression_dictionary() const {
+	return get_compression_dictionaries()->dictionaries.size() > 0;
 }
 
 void VoxelStreamSQLite::_bind_methods() {
@@ -573,6 +813,14 @@ void VoxelStreamSQLite::_bind_methods() {
 			D_METHOD("get_preferred_coordinate_format"), &VoxelStreamSQLite::get_preferred_coordinate_format
 	);
 
+	ClassDB::bind_method(
+			D_METHOD("train_compression_dictionary", "max_samples", "max_size"),
+			&VoxelStreamSQLite::train_compression_dictionary,
+			DEFVAL(1000),
+			DEFVAL(CompressedData::MAX_DICTIONARY_SIZE)
+	);
+	ClassDB::bind_method(D_METHOD("has_compression_dictionary"), &VoxelStreamSQLite::has_compression_dictionary);
+
 	BIND_ENUM_CONSTANT(COORDINATE_FORMAT_INT64_X16_Y16_Z16_L16);
 	BIND_ENUM_CONSTANT(COORDINATE_FORMAT_INT64_X19_Y19_Z19_L7);
 	BIND_ENUM_CONSTANT(COORDINATE_FORMAT_STRING_CSD);
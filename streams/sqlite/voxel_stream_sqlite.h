@@ -73,9 +73,37 @@ public:
 
 	bool copy_blocks_to_other_sqlite_stream(Ref<VoxelStreamSQLite> dst_stream);
 
+	// Trains a compression dictionary from a random selection of voxel blocks saved in the database, and uses it to
+	// compress blocks saved afterward. Previous dictionaries are kept, so blocks saved before remain readable.
+	// Returns false if not enough data could be gathered.
+	bool train_compression_dictionary(int max_samples, int max_size);
+	bool has_compression_dictionary() const;
+
 private:
 	void rebuild_key_cache();
 
+	struct CompressionDictionaries {
+		StdVector<uint32_t> ids;
+		StdVector<StdVector<uint8_t>> dictionaries;
+
+		// The latest dictionary is used for new saves
+		inline Span<const uint8_t> get_current() const {
+			if (dictionaries.size() == 0) {
+				return Span<const uint8_t>();
+			}
+			return to_span(dictionaries.back());
+		}
+
+		// Gets the dictionary needed to decompress the given data. Returns an empty span if none is needed, or if
+		// it wasn't found.
+		Span<const uint8_t> find_for_data(Span<const uint8_t> data) const;
+
+		// Returns an empty span if there is no dictionary with the given ID.
+		Span<const uint8_t> find(uint32_t id) const;
+
+		void remove(uint32_t id);
+	};
+
 	struct BlockKeysCache {
 		FixedArray<StdUnorderedSet<Vector3i>, constants::MAX_LOD> lods;
 		RWLock rw_lock;
@@ -128,7 +156,8 @@ private:
 
 	sqlite::Connection *get_connection();
 	void recycle_connection(sqlite::Connection *con);
-	void flush_cache_to_connection(sqlite::Connection *p_connection);
+	void flush_cache_to_connection(sqlite::Connection *p_connection, Span<const uint8_t> dictionary);
+	std::shared_ptr<const CompressionDictionaries> get_compression_dictionaries() const;
 
 	static void _bind_methods();
 
@@ -151,6 +180,11 @@ private:
 	// Format that will be used when creating new databases. May not necessarily match the format actually used by
 	// existing databases.
 	CoordinateFormat _preferred_coordinate_format = COORDINATE_FORMAT_STRING_CSD;
+	// Dictionaries found in the database. They are loaded along with the first connection. Never null.
+	// The object is never modified once assigned, so threads can keep using it while it gets replaced.
+	// Protected by `_connection_mutex`.
+	std::shared_ptr<const CompressionDictionaries> _compression_dictionaries;
+	bool _compression_dictionaries_loaded = false;
 };
 
 } // namespace zylann::voxel
@@ -263,7 +263,9 @@ size_t get_size_in_bytes(const VoxelBuffer &buffer, size_t &metadata_size) {
 		size += 1;
 
 		switch (compression) {
-			case VoxelBuffer::COMPRESSION_NONE: {
+			case VoxelBuffer::COMPRESSION_NONE:
+			// Palettes are an in-memory representation, they are serialized decompressed
+			case VoxelBuffer::COMPRESSION_PALETTE: {
 				size += VoxelBuffer::get_size_in_bytes_for_volume(size_in_voxels, depth);
 			} break;
 
@@ -322,8 +324,13 @@ SerializeResult serialize(const VoxelBuffer &voxel_buffer) {
 	f.store_16(voxel_buffer.get_size().z);
 
 	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
-		const VoxelBuffer::Compression compression = voxel_buffer.get_channel_compression(channel_index);
+		VoxelBuffer::Compression compression = voxel_buffer.get_channel_compression(channel_index);
 		const VoxelBuffer::Depth depth = voxel_buffer.get_channel_depth(channel_index);
+		const bool is_palette = compression == VoxelBuffer::COMPRESSION_PALETTE;
+		if (is_palette) {
+			// Palettes are an in-memory representation, they are serialized decompressed
+			compression = VoxelBuffer::COMPRESSION_NONE;
+		}
 		// Low nibble: compression (up to 16 values allowed)
 		// High nibble: depth (up to 16 values allowed)
 		const uint8_t fmt = static_cast<uint8_t>(compression) | (static_cast<uint8_t>(depth) << 4);
@@ -331,6 +338,13 @@ SerializeResult serialize(const VoxelBuffer &voxel_buffer) {
 
 		switch (compression) {
 			case VoxelBuffer::COMPRESSION_NONE: {
+				if (is_palette) {
+					const size_t begin = dst_data.size();
+					const size_t size = VoxelBuffer::get_size_in_bytes_for_volume(voxel_buffer.get_size(), depth);
+					dst_data.resize(begin + size);
+					voxel_buffer.copy_channel_to_bytes(channel_index, Span<uint8_t>(&dst_data[begin], size));
+					break;
+				}
 				Span<const uint8_t> data;
 				ERR_FAIL_COND_V(
 						!voxel_buffer.get_channel_as_bytes_read_only(channel_index, data),
@@ -695,6 +709,10 @@ bool deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer) {
 }
 
 SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer) {
+	return serialize_and_compress(voxel_buffer, Span<const uint8_t>());
+}
+
+SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer, Span<const uint8_t> dictionary) {
 	ZN_PROFILE_SCOPE();
 
 	StdVector<uint8_t> &compressed_data = get_tls_compressed_data();
@@ -703,8 +721,8 @@ SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer) {
 	ERR_FAIL_COND_V(!res.success, SerializeResult(compressed_data, false));
 	const StdVector<uint8_t> &data = res.data;
 
-	res.success = CompressedData::compress(
-			Span<const uint8_t>(data.data(), 0, data.size()), compressed_data, CompressedData::COMPRESSION_LZ4
+	res.success = CompressedData::compress_with_dictionary(
+			Span<const uint8_t>(data.data(), 0, data.size()), compressed_data, dictionary
 	);
 	ERR_FAIL_COND_V(!res.success, SerializeResult(compressed_data, false));
 
@@ -712,11 +730,19 @@ SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer) {
 }
 
 bool decompress_and_deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer) {
+	return decompress_and_deserialize(p_data, out_voxel_buffer, Span<const uint8_t>());
+}
+
+bool decompress_and_deserialize(
+		Span<const uint8_t> p_data,
+		VoxelBuffer &out_voxel_buffer,
+		Span<const uint8_t> dictionary
+) {
 	ZN_PROFILE_SCOPE();
 
 	StdVector<uint8_t> &data = get_tls_data();
 
-	const bool res = CompressedData::decompress(p_data, data);
+	const bool res = CompressedData::decompress(p_data, data, dictionary);
 	ERR_FAIL_COND_V(!res, false);
 
 	return deserialize(to_span_const(data), out_voxel_buffer);
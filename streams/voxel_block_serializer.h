@@ -38,6 +38,15 @@ SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer);
 bool decompress_and_deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer);
 bool decompress_and_deserialize(FileAccess &f, unsigned int size_to_read, VoxelBuffer &out_voxel_buffer);
 
+// Variants using a compression dictionary (see `CompressedData::train_dictionary`).
+// If the dictionary is empty, they behave like the variants above.
+SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer, Span<const uint8_t> dictionary);
+bool decompress_and_deserialize(
+		Span<const uint8_t> p_data,
+		VoxelBuffer &out_voxel_buffer,
+		Span<const uint8_t> dictionary
+);
+
 // Temporary thread-local buffers for internal use
 StdVector<uint8_t> &get_tls_data();
 StdVector<uint8_t> &get_tls_compressed_data();
@@ -51,6 +51,24 @@ void VoxelStream::load_all_blocks(FullLoadingResult &result) {
 	ZN_PRINT_ERROR(format("{} does not support `load_all_blocks`", get_class()));
 }
 
+VoxelStream::ResultCode VoxelStream::get_voxel_block_file_location(
+		Vector3i position_in_blocks,
+		unsigned int lod_index,
+		BlockFileLocation &out_location
+) {
+	ZN_PRINT_ERROR(format("{} does not support `get_voxel_block_file_location`", get_class()));
+	return RESULT_ERROR;
+}
+
+VoxelStream::ResultCode VoxelStream::decode_voxel_block(
+		const BlockFileLocation &location,
+		Span<const uint8_t> data,
+		VoxelBuffer &out_voxels
+) {
+	ZN_PRINT_ERROR(format("{} does not support `decode_voxel_block`", get_class()));
+	return RESULT_ERROR;
+}
+
 int VoxelStream::get_used_channels_mask() const {
 	return 0;
 }
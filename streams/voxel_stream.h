@@ -13,6 +13,10 @@
 
 #include <cstdint>
 
+namespace zylann {
+class ReadOnlyFile;
+}
+
 namespace zylann::voxel {
 
 class VoxelBuffer;
@@ -104,6 +108,37 @@ public:
 
 	virtual void load_all_blocks(FullLoadingResult &result);
 
+	// Where the data of a block is stored within a file.
+	struct BlockFileLocation {
+		std::shared_ptr<const ReadOnlyFile> file;
+		uint64_t offset = 0;
+		uint32_t size = 0;
+		// Allows the stream to tell if the file was modified since the location was obtained
+		uint64_t version = 0;
+	};
+
+	// Some file-based streams can tell where blocks are stored, so reading them can be done outside of the stream,
+	// with many reads in flight at once, and decoding can be done later on any thread.
+	virtual bool supports_block_file_locations() const {
+		return false;
+	}
+
+	// Gets where the data of a block is stored. Returns `RESULT_BLOCK_NOT_FOUND` if the block isn't in the stream.
+	virtual ResultCode get_voxel_block_file_location(
+			Vector3i position_in_blocks,
+			unsigned int lod_index,
+			BlockFileLocation &out_location
+	);
+
+	// Decodes data read from a location obtained with `get_voxel_block_file_location`. `out_voxels` must have the size
+	// of a block. Returns `RESULT_ERROR` if the data is invalid or outdated, in which case the block should be loaded
+	// with `load_voxel_block` instead.
+	virtual ResultCode decode_voxel_block(
+			const BlockFileLocation &location,
+			Span<const uint8_t> data,
+			VoxelBuffer &out_voxels
+	);
+
 	// Tells which channels can be found in this stream.
 	// The simplest implementation is to return them all.
 	// One reason to specify which channels are available is to help the editor detect configuration issues,
@@ -1,16 +1,93 @@
 #include "voxel_box_mover.h"
+#include "../../engine/voxel_engine.h"
 #include "../../meshers/blocky/voxel_mesher_blocky.h"
 #include "../../meshers/cubes/voxel_mesher_cubes.h"
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_data.h"
+#include "../../util/containers/fixed_array.h"
+#include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/math/conv.h"
+#include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
+#include "../../util/tasks/threaded_task.h"
+#include "../../util/thread/semaphore.h"
 #include "voxel_terrain.h"
 
+#include <atomic>
+
 namespace zylann::voxel {
 
 namespace {
 
+// Axis-aligned boxes stored as a structure of arrays. Loops going through them access memory linearly, and the simple
+// ones can be vectorized by the compiler.
+struct BoxesSoA {
+	FixedArray<StdVector<real_t>, 3> min;
+	FixedArray<StdVector<real_t>, 3> max;
+
+	inline unsigned int size() const {
+		return min[0].size();
+	}
+
+	void clear() {
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			min[axis].clear();
+			max[axis].clear();
+		}
+	}
+
+	inline void push_back(const AABB &box) {
+		const Vector3 end = box.position + box.size;
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			min[axis].push_back(box.position[axis]);
+			max[axis].push_back(end[axis]);
+		}
+	}
+
+	inline void push_back_from(const BoxesSoA &other, unsigned int i) {
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			min[axis].push_back(other.min[axis][i]);
+			max[axis].push_back(other.max[axis][i]);
+		}
+	}
+};
+
+// Collision boxes of the voxels found in an area, along with the position of the voxel each box comes from
+struct VoxelBoxes {
+	BoxesSoA boxes;
+	FixedArray<StdVector<int32_t>, 3> voxel_positions;
+
+	void clear() {
+		boxes.clear();
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			voxel_positions[axis].clear();
+		}
+	}
+
+	inline void push_back(const AABB &box, Vector3i voxel_position) {
+		boxes.push_back(box);
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			voxel_positions[axis].push_back(voxel_position[axis]);
+		}
+	}
+};
+
+struct MoverScratch {
+	// Boxes of the voxels around a group of agents
+	VoxelBoxes group_boxes;
+	// Boxes of the voxels in a specific area
+	VoxelBoxes area_boxes;
+	BoxesSoA selected_boxes;
+	BoxesSoA colliding_boxes;
+	StdVector<uint8_t> mask;
+};
+
+MoverScratch &get_tls_scratch() {
+	static thread_local MoverScratch tls_scratch;
+	return tls_scratch;
+}
+
 AABB expand_with_vector(AABB box, Vector3 v) {
 	if (v.x > 0) {
 		box.size.x += v.x;
@@ -36,31 +113,40 @@ AABB expand_with_vector(AABB box, Vector3 v) {
 	return box;
 }
 
-real_t calculate_i_offset(const AABB &box, AABB other, real_t motion, int i, int j, int k) {
+// Clamps the motion of `box` along axis `i` so it doesn't go through any of the given boxes
+real_t sweep_axis(const BoxesSoA &boxes, const AABB &box, real_t motion, int i, int j, int k) {
 	const real_t EPSILON = 0.001;
 
-	const Vector3 other_end = other.position + other.size;
 	const Vector3 box_end = box.position + box.size;
 
-	if (other_end[k] <= box.position[k] || other.position[k] >= box_end[k]) {
-		return motion;
-	}
+	const real_t *min_i = boxes.min[i].data();
+	const real_t *min_j = boxes.min[j].data();
+	const real_t *min_k = boxes.min[k].data();
+	const real_t *max_i = boxes.max[i].data();
+	const real_t *max_j = boxes.max[j].data();
+	const real_t *max_k = boxes.max[k].data();
 
-	if (other_end[j] <= box.position[j] || other.position[j] >= box_end[j]) {
-		return motion;
-	}
+	for (unsigned int bi = 0; bi < boxes.size(); ++bi) {
+		if (box_end[k] <= min_k[bi] || box.position[k] >= max_k[bi]) {
+			continue;
+		}
 
-	if (motion > 0.0 && other_end[i] <= box.position[i]) {
-		const real_t off = box.position[i] - other_end[i] - EPSILON;
-		if (off < motion) {
-			motion = off;
+		if (box_end[j] <= min_j[bi] || box.position[j] >= max_j[bi]) {
+			continue;
+		}
+
+		if (motion > 0.0 && box_end[i] <= min_i[bi]) {
+			const real_t off = min_i[bi] - box_end[i] - EPSILON;
+			if (off < motion) {
+				motion = off;
+			}
 		}
-	}
 
-	if (motion < 0.0 && other.position[i] >= box_end[i]) {
-		const real_t off = box_end[i] - other.position[i] + EPSILON;
-		if (off > motion) {
-			motion = off;
+		if (motion < 0.0 && box.position[i] >= max_i[bi]) {
+			const real_t off = max_i[bi] - box.position[i] + EPSILON;
+			if (off > motion) {
+				motion = off;
+			}
 		}
 	}
 
@@ -85,16 +171,22 @@ real_t calculate_i_offset(const AABB &box, AABB other, real_t motion, int i, int
 //
 // TODO one way to fix this would be to try a "hot side" projection instead
 //
-Vector3 get_motion(AABB box, Vector3 motion, Span<const AABB> environment_boxes) {
+Vector3 get_motion(AABB box, Vector3 motion, const BoxesSoA &environment_boxes, BoxesSoA &colliding_boxes) {
 	// The bounding box is expanded to include it's estimated version at next update.
 	// This also makes the algorithm tunnelling-free
 	const AABB expanded_box = expand_with_vector(box, motion);
-
-	StdVector<AABB> colliding_boxes;
-	for (size_t i = 0; i < environment_boxes.size(); ++i) {
-		const AABB &other = environment_boxes[i];
-		if (expanded_box.intersects(other)) {
-			colliding_boxes.push_back(other);
+	const Vector3 expanded_box_end = expanded_box.position + expanded_box.size;
+
+	colliding_boxes.clear();
+	for (unsigned int i = 0; i < environment_boxes.size(); ++i) {
+		// Same as `AABB::intersects`
+		if (expanded_box.position.x < environment_boxes.max[0][i] &&
+			expanded_box_end.x > environment_boxes.min[0][i] &&
+			expanded_box.position.y < environment_boxes.max[1][i] &&
+			expanded_box_end.y > environment_boxes.min[1][i] &&
+			expanded_box.position.z < environment_boxes.max[2][i] &&
+			expanded_box_end.z > environment_boxes.min[2][i]) {
+			colliding_boxes.push_back_from(environment_boxes, i);
 		}
 	}
 
@@ -106,19 +198,13 @@ Vector3 get_motion(AABB box, Vector3 motion, Span<const AABB> environment_boxes)
 
 	Vector3 new_motion = motion;
 
-	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
-		new_motion.y = calculate_i_offset(colliding_boxes[i], box, new_motion.y, 1, 0, 2);
-	}
+	new_motion.y = sweep_axis(colliding_boxes, box, new_motion.y, 1, 0, 2);
 	box.position.y += new_motion.y;
 
-	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
-		new_motion.x = calculate_i_offset(colliding_boxes[i], box, new_motion.x, 0, 1, 2);
-	}
+	new_motion.x = sweep_axis(colliding_boxes, box, new_motion.x, 0, 1, 2);
 	box.position.x += new_motion.x;
 
-	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
-		new_motion.z = calculate_i_offset(colliding_boxes[i], box, new_motion.z, 2, 1, 0);
-	}
+	new_motion.z = sweep_axis(colliding_boxes, box, new_motion.z, 2, 1, 0);
 	box.position.z += new_motion.z;
 
 	return new_motion;
@@ -155,16 +241,18 @@ inline Vector2 get_xz(Vector3 v) {
 	return Vector2(v.x, v.z);
 }
 
-bool boxcast_down(Span<const AABB> aabbs, Vector2 box_pos, Vector2 box_size, real_t &out_hit_y) {
-	if (aabbs.size() == 0) {
+bool boxcast_down(const BoxesSoA &boxes, Vector2 box_pos, Vector2 box_size, real_t &out_hit_y) {
+	if (boxes.size() == 0) {
 		return false;
 	}
+	const Vector2 box_end = box_pos + box_size;
 	bool hit = false;
 	real_t max_y = -9999999;
-	for (unsigned int i = 0; i < aabbs.size(); ++i) {
-		const AABB &aabb = aabbs[i];
-		if (Rect2(box_pos, box_size).intersects(Rect2(get_xz(aabb.position), get_xz(aabb.size)))) {
-			const real_t box_top = aabb.position.y + aabb.size.y;
+	for (unsigned int i = 0; i < boxes.size(); ++i) {
+		// Same as `Rect2::intersects` on the XZ plane
+		if (box_pos.x < boxes.max[0][i] && box_end.x > boxes.min[0][i] && //
+			box_pos.y < boxes.max[2][i] && box_end.y > boxes.min[2][i]) {
+			const real_t box_top = boxes.max[1][i];
 			if (hit) {
 				max_y = math::max(box_top, max_y);
 			} else {
@@ -177,154 +265,491 @@ bool boxcast_down(Span<const AABB> aabbs, Vector2 box_pos, Vector2 box_size, rea
 	return hit;
 }
 
-bool intersects(Span<const AABB> aabbs, const AABB &box) {
-	for (unsigned int i = 0; i < aabbs.size(); ++i) {
-		if (aabbs[i].intersects(box)) {
+bool intersects(const BoxesSoA &boxes, const AABB &box) {
+	const Vector3 box_end = box.position + box.size;
+	for (unsigned int i = 0; i < boxes.size(); ++i) {
+		if (box.position.x < boxes.max[0][i] && box_end.x > boxes.min[0][i] && //
+			box.position.y < boxes.max[1][i] && box_end.y > boxes.min[1][i] && //
+			box.position.z < boxes.max[2][i] && box_end.z > boxes.min[2][i]) {
 			return true;
 		}
 	}
 	return false;
 }
 
-void collect_boxes(VoxelTerrain &p_terrain, AABB query_box, uint32_t collision_nask, StdVector<AABB> &potential_boxes) {
-	ZN_PROFILE_SCOPE();
-	const VoxelData &voxels = p_terrain.get_storage();
-
-	const int min_x = int(Math::floor(query_box.position.x));
-	const int min_y = int(Math::floor(query_box.position.y));
-	const int min_z = int(Math::floor(query_box.position.z));
-
-	const Vector3 query_box_end = query_box.position + query_box.size;
-	const int max_x = int(Math::ceil(query_box_end.x));
-	const int max_y = int(Math::ceil(query_box_end.y));
-	const int max_z = int(Math::ceil(query_box_end.z));
+// Voxels touched by a box
+Box3i get_voxel_box(const AABB &box) {
+	const Vector3 box_min = box.position;
+	const Vector3 box_max = box.position + box.size;
+	return Box3i::from_min_max(
+			Vector3i(int(Math::floor(box_min.x)), int(Math::floor(box_min.y)), int(Math::floor(box_min.z))),
+			Vector3i(int(Math::ceil(box_max.x)), int(Math::ceil(box_max.y)), int(Math::ceil(box_max.z)))
+	);
+}
 
-	Vector3i i(min_x, min_y, min_z);
+// Where collision boxes come from
+struct CollisionSource {
+	enum Type { //
+		TYPE_NONE,
+		TYPE_BLOCKY,
+		TYPE_CUBES
+	};
+
+	Type type = TYPE_NONE;
+	VoxelData *data = nullptr;
+	const VoxelBlockyLibraryBase::BakedData *baked_data = nullptr;
+	uint32_t collision_mask = 0;
+};
+
+CollisionSource get_collision_source(VoxelTerrain &terrain, uint32_t collision_mask) {
+	CollisionSource source;
+	source.data = &terrain.get_storage();
+	source.collision_mask = collision_mask;
 
 	Ref<VoxelMesherBlocky> mesher_blocky;
 	Ref<VoxelMesherCubes> mesher_cubes;
 
-	if (zylann::godot::try_get_as(p_terrain.get_mesher(), mesher_blocky)) {
+	if (zylann::godot::try_get_as(terrain.get_mesher(), mesher_blocky)) {
 		Ref<VoxelBlockyLibraryBase> library_ref = mesher_blocky->get_library();
-		ERR_FAIL_COND_MSG(library_ref.is_null(), "VoxelMesherBlocky has no library assigned");
-		const int channel = VoxelBuffer::CHANNEL_TYPE;
-		VoxelSingleValue defval;
-		defval.i = 0;
+		ERR_FAIL_COND_V_MSG(library_ref.is_null(), source, "VoxelMesherBlocky has no library assigned");
+		source.type = CollisionSource::TYPE_BLOCKY;
+		// The library is kept alive by the mesher
+		source.baked_data = &library_ref->get_baked_data();
 
-		const VoxelBlockyLibraryBase::BakedData &baked_data = library_ref->get_baked_data();
+	} else if (zylann::godot::try_get_as(terrain.get_mesher(), mesher_cubes)) {
+		source.type = CollisionSource::TYPE_CUBES;
+	}
 
-		// TODO Optimization: read the whole box of voxels at once, querying individually is slower
-		for (i.z = min_z; i.z < max_z; ++i.z) {
-			for (i.y = min_y; i.y < max_y; ++i.y) {
-				for (i.x = min_x; i.x < max_x; ++i.x) {
-					const int type_id = voxels.get_voxel(i, channel, defval).i;
+	return source;
+}
 
-					if (baked_data.has_model(type_id)) {
-						const VoxelBlockyModel::BakedData &model = baked_data.models[type_id];
+inline void add_voxel_boxes(const CollisionSource &source, Vector3i pos, uint64_t value, VoxelBoxes &out_boxes) {
+	if (source.type == CollisionSource::TYPE_BLOCKY) {
+		const VoxelBlockyLibraryBase::BakedData &baked_data = *source.baked_data;
+		if (!baked_data.has_model(value)) {
+			return;
+		}
+		const VoxelBlockyModel::BakedData &model = baked_data.models[value];
+		if ((model.box_collision_mask & source.collision_mask) == 0) {
+			return;
+		}
+		for (const AABB &aabb : model.box_collision_aabbs) {
+			out_boxes.push_back(AABB(aabb.position + to_vec3(pos), aabb.size), pos);
+		}
 
-						if ((model.box_collision_mask & collision_nask) == 0) {
-							continue;
-						}
+	} else if (value != 0) {
+		out_boxes.push_back(AABB(to_vec3(pos), Vector3(1, 1, 1)), pos);
+	}
+}
 
-						for (const AABB &aabb : model.box_collision_aabbs) {
-							AABB world_box = aabb;
-							world_box.position += i;
-							potential_boxes.push_back(world_box);
-						}
+void collect_boxes(const CollisionSource &source, const Box3i voxel_box, VoxelBoxes &out_boxes) {
+	ZN_PROFILE_SCOPE();
+	out_boxes.clear();
+
+	if (source.type == CollisionSource::TYPE_NONE || voxel_box.is_empty()) {
+		return;
+	}
+
+	VoxelData &data = *source.data;
+	const unsigned int channel =
+			source.type == CollisionSource::TYPE_BLOCKY ? VoxelBuffer::CHANNEL_TYPE : VoxelBuffer::CHANNEL_COLOR;
+	const unsigned int block_size_po2 = data.get_block_size_po2();
+	const int block_size = 1 << block_size_po2;
+	SpatialLock3D &spatial_lock = data.get_spatial_lock(0);
+
+	// Voxels are read from each block directly, instead of looking up and locking a block for every voxel
+	const Box3i blocks_box = voxel_box.downscaled(block_size);
+
+	blocks_box.for_each_cell([&](Vector3i bpos) {
+		const Vector3i block_origin = bpos << block_size_po2;
+		const Box3i box = Box3i(block_origin, Vector3iUtil::create(block_size)).clipped(voxel_box);
+		const Vector3i max_pos = box.position + box.size;
+		Vector3i pos;
+
+		spatial_lock.lock_read(BoxBounds3i::from_position(bpos));
+		std::shared_ptr<VoxelBuffer> voxels = data.try_get_block_voxels(bpos);
+
+		if (voxels != nullptr) {
+			for (pos.z = box.position.z; pos.z < max_pos.z; ++pos.z) {
+				for (pos.y = box.position.y; pos.y < max_pos.y; ++pos.y) {
+					for (pos.x = box.position.x; pos.x < max_pos.x; ++pos.x) {
+						add_voxel_boxes(source, pos, voxels->get_voxel(pos - block_origin, channel), out_boxes);
 					}
 				}
 			}
-		}
-
-	} else if (zylann::godot::try_get_as(p_terrain.get_mesher(), mesher_cubes)) {
-		const int channel = VoxelBuffer::CHANNEL_COLOR;
-		VoxelSingleValue defval;
-		defval.i = 0;
-
-		// TODO Optimization: read the whole box of voxels at once, querying individually is slower
-		for (i.z = min_z; i.z < max_z; ++i.z) {
-			for (i.y = min_y; i.y < max_y; ++i.y) {
-				for (i.x = min_x; i.x < max_x; ++i.x) {
-					const int color_data = voxels.get_voxel(i, channel, defval).i;
-					if (color_data != 0) {
-						potential_boxes.push_back(AABB(i, Vector3(1, 1, 1)));
+			spatial_lock.unlock_read(BoxBounds3i::from_position(bpos));
+
+		} else {
+			spatial_lock.unlock_read(BoxBounds3i::from_position(bpos));
+
+			// Not loaded, or not edited and coming from the generator
+			VoxelSingleValue defval;
+			defval.i = 0;
+			for (pos.z = box.position.z; pos.z < max_pos.z; ++pos.z) {
+				for (pos.y = box.position.y; pos.y < max_pos.y; ++pos.y) {
+					for (pos.x = box.position.x; pos.x < max_pos.x; ++pos.x) {
+						add_voxel_boxes(source, pos, data.get_voxel(pos, channel, defval).i, out_boxes);
 					}
 				}
 			}
 		}
-	}
+	});
 }
 
-} // namespace
+// Gets the boxes coming from voxels inside an area, out of boxes collected in a bigger area. They come out in the same
+// order as if they were collected from the smaller area directly.
+void select_boxes(const VoxelBoxes &src, const Box3i voxel_box, BoxesSoA &dst, StdVector<uint8_t> &mask) {
+	const unsigned int count = src.boxes.size();
+	const Vector3i min_pos = voxel_box.position;
+	const Vector3i max_pos = voxel_box.position + voxel_box.size;
+	const int32_t *xs = src.voxel_positions[0].data();
+	const int32_t *ys = src.voxel_positions[1].data();
+	const int32_t *zs = src.voxel_positions[2].data();
+
+	// Branchless, so the compiler can vectorize it
+	mask.resize(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		mask[i] = (xs[i] >= min_pos.x) & (xs[i] < max_pos.x) & //
+				(ys[i] >= min_pos.y) & (ys[i] < max_pos.y) & //
+				(zs[i] >= min_pos.z) & (zs[i] < max_pos.z);
+	}
 
-Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, VoxelTerrain &p_terrain) {
-	ZN_PROFILE_SCOPE();
-	// The mesher is required to know how collisions should be processed
-	ERR_FAIL_COND_V(p_terrain.get_mesher().is_null(), Vector3());
+	dst.clear();
+	for (unsigned int i = 0; i < count; ++i) {
+		if (mask[i] != 0) {
+			dst.push_back_from(src.boxes, i);
+		}
+	}
+}
 
-	// Transform to local in case the volume is transformed
-	const Transform3D to_world = p_terrain.get_global_transform();
-	const Transform3D to_local = to_world.affine_inverse();
-	const Vector3 pos = to_local.xform(p_pos);
-	const Vector3 motion = to_local.basis.xform(p_motion);
-	const AABB aabb = Transform3D(to_local.basis, Vector3()).xform(p_aabb);
+struct StepClimbingSettings {
+	bool enabled;
+	real_t max_height;
+};
+
+// Raise a box slightly higher than steps it climbs, to avoid precision issues
+const real_t STEP_CLIMBING_EPSILON = 0.0001f;
+
+// Gets the motion of a box in the local space of the terrain.
+// `get_boxes` is a function taking a `Box3i` area in voxels, and returning the `BoxesSoA` collision boxes of the voxels
+// in that area. They remain valid until the next call.
+template <typename FGetBoxes>
+Vector3 move_box(
+		const AABB box,
+		const Vector3 motion,
+		const StepClimbingSettings step_climbing,
+		FGetBoxes get_boxes,
+		bool &out_stepped_up
+) {
+	BoxesSoA &colliding_boxes = get_tls_scratch().colliding_boxes;
 
-	const AABB box(aabb.position + pos, aabb.size);
 	const AABB expanded_box = expand_with_vector(box, motion);
 
-	static thread_local StdVector<AABB> s_colliding_boxes;
-	StdVector<AABB> &potential_boxes = s_colliding_boxes;
-	potential_boxes.clear();
-
 	// Collect potential collisions with the terrain (broad phase)
 	// TODO If motion is really big, we may want something more optimal or reject it
-	collect_boxes(p_terrain, expanded_box, _collision_mask, potential_boxes);
+	const BoxesSoA &potential_boxes = get_boxes(get_voxel_box(expanded_box));
 
 	// Calculate collisions (narrow phase)
-	Vector3 slided_motion = zylann::voxel::get_motion(box, motion, to_span(potential_boxes));
+	Vector3 slided_motion = get_motion(box, motion, potential_boxes, colliding_boxes);
 
 	// Minecraft-style stair climbing:
 	// If we were moving, changed horizontal direction due to collision, and resulting motion is about horizontal
-	_has_stepped_up = false;
-	if (_step_climbing_enabled &&
-			// Movement is horizontal?
-			Math::abs(slided_motion.y) < 0.001 && Vector2(motion.x, motion.z).length_squared() > 0.0001 &&
-			// Motor movement isn't the same as resulting slided motion?
-			Vector2(motion.x, motion.z).normalized().dot(Vector2(slided_motion.x, slided_motion.z).normalized()) <
-					0.99) {
+	out_stepped_up = false;
+	if (step_climbing.enabled &&
+		// Movement is horizontal?
+		Math::abs(slided_motion.y) < 0.001 && Vector2(motion.x, motion.z).length_squared() > 0.0001 &&
+		// Motor movement isn't the same as resulting slided motion?
+		Vector2(motion.x, motion.z).normalized().dot(Vector2(slided_motion.x, slided_motion.z).normalized()) < 0.99) {
 		// We hit an obstacle
 		real_t hit_y;
 		// Find out the height of the step
-		if (boxcast_down(to_span(potential_boxes), get_xz(expanded_box.position), get_xz(expanded_box.size), hit_y)) {
+		if (boxcast_down(potential_boxes, get_xz(expanded_box.position), get_xz(expanded_box.size), hit_y)) {
 			// If the step is up and not too high
-			if (hit_y > box.position.y && (hit_y - box.position.y) <= _max_step_height) {
+			if (hit_y > box.position.y && (hit_y - box.position.y) <= step_climbing.max_height) {
 				// Check if we would fit if we move the box above the step.
 				// Raise it slightly higher to avoid precision issues. Even if the final motion would move the box
 				// exactly on top of the stair, gameplay code could do some additional calculations with that motion
 				// (converting it to velocity?) which may induce precision errors causing the box to fall through.
-				const real_t epsilon = 0.0001f;
 				const AABB hyp_box(
-						Vector3(box.position.x + motion.x, hit_y + epsilon, box.position.z + motion.z), box.size);
+						Vector3(box.position.x + motion.x, hit_y + STEP_CLIMBING_EPSILON, box.position.z + motion.z),
+						box.size
+				);
 
-				potential_boxes.clear();
-				collect_boxes(p_terrain, hyp_box, _collision_mask, potential_boxes);
+				const BoxesSoA &hyp_boxes = get_boxes(get_voxel_box(hyp_box));
 
 				// If the box fits on top of the step
-				if (!intersects(to_span(potential_boxes), hyp_box)) {
+				if (!intersects(hyp_boxes, hyp_box)) {
 					// Change motion so that it brings the box on top of the step
 					slided_motion = hyp_box.position - box.position;
-					_has_stepped_up = true;
+					out_stepped_up = true;
 				}
 			}
 		}
 	}
 
+	return slided_motion;
+}
+
+// Area in which a box may need collision boxes when moving
+AABB get_query_box(const AABB &box, Vector3 motion, const StepClimbingSettings step_climbing) {
+	const AABB expanded_box = expand_with_vector(box, motion);
+	if (!step_climbing.enabled) {
+		return expanded_box;
+	}
+	// When climbing, the box is also tested on top of the step it hit. Padded a bit more to account for precision.
+	const real_t climb_height = step_climbing.max_height + 2 * STEP_CLIMBING_EPSILON;
+	const AABB climb_box(
+			Vector3(expanded_box.position.x, box.position.y, expanded_box.position.z),
+			Vector3(expanded_box.size.x, box.size.y + climb_height, expanded_box.size.z)
+	);
+	return expanded_box.merge(climb_box);
+}
+
+struct BatchAgent {
+	// In local space of the terrain
+	AABB box;
+	Vector3 motion;
+};
+
+// Agents close to each other, sharing the same voxels
+struct AgentGroup {
+	Box3i voxel_box;
+	StdVector<uint32_t> agent_indices;
+};
+
+struct MotionBatch {
+	CollisionSource source;
+	StepClimbingSettings step_climbing;
+	Basis to_world_basis;
+	Span<const BatchAgent> agents;
+	Span<const AgentGroup> groups;
+	Span<Vector3> out_motions;
+	Span<uint8_t> out_stepped_up;
+
+	void process_group(unsigned int group_index) const {
+		ZN_PROFILE_SCOPE();
+		const AgentGroup &group = groups[group_index];
+		MoverScratch &scratch = get_tls_scratch();
+
+		collect_boxes(source, group.voxel_box, scratch.group_boxes);
+
+		for (const uint32_t agent_index : group.agent_indices) {
+			const BatchAgent &agent = agents[agent_index];
+			bool stepped_up;
+
+			const Vector3 motion = move_box(
+					agent.box,
+					agent.motion,
+					step_climbing,
+					[this, &group, &scratch](const Box3i voxel_box) -> const BoxesSoA & {
+						if (group.voxel_box.contains(voxel_box)) {
+							select_boxes(scratch.group_boxes, voxel_box, scratch.selected_boxes, scratch.mask);
+							return scratch.selected_boxes;
+						}
+						// Not expected, but fallback on reading voxels
+						collect_boxes(source, voxel_box, scratch.area_boxes);
+						return scratch.area_boxes.boxes;
+					},
+					stepped_up
+			);
+
+			out_motions[agent_index] = to_world_basis.xform(motion);
+			out_stepped_up[agent_index] = stepped_up;
+		}
+	}
+};
+
+// Groups are claimed from a shared counter by the calling thread and by helper tasks. Helpers that start after all
+// groups were claimed do nothing, so the caller never waits for a task that didn't start.
+struct ParallelMotionBatchSync {
+	std::atomic_uint32_t next_index = { 0 };
+	std::atomic_uint32_t remaining_count = { 0 };
+	unsigned int group_count = 0;
+	// Only accessed after claiming a group, because it stops being valid once all groups are processed
+	const MotionBatch *batch = nullptr;
+	// Posted by the helper that completes the last group
+	Semaphore completion;
+};
+
+// Returns true if the calling thread completed the last group
+bool process_claimed_groups(ParallelMotionBatchSync &sync) {
+	bool completed_last = false;
+	while (true) {
+		const uint32_t i = sync.next_index.fetch_add(1);
+		if (i >= sync.group_count) {
+			break;
+		}
+		sync.batch->process_group(i);
+		if (sync.remaining_count.fetch_sub(1) == 1) {
+			completed_last = true;
+		}
+	}
+	return completed_last;
+}
+
+class ProcessMotionBatchTask : public IThreadedTask {
+public:
+	ProcessMotionBatchTask(std::shared_ptr<ParallelMotionBatchSync> sync) : _sync(sync) {}
+
+	void run(ThreadedTaskContext &ctx) override {
+		ZN_PROFILE_SCOPE();
+		if (process_claimed_groups(*_sync)) {
+			_sync->completion.post();
+		}
+	}
+
+	const char *get_debug_name() const override {
+		return "ProcessMotionBatch";
+	}
+
+private:
+	std::shared_ptr<ParallelMotionBatchSync> _sync;
+};
+
+void process_motion_batch(const MotionBatch &batch, bool parallel) {
+	const unsigned int group_count = batch.groups.size();
+
+	if (!parallel || group_count <= 1) {
+		for (unsigned int i = 0; i < group_count; ++i) {
+			batch.process_group(i);
+		}
+		return;
+	}
+
+	std::shared_ptr<ParallelMotionBatchSync> sync = make_shared_instance<ParallelMotionBatchSync>();
+	sync->group_count = group_count;
+	sync->remaining_count = group_count;
+	sync->batch = &batch;
+
+	// The current thread processes groups too
+	FixedArray<IThreadedTask *, ThreadedTaskRunner::MAX_THREADS> tasks;
+	const unsigned int task_count = math::min(group_count - 1, static_cast<unsigned int>(tasks.size()));
+	for (unsigned int i = 0; i < task_count; ++i) {
+		tasks[i] = ZN_NEW(ProcessMotionBatchTask(sync));
+	}
+	VoxelEngine::get_singleton().push_async_tasks(to_span(tasks, task_count));
+
+	if (!process_claimed_groups(*sync)) {
+		// Helpers are still processing the groups they claimed
+		sync->completion.wait();
+	}
+}
+
+// Terrains outside of the scene tree have no global transform, their local one is used instead
+Transform3D get_terrain_to_world(const VoxelTerrain &terrain) {
+	return terrain.is_inside_tree() ? terrain.get_global_transform() : terrain.get_transform();
+}
+
+} // namespace
+
+Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, VoxelTerrain &p_terrain) {
+	ZN_PROFILE_SCOPE();
+	// The mesher is required to know how collisions should be processed
+	ERR_FAIL_COND_V(p_terrain.get_mesher().is_null(), Vector3());
+
+	// Transform to local in case the volume is transformed
+	const Transform3D to_world = get_terrain_to_world(p_terrain);
+	const Transform3D to_local = to_world.affine_inverse();
+	const Vector3 pos = to_local.xform(p_pos);
+	const Vector3 motion = to_local.basis.xform(p_motion);
+	const AABB aabb = Transform3D(to_local.basis, Vector3()).xform(p_aabb);
+
+	const AABB box(aabb.position + pos, aabb.size);
+
+	const CollisionSource source = get_collision_source(p_terrain, _collision_mask);
+	VoxelBoxes &area_boxes = get_tls_scratch().area_boxes;
+
+	const Vector3 slided_motion = move_box(
+			box,
+			motion,
+			StepClimbingSettings{ _step_climbing_enabled, _max_step_height },
+			[&source, &area_boxes](const Box3i voxel_box) -> const BoxesSoA & {
+				collect_boxes(source, voxel_box, area_boxes);
+				return area_boxes.boxes;
+			},
+			_has_stepped_up
+	);
+
 	// Switch back to world
 	const Vector3 world_slided_motion = to_world.basis.xform(slided_motion);
 
 	return world_slided_motion;
 }
 
+void VoxelBoxMover::get_motions(
+		Span<const Vector3> positions,
+		Span<const Vector3> motions,
+		Span<const AABB> aabbs,
+		VoxelTerrain &terrain,
+		Span<Vector3> out_motions
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(motions.size() == positions.size());
+	ZN_ASSERT_RETURN(aabbs.size() == positions.size() || aabbs.size() == 1);
+	ZN_ASSERT_RETURN(out_motions.size() == positions.size());
+
+	_stepped_up_in_batch.resize(positions.size());
+	to_span(_stepped_up_in_batch).fill(0);
+
+	if (terrain.get_mesher().is_null()) {
+		// Same as `get_motion`
+		out_motions.fill(Vector3());
+		ERR_FAIL_MSG("The mesher is required to know how collisions should be processed");
+	}
+
+	// Transform to local in case the volume is transformed
+	const Transform3D to_world = get_terrain_to_world(terrain);
+	const Transform3D to_local = to_world.affine_inverse();
+	const Transform3D to_local_basis(to_local.basis, Vector3());
+
+	const StepClimbingSettings step_climbing{ _step_climbing_enabled, _max_step_height };
+
+	StdVector<BatchAgent> agents;
+	agents.resize(positions.size());
+
+	StdVector<AgentGroup> groups;
+	StdUnorderedMap<Vector3i, uint32_t> group_indices;
+
+	// Agents are grouped by the area they are in, so voxels are read once for all agents of that area. Areas are small
+	// enough to not read a lot of voxels no agent needs.
+	const unsigned int group_area_size_po2 = 4;
+
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		const AABB aabb = to_local_basis.xform(aabbs.size() == 1 ? aabbs[0] : aabbs[i]);
+
+		BatchAgent &agent = agents[i];
+		agent.box = AABB(aabb.position + to_local.xform(positions[i]), aabb.size);
+		agent.motion = to_local.basis.xform(motions[i]);
+
+		const Box3i voxel_box = get_voxel_box(get_query_box(agent.box, agent.motion, step_climbing));
+		const Vector3i group_key = (voxel_box.position + voxel_box.size / 2) >> group_area_size_po2;
+
+		auto it = group_indices.find(group_key);
+		if (it == group_indices.end()) {
+			group_indices.insert({ group_key, groups.size() });
+			AgentGroup group;
+			group.voxel_box = voxel_box;
+			group.agent_indices.push_back(i);
+			groups.push_back(std::move(group));
+		} else {
+			AgentGroup &group = groups[it->second];
+			group.voxel_box.merge_with(voxel_box);
+			group.agent_indices.push_back(i);
+		}
+	}
+
+	MotionBatch batch;
+	batch.source = get_collision_source(terrain, _collision_mask);
+	batch.step_climbing = step_climbing;
+	batch.to_world_basis = to_world.basis;
+	batch.agents = to_span(agents);
+	batch.groups = to_span(groups);
+	batch.out_motions = out_motions;
+	batch.out_stepped_up = to_span(_stepped_up_in_batch);
+
+	process_motion_batch(batch, _threaded_batches_enabled);
+}
+
 void VoxelBoxMover::set_collision_mask(uint32_t mask) {
 	_collision_mask = mask;
 }
@@ -341,6 +766,11 @@ bool VoxelBoxMover::has_stepped_up() const {
 	return _has_stepped_up;
 }
 
+bool VoxelBoxMover::has_stepped_up_in_batch(unsigned int index) const {
+	ZN_ASSERT_RETURN_V(index < _stepped_up_in_batch.size(), false);
+	return _stepped_up_in_batch[index] != 0;
+}
+
 void VoxelBoxMover::set_max_step_height(float height) {
 	_max_step_height = height;
 }
@@ -349,6 +779,14 @@ float VoxelBoxMover::get_max_step_height() const {
 	return _max_step_height;
 }
 
+void VoxelBoxMover::set_threaded_batches_enabled(bool enabled) {
+	_threaded_batches_enabled = enabled;
+}
+
+bool VoxelBoxMover::is_threaded_batches_enabled() const {
+	return _threaded_batches_enabled;
+}
+
 #if defined(ZN_GODOT)
 Vector3 VoxelBoxMover::_b_get_motion(Vector3 pos, Vector3 motion, AABB aabb, Node *terrain_node) {
 #elif defined(ZN_GODOT_EXTENSION)
@@ -361,8 +799,51 @@ Vector3 VoxelBoxMover::_b_get_motion(Vector3 pos, Vector3 motion, AABB aabb, Obj
 	return get_motion(pos, motion, aabb, *terrain);
 }
 
+#if defined(ZN_GODOT)
+PackedVector3Array VoxelBoxMover::_b_get_motions(
+		PackedVector3Array positions,
+		PackedVector3Array motions,
+		Array aabbs,
+		Node *terrain_node
+) {
+#elif defined(ZN_GODOT_EXTENSION)
+PackedVector3Array VoxelBoxMover::_b_get_motions(
+		PackedVector3Array positions,
+		PackedVector3Array motions,
+		Array aabbs,
+		Object *terrain_node_o
+) {
+	Node *terrain_node = Object::cast_to<Node>(terrain_node_o);
+#endif
+	PackedVector3Array out_motions;
+	ERR_FAIL_COND_V(terrain_node == nullptr, out_motions);
+	VoxelTerrain *terrain = Object::cast_to<VoxelTerrain>(terrain_node);
+	ERR_FAIL_COND_V(terrain == nullptr, out_motions);
+	ERR_FAIL_COND_V(positions.size() != motions.size(), out_motions);
+	ERR_FAIL_COND_V(aabbs.size() != positions.size() && aabbs.size() != 1, out_motions);
+
+	StdVector<AABB> aabbs_vec;
+	aabbs_vec.resize(aabbs.size());
+	for (int i = 0; i < aabbs.size(); ++i) {
+		aabbs_vec[i] = aabbs[i];
+	}
+
+	out_motions.resize(positions.size());
+	get_motions(
+			to_span(positions),
+			to_span(motions),
+			to_span(aabbs_vec),
+			*terrain,
+			Span<Vector3>(out_motions.ptrw(), out_motions.size())
+	);
+	return out_motions;
+}
+
 void VoxelBoxMover::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_motion", "pos", "motion", "aabb", "terrain"), &VoxelBoxMover::_b_get_motion);
+	ClassDB::bind_method(
+			D_METHOD("get_motions", "positions", "motions", "aabbs", "terrain"), &VoxelBoxMover::_b_get_motions
+	);
 
 	ClassDB::bind_method(D_METHOD("set_collision_mask", "mask"), &VoxelBoxMover::set_collision_mask);
 	ClassDB::bind_method(D_METHOD("get_collision_mask"), &VoxelBoxMover::get_collision_mask);
@@ -374,6 +855,12 @@ void VoxelBoxMover::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_max_step_height"), &VoxelBoxMover::get_max_step_height);
 
 	ClassDB::bind_method(D_METHOD("has_stepped_up"), &VoxelBoxMover::has_stepped_up);
+	ClassDB::bind_method(D_METHOD("has_stepped_up_in_batch", "index"), &VoxelBoxMover::has_stepped_up_in_batch);
+
+	ClassDB::bind_method(
+			D_METHOD("set_threaded_batches_enabled", "enabled"), &VoxelBoxMover::set_threaded_batches_enabled
+	);
+	ClassDB::bind_method(D_METHOD("is_threaded_batches_enabled"), &VoxelBoxMover::is_threaded_batches_enabled);
 }
 
 } // namespace zylann::voxel
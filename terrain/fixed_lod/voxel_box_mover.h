@@ -1,7 +1,11 @@
 #ifndef VOXEL_BOX_MOVER_H
 #define VOXEL_BOX_MOVER_H
 
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/ref_counted.h"
+#include "../../util/godot/core/array.h"
+#include "../../util/godot/core/packed_arrays.h"
 #include "../../util/godot/macros.h"
 
 ZN_GODOT_FORWARD_DECLARE(class Node);
@@ -16,6 +20,17 @@ class VoxelBoxMover : public RefCounted {
 public:
 	Vector3 get_motion(Vector3 pos, Vector3 motion, AABB aabb, VoxelTerrain &terrain);
 
+	// Moves many boxes at once, with the same result as calling `get_motion` for each of them. Voxels are read once for
+	// boxes close to each other, and groups of boxes can be processed on the thread pool.
+	// `aabbs` must have one box per position, or a single box used for all of them.
+	void get_motions(
+			Span<const Vector3> positions,
+			Span<const Vector3> motions,
+			Span<const AABB> aabbs,
+			VoxelTerrain &terrain,
+			Span<Vector3> out_motions
+	);
+
 	void set_collision_mask(uint32_t mask);
 	inline uint32_t get_collision_mask() const {
 		return _collision_mask;
@@ -28,13 +43,29 @@ public:
 	float get_max_step_height() const;
 
 	bool has_stepped_up() const;
+	bool has_stepped_up_in_batch(unsigned int index) const;
+
+	void set_threaded_batches_enabled(bool enabled);
+	bool is_threaded_batches_enabled() const;
 
 private:
 #if defined(ZN_GODOT)
 	Vector3 _b_get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, Node *p_terrain_node);
+	PackedVector3Array _b_get_motions(
+			PackedVector3Array p_positions,
+			PackedVector3Array p_motions,
+			Array p_aabbs,
+			Node *p_terrain_node
+	);
 #elif defined(ZN_GODOT_EXTENSION)
 	// TODO GDX: it seems binding a method taking a `Node*` fails to compile. It is supposed to be working.
 	Vector3 _b_get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, Object *p_terrain_node_o);
+	PackedVector3Array _b_get_motions(
+			PackedVector3Array p_positions,
+			PackedVector3Array p_motions,
+			Array p_aabbs,
+			Object *p_terrain_node_o
+	);
 #endif
 
 	static void _bind_methods();
@@ -43,9 +74,12 @@ private:
 	uint32_t _collision_mask = 0xffffffff; // Everything
 	bool _step_climbing_enabled = false;
 	real_t _max_step_height = 0.5;
+	bool _threaded_batches_enabled = false;
 
 	// States
 	bool _has_stepped_up = false;
+	// One per box of the last batch
+	StdVector<uint8_t> _stepped_up_in_batch;
 };
 
 } // namespace zylann::voxel
@@ -776,9 +776,7 @@ void VoxelTerrain::post_edit_area(Box3i box_in_voxels, bool update_mesh) {
 	}
 
 	if (_multiplayer_synchronizer != nullptr && _multiplayer_synchronizer->is_server()) {
-		// TODO This is not efficient when the user does many individual modifications in a specific area.
-		// We would either have to batch modified areas somehow, or expose a transactional API to the user
-		// (begin(area), edit in area, end(area))
+		// Areas are batched and sent once per frame
 		_multiplayer_synchronizer->send_area(box_in_voxels);
 	}
 
@@ -1131,7 +1129,7 @@ void VoxelTerrain::notify_data_block_enter(const VoxelDataBlock &block, Vector3i
 
 	if (_multiplayer_synchronizer != nullptr && !Engine::get_singleton()->is_editor_hint() &&
 		network_peer_id != MultiplayerPeer::TARGET_PEER_SERVER && _multiplayer_synchronizer->is_server()) {
-		_multiplayer_synchronizer->send_block(network_peer_id, block, bpos);
+		_multiplayer_synchronizer->send_block(network_peer_id, bpos);
 	}
 }
 
@@ -1930,7 +1928,13 @@ void VoxelTerrain::apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob) {
 
 	const bool gen_collisions = _generate_collisions && block->collision_viewers.get() > 0;
 	if (gen_collisions) {
-		Ref<Shape3D> collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
+		Ref<Shape3D> collision_shape;
+		if (ob.has_collision_shape) {
+			// Already built in the meshing task
+			collision_shape = ob.collision_shape;
+		} else {
+			collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
+		}
 		const bool debug_collisions = is_inside_tree() ? get_tree()->is_debugging_collisions_hint() : false;
 		block->set_collision_shape(collision_shape, debug_collisions, this, _collision_margin);
 
@@ -6,15 +6,16 @@
 #include "../../util/godot/classes/multiplayer_api.h"
 #include "../../util/godot/classes/multiplayer_peer.h"
 #include "../../util/godot/classes/scene_tree.h"
+#include "../../util/godot/classes/time.h"
 #include "../../util/godot/core/array.h"
+#include "../../util/godot/core/packed_arrays.h"
 #include "../../util/io/serialization.h"
+#include "../../util/math/conv.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 #include "voxel_terrain.h"
 
-#ifdef TOOLS_ENABLED
-#include "../../util/godot/core/packed_arrays.h"
-#endif
+#include <algorithm>
 
 namespace zylann::voxel {
 
@@ -26,7 +27,7 @@ VoxelTerrainMultiplayerSynchronizer::VoxelTerrainMultiplayerSynchronizer() {
 	config["channel"] = _rpc_channel;
 
 	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_blocks, config);
-	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_area, config);
+	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_areas, config);
 
 	set_process(true);
 }
@@ -44,76 +45,52 @@ bool VoxelTerrainMultiplayerSynchronizer::is_server() const {
 	return mp->is_server();
 }
 
-void VoxelTerrainMultiplayerSynchronizer::send_block(
-		int viewer_peer_id,
-		const VoxelDataBlock &data_block,
-		Vector3i bpos
-) {
+void VoxelTerrainMultiplayerSynchronizer::send_block(int viewer_peer_id, Vector3i bpos) {
 	ZN_PROFILE_SCOPE();
 
-	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(data_block.get_voxels_const());
-	ZN_ASSERT_RETURN(result.success);
-
-	PackedByteArray message_data;
-	message_data.resize(4 * sizeof(int16_t) + result.data.size());
-
-	ByteSpanWithPosition mw_span(Span<uint8_t>(message_data.ptrw(), message_data.size()), 0);
-	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
-
-	mw.store_16(bpos.x);
-	mw.store_16(bpos.y);
-	mw.store_16(bpos.z);
-	ZN_ASSERT_RETURN(result.data.size() <= 65535);
-	mw.store_16(result.data.size());
-	mw.store_buffer(to_span(result.data));
-
 	// print_line(String("Server: send block {0}").format(varray(bpos)));
 
 	// rpc_id(viewer_peer_id, VoxelStringNames::get_singleton().receive_block, data);
 	// Instead of sending it right away, defer it until the terrain finished processing. Sending individual blocks with
 	// the RPC system is too slow.
-	_deferred_block_messages_per_peer[viewer_peer_id].push_back(DeferredBlockMessage{ message_data });
+	PeerState &peer = _peers[viewer_peer_id];
+	if (!peer.pending_blocks.insert(bpos).second) {
+		return;
+	}
+	// The block is serialized when sent, so it won't match any snapshot version we know of
+	peer.snapshot_versions.erase(bpos);
+
+	// Edits queued for this block are now included in it
+	// Order of remaining messages must be preserved
+	peer.messages.erase(
+			std::remove_if(
+					peer.messages.begin(),
+					peer.messages.end(),
+					[bpos](const QueuedMessage &message) {
+						return message.block_position == bpos && message.type == QueuedMessage::TYPE_AREA;
+					}
+			),
+			peer.messages.end()
+	);
+
+	peer.messages.push_back(QueuedMessage{ bpos, QueuedMessage::TYPE_BLOCK });
 }
 
 // TODO Have a way to implement ghost edits?
-// If someone wants to spam edits to appear smooth on clients, this would have terrible impact on networking
-// performance. So perhaps the server needs to cluster edits that are close together, and send the area in batch.
-// Conversely, the client would have to apply the edit locally, while having a way to revert it if the server
+// Edits are batched per frame and sent as deltas, which helps when edits are spammed, but clients still see them
+// with latency. The client would have to apply the edit locally, while having a way to revert it if the server
 // isn't acknowledging it for some time.
 
 void VoxelTerrainMultiplayerSynchronizer::send_area(Box3i voxel_box) {
-	ZN_PROFILE_SCOPE();
-	ZN_ASSERT_RETURN(_terrain != nullptr);
-
-	StdVector<ViewerID> viewers;
-	_terrain->get_viewers_in_area(viewers, voxel_box);
-
-	// Not particularly efficient for single-voxel edits, but should scale ok with bigger boxes
-	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-	voxels.create(voxel_box.size);
-	_terrain->get_storage().copy(voxel_box.position, voxels, 0xff);
-
-	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(voxels);
-	ZN_ASSERT_RETURN(result.success);
-
-	PackedByteArray pba;
-	pba.resize(4 * sizeof(int32_t) + result.data.size());
+	_edited_areas.push_back(voxel_box);
+}
 
-	ByteSpanWithPosition mw_span(Span<uint8_t>(pba.ptrw(), pba.size()), 0);
-	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+void VoxelTerrainMultiplayerSynchronizer::set_max_bytes_per_peer_per_frame(int bytes) {
+	_max_bytes_per_peer_per_frame = math::max(bytes, 0);
+}
 
-	mw.store_32(voxel_box.position.x);
-	mw.store_32(voxel_box.position.y);
-	mw.store_32(voxel_box.position.z);
-	mw.store_32(result.data.size());
-	mw.store_buffer(to_span(result.data));
-	for (const ViewerID viewer_id : viewers) {
-		const int peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
-		// TODO Don't bother copying and serializing if no networked viewers are around?
-		if (peer_id != -1 && peer_id != MultiplayerPeer::TARGET_PEER_SERVER) {
-			rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_area, pba);
-		}
-	}
+int VoxelTerrainMultiplayerSynchronizer::get_max_bytes_per_peer_per_frame() const {
+	return _max_bytes_per_peer_per_frame;
 }
 
 void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
@@ -135,51 +112,416 @@ void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
 	}
 }
 
-// template <typename T, typename F>
-// inline void for_chunks(const StdVector<T> &vec, unsigned int chunk_size, F f) {
-// 	for (unsigned int i = 0; i < vec.size(); i += chunk_size) {
-// 		f(to_span_from_position_and_size(vec, i, i + chunk_size > vec.size() ? vec.size() - i : chunk_size));
-// 	}
-// }
-
 void VoxelTerrainMultiplayerSynchronizer::process() {
 	ZN_PROFILE_SCOPE();
 
-	for (auto it = _deferred_block_messages_per_peer.begin(); it != _deferred_block_messages_per_peer.end(); ++it) {
-		StdVector<DeferredBlockMessage> &messages = it->second;
+	if (_terrain == nullptr) {
+		return;
+	}
+
+	if (_edited_areas.size() > 0) {
+		flush_edited_areas();
+	}
+
+	if (_peers.size() == 0) {
+		return;
+	}
+
+	update_peer_positions();
 
-		if (messages.size() == 0) {
+	for (auto it = _peers.begin(); it != _peers.end();) {
+		if (!it->second.has_viewer) {
+			// Peer has left
+			it = _peers.erase(it);
 			continue;
 		}
+		send_queued_messages(it->first);
+		++it;
+	}
+}
+
+void VoxelTerrainMultiplayerSynchronizer::update_peer_positions() {
+	for (auto it = _peers.begin(); it != _peers.end(); ++it) {
+		it->second.has_viewer = false;
+	}
+
+	const Transform3D world_to_local_transform = _terrain->get_global_transform().affine_inverse();
+
+	// Peers usually have only one viewer. If they have more, the last one is used.
+	VoxelEngine::get_singleton().for_each_viewer(
+			[this, &world_to_local_transform](ViewerID viewer_id, const VoxelEngine::Viewer &viewer) {
+				auto it = _peers.find(viewer.network_peer_id);
+				if (it != _peers.end()) {
+					it->second.viewer_position = to_vec3f(world_to_local_transform.xform(viewer.world_position));
+					it->second.has_viewer = true;
+				}
+			}
+	);
+}
+
+namespace {
+
+// Combines voxels of `src` into `dst` with a bitwise XOR, channel by channel. Applying the same `src` twice gives back
+// the original `dst`.
+bool xor_voxels(VoxelBuffer &dst, const VoxelBuffer &src, StdVector<uint8_t> &temp) {
+	ZN_ASSERT_RETURN_V(dst.get_size() == src.get_size(), false);
 
-		PackedByteArray pba;
-		// Make one big fat message per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
-		// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by
-		// the high-level features...
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		const VoxelBuffer::Depth depth = src.get_channel_depth(channel_index);
+		ZN_ASSERT_RETURN_V(dst.get_channel_depth(channel_index) == depth, false);
 
-		unsigned int size = 0;
-		for (const DeferredBlockMessage &message : messages) {
-			size += message.data.size();
+		if (src.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+			const uint64_t src_value = src.get_voxel(Vector3i(), channel_index);
+			if (src_value == 0) {
+				continue;
+			}
+			if (dst.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+				dst.fill(dst.get_voxel(Vector3i(), channel_index) ^ src_value, channel_index);
+				continue;
+			}
 		}
 
-		pba.resize(1 * sizeof(uint32_t) + size);
+		temp.resize(VoxelBuffer::get_size_in_bytes_for_volume(src.get_size(), depth));
+		src.copy_channel_to_bytes(channel_index, to_span(temp));
 
-		ByteSpanWithPosition mw_span(Span<uint8_t>(pba.ptrw(), pba.size()), 0);
-		MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
-		mw.store_32(messages.size());
+		dst.decompress_channel(channel_index);
+		Span<uint8_t> dst_bytes;
+		ZN_ASSERT_RETURN_V(dst.get_channel_as_bytes(channel_index, dst_bytes), false);
+		ZN_ASSERT_RETURN_V(dst_bytes.size() == temp.size(), false);
 
-		for (const DeferredBlockMessage &message : messages) {
-			mw.store_buffer(Span<const uint8_t>(message.data.ptr(), message.data.size()));
+		for (size_t i = 0; i < dst_bytes.size(); ++i) {
+			dst_bytes[i] ^= temp[i];
 		}
-		ZN_ASSERT(mw.data.size() == mw.data.pos);
+	}
+
+	// Unchanged channels become zeros
+	dst.compress_uniform_channels();
+	return true;
+}
+
+bool has_same_channel_depths(const VoxelBuffer &a, const VoxelBuffer &b) {
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if (a.get_channel_depth(channel_index) != b.get_channel_depth(channel_index)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+enum AreaMessageType : uint8_t {
+	// Voxels replace those of the area
+	AREA_REPLACE = 0,
+	// Voxels are combined with those of the area using XOR
+	AREA_XOR = 1,
+};
+
+// Snapshots are only useful if more edits come soon after, such as when digging or with explosions
+constexpr uint64_t SNAPSHOT_LIFETIME_MSEC = 10000;
+constexpr unsigned int MAX_SNAPSHOTS = 256;
+
+inline uint64_t get_ticks_msec() {
+	return Time::get_singleton()->get_ticks_msec();
+}
+
+// The count is stored in the first 4 bytes, which must have been reserved
+PackedByteArray make_batch_message(StdVector<uint8_t> &data, uint32_t count) {
+	ByteSpanWithPosition mw_span(to_span(data), 0);
+	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+	mw.store_32(count);
+
+	PackedByteArray pba;
+	zylann::godot::copy_to(pba, to_span_const(data));
+	return pba;
+}
+
+PackedByteArray make_area_message(AreaMessageType type, Vector3i position, const VoxelBuffer &voxels) {
+	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(voxels);
+	ZN_ASSERT_RETURN_V(result.success, PackedByteArray());
+
+	PackedByteArray area_data;
+	area_data.resize(1 + 4 * sizeof(int32_t) + result.data.size());
+
+	ByteSpanWithPosition mw_span(Span<uint8_t>(area_data.ptrw(), area_data.size()), 0);
+	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+
+	mw.store_8(type);
+	mw.store_32(position.x);
+	mw.store_32(position.y);
+	mw.store_32(position.z);
+	mw.store_32(result.data.size());
+	mw.store_buffer(to_span(result.data));
+
+	return area_data;
+}
+
+} // namespace
 
-		messages.clear();
+void VoxelTerrainMultiplayerSynchronizer::flush_edited_areas() {
+	ZN_PROFILE_SCOPE();
 
-		const int peer_id = it->first;
-		ZN_PRINT_VERBOSE(format("Sending {} bytes of block data to peer {}", pba.size(), peer_id));
-		// print_data_hex(Span<const uint8_t>(pba.ptr(), pba.size()));
+	VoxelData &data = _terrain->get_storage();
+	const int block_size = data.get_block_size();
+	const uint64_t now_msec = get_ticks_msec();
+
+	// Edits of the frame can overlap, and clients load data in blocks, so areas are merged per block
+	StdUnorderedMap<Vector3i, Box3i> edited_boxes_per_block;
+	for (const Box3i &area : _edited_areas) {
+		area.downscaled(block_size).for_each_cell([&edited_boxes_per_block, &area, block_size](Vector3i bpos) {
+			const Box3i box = area.clipped(Box3i(bpos * block_size, Vector3iUtil::create(block_size)));
+			auto it = edited_boxes_per_block.find(bpos);
+			if (it == edited_boxes_per_block.end()) {
+				edited_boxes_per_block.insert({ bpos, box });
+			} else {
+				it->second = Box3i::get_bounding_box(it->second, box);
+			}
+		});
+	}
+	_edited_areas.clear();
+
+	StdVector<ViewerID> viewers;
+	StdVector<int> peer_ids;
+	StdVector<uint8_t> temp;
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
+	VoxelBuffer delta(VoxelBuffer::ALLOCATOR_POOL);
+
+	for (auto it = edited_boxes_per_block.begin(); it != edited_boxes_per_block.end(); ++it) {
+		const Vector3i bpos = it->first;
+		const Box3i voxel_box = it->second;
+		const Vector3i block_origin = bpos * block_size;
+
+		if (!data.has_block(bpos, 0)) {
+			// Not loaded, peers can't have it either
+			_snapshots.erase(bpos);
+			continue;
+		}
+
+		viewers.clear();
+		_terrain->get_viewers_in_area(viewers, voxel_box);
+		// A peer could have multiple viewers in the area
+		peer_ids.clear();
+		for (const ViewerID viewer_id : viewers) {
+			const int peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
+			if (peer_id != -1 && peer_id != MultiplayerPeer::TARGET_PEER_SERVER &&
+				!contains(to_span_const(peer_ids), peer_id)) {
+				peer_ids.push_back(peer_id);
+			}
+		}
+		if (peer_ids.size() == 0) {
+			// Not bothering if no networked viewers are around. The snapshot would be outdated now, so it is dropped.
+			_snapshots.erase(bpos);
+			continue;
+		}
+
+		voxels.create(voxel_box.size);
+		data.copy(voxel_box.position, voxels, 0xff);
+
+		// Version of the snapshot `delta` is relative to, if any
+		uint64_t base_version = 0;
+		bool has_delta = false;
+		uint64_t new_version = 0;
+
+		auto snapshot_it = _snapshots.find(bpos);
+		if (snapshot_it != _snapshots.end() && has_same_channel_depths(snapshot_it->second.voxels, voxels)) {
+			BlockSnapshot &snapshot = snapshot_it->second;
+
+			const Vector3i min_pos_in_block = voxel_box.position - block_origin;
+			delta.create(voxel_box.size);
+			for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+				delta.set_channel_depth(channel_index, voxels.get_channel_depth(channel_index));
+				delta.copy_channel_from(
+						snapshot.voxels,
+						min_pos_in_block,
+						min_pos_in_block + voxel_box.size,
+						Vector3i(),
+						channel_index
+				);
+				// Keep the snapshot in sync with what peers will have
+				snapshot.voxels.copy_channel_from(
+						voxels, Vector3i(), voxel_box.size, min_pos_in_block, channel_index
+				);
+			}
+			snapshot.last_edit_time_msec = now_msec;
+
+			base_version = snapshot.version;
+			has_delta = xor_voxels(delta, voxels, temp);
+			snapshot.version = _next_snapshot_version++;
+			new_version = snapshot.version;
+
+		} else {
+			BlockSnapshot &snapshot = _snapshots[bpos];
+			snapshot.voxels.create(Vector3iUtil::create(block_size));
+			data.copy(block_origin, snapshot.voxels, 0xff);
+			snapshot.last_edit_time_msec = now_msec;
+			snapshot.version = _next_snapshot_version++;
+			new_version = snapshot.version;
+		}
+
+		// Serialized areas are shared between peers, and only made if at least one peer needs them
+		PackedByteArray xor_area_data;
+		PackedByteArray replace_area_data;
+
+		for (const int peer_id : peer_ids) {
+			PeerState &peer = _peers[peer_id];
+			if (peer.pending_blocks.find(bpos) != peer.pending_blocks.end()) {
+				// The block will be sent with the edit included
+				continue;
+			}
+
+			auto version_it = peer.snapshot_versions.find(bpos);
+			const bool peer_has_base =
+					has_delta && version_it != peer.snapshot_versions.end() && version_it->second == base_version;
+
+			PackedByteArray *area_data = nullptr;
+			if (peer_has_base) {
+				if (xor_area_data.size() == 0) {
+					xor_area_data = make_area_message(AREA_XOR, voxel_box.position, delta);
+				}
+				area_data = &xor_area_data;
+			} else {
+				// The peer missed edits the snapshot includes, so the delta would not apply to what it has
+				if (replace_area_data.size() == 0) {
+					replace_area_data = make_area_message(AREA_REPLACE, voxel_box.position, voxels);
+				}
+				area_data = &replace_area_data;
+			}
+			ZN_ASSERT_CONTINUE(area_data->size() > 0);
+
+			peer.messages.push_back(QueuedMessage{ bpos, QueuedMessage::TYPE_AREA, 0.f, *area_data });
+			peer.snapshot_versions[bpos] = new_version;
+		}
+	}
+
+	remove_old_snapshots(now_msec);
+}
+
+void VoxelTerrainMultiplayerSynchronizer::remove_old_snapshots(uint64_t now_msec) {
+	for (auto it = _snapshots.begin(); it != _snapshots.end();) {
+		if (now_msec - it->second.last_edit_time_msec > SNAPSHOT_LIFETIME_MSEC) {
+			it = _snapshots.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	if (_snapshots.size() > MAX_SNAPSHOTS) {
+		// Remove least recently edited
+		StdVector<std::pair<uint64_t, Vector3i>> snapshots_by_time;
+		snapshots_by_time.reserve(_snapshots.size());
+		for (auto it = _snapshots.begin(); it != _snapshots.end(); ++it) {
+			snapshots_by_time.push_back({ it->second.last_edit_time_msec, it->first });
+		}
+		std::sort(snapshots_by_time.begin(), snapshots_by_time.end(), [](const auto &a, const auto &b) {
+			return a.first < b.first;
+		});
+		for (unsigned int i = 0; i < snapshots_by_time.size() - MAX_SNAPSHOTS; ++i) {
+			_snapshots.erase(snapshots_by_time[i].second);
+		}
+	}
+
+	// Versions of dropped snapshots can't be matched anymore
+	for (auto peer_it = _peers.begin(); peer_it != _peers.end(); ++peer_it) {
+		StdUnorderedMap<Vector3i, uint64_t> &versions = peer_it->second.snapshot_versions;
+		for (auto it = versions.begin(); it != versions.end();) {
+			if (_snapshots.find(it->first) == _snapshots.end()) {
+				it = versions.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+void VoxelTerrainMultiplayerSynchronizer::send_queued_messages(int peer_id) {
+	ZN_PROFILE_SCOPE();
+
+	PeerState &peer = _peers[peer_id];
+	StdVector<QueuedMessage> &messages = peer.messages;
+
+	if (messages.size() == 0) {
+		return;
+	}
+
+	const float block_size = _terrain->get_data_block_size();
+	const Vector3f block_half_size = Vector3f(0.5f * block_size);
+	for (QueuedMessage &message : messages) {
+		const Vector3f block_center = to_vec3f(message.block_position) * block_size + block_half_size;
+		message.distance_squared = math::distance_squared(block_center, peer.viewer_position);
+	}
+
+	// Closest first. The sort is stable, so messages about the same block remain in the order they were produced.
+	std::stable_sort(messages.begin(), messages.end(), [](const QueuedMessage &a, const QueuedMessage &b) {
+		return a.distance_squared < b.distance_squared;
+	});
+
+	// Make one big fat message per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
+	// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by
+	// the high-level features...
+	StdVector<uint8_t> blocks_data;
+	StdVector<uint8_t> areas_data;
+	MemoryWriter blocks_writer(blocks_data, ENDIANNESS_LITTLE_ENDIAN);
+	MemoryWriter areas_writer(areas_data, ENDIANNESS_LITTLE_ENDIAN);
+	// Counts are written at the beginning once known
+	blocks_writer.store_32(0);
+	areas_writer.store_32(0);
+	uint32_t block_count = 0;
+	uint32_t area_count = 0;
+
+	VoxelData &data = _terrain->get_storage();
+
+	unsigned int sent_count = 0;
+	for (; sent_count < messages.size(); ++sent_count) {
+		if (_max_bytes_per_peer_per_frame != 0 && sent_count > 0 &&
+			blocks_data.size() + areas_data.size() >= _max_bytes_per_peer_per_frame) {
+			break;
+		}
+
+		const QueuedMessage &message = messages[sent_count];
+
+		if (message.type == QueuedMessage::TYPE_AREA) {
+			areas_writer.store_buffer(Span<const uint8_t>(message.area_data.ptr(), message.area_data.size()));
+			++area_count;
+			continue;
+		}
+
+		const Vector3i bpos = message.block_position;
+		peer.pending_blocks.erase(bpos);
+
+		BlockSerializer::SerializeResult result;
+		{
+			SpatialLock3D::Read srlock(data.get_spatial_lock(0), BoxBounds3i::from_position(bpos));
+			std::shared_ptr<VoxelBuffer> voxels = data.try_get_block_voxels(bpos);
+			if (voxels == nullptr) {
+				// Got unloaded meanwhile
+				continue;
+			}
+			result = BlockSerializer::serialize_and_compress(*voxels);
+		}
+		ZN_ASSERT_CONTINUE(result.success);
+		ZN_ASSERT_CONTINUE(result.data.size() <= 65535);
+
+		// This effectively limits volume size to 1,048,576. If really required, we could double this data to cover
+		// more.
+		blocks_writer.store_16(bpos.x);
+		blocks_writer.store_16(bpos.y);
+		blocks_writer.store_16(bpos.z);
+		blocks_writer.store_16(result.data.size());
+		blocks_writer.store_buffer(to_span(result.data));
+		++block_count;
+	}
+
+	messages.erase(messages.begin(), messages.begin() + sent_count);
+
+	// Blocks first, because areas can be edits of blocks sent in the same frame
+	if (block_count > 0) {
+		const PackedByteArray pba = make_batch_message(blocks_data, block_count);
+		ZN_PRINT_VERBOSE(format("Sending {} blocks ({} bytes) to peer {}", block_count, pba.size(), peer_id));
 		rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_blocks, pba);
 	}
+	if (area_count > 0) {
+		const PackedByteArray pba = make_batch_message(areas_data, area_count);
+		ZN_PRINT_VERBOSE(format("Sending {} edited areas ({} bytes) to peer {}", area_count, pba.size(), peer_id));
+		rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_areas, pba);
+	}
 }
 
 void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray message_data) {
@@ -216,28 +558,49 @@ void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray mess
 	}
 }
 
-void VoxelTerrainMultiplayerSynchronizer::_b_receive_area(PackedByteArray message_data) {
+void VoxelTerrainMultiplayerSynchronizer::_b_receive_areas(PackedByteArray message_data) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(_terrain != nullptr);
 
 	MemoryReader mr(Span<const uint8_t>(message_data.ptr(), message_data.size()), ENDIANNESS_LITTLE_ENDIAN);
 
-	Vector3i pos;
-	pos.x = int32_t(mr.get_32());
-	pos.y = int32_t(mr.get_32());
-	pos.z = int32_t(mr.get_32());
-	const int voxel_data_size = mr.get_32();
+	const unsigned int area_count = mr.get_32();
 
+	VoxelData &data = _terrain->get_storage();
 	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-	ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(mr.data.sub(mr.pos, voxel_data_size), voxels));
-
-	_terrain->get_storage().paste(pos, voxels, 0xff, false);
-	_terrain->post_edit_area(
-			Box3i(pos, voxels.get_size()),
-			// Don't bother for now, update mesh regardless. If necessary we would have to add a flag with the message
-			// to tell it's not actually changing voxels (if it's metadata changes), but might not be worth it
-			true
-	);
+	VoxelBuffer current_voxels(VoxelBuffer::ALLOCATOR_POOL);
+	StdVector<uint8_t> temp;
+
+	for (unsigned int i = 0; i < area_count; ++i) {
+		const uint8_t type = mr.get_8();
+		Vector3i pos;
+		pos.x = int32_t(mr.get_32());
+		pos.y = int32_t(mr.get_32());
+		pos.z = int32_t(mr.get_32());
+		const int voxel_data_size = mr.get_32();
+
+		ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(mr.data.sub(mr.pos, voxel_data_size), voxels));
+		mr.pos += voxel_data_size;
+
+		if (type == AREA_XOR) {
+			// The server sent the difference with what we received before
+			current_voxels.create(voxels.get_size());
+			data.copy(pos, current_voxels, 0xff);
+			ZN_ASSERT_CONTINUE(xor_voxels(current_voxels, voxels, temp));
+			data.paste(pos, current_voxels, 0xff, false);
+		} else {
+			ZN_ASSERT_CONTINUE(type == AREA_REPLACE);
+			data.paste(pos, voxels, 0xff, false);
+		}
+
+		_terrain->post_edit_area(
+				Box3i(pos, voxels.get_size()),
+				// Don't bother for now, update mesh regardless. If necessary we would have to add a flag with the
+				// message to tell it's not actually changing voxels (if it's metadata changes), but might not be worth
+				// it
+				true
+		);
+	}
 }
 
 #ifdef TOOLS_ENABLED
@@ -285,7 +648,24 @@ void VoxelTerrainMultiplayerSynchronizer::_bind_methods() {
 	ClassDB::bind_method(
 			D_METHOD("_rpc_receive_blocks", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks
 	);
-	ClassDB::bind_method(D_METHOD("_rpc_receive_area", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_area);
+	ClassDB::bind_method(
+			D_METHOD("_rpc_receive_areas", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_areas
+	);
+
+	ClassDB::bind_method(
+			D_METHOD("set_max_bytes_per_peer_per_frame", "bytes"),
+			&VoxelTerrainMultiplayerSynchronizer::set_max_bytes_per_peer_per_frame
+	);
+	ClassDB::bind_method(
+			D_METHOD("get_max_bytes_per_peer_per_frame"),
+			&VoxelTerrainMultiplayerSynchronizer::get_max_bytes_per_peer_per_frame
+	);
+
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "max_bytes_per_peer_per_frame", PROPERTY_HINT_RANGE, "0,1048576,1,or_greater"),
+			"set_max_bytes_per_peer_per_frame",
+			"get_max_bytes_per_peer_per_frame"
+	);
 }
 
 } // namespace zylann::voxel
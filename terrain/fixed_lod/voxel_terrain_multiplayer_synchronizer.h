@@ -1,11 +1,13 @@
 #ifndef VOXEL_NETWORK_TERRAIN_SYNC_H
 #define VOXEL_NETWORK_TERRAIN_SYNC_H
 
-#include "../../storage/voxel_data_block.h"
+#include "../../storage/voxel_buffer.h"
 #include "../../util/containers/std_unordered_map.h"
+#include "../../util/containers/std_unordered_set.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/node.h"
 #include "../../util/math/box3i.h"
+#include "../../util/math/vector3f.h"
 
 #ifdef TOOLS_ENABLED
 #include "../../util/godot/core/version.h"
@@ -15,7 +17,15 @@ namespace zylann::voxel {
 
 class VoxelTerrain;
 
-// Implements multiplayer replication for `VoxelTerrain`
+// Implements multiplayer replication for `VoxelTerrain`.
+//
+// The server keeps a queue of messages per peer. Every frame, queued messages are sent in one batch per peer, closest
+// to the peer's viewer first, until a byte budget is reached.
+// Edits are not sent right away: edited areas are accumulated and sent in the next process, clipped to each data
+// block. If a snapshot of a block is still around from a previous edit, only the XOR of the new voxels with that
+// snapshot is sent, which is mostly zeros and compresses very well. Otherwise the area is sent as-is. Peers can miss
+// edits (they were not nearby, or got the whole block instead), so the version of the snapshot each peer has is
+// tracked, and peers that don't have the version the delta was computed from get the area as-is.
 class VoxelTerrainMultiplayerSynchronizer : public Node {
 	GDCLASS(VoxelTerrainMultiplayerSynchronizer, Node)
 public:
@@ -23,9 +33,15 @@ public:
 
 	bool is_server() const;
 
-	void send_block(int viewer_peer_id, const VoxelDataBlock &data_block, Vector3i bpos);
+	// Queues a full block to be sent to a peer. It is serialized when sent, so it includes edits done meanwhile.
+	void send_block(int viewer_peer_id, Vector3i bpos);
+	// Marks an area as edited. It will be sent to peers on the next process.
 	void send_area(Box3i voxel_box);
 
+	// Zero means unlimited. At least one message is sent per frame, and the last message can exceed the budget.
+	void set_max_bytes_per_peer_per_frame(int bytes);
+	int get_max_bytes_per_peer_per_frame() const;
+
 #ifdef TOOLS_ENABLED
 #if defined(ZN_GODOT)
 	PackedStringArray get_configuration_warnings() const override;
@@ -39,20 +55,63 @@ private:
 	void _notification(int p_what);
 
 	void process();
+	void update_peer_positions();
+	void flush_edited_areas();
+	void remove_old_snapshots(uint64_t now_msec);
+	void send_queued_messages(int peer_id);
 
 	void _b_receive_blocks(PackedByteArray message_data);
-	void _b_receive_area(PackedByteArray message_data);
+	void _b_receive_areas(PackedByteArray message_data);
 
 	static void _bind_methods();
 
 	VoxelTerrain *_terrain = nullptr;
 	int _rpc_channel = 0;
 
-	struct DeferredBlockMessage {
-		PackedByteArray data;
+	unsigned int _max_bytes_per_peer_per_frame = 0;
+
+	struct QueuedMessage {
+		enum Type : uint8_t {
+			TYPE_BLOCK,
+			TYPE_AREA,
+		};
+		// Data block the message is about
+		Vector3i block_position;
+		Type type;
+		// Squared distance to the viewer of the peer, updated before sending
+		float distance_squared = 0.f;
+		// Serialized area. Shared between peers receiving the same edit.
+		PackedByteArray area_data;
+	};
+
+	struct PeerState {
+		StdVector<QueuedMessage> messages;
+		// Blocks queued with `TYPE_BLOCK`. Edits are not queued for them, since they will be part of the block.
+		StdUnorderedSet<Vector3i> pending_blocks;
+		// Version of the block snapshot the peer's voxels match, for blocks it received edits of
+		StdUnorderedMap<Vector3i, uint64_t> snapshot_versions;
+		// In terrain space
+		Vector3f viewer_position;
+		bool has_viewer = true;
+	};
+
+	StdUnorderedMap<int, PeerState> _peers;
+
+	StdVector<Box3i> _edited_areas;
+
+	// Voxels of a block as peers have last received them. Dropping one is always safe, the next edit of the block
+	// will then be sent as-is.
+	struct BlockSnapshot {
+		VoxelBuffer voxels;
+		uint64_t last_edit_time_msec = 0;
+		// Changes every time the snapshot is updated. Versions are never reused, even across different snapshots.
+		uint64_t version = 0;
+
+		BlockSnapshot() : voxels(VoxelBuffer::ALLOCATOR_POOL) {}
 	};
 
-	StdUnorderedMap<int, StdVector<DeferredBlockMessage>> _deferred_block_messages_per_peer;
+	StdUnorderedMap<Vector3i, BlockSnapshot> _snapshots;
+	uint64_t _next_snapshot_version = 1;
 };
 
 } // namespace zylann::voxel
@@ -1,5 +1,6 @@
 #include "generate_instances_block_task.h"
 #include "../../util/godot/classes/array_mesh.h"
+#include "../../util/godot/direct_multimesh_instance.h"
 #include "../../util/profiling.h"
 
 namespace zylann::voxel {
@@ -35,6 +36,13 @@ void GenerateInstancesBlockTask::run(ThreadedTaskContext &ctx) {
 		transforms.push_back(t);
 	}
 
+	PackedFloat32Array multimesh_buffer;
+	if (build_multimesh_buffer && transforms.size() > 0) {
+		zylann::godot::DirectMultiMeshInstance::make_transform_3d_bulk_array(
+				to_span_const(transforms), multimesh_buffer
+		);
+	}
+
 	{
 		MutexLock mlock(output_queue->mutex);
 		output_queue->results.push_back(InstanceLoadingTaskOutput());
@@ -43,6 +51,7 @@ void GenerateInstancesBlockTask::run(ThreadedTaskContext &ctx) {
 		o.edited_mask = edited_mask;
 		o.render_block_position = mesh_block_grid_position;
 		o.transforms = std::move(transforms);
+		o.multimesh_buffer = multimesh_buffer;
 	}
 }
 
@@ -24,6 +24,8 @@ public:
 	float mesh_block_size;
 	Array surface_arrays;
 	Ref<VoxelInstanceGenerator> generator;
+	// If true, the buffer used by multimeshes is also built, so the main thread doesn't have to
+	bool build_multimesh_buffer;
 	// Can be pre-populated by edited transforms
 	StdVector<Transform3f> transforms;
 	std::shared_ptr<InstancerTaskOutputQueue> output_queue;
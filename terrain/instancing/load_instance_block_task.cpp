@@ -4,6 +4,7 @@
 #include "../../util/containers/container_funcs.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/array_mesh.h"
+#include "../../util/godot/direct_multimesh_instance.h"
 #include "../../util/math/box3i.h"
 #include "../../util/math/conv.h"
 #include "../../util/profiling.h"
@@ -192,14 +193,16 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 		}
 	}
 
+	// TODO Cache memory
+	StdVector<VoxelInstanceLibrary::PackedItem> items;
+	if (_library.is_valid()) {
+		_library->get_packed_items_at_lod(items, _lod_index);
+	}
+
 	// Generate the rest
-	if (_mesh_arrays.size() != 0 && _library.is_valid()) {
+	if (_mesh_arrays.size() != 0) {
 		ZN_PROFILE_SCOPE();
 
-		// TODO Cache memory
-		StdVector<VoxelInstanceLibrary::PackedItem> items;
-		_library->get_packed_items_at_lod(items, _lod_index);
-
 		if (items.size() > 0) {
 			BufferedTaskScheduler &task_scheduler = BufferedTaskScheduler::get_for_current_thread();
 
@@ -235,6 +238,7 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 						task->up_mode = _up_mode;
 						task->surface_arrays = _mesh_arrays;
 						task->generator = item.generator;
+						task->build_multimesh_buffer = item.multimesh;
 						task->transforms = std::move(layer.transforms);
 						task->output_queue = _output_queue;
 
@@ -258,9 +262,22 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 		// Will normally be full
 		o.edited_mask = layer.edited_mask;
 		o.render_block_position = _render_grid_position;
+
+		// Build the multimesh buffer here like generation tasks do, so the main thread doesn't have to
+		const int layer_id = layer.id;
+		size_t item_index;
+		const bool item_found = find(items, item_index, [layer_id](const VoxelInstanceLibrary::PackedItem &item) {
+			return static_cast<int>(item.id) == layer_id;
+		});
+		if (item_found && items[item_index].multimesh && layer.transforms.size() > 0) {
+			zylann::godot::DirectMultiMeshInstance::make_transform_3d_bulk_array(
+					to_span_const(layer.transforms), o.multimesh_buffer
+			);
+		}
+
 		o.transforms = std::move(layer.transforms);
 		{
-			MutexLock(_output_queue->mutex);
+			MutexLock mlock(_output_queue->mutex);
 			_output_queue->results.push_back(std::move(o));
 		}
 	}
@@ -14,6 +14,116 @@ namespace zylann::voxel {
 namespace {
 const float MAX_DENSITY = 1.f;
 const char *DENSITY_HINT_STRING = "0.0, 1.0, 0.01";
+
+// Candidate instances, with components stored in separate arrays so filters run as simple loops over contiguous
+// values. One instance is kept per thread and reused across blocks.
+struct InstancePointsSoA {
+	StdVector<float> px;
+	StdVector<float> py;
+	StdVector<float> pz;
+	StdVector<float> nx;
+	StdVector<float> ny;
+	StdVector<float> nz;
+	StdVector<float> noise;
+	// Result of filters, one per point
+	StdVector<uint8_t> keep;
+
+	StdVector<float> noise_graph_x;
+	StdVector<float> noise_graph_y;
+	StdVector<float> noise_graph_z;
+
+	inline unsigned int size() const {
+		return px.size();
+	}
+
+	void clear() {
+		resize(0);
+	}
+
+	void resize(unsigned int count) {
+		px.resize(count);
+		py.resize(count);
+		pz.resize(count);
+		nx.resize(count);
+		ny.resize(count);
+		nz.resize(count);
+	}
+
+	inline void set(unsigned int i, Vector3f pos, Vector3f normal) {
+		px[i] = pos.x;
+		py[i] = pos.y;
+		pz[i] = pos.z;
+		nx[i] = normal.x;
+		ny[i] = normal.y;
+		nz[i] = normal.z;
+	}
+
+	inline void push_back(Vector3f pos, Vector3f normal) {
+		px.push_back(pos.x);
+		py.push_back(pos.y);
+		pz.push_back(pos.z);
+		nx.push_back(normal.x);
+		ny.push_back(normal.y);
+		nz.push_back(normal.z);
+	}
+
+	inline Vector3f get_position(unsigned int i) const {
+		return Vector3f(px[i], py[i], pz[i]);
+	}
+
+	inline Vector3f get_normal(unsigned int i) const {
+		return Vector3f(nx[i], ny[i], nz[i]);
+	}
+
+	inline void move(unsigned int dst, unsigned int src, bool with_noise) {
+		px[dst] = px[src];
+		py[dst] = py[src];
+		pz[dst] = pz[src];
+		nx[dst] = nx[src];
+		ny[dst] = ny[src];
+		nz[dst] = nz[src];
+		if (with_noise) {
+			noise[dst] = noise[src];
+		}
+	}
+
+	void resize_kept(unsigned int count, bool with_noise) {
+		resize(count);
+		if (with_noise) {
+			noise.resize(count);
+		}
+	}
+
+	// Removes points not flagged in `keep` by moving the last point in their place, which changes their order the
+	// same way removing them one by one with `unordered_remove` did. Keeps results identical to older versions.
+	void remove_unkept_unordered(bool with_noise) {
+		unsigned int count = size();
+		for (unsigned int i = 0; i < count;) {
+			if (keep[i] != 0) {
+				++i;
+				continue;
+			}
+			--count;
+			move(i, count, with_noise);
+			keep[i] = keep[count];
+		}
+		resize_kept(count, with_noise);
+	}
+
+	// Removes points not flagged in `keep`, preserving the order of the others
+	void remove_unkept_ordered(bool with_noise) {
+		const unsigned int count = size();
+		unsigned int dst = 0;
+		for (unsigned int src = 0; src < count; ++src) {
+			if (keep[src] != 0) {
+				move(dst, src, with_noise);
+				++dst;
+			}
+		}
+		resize_kept(dst, with_noise);
+	}
+};
+
 } // namespace
 
 void VoxelInstanceGenerator::generate_transforms(
@@ -65,19 +175,9 @@ void VoxelInstanceGenerator::generate_transforms(
 
 	// TODO This part might be moved to the meshing thread if it turns out to be too heavy
 
-	static thread_local StdVector<Vector3f> g_vertex_cache;
-	static thread_local StdVector<Vector3f> g_normal_cache;
-	static thread_local StdVector<float> g_noise_cache;
-	// static thread_local StdVector<float> g_noise_graph_output_cache;
-	static thread_local StdVector<float> g_noise_graph_x_cache;
-	static thread_local StdVector<float> g_noise_graph_y_cache;
-	static thread_local StdVector<float> g_noise_graph_z_cache;
-
-	StdVector<Vector3f> &vertex_cache = g_vertex_cache;
-	StdVector<Vector3f> &normal_cache = g_normal_cache;
-
-	vertex_cache.clear();
-	normal_cache.clear();
+	static thread_local InstancePointsSoA tls_points;
+	InstancePointsSoA &points = tls_points;
+	points.clear();
 
 	// Pick random points
 	{
@@ -109,8 +209,7 @@ void VoxelInstanceGenerator::generate_transforms(
 					if (pos.x > margin || pos.y > margin || pos.z > margin) {
 						continue;
 					}
-					vertex_cache.push_back(pos);
-					normal_cache.push_back(to_vec3f(normals[i]));
+					points.push_back(pos, to_vec3f(normals[i]));
 				}
 			} break;
 
@@ -123,8 +222,7 @@ void VoxelInstanceGenerator::generate_transforms(
 				// so we can use number of triangles as a metric proportional to the number of instances
 				const int instance_count = _density * triangle_count;
 
-				vertex_cache.resize(instance_count);
-				normal_cache.resize(instance_count);
+				points.resize(instance_count);
 
 				for (int instance_index = 0; instance_index < instance_count; ++instance_index) {
 					// Pick a random triangle
@@ -152,8 +250,7 @@ void VoxelInstanceGenerator::generate_transforms(
 					const Vector3 p = pa.lerp(pb, t0).lerp(pc, t1);
 					const Vector3 n = na.lerp(nb, t0).lerp(nc, t1);
 
-					vertex_cache[instance_index] = to_vec3f(p);
-					normal_cache[instance_index] = to_vec3f(n);
+					points.set(instance_index, to_vec3f(p), to_vec3f(n));
 				}
 
 			} break;
@@ -206,8 +303,7 @@ void VoxelInstanceGenerator::generate_transforms(
 						const Vector3 p = pa.lerp(pb, t0).lerp(pc, t1);
 						const Vector3 n = na.lerp(nb, t0).lerp(nc, t1);
 
-						vertex_cache.push_back(to_vec3f(p));
-						normal_cache.push_back(to_vec3f(n));
+						points.push_back(to_vec3f(p), to_vec3f(n));
 					}
 
 					accumulator -= count_in_triangle * inv_density;
@@ -226,15 +322,12 @@ void VoxelInstanceGenerator::generate_transforms(
 	if ((octant_mask & 0xff) != 0xff) {
 		ZN_PROFILE_SCOPE_NAMED("octant filter");
 		const float h = block_size / 2.f;
-		for (unsigned int i = 0; i < vertex_cache.size(); ++i) {
-			const Vector3f &pos = vertex_cache[i];
-			const uint8_t octant_index = get_octant_index(pos, h);
-			if ((octant_mask & (1 << octant_index)) == 0) {
-				unordered_remove(vertex_cache, i);
-				unordered_remove(normal_cache, i);
-				--i;
-			}
+		points.keep.resize(points.size());
+		for (unsigned int i = 0; i < points.size(); ++i) {
+			const uint8_t octant_index = get_octant_index(points.px[i] > h, points.py[i] > h, points.pz[i] > h);
+			points.keep[i] = (octant_mask >> octant_index) & 1;
 		}
+		points.remove_unkept_unordered(false);
 	}
 
 	// Position of the block relative to the instancer node.
@@ -255,8 +348,8 @@ void VoxelInstanceGenerator::generate_transforms(
 	if (noise_graph.is_valid()) {
 		ZN_PROFILE_SCOPE_NAMED("Noise graph filter");
 
-		StdVector<float> &out_buffer = g_noise_cache;
-		out_buffer.resize(vertex_cache.size());
+		StdVector<float> &out_buffer = points.noise;
+		out_buffer.resize(points.size());
 
 		// Check noise graph validity
 		std::shared_ptr<pg::VoxelGraphFunction::CompiledGraph> compiled_graph = noise_graph->get_compiled_graph();
@@ -289,20 +382,19 @@ void VoxelInstanceGenerator::generate_transforms(
 		if (compiled_graph != nullptr) {
 			// Execute graph
 
-			StdVector<float> &x_buffer = g_noise_graph_x_cache;
-			StdVector<float> &z_buffer = g_noise_graph_z_cache;
-			x_buffer.resize(vertex_cache.size());
-			z_buffer.resize(vertex_cache.size());
+			StdVector<float> &x_buffer = points.noise_graph_x;
+			StdVector<float> &z_buffer = points.noise_graph_z;
+			x_buffer.resize(points.size());
+			z_buffer.resize(points.size());
 
 			FixedArray<Span<float>, 1> outputs;
 			outputs[0] = to_span(out_buffer);
 
 			switch (_noise_dimension) {
 				case DIMENSION_2D: {
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
-						x_buffer[i] = pos.x;
-						z_buffer[i] = pos.z;
+					for (unsigned int i = 0; i < points.size(); ++i) {
+						x_buffer[i] = points.px[i] + mesh_block_origin_d.x;
+						z_buffer[i] = points.pz[i] + mesh_block_origin_d.z;
 					}
 
 					FixedArray<Span<float>, 2> inputs;
@@ -313,14 +405,13 @@ void VoxelInstanceGenerator::generate_transforms(
 				} break;
 
 				case DIMENSION_3D: {
-					StdVector<float> &y_buffer = g_noise_graph_y_cache;
-					y_buffer.resize(vertex_cache.size());
-
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
-						x_buffer[i] = pos.x;
-						y_buffer[i] = pos.y;
-						z_buffer[i] = pos.z;
+					StdVector<float> &y_buffer = points.noise_graph_y;
+					y_buffer.resize(points.size());
+
+					for (unsigned int i = 0; i < points.size(); ++i) {
+						x_buffer[i] = points.px[i] + mesh_block_origin_d.x;
+						y_buffer[i] = points.py[i] + mesh_block_origin_d.y;
+						z_buffer[i] = points.pz[i] + mesh_block_origin_d.z;
 					}
 
 					FixedArray<Span<float>, 3> inputs;
@@ -343,26 +434,26 @@ void VoxelInstanceGenerator::generate_transforms(
 		}
 	}
 
-	StdVector<float> &noise_cache = g_noise_cache;
+	StdVector<float> &noise_cache = points.noise;
 
 	// Legacy noise (noise graph is more versatile, but this remains for compatibility)
 	if (noise.is_valid()) {
-		noise_cache.resize(vertex_cache.size());
+		noise_cache.resize(points.size());
 
 		switch (_noise_dimension) {
 			case DIMENSION_2D: {
 				if (noise_graph.is_valid()) {
 					// Multiply output of noise graph
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+					for (unsigned int i = 0; i < points.size(); ++i) {
+						const Vector3 pos = to_vec3(points.get_position(i)) + mesh_block_origin_d;
 						// Casting to float because Noise returns `real_t`, which is `double` in 64-bit float builds,
 						// but we don't need doubles for noise in this context...
 						noise_cache[i] *= math::max(float(noise->get_noise_2d(pos.x, pos.z)), 0.f);
 					}
 				} else {
 					// Use noise directly
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+					for (unsigned int i = 0; i < points.size(); ++i) {
+						const Vector3 pos = to_vec3(points.get_position(i)) + mesh_block_origin_d;
 						noise_cache[i] = noise->get_noise_2d(pos.x, pos.z);
 					}
 				}
@@ -370,13 +461,13 @@ void VoxelInstanceGenerator::generate_transforms(
 
 			case DIMENSION_3D: {
 				if (noise_graph.is_valid()) {
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+					for (unsigned int i = 0; i < points.size(); ++i) {
+						const Vector3 pos = to_vec3(points.get_position(i)) + mesh_block_origin_d;
 						noise_cache[i] *= math::max(float(noise->get_noise_3d(pos.x, pos.y, pos.z)), 0.f);
 					}
 				} else {
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+					for (unsigned int i = 0; i < points.size(); ++i) {
+						const Vector3 pos = to_vec3(points.get_position(i)) + mesh_block_origin_d;
 						noise_cache[i] = noise->get_noise_3d(pos.x, pos.y, pos.z);
 					}
 				}
@@ -393,15 +484,11 @@ void VoxelInstanceGenerator::generate_transforms(
 	if (use_noise) {
 		ZN_PROFILE_SCOPE_NAMED("Noise filter");
 
-		for (size_t i = 0; i < vertex_cache.size(); ++i) {
-			const float n = noise_cache[i];
-			if (n <= 0) {
-				unordered_remove(vertex_cache, i);
-				unordered_remove(normal_cache, i);
-				unordered_remove(noise_cache, i);
-				--i;
-			}
+		points.keep.resize(points.size());
+		for (unsigned int i = 0; i < points.size(); ++i) {
+			points.keep[i] = !(noise_cache[i] <= 0);
 		}
+		points.remove_unkept_unordered(true);
 	}
 
 	const float vertical_alignment = _vertical_alignment;
@@ -421,32 +508,56 @@ void VoxelInstanceGenerator::generate_transforms(
 	const Vector3f fixed_look_axis_alternative = up_mode == UP_MODE_POSITIVE_Y ? Vector3f(0, 1, 0) : Vector3f(1, 0, 0);
 	const Vector3f mesh_block_origin = to_vec3f(grid_position * block_size);
 
+	// Filter out by slope and height
+	if (slope_filter || height_filter) {
+		ZN_PROFILE_SCOPE_NAMED("Slope and height filter");
+
+		points.keep.resize(points.size());
+
+		if (up_mode == UP_MODE_SPHERE) {
+			for (unsigned int i = 0; i < points.size(); ++i) {
+				float sphere_distance;
+				const Vector3f up = math::normalized(mesh_block_origin + points.get_position(i), sphere_distance);
+				const float ny = math::dot(math::normalized(points.get_normal(i)), up);
+				const bool slope_ok = !slope_filter || !(ny < normal_min_y || ny > normal_max_y);
+				const bool height_ok =
+						!height_filter || !(sphere_distance < min_height || sphere_distance > max_height);
+				points.keep[i] = slope_ok && height_ok;
+			}
+
+		} else {
+			for (unsigned int i = 0; i < points.size(); ++i) {
+				// Warning: sometimes mesh normals are not perfectly normalized.
+				const float ny = math::normalized(points.get_normal(i)).y;
+				const float y = mesh_block_origin.y + points.py[i];
+				const bool slope_ok = !slope_filter || !(ny < normal_min_y || ny > normal_max_y);
+				const bool height_ok = !height_filter || !(y < min_height || y > max_height);
+				points.keep[i] = slope_ok && height_ok;
+			}
+		}
+
+		// Order is preserved, because random numbers are only drawn for points passing this filter
+		points.remove_unkept_ordered(use_noise);
+	}
+
 	// Calculate orientations and scales
-	for (size_t vertex_index = 0; vertex_index < vertex_cache.size(); ++vertex_index) {
+	for (unsigned int vertex_index = 0; vertex_index < points.size(); ++vertex_index) {
 		Transform3f t;
-		t.origin = vertex_cache[vertex_index];
+		t.origin = points.get_position(vertex_index);
 
 		// Warning: sometimes mesh normals are not perfectly normalized.
 		// The cause is for meshing speed on CPU. It's normalized on GPU anyways.
-		Vector3f surface_normal = normal_cache[vertex_index];
+		Vector3f surface_normal = points.get_normal(vertex_index);
 
 		Vector3f axis_y;
 
-		bool surface_normal_is_normalized = false;
-		bool sphere_up_is_computed = false;
-		bool sphere_distance_is_computed = false;
-		float sphere_distance;
-
 		if (vertical_alignment == 0.f) {
 			surface_normal = math::normalized(surface_normal);
-			surface_normal_is_normalized = true;
 			axis_y = surface_normal;
 
 		} else {
 			if (up_mode == UP_MODE_SPHERE) {
-				global_up = math::normalized(mesh_block_origin + t.origin, sphere_distance);
-				sphere_up_is_computed = true;
-				sphere_distance_is_computed = true;
+				global_up = math::normalized(mesh_block_origin + t.origin);
 			}
 
 			if (vertical_alignment < 1.f) {
@@ -457,42 +568,6 @@ void VoxelInstanceGenerator::generate_transforms(
 			}
 		}
 
-		if (slope_filter) {
-			if (!surface_normal_is_normalized) {
-				surface_normal = math::normalized(surface_normal);
-			}
-
-			float ny = surface_normal.y;
-			if (up_mode == UP_MODE_SPHERE) {
-				if (!sphere_up_is_computed) {
-					global_up = math::normalized(mesh_block_origin + t.origin, sphere_distance);
-					sphere_up_is_computed = true;
-					sphere_distance_is_computed = true;
-				}
-				ny = math::dot(surface_normal, global_up);
-			}
-
-			if (ny < normal_min_y || ny > normal_max_y) {
-				// Discard
-				continue;
-			}
-		}
-
-		if (height_filter) {
-			float y = mesh_block_origin.y + t.origin.y;
-			if (up_mode == UP_MODE_SPHERE) {
-				if (!sphere_distance_is_computed) {
-					sphere_distance = math::length(mesh_block_origin + t.origin);
-					sphere_distance_is_computed = true;
-				}
-				y = sphere_distance;
-			}
-
-			if (y < min_height || y > max_height) {
-				continue;
-			}
-		}
-
 		t.origin += offset_along_normal * axis_y;
 
 		// Allows to use two faces of a single rock to create variety in the same layer
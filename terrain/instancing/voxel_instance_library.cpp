@@ -2,6 +2,7 @@
 #include "../../util/containers/container_funcs.h"
 #include "../../util/profiling.h"
 #include "voxel_instance_library_item.h"
+#include "voxel_instance_library_multimesh_item.h"
 #include <algorithm>
 #ifdef ZN_GODOT_EXTENSION
 #include "../../util/godot/core/array.h"
@@ -34,14 +35,14 @@ void VoxelInstanceLibrary::add_item(int p_id, Ref<VoxelInstanceLibraryItem> item
 	item->add_listener(this, id);
 
 	// This is also called when the resource is loaded, so do this iteratively instead of updating all packed items
-	Ref<VoxelInstanceGenerator> generator = item->get_generator();
-	if (generator.is_valid()) {
+	{
 		PackedItems::Lod &lod = _packed_items.lods[item->get_lod_index()];
 		MutexLock mlock(_packed_items.mutex);
 		if (!contains(lod.items, [id](const PackedItem &existing_item) { return existing_item.id == id; })) {
 			PackedItem packed_item;
 			packed_item.id = id;
-			packed_item.generator = generator;
+			packed_item.generator = item->get_generator();
+			packed_item.multimesh = Object::cast_to<VoxelInstanceLibraryMultiMeshItem>(*item) != nullptr;
 			lod.items.push_back(packed_item);
 		}
 	}
@@ -189,10 +190,8 @@ void VoxelInstanceLibrary::update_packed_items() {
 		PackedItems::Lod &lod = packed_items.lods[lod_index];
 		PackedItem packed_item;
 		packed_item.generator = item.get_generator();
-		if (packed_item.generator.is_null()) {
-			return;
-		}
 		packed_item.id = id;
+		packed_item.multimesh = Object::cast_to<VoxelInstanceLibraryMultiMeshItem>(&item) != nullptr;
 		lod.items.push_back(packed_item);
 	});
 
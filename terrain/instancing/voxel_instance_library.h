@@ -61,8 +61,11 @@ public:
 #endif
 
 	struct PackedItem {
+		// May be null if the item only has instances loaded from a stream
 		Ref<VoxelInstanceGenerator> generator;
 		unsigned int id;
+		// If true, instances are rendered with a multimesh
+		bool multimesh;
 	};
 
 	void get_packed_items_at_lod(StdVector<PackedItem> &out_items, unsigned int lod_index) const;
@@ -99,7 +102,7 @@ private:
 		std::atomic_bool needs_update = false;
 	};
 
-	// Packed representation of items for use in procedural generation tasks
+	// Packed representation of items for use in loading and procedural generation tasks
 	PackedItems _packed_items;
 };
 
@@ -301,6 +301,7 @@ void VoxelInstancer::process_task_results() {
 		update_block_from_transforms( //
 				block_it->second, //
 				to_span_const(output.transforms), //
+				output.multimesh_buffer, //
 				output.render_block_position, //
 				layer, //
 				*item, //
@@ -829,6 +830,7 @@ void VoxelInstancer::regenerate_layer(uint16_t layer_id, bool regenerate_blocks)
 		update_block_from_transforms(
 				block_index,
 				to_span_const(transform_cache),
+				PackedFloat32Array(),
 				block.grid_position,
 				layer,
 				**item,
@@ -1204,6 +1206,7 @@ unsigned int VoxelInstancer::create_block(
 void VoxelInstancer::update_block_from_transforms( //
 		int block_index, //
 		Span<const Transform3f> transforms, //
+		PackedFloat32Array multimesh_buffer, //
 		Vector3i grid_position, //
 		Layer &layer, //
 		const VoxelInstanceLibraryItem &item_base, //
@@ -1247,8 +1250,11 @@ void VoxelInstancer::update_block_from_transforms( //
 			} else {
 				multimesh->set_visible_instance_count(-1);
 			}
-			PackedFloat32Array bulk_array;
-			zylann::godot::DirectMultiMeshInstance::make_transform_3d_bulk_array(transforms, bulk_array);
+			PackedFloat32Array bulk_array = multimesh_buffer;
+			if (bulk_array.size() == 0) {
+				// Not done by the task that produced the transforms
+				zylann::godot::DirectMultiMeshInstance::make_transform_3d_bulk_array(transforms, bulk_array);
+			}
 			multimesh->set_instance_count(transforms.size());
 
 			// Setting the mesh BEFORE `multimesh_set_buffer` because otherwise Godot computes the AABB inside
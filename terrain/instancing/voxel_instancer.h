@@ -190,6 +190,8 @@ private:
 	void update_block_from_transforms(
 			int block_index,
 			Span<const Transform3f> transforms,
+			// Optional, if transforms were already converted for multimeshes
+			PackedFloat32Array multimesh_buffer,
 			Vector3i grid_position,
 			Layer &layer,
 			const VoxelInstanceLibraryItem &item_base,
@@ -5,6 +5,7 @@
 #include "../../engine/detail_rendering/detail_rendering.h"
 #include "../../engine/voxel_engine_gd.h"
 #include "../../engine/voxel_engine_updater.h"
+#include "../../meshers/mesh_block_task.h"
 #include "../../meshers/blocky/voxel_mesher_blocky.h"
 #include "../../meshers/transvoxel/voxel_mesher_transvoxel.h"
 #include "../../storage/voxel_buffer_gd.h"
@@ -939,11 +940,11 @@ bool VoxelLodTerrain::get_generate_collisions() const {
 
 void VoxelLodTerrain::set_collision_lod_count(int lod_count) {
 	ERR_FAIL_COND(lod_count < 0);
-	_collision_lod_count = static_cast<unsigned int>(math::min(lod_count, get_lod_count()));
+	_update_data->settings.collision_lod_count = static_cast<unsigned int>(math::min(lod_count, get_lod_count()));
 }
 
 int VoxelLodTerrain::get_collision_lod_count() const {
-	return _collision_lod_count;
+	return _update_data->settings.collision_lod_count;
 }
 
 void VoxelLodTerrain::set_collision_layer(int layer) {
@@ -1979,8 +1980,9 @@ void VoxelLodTerrain::apply_mesh_update(VoxelEngine::BlockMeshOutput &ob) {
 	}
 
 	bool has_collision = get_generate_collisions();
-	if (has_collision && _collision_lod_count != 0) {
-		has_collision = ob.lod < _collision_lod_count;
+	const unsigned int collision_lod_count = _update_data->settings.collision_lod_count;
+	if (has_collision && collision_lod_count != 0) {
+		has_collision = ob.lod < collision_lod_count;
 	}
 
 	if (has_collision && collision_expected) {
@@ -1989,7 +1991,13 @@ void VoxelLodTerrain::apply_mesh_update(VoxelEngine::BlockMeshOutput &ob) {
 		if (_collision_update_delay == 0 ||
 			static_cast<int>(now - block->last_collider_update_time) > _collision_update_delay) {
 			ZN_ASSERT(_mesher.is_valid());
-			Ref<Shape3D> collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
+			Ref<Shape3D> collision_shape;
+			if (ob.has_collision_shape) {
+				// Already built in the meshing task
+				collision_shape = ob.collision_shape;
+			} else {
+				collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
+			}
 			const bool debug_collisions = is_inside_tree() ? get_tree()->is_debugging_collisions_hint() : false;
 			block->set_collision_shape(collision_shape, debug_collisions, this, _collision_margin);
 
@@ -1997,14 +2005,23 @@ void VoxelLodTerrain::apply_mesh_update(VoxelEngine::BlockMeshOutput &ob) {
 			block->set_collision_mask(_collision_mask);
 			block->set_collision_enabled(collision_active);
 			block->last_collider_update_time = now;
-			block->deferred_collider_data.reset();
+			block->deferred_collider.reset();
 
 		} else {
-			if (block->deferred_collider_data == nullptr) {
+			if (block->deferred_collider == nullptr) {
 				_deferred_collision_updates_per_lod[ob.lod].push_back(ob.position);
-				block->deferred_collider_data = make_unique_instance<VoxelMesher::Output>();
+				block->deferred_collider = make_unique_instance<VoxelMeshBlockVLT::DeferredCollider>();
+			}
+			VoxelMeshBlockVLT::DeferredCollider &deferred_collider = *block->deferred_collider;
+			deferred_collider.has_shape = ob.has_collision_shape;
+			if (ob.has_collision_shape) {
+				deferred_collider.shape = ob.collision_shape;
+				// Surfaces are not needed, don't keep them around
+				deferred_collider.mesher_output = VoxelMesher::Output();
+			} else {
+				deferred_collider.shape.unref();
+				deferred_collider.mesher_output = std::move(ob.surfaces);
 			}
-			*block->deferred_collider_data = std::move(ob.surfaces);
 		}
 	}
 
@@ -2227,7 +2244,7 @@ void VoxelLodTerrain::process_deferred_collision_updates(uint32_t timeout_msec)
 			const Vector3i block_pos = deferred_collision_updates[i];
 			VoxelMeshBlockVLT *block = mesh_map.get_block(block_pos);
 
-			if (block == nullptr || block->deferred_collider_data == nullptr) {
+			if (block == nullptr || block->deferred_collider == nullptr) {
 				// Block was unloaded or no longer needs a collision update
 				unordered_remove(deferred_collision_updates, i);
 				--i;
@@ -2237,10 +2254,13 @@ void VoxelLodTerrain::process_deferred_collision_updates(uint32_t timeout_msec)
 			const uint64_t now = get_ticks_msec();
 
 			if (static_cast<int>(now - block->last_collider_update_time) > _collision_update_delay) {
+				const VoxelMeshBlockVLT::DeferredCollider &deferred_collider = *block->deferred_collider;
 				Ref<Shape3D> collision_shape;
-				if (_mesher.is_valid()) {
+				if (deferred_collider.has_shape) {
+					collision_shape = deferred_collider.shape;
+				} else if (_mesher.is_valid()) {
 					collision_shape =
-							make_collision_shape_from_mesher_output(*block->deferred_collider_data, **_mesher);
+							make_collision_shape_from_mesher_output(deferred_collider.mesher_output, **_mesher);
 				}
 
 				block->set_collision_shape(
@@ -2249,7 +2269,7 @@ void VoxelLodTerrain::process_deferred_collision_updates(uint32_t timeout_msec)
 				block->set_collision_layer(_collision_layer);
 				block->set_collision_mask(_collision_mask);
 				block->last_collider_update_time = now;
-				block->deferred_collider_data.reset();
+				block->deferred_collider.reset();
 
 				unordered_remove(deferred_collision_updates, i);
 				--i;
@@ -2549,6 +2569,9 @@ void VoxelLodTerrain::remesh_all_blocks() {
 	for (unsigned int lod_index = 0; lod_index < lod_count; ++lod_index) {
 		VoxelLodTerrainUpdateData::Lod &lod = _update_data->state.lods[lod_index];
 		for (auto it = lod.mesh_map_state.map.begin(); it != lod.mesh_map_state.map.end(); ++it) {
+			if (it->second.incremental_history != nullptr) {
+				it->second.incremental_history->invalidate();
+			}
 			VoxelLodTerrainUpdateTask::schedule_mesh_update(
 					it->second, it->first, lod.mesh_blocks_pending_update, it->second.mesh_viewers.get() > 0
 			);
@@ -373,7 +373,6 @@ private:
 	// These are "fire and forget"
 	StdVector<FadingOutMesh> _fading_out_meshes;
 
-	unsigned int _collision_lod_count = 0;
 	unsigned int _collision_layer = 1;
 	unsigned int _collision_mask = 1;
 	float _collision_margin = constants::DEFAULT_COLLISION_MARGIN;
@@ -1,8 +1,13 @@
 #include "voxel_lod_terrain_update_clipbox_streaming.h"
+#include "../../engine/voxel_engine.h"
+#include "../../util/containers/container_funcs.h"
 #include "../../util/containers/std_unordered_set.h"
 #include "../../util/math/conv.h"
+#include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
+#include "../../util/tasks/threaded_task.h"
+#include "../../util/thread/semaphore.h"
 #include "voxel_lod_terrain_update_task.h"
 
 // #include <fstream>
@@ -130,6 +135,24 @@ Vector3i get_relative_lod_distance_in_chunks( //
 	return ld3;
 }
 
+inline bool has_flags_changed(const VoxelLodTerrainUpdateData::PairedViewer &pv) {
+	return pv.state.requires_collisions != pv.prev_state.requires_collisions ||
+			pv.state.requires_visuals != pv.prev_state.requires_visuals;
+}
+
+// Tells if anything boxes of the viewer are computed from has changed since the previous update
+inline bool has_inputs_changed(const VoxelLodTerrainUpdateData::PairedViewer &pv) {
+	return pv.state.local_position_voxels != pv.prev_state.local_position_voxels ||
+			pv.state.view_distance_voxels.horizontal != pv.prev_state.view_distance_voxels.horizontal ||
+			pv.state.view_distance_voxels.vertical != pv.prev_state.view_distance_voxels.vertical ||
+			has_flags_changed(pv);
+}
+
+inline bool has_boxes_or_flags_changed(const VoxelLodTerrainUpdateData::PairedViewer &pv) {
+	return pv.state.data_box_per_lod != pv.prev_state.data_box_per_lod ||
+			pv.state.mesh_box_per_lod != pv.prev_state.mesh_box_per_lod || has_flags_changed(pv);
+}
+
 void process_viewers( //
 		VoxelLodTerrainUpdateData::ClipboxStreamingState &cs, //
 		const VoxelLodTerrainUpdateData::Settings &volume_settings, //
@@ -168,12 +191,25 @@ void process_viewers( //
 				pv.state.mesh_box_per_lod[lod_index] = Box3i();
 			}
 
+			pv.changed = true;
+
 			unpaired_viewers_to_remove.push_back(paired_viewer_index);
 		}
 	}
 
 	// TODO Pair/Unpair viewers as they intersect volume bounds
 
+	VoxelLodTerrainUpdateData::ClipboxStreamingState::BoxParameters box_parameters;
+	box_parameters.volume_bounds_in_voxels = volume_bounds_in_voxels;
+	box_parameters.lod_count = lod_count;
+	box_parameters.data_block_size_po2 = data_block_size_po2;
+	box_parameters.mesh_block_size_po2 = volume_settings.mesh_block_size_po2;
+	box_parameters.lod_distance = volume_settings.lod_distance;
+	box_parameters.secondary_lod_distance = volume_settings.secondary_lod_distance;
+
+	const bool box_parameters_changed = !(box_parameters == cs.box_parameters);
+	cs.box_parameters = box_parameters;
+
 	const Transform3D world_to_local_transform = volume_transform.affine_inverse();
 
 	// Note, this does not support non-uniform scaling
@@ -204,12 +240,14 @@ void process_viewers( //
 		const VoxelEngine::Viewer &viewer = viewer_and_id.second;
 
 		unsigned int paired_viewer_index;
+		bool is_new_viewer = false;
 		if (!find_index(to_span_const(cs.paired_viewers), viewer_id, paired_viewer_index)) {
 			// New viewer
 			VoxelLodTerrainUpdateData::PairedViewer pv;
 			pv.id = viewer_id;
 			paired_viewer_index = cs.paired_viewers.size();
 			cs.paired_viewers.push_back(pv);
+			is_new_viewer = true;
 			ZN_PRINT_VERBOSE(format("Pairing viewer {} to VoxelLodTerrain", viewer_id));
 		}
 
@@ -244,6 +282,12 @@ void process_viewers( //
 		paired_viewer.state.requires_collisions = viewer.require_collisions && can_mesh;
 		paired_viewer.state.requires_visuals = viewer.require_visuals && can_mesh;
 
+		if (!is_new_viewer && !box_parameters_changed && !has_inputs_changed(paired_viewer)) {
+			// Boxes would be the same as before, skip the viewer entirely
+			paired_viewer.changed = false;
+			continue;
+		}
+
 		// Viewers can request any box they like, but they must follow these rules:
 		// - Boxes of parent LODs must contain child boxes (when converted into world coordinates)
 		// - Mesh boxes that have a parent LOD must have an even size and even position, in order to support subdivision
@@ -366,6 +410,9 @@ void process_viewers( //
 				paired_viewer.state.data_box_per_lod[lod_index] = new_data_box;
 			}
 		}
+
+		// The viewer could have moved without crossing chunk boundaries
+		paired_viewer.changed = has_boxes_or_flags_changed(paired_viewer);
 	}
 }
 
@@ -450,13 +497,13 @@ void unreference_data_block_from_loading_lists( //
 }
 
 void process_data_blocks_sliding_box( //
-		VoxelLodTerrainUpdateData::State &state, //
+		VoxelLodTerrainUpdateData::Lod &lod, //
+		unsigned int lod_index, //
 		VoxelData &data, //
+		Span<const VoxelLodTerrainUpdateData::PairedViewer *const> paired_viewers, //
 		StdVector<VoxelData::BlockToSave> *blocks_to_save, //
 		// TODO We should be able to work in BOXES to load, it can help compressing network messages
 		StdVector<VoxelLodTerrainUpdateData::BlockToLoad> &data_blocks_to_load, //
-		const VoxelLodTerrainUpdateData::Settings &settings, //
-		int lod_count, //
 		bool can_load //
 ) {
 	ZN_PROFILE_SCOPE();
@@ -465,152 +512,125 @@ void process_data_blocks_sliding_box( //
 	const int data_block_size_po2 = data.get_block_size_po2();
 	const Box3i bounds_in_voxels = data.get_bounds();
 
-	// const int mesh_to_data_factor = mesh_block_size / data_block_size;
+	// Each LOD keeps a box of loaded blocks, and only some of the blocks will get polygonized.
+	// The player can edit them so changes can be propagated to lower lods.
 
-	// const int lod_distance_in_mesh_chunks = get_lod_distance_in_mesh_chunks(settings.lod_distance, mesh_block_size);
+	const unsigned int lod_data_block_size_po2 = data_block_size_po2 + lod_index;
 
-	// // Data chunks are driven by mesh chunks, because mesh needs data
-	// const int lod_distance_in_data_chunks = lod_distance_in_mesh_chunks * mesh_to_data_factor
-	// 		// To account for the fact meshes need neighbor data chunks
-	// 		+ 1;
+	// Should be correct as long as bounds size is a multiple of the biggest LOD chunk
+	const Box3i bounds_in_data_blocks = Box3i( //
+			bounds_in_voxels.position >> lod_data_block_size_po2, //
+			bounds_in_voxels.size >> lod_data_block_size_po2);
 
 	static thread_local StdVector<Vector3i> tls_missing_blocks;
 	static thread_local StdVector<Vector3i> tls_found_blocks_positions;
 
-#ifdef DEV_ENABLED
-	Box3i debug_parent_box;
-#endif
-
-	for (const VoxelLodTerrainUpdateData::PairedViewer &paired_viewer : state.clipbox_streaming.paired_viewers) {
-		// Iterating from big to small LOD so we can exit earlier if bounds don't intersect.
-		for (int lod_index = lod_count - 1; lod_index >= 0; --lod_index) {
-			ZN_PROFILE_SCOPE();
-			VoxelLodTerrainUpdateData::Lod &lod = state.lods[lod_index];
-
-			// Each LOD keeps a box of loaded blocks, and only some of the blocks will get polygonized.
-			// The player can edit them so changes can be propagated to lower lods.
-
-			const unsigned int lod_data_block_size_po2 = data_block_size_po2 + lod_index;
-
-			// Should be correct as long as bounds size is a multiple of the biggest LOD chunk
-			const Box3i bounds_in_data_blocks = Box3i( //
-					bounds_in_voxels.position >> lod_data_block_size_po2, //
-					bounds_in_voxels.size >> lod_data_block_size_po2);
+	for (const VoxelLodTerrainUpdateData::PairedViewer *paired_viewer : paired_viewers) {
+		// const Box3i new_data_box = get_lod_box_in_chunks(
+		// 		viewer_pos_in_lod0_voxels, lod_distance_in_data_chunks, data_block_size_po2, lod_index)
+		// 								   .clipped(bounds_in_data_blocks);
 
-			// const Box3i new_data_box = get_lod_box_in_chunks(
-			// 		viewer_pos_in_lod0_voxels, lod_distance_in_data_chunks, data_block_size_po2, lod_index)
-			// 								   .clipped(bounds_in_data_blocks);
-
-			const Box3i &new_data_box = paired_viewer.state.data_box_per_lod[lod_index];
-			const Box3i &prev_data_box = paired_viewer.prev_state.data_box_per_lod[lod_index];
-
-#ifdef DEV_ENABLED
-			if (lod_index + 1 != lod_count) {
-				const Box3i debug_parent_box_in_current_lod(debug_parent_box.position << 1, debug_parent_box.size << 1);
-				ZN_ASSERT(debug_parent_box_in_current_lod.contains(new_data_box));
-			}
-			debug_parent_box = new_data_box;
-#endif
+		const Box3i &new_data_box = paired_viewer->state.data_box_per_lod[lod_index];
+		const Box3i &prev_data_box = paired_viewer->prev_state.data_box_per_lod[lod_index];
 
-			// const Box3i prev_data_box = get_lod_box_in_chunks(
-			// 		state.clipbox_streaming.viewer_pos_in_lod0_voxels_previous_update,
-			// 		state.clipbox_streaming.lod_distance_in_data_chunks_previous_update, data_block_size_po2, lod_index)
-			// 									.clipped(bounds_in_data_blocks);
+		// const Box3i prev_data_box = get_lod_box_in_chunks(
+		// 		state.clipbox_streaming.viewer_pos_in_lod0_voxels_previous_update,
+		// 		state.clipbox_streaming.lod_distance_in_data_chunks_previous_update, data_block_size_po2, lod_index)
+		// 									.clipped(bounds_in_data_blocks);
 
-			if (!new_data_box.intersects(bounds_in_data_blocks) && !prev_data_box.intersects(bounds_in_data_blocks)) {
-				// If this box doesn't intersect either now or before, there is no chance a smaller one will
-				break;
-			}
+		if (!new_data_box.intersects(bounds_in_data_blocks) && !prev_data_box.intersects(bounds_in_data_blocks)) {
+			// This viewer has nothing to load or unload in this LOD
+			continue;
+		}
 
-			if (prev_data_box != new_data_box) {
-				// Detect blocks to load.
-				if (can_load) {
-					tls_missing_blocks.clear();
+		if (prev_data_box != new_data_box) {
+			// Detect blocks to load.
+			if (can_load) {
+				tls_missing_blocks.clear();
 
-					new_data_box.difference(prev_data_box, [&data, lod_index](Box3i box_to_load) {
-						data.view_area(box_to_load, lod_index, &tls_missing_blocks, nullptr, nullptr);
-					});
+				new_data_box.difference(prev_data_box, [&data, lod_index](Box3i box_to_load) {
+					data.view_area(box_to_load, lod_index, &tls_missing_blocks, nullptr, nullptr);
+				});
 
-					{
-						ZN_PROFILE_SCOPE_NAMED("Add loading blocks");
-						for (const Vector3i bpos : tls_missing_blocks) {
-							add_loading_block(lod, bpos, lod_index, data_blocks_to_load);
-						}
+				{
+					ZN_PROFILE_SCOPE_NAMED("Add loading blocks");
+					for (const Vector3i bpos : tls_missing_blocks) {
+						add_loading_block(lod, bpos, lod_index, data_blocks_to_load);
 					}
 				}
+			}
 
-				// Detect blocks to unload
-				{
-					tls_missing_blocks.clear();
-					tls_found_blocks_positions.clear();
+			// Detect blocks to unload
+			{
+				tls_missing_blocks.clear();
+				tls_found_blocks_positions.clear();
 
-					const unsigned int to_save_index0 = blocks_to_save != nullptr ? blocks_to_save->size() : 0;
+				const unsigned int to_save_index0 = blocks_to_save != nullptr ? blocks_to_save->size() : 0;
 
-					prev_data_box.difference(new_data_box, [&data, blocks_to_save, lod_index](Box3i box_to_remove) {
-						data.unview_area(box_to_remove, lod_index, &tls_found_blocks_positions, &tls_missing_blocks,
-								blocks_to_save);
-					});
+				prev_data_box.difference(new_data_box, [&data, blocks_to_save, lod_index](Box3i box_to_remove) {
+					data.unview_area(box_to_remove, lod_index, &tls_found_blocks_positions, &tls_missing_blocks,
+							blocks_to_save);
+				});
 
-					if (blocks_to_save != nullptr && blocks_to_save->size() > to_save_index0) {
-						add_unloaded_saving_blocks(lod, to_span(*blocks_to_save).sub(to_save_index0));
-					}
+				if (blocks_to_save != nullptr && blocks_to_save->size() > to_save_index0) {
+					add_unloaded_saving_blocks(lod, to_span(*blocks_to_save).sub(to_save_index0));
+				}
 
-					// Remove loading blocks regardless of refcount (those were loaded and had their refcount reach
-					// zero)
-					for (const Vector3i bpos : tls_found_blocks_positions) {
-						// emit_data_block_unloaded(bpos);
+				// Remove loading blocks regardless of refcount (those were loaded and had their refcount reach
+				// zero)
+				for (const Vector3i bpos : tls_found_blocks_positions) {
+					// emit_data_block_unloaded(bpos);
 
-						// TODO If they were loaded, why would they be in loading blocks?
-						// Maybe to make sure they are not in here regardless
-						lod.loading_blocks.erase(bpos);
-					}
+					// TODO If they were loaded, why would they be in loading blocks?
+					// Maybe to make sure they are not in here regardless
+					lod.loading_blocks.erase(bpos);
+				}
 
-					// Remove refcount from loading blocks, and cancel loading if it reaches zero
-					for (const Vector3i bpos : tls_missing_blocks) {
-						unreference_data_block_from_loading_lists(
-								lod.loading_blocks, data_blocks_to_load, bpos, lod_index);
-					}
+				// Remove refcount from loading blocks, and cancel loading if it reaches zero
+				for (const Vector3i bpos : tls_missing_blocks) {
+					unreference_data_block_from_loading_lists(
+							lod.loading_blocks, data_blocks_to_load, bpos, lod_index);
 				}
 			}
+		}
 
-			// Turned this off because I don't remember why I added it. Keeping it in case a bug occurs that could
-			// highlight why it was there.
-			// Was originally added in 17c6b1f557c5abc447cb62c200afcff1298fadff
-			// Perhaps that's in case there was updates pending in the list before we get here, so there needs to be
-			// some way of cancelling them? But with clipbox logic and multiple viewers, that no longer works
+		// Turned this off because I don't remember why I added it. Keeping it in case a bug occurs that could
+		// highlight why it was there.
+		// Was originally added in 17c6b1f557c5abc447cb62c200afcff1298fadff
+		// Perhaps that's in case there was updates pending in the list before we get here, so there needs to be
+		// some way of cancelling them? But with clipbox logic and multiple viewers, that no longer works
 #if 0
-			// TODO Why do we do this here? Sounds like it should be done in the mesh clipbox logic
-			{
-				ZN_PROFILE_SCOPE_NAMED("Cancel updates");
-				// Cancel mesh block updates that are not within the padded region
-				// (since neighbors are always required to remesh)
-
-				// TODO This might break at terrain borders
-				const Box3i padded_new_box = new_data_box.padded(-1);
-				Box3i mesh_box;
-				if (mesh_block_size > data_block_size) {
-					const int factor = mesh_block_size / data_block_size;
-					mesh_box = padded_new_box.downscaled_inner(factor);
-				} else {
-					mesh_box = padded_new_box;
-				}
+		// TODO Why do we do this here? Sounds like it should be done in the mesh clipbox logic
+		{
+			ZN_PROFILE_SCOPE_NAMED("Cancel updates");
+			// Cancel mesh block updates that are not within the padded region
+			// (since neighbors are always required to remesh)
+
+			// TODO This might break at terrain borders
+			const Box3i padded_new_box = new_data_box.padded(-1);
+			Box3i mesh_box;
+			if (mesh_block_size > data_block_size) {
+				const int factor = mesh_block_size / data_block_size;
+				mesh_box = padded_new_box.downscaled_inner(factor);
+			} else {
+				mesh_box = padded_new_box;
+			}
 
-				unordered_remove_if(lod.mesh_blocks_pending_update,
-						[&lod, mesh_box](const VoxelLodTerrainUpdateData::MeshToUpdate &mtu) {
-							if (mesh_box.contains(mtu.position)) {
-								return false;
-							} else {
-								auto mesh_block_it = lod.mesh_map_state.map.find(mtu.position);
-								if (mesh_block_it != lod.mesh_map_state.map.end()) {
-									mesh_block_it->second.state = VoxelLodTerrainUpdateData::MESH_NEED_UPDATE;
-								}
-								return true;
+			unordered_remove_if(lod.mesh_blocks_pending_update,
+					[&lod, mesh_box](const VoxelLodTerrainUpdateData::MeshToUpdate &mtu) {
+						if (mesh_box.contains(mtu.position)) {
+							return false;
+						} else {
+							auto mesh_block_it = lod.mesh_map_state.map.find(mtu.position);
+							if (mesh_block_it != lod.mesh_map_state.map.end()) {
+								mesh_block_it->second.state = VoxelLodTerrainUpdateData::MESH_NEED_UPDATE;
 							}
-						});
-			}
+							return true;
+						}
+					});
+		}
 #endif
 
-		} // for each lod
 	} // for each viewer
 
 	// state.clipbox_streaming.lod_distance_in_data_chunks_previous_update = lod_distance_in_data_chunks;
@@ -823,8 +843,16 @@ void view_mesh_box(const Box3i box_to_add, VoxelLodTerrainUpdateData::Lod &lod,
 	});
 }
 
-void unview_mesh_box(const Box3i out_of_range_box, VoxelLodTerrainUpdateData::Lod &lod, unsigned int lod_index,
-		unsigned int lod_count, VoxelLodTerrainUpdateData::State &state, bool visual_flag, bool collision_flag) {
+// Mesh box that went out of range of a viewer. Parents of its blocks are shown after all LODs are processed, because
+// that involves two LODs, while processing of each LOD only accesses that LOD.
+struct UnviewedMeshBox {
+	Box3i box;
+	bool visual;
+	bool collision;
+};
+
+void unview_mesh_box(const Box3i out_of_range_box, VoxelLodTerrainUpdateData::Lod &lod, bool visual_flag,
+		bool collision_flag, StdVector<UnviewedMeshBox> &unviewed_mesh_boxes) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(collision_flag || visual_flag);
 
@@ -884,18 +912,32 @@ void unview_mesh_box(const Box3i out_of_range_box, VoxelLodTerrainUpdateData::Lo
 		}
 	});
 
+	unviewed_mesh_boxes.push_back(UnviewedMeshBox{ out_of_range_box, visual_flag, collision_flag });
+}
+
+void show_parents_of_unviewed_mesh_box(const UnviewedMeshBox &unviewed_box, unsigned int lod_index,
+		unsigned int lod_count, VoxelLodTerrainUpdateData::State &state) {
 	// Immediately show parent when children are removed.
 	// This is a cheap approach as the parent mesh will be available most of the time.
 	// However, at high speeds, if loading can't keep up, holes and overlaps will start happening in the
 	// opposite direction of movement.
 	const unsigned int parent_lod_index = lod_index + 1;
 	if (parent_lod_index < lod_count) {
+		ZN_PROFILE_SCOPE();
+
+		const Box3i &out_of_range_box = unviewed_box.box;
+		const bool visual_flag = unviewed_box.visual;
+		const bool collision_flag = unviewed_box.collision;
+
 		// Should always work without reaching zero size because non-max LODs are always
 		// multiple of 2 due to subdivision rules
 		const Box3i parent_box = Box3i(out_of_range_box.position >> 1, out_of_range_box.size >> 1);
 
+		const VoxelLodTerrainUpdateData::Lod &lod = state.lods[lod_index];
 		VoxelLodTerrainUpdateData::Lod &parent_lod = state.lods[parent_lod_index];
 
+		RWLockWrite wlock(parent_lod.mesh_map_state.map_lock);
+
 		// Show parents when children are removed
 		parent_box.for_each_cell([&parent_lod, //
 										 &lod, //
@@ -982,135 +1024,112 @@ inline bool requires_meshes(const VoxelLodTerrainUpdateData::PairedViewer::State
 }
 
 void process_viewer_mesh_blocks_sliding_box( //
-		VoxelLodTerrainUpdateData::State &state, //
-		int mesh_block_size_po2, //
-		int lod_count, //
-		const Box3i &volume_bounds_in_voxels, //
+		VoxelLodTerrainUpdateData::Lod &lod, //
+		unsigned int lod_index, //
+		const Box3i &bounds_in_mesh_blocks, //
 		const VoxelLodTerrainUpdateData::PairedViewer &paired_viewer, //
 		bool can_load, //
 		bool is_full_load_mode, //
 		int mesh_to_data_factor, //
-		const VoxelData &data //
+		const VoxelData &data, //
+		StdVector<UnviewedMeshBox> &unviewed_mesh_boxes //
 ) {
-	ZN_PROFILE_SCOPE();
-
-#ifdef DEV_ENABLED
-	Box3i debug_parent_box;
-#endif
-
 	// TODO Optimize: when a viewer doesn't need visuals, we only need to build meshes for collisions up to a certain
 	// LOD (collision max LOD property). That would be an optimization for servers, NPCs and player hosts
 
-	// Iterating from big to small LOD so we can exit earlier if bounds don't intersect.
-	for (int lod_index = lod_count - 1; lod_index >= 0; --lod_index) {
-		ZN_PROFILE_SCOPE();
-		VoxelLodTerrainUpdateData::Lod &lod = state.lods[lod_index];
+	// const Box3i new_mesh_box = get_lod_box_in_chunks(
+	// 		viewer_pos_in_lod0_voxels, lod_distance_in_mesh_chunks, mesh_block_size_po2, lod_index)
+	// 								   .clipped(bounds_in_mesh_blocks);
 
-		const int lod_mesh_block_size_po2 = mesh_block_size_po2 + lod_index;
-		const int lod_mesh_block_size = 1 << lod_mesh_block_size_po2;
-		// const Vector3i viewer_block_pos_within_lod = math::floor_to_int(p_viewer_pos) >> block_size_po2;
+	const Box3i &new_mesh_box = paired_viewer.state.mesh_box_per_lod[lod_index];
+	const Box3i &prev_mesh_box = paired_viewer.prev_state.mesh_box_per_lod[lod_index];
 
-		const Box3i bounds_in_mesh_blocks = volume_bounds_in_voxels.downscaled(lod_mesh_block_size);
+	// const Box3i prev_mesh_box = get_lod_box_in_chunks(
+	// 		state.clipbox_streaming.viewer_pos_in_lod0_voxels_previous_update,
+	// 		state.clipbox_streaming.lod_distance_in_mesh_chunks_previous_update, mesh_block_size_po2, lod_index)
+	// 									.clipped(bounds_in_mesh_blocks);
 
-		// const Box3i new_mesh_box = get_lod_box_in_chunks(
-		// 		viewer_pos_in_lod0_voxels, lod_distance_in_mesh_chunks, mesh_block_size_po2, lod_index)
-		// 								   .clipped(bounds_in_mesh_blocks);
-
-		const Box3i &new_mesh_box = paired_viewer.state.mesh_box_per_lod[lod_index];
-		const Box3i &prev_mesh_box = paired_viewer.prev_state.mesh_box_per_lod[lod_index];
-
-#ifdef DEV_ENABLED
-		if (lod_index + 1 != lod_count) {
-			const Box3i debug_parent_box_in_current_lod(debug_parent_box.position << 1, debug_parent_box.size << 1);
-			ZN_ASSERT(debug_parent_box_in_current_lod.contains(new_mesh_box));
-		}
-		debug_parent_box = new_mesh_box;
-#endif
-
-		// const Box3i prev_mesh_box = get_lod_box_in_chunks(
-		// 		state.clipbox_streaming.viewer_pos_in_lod0_voxels_previous_update,
-		// 		state.clipbox_streaming.lod_distance_in_mesh_chunks_previous_update, mesh_block_size_po2, lod_index)
-		// 									.clipped(bounds_in_mesh_blocks);
-
-		if (!new_mesh_box.intersects(bounds_in_mesh_blocks) && !prev_mesh_box.intersects(bounds_in_mesh_blocks)) {
-			// If this box doesn't intersect either now or before, there is no chance a smaller one will
-			break;
-		}
+	if (!new_mesh_box.intersects(bounds_in_mesh_blocks) && !prev_mesh_box.intersects(bounds_in_mesh_blocks)) {
+		// This viewer has nothing to load or unload in this LOD
+		return;
+	}
 
-		if (prev_mesh_box != new_mesh_box) {
-			RWLockWrite wlock(lod.mesh_map_state.map_lock);
+	if (prev_mesh_box != new_mesh_box) {
+		RWLockWrite wlock(lod.mesh_map_state.map_lock);
 
-			// Add meshes entering range
-			if (requires_meshes(paired_viewer.state) && can_load) {
-				SmallVector<Box3i, 6> new_mesh_boxes;
-				new_mesh_box.difference_to_vec(prev_mesh_box, new_mesh_boxes);
+		// Add meshes entering range
+		if (requires_meshes(paired_viewer.state) && can_load) {
+			SmallVector<Box3i, 6> new_mesh_boxes;
+			new_mesh_box.difference_to_vec(prev_mesh_box, new_mesh_boxes);
 
-				for (const Box3i &box_to_add : new_mesh_boxes) {
-					view_mesh_box(box_to_add, lod, lod_index, is_full_load_mode, mesh_to_data_factor, data,
-							paired_viewer.state.requires_visuals, paired_viewer.state.requires_collisions);
-				}
+			for (const Box3i &box_to_add : new_mesh_boxes) {
+				view_mesh_box(box_to_add, lod, lod_index, is_full_load_mode, mesh_to_data_factor, data,
+						paired_viewer.state.requires_visuals, paired_viewer.state.requires_collisions);
 			}
+		}
 
-			// Remove meshes out or range
-			if (requires_meshes(paired_viewer.prev_state)) {
-				SmallVector<Box3i, 6> old_mesh_boxes;
-				prev_mesh_box.difference_to_vec(new_mesh_box, old_mesh_boxes);
+		// Remove meshes out or range
+		if (requires_meshes(paired_viewer.prev_state)) {
+			SmallVector<Box3i, 6> old_mesh_boxes;
+			prev_mesh_box.difference_to_vec(new_mesh_box, old_mesh_boxes);
 
-				for (const Box3i &out_of_range_box : old_mesh_boxes) {
-					unview_mesh_box(out_of_range_box, lod, lod_index, lod_count, state,
-							// Use previous state because old boxes were loaded because of them
-							paired_viewer.prev_state.requires_visuals, paired_viewer.prev_state.requires_collisions);
-				}
+			for (const Box3i &out_of_range_box : old_mesh_boxes) {
+				unview_mesh_box(out_of_range_box, lod,
+						// Use previous state because old boxes were loaded because of them
+						paired_viewer.prev_state.requires_visuals, paired_viewer.prev_state.requires_collisions,
+						unviewed_mesh_boxes);
 			}
 		}
+	}
 
-		// Handle viewer flags changes at runtime. However I can't think of a use case at the moment, outside of
-		// temporary editor stuff. It should be rare, or just never happen.
-		// This operates on a DISTINCT set of blocks than the one above.
-		// Also, this won't do anything on new viewers that have no previous state, because the previous box will be
-		// empty.
-		if (!Vector3iUtil::is_empty_size(prev_mesh_box.size)) {
-			if (paired_viewer.state.requires_collisions != paired_viewer.prev_state.requires_collisions) {
-				const Box3i box = new_mesh_box.clipped(prev_mesh_box);
-				if (paired_viewer.state.requires_collisions) {
-					// Add refcount to just collisions
-					view_mesh_box(box, lod, lod_index, is_full_load_mode, mesh_to_data_factor, data, false, true);
-				} else {
-					// Remove refcount to just collisions
-					unview_mesh_box(box, lod, lod_index, lod_count, state, false, true);
-				}
+	// Handle viewer flags changes at runtime. However I can't think of a use case at the moment, outside of
+	// temporary editor stuff. It should be rare, or just never happen.
+	// This operates on a DISTINCT set of blocks than the one above.
+	// Also, this won't do anything on new viewers that have no previous state, because the previous box will be
+	// empty.
+	if (!Vector3iUtil::is_empty_size(prev_mesh_box.size)) {
+		if (paired_viewer.state.requires_collisions != paired_viewer.prev_state.requires_collisions) {
+			const Box3i box = new_mesh_box.clipped(prev_mesh_box);
+			if (paired_viewer.state.requires_collisions) {
+				// Add refcount to just collisions
+				view_mesh_box(box, lod, lod_index, is_full_load_mode, mesh_to_data_factor, data, false, true);
+			} else {
+				// Remove refcount to just collisions
+				unview_mesh_box(box, lod, false, true, unviewed_mesh_boxes);
 			}
+		}
 
-			if (paired_viewer.state.requires_visuals != paired_viewer.prev_state.requires_visuals) {
-				const Box3i box = new_mesh_box.clipped(prev_mesh_box);
-				if (paired_viewer.state.requires_visuals) {
-					view_mesh_box(box, lod, lod_index, is_full_load_mode, mesh_to_data_factor, data, true, false);
-				} else {
-					unview_mesh_box(box, lod, lod_index, lod_count, state, true, false);
-				}
+		if (paired_viewer.state.requires_visuals != paired_viewer.prev_state.requires_visuals) {
+			const Box3i box = new_mesh_box.clipped(prev_mesh_box);
+			if (paired_viewer.state.requires_visuals) {
+				view_mesh_box(box, lod, lod_index, is_full_load_mode, mesh_to_data_factor, data, true, false);
+			} else {
+				unview_mesh_box(box, lod, true, false, unviewed_mesh_boxes);
 			}
 		}
-
-		// {
-		// 	ZN_PROFILE_SCOPE_NAMED("Cancel updates");
-		// 	// Cancel block updates that are not within the new region
-		// 	unordered_remove_if(lod.mesh_blocks_pending_update,
-		// 			[new_mesh_box](const VoxelLodTerrainUpdateData::MeshToUpdate &mtu) { //
-		// 				return !new_mesh_box.contains(mtu.position);
-		// 			});
-		// }
 	}
+
+	// {
+	// 	ZN_PROFILE_SCOPE_NAMED("Cancel updates");
+	// 	// Cancel block updates that are not within the new region
+	// 	unordered_remove_if(lod.mesh_blocks_pending_update,
+	// 			[new_mesh_box](const VoxelLodTerrainUpdateData::MeshToUpdate &mtu) { //
+	// 				return !new_mesh_box.contains(mtu.position);
+	// 			});
+	// }
 }
 
 void process_mesh_blocks_sliding_box( //
-		VoxelLodTerrainUpdateData::State &state, //
+		VoxelLodTerrainUpdateData::Lod &lod, //
+		unsigned int lod_index, //
+		Span<const VoxelLodTerrainUpdateData::PairedViewer *const> paired_viewers, //
 		const VoxelLodTerrainUpdateData::Settings &settings, //
 		const Box3i bounds_in_voxels, //
-		int lod_count, //
 		bool is_full_load_mode, //
 		bool can_load, //
 		const VoxelData &data, //
-		int data_block_size //
+		int data_block_size, //
+		StdVector<UnviewedMeshBox> &unviewed_mesh_boxes //
 ) {
 	ZN_PROFILE_SCOPE();
 
@@ -1121,12 +1140,14 @@ void process_mesh_blocks_sliding_box( //
 	const int mesh_block_size = 1 << mesh_block_size_po2;
 	const int mesh_to_data_factor = mesh_block_size / data_block_size;
 
-	for (const VoxelLodTerrainUpdateData::PairedViewer &paired_viewer : state.clipbox_streaming.paired_viewers) {
+	const Box3i bounds_in_mesh_blocks = bounds_in_voxels.downscaled(mesh_block_size << lod_index);
+
+	for (const VoxelLodTerrainUpdateData::PairedViewer *paired_viewer : paired_viewers) {
 		// Only update around viewers that need meshes.
 		// Check previous state too in case we have to handle them changing
-		if (requires_meshes(paired_viewer.state) || requires_meshes(paired_viewer.prev_state)) {
-			process_viewer_mesh_blocks_sliding_box(state, mesh_block_size_po2, lod_count, bounds_in_voxels,
-					paired_viewer, can_load, is_full_load_mode, mesh_to_data_factor, data);
+		if (requires_meshes(paired_viewer->state) || requires_meshes(paired_viewer->prev_state)) {
+			process_viewer_mesh_blocks_sliding_box(lod, lod_index, bounds_in_mesh_blocks, *paired_viewer, can_load,
+					is_full_load_mode, mesh_to_data_factor, data, unviewed_mesh_boxes);
 		}
 	}
 
@@ -1498,6 +1519,151 @@ void process_loaded_mesh_blocks_trigger_visibility_changes( //
 	}
 }
 
+#ifdef DEV_ENABLED
+
+// Boxes of parent LODs must contain boxes of child LODs
+void debug_check_boxes_nesting(
+		const FixedArray<Box3i, constants::MAX_LOD> &boxes,
+		const FixedArray<Box3i, constants::MAX_LOD> &prev_boxes,
+		unsigned int lod_count,
+		const Box3i &bounds_in_voxels,
+		int block_size_po2
+) {
+	for (int lod_index = lod_count - 1; lod_index >= 0; --lod_index) {
+		const Box3i bounds_in_blocks = bounds_in_voxels.downscaled(1 << (block_size_po2 + lod_index));
+		if (!boxes[lod_index].intersects(bounds_in_blocks) && !prev_boxes[lod_index].intersects(bounds_in_blocks)) {
+			// If this box doesn't intersect either now or before, there is no chance a smaller one will
+			break;
+		}
+		if (lod_index + 1 != static_cast<int>(lod_count)) {
+			const Box3i &parent_box = boxes[lod_index + 1];
+			const Box3i parent_box_in_current_lod(parent_box.position << 1, parent_box.size << 1);
+			ZN_ASSERT(parent_box_in_current_lod.contains(boxes[lod_index]));
+		}
+	}
+}
+
+#endif
+
+// Results of processing one LOD. They are merged in a fixed order after all LODs are processed, so they don't depend on
+// which thread processed which LOD.
+struct LodSlidingBoxesOutput {
+	StdVector<VoxelLodTerrainUpdateData::BlockToLoad> data_blocks_to_load;
+	StdVector<VoxelData::BlockToSave> data_blocks_to_save;
+	StdVector<UnviewedMeshBox> unviewed_mesh_boxes;
+
+	void clear() {
+		data_blocks_to_load.clear();
+		data_blocks_to_save.clear();
+		unviewed_mesh_boxes.clear();
+	}
+};
+
+// Diffs boxes of viewers that changed. Each LOD only accesses its own state, so LODs can be processed in parallel.
+struct SlidingBoxesJob {
+	VoxelLodTerrainUpdateData::State &state;
+	VoxelData &data;
+	Span<const VoxelLodTerrainUpdateData::PairedViewer *const> paired_viewers;
+	const VoxelLodTerrainUpdateData::Settings &settings;
+	Span<LodSlidingBoxesOutput> outputs;
+	bool streaming_enabled;
+	bool save_unloaded_blocks;
+	bool can_load;
+
+	void process_lod(unsigned int lod_index) const {
+		ZN_PROFILE_SCOPE();
+
+		VoxelLodTerrainUpdateData::Lod &lod = state.lods[lod_index];
+		LodSlidingBoxesOutput &output = outputs[lod_index];
+
+		if (streaming_enabled) {
+			process_data_blocks_sliding_box(lod, lod_index, data, paired_viewers,
+					save_unloaded_blocks ? &output.data_blocks_to_save : nullptr, output.data_blocks_to_load,
+					can_load);
+		}
+
+		process_mesh_blocks_sliding_box(lod, lod_index, paired_viewers, settings, data.get_bounds(),
+				!streaming_enabled, can_load, data, data.get_block_size(), output.unviewed_mesh_boxes);
+	}
+};
+
+// LODs are claimed from a shared counter by the thread running the update and by helper tasks. Helpers that start after
+// all LODs were claimed do nothing, so the update never waits for a task that didn't start.
+struct ParallelSlidingBoxesSync {
+	std::atomic_uint32_t next_index = { 0 };
+	std::atomic_uint32_t remaining_count = { 0 };
+	unsigned int lod_count = 0;
+	// Only accessed after claiming a LOD, because it stops being valid once all LODs are processed
+	const SlidingBoxesJob *job = nullptr;
+	// Posted by the helper that completes the last LOD
+	Semaphore completion;
+};
+
+// Returns true if the calling thread completed the last LOD
+bool process_claimed_lods(ParallelSlidingBoxesSync &sync) {
+	bool completed_last = false;
+	while (true) {
+		const uint32_t i = sync.next_index.fetch_add(1);
+		if (i >= sync.lod_count) {
+			break;
+		}
+		// Bigger LODs first
+		sync.job->process_lod(sync.lod_count - 1 - i);
+		if (sync.remaining_count.fetch_sub(1) == 1) {
+			completed_last = true;
+		}
+	}
+	return completed_last;
+}
+
+class ProcessSlidingBoxesTask : public IThreadedTask {
+public:
+	ProcessSlidingBoxesTask(std::shared_ptr<ParallelSlidingBoxesSync> sync) : _sync(sync) {}
+
+	void run(ThreadedTaskContext &ctx) override {
+		ZN_PROFILE_SCOPE();
+		if (process_claimed_lods(*_sync)) {
+			_sync->completion.post();
+		}
+	}
+
+	const char *get_debug_name() const override {
+		return "ProcessSlidingBoxes";
+	}
+
+private:
+	std::shared_ptr<ParallelSlidingBoxesSync> _sync;
+};
+
+void process_sliding_boxes(const SlidingBoxesJob &job, unsigned int lod_count, bool parallel) {
+	if (!parallel || lod_count <= 1) {
+		for (int lod_index = lod_count - 1; lod_index >= 0; --lod_index) {
+			job.process_lod(lod_index);
+		}
+		return;
+	}
+
+	ZN_PROFILE_SCOPE();
+
+	std::shared_ptr<ParallelSlidingBoxesSync> sync = make_shared_instance<ParallelSlidingBoxesSync>();
+	sync->lod_count = lod_count;
+	sync->remaining_count = lod_count;
+	sync->job = &job;
+
+	// The current thread processes LODs too
+	FixedArray<IThreadedTask *, constants::MAX_LOD> tasks;
+	const unsigned int task_count = lod_count - 1;
+	for (unsigned int i = 0; i < task_count; ++i) {
+		tasks[i] = ZN_NEW(ProcessSlidingBoxesTask(sync));
+	}
+	VoxelEngine::get_singleton().push_async_tasks(to_span(tasks, task_count));
+
+	if (!process_claimed_lods(*sync)) {
+		// Helpers are still processing the LODs they claimed
+		sync->completion.wait();
+	}
+}
+
 } // namespace
 
 void process_clipbox_streaming( //
@@ -1524,21 +1690,69 @@ void process_clipbox_streaming( //
 	process_viewers(state.clipbox_streaming, settings, lod_count, viewers, volume_transform, bounds_in_voxels,
 			data_block_size_po2, can_mesh, unpaired_viewers_to_remove);
 
-	if (streaming_enabled) {
-		process_data_blocks_sliding_box(
-				state, data, data_blocks_to_save, data_blocks_to_load, settings, lod_count, can_load);
-	} else {
-		if (full_load_completed == false) {
-			// Don't do anything until things are loaded, because we'll trigger meshing directly when mesh blocks get
-			// created. If we let this happen before, mesh blocks will get created but we won't have a way to tell when
-			// to trigger meshing per block. If we need to do that in the future though, we could diff the "fully
-			// loaded" state and iterate all mesh blocks when it becomes true?
-			return;
+	if (!streaming_enabled && full_load_completed == false) {
+		// Don't do anything until things are loaded, because we'll trigger meshing directly when mesh blocks get
+		// created. If we let this happen before, mesh blocks will get created but we won't have a way to tell when
+		// to trigger meshing per block. If we need to do that in the future though, we could diff the "fully
+		// loaded" state and iterate all mesh blocks when it becomes true?
+		return;
+	}
+
+	// Viewers that didn't move don't need their boxes to be diffed
+	static thread_local StdVector<const VoxelLodTerrainUpdateData::PairedViewer *> tls_changed_viewers;
+	StdVector<const VoxelLodTerrainUpdateData::PairedViewer *> &changed_viewers = tls_changed_viewers;
+	changed_viewers.clear();
+	for (const VoxelLodTerrainUpdateData::PairedViewer &paired_viewer : state.clipbox_streaming.paired_viewers) {
+		if (paired_viewer.changed) {
+			changed_viewers.push_back(&paired_viewer);
+
+#ifdef DEV_ENABLED
+			if (streaming_enabled) {
+				debug_check_boxes_nesting(paired_viewer.state.data_box_per_lod,
+						paired_viewer.prev_state.data_box_per_lod, lod_count, bounds_in_voxels, data_block_size_po2);
+			}
+			if (requires_meshes(paired_viewer.state) || requires_meshes(paired_viewer.prev_state)) {
+				debug_check_boxes_nesting(paired_viewer.state.mesh_box_per_lod,
+						paired_viewer.prev_state.mesh_box_per_lod, lod_count, bounds_in_voxels,
+						settings.mesh_block_size_po2);
+			}
+#endif
 		}
 	}
 
-	process_mesh_blocks_sliding_box(
-			state, settings, bounds_in_voxels, lod_count, !streaming_enabled, can_load, data, 1 << data_block_size_po2);
+	if (changed_viewers.size() > 0) {
+		static thread_local FixedArray<LodSlidingBoxesOutput, constants::MAX_LOD> tls_lod_outputs;
+
+		const SlidingBoxesJob job{
+			state, //
+			data, //
+			to_span_const(changed_viewers), //
+			settings, //
+			to_span(tls_lod_outputs), //
+			streaming_enabled, //
+			data_blocks_to_save != nullptr, //
+			can_load //
+		};
+
+		// With few viewers moving, there isn't enough work to be worth spreading over threads
+		const unsigned int min_changed_viewers_for_parallel = 4;
+		process_sliding_boxes(job, lod_count, changed_viewers.size() >= min_changed_viewers_for_parallel);
+
+		for (int lod_index = lod_count - 1; lod_index >= 0; --lod_index) {
+			LodSlidingBoxesOutput &output = tls_lod_outputs[lod_index];
+
+			append_array(data_blocks_to_load, output.data_blocks_to_load);
+			if (data_blocks_to_save != nullptr) {
+				append_array(*data_blocks_to_save, output.data_blocks_to_save);
+			}
+
+			for (const UnviewedMeshBox &unviewed_box : output.unviewed_mesh_boxes) {
+				show_parents_of_unviewed_mesh_box(unviewed_box, lod_index, lod_count, state);
+			}
+
+			output.clear();
+		}
+	}
 
 	// Removing paired viewers after box diffs because we interpret viewer removal as boxes becoming zero-size, so we
 	// need one processing step to handle that before actually removing them
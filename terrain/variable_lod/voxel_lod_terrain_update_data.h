@@ -20,6 +20,8 @@ class AsyncDependencyTracker;
 
 namespace voxel {
 
+class IncrementalMeshHistory;
+
 // Settings and states needed for the multi-threaded part of the update loop of VoxelLodTerrain.
 // See `VoxelLodTerrainUpdateTask` for more info.
 struct VoxelLodTerrainUpdateData {
@@ -74,6 +76,8 @@ struct VoxelLodTerrainUpdateData {
 		// Not really exposed for now, will wait for it to be really needed. It might never be.
 		bool cache_generated_blocks = false;
 		bool collision_enabled = true;
+		// Collisions are only built for LODs below this count. 0 means all LODs.
+		unsigned int collision_lod_count = 0;
 		bool detail_textures_use_gpu = false;
 		bool generator_use_gpu = false;
 		uint8_t detail_texture_generator_override_begin_lod_index = 0;
@@ -129,6 +133,9 @@ struct VoxelLodTerrainUpdateData {
 		std::atomic_bool visual_loaded;
 		std::atomic_bool collision_loaded;
 
+		// Only allocated if the mesher supports incremental builds.
+		std::shared_ptr<IncrementalMeshHistory> incremental_history;
+
 		// bool pending_update_has_visuals;
 		// bool pending_update_has_collision;
 
@@ -276,6 +283,9 @@ struct VoxelLodTerrainUpdateData {
 		ViewerID id;
 		State state;
 		State prev_state;
+		// True if boxes or flags of the viewer changed in the last update. Viewers that didn't change are skipped
+		// when diffing boxes.
+		bool changed = true;
 	};
 
 	struct LoadedMeshBlockEvent {
@@ -286,7 +296,27 @@ struct VoxelLodTerrainUpdateData {
 	};
 
 	struct ClipboxStreamingState {
+		// Volume parameters boxes of paired viewers depend on, besides the viewers themselves
+		struct BoxParameters {
+			Box3i volume_bounds_in_voxels;
+			unsigned int lod_count = 0;
+			int data_block_size_po2 = 0;
+			int mesh_block_size_po2 = 0;
+			float lod_distance = 0.f;
+			float secondary_lod_distance = 0.f;
+
+			inline bool operator==(const BoxParameters &other) const {
+				return volume_bounds_in_voxels == other.volume_bounds_in_voxels && lod_count == other.lod_count &&
+						data_block_size_po2 == other.data_block_size_po2 &&
+						mesh_block_size_po2 == other.mesh_block_size_po2 && lod_distance == other.lod_distance &&
+						secondary_lod_distance == other.secondary_lod_distance;
+			}
+		};
+
 		StdVector<PairedViewer> paired_viewers;
+		// Parameters boxes of paired viewers were last computed with. If they change, boxes of all viewers are computed
+		// again. Otherwise, viewers that didn't move keep their boxes.
+		BoxParameters box_parameters;
 		// Vector3i viewer_pos_in_lod0_voxels_previous_update;
 		// int lod_distance_in_data_chunks_previous_update = 0;
 		// int lod_distance_in_mesh_chunks_previous_update = 0;
@@ -297,15 +297,26 @@ void send_mesh_requests( //
 			task->meshing_dependency = meshing_dependency;
 			task->data = data_ptr;
 			task->require_visual = mesh_to_update.require_visual;
-			task->collision_hint = settings.collision_enabled;
+			task->collision_hint = settings.collision_enabled &&
+					(settings.collision_lod_count == 0 || lod_index < settings.collision_lod_count);
 			task->detail_texture_settings = settings.detail_texture_settings;
 			task->detail_texture_generator_override = settings.detail_texture_generator_override;
 			task->detail_texture_generator_override_begin_lod_index =
 					settings.detail_texture_generator_override_begin_lod_index;
 			task->detail_texture_use_gpu = settings.detail_textures_use_gpu;
 			task->block_generation_use_gpu = settings.generator_use_gpu;
+			task->mesh_cache_hint = true;
 			task->cancellation_token = mesh_to_update.cancellation_token;
 
+			if (meshing_dependency->mesher->is_incremental_build_enabled()) {
+				if (mesh_block.incremental_history == nullptr) {
+					mesh_block.incremental_history = make_shared_instance<IncrementalMeshHistory>();
+				}
+				// Taken now, because voxels may be modified by edits as soon as the task is scheduled
+				task->incremental_history = mesh_block.incremental_history;
+				task->incremental_snapshot = mesh_block.incremental_history->take_snapshot();
+			}
+
 			// Don't update a detail texture if one update is already processing
 			if (settings.detail_texture_settings.enabled &&
 					lod_index >= settings.detail_texture_settings.begin_lod_index &&
@@ -503,6 +514,23 @@ void process_async_edits( //
 	}
 }
 
+// Tells the mesh history of a block which voxels changed, if it has one. The box is in LOD0 voxels.
+void add_incremental_mesh_dirty_box(
+		VoxelLodTerrainUpdateData::MeshBlockState &mesh_block,
+		const Vector3i mesh_block_pos,
+		const int mesh_block_size,
+		const unsigned int lod_index,
+		const Box3i voxel_box_lod0
+) {
+	if (mesh_block.incremental_history == nullptr) {
+		return;
+	}
+	// Padded because LOD mips are computed from neighbor voxels
+	Box3i box = voxel_box_lod0.downscaled(1 << lod_index).padded(1);
+	box.position -= mesh_block_pos * mesh_block_size;
+	mesh_block.incremental_history->add_dirty_box(box);
+}
+
 void process_changed_generated_areas( //
 		VoxelLodTerrainUpdateData::State &state, //
 		const VoxelLodTerrainUpdateData::Settings &settings, //
@@ -527,9 +555,10 @@ void process_changed_generated_areas( //
 
 			RWLockRead rlock(lod.mesh_map_state.map_lock);
 
-			bbox.for_each_cell_zxy([&lod](const Vector3i bpos) {
+			bbox.for_each_cell_zxy([&lod, &voxel_box, mesh_block_size, lod_index](const Vector3i bpos) {
 				auto block_it = lod.mesh_map_state.map.find(bpos);
 				if (block_it != lod.mesh_map_state.map.end()) {
+					add_incremental_mesh_dirty_box(block_it->second, bpos, mesh_block_size, lod_index, voxel_box);
 					VoxelLodTerrainUpdateTask::schedule_mesh_update(block_it->second, bpos,
 							lod.mesh_blocks_pending_update, block_it->second.mesh_viewers.get() > 0);
 				}
@@ -612,9 +641,12 @@ void VoxelLodTerrainUpdateTask::flush_pending_lod_edits( //
 			const Box3i padded_voxel_box = voxel_box.padded(1);
 			const Box3i mesh_block_box = padded_voxel_box.downscaled(mesh_block_size_at_lod);
 
-			mesh_block_box.for_each_cell([&lod](Vector3i mesh_block_pos) {
+			mesh_block_box.for_each_cell([&lod, &voxel_box, mesh_block_size, lod_index](Vector3i mesh_block_pos) {
 				auto mesh_block_it = lod.mesh_map_state.map.find(mesh_block_pos);
 				if (mesh_block_it != lod.mesh_map_state.map.end()) {
+					add_incremental_mesh_dirty_box(
+							mesh_block_it->second, mesh_block_pos, mesh_block_size, lod_index, voxel_box
+					);
 					// If a mesh block state exists here, it will need an update.
 					// If there is none, it will probably get created later when we come closer to it
 					schedule_mesh_update( //
@@ -36,8 +36,16 @@ public:
 	// 2 means using texture of grand-parent LOD (lod_index+2), etc.
 	uint8_t detail_texture_fallback_level = 0;
 
+	struct DeferredCollider {
+		// Only used if `has_shape` is false, the shape will be built from it on the main thread
+		VoxelMesher::Output mesher_output;
+		// Shape built by the meshing task, can be null
+		Ref<Shape3D> shape;
+		bool has_shape = false;
+	};
+
 	uint64_t last_collider_update_time = 0;
-	UniquePtr<VoxelMesher::Output> deferred_collider_data;
+	UniquePtr<DeferredCollider> deferred_collider;
 
 	VoxelMeshBlockVLT(const Vector3i bpos, unsigned int size, unsigned int p_lod_index);
 	~VoxelMeshBlockVLT();
@@ -2,18 +2,19 @@
 #include "../terrain/fixed_lod/voxel_terrain.h"
 // #include "../util/string/format.h"
 #include "../constants/voxel_string_names.h"
+#include "../engine/voxel_engine.h"
 #include "../util/math/conv.h"
+#include "../util/memory/memory.h"
+#include "../util/profiling.h"
 
 namespace zylann::voxel {
 
 VoxelAStarGrid3DInternal::VoxelAStarGrid3DInternal() : _voxel_buffer(VoxelBuffer::ALLOCATOR_POOL) {}
 
 void VoxelAStarGrid3DInternal::init_cache() {
-	_grid_cache_size = math::ceildiv(get_region().size, Chunk::SIZE);
-	_grid_cache.resize(_grid_cache_size.x * _grid_cache_size.y * _grid_cache_size.z);
-	_grid_chunk_states.resize_no_init(_grid_cache.size());
-	_grid_chunk_states.fill(false);
-	_voxel_buffer.create(Vector3iUtil::create(Chunk::SIZE));
+	_pages.clear();
+	_last_page = nullptr;
+	_voxel_buffer.create(Vector3iUtil::create(Page::SIZE));
 
 	// const Box3i region = get_region();
 	// for (int y = region.pos.y; y < region.pos.y + region.size.y; ++y) {
@@ -33,78 +34,122 @@ void VoxelAStarGrid3DInternal::init_cache() {
 }
 
 bool VoxelAStarGrid3DInternal::is_solid(Vector3i pos) {
-	// TODO We could align the cache with the voxel chunk grid to avoid more expensive copies across chunk borders
-	const Vector3i gpos = pos - get_region().position;
-	const Vector3i cpos = gpos >> Chunk::SIZE_PO2;
-	const Vector3i rpos = gpos & Chunk::SIZE_MASK;
+	const Vector3i page_position = pos >> Page::SIZE_PO2;
 
-	const unsigned int chunk_loc = Vector3iUtil::get_zxy_index(cpos, _grid_cache_size);
-	Chunk chunk;
+	if (_last_page == nullptr || page_position != _last_page_position) {
+		auto it = _pages.find(page_position);
+		_last_page = it != _pages.end() ? &it->second : &load_page(page_position);
+		_last_page_position = page_position;
+	}
 
-	if (_grid_chunk_states.get(chunk_loc)) {
-		chunk = _grid_cache[chunk_loc];
+	return _last_page->get_solid_bit(pos & Page::SIZE_MASK);
+}
 
-	} else {
-		ZN_PROFILE_SCOPE_NAMED("Caching voxels");
-		ZN_ASSERT(data != nullptr);
-
-		const VoxelBuffer::ChannelId channel_index = VoxelBuffer::CHANNEL_TYPE;
-		const Vector3i copy_origin = (cpos << Chunk::SIZE_PO2) + get_region().position;
-		data->copy(copy_origin, _voxel_buffer, 1 << channel_index);
-
-		if (_voxel_buffer.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
-			if (_voxel_buffer.get_voxel(0, 0, 0, channel_index) != 0) {
-				chunk.solid_bits = 0xffffffffffffffff;
-			} else {
-				chunk.solid_bits = 0;
-			}
+const VoxelAStarGrid3DInternal::Page &VoxelAStarGrid3DInternal::load_page(Vector3i page_position) {
+	ZN_PROFILE_SCOPE_NAMED("Caching voxels");
+	ZN_ASSERT(data != nullptr);
 
-		} else {
-			chunk.solid_bits = 0;
-
-			switch (_voxel_buffer.get_channel_depth(channel_index)) {
-				case VoxelBuffer::DEPTH_8_BIT: {
-					Span<const uint8_t> values;
-					ZN_ASSERT(_voxel_buffer.get_channel_data(channel_index, values));
-					uint64_t i = 0;
-					// Assuming ZXY loop order
-					for (const uint8_t v : values) {
-						chunk.solid_bits |= (v == 0 ? uint64_t(0) : (uint64_t(1) << i));
-						++i;
-					}
-				} break;
-
-				case VoxelBuffer::DEPTH_16_BIT: {
-					Span<const uint16_t> values;
-					ZN_ASSERT(_voxel_buffer.get_channel_data(channel_index, values));
-					uint64_t i = 0;
-					for (const uint16_t v : values) {
-						chunk.solid_bits |= (v == 0 ? uint64_t(0) : (uint64_t(1) << i));
-						++i;
-					}
-				} break;
-
-				default:
-					ZN_PRINT_ERROR("Unhandled channel depth");
-					break;
-			}
+	Page &page = _pages[page_position];
 
-			_grid_chunk_states.set(chunk_loc);
-		}
+	const VoxelBuffer::ChannelId channel_index = VoxelBuffer::CHANNEL_TYPE;
+	data->copy(page_position << Page::SIZE_PO2, _voxel_buffer, 1 << channel_index);
+
+	if (_voxel_buffer.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+		const uint64_t bits = _voxel_buffer.get_voxel(0, 0, 0, channel_index) != 0 ? 0xffffffffffffffff : 0;
+		fill(page.solid_bits, bits);
 
-		_grid_cache[chunk_loc] = chunk;
+	} else {
+		fill(page.solid_bits, uint64_t(0));
+
+		// Assuming ZXY loop order
+		switch (_voxel_buffer.get_channel_depth(channel_index)) {
+			case VoxelBuffer::DEPTH_8_BIT: {
+				Span<const uint8_t> values;
+				ZN_ASSERT(_voxel_buffer.get_channel_data(channel_index, values));
+				for (unsigned int i = 0; i < values.size(); ++i) {
+					page.solid_bits[i >> 6] |= (values[i] == 0 ? uint64_t(0) : (uint64_t(1) << (i & 63)));
+				}
+			} break;
+
+			case VoxelBuffer::DEPTH_16_BIT: {
+				Span<const uint16_t> values;
+				ZN_ASSERT(_voxel_buffer.get_channel_data(channel_index, values));
+				for (unsigned int i = 0; i < values.size(); ++i) {
+					page.solid_bits[i >> 6] |= (values[i] == 0 ? uint64_t(0) : (uint64_t(1) << (i & 63)));
+				}
+			} break;
+
+			default:
+				ZN_PRINT_ERROR("Unhandled channel depth");
+				break;
+		}
 	}
 
-	return chunk.get_solid_bit(rpos);
+	return page;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+TypedArray<Vector3i> to_typed_array(Span<const Vector3i> items) {
+	TypedArray<Vector3i> typed_array;
+	typed_array.resize(items.size());
+	for (unsigned int i = 0; i < items.size(); ++i) {
+		typed_array[i] = items[i];
+	}
+	return typed_array;
+}
+} // namespace
+
 void VoxelAStarGrid3D::set_terrain(VoxelTerrain *node) {
 	ZN_ASSERT_RETURN(node != nullptr);
 	// Can't modify the pathfinder while it is running in a different thread
 	ZN_ASSERT_RETURN(_is_running_async == false);
 	_path_finder.data = node->get_storage_shared();
+	reset_hierarchy_cache();
+}
+
+void VoxelAStarGrid3D::set_hierarchical_enabled(bool enabled) {
+	ZN_ASSERT_RETURN(_is_running_async == false);
+	if (enabled == _hierarchical_enabled) {
+		return;
+	}
+	_hierarchical_enabled = enabled;
+	// Modifications are not tracked while disabled
+	reset_hierarchy_cache();
+}
+
+bool VoxelAStarGrid3D::is_hierarchical_enabled() const {
+	return _hierarchical_enabled;
+}
+
+void VoxelAStarGrid3D::clear_cache() {
+	ZN_ASSERT_RETURN(_is_running_async == false);
+	reset_hierarchy_cache();
+}
+
+void VoxelAStarGrid3D::reset_hierarchy_cache() {
+	_hierarchy.clear();
+	if (_path_finder.data != nullptr) {
+		// Clusters match data blocks
+		_hierarchy.set_cluster_size_po2(_path_finder.data->get_block_size_po2());
+		_data_modification_count = _path_finder.data->get_modification_count();
+	}
+}
+
+void VoxelAStarGrid3D::update_hierarchy_cache() {
+	if (!_hierarchical_enabled || _path_finder.data == nullptr) {
+		return;
+	}
+	ZN_PROFILE_SCOPE();
+	StdVector<Box3i> modified_areas;
+	if (_path_finder.data->get_modified_areas_since(_data_modification_count, modified_areas)) {
+		for (const Box3i &box : modified_areas) {
+			_hierarchy.invalidate_area(box, _path_finder);
+		}
+	} else {
+		_hierarchy.clear();
+	}
 }
 
 TypedArray<Vector3i> VoxelAStarGrid3D::find_path(Vector3i from_position, Vector3i to_position) {
@@ -113,7 +158,10 @@ TypedArray<Vector3i> VoxelAStarGrid3D::find_path(Vector3i from_position, Vector3
 #ifdef DEBUG_ENABLED
 	check_params(from_position, to_position);
 #endif
-	return find_path_internal(from_position, to_position);
+	update_hierarchy_cache();
+	StdVector<Vector3i> path;
+	find_path_internal(_path_finder, from_position, to_position, path);
+	return to_typed_array(to_span(path));
 }
 
 #ifdef DEBUG_ENABLED
@@ -130,32 +178,34 @@ void VoxelAStarGrid3D::check_params(Vector3i from_position, Vector3i to_position
 }
 #endif
 
-namespace {
-TypedArray<Vector3i> to_typed_array(Span<const Vector3i> items) {
-	TypedArray<Vector3i> typed_array;
-	typed_array.resize(items.size());
-	for (unsigned int i = 0; i < items.size(); ++i) {
-		typed_array[i] = items[i];
+void VoxelAStarGrid3D::find_path_internal(
+		VoxelAStarGrid3DInternal &path_finder,
+		Vector3i from_position,
+		Vector3i to_position,
+		StdVector<Vector3i> &out_path
+) {
+	path_finder.init_cache();
+
+	if (_hierarchical_enabled) {
+		_hierarchy.find_path(path_finder, from_position, to_position, out_path);
+		return;
 	}
-	return typed_array;
-}
-} // namespace
 
-TypedArray<Vector3i> VoxelAStarGrid3D::find_path_internal(Vector3i from_position, Vector3i to_position) {
-	_path_finder.start(from_position, to_position);
-	_path_finder.init_cache();
+	path_finder.start(from_position, to_position);
 
-	while (_path_finder.is_running()) {
-		_path_finder.step();
+	while (path_finder.is_running()) {
+		path_finder.step();
 	}
 
-	Span<const Vector3i> path = _path_finder.get_path();
-	return to_typed_array(path);
+	Span<const Vector3i> path = path_finder.get_path();
+	out_path.clear();
+	out_path.insert(out_path.end(), path.data(), path.data() + path.size());
 }
 
 void VoxelAStarGrid3D::set_region(Box3i region) {
 	ZN_ASSERT_RETURN(_is_running_async == false);
 	_path_finder.set_region(region);
+	reset_hierarchy_cache();
 }
 
 Box3i VoxelAStarGrid3D::get_region() {
@@ -169,6 +219,8 @@ void VoxelAStarGrid3D::find_path_async(Vector3i from_position, Vector3i to_posit
 	check_params(from_position, to_position);
 #endif
 
+	update_hierarchy_cache();
+
 	_is_running_async = true;
 
 	class Task : public IThreadedTask {
@@ -179,8 +231,11 @@ void VoxelAStarGrid3D::find_path_async(Vector3i from_position, Vector3i to_posit
 
 		void run(ThreadedTaskContext &ctx) override {
 			ZN_ASSERT(astar.is_valid());
-			TypedArray<Vector3i> path = astar->find_path_internal(from_position, to_position);
-			astar->call_deferred(VoxelStringNames::get_singleton()._on_async_search_completed, path);
+			StdVector<Vector3i> path;
+			astar->find_path_internal(astar->_path_finder, from_position, to_position, path);
+			astar->call_deferred(
+					VoxelStringNames::get_singleton()._on_async_search_completed, to_typed_array(to_span(path))
+			);
 		}
 
 		const char *get_debug_name() const override {
@@ -196,6 +251,100 @@ void VoxelAStarGrid3D::find_path_async(Vector3i from_position, Vector3i to_posit
 	VoxelEngine::get_singleton().push_async_task(task);
 }
 
+void VoxelAStarGrid3D::find_paths_async(
+		const TypedArray<Vector3i> &from_positions,
+		const TypedArray<Vector3i> &to_positions
+) {
+	ZN_ASSERT_RETURN(_is_running_async == false);
+	ZN_ASSERT_RETURN_MSG(
+			from_positions.size() == to_positions.size(), "Expected as many source positions as destinations"
+	);
+
+	update_hierarchy_cache();
+
+	// Queries are claimed from a shared counter by every task, and the last task to finish emits the results
+	struct Batch {
+		StdVector<Vector3i> from_positions;
+		StdVector<Vector3i> to_positions;
+		StdVector<StdVector<Vector3i>> paths;
+		std::atomic_uint32_t next_index = { 0 };
+		std::atomic_uint32_t remaining_task_count = { 0 };
+	};
+
+	std::shared_ptr<Batch> batch = make_shared_instance<Batch>();
+	const unsigned int query_count = from_positions.size();
+	batch->from_positions.resize(query_count);
+	batch->to_positions.resize(query_count);
+	batch->paths.resize(query_count);
+	for (unsigned int i = 0; i < query_count; ++i) {
+		batch->from_positions[i] = from_positions[i];
+		batch->to_positions[i] = to_positions[i];
+#ifdef DEBUG_ENABLED
+		check_params(batch->from_positions[i], batch->to_positions[i]);
+#endif
+	}
+
+	class Task : public IThreadedTask {
+	public:
+		Ref<VoxelAStarGrid3D> astar;
+		std::shared_ptr<Batch> batch;
+
+		void run(ThreadedTaskContext &ctx) override {
+			ZN_PROFILE_SCOPE();
+			ZN_ASSERT(astar.is_valid());
+
+			// Each task needs its own search state. The hierarchy is shared.
+			UniquePtr<VoxelAStarGrid3DInternal> path_finder;
+
+			while (true) {
+				const uint32_t i = batch->next_index.fetch_add(1);
+				if (i >= batch->paths.size()) {
+					break;
+				}
+				if (path_finder == nullptr) {
+					const VoxelAStarGrid3DInternal &src = astar->_path_finder;
+					path_finder = make_unique_instance<VoxelAStarGrid3DInternal>();
+					path_finder->data = src.data;
+					path_finder->set_region(src.get_region());
+					path_finder->set_agent_size(src.get_agent_size());
+					path_finder->set_max_fall_height(src.get_max_fall_height());
+					path_finder->set_max_path_cost(src.get_max_path_cost());
+				}
+				astar->find_path_internal(
+						*path_finder, batch->from_positions[i], batch->to_positions[i], batch->paths[i]
+				);
+			}
+
+			if (batch->remaining_task_count.fetch_sub(1) == 1) {
+				Array paths;
+				paths.resize(batch->paths.size());
+				for (unsigned int i = 0; i < batch->paths.size(); ++i) {
+					paths[i] = to_typed_array(to_span(batch->paths[i]));
+				}
+				astar->call_deferred(VoxelStringNames::get_singleton()._on_async_batch_completed, paths);
+			}
+		}
+
+		const char *get_debug_name() const override {
+			return "VoxelAStarGrid3DBatchTask";
+		}
+	};
+
+	_is_running_async = true;
+
+	// Tasks that start after all queries were claimed do nothing
+	FixedArray<IThreadedTask *, ThreadedTaskRunner::MAX_THREADS> tasks;
+	const unsigned int task_count = math::clamp(query_count, 1u, static_cast<unsigned int>(tasks.size()));
+	batch->remaining_task_count = task_count;
+	for (unsigned int i = 0; i < task_count; ++i) {
+		Task *task = ZN_NEW(Task);
+		task->astar = Ref<VoxelAStarGrid3D>(this);
+		task->batch = batch;
+		tasks[i] = task;
+	}
+	VoxelEngine::get_singleton().push_async_tasks(to_span(tasks, task_count));
+}
+
 bool VoxelAStarGrid3D::is_running_async() const {
 	return _is_running_async;
 }
@@ -222,15 +371,30 @@ void VoxelAStarGrid3D::_b_on_async_search_completed(TypedArray<Vector3i> path) {
 	emit_signal(VoxelStringNames::get_singleton().async_search_completed, path);
 }
 
+void VoxelAStarGrid3D::_b_on_async_batch_completed(Array paths) {
+	_is_running_async = false;
+	emit_signal(VoxelStringNames::get_singleton().async_batch_completed, paths);
+}
+
 void VoxelAStarGrid3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_terrain", "terrain"), &VoxelAStarGrid3D::set_terrain);
 
 	ClassDB::bind_method(D_METHOD("set_region", "box"), &VoxelAStarGrid3D::_b_set_region);
 	ClassDB::bind_method(D_METHOD("get_region"), &VoxelAStarGrid3D::_b_get_region);
 
+	ClassDB::bind_method(
+			D_METHOD("set_hierarchical_enabled", "enabled"), &VoxelAStarGrid3D::set_hierarchical_enabled
+	);
+	ClassDB::bind_method(D_METHOD("is_hierarchical_enabled"), &VoxelAStarGrid3D::is_hierarchical_enabled);
+
+	ClassDB::bind_method(D_METHOD("clear_cache"), &VoxelAStarGrid3D::clear_cache);
+
 	ClassDB::bind_method(D_METHOD("find_path", "from_position", "to_position"), &VoxelAStarGrid3D::find_path);
 	ClassDB::bind_method(
 			D_METHOD("find_path_async", "from_position", "to_position"), &VoxelAStarGrid3D::find_path_async);
+	ClassDB::bind_method(
+			D_METHOD("find_paths_async", "from_positions", "to_positions"), &VoxelAStarGrid3D::find_paths_async
+	);
 	ClassDB::bind_method(D_METHOD("is_running_async"), &VoxelAStarGrid3D::is_running_async);
 
 	ClassDB::bind_method(D_METHOD("debug_get_visited_positions"), &VoxelAStarGrid3D::debug_get_visited_positions);
@@ -238,9 +402,17 @@ void VoxelAStarGrid3D::_bind_methods() {
 	// Internal
 	ClassDB::bind_method(
 			D_METHOD("_on_async_search_completed", "path"), &VoxelAStarGrid3D::_b_on_async_search_completed);
+	ClassDB::bind_method(
+			D_METHOD("_on_async_batch_completed", "paths"), &VoxelAStarGrid3D::_b_on_async_batch_completed
+	);
+
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "hierarchical_enabled"), "set_hierarchical_enabled", "is_hierarchical_enabled"
+	);
 
 	ADD_SIGNAL(MethodInfo(
 			"async_search_completed", PropertyInfo(Variant::ARRAY, "path", PROPERTY_HINT_ARRAY_TYPE, "Vector3i")));
+	ADD_SIGNAL(MethodInfo("async_batch_completed", PropertyInfo(Variant::ARRAY, "paths")));
 }
 
 } // namespace zylann::voxel
@@ -4,8 +4,11 @@
 #include "../storage/voxel_buffer.h"
 #include "../storage/voxel_data.h"
 #include "../util/a_star_grid_3d.h"
-#include "../util/containers/dynamic_bitset.h"
+#include "../util/a_star_grid_3d_hierarchical.h"
+#include "../util/containers/fixed_array.h"
+#include "../util/containers/std_unordered_map.h"
 #include "../util/containers/std_vector.h"
+#include "../util/godot/core/array.h"
 #include <atomic>
 
 namespace zylann::voxel {
@@ -21,36 +24,40 @@ public:
 	// any time.
 	std::shared_ptr<VoxelData> data;
 
+	// Clears cached voxels, so the next searches see the latest changes
 	void init_cache();
 
 protected:
 	bool is_solid(Vector3i pos) override;
 
 private:
-	// We store a cache of solid bits for the whole pathfindable region.
-	// To minimize multithreaded access to the main voxel data, we only load chunks of bits as they are needed.
+	// We store a cache of solid bits for the pathfindable region.
+	// To minimize multithreaded access to the main voxel data, we only load pages of bits as they are needed. They are
+	// stored sparsely, because the region can be very large when searching long paths.
 
-	struct Chunk {
-		static const int SIZE_PO2 = 2;
+	struct Page {
+		// Aligned with the default size of data blocks, so loading a page usually copies from a single block
+		static const int SIZE_PO2 = 4;
 		static const int SIZE = 1 << SIZE_PO2;
 		static const int SIZE_MASK = SIZE - 1;
 
-		// 4x4x4 bits in ZXY order
-		uint64_t solid_bits = 0;
+		// 16x16x16 bits in ZXY order
+		FixedArray<uint64_t, (SIZE * SIZE * SIZE) / 64> solid_bits;
 
 		inline bool get_solid_bit(Vector3i rel) const {
-			const uint64_t i = Vector3iUtil::get_zxy_index(rel, Vector3i(SIZE, SIZE, SIZE));
-			// const unsigned int i = rel.y + (rel.x << 2) + (rel.z << 4);
-			return ((solid_bits >> i) & uint64_t(1)) != 0;
+			const unsigned int i = Vector3iUtil::get_zxy_index(rel, Vector3i(SIZE, SIZE, SIZE));
+			return ((solid_bits[i >> 6] >> (i & 63)) & uint64_t(1)) != 0;
 		}
 	};
 
-	// Cached 3D bitmap
-	StdVector<Chunk> _grid_cache;
-	Vector3i _grid_cache_size;
+	const Page &load_page(Vector3i page_position);
 
-	// Tracks which chunks are loaded
-	DynamicBitset _grid_chunk_states;
+	// Cached pages, in page coordinates
+	StdUnorderedMap<Vector3i, Page> _pages;
+
+	// Last accessed page, since consecutive accesses are usually close to each other
+	const Page *_last_page = nullptr;
+	Vector3i _last_page_position;
 
 	// Temporary buffer used to read voxels from the main voxel storage
 	VoxelBuffer _voxel_buffer;
@@ -61,22 +68,39 @@ class VoxelAStarGrid3D : public RefCounted {
 	GDCLASS(VoxelAStarGrid3D, RefCounted)
 public:
 	// Bare bones at the moment. May need more configurations and customization.
-	// Also, it does not cache data between queries.
 
 	void set_terrain(VoxelTerrain *node);
 
 	void set_region(Box3i region);
 	Box3i get_region();
 
+	// When enabled, paths are searched over a cached graph of connections between data blocks, and then refined
+	// within each block. Paths can be slightly longer, but long searches become much cheaper.
+	void set_hierarchical_enabled(bool enabled);
+	bool is_hierarchical_enabled() const;
+
+	// Clears information cached about the terrain. Edits and blocks getting loaded or unloaded are detected
+	// automatically, so this should only be needed if the terrain changes in other ways.
+	void clear_cache();
+
 	TypedArray<Vector3i> find_path(Vector3i from_position, Vector3i to_position);
 
 	void find_path_async(Vector3i from_position, Vector3i to_position);
+	// Searches many paths at once, spread over multiple threads.
+	void find_paths_async(const TypedArray<Vector3i> &from_positions, const TypedArray<Vector3i> &to_positions);
 	bool is_running_async() const;
 
 	TypedArray<Vector3i> debug_get_visited_positions() const;
 
 private:
-	TypedArray<Vector3i> find_path_internal(Vector3i from_position, Vector3i to_position);
+	void find_path_internal(
+			VoxelAStarGrid3DInternal &path_finder,
+			Vector3i from_position,
+			Vector3i to_position,
+			StdVector<Vector3i> &out_path
+	);
+	void update_hierarchy_cache();
+	void reset_hierarchy_cache();
 #ifdef DEBUG_ENABLED
 	void check_params(Vector3i from_position, Vector3i to_position);
 #endif
@@ -84,11 +108,18 @@ private:
 	void _b_set_region(AABB aabb);
 	AABB _b_get_region();
 	void _b_on_async_search_completed(TypedArray<Vector3i> path);
+	void _b_on_async_batch_completed(Array paths);
 
 	static void _bind_methods();
 
 	VoxelAStarGrid3DInternal _path_finder;
 	std::atomic_bool _is_running_async = { false };
+
+	bool _hierarchical_enabled = false;
+	// Shared by all searches, including those running in threads
+	HierarchicalAStarGrid3D _hierarchy;
+	// Modifications of the terrain already taken into account by the hierarchy cache
+	uint64_t _data_modification_count = 0;
 };
 
 } // namespace zylann::voxel
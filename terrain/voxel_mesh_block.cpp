@@ -2,6 +2,7 @@
 #include "../constants/voxel_string_names.h"
 #include "../util/godot/classes/collision_shape_3d.h"
 #include "../util/godot/classes/concave_polygon_shape_3d.h"
+#include "../util/godot/classes/mesh.h"
 #include "../util/godot/classes/node_3d.h"
 #include "../util/macros.h"
 #include "../util/profiling.h"
@@ -210,41 +211,131 @@ bool VoxelMeshBlock::is_collision_enabled() const {
 	return _collision_enabled;
 }
 
+namespace {
+
+// Collision vertices are snapped to a grid this fine, in voxels
+const float COLLISION_VERTEX_QUANTIZATION = 1024.f;
+
+// Appends indexed triangles as a list of faces. Vertices are quantized so nearly-identical ones become the same, and
+// triangles that become degenerate are skipped. Meshers like Transvoxel can produce lots of them, which are useless
+// for collision and make physics engines slower to build and query shapes.
+template <typename TPosition>
+void append_collision_faces(
+		Span<const TPosition> positions,
+		Span<const int> indices,
+		StdVector<Vector3f> &faces,
+		StdVector<Vector3i> &quantized_positions
+) {
+	ERR_FAIL_COND(indices.size() % 3 != 0);
+
+	quantized_positions.resize(positions.size());
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		const TPosition p = positions[i];
+		quantized_positions[i] = Vector3i( //
+				int(Math::round(p.x * COLLISION_VERTEX_QUANTIZATION)),
+				int(Math::round(p.y * COLLISION_VERTEX_QUANTIZATION)),
+				int(Math::round(p.z * COLLISION_VERTEX_QUANTIZATION))
+		);
+	}
+
+	const float inv_quantization = 1.f / COLLISION_VERTEX_QUANTIZATION;
+
+	for (unsigned int ii = 0; ii < indices.size(); ii += 3) {
+		const int i0 = indices[ii];
+		const int i1 = indices[ii + 1];
+		const int i2 = indices[ii + 2];
+#ifdef DEBUG_ENABLED
+		ERR_FAIL_COND(i0 < 0 || i1 < 0 || i2 < 0);
+		ERR_FAIL_COND(i0 >= int(positions.size()) || i1 >= int(positions.size()) || i2 >= int(positions.size()));
+#endif
+		const Vector3i p0 = quantized_positions[i0];
+		const Vector3i p1 = quantized_positions[i1];
+		const Vector3i p2 = quantized_positions[i2];
+
+		// Collinear or collapsed after snapping (exact test with 64-bit integers)
+		const int64_t ax = p1.x - p0.x;
+		const int64_t ay = p1.y - p0.y;
+		const int64_t az = p1.z - p0.z;
+		const int64_t bx = p2.x - p0.x;
+		const int64_t by = p2.y - p0.y;
+		const int64_t bz = p2.z - p0.z;
+		if (ay * bz - az * by == 0 && az * bx - ax * bz == 0 && ax * by - ay * bx == 0) {
+			continue;
+		}
+
+		faces.push_back(Vector3f(p0.x, p0.y, p0.z) * inv_quantization);
+		faces.push_back(Vector3f(p1.x, p1.y, p1.z) * inv_quantization);
+		faces.push_back(Vector3f(p2.x, p2.y, p2.z) * inv_quantization);
+	}
+}
+
+template <typename TPosition>
+void append_collision_faces(
+		Span<const TPosition> positions,
+		Span<const int> indices,
+		StdVector<Vector3f> &faces
+) {
+	static thread_local StdVector<Vector3i> tls_quantized_positions;
+	append_collision_faces(positions, indices, faces, tls_quantized_positions);
+}
+
+void append_collision_faces(const Array &surface_arrays, unsigned int index_count, StdVector<Vector3f> &faces) {
+	if (surface_arrays.size() == 0) {
+		// That surface is empty
+		return;
+	}
+	// If the surface is not empty then it must have an expected amount of data arrays
+	ERR_FAIL_COND(surface_arrays.size() != Mesh::ARRAY_MAX);
+
+	const PackedVector3Array positions = surface_arrays[Mesh::ARRAY_VERTEX];
+	const PackedInt32Array indices = surface_arrays[Mesh::ARRAY_INDEX];
+	ERR_FAIL_COND(index_count > static_cast<unsigned int>(indices.size()));
+
+	append_collision_faces(
+			Span<const Vector3>(positions.ptr(), positions.size()), Span<const int>(indices.ptr(), index_count), faces
+	);
+}
+
+} // namespace
+
 Ref<ConcavePolygonShape3D> make_collision_shape_from_mesher_output(
 		const VoxelMesher::Output &mesher_output, const VoxelMesher &mesher) {
-	using namespace zylann::godot;
+	ZN_PROFILE_SCOPE();
 
-	Ref<ConcavePolygonShape3D> shape;
+	static thread_local StdVector<Vector3f> tls_faces;
+	StdVector<Vector3f> &faces = tls_faces;
+	faces.clear();
 
 	if (mesher.is_generating_collision_surface()) {
 		if (mesher_output.collision_surface.submesh_vertex_end != -1) {
 			// Use a sub-region of the render mesh
 			if (mesher_output.surfaces.size() > 0) {
-				shape = create_concave_polygon_shape(
-						mesher_output.surfaces[0].arrays, mesher_output.collision_surface.submesh_index_end);
+				append_collision_faces(
+						mesher_output.surfaces[0].arrays, mesher_output.collision_surface.submesh_index_end, faces
+				);
 			}
 
 		} else {
 			// Use specialized collision mesh
-			shape = create_concave_polygon_shape(to_span(mesher_output.collision_surface.positions),
-					to_span(mesher_output.collision_surface.indices));
+			append_collision_faces(
+					to_span(mesher_output.collision_surface.positions),
+					to_span(mesher_output.collision_surface.indices),
+					faces
+			);
 		}
 
 	} else {
 		// Use render mesh
-		static thread_local StdVector<Array> tls_render_surfaces;
-		ZN_ASSERT(tls_render_surfaces.size() == 0);
-
-		for (unsigned int i = 0; i < mesher_output.surfaces.size(); ++i) {
-			tls_render_surfaces.push_back(mesher_output.surfaces[i].arrays);
+		for (const VoxelMesher::Output::Surface &surface : mesher_output.surfaces) {
+			const Array &arrays = surface.arrays;
+			if (arrays.size() != 0) {
+				const PackedInt32Array indices = arrays[Mesh::ARRAY_INDEX];
+				append_collision_faces(arrays, indices.size(), faces);
+			}
 		}
-
-		shape = create_concave_polygon_shape(to_span(tls_render_surfaces));
-
-		tls_render_surfaces.clear();
 	}
 
-	return shape;
+	return zylann::godot::create_concave_polygon_shape_from_faces(to_span(faces));
 }
 
 } // namespace zylann::voxel
@@ -2,8 +2,10 @@
 #include "../util/profiling.h"
 #include "testing.h"
 
+#include "util/test_a_star_grid_3d.h"
 #include "util/test_box3i.h"
 #include "util/test_container_funcs.h"
+#include "util/test_dynamic_aabb_tree.h"
 #include "util/test_expression_parser.h"
 #include "util/test_flat_map.h"
 #include "util/test_island_finder.h"
@@ -17,16 +19,26 @@
 #include "voxel/test_curve_range.h"
 #include "voxel/test_detail_rendering_gpu.h"
 #include "voxel/test_edition_funcs.h"
+#include "voxel/test_generator_output_cache.h"
+#include "voxel/test_mesh_output_cache.h"
 #include "voxel/test_mesh_sdf.h"
 #include "voxel/test_octree.h"
 #include "voxel/test_region_file.h"
 #include "voxel/test_storage_funcs.h"
 #include "voxel/test_stream_sqlite.h"
+#include "voxel/test_voxel_a_star_grid_3d.h"
+#include "voxel/test_voxel_box_mover.h"
 #include "voxel/test_voxel_buffer.h"
 #include "voxel/test_voxel_data_map.h"
+#include "voxel/test_voxel_data_raycaster.h"
+#include "voxel/test_voxel_generator_multipass_cb.h"
 #include "voxel/test_voxel_graph.h"
 #include "voxel/test_voxel_instancer.h"
+#include "voxel/test_voxel_memory_pool.h"
+#include "voxel/test_voxel_mesher_blocky.h"
 #include "voxel/test_voxel_mesher_cubes.h"
+#include "voxel/test_voxel_mesher_transvoxel.h"
+#include "voxel/test_voxel_modifier_stack.h"
 
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
 #include "fast_noise_2/test_fast_noise_2.h"
@@ -47,6 +59,7 @@ void run_voxel_tests() {
 	using namespace zylann::tests;
 
 	VOXEL_TEST(test_wrap);
+	VOXEL_TEST(test_simd_kernels);
 	VOXEL_TEST(test_int32_to_string_base10);
 	VOXEL_TEST(test_string_base10_to_int32);
 	VOXEL_TEST(test_voxel_buffer_paste_masked);
@@ -56,6 +69,13 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_voxel_data_map_paste_fill);
 	VOXEL_TEST(test_voxel_data_map_paste_mask);
 	VOXEL_TEST(test_voxel_data_map_copy);
+	VOXEL_TEST(test_voxel_data_map_block_handles);
+	VOXEL_TEST(test_voxel_data_map_remove_most_blocks);
+	VOXEL_TEST(test_voxel_data_map_benchmark);
+	VOXEL_TEST(test_voxel_raycast_hierarchical);
+	VOXEL_TEST(test_voxel_data_raycaster);
+	VOXEL_TEST(test_voxel_box_mover_get_motions);
+	VOXEL_TEST(test_voxel_a_star_grid_3d_block_loading);
 	VOXEL_TEST(test_encode_weights_packed_u16);
 	VOXEL_TEST(test_copy_3d_region_zxy);
 	VOXEL_TEST(test_voxel_graph_invalid_connection);
@@ -88,7 +108,12 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_voxel_graph_image);
 	VOXEL_TEST(test_voxel_graph_many_weight_outputs);
 	VOXEL_TEST(test_voxel_graph_many_subdivisions);
+	VOXEL_TEST(test_voxel_graph_generate_block_benchmark);
+	VOXEL_TEST(test_generator_output_cache);
+	VOXEL_TEST(test_generator_output_cache_subresource_change);
 	VOXEL_TEST(test_island_finder);
+	VOXEL_TEST(test_a_star_grid_3d_hierarchical);
+	VOXEL_TEST(test_a_star_grid_3d_hierarchical_invalidation);
 	VOXEL_TEST(test_unordered_remove_if);
 	VOXEL_TEST(test_instance_data_serialization);
 	VOXEL_TEST(test_transform_3d_array_zxy);
@@ -97,9 +122,12 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_get_curve_monotonic_sections);
 	VOXEL_TEST(test_voxel_buffer_create);
 	VOXEL_TEST(test_block_serializer);
+	VOXEL_TEST(test_block_serializer_compression_dictionary);
 	VOXEL_TEST(test_block_serializer_stream_peer);
 	VOXEL_TEST(test_region_file);
 	VOXEL_TEST(test_voxel_stream_region_files);
+	VOXEL_TEST(test_voxel_stream_region_files_memory_mapped);
+	VOXEL_TEST(test_voxel_stream_region_files_async_reads);
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
 	VOXEL_TEST(test_fast_noise_2_basic);
 	VOXEL_TEST(test_fast_noise_2_empty_encoded_node_tree);
@@ -109,23 +137,44 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_expression_parser);
 	VOXEL_TEST(test_voxel_buffer_metadata);
 	VOXEL_TEST(test_voxel_buffer_metadata_gd);
+	VOXEL_TEST(test_voxel_buffer_palette);
+	VOXEL_TEST(test_voxel_buffer_palette_memory_usage);
+	VOXEL_TEST(test_voxel_memory_pool_thread_caches);
+	VOXEL_TEST(test_voxel_memory_pool_arenas);
 	VOXEL_TEST(test_voxel_mesher_cubes);
+	VOXEL_TEST(test_voxel_mesher_blocky_greedy);
+	VOXEL_TEST(test_voxel_mesher_blocky_box_collision);
+	VOXEL_TEST(test_voxel_mesher_transvoxel_incremental_build);
+	VOXEL_TEST(test_voxel_mesher_transvoxel_compact_vertex_format);
+	VOXEL_TEST(test_mesh_output_cache);
+	VOXEL_TEST(test_mesh_output_cache_key_generator_change);
 	VOXEL_TEST(test_threaded_task_runner_misc);
+	VOXEL_TEST(test_threaded_task_runner_thread_count_reduction);
 	VOXEL_TEST(test_threaded_task_runner_debug_names);
+	VOXEL_TEST(test_threaded_task_runner_contention);
 	VOXEL_TEST(test_task_priority_values);
 	VOXEL_TEST(test_voxel_mesh_sdf_issue463);
+	VOXEL_TEST(test_mesh_sdf_bvh);
+	VOXEL_TEST(test_voxel_modifier_stack_index);
+	VOXEL_TEST(test_voxel_modifier_stack_benchmark);
+	VOXEL_TEST(test_voxel_generator_multipass_cb_benchmark);
 	VOXEL_TEST(test_normalmap_render_gpu);
 	VOXEL_TEST(test_slot_map);
+	VOXEL_TEST(test_dynamic_aabb_tree);
 	VOXEL_TEST(test_box_blur);
 	VOXEL_TEST(test_threaded_task_postponing);
 	VOXEL_TEST(test_spatial_lock_misc);
 	VOXEL_TEST(test_spatial_lock_spam);
+	VOXEL_TEST(test_spatial_lock_benchmark);
 	VOXEL_TEST(test_spatial_lock_dependent_map_chunks);
 	VOXEL_TEST(test_discord_soakil_copypaste);
 	VOXEL_TEST(test_voxel_stream_sqlite_key_string_csd_encoding);
 	VOXEL_TEST(test_voxel_stream_sqlite_key_blob80_encoding);
 	VOXEL_TEST(test_voxel_stream_sqlite_basic);
 	VOXEL_TEST(test_voxel_stream_sqlite_coordinate_format);
+	VOXEL_TEST(test_voxel_stream_sqlite_compression_dictionary);
+	VOXEL_TEST(test_voxel_stream_sqlite_compression_dictionary_retrain);
+	VOXEL_TEST(test_voxel_stream_sqlite_load_throughput);
 
 	print_line("------------ Voxel tests end -------------");
 }
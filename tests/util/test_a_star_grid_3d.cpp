@@ -0,0 +1,128 @@
+#include "test_a_star_grid_3d.h"
+#include "../../util/a_star_grid_3d.h"
+#include "../../util/a_star_grid_3d_hierarchical.h"
+#include "../../util/containers/std_vector.h"
+#include "../testing.h"
+
+namespace zylann::tests {
+
+namespace {
+
+// Flat ground with rows of walls. Walls have a gap whose location can be changed.
+class TestGrid : public AStarGrid3D {
+public:
+	int wall_gap_z = 5;
+
+	TestGrid() {
+		set_region(Box3i(Vector3i(0, 0, 0), Vector3i(100, 8, 100)));
+		set_agent_size(Vector3f(0.8f, 1.8f, 0.8f));
+		set_max_fall_height(3);
+	}
+
+protected:
+	bool is_solid(Vector3i pos) override {
+		if (pos.y <= 0) {
+			return true;
+		}
+		if (pos.x % 20 == 10 && pos.y < 5 && Math::abs(pos.z - wall_gap_z) > 1) {
+			return true;
+		}
+		// Some obstacles
+		return ((pos.x * 7 + pos.z * 13) % 17) == 0 && pos.y < 3;
+	}
+};
+
+bool is_path_valid(TestGrid &grid, Vector3i from_position, Vector3i to_position, const StdVector<Vector3i> &path) {
+	if (path.size() == 0 || path[0] != from_position) {
+		return false;
+	}
+	StdVector<Vector3i> neighbors;
+	for (unsigned int i = 0; i < path.size(); ++i) {
+		const Vector3i next = i + 1 < path.size() ? path[i + 1] : to_position;
+		neighbors.clear();
+		grid.get_neighbor_positions(path[i], neighbors);
+		bool found = false;
+		for (const Vector3i npos : neighbors) {
+			if (npos == next) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool find_path_regular(TestGrid &grid, Vector3i from_position, Vector3i to_position) {
+	grid.start(from_position, to_position);
+	while (grid.is_running()) {
+		grid.step();
+	}
+	return grid.get_path_cost() >= 0.f;
+}
+
+} // namespace
+
+void test_a_star_grid_3d_hierarchical() {
+	TestGrid grid;
+	HierarchicalAStarGrid3D hierarchy;
+	StdVector<Vector3i> path;
+
+	uint32_t seed = 131183;
+	auto next_coordinate = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return static_cast<int>((seed >> 8) % 100);
+	};
+
+	int query_count = 0;
+	while (query_count < 20) {
+		const Vector3i from_position(next_coordinate(), 1, next_coordinate());
+		const Vector3i to_position(next_coordinate(), 1, next_coordinate());
+		if (!grid.is_valid_position(from_position) || !grid.is_valid_position(to_position)) {
+			continue;
+		}
+		++query_count;
+
+		const bool found = hierarchy.find_path(grid, from_position, to_position, path);
+		// Both searches must agree on whether a path exists
+		ZN_TEST_ASSERT(found == find_path_regular(grid, from_position, to_position));
+		if (found) {
+			ZN_TEST_ASSERT(is_path_valid(grid, from_position, to_position, path));
+		}
+	}
+
+	ZN_TEST_ASSERT(hierarchy.get_cached_cluster_count() > 0);
+}
+
+void test_a_star_grid_3d_hierarchical_invalidation() {
+	TestGrid grid;
+	HierarchicalAStarGrid3D hierarchy;
+	StdVector<Vector3i> path;
+
+	const Vector3i from_position(2, 1, 50);
+	const Vector3i to_position(18, 1, 50);
+
+	// Cache clusters with a gap near the path
+	grid.wall_gap_z = 50;
+	ZN_TEST_ASSERT(hierarchy.find_path(grid, from_position, to_position, path));
+	ZN_TEST_ASSERT(is_path_valid(grid, from_position, to_position, path));
+
+	// Move the gap elsewhere. The path must go through the new gap.
+	grid.wall_gap_z = 90;
+	hierarchy.invalidate_area(Box3i(Vector3i(10, 0, 0), Vector3i(1, 5, 100)), grid);
+	ZN_TEST_ASSERT(hierarchy.find_path(grid, from_position, to_position, path));
+	ZN_TEST_ASSERT(is_path_valid(grid, from_position, to_position, path));
+
+	bool went_through_gap = false;
+	for (const Vector3i pos : path) {
+		if (pos.x == 10) {
+			ZN_TEST_ASSERT(Math::abs(pos.z - grid.wall_gap_z) <= 1);
+			went_through_gap = true;
+		}
+	}
+	ZN_TEST_ASSERT(went_through_gap);
+}
+
+} // namespace zylann::tests
@@ -0,0 +1,106 @@
+#include "test_dynamic_aabb_tree.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/dynamic_aabb_tree.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../testing.h"
+#include <algorithm>
+
+namespace zylann::tests {
+
+void test_dynamic_aabb_tree() {
+	struct Box {
+		Vector3f min_pos;
+		Vector3f max_pos;
+		uint32_t leaf;
+		bool valid;
+	};
+
+	struct L {
+		static Box make_random_box(RandomPCG &rng) {
+			const Vector3f pos(rng.randf() * 1000.f, rng.randf() * 1000.f, rng.randf() * 1000.f);
+			const Vector3f size(1.f + rng.randf() * 20.f, 1.f + rng.randf() * 20.f, 1.f + rng.randf() * 20.f);
+			return Box{ pos, pos + size, 0, true };
+		}
+
+		static bool intersects(const Box &a, const Box &b) {
+			return a.min_pos.x <= b.max_pos.x && a.min_pos.y <= b.max_pos.y && a.min_pos.z <= b.max_pos.z &&
+					a.max_pos.x >= b.min_pos.x && a.max_pos.y >= b.min_pos.y && a.max_pos.z >= b.min_pos.z;
+		}
+
+		static void check_queries(const DynamicAABBTree &tree, const StdVector<Box> &boxes, RandomPCG &rng) {
+			StdVector<uint32_t> found;
+			for (unsigned int query_index = 0; query_index < 100; ++query_index) {
+				Box query_box = make_random_box(rng);
+				query_box.max_pos = query_box.max_pos + Vector3f(50.f);
+
+				found.clear();
+				tree.query(query_box.min_pos, query_box.max_pos, [&found](uint32_t item) { //
+					found.push_back(item);
+				});
+				std::sort(found.begin(), found.end());
+
+				// Every box intersecting must be found. Others may be found too since leaves have enlarged boxes.
+				for (unsigned int i = 0; i < boxes.size(); ++i) {
+					const Box &box = boxes[i];
+					if (box.valid && intersects(box, query_box)) {
+						ZN_TEST_ASSERT(std::binary_search(found.begin(), found.end(), i));
+					}
+				}
+				for (const uint32_t i : found) {
+					ZN_TEST_ASSERT(i < boxes.size() && boxes[i].valid);
+				}
+			}
+		}
+	};
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	DynamicAABBTree tree;
+	StdVector<Box> boxes;
+
+	for (unsigned int i = 0; i < 2000; ++i) {
+		Box box = L::make_random_box(rng);
+		box.leaf = tree.create_leaf(box.min_pos, box.max_pos, i);
+		boxes.push_back(box);
+	}
+	ZN_TEST_ASSERT(tree.get_leaf_count() == boxes.size());
+	// Balancing should keep the tree not much taller than a perfectly balanced one (11 levels)
+	ZN_TEST_ASSERT(tree.get_height() < 24);
+	L::check_queries(tree, boxes, rng);
+
+	// Move boxes by small and large amounts
+	for (unsigned int i = 0; i < boxes.size(); ++i) {
+		Box &box = boxes[i];
+		const Vector3f offset = rng.rand(4) == 0 ? Vector3f(rng.randf() * 500.f, 0.f, rng.randf() * 500.f)
+												 : Vector3f(rng.randf() * 0.5f, rng.randf() * 0.5f, 0.f);
+		box.min_pos = box.min_pos + offset;
+		box.max_pos = box.max_pos + offset;
+		tree.move_leaf(box.leaf, box.min_pos, box.max_pos);
+		ZN_TEST_ASSERT(tree.get_item(box.leaf) == i);
+	}
+	L::check_queries(tree, boxes, rng);
+
+	// Remove half of the boxes
+	for (unsigned int i = 0; i < boxes.size(); i += 2) {
+		Box &box = boxes[i];
+		tree.destroy_leaf(box.leaf);
+		box.valid = false;
+	}
+	ZN_TEST_ASSERT(tree.get_leaf_count() == boxes.size() / 2);
+	L::check_queries(tree, boxes, rng);
+
+	// Boxes inserted in order along a line are the worst case for an unbalanced tree
+	tree.clear();
+	boxes.clear();
+	for (unsigned int i = 0; i < 1000; ++i) {
+		const Vector3f pos(i * 10.f, 0.f, 0.f);
+		Box box{ pos, pos + Vector3f(5.f), 0, true };
+		box.leaf = tree.create_leaf(box.min_pos, box.max_pos, i);
+		boxes.push_back(box);
+	}
+	ZN_TEST_ASSERT(tree.get_height() < 20);
+	L::check_queries(tree, boxes, rng);
+}
+
+} // namespace zylann::tests
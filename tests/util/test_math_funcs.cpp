@@ -1,5 +1,10 @@
 #include "test_math_funcs.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../../util/io/log.h"
 #include "../../util/math/funcs.h"
+#include "../../util/math/simd.h"
+#include "../../util/string/format.h"
 #include "../testing.h"
 
 namespace zylann::tests {
@@ -30,4 +35,121 @@ void test_wrap() {
 	}
 }
 
+void test_simd_kernels() {
+	// Odd count so the tail of vectorized loops gets tested too
+	const unsigned int input_count = 1003;
+
+	struct Inputs {
+		StdVector<float> a;
+		StdVector<float> b;
+		StdVector<float> c;
+		StdVector<float> table;
+		StdVector<float> triangles;
+	};
+
+	struct L {
+		static void compute_all(const Inputs &in, StdVector<StdVector<float>> &outputs) {
+			const unsigned int count = in.a.size();
+			const float *a = in.a.data();
+			const float *b = in.b.data();
+			const float *c = in.c.data();
+
+			outputs.clear();
+			outputs.resize(20);
+			for (StdVector<float> &output : outputs) {
+				output.resize(count);
+			}
+
+			unsigned int i = 0;
+			math::simd::add(a, b, outputs[i++].data(), count);
+			math::simd::add_constant(a, 0.5f, outputs[i++].data(), count);
+			math::simd::subtract(a, b, outputs[i++].data(), count);
+			math::simd::subtract_constant(a, 0.5f, outputs[i++].data(), count);
+			math::simd::subtract_from_constant(0.5f, b, outputs[i++].data(), count);
+			math::simd::multiply(a, b, outputs[i++].data(), count);
+			math::simd::multiply_constant(a, 0.5f, outputs[i++].data(), count);
+			math::simd::min(a, b, outputs[i++].data(), count);
+			math::simd::min_constant(a, 0.5f, outputs[i++].data(), count);
+			math::simd::max(a, b, outputs[i++].data(), count);
+			math::simd::max_constant(a, 0.5f, outputs[i++].data(), count);
+			math::simd::clamp(a, b, c, outputs[i++].data(), count);
+			math::simd::clamp_constant(a, -10.f, 10.f, outputs[i++].data(), count);
+			math::simd::lerp(a, b, c, outputs[i++].data(), count);
+			math::simd::sdf_sphere(a, b, c, 20.f, outputs[i++].data(), count);
+			math::simd::sdf_box(a, b, c, 10.f, 20.f, 30.f, outputs[i++].data(), count);
+			math::simd::sdf_smooth_union(a, b, 4.f, outputs[i++].data(), count);
+			math::simd::sample_table(a, in.table.data(), in.table.size(), -20.f, 30.f, outputs[i++].data(), count);
+			math::simd::triangle_distance_squared(
+					1.f, -2.f, 3.f, in.triangles.data(), count, outputs[i++].data(), count
+			);
+			// In-place
+			outputs[i] = in.a;
+			math::simd::add(outputs[i].data(), b, outputs[i].data(), count);
+			++i;
+
+			ZN_ASSERT(i == outputs.size());
+		}
+	};
+
+	Inputs inputs;
+	inputs.a.resize(input_count);
+	inputs.b.resize(input_count);
+	inputs.c.resize(input_count);
+	inputs.table.resize(37);
+	inputs.triangles.resize(9 * input_count);
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	for (unsigned int i = 0; i < input_count; ++i) {
+		inputs.a[i] = rng.random(-50.f, 50.f);
+		inputs.b[i] = rng.random(-50.f, 50.f);
+		inputs.c[i] = rng.random(-50.f, 50.f);
+	}
+	for (float &v : inputs.table) {
+		v = rng.random(-1.f, 1.f);
+	}
+	for (float &v : inputs.triangles) {
+		v = rng.random(-50.f, 50.f);
+	}
+
+	const math::simd::Level initial_level = math::simd::get_level();
+
+	StdVector<StdVector<float>> expected_outputs;
+	math::simd::set_level(math::simd::LEVEL_SCALAR);
+	L::compute_all(inputs, expected_outputs);
+
+	StdVector<StdVector<float>> outputs;
+
+	for (unsigned int level_index = math::simd::LEVEL_SCALAR + 1; level_index <= math::simd::get_max_supported_level();
+		 ++level_index) {
+		const math::simd::Level level = static_cast<math::simd::Level>(level_index);
+		math::simd::set_level(level);
+		L::compute_all(inputs, outputs);
+
+		for (unsigned int kernel_index = 0; kernel_index < outputs.size(); ++kernel_index) {
+			const StdVector<float> &output = outputs[kernel_index];
+			const StdVector<float> &expected_output = expected_outputs[kernel_index];
+
+			for (unsigned int i = 0; i < output.size(); ++i) {
+				// Results are not always bit-exact due to different order of operations
+				const float tolerance = 0.0001f * math::max(1.f, Math::abs(expected_output[i]));
+				if (Math::abs(output[i] - expected_output[i]) > tolerance) {
+					ZN_PRINT_ERROR(format(
+							"Kernel {} with {} at index {}: expected {}, got {}",
+							kernel_index,
+							math::simd::get_level_name(level),
+							i,
+							expected_output[i],
+							output[i]
+					));
+					ZN_TEST_ASSERT(false);
+				}
+			}
+		}
+	}
+
+	math::simd::set_level(initial_level);
+}
+
 } // namespace zylann::tests
@@ -4,6 +4,7 @@
 namespace zylann::tests {
 
 void test_wrap();
+void test_simd_kernels();
 
 } // namespace zylann::tests
 
@@ -4,6 +4,7 @@
 #include "../../util/math/conv.h"
 #include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
+#include "../../util/profiling_clock.h"
 #include "../../util/string/format.h"
 #include "../../util/tasks/threaded_task_runner.h"
 #include "../../util/thread/spatial_lock_3d.h"
@@ -234,6 +235,94 @@ void test_spatial_lock_spam() {
 	ZN_TEST_ASSERT(spatial_lock.get_locked_boxes_count() == 0);
 }
 
+void test_spatial_lock_benchmark() {
+	// Many threads lock small boxes very frequently without doing much work, like tasks meshing and generating chunks
+	// do. Each thread mostly works in its own area, and sometimes writes into a small area shared by all threads.
+	// Measures how many locks per second can be taken. A counter in the shared area checks writes are exclusive.
+
+	static const unsigned int ITERATIONS_PER_THREAD = 100000;
+	static const unsigned int THREAD_AREA_SIZE = 32;
+
+	struct Context {
+		SpatialLock3D *spatial_lock;
+		unsigned int *shared_counter;
+		unsigned int thread_index;
+		unsigned int shared_write_count;
+	};
+
+	struct L {
+		static void thread_func(void *userdata) {
+			Context &ctx = *static_cast<Context *>(userdata);
+			SpatialLock3D &spatial_lock = *ctx.spatial_lock;
+
+			RandomPCG rng;
+			rng.seed(ctx.thread_index + 42);
+
+			const Vector3i area_origin(ctx.thread_index * THREAD_AREA_SIZE, 0, 0);
+			const BoxBounds3i shared_box = BoxBounds3i::from_min_max_included(Vector3i(-4, 0, 0), Vector3i(-1, 3, 3));
+
+			for (unsigned int i = 0; i < ITERATIONS_PER_THREAD; ++i) {
+				if (rng.rand(100) < 2) {
+					SpatialLock3D::Write swlock(spatial_lock, shared_box);
+					++(*ctx.shared_counter);
+					++ctx.shared_write_count;
+					continue;
+				}
+
+				const unsigned int r = THREAD_AREA_SIZE - 3;
+				const Vector3i min_pos = area_origin + Vector3i(rng.rand(r), rng.rand(r), rng.rand(r));
+				const BoxBounds3i box = BoxBounds3i::from_min_max_included(min_pos, min_pos + Vector3i(2, 2, 2));
+
+				if (rng.rand(100) < 90) {
+					SpatialLock3D::Read srlock(spatial_lock, box);
+				} else {
+					SpatialLock3D::Write swlock(spatial_lock, box);
+				}
+			}
+		}
+	};
+
+	SpatialLock3D spatial_lock;
+	unsigned int shared_counter = 0;
+	FixedArray<Thread, 7> threads; // Excluding main thread
+	FixedArray<Context, 8> contexts;
+	const unsigned int main_thread_index = contexts.size() - 1;
+
+	for (unsigned int thread_index = 0; thread_index < contexts.size(); ++thread_index) {
+		contexts[thread_index] = Context{ &spatial_lock, &shared_counter, thread_index, 0 };
+	}
+
+	ProfilingClock pclock;
+
+	for (unsigned int thread_index = 0; thread_index < threads.size(); ++thread_index) {
+		threads[thread_index].start(L::thread_func, &contexts[thread_index]);
+	}
+
+	L::thread_func(&contexts[main_thread_index]);
+
+	for (unsigned int thread_index = 0; thread_index < threads.size(); ++thread_index) {
+		threads[thread_index].wait_to_finish();
+	}
+
+	const uint64_t elapsed_us = pclock.restart();
+
+	unsigned int expected_shared_writes = 0;
+	for (const Context &ctx : contexts) {
+		expected_shared_writes += ctx.shared_write_count;
+	}
+	ZN_TEST_ASSERT(shared_counter == expected_shared_writes);
+	ZN_TEST_ASSERT(spatial_lock.get_locked_boxes_count() == 0);
+
+	const uint64_t lock_count = uint64_t(ITERATIONS_PER_THREAD) * contexts.size();
+	ZN_PRINT_VERBOSE(format(
+			"SpatialLock3D benchmark: {} locks from {} threads in {} us, {} locks/s",
+			lock_count,
+			contexts.size(),
+			elapsed_us,
+			elapsed_us > 0 ? lock_count * 1000000 / elapsed_us : 0
+	));
+}
+
 void test_spatial_lock_dependent_map_chunks() {
 	// Simulates a bunch of tasks that could be baking light in columns of chunks.
 	// Each task may write into its neighbors.
@@ -5,6 +5,7 @@ namespace zylann::tests {
 
 void test_spatial_lock_misc();
 void test_spatial_lock_spam();
+void test_spatial_lock_benchmark();
 void test_spatial_lock_dependent_map_chunks();
 
 } // namespace zylann::tests
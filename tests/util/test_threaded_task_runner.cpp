@@ -4,9 +4,11 @@
 #include "../../util/godot/classes/os.h"
 #include "../../util/godot/classes/time.h"
 #include "../../util/io/log.h"
+#include "../../util/math/funcs.h"
 #include "../../util/math/vector3i.h"
 #include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
+#include "../../util/profiling_clock.h"
 #include "../../util/string/format.h"
 #include "../../util/string/std_stringstream.h"
 #include "../../util/tasks/threaded_task_runner.h"
@@ -19,7 +21,9 @@
 
 namespace zylann::tests {
 
-void test_threaded_task_runner_misc() {
+namespace {
+
+void test_threaded_task_runner_misc(ThreadedTaskRunner::SchedulerMode scheduler_mode) {
 	static const uint32_t task_duration_usec = 100'000;
 
 	struct TaskCounter {
@@ -88,6 +92,7 @@ void test_threaded_task_runner_misc() {
 	std::shared_ptr<TaskCounter> serial_counter = make_unique_instance<TaskCounter>();
 
 	ThreadedTaskRunner runner;
+	runner.set_scheduler_mode(scheduler_mode);
 	runner.set_thread_count(test_thread_count);
 	runner.set_name("Test");
 
@@ -142,6 +147,57 @@ void test_threaded_task_runner_misc() {
 	ZN_TEST_ASSERT(serial_counter->current_count == 0);
 }
 
+} // namespace
+
+void test_threaded_task_runner_misc() {
+	test_threaded_task_runner_misc(ThreadedTaskRunner::SCHEDULER_GLOBAL_QUEUE);
+	test_threaded_task_runner_misc(ThreadedTaskRunner::SCHEDULER_WORK_STEALING);
+}
+
+void test_threaded_task_runner_thread_count_reduction() {
+	class TestTask : public IThreadedTask {
+	public:
+		std::shared_ptr<std::atomic_uint32_t> completed_count;
+
+		TestTask(std::shared_ptr<std::atomic_uint32_t> p_completed_count) : completed_count(p_completed_count) {}
+
+		void run(ThreadedTaskContext &ctx) override {
+			ZN_PROFILE_SCOPE();
+			Thread::sleep_usec(1'000);
+			++(*completed_count);
+		}
+	};
+
+	const unsigned int task_count = 200;
+	std::shared_ptr<std::atomic_uint32_t> completed_count = make_shared_instance<std::atomic_uint32_t>(0);
+
+	ThreadedTaskRunner runner;
+	runner.set_scheduler_mode(ThreadedTaskRunner::SCHEDULER_WORK_STEALING);
+	runner.set_name("Test");
+	runner.set_thread_count(8);
+
+	// Tasks are spread across the queues of all threads
+	for (unsigned int i = 0; i < task_count; ++i) {
+		runner.enqueue(ZN_NEW(TestTask(completed_count)), false);
+	}
+
+	// Most tasks are still queued, including in queues of threads that are going away
+	runner.set_thread_count(2);
+	ZN_TEST_ASSERT(runner.get_thread_count() == 2);
+
+	runner.wait_for_all_tasks();
+
+	unsigned int dequeued_count = 0;
+	runner.dequeue_completed_tasks([&dequeued_count](IThreadedTask *task) {
+		ZN_DELETE(task);
+		++dequeued_count;
+	});
+
+	ZN_TEST_ASSERT(*completed_count == task_count);
+	ZN_TEST_ASSERT(dequeued_count == task_count);
+	ZN_TEST_ASSERT(runner.get_debug_remaining_tasks() == 0);
+}
+
 void test_threaded_task_runner_debug_names() {
 	class NamedTestTask1 : public IThreadedTask {
 	public:
@@ -266,6 +322,82 @@ void test_threaded_task_runner_debug_names() {
 	print_line(ss.str());
 }
 
+// Runs a lot of very small tasks, so most of the time is spent scheduling them rather than running them.
+// Compares scheduler modes.
+void test_threaded_task_runner_contention() {
+	class SmallTask : public IThreadedTask {
+	public:
+		std::atomic_uint32_t &counter;
+		TaskPriority priority;
+
+		SmallTask(std::atomic_uint32_t &p_counter, TaskPriority p_priority) :
+				counter(p_counter), priority(p_priority) {}
+
+		void run(ThreadedTaskContext &ctx) override {
+			++counter;
+		}
+
+		TaskPriority get_priority() override {
+			return priority;
+		}
+	};
+
+	const unsigned int task_count = 200'000;
+	const unsigned int batch_size = 1000;
+	const unsigned int thread_count =
+			math::clamp(Thread::get_hardware_concurrency(), 2u, uint32_t(ThreadedTaskRunner::MAX_THREADS));
+
+	const ThreadedTaskRunner::SchedulerMode modes[] = {
+		ThreadedTaskRunner::SCHEDULER_GLOBAL_QUEUE, //
+		ThreadedTaskRunner::SCHEDULER_WORK_STEALING //
+	};
+
+	for (const ThreadedTaskRunner::SchedulerMode mode : modes) {
+		std::atomic_uint32_t counter = { 0 };
+		RandomPCG rng;
+		StdVector<IThreadedTask *> batch;
+
+		ThreadedTaskRunner runner;
+		runner.set_scheduler_mode(mode);
+		runner.set_thread_count(thread_count);
+		runner.set_name("Test");
+
+		ProfilingClock pclock;
+
+		for (unsigned int batch_begin = 0; batch_begin < task_count; batch_begin += batch_size) {
+			batch.clear();
+			for (unsigned int i = 0; i < batch_size; ++i) {
+				const TaskPriority priority(rng.rand() % 256, rng.rand() % 4, 10, 10);
+				batch.push_back(ZN_NEW(SmallTask(counter, priority)));
+			}
+			runner.enqueue(to_span(batch), false);
+		}
+
+		runner.wait_for_all_tasks();
+
+		const uint64_t elapsed_us = pclock.get_elapsed_microseconds();
+
+		unsigned int completed_count = 0;
+		runner.dequeue_completed_tasks([&completed_count](IThreadedTask *task) {
+			ZN_DELETE(task);
+			++completed_count;
+		});
+
+		ZN_TEST_ASSERT(completed_count == task_count);
+		ZN_TEST_ASSERT(counter == task_count);
+
+		const uint64_t tasks_per_second = uint64_t(task_count) * 1'000'000 / math::max(elapsed_us, uint64_t(1));
+		ZN_PRINT_VERBOSE(format(
+				"Ran {} tasks on {} threads with {} in {} us ({} tasks/s)",
+				task_count,
+				thread_count,
+				mode == ThreadedTaskRunner::SCHEDULER_WORK_STEALING ? "work stealing" : "global queue",
+				elapsed_us,
+				tasks_per_second
+		));
+	}
+}
+
 void test_task_priority_values() {
 	ZN_TEST_ASSERT(TaskPriority(0, 0, 0, 0) < TaskPriority(1, 0, 0, 0));
 	ZN_TEST_ASSERT(TaskPriority(0, 0, 0, 0) < TaskPriority(0, 0, 0, 1));
@@ -4,7 +4,9 @@
 namespace zylann::tests {
 
 void test_threaded_task_runner_misc();
+void test_threaded_task_runner_thread_count_reduction();
 void test_threaded_task_runner_debug_names();
+void test_threaded_task_runner_contention();
 void test_task_priority_values();
 void test_threaded_task_postponing();
 
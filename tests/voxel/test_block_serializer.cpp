@@ -1,5 +1,6 @@
 #include "test_block_serializer.h"
 #include "../../storage/voxel_buffer_gd.h"
+#include "../../streams/compressed_data.h"
 #include "../../streams/voxel_block_serializer.h"
 #include "../../streams/voxel_block_serializer_gd.h"
 #include "../../util/godot/classes/stream_peer_buffer.h"
@@ -49,6 +50,61 @@ void test_block_serializer() {
 	}
 }
 
+void test_block_serializer_compression_dictionary() {
+	struct L {
+		static void make_block(VoxelBuffer &vb, int variant) {
+			vb.create(Vector3i(16, 16, 16));
+			// Blocks share similar patterns, but aren't identical
+			vb.fill_area(1, Vector3i(0, 0, 0), Vector3i(16, 8 + variant % 4, 16), 0);
+			vb.fill_area(variant % 3 + 2, Vector3i(variant % 5, 2, 3), Vector3i(12, 6, 14), 0);
+			vb.fill_area(7, Vector3i(0, 0, 0), Vector3i(16, 4, 16), 1);
+		}
+	};
+
+	// Train a dictionary from uncompressed serialized blocks
+	StdVector<StdVector<uint8_t>> samples;
+	for (int i = 0; i < 8; ++i) {
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		L::make_block(vb, i);
+		BlockSerializer::SerializeResult result = BlockSerializer::serialize(vb);
+		ZN_TEST_ASSERT(result.success);
+		samples.push_back(result.data);
+	}
+	StdVector<Span<const uint8_t>> sample_spans;
+	for (const StdVector<uint8_t> &sample : samples) {
+		sample_spans.push_back(to_span(sample));
+	}
+	StdVector<uint8_t> dictionary;
+	CompressedData::train_dictionary(to_span(sample_spans), 4096, dictionary);
+	ZN_TEST_ASSERT(dictionary.size() > 0);
+	ZN_TEST_ASSERT(dictionary.size() <= 4096);
+
+	VoxelBuffer voxel_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+	L::make_block(voxel_buffer, 42);
+
+	// Serialize
+	BlockSerializer::SerializeResult result =
+			BlockSerializer::serialize_and_compress(voxel_buffer, to_span_const(dictionary));
+	ZN_TEST_ASSERT(result.success);
+	StdVector<uint8_t> data = result.data;
+
+	uint32_t dictionary_id;
+	ZN_TEST_ASSERT(CompressedData::get_required_dictionary_id(to_span(data), dictionary_id));
+	ZN_TEST_ASSERT(dictionary_id == CompressedData::get_dictionary_id(to_span(dictionary)));
+
+	// Deserialize
+	VoxelBuffer deserialized_voxel_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+	ZN_TEST_ASSERT(BlockSerializer::decompress_and_deserialize(
+			to_span(data), deserialized_voxel_buffer, to_span_const(dictionary)
+	));
+	ZN_TEST_ASSERT(voxel_buffer.equals(deserialized_voxel_buffer));
+
+	// Data compressed without dictionary doesn't require one
+	BlockSerializer::SerializeResult result_without_dictionary = BlockSerializer::serialize_and_compress(voxel_buffer);
+	ZN_TEST_ASSERT(result_without_dictionary.success);
+	ZN_TEST_ASSERT(!CompressedData::get_required_dictionary_id(to_span(result_without_dictionary.data), dictionary_id));
+}
+
 void test_block_serializer_stream_peer() {
 	// Create an example buffer
 	const Vector3i block_size(8, 9, 10);
@@ -4,6 +4,7 @@
 namespace zylann::voxel::tests {
 
 void test_block_serializer();
+void test_block_serializer_compression_dictionary();
 void test_block_serializer_stream_peer();
 
 } // namespace zylann::voxel::tests
@@ -0,0 +1,223 @@
+#include "test_generator_output_cache.h"
+#include "../../generators/graph/voxel_generator_graph.h"
+#include "../../generators/voxel_generator_output_cache.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../util/godot/classes/directory.h"
+#include "../../util/godot/classes/file_access.h"
+#include "../../util/godot/core/array.h"
+#include "../../util/noise/fast_noise_lite/fast_noise_lite.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_generator_output_cache() {
+	static const int BLOCK_SIZE = 16;
+	static const unsigned int BLOCK_COUNT = 10;
+	static const uint64_t GENERATOR_HASH = 123456789;
+
+	struct L {
+		static void make_block(VoxelBuffer &vb, unsigned int seed) {
+			vb.create(Vector3iUtil::create(BLOCK_SIZE));
+			Vector3i pos;
+			for (pos.z = 0; pos.z < BLOCK_SIZE; ++pos.z) {
+				for (pos.x = 0; pos.x < BLOCK_SIZE; ++pos.x) {
+					for (pos.y = 0; pos.y < BLOCK_SIZE; ++pos.y) {
+						const float sd = Math::sin(pos.x * 0.3f + seed) * 4.f + pos.y - BLOCK_SIZE / 2 +
+								Math::cos(pos.z * 0.2f + seed);
+						vb.set_voxel_f(sd, pos, VoxelBuffer::CHANNEL_SDF);
+					}
+				}
+			}
+		}
+
+		static VoxelGeneratorOutputCache::Key make_key(unsigned int i) {
+			return VoxelGeneratorOutputCache::Key{ GENERATOR_HASH, Vector3i(i, 0, 0), 0, BLOCK_SIZE };
+		}
+
+		static void store_blocks(VoxelGeneratorOutputCache &cache) {
+			for (unsigned int i = 0; i < BLOCK_COUNT; ++i) {
+				VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				make_block(vb, i);
+				cache.store(make_key(i), vb, (i % 2) == 0);
+			}
+		}
+
+		static bool check_block(VoxelGeneratorOutputCache &cache, unsigned int i) {
+			VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+			make_block(expected, i);
+			VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+			bool max_lod_hint;
+			if (!cache.load(make_key(i), vb, max_lod_hint)) {
+				return false;
+			}
+			ZN_TEST_ASSERT(vb.equals(expected));
+			ZN_TEST_ASSERT(max_lod_hint == ((i % 2) == 0));
+			return true;
+		}
+
+		// Flips the last byte of every cache file. Returns how many files were modified.
+		static unsigned int corrupt_files(const String &directory) {
+			Ref<DirAccess> dir = zylann::godot::open_directory(directory);
+			ZN_TEST_ASSERT(dir.is_valid());
+			ZN_TEST_ASSERT(dir->change_dir(directory) == OK);
+
+			StdVector<String> file_names;
+			dir->list_dir_begin();
+			String file_name = dir->get_next();
+			while (!file_name.is_empty()) {
+				if (!dir->current_is_dir() && file_name.get_extension() == "vxgc") {
+					file_names.push_back(file_name);
+				}
+				file_name = dir->get_next();
+			}
+			dir->list_dir_end();
+
+			for (const String &name : file_names) {
+				Error err;
+				Ref<FileAccess> f = zylann::godot::open_file(directory.path_join(name), FileAccess::READ_WRITE, err);
+				ZN_TEST_ASSERT(f.is_valid());
+				const uint64_t len = f->get_length();
+				ZN_TEST_ASSERT(len > 0);
+				f->seek(len - 1);
+				const uint8_t b = f->get_8();
+				f->seek(len - 1);
+				f->store_8(b ^ 0xff);
+			}
+
+			return file_names.size();
+		}
+	};
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	// Declared after the directory, so files get removed before it
+	VoxelGeneratorOutputCache cache;
+
+	// Measure how much a block takes
+	cache.configure(1024 * 1024, String(), 0);
+	L::store_blocks(cache);
+	const VoxelGeneratorOutputCache::Stats all_in_memory_stats = cache.get_stats();
+	ZN_TEST_ASSERT(all_in_memory_stats.memory_entry_count == BLOCK_COUNT);
+	const size_t average_block_size = all_in_memory_stats.memory_usage / BLOCK_COUNT;
+	ZN_TEST_ASSERT(average_block_size > 0);
+
+	const size_t memory_budget = average_block_size * 7 / 2;
+
+	// Memory only: least recently used blocks get discarded
+	{
+		cache.configure(memory_budget, String(), 0);
+		L::store_blocks(cache);
+
+		const VoxelGeneratorOutputCache::Stats stats = cache.get_stats();
+		ZN_TEST_ASSERT(stats.memory_usage <= memory_budget);
+		ZN_TEST_ASSERT(stats.memory_entry_count < BLOCK_COUNT);
+		ZN_TEST_ASSERT(stats.disk_entry_count == 0);
+
+		ZN_TEST_ASSERT(L::check_block(cache, BLOCK_COUNT - 1));
+		ZN_TEST_ASSERT(!L::check_block(cache, 0));
+	}
+
+	// Different generator: miss
+	{
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		bool max_lod_hint;
+		VoxelGeneratorOutputCache::Key key = L::make_key(BLOCK_COUNT - 1);
+		key.generator_hash += 1;
+		ZN_TEST_ASSERT(!cache.load(key, vb, max_lod_hint));
+	}
+
+	// With files: evicted blocks can be loaded back
+	{
+		cache.configure(memory_budget, test_dir.get_path(), 1024 * 1024);
+		L::store_blocks(cache);
+
+		const VoxelGeneratorOutputCache::Stats stats = cache.get_stats();
+		ZN_TEST_ASSERT(stats.memory_usage <= memory_budget);
+		ZN_TEST_ASSERT(stats.disk_entry_count > 0);
+		ZN_TEST_ASSERT(stats.memory_entry_count + stats.disk_entry_count == BLOCK_COUNT);
+
+		for (unsigned int i = 0; i < BLOCK_COUNT; ++i) {
+			ZN_TEST_ASSERT(L::check_block(cache, i));
+		}
+
+		// Loading blocks from files moves them back in memory, evicting others to files
+		const VoxelGeneratorOutputCache::Stats stats_after = cache.get_stats();
+		ZN_TEST_ASSERT(stats_after.memory_usage <= memory_budget);
+		ZN_TEST_ASSERT(stats_after.memory_entry_count + stats_after.disk_entry_count == BLOCK_COUNT);
+	}
+
+	// Corrupted files are detected and count as misses
+	{
+		cache.configure(memory_budget, test_dir.get_path(), 1024 * 1024);
+		L::store_blocks(cache);
+		ZN_TEST_ASSERT(cache.get_stats().disk_entry_count > 0);
+
+		ZN_TEST_ASSERT(L::corrupt_files(test_dir.get_path()) > 0);
+
+		// The first blocks were evicted to files, the last ones are still in memory
+		ZN_TEST_ASSERT(!L::check_block(cache, 0));
+		ZN_TEST_ASSERT(L::check_block(cache, BLOCK_COUNT - 1));
+	}
+
+	cache.clear();
+	ZN_TEST_ASSERT(cache.get_stats().disk_entry_count == 0);
+	ZN_TEST_ASSERT(!L::check_block(cache, BLOCK_COUNT - 1));
+}
+
+void test_generator_output_cache_subresource_change() {
+	static const int BLOCK_SIZE = 16;
+
+	//     X --- FastNoise2D --- OutputSDF
+	//      \/
+	//      /\
+	//     Z
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	pg::VoxelGraphFunction &g = **generator->get_main_function();
+	const uint32_t in_x = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_X, Vector2());
+	const uint32_t in_z = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+	const uint32_t n_fn2d = g.create_node(pg::VoxelGraphFunction::NODE_FAST_NOISE_2D, Vector2());
+	const uint32_t out_sdf = g.create_node(pg::VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+	Ref<ZN_FastNoiseLite> noise;
+	noise.instantiate();
+	g.set_node_param(n_fn2d, 0, noise);
+	g.add_connection(in_x, 0, n_fn2d, 0);
+	g.add_connection(in_z, 0, n_fn2d, 1);
+	g.add_connection(n_fn2d, 0, out_sdf, 0);
+
+	const pg::CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT_MSG(result.success,
+			String("Failed to compile graph: {0}: {1}").format(varray(result.node_id, result.message)));
+
+	struct L {
+		static VoxelGeneratorOutputCache::Key make_key(const VoxelGenerator &generator) {
+			return VoxelGeneratorOutputCache::Key{ generator.get_output_hash(), Vector3i(), 0, BLOCK_SIZE };
+		}
+	};
+
+	VoxelGeneratorOutputCache cache;
+	cache.configure(1024 * 1024, String(), 0);
+
+	{
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		vb.create(Vector3iUtil::create(BLOCK_SIZE));
+		VoxelGenerator::VoxelQueryData query{ vb, Vector3i(), 0 };
+		generator->generate_block(query);
+		cache.store(L::make_key(**generator), vb, false);
+	}
+
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	bool max_lod_hint;
+	ZN_TEST_ASSERT(cache.load(L::make_key(**generator), vb, max_lod_hint));
+
+	// Editing the noise changes what the generator outputs, without recompiling the graph
+	noise->set_seed(noise->get_seed() + 1);
+	ZN_TEST_ASSERT(!cache.load(L::make_key(**generator), vb, max_lod_hint));
+
+	// Reverting the edit gives back the same output
+	noise->set_seed(noise->get_seed() - 1);
+	ZN_TEST_ASSERT(cache.load(L::make_key(**generator), vb, max_lod_hint));
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,11 @@
+#ifndef VOXEL_TEST_GENERATOR_OUTPUT_CACHE_H
+#define VOXEL_TEST_GENERATOR_OUTPUT_CACHE_H
+
+namespace zylann::voxel::tests {
+
+void test_generator_output_cache();
+void test_generator_output_cache_subresource_change();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TEST_GENERATOR_OUTPUT_CACHE_H
@@ -0,0 +1,234 @@
+#include "test_mesh_output_cache.h"
+#include "../../engine/voxel_engine.h"
+#include "../../generators/graph/voxel_generator_graph.h"
+#include "../../meshers/mesh_block_task.h"
+#include "../../meshers/transvoxel/voxel_mesher_transvoxel.h"
+#include "../../meshers/voxel_mesh_output_cache.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../util/noise/fast_noise_lite/fast_noise_lite.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_mesh_output_cache() {
+	static const uint64_t GENERATOR_HASH = 123456789;
+
+	struct L {
+		static void build(VoxelMesher::Output &output, Vector3f center) {
+			// 16 voxels plus padding
+			VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+			vb.create(Vector3i(19, 19, 19));
+			vb.set_channel_depth(VoxelBuffer::CHANNEL_SDF, VoxelBuffer::DEPTH_32_BIT);
+			Vector3i pos;
+			for (pos.z = 0; pos.z < vb.get_size().z; ++pos.z) {
+				for (pos.x = 0; pos.x < vb.get_size().x; ++pos.x) {
+					for (pos.y = 0; pos.y < vb.get_size().y; ++pos.y) {
+						const float sd = (Vector3f(pos.x, pos.y, pos.z) - center).length() - 7.f;
+						vb.set_voxel_f(sd, pos, VoxelBuffer::CHANNEL_SDF);
+					}
+				}
+			}
+
+			Ref<VoxelMesherTransvoxel> mesher;
+			mesher.instantiate();
+			VoxelMesher::Input input{ vb, nullptr, nullptr, Vector3i(), 0, true };
+			input.lod_hint = true;
+			mesher->build(output, input);
+		}
+
+		static bool is_same_surface(const VoxelMesher::Output::Surface &a, const VoxelMesher::Output::Surface &b) {
+			ZN_TEST_ASSERT(a.material_index == b.material_index);
+			ZN_TEST_ASSERT(a.arrays.size() == b.arrays.size());
+			if (a.arrays.size() == 0) {
+				return true;
+			}
+
+			// Positions and normals are quantized
+			const PackedVector3Array vertices_a = a.arrays[Mesh::ARRAY_VERTEX];
+			const PackedVector3Array vertices_b = b.arrays[Mesh::ARRAY_VERTEX];
+			ZN_TEST_ASSERT(vertices_a.size() == vertices_b.size());
+			for (int i = 0; i < vertices_a.size(); ++i) {
+				ZN_TEST_ASSERT(vertices_a[i].distance_to(vertices_b[i]) < 0.001f);
+			}
+			const PackedVector3Array normals_a = a.arrays[Mesh::ARRAY_NORMAL];
+			const PackedVector3Array normals_b = b.arrays[Mesh::ARRAY_NORMAL];
+			ZN_TEST_ASSERT(normals_a.size() == normals_b.size());
+			for (int i = 0; i < normals_a.size(); ++i) {
+				ZN_TEST_ASSERT(normals_a[i].distance_to(normals_b[i]) < 0.001f);
+			}
+
+			// Other arrays are lossless
+			for (int i = 0; i < a.arrays.size(); ++i) {
+				if (i != Mesh::ARRAY_VERTEX && i != Mesh::ARRAY_NORMAL) {
+					ZN_TEST_ASSERT(a.arrays[i] == b.arrays[i]);
+				}
+			}
+			return true;
+		}
+
+		static bool is_same_output(const VoxelMesher::Output &a, const VoxelMesher::Output &b) {
+			ZN_TEST_ASSERT(a.primitive_type == b.primitive_type);
+			ZN_TEST_ASSERT(a.mesh_flags == b.mesh_flags);
+			ZN_TEST_ASSERT(a.surfaces.size() == b.surfaces.size());
+			for (unsigned int i = 0; i < a.surfaces.size(); ++i) {
+				ZN_TEST_ASSERT(is_same_surface(a.surfaces[i], b.surfaces[i]));
+			}
+			for (unsigned int side = 0; side < a.transition_surfaces.size(); ++side) {
+				ZN_TEST_ASSERT(a.transition_surfaces[side].size() == b.transition_surfaces[side].size());
+				for (unsigned int i = 0; i < a.transition_surfaces[side].size(); ++i) {
+					ZN_TEST_ASSERT(is_same_surface(a.transition_surfaces[side][i], b.transition_surfaces[side][i]));
+				}
+			}
+			ZN_TEST_ASSERT(a.collision_surface.positions == b.collision_surface.positions);
+			ZN_TEST_ASSERT(a.collision_surface.indices == b.collision_surface.indices);
+			ZN_TEST_ASSERT(a.collision_surface.submesh_vertex_end == b.collision_surface.submesh_vertex_end);
+			ZN_TEST_ASSERT(a.collision_surface.submesh_index_end == b.collision_surface.submesh_index_end);
+			return true;
+		}
+
+		static VoxelMeshOutputCache::Key make_key(Vector3i position, uint8_t lod_index) {
+			return VoxelMeshOutputCache::Key{ GENERATOR_HASH, 987654321, position, lod_index, 4 };
+		}
+	};
+
+	VoxelMesher::Output output0;
+	L::build(output0, Vector3f(9.5f, 9.5f, 9.5f));
+	ZN_TEST_ASSERT(output0.surfaces.size() == 1);
+	VoxelMesher::Output output1;
+	L::build(output1, Vector3f(4.f, 12.f, 7.f));
+
+	// Serialization roundtrip
+	{
+		StdVector<uint8_t> data;
+		ZN_TEST_ASSERT(VoxelMeshOutputCache::serialize(output0, data));
+		VoxelMesher::Output output;
+		ZN_TEST_ASSERT(VoxelMeshOutputCache::deserialize(to_span_const(data), output));
+		ZN_TEST_ASSERT(L::is_same_output(output, output0));
+
+		// Truncated data must fail gracefully
+		ZN_TEST_ASSERT(!VoxelMeshOutputCache::deserialize(Span<const uint8_t>(data.data(), data.size() / 2), output));
+	}
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	// Blocks in the same region and in different regions, including negative coordinates
+	const Vector3i positions[] = { Vector3i(0, 0, 0), Vector3i(1, 0, 0), Vector3i(-1, -3, 20), Vector3i(100, 5, -9) };
+
+	{
+		VoxelMeshOutputCache cache;
+		cache.configure(test_dir.get_path(), 1);
+		ZN_TEST_ASSERT(cache.is_enabled());
+
+		VoxelMesher::Output output;
+		ZN_TEST_ASSERT(!cache.load(L::make_key(positions[0], 1), output));
+
+		for (unsigned int i = 0; i < std::size(positions); ++i) {
+			cache.store(L::make_key(positions[i], 1), (i % 2) == 0 ? output0 : output1);
+		}
+
+		for (unsigned int i = 0; i < std::size(positions); ++i) {
+			VoxelMesher::Output loaded_output;
+			ZN_TEST_ASSERT(cache.load(L::make_key(positions[i], 1), loaded_output));
+			ZN_TEST_ASSERT(L::is_same_output(loaded_output, (i % 2) == 0 ? output0 : output1));
+		}
+
+		// Different LOD, generator or mesher: miss
+		ZN_TEST_ASSERT(!cache.load(L::make_key(positions[0], 2), output));
+		VoxelMeshOutputCache::Key key = L::make_key(positions[0], 1);
+		key.generator_hash += 1;
+		ZN_TEST_ASSERT(!cache.load(key, output));
+		key = L::make_key(positions[0], 1);
+		key.mesher_hash += 1;
+		ZN_TEST_ASSERT(!cache.load(key, output));
+
+		const VoxelMeshOutputCache::Stats stats = cache.get_stats();
+		ZN_TEST_ASSERT(stats.store_count == std::size(positions));
+		ZN_TEST_ASSERT(stats.hit_count == std::size(positions));
+	}
+
+	// Files are kept across runs
+	{
+		VoxelMeshOutputCache cache;
+		cache.configure(test_dir.get_path(), 1);
+
+		for (unsigned int i = 0; i < std::size(positions); ++i) {
+			VoxelMesher::Output loaded_output;
+			ZN_TEST_ASSERT(cache.load(L::make_key(positions[i], 1), loaded_output));
+			ZN_TEST_ASSERT(L::is_same_output(loaded_output, (i % 2) == 0 ? output0 : output1));
+		}
+
+		// Storing in an existing file
+		cache.store(L::make_key(Vector3i(2, 0, 0), 1), output1);
+		VoxelMesher::Output loaded_output;
+		ZN_TEST_ASSERT(cache.load(L::make_key(Vector3i(2, 0, 0), 1), loaded_output));
+		ZN_TEST_ASSERT(L::is_same_output(loaded_output, output1));
+		ZN_TEST_ASSERT(cache.load(L::make_key(positions[1], 1), loaded_output));
+		ZN_TEST_ASSERT(L::is_same_output(loaded_output, output1));
+	}
+}
+
+void test_mesh_output_cache_key_generator_change() {
+	//     X --- FastNoise2D --- OutputSDF
+	//      \/
+	//      /\
+	//     Z
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	pg::VoxelGraphFunction &g = **generator->get_main_function();
+	const uint32_t in_x = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_X, Vector2());
+	const uint32_t in_z = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+	const uint32_t n_fn2d = g.create_node(pg::VoxelGraphFunction::NODE_FAST_NOISE_2D, Vector2());
+	const uint32_t out_sdf = g.create_node(pg::VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+	Ref<ZN_FastNoiseLite> noise;
+	noise.instantiate();
+	g.set_node_param(n_fn2d, 0, noise);
+	g.add_connection(in_x, 0, n_fn2d, 0);
+	g.add_connection(in_z, 0, n_fn2d, 1);
+	g.add_connection(n_fn2d, 0, out_sdf, 0);
+	ZN_TEST_ASSERT(generator->compile(false).success);
+
+	Ref<VoxelMesherTransvoxel> mesher;
+	mesher.instantiate();
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	VoxelMeshOutputCache &cache = VoxelEngine::get_singleton().get_mesh_output_cache();
+	cache.configure(test_dir.get_path(), 1);
+
+	// Task for a block that has no voxels in memory, so it only contains what the generator outputs
+	MeshBlockTask task;
+	task.mesh_block_position = Vector3i(1, 2, 3);
+	task.lod_index = 1;
+	task.blocks_count = 3 * 3 * 3;
+	task.mesh_cache_hint = true;
+	task.lod_hint = true;
+	task.data = make_shared_instance<VoxelData>();
+	MeshingDependency::reset(task.meshing_dependency, mesher, generator);
+
+	VoxelMeshOutputCache::Key key0;
+	ZN_TEST_ASSERT(task.get_mesh_cache_key(key0));
+	VoxelMeshOutputCache::Key key1;
+	ZN_TEST_ASSERT(task.get_mesh_cache_key(key1));
+	ZN_TEST_ASSERT(key1.generator_hash == key0.generator_hash);
+	ZN_TEST_ASSERT(key1.mesher_hash == key0.mesher_hash);
+
+	// Editing a resource used by the generator changes its output without recompiling, so the key must change
+	noise->set_period(noise->get_period() + 10.f);
+	VoxelMeshOutputCache::Key key2;
+	ZN_TEST_ASSERT(task.get_mesh_cache_key(key2));
+	ZN_TEST_ASSERT(key2.generator_hash != key0.generator_hash);
+	ZN_TEST_ASSERT(key2.mesher_hash == key0.mesher_hash);
+	ZN_TEST_ASSERT(key2.position == key0.position);
+
+	// Blocks below the first cached LOD don't use the cache
+	task.lod_index = 0;
+	ZN_TEST_ASSERT(!task.get_mesh_cache_key(key2));
+
+	// Don't leave the cache enabled for other tests
+	cache.configure(String(), 0);
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,11 @@
+#ifndef VOXEL_TESTS_MESH_OUTPUT_CACHE_H
+#define VOXEL_TESTS_MESH_OUTPUT_CACHE_H
+
+namespace zylann::voxel::tests {
+
+void test_mesh_output_cache();
+void test_mesh_output_cache_key_generator_change();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_MESH_OUTPUT_CACHE_H
@@ -1,5 +1,9 @@
 #include "test_mesh_sdf.h"
+#include "../../edition/mesh_sdf.h"
 #include "../../edition/voxel_mesh_sdf_gd.h"
+#include "../../util/math/conv.h"
+#include "../../util/math/sdf.h"
+#include "../testing.h"
 
 namespace zylann::voxel::tests {
 
@@ -30,4 +34,73 @@ void test_voxel_mesh_sdf_issue463() {
 	msdf->call("_set_data", d);
 }
 
+void test_mesh_sdf_bvh() {
+	// Box with different sizes on each axis, so its exact SDF is known
+	const Vector3 extents(1.0, 0.5, 0.75);
+
+	StdVector<Vector3> vertices;
+	for (int i = 0; i < 8; ++i) {
+		vertices.push_back(Vector3( //
+				(i & 1) != 0 ? extents.x : -extents.x,
+				(i & 2) != 0 ? extents.y : -extents.y,
+				(i & 4) != 0 ? extents.z : -extents.z
+		));
+	}
+
+	// Front faces are clockwise
+	const StdVector<int> indices = {
+		0, 1, 2, 1, 3, 2, // -Z
+		4, 6, 5, 5, 6, 7, // +Z
+		0, 4, 1, 1, 4, 5, // -Y
+		2, 3, 6, 3, 7, 6, // +Y
+		0, 2, 4, 2, 6, 4, // -X
+		1, 5, 3, 3, 5, 7 // +X
+	};
+
+	StdVector<mesh_sdf::Triangle> triangles;
+	Vector3f min_pos;
+	Vector3f max_pos;
+	ZN_TEST_ASSERT(mesh_sdf::prepare_triangles(to_span(vertices), to_span(indices), triangles, min_pos, max_pos));
+
+	mesh_sdf::TriangleBVH bvh;
+	mesh_sdf::build_triangle_bvh(to_span(triangles), bvh);
+	ZN_TEST_ASSERT(bvh.triangles.size() == triangles.size());
+	ZN_TEST_ASSERT(mesh_sdf::get_winding_number(bvh, Vector3f(0.1f, 0.2f, 0.3f)) > 0.99f);
+	ZN_TEST_ASSERT(mesh_sdf::get_winding_number(bvh, Vector3f(0.f, 3.f, 0.f)) < 0.01f);
+
+	const Vector3f box_min_pos = min_pos - Vector3f(0.5f);
+	const Vector3f box_max_pos = max_pos + Vector3f(0.5f);
+	const Vector3i res = mesh_sdf::auto_compute_grid_resolution(box_max_pos - box_min_pos, 24);
+
+	StdVector<float> naive_grid;
+	naive_grid.resize(Vector3iUtil::get_volume(res));
+	mesh_sdf::generate_mesh_sdf_naive(to_span(naive_grid), res, to_span(triangles), box_min_pos, box_max_pos);
+
+	StdVector<float> bvh_grid;
+	bvh_grid.resize(Vector3iUtil::get_volume(res));
+	mesh_sdf::generate_mesh_sdf_bvh(to_span(bvh_grid), res, to_span(triangles), box_min_pos, box_max_pos);
+
+	const Vector3f cell_size = (box_max_pos - box_min_pos) / to_vec3f(res);
+
+	Vector3i grid_pos;
+	for (grid_pos.z = 0; grid_pos.z < res.z; ++grid_pos.z) {
+		for (grid_pos.x = 0; grid_pos.x < res.x; ++grid_pos.x) {
+			for (grid_pos.y = 0; grid_pos.y < res.y; ++grid_pos.y) {
+				const unsigned int i = Vector3iUtil::get_zxy_index(grid_pos, res);
+				const Vector3f pos = box_min_pos + cell_size * (to_vec3f(grid_pos) + Vector3f(0.5f));
+				const float expected_sd = math::sdf_box(to_vec3(pos), extents);
+
+				// Same distances as checking every triangle
+				ZN_TEST_ASSERT(Math::abs(Math::abs(bvh_grid[i]) - Math::abs(naive_grid[i])) < 0.0001f);
+				ZN_TEST_ASSERT(Math::abs(Math::abs(bvh_grid[i]) - Math::abs(expected_sd)) < 0.0001f);
+
+				// Signs don't depend on which triangle is the closest
+				if (Math::abs(expected_sd) > 0.001f) {
+					ZN_TEST_ASSERT((bvh_grid[i] < 0.f) == (expected_sd < 0.f));
+				}
+			}
+		}
+	}
+}
+
 } // namespace zylann::voxel::tests
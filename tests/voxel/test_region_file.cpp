@@ -3,6 +3,7 @@
 #include "../../streams/region/voxel_stream_region_files.h"
 #include "../../util/containers/std_unordered_map.h"
 #include "../../util/godot/core/random_pcg.h"
+#include "../../util/io/async_file_reader.h"
 #include "../testing.h"
 
 namespace zylann::voxel::tests {
@@ -200,4 +201,201 @@ void test_voxel_stream_region_files() {
 	}
 }
 
+void test_voxel_stream_region_files_memory_mapped() {
+	if (!MemoryMappedFile::is_supported()) {
+		return;
+	}
+
+	const int block_size_po2 = 4;
+	const int block_size = 1 << block_size_po2;
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	Ref<VoxelStreamRegionFiles> stream;
+	stream.instantiate();
+	stream->set_block_size_po2(block_size_po2);
+	stream->set_directory(test_dir.get_path());
+	stream->set_memory_mapped_reads_enabled(true);
+
+	RandomPCG rng;
+
+	struct L {
+		static void make_block(VoxelBuffer &buffer, RandomPCG &rng, int random_layers) {
+			buffer.create(block_size, block_size, block_size);
+			buffer.fill(1, 0);
+			for (int z = 0; z < block_size; ++z) {
+				for (int x = 0; x < block_size; ++x) {
+					for (int y = 0; y < random_layers; ++y) {
+						buffer.set_voxel(rng.rand() % 256, x, y, z, 0);
+					}
+				}
+			}
+		}
+	};
+
+	StdVector<VoxelBuffer> saved_buffers;
+	for (int i = 0; i < 8; ++i) {
+		VoxelBuffer &buffer = saved_buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		L::make_block(buffer, rng, 2);
+		VoxelStream::VoxelQueryData q{ buffer, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+	}
+
+	struct Check {
+		static void all_blocks(VoxelStreamRegionFiles &stream, const StdVector<VoxelBuffer> &expected_buffers) {
+			for (unsigned int i = 0; i < expected_buffers.size(); ++i) {
+				VoxelBuffer loaded_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+				loaded_buffer.create(block_size, block_size, block_size);
+				VoxelStream::VoxelQueryData q{ loaded_buffer, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+				stream.load_voxel_block(q);
+				ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+				ZN_TEST_ASSERT(loaded_buffer.equals(expected_buffers[i]));
+			}
+		}
+	};
+
+	Check::all_blocks(**stream, saved_buffers);
+
+	// Overwrite a block with one taking more sectors, which moves data around in the file. Reads must see the change.
+	L::make_block(saved_buffers[2], rng, block_size);
+	{
+		VoxelStream::VoxelQueryData q{ saved_buffers[2], Vector3i(2, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+	}
+
+	Check::all_blocks(**stream, saved_buffers);
+}
+
+void test_voxel_stream_region_files_async_reads() {
+	if (!ReadOnlyFile::is_supported()) {
+		return;
+	}
+
+	const int block_size_po2 = 4;
+	const int block_size = 1 << block_size_po2;
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	Ref<VoxelStreamRegionFiles> stream;
+	stream.instantiate();
+	stream->set_block_size_po2(block_size_po2);
+	stream->set_directory(test_dir.get_path());
+	stream->set_async_reads_enabled(true);
+	ZN_TEST_ASSERT(stream->supports_block_file_locations());
+
+	RandomPCG rng;
+
+	struct L {
+		static void make_block(VoxelBuffer &buffer, RandomPCG &rng) {
+			buffer.create(block_size, block_size, block_size);
+			buffer.fill(1, 0);
+			for (int z = 0; z < block_size; ++z) {
+				for (int x = 0; x < block_size; ++x) {
+					buffer.set_voxel(rng.rand() % 256, x, 0, z, 0);
+				}
+			}
+		}
+
+		static void read_completed(void *userdata, bool success) {
+			uint8_t *result = static_cast<uint8_t *>(userdata);
+			*result = success ? 1 : 0;
+		}
+	};
+
+	StdVector<VoxelBuffer> saved_buffers;
+	for (int i = 0; i < 8; ++i) {
+		VoxelBuffer &buffer = saved_buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		L::make_block(buffer, rng);
+		VoxelStream::VoxelQueryData q{ buffer, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+	}
+
+	{
+		VoxelStream::BlockFileLocation location;
+		ZN_TEST_ASSERT(
+				stream->get_voxel_block_file_location(Vector3i(0, 1, 0), 0, location) ==
+				VoxelStream::RESULT_BLOCK_NOT_FOUND
+		);
+	}
+
+	// Read with plain reads
+	StdVector<VoxelStream::BlockFileLocation> locations;
+	for (unsigned int i = 0; i < saved_buffers.size(); ++i) {
+		VoxelStream::BlockFileLocation &location = locations.emplace_back();
+		ZN_TEST_ASSERT(
+				stream->get_voxel_block_file_location(Vector3i(i, 0, 0), 0, location) ==
+				VoxelStream::RESULT_BLOCK_FOUND
+		);
+		ZN_TEST_ASSERT(location.file != nullptr);
+
+		StdVector<uint8_t> data;
+		data.resize(location.size);
+		ZN_TEST_ASSERT(location.file->read(location.offset, to_span(data)));
+
+		VoxelBuffer loaded_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		loaded_buffer.create(block_size, block_size, block_size);
+		ZN_TEST_ASSERT(
+				stream->decode_voxel_block(location, to_span_const(data), loaded_buffer) ==
+				VoxelStream::RESULT_BLOCK_FOUND
+		);
+		ZN_TEST_ASSERT(loaded_buffer.equals(saved_buffers[i]));
+	}
+
+	// Read all blocks at once with the asynchronous reader
+	AsyncFileReader reader;
+	if (reader.start(4)) {
+		StdVector<StdVector<uint8_t>> data;
+		StdVector<uint8_t> results;
+		data.resize(locations.size());
+		results.resize(locations.size(), 2);
+
+		for (unsigned int i = 0; i < locations.size(); ++i) {
+			const VoxelStream::BlockFileLocation &location = locations[i];
+			data[i].resize(location.size);
+			AsyncFileReader::Request request;
+			request.file = location.file;
+			request.offset = location.offset;
+			request.buffer = to_span(data[i]);
+			request.callback = L::read_completed;
+			request.userdata = &results[i];
+			reader.submit(std::move(request));
+		}
+
+		reader.wait_for_all_requests();
+		ZN_TEST_ASSERT(reader.get_pending_count() == 0);
+
+		for (unsigned int i = 0; i < locations.size(); ++i) {
+			ZN_TEST_ASSERT(results[i] == 1);
+			VoxelBuffer loaded_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+			loaded_buffer.create(block_size, block_size, block_size);
+			ZN_TEST_ASSERT(
+					stream->decode_voxel_block(locations[i], to_span_const(data[i]), loaded_buffer) ==
+					VoxelStream::RESULT_BLOCK_FOUND
+			);
+			ZN_TEST_ASSERT(loaded_buffer.equals(saved_buffers[i]));
+		}
+
+		reader.stop();
+	}
+
+	// Saving a block makes previously obtained locations outdated
+	{
+		const VoxelStream::BlockFileLocation &location = locations[2];
+		StdVector<uint8_t> data;
+		data.resize(location.size);
+		ZN_TEST_ASSERT(location.file->read(location.offset, to_span(data)));
+
+		VoxelStream::VoxelQueryData q{ saved_buffers[2], Vector3i(2, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+
+		VoxelBuffer loaded_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		loaded_buffer.create(block_size, block_size, block_size);
+		ZN_TEST_ASSERT(
+				stream->decode_voxel_block(location, to_span_const(data), loaded_buffer) == VoxelStream::RESULT_ERROR
+		);
+	}
+}
+
 } // namespace zylann::voxel::tests
@@ -5,6 +5,8 @@ namespace zylann::voxel::tests {
 
 void test_region_file();
 void test_voxel_stream_region_files();
+void test_voxel_stream_region_files_memory_mapped();
+void test_voxel_stream_region_files_async_reads();
 
 } // namespace zylann::voxel::tests
 
@@ -1,8 +1,11 @@
 #include "test_stream_sqlite.h"
+#include "../../streams/compressed_data.h"
 #include "../../streams/sqlite/block_location.h"
+#include "../../streams/sqlite/connection.h"
 #include "../../streams/sqlite/voxel_stream_sqlite.h"
 #include "../../util/containers/container_funcs.h"
 #include "../../util/godot/core/random_pcg.h"
+#include "../../util/godot/core/string.h"
 #include "../../util/math/conv.h"
 #include "../../util/math/vector3i.h"
 #include "../../util/profiling.h"
@@ -231,6 +234,285 @@ void test_voxel_stream_sqlite_coordinate_format() {
 	test_voxel_stream_sqlite_coordinate_format(VoxelStreamSQLite::COORDINATE_FORMAT_BLOB80_X25_Y25_Z25_L5);
 }
 
+void test_voxel_stream_sqlite_load_throughput() {
+	ZN_PROFILE_SCOPE();
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	const String database_path = test_dir.get_path().path_join("database.sqlite");
+
+	// About 10k blocks, which is roughly what a player teleporting somewhere needs to load
+	const Box3i region(Vector3i(-11, -10, -11), Vector3i(22, 21, 22));
+
+	struct L {
+		static unsigned int get_block_id(Vector3i bpos) {
+			return (bpos.x & 0xff) | ((bpos.y & 0xff) << 8);
+		}
+	};
+
+	// Populate database
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+
+		ProfilingClock pclock;
+
+		region.for_each_cell_zxy([&stream](Vector3i bpos) {
+			VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+			vb.create(Vector3iUtil::create(1 << constants::DEFAULT_BLOCK_SIZE_PO2));
+			vb.fill(L::get_block_id(bpos), 0);
+			vb.fill_area(1, Vector3i(0, 8, 0), Vector3i(16, 16, 16), 0);
+			VoxelStreamSQLite::VoxelQueryData q{ vb, bpos, 0, VoxelStreamSQLite::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		});
+
+		stream->flush();
+
+		const uint64_t elapsed_us = pclock.get_elapsed_microseconds();
+		ZN_PRINT_VERBOSE(format("Wrote {} blocks in {} us", Vector3iUtil::get_volume(region.size), elapsed_us));
+	}
+
+	// Cold loads, in batches similar to what streaming tasks request
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+
+		const unsigned int batch_size = 256;
+
+		StdVector<Vector3i> positions;
+		region.for_each_cell_zxy([&positions](Vector3i bpos) { positions.push_back(bpos); });
+
+		StdVector<VoxelBuffer> buffers;
+		buffers.reserve(batch_size);
+		for (unsigned int i = 0; i < batch_size; ++i) {
+			buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		}
+		StdVector<VoxelStreamSQLite::VoxelQueryData> queries;
+
+		ProfilingClock pclock;
+
+		for (unsigned int batch_begin = 0; batch_begin < positions.size(); batch_begin += batch_size) {
+			const unsigned int batch_end =
+					math::min(batch_begin + batch_size, static_cast<unsigned int>(positions.size()));
+
+			queries.clear();
+			for (unsigned int i = batch_begin; i < batch_end; ++i) {
+				queries.push_back(VoxelStreamSQLite::VoxelQueryData{
+						buffers[i - batch_begin], positions[i], 0, VoxelStreamSQLite::RESULT_ERROR });
+			}
+
+			stream->load_voxel_blocks(to_span(queries));
+
+			for (const VoxelStreamSQLite::VoxelQueryData &q : queries) {
+				ZN_TEST_ASSERT(q.result == VoxelStreamSQLite::RESULT_BLOCK_FOUND);
+				ZN_TEST_ASSERT(q.voxel_buffer.get_voxel(Vector3i(), 0) == L::get_block_id(q.position_in_blocks));
+			}
+		}
+
+		const uint64_t elapsed_us = pclock.get_elapsed_microseconds();
+		const uint64_t blocks_per_second = positions.size() * 1'000'000 / math::max(elapsed_us, uint64_t(1));
+		ZN_PRINT_VERBOSE(format(
+				"Cold loaded {} blocks in {} us ({} blocks/s)", positions.size(), elapsed_us, blocks_per_second
+		));
+	}
+}
+
+void test_voxel_stream_sqlite_compression_dictionary() {
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	const String database_path = test_dir.get_path().path_join("database.sqlite");
+
+	struct L {
+		static void make_block(VoxelBuffer &vb, int variant) {
+			vb.create(Vector3i(16, 16, 16));
+			vb.fill_area(1, Vector3i(0, 0, 0), Vector3i(16, 8 + variant % 4, 16), 0);
+			vb.fill_area(variant % 3 + 2, Vector3i(variant % 5, 2, 3), Vector3i(12, 6, 14), 0);
+		}
+	};
+
+	const int block_count = 16;
+
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+
+		// Blocks saved before training
+		for (int i = 0; i < block_count; ++i) {
+			VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+			L::make_block(vb, i);
+			VoxelStreamSQLite::VoxelQueryData q{ vb, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+
+		ZN_TEST_ASSERT(!stream->has_compression_dictionary());
+		ZN_TEST_ASSERT(stream->train_compression_dictionary(block_count, 4096));
+		ZN_TEST_ASSERT(stream->has_compression_dictionary());
+
+		// Blocks saved after training
+		for (int i = 0; i < block_count; ++i) {
+			VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+			L::make_block(vb, i + 1);
+			VoxelStreamSQLite::VoxelQueryData q{ vb, Vector3i(i, 1, 0), 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+
+		stream->flush();
+	}
+	{
+		// Reopen the database, dictionaries must be loaded back
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+
+		for (int i = 0; i < block_count; ++i) {
+			for (int y = 0; y < 2; ++y) {
+				VoxelBuffer expected_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				L::make_block(expected_vb, i + y);
+
+				VoxelBuffer loaded_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(i, y, 0), 0, VoxelStream::RESULT_ERROR };
+				stream->load_voxel_block(q);
+				ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+				ZN_TEST_ASSERT(loaded_vb.equals(expected_vb));
+			}
+		}
+
+		ZN_TEST_ASSERT(stream->has_compression_dictionary());
+	}
+	{
+		// Copy to another database, which must also get the dictionaries
+		const String copy_database_path = test_dir.get_path().path_join("database_copy.sqlite");
+		{
+			Ref<VoxelStreamSQLite> src_stream;
+			src_stream.instantiate();
+			src_stream->set_database_path(database_path);
+
+			Ref<VoxelStreamSQLite> dst_stream;
+			dst_stream.instantiate();
+			dst_stream->set_database_path(copy_database_path);
+
+			ZN_TEST_ASSERT(src_stream->copy_blocks_to_other_sqlite_stream(dst_stream));
+			ZN_TEST_ASSERT(dst_stream->has_compression_dictionary());
+		}
+		{
+			Ref<VoxelStreamSQLite> stream;
+			stream.instantiate();
+			stream->set_database_path(copy_database_path);
+
+			for (int y = 0; y < 2; ++y) {
+				VoxelBuffer expected_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				L::make_block(expected_vb, 3 + y);
+
+				VoxelBuffer loaded_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(3, y, 0), 0, VoxelStream::RESULT_ERROR };
+				stream->load_voxel_block(q);
+				ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+				ZN_TEST_ASSERT(loaded_vb.equals(expected_vb));
+			}
+		}
+	}
+}
+
+void test_voxel_stream_sqlite_compression_dictionary_retrain() {
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	const String database_path = test_dir.get_path().path_join("database.sqlite");
+
+	struct L {
+		static void make_block(VoxelBuffer &vb, int variant) {
+			vb.create(Vector3i(16, 16, 16));
+			vb.fill_area(1, Vector3i(0, 0, 0), Vector3i(16, 8 + variant % 4, 16), 0);
+			vb.fill_area(variant % 3 + 2, Vector3i(variant % 5, 2, 3), Vector3i(12, 6, 14), 0);
+		}
+
+		static void make_other_block(VoxelBuffer &vb, int variant) {
+			vb.create(Vector3i(16, 16, 16));
+			vb.fill_area(7, Vector3i(0, 4, 0), Vector3i(16, 16, 16), 0);
+			vb.fill_area(variant % 4 + 9, Vector3i(2, variant % 6, 1), Vector3i(5, 15, 16), 0);
+		}
+
+		static void save_blocks(VoxelStreamSQLite &stream, int count, int y, bool other) {
+			for (int i = 0; i < count; ++i) {
+				VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				if (other) {
+					make_other_block(vb, i);
+				} else {
+					make_block(vb, i + y);
+				}
+				VoxelStreamSQLite::VoxelQueryData q{ vb, Vector3i(i, y, 0), 0, VoxelStream::RESULT_ERROR };
+				stream.save_voxel_block(q);
+			}
+		}
+	};
+
+	const int block_count = 16;
+
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+
+		// Train on some blocks, then on different ones, then on the first ones again. Training only uses blocks
+		// at y=0, so the last dictionary is the same as the first, with the same ID.
+		L::save_blocks(**stream, block_count, 0, false);
+		ZN_TEST_ASSERT(stream->train_compression_dictionary(block_count, 4096));
+		L::save_blocks(**stream, block_count, 0, true);
+		ZN_TEST_ASSERT(stream->train_compression_dictionary(block_count, 4096));
+		L::save_blocks(**stream, block_count, 0, false);
+		ZN_TEST_ASSERT(stream->train_compression_dictionary(block_count, 4096));
+
+		// Compressed with the dictionary that was trained again
+		L::save_blocks(**stream, block_count, 1, false);
+
+		stream->flush();
+	}
+	{
+		// The dictionary trained last must be the current one after reopening, so it must be saved last
+		sqlite::Connection con;
+		ZN_TEST_ASSERT(con.open(
+				zylann::godot::to_std_string(database_path).c_str(), BlockLocation::FORMAT_INT64_X16_Y16_Z16_L16
+		));
+
+		StdVector<sqlite::Connection::CompressionDictionary> dictionaries;
+		ZN_TEST_ASSERT(con.load_compression_dictionaries(dictionaries));
+		ZN_TEST_ASSERT(dictionaries.size() == 2);
+
+		BlockLocation loc;
+		loc.position = Vector3i(0, 1, 0);
+		loc.lod = 0;
+		StdVector<uint8_t> block_data;
+		ZN_TEST_ASSERT(con.load_block(loc, block_data, sqlite::Connection::VOXELS) == VoxelStream::RESULT_BLOCK_FOUND);
+
+		uint32_t dictionary_id;
+		ZN_TEST_ASSERT(CompressedData::get_required_dictionary_id(to_span(block_data), dictionary_id));
+		ZN_TEST_ASSERT(dictionaries.back().id == dictionary_id);
+	}
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+
+		for (int i = 0; i < block_count; ++i) {
+			for (int y = 0; y < 2; ++y) {
+				VoxelBuffer expected_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				L::make_block(expected_vb, i + y);
+
+				VoxelBuffer loaded_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+				VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(i, y, 0), 0, VoxelStream::RESULT_ERROR };
+				stream->load_voxel_block(q);
+				ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+				ZN_TEST_ASSERT(loaded_vb.equals(expected_vb));
+			}
+		}
+	}
+}
+
 void test_voxel_stream_sqlite_key_string_csd_encoding(Vector3i pos, uint8_t lod_index, std::string_view expected) {
 	using namespace sqlite;
 
@@ -5,6 +5,9 @@ namespace zylann::voxel::tests {
 
 void test_voxel_stream_sqlite_basic();
 void test_voxel_stream_sqlite_coordinate_format();
+void test_voxel_stream_sqlite_compression_dictionary();
+void test_voxel_stream_sqlite_compression_dictionary_retrain();
+void test_voxel_stream_sqlite_load_throughput();
 void test_voxel_stream_sqlite_key_string_csd_encoding();
 void test_voxel_stream_sqlite_key_blob80_encoding();
 
@@ -0,0 +1,59 @@
+#include "test_voxel_a_star_grid_3d.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../terrain/fixed_lod/voxel_terrain.h"
+#include "../../terrain/voxel_a_star_grid_3d.h"
+#include "../../util/memory/memory.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_a_star_grid_3d_block_loading() {
+	static const int BLOCK_SIZE = 16;
+
+	struct L {
+		// Flat floor covering the whole block
+		static void load_floor_block(VoxelData &data, Vector3i bpos) {
+			std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+			voxels->create(Vector3iUtil::create(BLOCK_SIZE));
+			voxels->fill_area(1, Vector3i(), Vector3i(BLOCK_SIZE, 1, BLOCK_SIZE), VoxelBuffer::CHANNEL_TYPE);
+			ZN_TEST_ASSERT(data.try_set_block(bpos, VoxelDataBlock(voxels, 0)));
+		}
+	};
+
+	VoxelTerrain *terrain = memnew(VoxelTerrain);
+	VoxelData &data = terrain->get_storage();
+	ZN_TEST_ASSERT(data.get_block_size() == BLOCK_SIZE);
+
+	// Block (1, 0, 0) is not loaded yet, so there is no floor there
+	L::load_floor_block(data, Vector3i(0, 0, 0));
+	L::load_floor_block(data, Vector3i(0, 0, 1));
+	L::load_floor_block(data, Vector3i(1, 0, 1));
+
+	Ref<VoxelAStarGrid3D> astar;
+	astar.instantiate();
+	astar->set_terrain(terrain);
+	astar->set_region(Box3i(Vector3i(), Vector3i(2 * BLOCK_SIZE, 8, 2 * BLOCK_SIZE)));
+	astar->set_hierarchical_enabled(true);
+
+	const Vector3i from_position(2, 1, 4);
+	const Vector3i to_position_in_loaded_block(28, 1, 20);
+	const Vector3i to_position_in_new_block(28, 1, 4);
+
+	// Caches clusters next to the missing block
+	ZN_TEST_ASSERT(astar->find_path(from_position, to_position_in_loaded_block).size() > 0);
+	ZN_TEST_ASSERT(astar->find_path(from_position, to_position_in_new_block).size() == 0);
+
+	// Cached clusters around the block must be updated without having to clear the cache
+	L::load_floor_block(data, Vector3i(1, 0, 0));
+	ZN_TEST_ASSERT(astar->find_path(from_position, to_position_in_new_block).size() > 0);
+
+	data.unload_blocks(Box3i(Vector3i(1, 0, 0), Vector3i(1, 1, 1)), 0, nullptr);
+	ZN_TEST_ASSERT(astar->find_path(from_position, to_position_in_new_block).size() == 0);
+	ZN_TEST_ASSERT(astar->find_path(from_position, to_position_in_loaded_block).size() > 0);
+
+	astar.unref();
+	memdelete(terrain);
+}
+
+} // namespace zylann::voxel::tests
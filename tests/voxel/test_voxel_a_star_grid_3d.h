@@ -0,0 +1,10 @@
+#ifndef VOXEL_TESTS_VOXEL_A_STAR_GRID_3D_H
+#define VOXEL_TESTS_VOXEL_A_STAR_GRID_3D_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_a_star_grid_3d_block_loading();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_A_STAR_GRID_3D_H
@@ -0,0 +1,159 @@
+#include "test_voxel_box_mover.h"
+#include "../../meshers/cubes/voxel_mesher_cubes.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../terrain/fixed_lod/voxel_box_mover.h"
+#include "../../terrain/fixed_lod/voxel_terrain.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/memory/memory.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_box_mover_get_motions() {
+	static const int BLOCK_SIZE = 16;
+	static const int FLOOR_HEIGHT = 4;
+
+	struct L {
+		// Floor with a step of one voxel going along Z, and a wall too high to climb
+		static bool is_solid(Vector3i pos) {
+			if (pos.y < FLOOR_HEIGHT) {
+				return true;
+			}
+			if (pos.x >= 12 && pos.x < 14 && pos.y == FLOOR_HEIGHT) {
+				return true;
+			}
+			if (pos.x == 20 && pos.y < FLOOR_HEIGHT + 8) {
+				return true;
+			}
+			return false;
+		}
+	};
+
+	// Cubes are simpler to setup than blocky models, any non-zero color collides
+	Ref<VoxelMesherCubes> mesher;
+	mesher.instantiate();
+
+	VoxelTerrain *terrain = memnew(VoxelTerrain);
+	terrain->set_mesher(mesher);
+
+	VoxelData &data = terrain->get_storage();
+	ZN_TEST_ASSERT(data.get_block_size() == BLOCK_SIZE);
+
+	Vector3i bpos;
+	for (bpos.z = 0; bpos.z < 2; ++bpos.z) {
+		for (bpos.x = 0; bpos.x < 2; ++bpos.x) {
+			bpos.y = 0;
+			std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+			voxels->create(Vector3iUtil::create(BLOCK_SIZE));
+			Vector3i rpos;
+			for (rpos.z = 0; rpos.z < BLOCK_SIZE; ++rpos.z) {
+				for (rpos.x = 0; rpos.x < BLOCK_SIZE; ++rpos.x) {
+					for (rpos.y = 0; rpos.y < BLOCK_SIZE; ++rpos.y) {
+						if (L::is_solid(bpos * BLOCK_SIZE + rpos)) {
+							voxels->set_voxel(1, rpos, VoxelBuffer::CHANNEL_COLOR);
+						}
+					}
+				}
+			}
+			ZN_TEST_ASSERT(data.try_set_block(bpos, VoxelDataBlock(voxels, 0)));
+		}
+	}
+
+	const float FEET = FLOOR_HEIGHT + 0.01f;
+
+	// Some boxes overlap each other, or query overlapping areas
+	const Vector3 positions[] = {
+		Vector3(10.5, FEET, 5), // Walking into the step
+		Vector3(10.5, FEET, 5), // Same box as the previous one, moving differently
+		Vector3(10.8, FEET, 5.3), // Overlapping the previous ones
+		Vector3(18, FEET, 8), // Walking into the wall
+		Vector3(18.2, FEET, 8.5), // Next to the previous one
+		Vector3(25, FEET + 3, 25), // Falling on the floor
+		Vector3(2, FEET, 30.5), // Walking out of the loaded area
+		Vector3(28, FEET + 0.5f, 3), // Alone
+	};
+	const Vector3 motions[] = {
+		Vector3(3, -0.5, 0), //
+		Vector3(3, -0.5, 0.5), //
+		Vector3(2, -0.1, -0.2), //
+		Vector3(4, -0.2, 0), //
+		Vector3(3, -0.2, 1), //
+		Vector3(0, -5, 0), //
+		Vector3(-1, -0.1, 2), //
+		Vector3(0.5, -1, -0.5), //
+	};
+	const AABB aabbs[] = {
+		AABB(Vector3(-0.4, 0, -0.4), Vector3(0.8, 1.8, 0.8)),
+		AABB(Vector3(-0.3, 0, -0.3), Vector3(0.6, 1.5, 0.6)),
+		AABB(Vector3(-0.4, 0, -0.4), Vector3(0.8, 1.8, 0.8)),
+		AABB(Vector3(-0.5, 0, -0.5), Vector3(1.0, 1.0, 1.0)),
+		AABB(Vector3(-0.4, 0, -0.4), Vector3(0.8, 1.8, 0.8)),
+		AABB(Vector3(-0.4, 0, -0.4), Vector3(0.8, 1.8, 0.8)),
+		AABB(Vector3(-0.2, 0, -0.2), Vector3(0.4, 0.4, 0.4)),
+		AABB(Vector3(-0.4, 0, -0.4), Vector3(0.8, 1.8, 0.8)),
+	};
+	const unsigned int box_count = std::size(positions);
+	static_assert(std::size(motions) == std::size(positions));
+	static_assert(std::size(aabbs) == std::size(positions));
+
+	Ref<VoxelBoxMover> mover;
+	mover.instantiate();
+	mover->set_max_step_height(1.1f);
+
+	for (unsigned int config = 0; config < 8; ++config) {
+		const bool step_climbing = (config & 1) != 0;
+		const bool threaded = (config & 2) != 0;
+		const bool single_aabb = (config & 4) != 0;
+
+		mover->set_step_climbing_enabled(step_climbing);
+		mover->set_threaded_batches_enabled(threaded);
+
+		const Span<const AABB> batch_aabbs(aabbs, single_aabb ? 1 : box_count);
+
+		StdVector<Vector3> batch_motions;
+		batch_motions.resize(box_count);
+		mover->get_motions(
+				Span<const Vector3>(positions, box_count),
+				Span<const Vector3>(motions, box_count),
+				batch_aabbs,
+				*terrain,
+				to_span(batch_motions)
+		);
+
+		StdVector<uint8_t> batch_stepped_up;
+		for (unsigned int i = 0; i < box_count; ++i) {
+			batch_stepped_up.push_back(mover->has_stepped_up_in_batch(i));
+		}
+
+		unsigned int blocked_count = 0;
+		unsigned int stepped_up_count = 0;
+
+		for (unsigned int i = 0; i < box_count; ++i) {
+			const AABB aabb = single_aabb ? aabbs[0] : aabbs[i];
+			const Vector3 expected_motion = mover->get_motion(positions[i], motions[i], aabb, *terrain);
+
+			ZN_TEST_ASSERT(batch_motions[i].is_equal_approx(expected_motion));
+			ZN_TEST_ASSERT((batch_stepped_up[i] != 0) == mover->has_stepped_up());
+
+			if (!expected_motion.is_equal_approx(motions[i])) {
+				++blocked_count;
+			}
+			if (mover->has_stepped_up()) {
+				++stepped_up_count;
+			}
+		}
+
+		// Make sure the terrain actually got in the way
+		ZN_TEST_ASSERT(blocked_count > 0);
+		if (step_climbing) {
+			ZN_TEST_ASSERT(stepped_up_count > 0);
+		} else {
+			ZN_TEST_ASSERT(stepped_up_count == 0);
+		}
+	}
+
+	memdelete(terrain);
+}
+
+} // namespace zylann::voxel::tests
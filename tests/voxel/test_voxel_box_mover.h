@@ -0,0 +1,10 @@
+#ifndef VOXEL_TESTS_VOXEL_BOX_MOVER_H
+#define VOXEL_TESTS_VOXEL_BOX_MOVER_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_box_mover_get_motions();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_BOX_MOVER_H
@@ -3,6 +3,8 @@
 #include "../../storage/metadata/voxel_metadata_variant.h"
 #include "../../storage/voxel_buffer_gd.h"
 #include "../../streams/voxel_block_serializer.h"
+#include "../../util/io/log.h"
+#include "../../util/string/format.h"
 #include "../../util/string/std_stringstream.h"
 #include "../testing.h"
 #include <sstream>
@@ -378,4 +380,173 @@ void test_voxel_buffer_paste_masked() {
 	ZN_TEST_ASSERT(dst.equals(expected));
 }
 
+void test_voxel_buffer_palette() {
+	const Vector3i size(16, 16, 16);
+	const unsigned int channel = VoxelBuffer::CHANNEL_TYPE;
+
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(size);
+	ZN_TEST_ASSERT(vb.get_channel_depth(channel) == VoxelBuffer::DEPTH_16_BIT);
+
+	// A few distinct values, in layers
+	const uint64_t values[] = { 0, 1000, 2, 60000, 7 };
+	const unsigned int value_count = 5;
+	Vector3i pos;
+	for (pos.z = 0; pos.z < size.z; ++pos.z) {
+		for (pos.x = 0; pos.x < size.x; ++pos.x) {
+			for (pos.y = 0; pos.y < size.y; ++pos.y) {
+				vb.set_voxel(values[(pos.y + pos.x / 8) % value_count], pos, channel);
+			}
+		}
+	}
+
+	VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.copy_to(expected, false);
+
+	vb.compress_palette_channels();
+	ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_PALETTE);
+
+	struct L {
+		static bool channel_equals(const VoxelBuffer &a, const VoxelBuffer &b, unsigned int channel) {
+			Vector3i pos;
+			for (pos.z = 0; pos.z < a.get_size().z; ++pos.z) {
+				for (pos.x = 0; pos.x < a.get_size().x; ++pos.x) {
+					for (pos.y = 0; pos.y < a.get_size().y; ++pos.y) {
+						if (a.get_voxel(pos, channel) != b.get_voxel(pos, channel)) {
+							return false;
+						}
+					}
+				}
+			}
+			return true;
+		}
+	};
+
+	ZN_TEST_ASSERT(L::channel_equals(vb, expected, channel));
+
+	// Comparison is based on values, not on how they are stored
+	ZN_TEST_ASSERT(vb.equals(expected));
+	ZN_TEST_ASSERT(expected.equals(vb));
+
+	// Read-only raw access decodes into a temporary buffer without modifying the source
+	{
+		StdVector<uint8_t> decoded;
+		Span<const uint16_t> data;
+		ZN_TEST_ASSERT(vb.get_channel_data_read_only(channel, data, decoded));
+		ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_PALETTE);
+		Span<const uint16_t> expected_data;
+		ZN_TEST_ASSERT(expected.get_channel_data_read_only(channel, expected_data));
+		ZN_TEST_ASSERT(data.size() == expected_data.size());
+		for (unsigned int i = 0; i < data.size(); ++i) {
+			ZN_TEST_ASSERT(data[i] == expected_data[i]);
+		}
+	}
+
+	// Adding values should widen indices while staying compressed
+	for (unsigned int i = 0; i < 20; ++i) {
+		const Vector3i p(i % size.x, 3, 5);
+		const uint64_t v = 100 + i;
+		vb.set_voxel(v, p, channel);
+		expected.set_voxel(v, p, channel);
+	}
+	ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_PALETTE);
+	ZN_TEST_ASSERT(L::channel_equals(vb, expected, channel));
+
+	// Region copies from a palette channel
+	{
+		VoxelBuffer dst(VoxelBuffer::ALLOCATOR_DEFAULT);
+		dst.create(Vector3i(8, 8, 8));
+		dst.copy_channel_from(vb, Vector3i(4, 2, 3), Vector3i(12, 10, 11), Vector3i(), channel);
+		for (pos.z = 0; pos.z < 8; ++pos.z) {
+			for (pos.x = 0; pos.x < 8; ++pos.x) {
+				for (pos.y = 0; pos.y < 8; ++pos.y) {
+					ZN_TEST_ASSERT(dst.get_voxel(pos, channel) == expected.get_voxel(pos + Vector3i(4, 2, 3), channel));
+				}
+			}
+		}
+	}
+
+	// Serialized blocks must be identical to the uncompressed version
+	{
+		BlockSerializer::SerializeResult sresult = BlockSerializer::serialize(vb);
+		ZN_TEST_ASSERT(sresult.success);
+		StdVector<uint8_t> bytes = sresult.data;
+
+		VoxelBuffer rvb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		ZN_TEST_ASSERT(BlockSerializer::deserialize(to_span(bytes), rvb));
+		ZN_TEST_ASSERT(rvb.equals(expected));
+	}
+
+	// Going past the maximum palette size decompresses the channel
+	for (unsigned int i = 0; i < VoxelBuffer::MAX_PALETTE_SIZE; ++i) {
+		const Vector3i p(i % size.x, (i / size.x) % size.y, 9);
+		const uint64_t v = 10000 + i;
+		vb.set_voxel(v, p, channel);
+		expected.set_voxel(v, p, channel);
+	}
+	ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_NONE);
+	ZN_TEST_ASSERT(vb.equals(expected));
+
+	// Explicit decompression
+	vb.compress_palette_channels();
+	ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_NONE);
+	vb.fill_area(5, Vector3i(), Vector3i(16, 9, 16), channel);
+	vb.fill_area(6, Vector3i(0, 9, 0), size, channel);
+	vb.compress_palette_channels();
+	ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_PALETTE);
+	ZN_TEST_ASSERT(!vb.is_uniform(channel));
+	vb.decompress_channel(channel);
+	ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_NONE);
+	ZN_TEST_ASSERT(vb.get_voxel(Vector3i(3, 8, 3), channel) == 5);
+	ZN_TEST_ASSERT(vb.get_voxel(Vector3i(3, 9, 3), channel) == 6);
+}
+
+void test_voxel_buffer_palette_memory_usage() {
+	// Blocky terrain block crossing the surface, like a generator would output
+	static const int BLOCK_SIZE = 16;
+	const unsigned int channel = VoxelBuffer::CHANNEL_TYPE;
+	const uint64_t AIR = 0;
+	const uint64_t GRASS = 1;
+	const uint64_t DIRT = 2;
+	const uint64_t STONE = 3;
+
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(Vector3iUtil::create(BLOCK_SIZE));
+	Vector3i pos;
+	for (pos.z = 0; pos.z < BLOCK_SIZE; ++pos.z) {
+		for (pos.x = 0; pos.x < BLOCK_SIZE; ++pos.x) {
+			const int height = 8 + static_cast<int>(4.f * Math::sin(pos.x * 0.4f) * Math::cos(pos.z * 0.3f));
+			for (pos.y = 0; pos.y < BLOCK_SIZE; ++pos.y) {
+				uint64_t v = AIR;
+				if (pos.y < height - 3) {
+					v = STONE;
+				} else if (pos.y < height - 1) {
+					v = DIRT;
+				} else if (pos.y < height) {
+					v = GRASS;
+				}
+				vb.set_voxel(v, pos, channel);
+			}
+		}
+	}
+
+	VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.copy_to(expected, false);
+
+	const size_t size_before = vb.get_channels_size_in_bytes();
+	vb.compress_palette_channels();
+	const size_t size_after = vb.get_channels_size_in_bytes();
+
+	ZN_PRINT_VERBOSE(
+			format("VoxelBuffer palette compression: {} bytes before, {} bytes after", size_before, size_after)
+	);
+
+	// 16-bit values become 2-bit indices
+	ZN_TEST_ASSERT(vb.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_PALETTE);
+	ZN_TEST_ASSERT(size_after * 4 < size_before);
+
+	vb.decompress_channel(channel);
+	ZN_TEST_ASSERT(vb.equals(expected));
+}
+
 } // namespace zylann::voxel::tests
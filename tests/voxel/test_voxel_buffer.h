@@ -7,6 +7,8 @@ void test_voxel_buffer_create();
 void test_voxel_buffer_metadata();
 void test_voxel_buffer_metadata_gd();
 void test_voxel_buffer_paste_masked();
+void test_voxel_buffer_palette();
+void test_voxel_buffer_palette_memory_usage();
 
 } // namespace zylann::voxel::tests
 
@@ -1,6 +1,9 @@
 #include "test_voxel_data_map.h"
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_data_map.h"
+#include "../../util/containers/std_unordered_map.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
 #include "../testing.h"
 
 namespace zylann::voxel::tests {
@@ -162,4 +165,203 @@ void test_voxel_data_map_copy() {
 	ZN_TEST_ASSERT(buffer.equals(buffer2));
 }
 
+namespace {
+
+// The container VoxelDataMap used before, for comparison
+typedef StdUnorderedMap<Vector3i, VoxelDataBlock> ReferenceMap;
+
+struct DataMapBenchmark {
+	static void insert(VoxelDataMap &map, const Box3i &box) {
+		box.for_each_cell_zxy([&map](Vector3i bpos) { map.set_empty_block(bpos, false); });
+	}
+	static void insert(ReferenceMap &map, const Box3i &box) {
+		box.for_each_cell_zxy([&map](Vector3i bpos) { map.insert({ bpos, VoxelDataBlock(0) }); });
+	}
+	static void remove(VoxelDataMap &map, const Box3i &box) {
+		box.for_each_cell_zxy([&map](Vector3i bpos) { map.remove_block(bpos, VoxelDataMap::NoAction()); });
+	}
+	static void remove(ReferenceMap &map, const Box3i &box) {
+		box.for_each_cell_zxy([&map](Vector3i bpos) { map.erase(bpos); });
+	}
+	static unsigned int count_found(const VoxelDataMap &map, const Box3i &box) {
+		unsigned int count = 0;
+		box.for_each_cell_zxy([&map, &count](Vector3i bpos) {
+			if (map.get_block(bpos) != nullptr) {
+				++count;
+			}
+		});
+		return count;
+	}
+	static unsigned int count_found(const ReferenceMap &map, const Box3i &box) {
+		unsigned int count = 0;
+		box.for_each_cell_zxy([&map, &count](Vector3i bpos) {
+			if (map.find(bpos) != map.end()) {
+				++count;
+			}
+		});
+		return count;
+	}
+	static unsigned int get_size(const VoxelDataMap &map) {
+		return map.get_block_count();
+	}
+	static unsigned int get_size(const ReferenceMap &map) {
+		return map.size();
+	}
+	static unsigned int count_iterated(const VoxelDataMap &map) {
+		unsigned int count = 0;
+		map.for_each_block([&count](Vector3i bpos, const VoxelDataBlock &block) {
+			if (!block.has_voxels()) {
+				++count;
+			}
+		});
+		return count;
+	}
+	static unsigned int count_iterated(const ReferenceMap &map) {
+		unsigned int count = 0;
+		for (auto it = map.begin(); it != map.end(); ++it) {
+			if (!it->second.has_voxels()) {
+				++count;
+			}
+		}
+		return count;
+	}
+
+	template <typename TMap>
+	static void run(TMap &map, const char *name) {
+		// Blocks around a viewer, which then moves along X, unloading blocks behind and loading blocks ahead
+		const Box3i box(Vector3i(-32, -8, -32), Vector3i(64, 16, 64));
+		const unsigned int block_count = Vector3iUtil::get_volume(box.size);
+		const unsigned int lookup_iterations = 10;
+		const unsigned int churn_steps = 64;
+
+		ProfilingClock pclock;
+
+		insert(map, box);
+		const uint64_t insert_us = pclock.restart();
+
+		unsigned int found_count = 0;
+		for (unsigned int i = 0; i < lookup_iterations; ++i) {
+			found_count += count_found(map, box);
+			// Half of these are missing
+			found_count += count_found(map, Box3i(box.position + Vector3i(box.size.x / 2, 0, 0), box.size));
+		}
+		const uint64_t lookup_us = pclock.restart();
+		ZN_TEST_ASSERT(found_count == lookup_iterations * (block_count + block_count / 2));
+
+		unsigned int iterated_count = 0;
+		for (unsigned int i = 0; i < lookup_iterations; ++i) {
+			iterated_count += count_iterated(map);
+		}
+		const uint64_t iteration_us = pclock.restart();
+		ZN_TEST_ASSERT(iterated_count == lookup_iterations * block_count);
+
+		Box3i moving_box = box;
+		const Vector3i slab_size(1, box.size.y, box.size.z);
+		for (unsigned int i = 0; i < churn_steps; ++i) {
+			remove(map, Box3i(moving_box.position, slab_size));
+			insert(map, Box3i(moving_box.position + Vector3i(moving_box.size.x, 0, 0), slab_size));
+			moving_box.position.x += 1;
+		}
+		const uint64_t churn_us = pclock.restart();
+		ZN_TEST_ASSERT(get_size(map) == block_count);
+		ZN_TEST_ASSERT(count_found(map, moving_box) == block_count);
+
+		ZN_PRINT_VERBOSE(
+				format("{} with {} blocks: insert {} us, lookup {} us, iteration {} us, insert/erase churn {} us",
+					   name,
+					   block_count,
+					   insert_us,
+					   lookup_us,
+					   iteration_us,
+					   churn_us)
+		);
+	}
+};
+
+} // namespace
+
+void test_voxel_data_map_benchmark() {
+	VoxelDataMap map;
+	map.create(0);
+	DataMapBenchmark::run(map, "VoxelDataMap");
+
+	ReferenceMap reference_map;
+	DataMapBenchmark::run(reference_map, "StdUnorderedMap");
+}
+
+void test_voxel_data_map_block_handles() {
+	VoxelDataMap map;
+	map.create(0);
+
+	VoxelDataBlock *block1 = map.set_empty_block(Vector3i(1, 2, 3), false);
+	VoxelDataMap::BlockHandle handle1;
+	ZN_TEST_ASSERT(map.try_get_block_handle(Vector3i(1, 2, 3), handle1));
+	ZN_TEST_ASSERT(map.get_block(handle1) == block1);
+
+	// Adding many blocks must not move existing ones
+	const Box3i box(Vector3i(-20, -20, -20), Vector3i(40, 40, 40));
+	box.for_each_cell_zxy([&map](Vector3i bpos) { map.set_empty_block(bpos, false); });
+	ZN_TEST_ASSERT(map.get_block(Vector3i(1, 2, 3)) == block1);
+	ZN_TEST_ASSERT(map.get_block(handle1) == block1);
+	ZN_TEST_ASSERT(map.get_block_count() == int(Vector3iUtil::get_volume(box.size)));
+
+	// Handles of removed blocks must not find blocks added afterward, even if they reuse the same storage
+	map.remove_block(Vector3i(1, 2, 3), VoxelDataMap::NoAction());
+	ZN_TEST_ASSERT(map.get_block(handle1) == nullptr);
+	ZN_TEST_ASSERT(map.get_block(Vector3i(1, 2, 3)) == nullptr);
+	map.set_empty_block(Vector3i(100, 0, 0), false);
+	ZN_TEST_ASSERT(map.get_block(handle1) == nullptr);
+
+	unsigned int count = 0;
+	map.for_each_block_position([&count, &box](Vector3i bpos) {
+		ZN_TEST_ASSERT(box.contains(bpos) || bpos == Vector3i(100, 0, 0));
+		++count;
+	});
+	ZN_TEST_ASSERT(int(count) == map.get_block_count());
+}
+
+void test_voxel_data_map_remove_most_blocks() {
+	VoxelDataMap map;
+	map.create(0);
+
+	const Box3i box(Vector3i(-20, -20, -20), Vector3i(40, 40, 40));
+	box.for_each_cell_zxy([&map](Vector3i bpos) { map.set_empty_block(bpos, false); });
+
+	const Vector3i kept_pos = box.position;
+	VoxelDataBlock *kept_block = map.get_block(kept_pos);
+	VoxelDataMap::BlockHandle kept_handle;
+	ZN_TEST_ASSERT(map.try_get_block_handle(kept_pos, kept_handle));
+
+	// Added last, so it is stored at the end
+	const Vector3i removed_pos = box.position + box.size - Vector3i(1, 1, 1);
+	VoxelDataMap::BlockHandle removed_handle;
+	ZN_TEST_ASSERT(map.try_get_block_handle(removed_pos, removed_handle));
+
+	// Removing most blocks shrinks storage, remaining blocks must not move
+	box.for_each_cell_zxy([&map, kept_pos](Vector3i bpos) {
+		if (bpos != kept_pos) {
+			map.remove_block(bpos, VoxelDataMap::NoAction());
+		}
+	});
+	ZN_TEST_ASSERT(map.get_block_count() == 1);
+	ZN_TEST_ASSERT(map.get_block(kept_pos) == kept_block);
+	ZN_TEST_ASSERT(map.get_block(kept_handle) == kept_block);
+	ZN_TEST_ASSERT(map.get_block(removed_pos) == nullptr);
+	ZN_TEST_ASSERT(map.get_block(removed_handle) == nullptr);
+
+	// Adding blocks again grows storage back. Handles of removed blocks must still not find anything.
+	box.for_each_cell_zxy([&map](Vector3i bpos) { map.set_empty_block(bpos, false); });
+	ZN_TEST_ASSERT(map.get_block_count() == int(Vector3iUtil::get_volume(box.size)));
+	ZN_TEST_ASSERT(map.get_block(kept_handle) == kept_block);
+	ZN_TEST_ASSERT(map.get_block(removed_handle) == nullptr);
+
+	unsigned int count = 0;
+	map.for_each_block_position([&count, &map, &box](Vector3i bpos) {
+		ZN_TEST_ASSERT(box.contains(bpos));
+		ZN_TEST_ASSERT(map.has_block(bpos));
+		++count;
+	});
+	ZN_TEST_ASSERT(int(count) == map.get_block_count());
+}
+
 } // namespace zylann::voxel::tests
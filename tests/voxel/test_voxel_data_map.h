@@ -6,6 +6,9 @@ namespace zylann::voxel::tests {
 void test_voxel_data_map_paste_fill();
 void test_voxel_data_map_paste_mask();
 void test_voxel_data_map_copy();
+void test_voxel_data_map_block_handles();
+void test_voxel_data_map_remove_most_blocks();
+void test_voxel_data_map_benchmark();
 
 } // namespace zylann::voxel::tests
 
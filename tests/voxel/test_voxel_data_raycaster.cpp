@@ -0,0 +1,202 @@
+#include "test_voxel_data_raycaster.h"
+#include "../../edition/voxel_data_raycaster.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../util/math/conv.h"
+#include "../../util/memory/memory.h"
+#include "../../util/voxel_raycast.h"
+#include "../testing.h"
+
+#include <random>
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+// Sparse pseudo-random voxels, with empty regions
+bool is_test_voxel_solid(Vector3i pos) {
+	if (pos.y > 20 || pos.y < -30 || (pos.x >= 40 && pos.x < 48)) {
+		return false;
+	}
+	const uint32_t h = (uint32_t(pos.x) * 73856093u) ^ (uint32_t(pos.y) * 19349663u) ^ (uint32_t(pos.z) * 83492791u);
+	return (h % 97) == 0;
+}
+
+Vector3 get_random_direction(std::mt19937 &rng, unsigned int i) {
+	std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+	Vector3 d;
+	do {
+		d = Vector3(distribution(rng), distribution(rng), distribution(rng));
+		// Axis-aligned and planar rays are edge cases
+		if (i % 7 == 0) {
+			d.y = 0;
+		}
+		if (i % 11 == 0) {
+			d.x = 0;
+			d.z = 0;
+		}
+	} while (d.length_squared() < 0.01f);
+	return d.normalized();
+}
+
+} // namespace
+
+void test_voxel_raycast_hierarchical() {
+	// Must hit exactly the same voxels as the regular raycast
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position_distribution(-60.f, 60.f);
+
+	for (unsigned int cell_size_po2 = 0; cell_size_po2 <= 4; ++cell_size_po2) {
+		const int cell_size = 1 << cell_size_po2;
+
+		for (unsigned int i = 0; i < 2000; ++i) {
+			Vector3 origin(position_distribution(rng), position_distribution(rng), position_distribution(rng));
+			if (i % 5 == 0) {
+				// Integer coordinates are edge cases
+				origin = origin.floor();
+			}
+			const Vector3 direction = get_random_direction(rng, i);
+
+			struct Predicate {
+				bool operator()(const VoxelRaycastState &rs) const {
+					return is_test_voxel_solid(rs.hit_position);
+				}
+			};
+
+			Vector3i expected_hit_pos;
+			Vector3i expected_prev_pos;
+			float expected_distance;
+			float expected_prev_distance;
+			const bool expected_hit = voxel_raycast(
+					origin,
+					direction,
+					Predicate(),
+					80.f,
+					expected_hit_pos,
+					expected_prev_pos,
+					expected_distance,
+					expected_prev_distance
+			);
+
+			Vector3i hit_pos;
+			Vector3i prev_pos;
+			float distance;
+			float prev_distance;
+			const bool hit = voxel_raycast_hierarchical(
+					origin,
+					direction,
+					cell_size_po2,
+					[cell_size_po2, cell_size](Vector3i cell_pos) {
+						const Box3i box(cell_pos << cell_size_po2, Vector3iUtil::create(cell_size));
+						return !box.all_cells_match([](Vector3i pos) { return !is_test_voxel_solid(pos); });
+					},
+					Predicate(),
+					80.f,
+					hit_pos,
+					prev_pos,
+					distance,
+					prev_distance
+			);
+
+			ZN_TEST_ASSERT(hit == expected_hit);
+			if (hit) {
+				ZN_TEST_ASSERT(hit_pos == expected_hit_pos);
+				ZN_TEST_ASSERT(prev_pos == expected_prev_pos);
+				ZN_TEST_ASSERT(Math::is_equal_approx(distance, expected_distance, 0.001f));
+				ZN_TEST_ASSERT(Math::is_equal_approx(prev_distance, expected_prev_distance, 0.001f));
+			}
+		}
+	}
+}
+
+void test_voxel_data_raycaster() {
+	VoxelData data;
+	data.set_bounds(Box3i(Vector3iUtil::create(-5000), Vector3iUtil::create(10000)));
+	data.set_streaming_enabled(true);
+
+	const int block_size = data.get_block_size();
+
+	// Some blocks are missing, some are uniformly empty, others have sparse voxels
+	const Box3i blocks_box(Vector3i(-4, -4, -4), Vector3i(8, 8, 8));
+	blocks_box.for_each_cell_zxy([&data, block_size](Vector3i bpos) {
+		if (((bpos.x + bpos.y + bpos.z) % 5) == 0) {
+			return;
+		}
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(block_size));
+		buffer->fill_f(1.f, VoxelBuffer::CHANNEL_SDF);
+		if ((bpos.x & 1) == 0) {
+			const Vector3i origin = bpos * block_size;
+			Vector3i rpos;
+			for (rpos.z = 0; rpos.z < block_size; ++rpos.z) {
+				for (rpos.x = 0; rpos.x < block_size; ++rpos.x) {
+					for (rpos.y = 0; rpos.y < block_size; ++rpos.y) {
+						if (is_test_voxel_solid(origin + rpos)) {
+							buffer->set_voxel_f(-1.f, rpos, VoxelBuffer::CHANNEL_SDF);
+						}
+					}
+				}
+			}
+		}
+		VoxelDataBlock block(buffer, 0);
+		block.set_edited(true);
+		ZN_TEST_ASSERT(data.try_set_block(bpos, block));
+	});
+
+	struct Predicate {
+		const VoxelData &data;
+
+		bool operator()(const VoxelRaycastState &rs) const {
+			return data.get_voxel_f(rs.hit_position, VoxelBuffer::CHANNEL_SDF) < 0.f;
+		}
+	};
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> position_distribution(-70.f, 70.f);
+
+	VoxelDataRaycaster raycaster(data, VoxelDataRaycaster::MODE_SDF, false);
+	// Reused across rays, like `raycast_many` does
+	VoxelDataRaycaster raycaster_with_occupancy(data, VoxelDataRaycaster::MODE_SDF, true);
+
+	unsigned int hit_count = 0;
+
+	for (unsigned int i = 0; i < 2000; ++i) {
+		const Vector3 origin(position_distribution(rng), position_distribution(rng), position_distribution(rng));
+		const Vector3 direction = get_random_direction(rng, i);
+		const float max_distance = 100.f;
+
+		Vector3i expected_hit_pos;
+		Vector3i expected_prev_pos;
+		float expected_distance;
+		float expected_prev_distance;
+		const bool expected_hit = voxel_raycast(
+				origin,
+				direction,
+				Predicate{ data },
+				max_distance,
+				expected_hit_pos,
+				expected_prev_pos,
+				expected_distance,
+				expected_prev_distance
+		);
+
+		VoxelDataRaycaster::Hit hit;
+		ZN_TEST_ASSERT(raycaster.raycast(origin, direction, max_distance, hit) == expected_hit);
+		if (expected_hit) {
+			++hit_count;
+			ZN_TEST_ASSERT(hit.position == expected_hit_pos);
+			ZN_TEST_ASSERT(hit.previous_position == expected_prev_pos);
+		}
+
+		ZN_TEST_ASSERT(raycaster_with_occupancy.raycast(origin, direction, max_distance, hit) == expected_hit);
+		if (expected_hit) {
+			ZN_TEST_ASSERT(hit.position == expected_hit_pos);
+			ZN_TEST_ASSERT(hit.previous_position == expected_prev_pos);
+		}
+	}
+
+	// Make sure the test actually tests something
+	ZN_TEST_ASSERT(hit_count > 0);
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,11 @@
+#ifndef VOXEL_TEST_VOXEL_DATA_RAYCASTER_H
+#define VOXEL_TEST_VOXEL_DATA_RAYCASTER_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_raycast_hierarchical();
+void test_voxel_data_raycaster();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TEST_VOXEL_DATA_RAYCASTER_H
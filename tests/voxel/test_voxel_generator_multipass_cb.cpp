@@ -0,0 +1,236 @@
+#include "test_voxel_generator_multipass_cb.h"
+#include "../../engine/voxel_engine.h"
+#include "../../generators/multipass/generate_column_multipass_task.h"
+#include "../../generators/multipass/voxel_generator_multipass_cb.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../../util/math/box2i.h"
+#include "../../util/math/box3i.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+using namespace VoxelGeneratorMultipassCBStructs;
+
+// Generates hilly ground in the first pass, and plants trees in the second pass. Trees can overlap neighbor columns.
+// Voxels are only ever replaced by higher values, so the result doesn't depend on the order columns are processed.
+class TestTreeMultipassGenerator : public VoxelGeneratorMultipassCB {
+public:
+	static const int GROUND = 1;
+	static const int WOOD = 2;
+	static const int LEAVES = 3;
+
+	static const int TREES_PER_COLUMN = 4;
+	static const int TRUNK_HEIGHT = 6;
+	static const int LEAVES_RADIUS = 2;
+
+	static int get_ground_height(int x, int z) {
+		return 4 + static_cast<int>(6.f * Math::sin(x * 0.05f) * Math::cos(z * 0.07f));
+	}
+
+	void generate_pass(PassInput input) override {
+		if (input.pass_index == 0) {
+			generate_ground(input);
+		} else {
+			generate_trees(input);
+		}
+	}
+
+private:
+	static void generate_ground(PassInput input) {
+		const int bs = input.block_size;
+		// First pass has no neighbors, the grid is only the main column
+		for (int block_index = 0; block_index < input.grid_size.y; ++block_index) {
+			VoxelBuffer &voxels = input.grid[block_index]->voxels;
+			const Vector3i origin = (input.main_block_position + Vector3i(0, block_index, 0)) * bs;
+
+			for (int z = 0; z < bs; ++z) {
+				for (int x = 0; x < bs; ++x) {
+					const int height = get_ground_height(origin.x + x, origin.z + z) - origin.y;
+					voxels.fill_area(
+							GROUND,
+							Vector3i(x, 0, z),
+							Vector3i(x + 1, math::clamp(height, 0, bs), z + 1),
+							VoxelBuffer::CHANNEL_TYPE
+					);
+				}
+			}
+		}
+	}
+
+	static void set_voxel_max(PassInput &input, Vector3i pos, int v) {
+		const Vector3i block_pos = math::floordiv(pos, input.block_size);
+		const Vector3i grid_pos = block_pos - input.grid_origin;
+		if (!Box3i(Vector3i(), input.grid_size).contains(grid_pos)) {
+			return;
+		}
+		VoxelBuffer &voxels = input.grid[Vector3iUtil::get_zxy_index(grid_pos, input.grid_size)]->voxels;
+		const Vector3i rpos = pos - block_pos * input.block_size;
+		if (int(voxels.get_voxel(rpos, VoxelBuffer::CHANNEL_TYPE)) < v) {
+			voxels.set_voxel(v, rpos, VoxelBuffer::CHANNEL_TYPE);
+		}
+	}
+
+	static void generate_trees(PassInput input) {
+		const int bs = input.block_size;
+		const Vector3i column_origin = input.main_block_position * bs;
+
+		RandomPCG rng;
+		rng.seed((uint64_t(uint32_t(input.main_block_position.x)) << 32) | uint32_t(input.main_block_position.z));
+
+		for (int tree_index = 0; tree_index < TREES_PER_COLUMN; ++tree_index) {
+			const int x = column_origin.x + rng.rand(bs);
+			const int z = column_origin.z + rng.rand(bs);
+			const int ground_y = get_ground_height(x, z);
+
+			for (int y = ground_y; y < ground_y + TRUNK_HEIGHT; ++y) {
+				set_voxel_max(input, Vector3i(x, y, z), WOOD);
+			}
+
+			const Vector3i top(x, ground_y + TRUNK_HEIGHT, z);
+			Vector3i rpos;
+			for (rpos.z = -LEAVES_RADIUS; rpos.z <= LEAVES_RADIUS; ++rpos.z) {
+				for (rpos.x = -LEAVES_RADIUS; rpos.x <= LEAVES_RADIUS; ++rpos.x) {
+					for (rpos.y = -LEAVES_RADIUS; rpos.y <= LEAVES_RADIUS; ++rpos.y) {
+						set_voxel_max(input, top + rpos, LEAVES);
+					}
+				}
+			}
+		}
+	}
+};
+
+// Stands for a block request, gets scheduled when its column is complete
+class ColumnRequestTask : public IThreadedTask {
+public:
+	ColumnRequestTask(std::shared_ptr<std::atomic_int> p_completed_count) : _completed_count(p_completed_count) {}
+
+	const char *get_debug_name() const override {
+		return "ColumnRequestTask";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		++(*_completed_count);
+	}
+
+private:
+	std::shared_ptr<std::atomic_int> _completed_count;
+};
+
+} // namespace
+
+void test_voxel_generator_multipass_cb_benchmark() {
+	static const int AREA_SIZE_COLUMNS = 32;
+	static const int BLOCK_SIZE = 1 << constants::DEFAULT_BLOCK_SIZE_PO2;
+
+	Ref<TestTreeMultipassGenerator> generator;
+	generator.instantiate();
+	generator->set_column_base_y_blocks(-1);
+	generator->set_column_height_blocks(4);
+	generator->set_pass_count(2);
+	generator->set_pass_extent_blocks(1, 1);
+
+	const int final_subpass_index =
+			VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(generator->get_pass_count()) - 1;
+
+	// Allocate columns in the cache, like a terrain viewer would
+	const Box3i requested_box(Vector3i(0, -1, 0), Vector3i(AREA_SIZE_COLUMNS, 4, AREA_SIZE_COLUMNS));
+	generator->process_viewer_diff(ViewerID(), requested_box, Box3i());
+
+	std::shared_ptr<Internal> internal = generator->get_internal();
+	Map &map = internal->map;
+
+	std::shared_ptr<std::atomic_int> completed_count = make_shared_instance<std::atomic_int>(0);
+	StdVector<IThreadedTask *> tasks;
+
+	const Box2i area(Vector2i(), Vector2iUtil::create(AREA_SIZE_COLUMNS));
+
+	// Request every column, the same way block tasks do
+	area.for_each_cell_yx([&](Vector2i cpos) {
+		{
+			SpatialLock2D::Write swlock(map.spatial_lock, BoxBounds2i::from_position(cpos));
+			MutexLock mlock(map.mutex);
+			auto it = map.columns.find(cpos);
+			ZN_TEST_ASSERT(it != map.columns.end());
+			it->second.pending_subpass_tasks_mask |= (1 << final_subpass_index);
+		}
+		tasks.push_back(ZN_NEW(GenerateColumnMultipassTask(
+				cpos,
+				BLOCK_SIZE,
+				final_subpass_index,
+				internal,
+				generator,
+				TaskPriority(),
+				ZN_NEW(ColumnRequestTask(completed_count)),
+				make_shared_instance<std::atomic_int>(1)
+		)));
+	});
+
+	ProfilingClock profiling_clock;
+
+	VoxelEngine::get_singleton().push_async_tasks(to_span(tasks));
+	VoxelEngine::get_singleton().wait_and_clear_all_tasks(false);
+
+	const uint64_t time_us = profiling_clock.restart();
+
+	ZN_TEST_ASSERT(*completed_count == Vector2iUtil::get_area(area.size));
+
+	{
+		MutexLock mlock(map.mutex);
+
+		area.for_each_cell_yx([&map, final_subpass_index](Vector2i cpos) {
+			auto it = map.columns.find(cpos);
+			ZN_TEST_ASSERT(it != map.columns.end());
+			const Column &column = it->second;
+			ZN_TEST_ASSERT(column.subpass_index == final_subpass_index);
+			ZN_TEST_ASSERT(column.pending_subpass_tasks_mask == 0);
+			for (unsigned int subpass_index = 0; subpass_index < MAX_SUBPASSES; ++subpass_index) {
+				ZN_TEST_ASSERT(column.subpass_waiting_tasks[subpass_index].size() == 0);
+			}
+		});
+
+		// Columns must be the same as if they were generated alone on a single thread
+		const Vector2i checked_columns[] = { Vector2i(0, 0), Vector2i(13, 7), Vector2i(31, 31) };
+		for (const Vector2i cpos : checked_columns) {
+			const TypedArray<godot::VoxelBuffer> expected_blocks = generator->debug_generate_test_column(cpos);
+			const Column &column = map.columns.find(cpos)->second;
+			ZN_TEST_ASSERT(int(column.blocks.size()) == expected_blocks.size());
+			for (unsigned int i = 0; i < column.blocks.size(); ++i) {
+				Ref<godot::VoxelBuffer> expected_block = expected_blocks[i];
+				ZN_TEST_ASSERT(expected_block.is_valid());
+				ZN_TEST_ASSERT(expected_block->get_buffer().equals(column.blocks[i].voxels));
+			}
+		}
+	}
+
+	StdVector<VoxelGeneratorMultipassCB::PassStatsSnapshot> pass_stats;
+	generator->get_pass_stats(pass_stats);
+	ZN_TEST_ASSERT(pass_stats.size() == 2);
+
+	ZN_PRINT_VERBOSE(format(
+			"VoxelGeneratorMultipassCB benchmark: {}x{} columns generated in {} us", //
+			AREA_SIZE_COLUMNS,
+			AREA_SIZE_COLUMNS,
+			time_us
+	));
+	for (unsigned int pass_index = 0; pass_index < pass_stats.size(); ++pass_index) {
+		const VoxelGeneratorMultipassCB::PassStatsSnapshot &s = pass_stats[pass_index];
+		ZN_PRINT_VERBOSE(format(
+				"Pass {}: {} columns, {} us, {} dependency waits, {} lock retries",
+				pass_index,
+				s.column_count,
+				s.time_usec,
+				s.dependency_wait_count,
+				s.lock_retry_count
+		));
+	}
+
+	// Unload the cache
+	generator->process_viewer_diff(ViewerID(), Box3i(), requested_box);
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,10 @@
+#ifndef VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_CB_H
+#define VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_CB_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_generator_multipass_cb_benchmark();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_CB_H
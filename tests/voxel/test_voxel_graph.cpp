@@ -7,12 +7,15 @@
 #include "../../storage/voxel_buffer.h"
 #include "../../util/containers/container_funcs.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/godot/classes/curve.h"
 #include "../../util/godot/classes/fast_noise_lite.h"
 #include "../../util/godot/classes/image.h"
 #include "../../util/godot/core/random_pcg.h"
 #include "../../util/math/conv.h"
 #include "../../util/math/sdf.h"
+#include "../../util/math/simd.h"
 #include "../../util/noise/fast_noise_lite/fast_noise_lite.h"
+#include "../../util/profiling_clock.h"
 #include "../../util/string/format.h"
 #include "../../util/string/std_string.h"
 #include "../testing.h"
@@ -2114,4 +2117,106 @@ void test_voxel_graph_many_subdivisions() {
 	generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, Vector3i(0, 0, 0), 0 });
 }
 
+void test_voxel_graph_generate_block_benchmark() {
+	// Generates blocks with nodes that have vectorized implementations, using every instruction set the CPU supports,
+	// and checks that they all produce the same results.
+
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	{
+		VoxelGraphFunction &g = **generator->get_main_function();
+
+		//      X
+		//       \
+		//  Z --- Sphere --- SmoothUnion --- Add --- OutSDF
+		//       /          /               /
+		//      Y --- Plane                /
+		//                                /
+		//  X --- Multiply --- Curve -----
+
+		const uint32_t n_in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2(0, 0));
+		const uint32_t n_in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y, Vector2(0, 0));
+		const uint32_t n_in_z = g.create_node(VoxelGraphFunction::NODE_INPUT_Z, Vector2(0, 0));
+		const uint32_t n_out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2(0, 0));
+		const uint32_t n_plane = g.create_node(VoxelGraphFunction::NODE_SDF_PLANE, Vector2());
+		const uint32_t n_sphere = g.create_node(VoxelGraphFunction::NODE_SDF_SPHERE, Vector2());
+		const uint32_t n_union = g.create_node(VoxelGraphFunction::NODE_SDF_SMOOTH_UNION, Vector2());
+		const uint32_t n_mul = g.create_node(VoxelGraphFunction::NODE_MULTIPLY, Vector2());
+		const uint32_t n_curve = g.create_node(VoxelGraphFunction::NODE_CURVE, Vector2());
+		const uint32_t n_add = g.create_node(VoxelGraphFunction::NODE_ADD, Vector2());
+
+		uint32_t union_smoothness_id;
+		ZN_ASSERT(NodeTypeDB::get_singleton().try_get_param_index_from_name(
+				VoxelGraphFunction::NODE_SDF_SMOOTH_UNION, "smoothness", union_smoothness_id
+		));
+
+		Ref<Curve> curve;
+		curve.instantiate();
+		curve->add_point(Vector2(0, 0));
+		curve->add_point(Vector2(0.5, 1));
+		curve->add_point(Vector2(1, 0));
+
+		g.add_connection(n_in_x, 0, n_sphere, 0);
+		g.add_connection(n_in_y, 0, n_sphere, 1);
+		g.add_connection(n_in_z, 0, n_sphere, 2);
+		g.set_node_param(n_sphere, 0, 12.f);
+		g.add_connection(n_in_y, 0, n_plane, 0);
+		g.set_node_default_input(n_plane, 1, 0.f);
+		g.add_connection(n_sphere, 0, n_union, 0);
+		g.add_connection(n_plane, 0, n_union, 1);
+		g.set_node_param(n_union, union_smoothness_id, 4.f);
+		g.add_connection(n_in_x, 0, n_mul, 0);
+		g.set_node_default_input(n_mul, 1, 0.03f);
+		g.add_connection(n_mul, 0, n_curve, 0);
+		g.set_node_param(n_curve, 0, curve);
+		g.add_connection(n_union, 0, n_add, 0);
+		g.add_connection(n_curve, 0, n_add, 1);
+		g.add_connection(n_add, 0, n_out_sdf, 0);
+
+		CompilationResult result = generator->compile(false);
+		ZN_TEST_ASSERT_MSG(
+				result.success,
+				String("Failed to compile graph: {0}: {1}").format(varray(result.node_id, result.message))
+		);
+	}
+
+	const math::simd::Level initial_level = math::simd::get_level();
+	const unsigned int iterations = 20;
+	// Range analysis would skip most of the work in blocks far from the surface, so we use one that contains it
+	const Vector3i origin(-16, -16, -16);
+
+	VoxelBuffer reference_block(VoxelBuffer::ALLOCATOR_DEFAULT);
+	reference_block.create(Vector3i(32, 32, 32));
+
+	for (unsigned int level_index = 0; level_index <= math::simd::get_max_supported_level(); ++level_index) {
+		const math::simd::Level level = static_cast<math::simd::Level>(level_index);
+		math::simd::set_level(level);
+
+		VoxelBuffer block(VoxelBuffer::ALLOCATOR_DEFAULT);
+		block.create(Vector3i(32, 32, 32));
+
+		ProfilingClock pclock;
+
+		for (unsigned int i = 0; i < iterations; ++i) {
+			generator->generate_block(VoxelGenerator::VoxelQueryData{ block, origin, 0 });
+		}
+
+		const uint64_t elapsed_us = pclock.get_elapsed_microseconds();
+		ZN_PRINT_VERBOSE(format(
+				"Generating {} blocks of 32x32x32 with {}: {} us",
+				iterations,
+				math::simd::get_level_name(level),
+				elapsed_us
+		));
+
+		if (level == math::simd::LEVEL_SCALAR) {
+			block.copy_to(reference_block, false);
+		} else {
+			ZN_TEST_ASSERT(sd_equals_approx(reference_block, block));
+		}
+	}
+
+	math::simd::set_level(initial_level);
+}
+
 } // namespace zylann::voxel::tests
@@ -0,0 +1,100 @@
+#include "test_voxel_memory_pool.h"
+#include "../../storage/voxel_memory_pool.h"
+#include "../../util/containers/fixed_array.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/thread/thread.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_memory_pool_thread_caches() {
+	struct L {
+		static void run(void *userdata) {
+			VoxelMemoryPool &pool = *static_cast<VoxelMemoryPool *>(userdata);
+			StdVector<uint8_t *> blocks;
+			StdVector<size_t> sizes;
+
+			for (unsigned int iteration = 0; iteration < 100; ++iteration) {
+				// Allocate more blocks than a magazine can hold, so they get exchanged with the shared pools
+				for (unsigned int i = 0; i < 50; ++i) {
+					const size_t size = 100 + (i % 4) * 1000;
+					uint8_t *block = pool.allocate(size);
+					ZN_TEST_ASSERT(block != nullptr);
+					// Blocks must not be handed out twice
+					block[0] = i;
+					block[size - 1] = i;
+					blocks.push_back(block);
+					sizes.push_back(size);
+				}
+				for (unsigned int i = 0; i < blocks.size(); ++i) {
+					ZN_TEST_ASSERT(blocks[i][0] == i);
+					ZN_TEST_ASSERT(blocks[i][sizes[i] - 1] == i);
+					pool.recycle(blocks[i], sizes[i]);
+				}
+				blocks.clear();
+				sizes.clear();
+			}
+		}
+	};
+
+	VoxelMemoryPool pool;
+
+	FixedArray<Thread, 4> threads;
+	for (Thread &thread : threads) {
+		thread.start(L::run, &pool);
+	}
+	for (Thread &thread : threads) {
+		thread.wait_to_finish();
+	}
+
+	ZN_TEST_ASSERT(pool.debug_get_used_blocks() == 0);
+	ZN_TEST_ASSERT(pool.debug_get_used_memory() == 0);
+	ZN_TEST_ASSERT(pool.debug_get_used_capacity() == 0);
+	// Caches of threads that exited must have been returned to the pool
+	ZN_TEST_ASSERT(pool.debug_get_thread_cached_memory() == 0);
+	ZN_TEST_ASSERT(pool.debug_get_peak_used_memory() > 0);
+	ZN_TEST_ASSERT(pool.debug_get_peak_total_memory() >= pool.debug_get_peak_used_memory());
+	ZN_TEST_ASSERT(pool.debug_get_total_memory() > 0);
+
+	// Sizes are rounded up to a power of two
+	uint8_t *block = pool.allocate(100);
+	ZN_TEST_ASSERT(pool.debug_get_used_memory() == 100);
+	ZN_TEST_ASSERT(pool.debug_get_used_capacity() == 128);
+	pool.recycle(block, 100);
+
+	pool.clear_unused_blocks();
+	ZN_TEST_ASSERT(pool.debug_get_total_memory() == 0);
+	ZN_TEST_ASSERT(pool.debug_get_thread_cached_memory() == 0);
+}
+
+void test_voxel_memory_pool_arenas() {
+	VoxelMemoryPool pool;
+	pool.set_arenas_enabled(true, false);
+
+	uint8_t *block1 = pool.allocate(100);
+	uint8_t *block2 = pool.allocate(5000);
+	ZN_TEST_ASSERT(block1 != nullptr);
+	ZN_TEST_ASSERT(block2 != nullptr);
+
+	const size_t arena_memory = pool.debug_get_arena_memory();
+	ZN_TEST_ASSERT(arena_memory > 0);
+	ZN_TEST_ASSERT(pool.debug_get_total_memory() == arena_memory);
+	ZN_TEST_ASSERT(pool.debug_get_used_memory() == 5100);
+	ZN_TEST_ASSERT(pool.debug_get_used_capacity() == 128 + 8192);
+	ZN_TEST_ASSERT(pool.debug_get_arena_carved_memory() == 128 + 8192);
+
+	pool.recycle(block1, 100);
+	pool.recycle(block2, 5000);
+
+	// Arena memory can't be returned block by block
+	pool.clear_unused_blocks();
+	ZN_TEST_ASSERT(pool.debug_get_total_memory() == arena_memory);
+
+	// Recycled blocks are reused instead of carving new ones
+	uint8_t *block3 = pool.allocate(100);
+	ZN_TEST_ASSERT(block3 != nullptr);
+	ZN_TEST_ASSERT(pool.debug_get_arena_carved_memory() == 128 + 8192);
+	pool.recycle(block3, 100);
+}
+
+} // namespace zylann::voxel::tests
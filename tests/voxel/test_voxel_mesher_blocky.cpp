@@ -0,0 +1,198 @@
+#include "test_voxel_mesher_blocky.h"
+#include "../../constants/cube_tables.h"
+#include "../../meshers/blocky/voxel_blocky_library.h"
+#include "../../meshers/blocky/voxel_blocky_model_cube.h"
+#include "../../meshers/blocky/voxel_blocky_model_empty.h"
+#include "../../meshers/blocky/voxel_mesher_blocky.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../util/math/conv.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_mesher_blocky_greedy() {
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	{
+		Ref<VoxelBlockyModelEmpty> air;
+		air.instantiate();
+		library->add_model(air);
+	}
+	int cube_id = -1;
+	{
+		Ref<VoxelBlockyModelCube> cube;
+		cube.instantiate();
+		cube_id = library->add_model(cube);
+	}
+	library->bake();
+
+	// Flat ground filling the bottom half of the block, including padding, so only its top is visible
+	const int inner_size = 16;
+	const int ground_height = 8;
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(Vector3iUtil::create(inner_size + 2 * VoxelMesherBlocky::PADDING));
+	vb.fill_area(
+			cube_id,
+			Vector3i(),
+			Vector3i(vb.get_size().x, VoxelMesherBlocky::PADDING + ground_height, vb.get_size().z),
+			VoxelBuffer::CHANNEL_TYPE
+	);
+
+	Ref<VoxelMesherBlocky> mesher;
+	mesher.instantiate();
+	mesher->set_library(library);
+
+	struct L {
+		static VoxelMesher::Output build(VoxelMesherBlocky &mesher, const VoxelBuffer &vb) {
+			VoxelMesher::Input input{ vb, nullptr, nullptr, Vector3i(), 0, true };
+			VoxelMesher::Output output;
+			mesher.build(output, input);
+			return output;
+		}
+
+		static Rect2 get_uv_rect(const PackedVector2Array &uvs, int count) {
+			Rect2 rect(uvs[0], Vector2());
+			for (int i = 1; i < count; ++i) {
+				rect.expand_to(uvs[i]);
+			}
+			return rect;
+		}
+
+		static unsigned int get_vertex_count(const VoxelMesher::Output &output) {
+			unsigned int count = 0;
+			for (const VoxelMesher::Output::Surface &surface : output.surfaces) {
+				const PackedVector3Array positions = surface.arrays[Mesh::ARRAY_VERTEX];
+				count += positions.size();
+			}
+			return count;
+		}
+	};
+
+	Vector2 face_uv_size;
+	{
+		VoxelMesher::Output output = L::build(**mesher, vb);
+		ZN_TEST_ASSERT(L::get_vertex_count(output) == inner_size * inner_size * 4);
+		ZN_TEST_ASSERT(output.collision_surface.positions.size() == inner_size * inner_size * 4);
+
+		const PackedVector2Array uvs = output.surfaces[0].arrays[Mesh::ARRAY_TEX_UV];
+		face_uv_size = L::get_uv_rect(uvs, 4).size;
+	}
+
+	mesher->set_greedy_meshing_enabled(true);
+	{
+		VoxelMesher::Output output = L::build(**mesher, vb);
+
+		// All top faces are the same, so they should be merged into a single quad
+		ZN_TEST_ASSERT(output.surfaces.size() == 1);
+		ZN_TEST_ASSERT(L::get_vertex_count(output) == 4);
+		ZN_TEST_ASSERT(output.collision_surface.positions.size() == 4);
+		ZN_TEST_ASSERT(output.collision_surface.indices.size() == 6);
+
+		const Array &arrays = output.surfaces[0].arrays;
+		const PackedVector3Array positions = arrays[Mesh::ARRAY_VERTEX];
+		const PackedVector2Array uvs = arrays[Mesh::ARRAY_TEX_UV];
+		const PackedVector2Array uvs2 = arrays[Mesh::ARRAY_TEX_UV2];
+		ZN_TEST_ASSERT(uvs.size() == 4);
+		ZN_TEST_ASSERT(uvs2.size() == 4);
+
+		AABB aabb(positions[0], Vector3());
+		for (int i = 1; i < positions.size(); ++i) {
+			aabb.expand_to(positions[i]);
+		}
+		ZN_TEST_ASSERT(aabb.position.is_equal_approx(Vector3(0, ground_height, 0)));
+		ZN_TEST_ASSERT(aabb.size.is_equal_approx(Vector3(inner_size, 0, inner_size)));
+
+		// The texture of one face should repeat across the merged quad, starting from the origin of its tile
+		const Rect2 uv_rect = L::get_uv_rect(uvs, uvs.size());
+		ZN_TEST_ASSERT(uv_rect.size.is_equal_approx(face_uv_size * inner_size));
+		for (int i = 0; i < uvs2.size(); ++i) {
+			ZN_TEST_ASSERT(uvs2[i].is_equal_approx(uv_rect.position));
+		}
+	}
+}
+
+void test_voxel_mesher_blocky_box_collision() {
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	{
+		Ref<VoxelBlockyModelEmpty> air;
+		air.instantiate();
+		library->add_model(air);
+	}
+	int cube_id = -1;
+	{
+		Ref<VoxelBlockyModelCube> cube;
+		cube.instantiate();
+		cube_id = library->add_model(cube);
+	}
+	library->bake();
+
+	Ref<VoxelMesherBlocky> mesher;
+	mesher.instantiate();
+	mesher->set_library(library);
+	mesher->set_collision_mode(VoxelMesherBlocky::COLLISION_MODE_BOXES);
+
+	struct L {
+		static VoxelMesher::Output build(VoxelMesherBlocky &mesher, const VoxelBuffer &vb) {
+			VoxelMesher::Input input{ vb, nullptr, nullptr, Vector3i(), 0, true };
+			VoxelMesher::Output output;
+			mesher.build(output, input);
+			return output;
+		}
+
+		static AABB get_aabb(const StdVector<Vector3f> &positions) {
+			AABB aabb(to_vec3(positions[0]), Vector3());
+			for (const Vector3f p : positions) {
+				aabb.expand_to(to_vec3(p));
+			}
+			return aabb;
+		}
+	};
+
+	const int inner_size = 16;
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(Vector3iUtil::create(inner_size + 2 * VoxelMesherBlocky::PADDING));
+
+	// Isolated box of cubes, which should become a single box
+	{
+		const Vector3i box_pos(3, 4, 5);
+		const Vector3i box_size(3, 2, 4);
+		vb.fill_area(cube_id, box_pos, box_pos + box_size, VoxelBuffer::CHANNEL_TYPE);
+
+		VoxelMesher::Output output = L::build(**mesher, vb);
+		ZN_TEST_ASSERT(output.collision_surface.positions.size() == Cube::SIDE_COUNT * 4);
+		ZN_TEST_ASSERT(output.collision_surface.indices.size() == Cube::SIDE_COUNT * 6);
+
+		const AABB aabb = L::get_aabb(output.collision_surface.positions);
+		const Vector3i padding = Vector3iUtil::create(VoxelMesherBlocky::PADDING);
+		ZN_TEST_ASSERT(aabb.position.is_equal_approx(to_vec3(box_pos - padding)));
+		ZN_TEST_ASSERT(aabb.size.is_equal_approx(to_vec3(box_size)));
+
+		// Rendering is not affected
+		ZN_TEST_ASSERT(output.surfaces.size() == 1);
+		const PackedVector3Array positions = output.surfaces[0].arrays[Mesh::ARRAY_VERTEX];
+		ZN_TEST_ASSERT(positions.size() == 2 * (3 * 2 + 2 * 4 + 3 * 4) * 4);
+	}
+
+	// Flat ground filling the bottom half of the block, including padding, so only its top collides
+	{
+		const int ground_height = 8;
+		vb.clear_channel(VoxelBuffer::CHANNEL_TYPE, 0);
+		vb.fill_area(
+				cube_id,
+				Vector3i(),
+				Vector3i(vb.get_size().x, VoxelMesherBlocky::PADDING + ground_height, vb.get_size().z),
+				VoxelBuffer::CHANNEL_TYPE
+		);
+
+		VoxelMesher::Output output = L::build(**mesher, vb);
+		ZN_TEST_ASSERT(output.collision_surface.positions.size() == 4);
+		ZN_TEST_ASSERT(output.collision_surface.indices.size() == 6);
+
+		const AABB aabb = L::get_aabb(output.collision_surface.positions);
+		ZN_TEST_ASSERT(aabb.position.is_equal_approx(Vector3(0, ground_height, 0)));
+		ZN_TEST_ASSERT(aabb.size.is_equal_approx(Vector3(inner_size, 0, inner_size)));
+	}
+}
+
+} // namespace zylann::voxel::tests
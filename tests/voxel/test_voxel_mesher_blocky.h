@@ -0,0 +1,11 @@
+#ifndef VOXEL_TESTS_VOXEL_MESHER_BLOCKY_H
+#define VOXEL_TESTS_VOXEL_MESHER_BLOCKY_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_mesher_blocky_greedy();
+void test_voxel_mesher_blocky_box_collision();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_MESHER_BLOCKY_H
@@ -0,0 +1,203 @@
+#include "test_voxel_mesher_transvoxel.h"
+#include "../../meshers/transvoxel/voxel_mesher_transvoxel.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../util/godot/classes/mesh.h"
+#include "../../util/godot/classes/rendering_server.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+void add_sphere(VoxelBuffer &vb, Vector3f center, float radius, bool subtract) {
+	const Vector3i size = vb.get_size();
+	Vector3i pos;
+	for (pos.z = 0; pos.z < size.z; ++pos.z) {
+		for (pos.x = 0; pos.x < size.x; ++pos.x) {
+			for (pos.y = 0; pos.y < size.y; ++pos.y) {
+				const float sd = (Vector3f(pos.x, pos.y, pos.z) - center).length() - radius;
+				const float prev_sd = vb.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+				const float new_sd = subtract ? math::max(prev_sd, -sd) : math::min(prev_sd, sd);
+				vb.set_voxel_f(new_sd, pos, VoxelBuffer::CHANNEL_SDF);
+			}
+		}
+	}
+}
+
+} // namespace
+
+void test_voxel_mesher_transvoxel_incremental_build() {
+	struct L {
+		static void build(
+				VoxelMesherTransvoxel &mesher,
+				const VoxelBuffer &vb,
+				const VoxelMesher::IncrementalState *previous_state,
+				Box3i dirty_box,
+				VoxelMesher::Output &output
+		) {
+			VoxelMesher::Input input{ vb, nullptr, nullptr, Vector3i(), 0, false };
+			input.incremental_hint = true;
+			input.previous_state = previous_state;
+			input.dirty_box = dirty_box;
+			mesher.build(output, input);
+		}
+
+		static bool is_same_mesh(const VoxelMesher::Output &a, const VoxelMesher::Output &b) {
+			ZN_TEST_ASSERT(a.surfaces.size() == 1);
+			ZN_TEST_ASSERT(b.surfaces.size() == 1);
+			const Array &arrays_a = a.surfaces[0].arrays;
+			const Array &arrays_b = b.surfaces[0].arrays;
+			const PackedVector3Array vertices_a = arrays_a[Mesh::ARRAY_VERTEX];
+			const PackedVector3Array vertices_b = arrays_b[Mesh::ARRAY_VERTEX];
+			const PackedVector3Array normals_a = arrays_a[Mesh::ARRAY_NORMAL];
+			const PackedVector3Array normals_b = arrays_b[Mesh::ARRAY_NORMAL];
+			const PackedInt32Array indices_a = arrays_a[Mesh::ARRAY_INDEX];
+			const PackedInt32Array indices_b = arrays_b[Mesh::ARRAY_INDEX];
+			return vertices_a == vertices_b && normals_a == normals_b && indices_a == indices_b;
+		}
+	};
+
+	// 16 voxels plus padding
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(Vector3i(19, 19, 19));
+	vb.set_channel_depth(VoxelBuffer::CHANNEL_SDF, VoxelBuffer::DEPTH_32_BIT);
+	vb.fill_f(1.f, VoxelBuffer::CHANNEL_SDF);
+	add_sphere(vb, Vector3f(9.5f, 9.5f, 9.5f), 7.f, false);
+
+	Ref<VoxelMesherTransvoxel> mesher;
+	mesher.instantiate();
+	mesher->set_incremental_build_enabled(true);
+
+	VoxelMesher::Output output0;
+	L::build(**mesher, vb, nullptr, Box3i(), output0);
+	ZN_TEST_ASSERT(output0.incremental_state != nullptr);
+
+	{
+		// Nothing changed, previous slabs should be reused entirely
+		VoxelMesher::Output output;
+		L::build(**mesher, vb, output0.incremental_state.get(), Box3i(), output);
+		ZN_TEST_ASSERT(L::is_same_mesh(output, output0));
+	}
+
+	// Dig a small hole near the -Z side, which only affects the first slabs. The box is relative to the meshed area,
+	// which starts after padding.
+	const Vector3f dig_center(9.5f, 9.5f, 3.f);
+	const float dig_radius = 2.f;
+	add_sphere(vb, dig_center, dig_radius, true);
+	const Box3i dirty_box = Box3i::from_min_max(Vector3i(7, 7, 0), Vector3i(13, 13, 6)).padded(1);
+
+	VoxelMesher::Output incremental_output;
+	L::build(**mesher, vb, output0.incremental_state.get(), dirty_box, incremental_output);
+
+	VoxelMesher::Output full_output;
+	L::build(**mesher, vb, nullptr, Box3i(), full_output);
+
+	ZN_TEST_ASSERT(!L::is_same_mesh(incremental_output, output0));
+	ZN_TEST_ASSERT(L::is_same_mesh(incremental_output, full_output));
+
+	{
+		// Building on top of the incremental result must also work
+		add_sphere(vb, Vector3f(9.5f, 9.5f, 15.f), dig_radius, true);
+		const Box3i dirty_box2 = Box3i::from_min_max(Vector3i(7, 7, 11), Vector3i(13, 13, 17)).padded(1);
+
+		VoxelMesher::Output incremental_output2;
+		L::build(**mesher, vb, incremental_output.incremental_state.get(), dirty_box2, incremental_output2);
+
+		VoxelMesher::Output full_output2;
+		L::build(**mesher, vb, nullptr, Box3i(), full_output2);
+
+		ZN_TEST_ASSERT(L::is_same_mesh(incremental_output2, full_output2));
+	}
+}
+
+void test_voxel_mesher_transvoxel_compact_vertex_format() {
+	// 16 voxels plus padding
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(Vector3i(19, 19, 19));
+	vb.set_channel_depth(VoxelBuffer::CHANNEL_SDF, VoxelBuffer::DEPTH_32_BIT);
+	vb.fill_f(1.f, VoxelBuffer::CHANNEL_SDF);
+	add_sphere(vb, Vector3f(9.5f, 9.5f, 9.5f), 8.3f, false);
+
+	const uint8_t lod_index = 2;
+	const float cell_size = 1 << lod_index;
+
+	Ref<VoxelMesherTransvoxel> mesher;
+	mesher.instantiate();
+
+	VoxelMesher::Input input{ vb, nullptr, nullptr, Vector3i(), lod_index, false };
+	input.lod_hint = true;
+
+	VoxelMesher::Output full_output;
+	mesher->build(full_output, input);
+
+	mesher->set_compact_vertex_format_enabled(true);
+	VoxelMesher::Output compact_output;
+	mesher->build(compact_output, input);
+
+	const uint32_t custom0_format =
+			(compact_output.mesh_flags >> Mesh::ARRAY_FORMAT_CUSTOM0_SHIFT) & Mesh::ARRAY_FORMAT_CUSTOM_MASK;
+	const uint32_t custom2_format =
+			(compact_output.mesh_flags >> Mesh::ARRAY_FORMAT_CUSTOM2_SHIFT) & Mesh::ARRAY_FORMAT_CUSTOM_MASK;
+	ZN_TEST_ASSERT(custom0_format == RenderingServer::ARRAY_CUSTOM_RGBA8_UNORM);
+	ZN_TEST_ASSERT(custom2_format == RenderingServer::ARRAY_CUSTOM_RGBA8_SNORM);
+
+	ZN_TEST_ASSERT(full_output.surfaces.size() == 1);
+	ZN_TEST_ASSERT(compact_output.surfaces.size() == 1);
+	const Array &full_arrays = full_output.surfaces[0].arrays;
+	const Array &compact_arrays = compact_output.surfaces[0].arrays;
+
+	// Geometry is the same, only LOD data is packed differently
+	const PackedVector3Array vertices = full_arrays[Mesh::ARRAY_VERTEX];
+	ZN_TEST_ASSERT(vertices.size() > 0);
+	ZN_TEST_ASSERT(vertices == PackedVector3Array(compact_arrays[Mesh::ARRAY_VERTEX]));
+	ZN_TEST_ASSERT(PackedVector3Array(full_arrays[Mesh::ARRAY_NORMAL]) ==
+			PackedVector3Array(compact_arrays[Mesh::ARRAY_NORMAL]));
+	ZN_TEST_ASSERT(PackedInt32Array(full_arrays[Mesh::ARRAY_INDEX]) ==
+			PackedInt32Array(compact_arrays[Mesh::ARRAY_INDEX]));
+
+	const PackedFloat32Array full_lod_data = full_arrays[Mesh::ARRAY_CUSTOM0];
+	const PackedByteArray compact_lod_data = compact_arrays[Mesh::ARRAY_CUSTOM0];
+	const PackedByteArray compact_lod_offsets = compact_arrays[Mesh::ARRAY_CUSTOM2];
+	ZN_TEST_ASSERT(full_lod_data.size() == vertices.size() * 4);
+	ZN_TEST_ASSERT(compact_lod_data.size() == vertices.size() * 4);
+	ZN_TEST_ASSERT(compact_lod_offsets.size() == vertices.size() * 4);
+
+	const float *full_lod_data_r = full_lod_data.ptr();
+	const uint8_t *compact_lod_data_r = compact_lod_data.ptr();
+	const int8_t *compact_lod_offsets_r = reinterpret_cast<const int8_t *>(compact_lod_offsets.ptr());
+
+	// Offsets are stored in 1/127th of a cell
+	const float max_error = cell_size / 127.f + 0.001f;
+	unsigned int moved_vertex_count = 0;
+
+	for (int vi = 0; vi < vertices.size(); ++vi) {
+		const float *f = full_lod_data_r + vi * 4;
+		const uint8_t *c = compact_lod_data_r + vi * 4;
+		const int8_t *o = compact_lod_offsets_r + vi * 4;
+
+		uint32_t packed_masks;
+		memcpy(&packed_masks, &f[3], sizeof(packed_masks));
+		ZN_TEST_ASSERT(c[0] == (packed_masks & 0xff));
+		ZN_TEST_ASSERT(c[1] == ((packed_masks >> 8) & 0xff));
+		ZN_TEST_ASSERT(c[2] == ((packed_masks >> 16) & 0xff));
+		ZN_TEST_ASSERT(c[3] == lod_index);
+
+		if (c[0] == 0) {
+			continue;
+		}
+		const Vector3 v = vertices[vi];
+		const Vector3 expected_offset = Vector3(f[0], f[1], f[2]) - v;
+		const Vector3 offset = Vector3(o[0], o[1], o[2]) * (cell_size / 127.f);
+		ZN_TEST_ASSERT(Math::abs(offset.x - expected_offset.x) <= max_error);
+		ZN_TEST_ASSERT(Math::abs(offset.y - expected_offset.y) <= max_error);
+		ZN_TEST_ASSERT(Math::abs(offset.z - expected_offset.z) <= max_error);
+		if (expected_offset != Vector3()) {
+			++moved_vertex_count;
+		}
+	}
+
+	// The sphere touches sides of the block, so some vertices must have a secondary position
+	ZN_TEST_ASSERT(moved_vertex_count > 0);
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,189 @@
+#include "test_voxel_modifier_stack.h"
+#include "../../modifiers/voxel_modifier_sphere.h"
+#include "../../modifiers/voxel_modifier_stack.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+Vector3 make_random_position(RandomPCG &rng, float range) {
+	return Vector3(rng.randf() * range, rng.randf() * range, rng.randf() * range);
+}
+
+VoxelModifierSphere &add_random_sphere(VoxelModifierStack &stack, uint32_t id, RandomPCG &rng, float range) {
+	VoxelModifierSphere *sphere = stack.add_modifier<VoxelModifierSphere>(id);
+	sphere->set_operation(rng.rand(3) == 0 ? VoxelModifierSdf::OP_SUBTRACT : VoxelModifierSdf::OP_ADD);
+	sphere->set_radius(2.f + rng.randf() * 10.f);
+	sphere->set_transform(Transform3D(Basis(), make_random_position(rng, range)));
+	return *sphere;
+}
+
+// Reference implementation, testing every modifier in order
+float apply_modifiers_brute_force(const VoxelModifierStack &stack, float sdf, Vector3 position) {
+	VoxelModifierContext ctx;
+	ctx.positions = Span<Vector3>(&position, 1);
+	ctx.sdf = Span<float>(&sdf, 1);
+	const AABB aabb(position, Vector3(1, 1, 1));
+	stack.for_each_modifier([&ctx, &aabb](const VoxelModifier &modifier) {
+		if (modifier.get_aabb().intersects(aabb)) {
+			modifier.apply(ctx);
+		}
+	});
+	return sdf;
+}
+
+} // namespace
+
+void test_voxel_modifier_stack_index() {
+	static const float RANGE = 200.f;
+
+	struct L {
+		static void check(const VoxelModifierStack &stack, RandomPCG &rng) {
+			for (unsigned int i = 0; i < 2000; ++i) {
+				const Vector3 pos = make_random_position(rng, RANGE);
+				const float sdf0 = 2.f * rng.randf() - 1.f;
+
+				const float expected = apply_modifiers_brute_force(stack, sdf0, pos);
+
+				float sdf = sdf0;
+				stack.apply(sdf, pos);
+
+				// Modifiers must be applied in the same order, so results must be exactly the same
+				ZN_TEST_ASSERT(sdf == expected);
+			}
+		}
+	};
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	VoxelModifierStack stack;
+	StdVector<uint32_t> ids;
+
+	for (unsigned int i = 0; i < 300; ++i) {
+		const uint32_t id = stack.allocate_id();
+		add_random_sphere(stack, id, rng, RANGE);
+		ids.push_back(id);
+	}
+	L::check(stack, rng);
+
+	// Move modifiers by small and large amounts, and resize some
+	for (const uint32_t id : ids) {
+		VoxelModifierSphere *sphere = static_cast<VoxelModifierSphere *>(stack.get_modifier(id));
+		ZN_TEST_ASSERT(sphere != nullptr);
+		const Vector3 offset = rng.rand(4) == 0 ? make_random_position(rng, 50.f) : make_random_position(rng, 0.5f);
+		sphere->set_transform(Transform3D(Basis(), sphere->get_transform().origin + offset));
+		if (rng.rand(5) == 0) {
+			sphere->set_radius(2.f + rng.randf() * 20.f);
+		}
+	}
+	L::check(stack, rng);
+
+	// Remove some modifiers and add new ones, which must be applied after those already present
+	for (unsigned int i = 0; i < ids.size(); i += 3) {
+		stack.remove_modifier(ids[i]);
+		ZN_TEST_ASSERT(!stack.has_modifier(ids[i]));
+	}
+	for (unsigned int i = 0; i < 50; ++i) {
+		add_random_sphere(stack, stack.allocate_id(), rng, RANGE);
+	}
+	L::check(stack, rng);
+
+	// Moving the stack must keep modifiers updating the index of their new owner
+	VoxelModifierStack stack2 = std::move(stack);
+	VoxelModifierSphere *sphere = static_cast<VoxelModifierSphere *>(stack2.get_modifier(ids[1]));
+	ZN_TEST_ASSERT(sphere != nullptr);
+	sphere->set_transform(Transform3D(Basis(), Vector3(-100, -100, -100)));
+	float sdf = 1.f;
+	stack2.apply(sdf, Vector3(-100, -100, -100));
+	ZN_TEST_ASSERT(sdf == apply_modifiers_brute_force(stack2, 1.f, Vector3(-100, -100, -100)));
+	ZN_TEST_ASSERT(sdf < 0.f || sphere->get_operation() == VoxelModifierSdf::OP_SUBTRACT);
+
+	stack2.clear();
+	sdf = 1.f;
+	stack2.apply(sdf, Vector3(-100, -100, -100));
+	ZN_TEST_ASSERT(sdf == 1.f);
+}
+
+void test_voxel_modifier_stack_benchmark() {
+	// Many small modifiers spread over a large world, like lots of craters or tunnels dug by players.
+	// Compares querying them through the stack, with testing every modifier like the stack used to do.
+
+	static const unsigned int MODIFIER_COUNT = 10000;
+	static const unsigned int QUERY_COUNT = 20000;
+	static const float RANGE = 2000.f;
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	VoxelModifierStack stack;
+	StdVector<uint32_t> ids;
+	ids.reserve(MODIFIER_COUNT);
+
+	ProfilingClock pclock;
+
+	for (unsigned int i = 0; i < MODIFIER_COUNT; ++i) {
+		const uint32_t id = stack.allocate_id();
+		add_random_sphere(stack, id, rng, RANGE);
+		ids.push_back(id);
+	}
+
+	const uint64_t add_time_us = pclock.restart();
+
+	StdVector<Vector3> positions;
+	positions.resize(QUERY_COUNT);
+	for (Vector3 &pos : positions) {
+		pos = make_random_position(rng, RANGE);
+	}
+
+	// First query publishes the index
+	float sdf = 1.f;
+	stack.apply(sdf, positions[0]);
+
+	pclock.restart();
+
+	float sdf_sum_indexed = 0.f;
+	for (const Vector3 pos : positions) {
+		sdf = 1.f;
+		stack.apply(sdf, pos);
+		sdf_sum_indexed += sdf;
+	}
+
+	const uint64_t indexed_time_us = pclock.restart();
+
+	float sdf_sum_brute_force = 0.f;
+	for (const Vector3 pos : positions) {
+		sdf_sum_brute_force += apply_modifiers_brute_force(stack, 1.f, pos);
+	}
+
+	const uint64_t brute_force_time_us = pclock.restart();
+
+	ZN_TEST_ASSERT(sdf_sum_indexed == sdf_sum_brute_force);
+
+	// Move all modifiers a bit, like if they were animated
+	for (const uint32_t id : ids) {
+		VoxelModifier *modifier = stack.get_modifier(id);
+		modifier->set_transform(Transform3D(Basis(), modifier->get_transform().origin + Vector3(0.5f, 0.f, 0.f)));
+	}
+	stack.apply(sdf, positions[0]);
+
+	const uint64_t move_time_us = pclock.restart();
+
+	ZN_PRINT_VERBOSE(format(
+			"VoxelModifierStack benchmark: {} modifiers added in {} us, {} queries in {} us (brute force: {} us), "
+			"all modifiers moved in {} us",
+			MODIFIER_COUNT,
+			add_time_us,
+			QUERY_COUNT,
+			indexed_time_us,
+			brute_force_time_us,
+			move_time_us
+	));
+}
+
+} // namespace zylann::voxel::tests
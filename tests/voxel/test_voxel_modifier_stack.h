@@ -0,0 +1,11 @@
+#ifndef VOXEL_TESTS_VOXEL_MODIFIER_STACK_H
+#define VOXEL_TESTS_VOXEL_MODIFIER_STACK_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_modifier_stack_index();
+void test_voxel_modifier_stack_benchmark();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_MODIFIER_STACK_H
@@ -8,6 +8,7 @@ namespace zylann {
 
 AStarGrid3D::AStarGrid3D() {
 	_open_list.sorter.compare.pool = &_points_pool;
+	update_fitting_offset();
 }
 
 void AStarGrid3D::set_region(Box3i region) {
@@ -17,6 +18,15 @@ void AStarGrid3D::set_region(Box3i region) {
 void AStarGrid3D::set_agent_size(Vector3f size) {
 	ZN_ASSERT_RETURN(math::is_valid_size(size));
 	_agent_size = size;
+	update_fitting_offset();
+}
+
+void AStarGrid3D::update_fitting_offset() {
+	_fitting_offset = Vector3f( //
+			(int(_agent_size.x) & 1) == 1 ? 0.5f : 0.f, //
+			(int(_agent_size.y) & 1) == 1 ? 0.5f : 0.f, //
+			(int(_agent_size.z) & 1) == 1 ? 0.5f : 0.f
+	);
 }
 
 void AStarGrid3D::set_max_fall_height(int h) {
@@ -36,20 +46,19 @@ float AStarGrid3D::get_max_path_cost() const {
 }
 
 void AStarGrid3D::start(Vector3i from_position, Vector3i target_position) {
+	start(from_position, target_position, _region);
+}
+
+void AStarGrid3D::start(Vector3i from_position, Vector3i target_position, Box3i search_box) {
 	clear();
 
 	_target_position = target_position;
+	_search_box = search_box.clipped(_region);
 
-	_fitting_offset = Vector3f( //
-			(int(_agent_size.x) & 1) == 1 ? 0.5f : 0.f, //
-			(int(_agent_size.y) & 1) == 1 ? 0.5f : 0.f, //
-			(int(_agent_size.z) & 1) == 1 ? 0.5f : 0.f
-	);
-
-	if (!_region.contains(from_position)) {
+	if (!_search_box.contains(from_position)) {
 		return;
 	}
-	if (!_region.contains(target_position)) {
+	if (!_search_box.contains(target_position)) {
 		return;
 	}
 
@@ -91,6 +100,7 @@ void AStarGrid3D::step() {
 
 	if (current_point.position == _target_position) {
 		reconstruct_path(current_point_index);
+		_path_cost = current_point.gscore;
 		_is_running = false;
 		return;
 	}
@@ -104,6 +114,10 @@ void AStarGrid3D::step() {
 	get_neighbor_positions(current_point.position, _neighbor_positions);
 
 	for (const Vector3i npos : _neighbor_positions) {
+		if (!_search_box.contains(npos)) {
+			continue;
+		}
+
 		uint32_t neighbor_point_index;
 		auto it = _points_map.find(npos);
 
@@ -128,9 +142,7 @@ void AStarGrid3D::step() {
 			_points_map.insert({ npos, neighbor_point_index });
 		}
 
-		const Vector3i neighbor_dir = npos - current_point.position;
-		const float edge_cost = math::length(to_vec3f(neighbor_dir)); // neighbor_dir.length();
-		const float tentative_gscore = current_point.gscore + edge_cost;
+		const float tentative_gscore = current_point.gscore + get_step_cost(current_point.position, npos);
 
 		Point &neighbor_point = _points_pool[neighbor_point_index];
 
@@ -156,6 +168,21 @@ void AStarGrid3D::step() {
 	}
 }
 
+float AStarGrid3D::get_step_cost(Vector3i from_position, Vector3i to_position) {
+	const Vector3i dir = to_position - from_position;
+	return math::length(to_vec3f(dir));
+}
+
+bool AStarGrid3D::is_valid_position(Vector3i pos) {
+	return _region.contains(pos) && fits(to_vec3f(pos) + Vector3f(0.5f) + _fitting_offset, _agent_size * 0.5f);
+}
+
+int AStarGrid3D::get_cell_dependency_margin() const {
+	// Moves check if the agent fits around the source and destination, and if there is ground below the destination
+	const float agent_size = math::max(_agent_size.x, math::max(_agent_size.y, _agent_size.z));
+	return math::max(static_cast<int>(Math::ceil(agent_size)), _max_fall_height) + 2;
+}
+
 bool AStarGrid3D::is_solid(Vector3i pos) {
 	// Implemented in subclasses
 	return false;
@@ -307,6 +334,10 @@ Span<const Vector3i> AStarGrid3D::get_path() const {
 	return to_span(_path);
 }
 
+float AStarGrid3D::get_path_cost() const {
+	return _path_cost;
+}
+
 void AStarGrid3D::clear() {
 	_open_list.clear();
 	_points_map.clear();
@@ -314,6 +345,7 @@ void AStarGrid3D::clear() {
 	_path.clear();
 	_neighbor_positions.clear();
 	_is_running = false;
+	_path_cost = -1.f;
 }
 
 float AStarGrid3D::evaluate_heuristic(Vector3i pos, Vector3i target_pos) const {
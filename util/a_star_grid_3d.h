@@ -35,11 +35,25 @@ public:
 	}
 
 	void start(Vector3i from_position, Vector3i target_position);
+	// Same as `start`, but only visits positions inside `search_box`, which must be within the region. Positions
+	// outside are still checked to know if the agent can move between visited positions.
+	void start(Vector3i from_position, Vector3i target_position, Box3i search_box);
 	void step();
 	bool is_running() const;
 	Span<const Vector3i> get_path() const;
+	// Cost of the last path found, or -1 if no path was found.
+	float get_path_cost() const;
 	void clear();
 
+	// Gets positions the agent can move to from the given position in a single step.
+	void get_neighbor_positions(Vector3i pos, StdVector<Vector3i> &out_positions);
+	// Tells if the agent fits at the given position.
+	bool is_valid_position(Vector3i pos);
+	// Gets how far from a position cells can be, while still affecting moves from or to that position.
+	int get_cell_dependency_margin() const;
+	// Cost of a single step
+	static float get_step_cost(Vector3i from_position, Vector3i to_position);
+
 	// Debug
 
 	void debug_get_visited_points(StdVector<Vector3i> &out_positions) const;
@@ -49,9 +63,9 @@ protected:
 	virtual bool is_solid(Vector3i pos);
 
 private:
+	void update_fitting_offset();
 	float evaluate_heuristic(Vector3i pos, Vector3i target_pos) const;
 	void reconstruct_path(uint32_t end_point_index);
-	void get_neighbor_positions(Vector3i pos, StdVector<Vector3i> &out_positions);
 	bool is_ground_close_enough(Vector3i pos);
 	bool fits(Vector3f pos, Vector3f agent_extents);
 
@@ -152,6 +166,8 @@ private:
 	float _max_path_cost = 1000.f;
 
 	Box3i _region;
+	Box3i _search_box;
+	float _path_cost = -1.f;
 	StdVector<Point> _points_pool;
 	PriorityQueue _open_list;
 
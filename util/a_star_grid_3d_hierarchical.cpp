@@ -0,0 +1,549 @@
+#include "a_star_grid_3d_hierarchical.h"
+#include "../util/memory/memory.h"
+#include "../util/profiling.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace zylann {
+
+namespace {
+
+struct CostAndPosition {
+	float cost;
+	Vector3i position;
+
+	inline bool operator>(const CostAndPosition &other) const {
+		return cost > other.cost;
+	}
+};
+
+// Visits positions reachable from `from_position` without leaving `box`, by increasing cost.
+// `f(Vector3i pos, float cost)` is called once for each of them, and returns false to stop the search.
+template <typename F>
+void for_each_reachable_position(AStarGrid3D &grid, Vector3i from_position, const Box3i &box, F f) {
+	StdUnorderedMap<Vector3i, float> costs;
+	std::priority_queue<CostAndPosition, StdVector<CostAndPosition>, std::greater<CostAndPosition>> open_list;
+	StdVector<Vector3i> neighbors;
+
+	costs.insert({ from_position, 0.f });
+	open_list.push(CostAndPosition{ 0.f, from_position });
+
+	while (open_list.size() > 0) {
+		const CostAndPosition current = open_list.top();
+		open_list.pop();
+
+		if (current.cost > costs[current.position]) {
+			// Outdated entry, the position was reached with a lower cost since then
+			continue;
+		}
+		if (!f(current.position, current.cost)) {
+			return;
+		}
+
+		neighbors.clear();
+		grid.get_neighbor_positions(current.position, neighbors);
+
+		for (const Vector3i npos : neighbors) {
+			if (!box.contains(npos)) {
+				continue;
+			}
+			const float cost = current.cost + AStarGrid3D::get_step_cost(current.position, npos);
+			auto it = costs.find(npos);
+			if (it == costs.end()) {
+				costs.insert({ npos, cost });
+			} else if (cost < it->second) {
+				it->second = cost;
+			} else {
+				continue;
+			}
+			open_list.push(CostAndPosition{ cost, npos });
+		}
+	}
+}
+
+inline bool are_adjacent(Vector3i a, Vector3i b) {
+	const Vector3i d = a - b;
+	return Math::abs(d.x) <= 1 && Math::abs(d.y) <= 1 && Math::abs(d.z) <= 1;
+}
+
+// Move crossing the side of a cluster
+struct Crossing {
+	Vector3i from_position;
+	Vector3i to_position;
+	// Clusters on both sides
+	Vector3i from_cluster;
+	Vector3i to_cluster;
+};
+
+// The same crossings are found by the clusters on both sides of them, and must produce the same portals. So they are
+// ordered only by their positions, which doesn't depend on which cluster they are found from.
+inline bool operator<(const Crossing &a, const Crossing &b) {
+	if (a.from_cluster != b.from_cluster) {
+		return a.from_cluster < b.from_cluster;
+	}
+	if (a.to_cluster != b.to_cluster) {
+		return a.to_cluster < b.to_cluster;
+	}
+	if (a.from_position != b.from_position) {
+		return a.from_position < b.from_position;
+	}
+	return a.to_position < b.to_position;
+}
+
+// Groups crossings of adjacent positions going between the same two clusters, and picks one in the middle of each
+// group. `crossings` must be sorted.
+void pick_representative_crossings(Span<const Crossing> crossings, StdVector<Crossing> &out_crossings) {
+	StdVector<uint32_t> group_ids;
+	StdVector<uint32_t> group_members;
+
+	unsigned int begin = 0;
+	while (begin < crossings.size()) {
+		// Crossings between the same two clusters
+		unsigned int end = begin + 1;
+		while (end < crossings.size() && crossings[end].from_cluster == crossings[begin].from_cluster &&
+			   crossings[end].to_cluster == crossings[begin].to_cluster) {
+			++end;
+		}
+
+		// Connected groups, by flood fill
+		const unsigned int count = end - begin;
+		const uint32_t NO_GROUP = std::numeric_limits<uint32_t>::max();
+		group_ids.clear();
+		group_ids.resize(count, NO_GROUP);
+
+		for (unsigned int seed = 0; seed < count; ++seed) {
+			if (group_ids[seed] != NO_GROUP) {
+				continue;
+			}
+			group_members.clear();
+			group_members.push_back(seed);
+			group_ids[seed] = seed;
+
+			for (unsigned int mi = 0; mi < group_members.size(); ++mi) {
+				const Crossing &member = crossings[begin + group_members[mi]];
+				for (unsigned int other = seed + 1; other < count; ++other) {
+					if (group_ids[other] != NO_GROUP) {
+						continue;
+					}
+					const Crossing &c = crossings[begin + other];
+					if (are_adjacent(member.from_position, c.from_position) &&
+						are_adjacent(member.to_position, c.to_position)) {
+						group_ids[other] = seed;
+						group_members.push_back(other);
+					}
+				}
+			}
+
+			std::sort(group_members.begin(), group_members.end());
+			out_crossings.push_back(crossings[begin + group_members[group_members.size() / 2]]);
+		}
+
+		begin = end;
+	}
+}
+
+unsigned int add_portal(StdVector<Vector3i> &portals, Vector3i pos) {
+	for (unsigned int i = 0; i < portals.size(); ++i) {
+		if (portals[i] == pos) {
+			return i;
+		}
+	}
+	portals.push_back(pos);
+	return portals.size() - 1;
+}
+
+} // namespace
+
+int HierarchicalAStarGrid3D::Cluster::find_portal(Vector3i pos) const {
+	for (unsigned int i = 0; i < portals.size(); ++i) {
+		if (portals[i] == pos) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void HierarchicalAStarGrid3D::set_cluster_size_po2(unsigned int po2) {
+	ZN_ASSERT_RETURN(po2 >= 2 && po2 <= 6);
+	MutexLock mlock(_mutex);
+	if (po2 != _cluster_size_po2) {
+		_cluster_size_po2 = po2;
+		_clusters.clear();
+		++_generation;
+	}
+}
+
+Box3i HierarchicalAStarGrid3D::get_cluster_box(Vector3i cluster_position, const AStarGrid3D &grid) const {
+	return Box3i(cluster_position << _cluster_size_po2, Vector3iUtil::create(1 << _cluster_size_po2))
+			.clipped(grid.get_region());
+}
+
+void HierarchicalAStarGrid3D::invalidate_area(Box3i box, const AStarGrid3D &grid) {
+	ZN_PROFILE_SCOPE();
+	const Box3i clusters_box = box.padded(grid.get_cell_dependency_margin()).downscaled(1 << _cluster_size_po2);
+
+	MutexLock mlock(_mutex);
+	++_generation;
+
+	if (Vector3iUtil::get_volume(clusters_box.size) < static_cast<int64_t>(_clusters.size())) {
+		clusters_box.for_each_cell([this](Vector3i cpos) { _clusters.erase(cpos); });
+	} else {
+		for (auto it = _clusters.begin(); it != _clusters.end();) {
+			if (clusters_box.contains(it->first)) {
+				it = _clusters.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+void HierarchicalAStarGrid3D::clear() {
+	MutexLock mlock(_mutex);
+	_clusters.clear();
+	++_generation;
+}
+
+unsigned int HierarchicalAStarGrid3D::get_cached_cluster_count() const {
+	MutexLock mlock(_mutex);
+	return _clusters.size();
+}
+
+std::shared_ptr<const HierarchicalAStarGrid3D::Cluster> HierarchicalAStarGrid3D::get_cluster(
+		AStarGrid3D &grid,
+		Vector3i cluster_position
+) {
+	uint32_t generation;
+	{
+		MutexLock mlock(_mutex);
+		auto it = _clusters.find(cluster_position);
+		if (it != _clusters.end()) {
+			return it->second;
+		}
+		generation = _generation;
+	}
+
+	// Built without locking, so other threads can keep searching meanwhile. Two threads could end up building the
+	// same cluster, but that should be rare.
+	std::shared_ptr<Cluster> cluster = make_shared_instance<Cluster>();
+	build_cluster(grid, cluster_position, *cluster);
+
+	{
+		MutexLock mlock(_mutex);
+		if (generation == _generation) {
+			auto it = _clusters.find(cluster_position);
+			if (it != _clusters.end()) {
+				return it->second;
+			}
+			_clusters.insert({ cluster_position, cluster });
+		}
+		// Else, cells might have changed while it was being built. It is still used for the current search.
+	}
+
+	return cluster;
+}
+
+void HierarchicalAStarGrid3D::build_cluster(AStarGrid3D &grid, Vector3i cluster_position, Cluster &cluster) const {
+	ZN_PROFILE_SCOPE();
+
+	const Box3i box = get_cluster_box(cluster_position, grid);
+	if (box.is_empty()) {
+		cluster.edges_begin.push_back(0);
+		return;
+	}
+
+	StdVector<Crossing> crossings;
+	StdVector<Vector3i> neighbors;
+
+	// Moves can only go to adjacent positions, so only those near the sides of the cluster can cross them. Those
+	// leaving the cluster start from inside, and those entering start from outside.
+	const Box3i inner_box = box.padded(-1);
+	box.padded(1).clipped(grid.get_region()).for_each_cell([&](Vector3i pos) {
+		const bool inside = box.contains(pos);
+		if (inside && inner_box.contains(pos)) {
+			return;
+		}
+		if (!grid.is_valid_position(pos)) {
+			return;
+		}
+		neighbors.clear();
+		grid.get_neighbor_positions(pos, neighbors);
+		for (const Vector3i npos : neighbors) {
+			if (box.contains(npos) != inside) {
+				crossings.push_back(Crossing{
+						pos, npos, pos >> _cluster_size_po2, npos >> _cluster_size_po2 //
+				});
+			}
+		}
+	});
+
+	std::sort(crossings.begin(), crossings.end());
+
+	StdVector<Crossing> portal_crossings;
+	pick_representative_crossings(to_span(crossings), portal_crossings);
+
+	for (const Crossing &crossing : portal_crossings) {
+		if (crossing.from_cluster == cluster_position) {
+			const unsigned int portal_index = add_portal(cluster.portals, crossing.from_position);
+			cluster.exits.push_back(Cluster::Exit{
+					portal_index,
+					crossing.to_position,
+					AStarGrid3D::get_step_cost(crossing.from_position, crossing.to_position) //
+			});
+		} else {
+			add_portal(cluster.portals, crossing.to_position);
+		}
+	}
+
+	// Costs between portals
+	for (unsigned int portal_index = 0; portal_index < cluster.portals.size(); ++portal_index) {
+		cluster.edges_begin.push_back(cluster.edges.size());
+
+		unsigned int remaining_count = cluster.portals.size() - 1;
+		if (remaining_count == 0) {
+			continue;
+		}
+
+		for_each_reachable_position(
+				grid,
+				cluster.portals[portal_index],
+				box,
+				[&cluster, portal_index, &remaining_count](Vector3i pos, float cost) {
+					const int other_portal_index = cluster.find_portal(pos);
+					if (other_portal_index != -1 && other_portal_index != static_cast<int>(portal_index)) {
+						cluster.edges.push_back(Cluster::Edge{ static_cast<uint32_t>(other_portal_index), cost });
+						--remaining_count;
+					}
+					return remaining_count > 0;
+				}
+		);
+	}
+	cluster.edges_begin.push_back(cluster.edges.size());
+}
+
+bool HierarchicalAStarGrid3D::find_path(
+		AStarGrid3D &grid,
+		Vector3i from_position,
+		Vector3i target_position,
+		StdVector<Vector3i> &out_path
+) {
+	ZN_PROFILE_SCOPE();
+
+	out_path.clear();
+
+	const Box3i region = grid.get_region();
+	if (!region.contains(from_position) || !region.contains(target_position)) {
+		return false;
+	}
+
+	const Vector3i from_cluster_position = from_position >> _cluster_size_po2;
+	const Vector3i target_cluster_position = target_position >> _cluster_size_po2;
+	const Box3i target_cluster_box = get_cluster_box(target_cluster_position, grid);
+
+	// Try a direct path first if both positions are in the same cluster
+	if (from_cluster_position == target_cluster_position) {
+		grid.start(from_position, target_position, target_cluster_box);
+		while (grid.is_running()) {
+			grid.step();
+		}
+		if (grid.get_path_cost() >= 0.f) {
+			const Span<const Vector3i> path = grid.get_path();
+			out_path.insert(out_path.end(), path.data(), path.data() + path.size());
+			return true;
+		}
+	}
+
+	// Clusters are kept alive while the search uses them, in case they get invalidated meanwhile
+	StdUnorderedMap<Vector3i, std::shared_ptr<const Cluster>> clusters;
+	auto get_cluster_cached = [this, &grid, &clusters](Vector3i cpos) -> const Cluster & {
+		auto it = clusters.find(cpos);
+		if (it != clusters.end()) {
+			return *it->second;
+		}
+		std::shared_ptr<const Cluster> cluster = get_cluster(grid, cpos);
+		clusters.insert({ cpos, cluster });
+		return *cluster;
+	};
+
+	const Cluster &from_cluster = get_cluster_cached(from_cluster_position);
+	const Cluster &target_cluster = get_cluster_cached(target_cluster_position);
+
+	// Costs to leave the start cluster
+	StdVector<Cluster::Edge> from_edges;
+	{
+		unsigned int remaining_count = from_cluster.portals.size();
+		if (remaining_count > 0) {
+			for_each_reachable_position(
+					grid,
+					from_position,
+					get_cluster_box(from_cluster_position, grid),
+					[&from_cluster, &from_edges, &remaining_count](Vector3i pos, float cost) {
+						const int portal_index = from_cluster.find_portal(pos);
+						if (portal_index != -1) {
+							from_edges.push_back(Cluster::Edge{ static_cast<uint32_t>(portal_index), cost });
+							--remaining_count;
+						}
+						return remaining_count > 0;
+					}
+			);
+		}
+	}
+
+	// Costs to reach the target from portals of its cluster.
+	// Moves are not always reversible (like falling), so a search is done from each portal.
+	StdVector<float> target_costs;
+	target_costs.resize(target_cluster.portals.size(), -1.f);
+	for (unsigned int portal_index = 0; portal_index < target_cluster.portals.size(); ++portal_index) {
+		grid.start(target_cluster.portals[portal_index], target_position, target_cluster_box);
+		while (grid.is_running()) {
+			grid.step();
+		}
+		target_costs[portal_index] = grid.get_path_cost();
+	}
+
+	// Search over portals
+
+	struct Node {
+		Vector3i position;
+		float gscore;
+		uint32_t came_from;
+		bool closed;
+	};
+
+	const uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+	StdVector<Node> nodes;
+	StdUnorderedMap<Vector3i, uint32_t> node_indices;
+
+	struct OpenItem {
+		float fscore;
+		uint32_t node_index;
+
+		inline bool operator>(const OpenItem &other) const {
+			return fscore > other.fscore;
+		}
+	};
+
+	std::priority_queue<OpenItem, StdVector<OpenItem>, std::greater<OpenItem>> open_list;
+
+	const float max_path_cost = grid.get_max_path_cost();
+
+	auto visit = [&](Vector3i pos, uint32_t came_from, float gscore) {
+		if (gscore >= max_path_cost) {
+			return;
+		}
+		uint32_t node_index;
+		auto it = node_indices.find(pos);
+		if (it == node_indices.end()) {
+			node_index = nodes.size();
+			nodes.push_back(Node{ pos, gscore, came_from, false });
+			node_indices.insert({ pos, node_index });
+		} else {
+			node_index = it->second;
+			Node &node = nodes[node_index];
+			// Same epsilon as `AStarGrid3D`
+			if (node.closed || gscore + 0.001f >= node.gscore) {
+				return;
+			}
+			node.gscore = gscore;
+			node.came_from = came_from;
+		}
+		const Vector3i d = target_position - pos;
+		// Manhattan, like `AStarGrid3D`
+		const float heuristic = Math::abs(d.x) + Math::abs(d.y) + Math::abs(d.z);
+		open_list.push(OpenItem{ gscore + heuristic, node_index });
+	};
+
+	// The start is always the first node. The target can only be reached from portals of its cluster.
+	nodes.push_back(Node{ from_position, 0.f, NO_NODE, true });
+	node_indices.insert({ from_position, 0 });
+
+	for (const Cluster::Edge &edge : from_edges) {
+		visit(from_cluster.portals[edge.to_portal_index], 0, edge.cost);
+	}
+
+	uint32_t target_node_index = NO_NODE;
+
+	while (open_list.size() > 0) {
+		const OpenItem item = open_list.top();
+		open_list.pop();
+
+		Node &node = nodes[item.node_index];
+		if (node.closed) {
+			continue;
+		}
+		node.closed = true;
+
+		const Vector3i pos = node.position;
+		const float gscore = node.gscore;
+
+		if (pos == target_position) {
+			target_node_index = item.node_index;
+			break;
+		}
+
+		const Vector3i cluster_position = pos >> _cluster_size_po2;
+		const Cluster &cluster = get_cluster_cached(cluster_position);
+		const int portal_index = cluster.find_portal(pos);
+		if (portal_index == -1) {
+			// Cluster got rebuilt differently since the node was found
+			continue;
+		}
+
+		for (unsigned int ei = cluster.edges_begin[portal_index]; ei < cluster.edges_begin[portal_index + 1]; ++ei) {
+			const Cluster::Edge &edge = cluster.edges[ei];
+			visit(cluster.portals[edge.to_portal_index], item.node_index, gscore + edge.cost);
+		}
+
+		for (const Cluster::Exit &exit : cluster.exits) {
+			if (exit.from_portal_index == static_cast<uint32_t>(portal_index)) {
+				visit(exit.to_position, item.node_index, gscore + exit.cost);
+			}
+		}
+
+		if (cluster_position == target_cluster_position && target_costs[portal_index] >= 0.f) {
+			visit(target_position, item.node_index, gscore + target_costs[portal_index]);
+		}
+	}
+
+	if (target_node_index == NO_NODE) {
+		return false;
+	}
+
+	// Refine the path between each portal
+
+	StdVector<Vector3i> portal_path;
+	for (uint32_t node_index = target_node_index; node_index != NO_NODE; node_index = nodes[node_index].came_from) {
+		portal_path.push_back(nodes[node_index].position);
+	}
+	std::reverse(portal_path.begin(), portal_path.end());
+
+	for (unsigned int i = 0; i + 1 < portal_path.size(); ++i) {
+		const Vector3i a = portal_path[i];
+		const Vector3i b = portal_path[i + 1];
+		const Vector3i cluster_position = a >> _cluster_size_po2;
+
+		if (cluster_position != (b >> _cluster_size_po2)) {
+			// Single move between two clusters
+			out_path.push_back(a);
+			continue;
+		}
+
+		grid.start(a, b, get_cluster_box(cluster_position, grid));
+		while (grid.is_running()) {
+			grid.step();
+		}
+		if (grid.get_path_cost() < 0.f) {
+			// Could happen if cells changed during the search
+			out_path.clear();
+			return false;
+		}
+		const Span<const Vector3i> path = grid.get_path();
+		out_path.insert(out_path.end(), path.data(), path.data() + path.size());
+	}
+
+	return true;
+}
+
+} // namespace zylann
@@ -0,0 +1,79 @@
+#ifndef ZN_ASTAR_GRID_3D_HIERARCHICAL_H
+#define ZN_ASTAR_GRID_3D_HIERARCHICAL_H
+
+#include "a_star_grid_3d.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/containers/std_vector.h"
+#include "../util/math/box3i.h"
+#include "../util/thread/mutex.h"
+#include <memory>
+
+namespace zylann {
+
+// Finds long paths on an `AStarGrid3D` in two levels, similar to HPA*.
+// The grid is divided into cubic clusters. Moves between two clusters are grouped into portals, and the cost to go from
+// one portal to another within the same cluster is computed once and cached. Paths are first searched over portals,
+// then refined with regular searches restricted to each cluster along the way.
+// Paths are usually slightly longer than those `AStarGrid3D` finds, but searches visit much fewer positions over long
+// distances.
+//
+// Cached clusters must be invalidated when cells change, using `invalidate_area`.
+// Several searches can run at the same time from different threads, as long as each uses its own `AStarGrid3D`.
+// These must all be configured the same way.
+class HierarchicalAStarGrid3D {
+public:
+	void set_cluster_size_po2(unsigned int po2);
+	unsigned int get_cluster_size_po2() const {
+		return _cluster_size_po2;
+	}
+
+	// Searches a path, using the region and agent settings of `grid`. The path has the same format as
+	// `AStarGrid3D::get_path`. Returns false if no path was found.
+	bool find_path(AStarGrid3D &grid, Vector3i from_position, Vector3i target_position, StdVector<Vector3i> &out_path);
+
+	// Removes cached clusters that could be affected by changes of cells in the given box.
+	void invalidate_area(Box3i box, const AStarGrid3D &grid);
+	void clear();
+
+	unsigned int get_cached_cluster_count() const;
+
+private:
+	struct Cluster {
+		struct Edge {
+			uint32_t to_portal_index;
+			float cost;
+		};
+
+		struct Exit {
+			uint32_t from_portal_index;
+			// Portal of a neighbor cluster
+			Vector3i to_position;
+			float cost;
+		};
+
+		// Positions through which paths enter or leave the cluster
+		StdVector<Vector3i> portals;
+		// Edges going out of each portal, to other portals reachable without leaving the cluster.
+		// Edges of portal `i` start at `edges_begin[i]` and end at `edges_begin[i + 1]`.
+		StdVector<uint32_t> edges_begin;
+		StdVector<Edge> edges;
+		StdVector<Exit> exits;
+
+		int find_portal(Vector3i pos) const;
+	};
+
+	Box3i get_cluster_box(Vector3i cluster_position, const AStarGrid3D &grid) const;
+	std::shared_ptr<const Cluster> get_cluster(AStarGrid3D &grid, Vector3i cluster_position);
+	void build_cluster(AStarGrid3D &grid, Vector3i cluster_position, Cluster &cluster) const;
+
+	unsigned int _cluster_size_po2 = 4;
+
+	StdUnorderedMap<Vector3i, std::shared_ptr<const Cluster>> _clusters;
+	// Incremented on invalidation, so clusters built from cells that changed meanwhile don't get cached
+	uint32_t _generation = 0;
+	Mutex _mutex;
+};
+
+} // namespace zylann
+
+#endif // ZN_ASTAR_GRID_3D_HIERARCHICAL_H
@@ -0,0 +1,15 @@
+#ifndef ZN_STD_DEQUE_H
+#define ZN_STD_DEQUE_H
+
+#include "../memory/std_allocator.h"
+#include <deque>
+
+namespace zylann {
+
+// Convenience alias that uses our own default allocator
+template <typename TValue, typename TAllocator = StdDefaultAllocator<TValue>>
+using StdDeque = std::deque<TValue, TAllocator>;
+
+} // namespace zylann
+
+#endif // ZN_STD_DEQUE_H
@@ -0,0 +1,338 @@
+#include "dynamic_aabb_tree.h"
+#include "math/funcs.h"
+
+namespace zylann {
+
+namespace {
+
+// Boxes are enlarged by this fraction of their size, plus a constant amount
+const float FAT_MARGIN_RATIO = 0.1f;
+const float FAT_MARGIN_CONSTANT = 1.f;
+
+inline float get_half_surface_area(Vector3f min_pos, Vector3f max_pos) {
+	const Vector3f size = max_pos - min_pos;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+inline bool contains(Vector3f outer_min, Vector3f outer_max, Vector3f inner_min, Vector3f inner_max) {
+	return outer_min.x <= inner_min.x && outer_min.y <= inner_min.y && outer_min.z <= inner_min.z &&
+			outer_max.x >= inner_max.x && outer_max.y >= inner_max.y && outer_max.z >= inner_max.z;
+}
+
+inline void get_fat_box(Vector3f min_pos, Vector3f max_pos, Vector3f &out_min, Vector3f &out_max) {
+	const Vector3f margin = (max_pos - min_pos) * FAT_MARGIN_RATIO + Vector3f(FAT_MARGIN_CONSTANT);
+	out_min = min_pos - margin;
+	out_max = max_pos + margin;
+}
+
+} // namespace
+
+uint32_t DynamicAABBTree::allocate_node() {
+	uint32_t i;
+	if (_free_list != NULL_NODE) {
+		i = _free_list;
+		_free_list = _nodes[i].parent;
+	} else {
+		i = _nodes.size();
+		_nodes.push_back(Node());
+	}
+	Node &node = _nodes[i];
+	node.parent = NULL_NODE;
+	node.child0 = NULL_NODE;
+	node.child1 = NULL_NODE;
+	node.item = 0;
+	node.height = 0;
+	return i;
+}
+
+void DynamicAABBTree::free_node(uint32_t i) {
+	Node &node = _nodes[i];
+	node.parent = _free_list;
+	node.height = -1;
+	_free_list = i;
+}
+
+uint32_t DynamicAABBTree::create_leaf(Vector3f min_pos, Vector3f max_pos, uint32_t item) {
+	const uint32_t leaf = allocate_node();
+	Node &node = _nodes[leaf];
+	get_fat_box(min_pos, max_pos, node.min_pos, node.max_pos);
+	node.item = item;
+	insert_leaf(leaf);
+	++_leaf_count;
+	return leaf;
+}
+
+void DynamicAABBTree::destroy_leaf(uint32_t leaf) {
+	ZN_ASSERT_RETURN(leaf < _nodes.size());
+	ZN_ASSERT_RETURN(_nodes[leaf].is_leaf() && _nodes[leaf].height == 0);
+	remove_leaf(leaf);
+	free_node(leaf);
+	--_leaf_count;
+}
+
+bool DynamicAABBTree::move_leaf(uint32_t leaf, Vector3f min_pos, Vector3f max_pos) {
+	ZN_ASSERT_RETURN_V(leaf < _nodes.size(), false);
+	Node &node = _nodes[leaf];
+	ZN_ASSERT_RETURN_V(node.is_leaf() && node.height == 0, false);
+
+	Vector3f fat_min;
+	Vector3f fat_max;
+	get_fat_box(min_pos, max_pos, fat_min, fat_max);
+
+	if (contains(node.min_pos, node.max_pos, min_pos, max_pos)) {
+		// Still fits. Only re-insert if the box shrank a lot, otherwise it would produce many false positives
+		if (get_half_surface_area(node.min_pos, node.max_pos) <= 4.f * get_half_surface_area(fat_min, fat_max)) {
+			return false;
+		}
+	}
+
+	remove_leaf(leaf);
+	// Note, `remove_leaf` doesn't change the address of nodes
+	node.min_pos = fat_min;
+	node.max_pos = fat_max;
+	insert_leaf(leaf);
+	return true;
+}
+
+void DynamicAABBTree::clear() {
+	_nodes.clear();
+	_root = NULL_NODE;
+	_free_list = NULL_NODE;
+	_leaf_count = 0;
+}
+
+int DynamicAABBTree::get_height() const {
+	if (_root == NULL_NODE) {
+		return 0;
+	}
+	return _nodes[_root].height;
+}
+
+void DynamicAABBTree::insert_leaf(uint32_t leaf) {
+	if (_root == NULL_NODE) {
+		_root = leaf;
+		_nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	const Vector3f leaf_min = _nodes[leaf].min_pos;
+	const Vector3f leaf_max = _nodes[leaf].max_pos;
+
+	// Find the best sibling, descending towards the child that would grow the least
+	uint32_t sibling = _root;
+	while (!_nodes[sibling].is_leaf()) {
+		const Node &node = _nodes[sibling];
+
+		const float area = get_half_surface_area(node.min_pos, node.max_pos);
+		const float combined_area =
+				get_half_surface_area(math::min(node.min_pos, leaf_min), math::max(node.max_pos, leaf_max));
+
+		// Cost of creating a new parent for this node and the new leaf
+		const float cost = 2.f * combined_area;
+		// Minimum cost of pushing the leaf further down the tree
+		const float inheritance_cost = 2.f * (combined_area - area);
+
+		float child_costs[2];
+		const uint32_t children[2] = { node.child0, node.child1 };
+		for (unsigned int ci = 0; ci < 2; ++ci) {
+			const Node &child = _nodes[children[ci]];
+			const float new_area =
+					get_half_surface_area(math::min(child.min_pos, leaf_min), math::max(child.max_pos, leaf_max));
+			if (child.is_leaf()) {
+				child_costs[ci] = new_area + inheritance_cost;
+			} else {
+				child_costs[ci] = new_area - get_half_surface_area(child.min_pos, child.max_pos) + inheritance_cost;
+			}
+		}
+
+		if (cost < child_costs[0] && cost < child_costs[1]) {
+			break;
+		}
+		sibling = child_costs[0] < child_costs[1] ? node.child0 : node.child1;
+	}
+
+	// Create a new parent holding the sibling and the leaf
+	const uint32_t old_parent = _nodes[sibling].parent;
+	const uint32_t new_parent = allocate_node();
+	{
+		Node &np = _nodes[new_parent];
+		const Node &sn = _nodes[sibling];
+		np.parent = old_parent;
+		np.min_pos = math::min(sn.min_pos, leaf_min);
+		np.max_pos = math::max(sn.max_pos, leaf_max);
+		np.height = sn.height + 1;
+		np.child0 = sibling;
+		np.child1 = leaf;
+	}
+
+	if (old_parent != NULL_NODE) {
+		Node &op = _nodes[old_parent];
+		if (op.child0 == sibling) {
+			op.child0 = new_parent;
+		} else {
+			op.child1 = new_parent;
+		}
+	} else {
+		_root = new_parent;
+	}
+	_nodes[sibling].parent = new_parent;
+	_nodes[leaf].parent = new_parent;
+
+	refit_ancestors(new_parent);
+}
+
+void DynamicAABBTree::remove_leaf(uint32_t leaf) {
+	if (leaf == _root) {
+		_root = NULL_NODE;
+		return;
+	}
+
+	const uint32_t parent = _nodes[leaf].parent;
+	const uint32_t grand_parent = _nodes[parent].parent;
+	const uint32_t sibling = _nodes[parent].child0 == leaf ? _nodes[parent].child1 : _nodes[parent].child0;
+
+	// The sibling takes the place of the parent
+	if (grand_parent != NULL_NODE) {
+		Node &gp = _nodes[grand_parent];
+		if (gp.child0 == parent) {
+			gp.child0 = sibling;
+		} else {
+			gp.child1 = sibling;
+		}
+		_nodes[sibling].parent = grand_parent;
+		free_node(parent);
+		refit_ancestors(grand_parent);
+	} else {
+		_root = sibling;
+		_nodes[sibling].parent = NULL_NODE;
+		free_node(parent);
+	}
+}
+
+void DynamicAABBTree::refit_ancestors(uint32_t i) {
+	while (i != NULL_NODE) {
+		i = balance(i);
+
+		Node &node = _nodes[i];
+		const Node &child0 = _nodes[node.child0];
+		const Node &child1 = _nodes[node.child1];
+		node.height = 1 + math::max(child0.height, child1.height);
+		node.min_pos = math::min(child0.min_pos, child1.min_pos);
+		node.max_pos = math::max(child0.max_pos, child1.max_pos);
+
+		i = node.parent;
+	}
+}
+
+// If the subtree rooted at `a` is imbalanced, rotates it and returns the index of its new root.
+uint32_t DynamicAABBTree::balance(uint32_t ia) {
+	Node &a = _nodes[ia];
+	if (a.is_leaf() || a.height < 2) {
+		return ia;
+	}
+
+	const uint32_t ib = a.child0;
+	const uint32_t ic = a.child1;
+	Node &b = _nodes[ib];
+	Node &c = _nodes[ic];
+
+	const int balance = c.height - b.height;
+
+	if (balance > 1) {
+		// Rotate C up
+		const uint32_t i_f = c.child0;
+		const uint32_t ig = c.child1;
+		Node &f = _nodes[i_f];
+		Node &g = _nodes[ig];
+
+		c.child0 = ia;
+		c.parent = a.parent;
+		a.parent = ic;
+
+		if (c.parent != NULL_NODE) {
+			Node &cp = _nodes[c.parent];
+			if (cp.child0 == ia) {
+				cp.child0 = ic;
+			} else {
+				cp.child1 = ic;
+			}
+		} else {
+			_root = ic;
+		}
+
+		// Keep the tallest child of C, and give the other one to A
+		if (f.height > g.height) {
+			c.child1 = i_f;
+			a.child1 = ig;
+			g.parent = ia;
+			a.min_pos = math::min(b.min_pos, g.min_pos);
+			a.max_pos = math::max(b.max_pos, g.max_pos);
+			c.min_pos = math::min(a.min_pos, f.min_pos);
+			c.max_pos = math::max(a.max_pos, f.max_pos);
+			a.height = 1 + math::max(b.height, g.height);
+			c.height = 1 + math::max(a.height, f.height);
+		} else {
+			c.child1 = ig;
+			a.child1 = i_f;
+			f.parent = ia;
+			a.min_pos = math::min(b.min_pos, f.min_pos);
+			a.max_pos = math::max(b.max_pos, f.max_pos);
+			c.min_pos = math::min(a.min_pos, g.min_pos);
+			c.max_pos = math::max(a.max_pos, g.max_pos);
+			a.height = 1 + math::max(b.height, f.height);
+			c.height = 1 + math::max(a.height, g.height);
+		}
+		return ic;
+	}
+
+	if (balance < -1) {
+		// Rotate B up
+		const uint32_t id = b.child0;
+		const uint32_t ie = b.child1;
+		Node &d = _nodes[id];
+		Node &e = _nodes[ie];
+
+		b.child0 = ia;
+		b.parent = a.parent;
+		a.parent = ib;
+
+		if (b.parent != NULL_NODE) {
+			Node &bp = _nodes[b.parent];
+			if (bp.child0 == ia) {
+				bp.child0 = ib;
+			} else {
+				bp.child1 = ib;
+			}
+		} else {
+			_root = ib;
+		}
+
+		// Keep the tallest child of B, and give the other one to A
+		if (d.height > e.height) {
+			b.child1 = id;
+			a.child0 = ie;
+			e.parent = ia;
+			a.min_pos = math::min(c.min_pos, e.min_pos);
+			a.max_pos = math::max(c.max_pos, e.max_pos);
+			b.min_pos = math::min(a.min_pos, d.min_pos);
+			b.max_pos = math::max(a.max_pos, d.max_pos);
+			a.height = 1 + math::max(c.height, e.height);
+			b.height = 1 + math::max(a.height, d.height);
+		} else {
+			b.child1 = ie;
+			a.child0 = id;
+			d.parent = ia;
+			a.min_pos = math::min(c.min_pos, d.min_pos);
+			a.max_pos = math::max(c.max_pos, d.max_pos);
+			b.min_pos = math::min(a.min_pos, e.min_pos);
+			b.max_pos = math::max(a.max_pos, e.max_pos);
+			a.height = 1 + math::max(c.height, d.height);
+			b.height = 1 + math::max(a.height, e.height);
+		}
+		return ib;
+	}
+
+	return ia;
+}
+
+} // namespace zylann
@@ -0,0 +1,104 @@
+#ifndef ZN_DYNAMIC_AABB_TREE_H
+#define ZN_DYNAMIC_AABB_TREE_H
+
+#include "containers/fixed_array.h"
+#include "containers/std_vector.h"
+#include "errors.h"
+#include "math/vector3f.h"
+
+namespace zylann {
+
+// Bounding volume hierarchy of boxes that can be inserted, moved and removed one at a time, without rebuilding the
+// whole tree. Leaves store "fat" boxes, larger than the boxes they were given, so that small moves don't need to
+// change the tree. Queries may then return items whose actual box doesn't intersect, which have to be tested again.
+// The tree is kept balanced with rotations, similar to Box2D's dynamic tree.
+//
+// The tree is a plain array of nodes, so it can be copied cheaply to make a snapshot that other threads can query
+// while the original keeps being modified.
+class DynamicAABBTree {
+public:
+	static const uint32_t NULL_NODE = 0xffffffff;
+
+	// Inserts a box associated to the given item, and returns the identifier of the leaf holding it.
+	uint32_t create_leaf(Vector3f min_pos, Vector3f max_pos, uint32_t item);
+	void destroy_leaf(uint32_t leaf);
+	// Updates the box of a leaf. Returns true if the tree had to be changed, or false if the box still fits within the
+	// fat box of the leaf.
+	bool move_leaf(uint32_t leaf, Vector3f min_pos, Vector3f max_pos);
+	void clear();
+
+	uint32_t get_item(uint32_t leaf) const {
+		ZN_ASSERT(leaf < _nodes.size());
+		return _nodes[leaf].item;
+	}
+
+	unsigned int get_leaf_count() const {
+		return _leaf_count;
+	}
+
+	// Height of the tree, where a tree with only one leaf has a height of 0. Mostly for testing.
+	int get_height() const;
+
+	// Calls `f(item)` for every leaf whose fat box intersects the given box (inclusive).
+	template <typename F>
+	void query(Vector3f min_pos, Vector3f max_pos, F f) const {
+		if (_root == NULL_NODE) {
+			return;
+		}
+		// The tree is balanced so this is enough for billions of leaves
+		FixedArray<uint32_t, 64> stack;
+		unsigned int stack_size = 0;
+		stack[stack_size++] = _root;
+
+		while (stack_size > 0) {
+			const Node &node = _nodes[stack[--stack_size]];
+
+			if (node.min_pos.x > max_pos.x || node.min_pos.y > max_pos.y || node.min_pos.z > max_pos.z ||
+				node.max_pos.x < min_pos.x || node.max_pos.y < min_pos.y || node.max_pos.z < min_pos.z) {
+				continue;
+			}
+
+			if (node.is_leaf()) {
+				f(node.item);
+			} else {
+				ZN_ASSERT(stack_size + 2 <= stack.size());
+				stack[stack_size++] = node.child0;
+				stack[stack_size++] = node.child1;
+			}
+		}
+	}
+
+private:
+	struct Node {
+		Vector3f min_pos;
+		Vector3f max_pos;
+		// Next free node when the node is not used
+		uint32_t parent;
+		uint32_t child0;
+		uint32_t child1;
+		// Only used by leaves
+		uint32_t item;
+		// Leaves have a height of 0, free nodes have -1
+		int32_t height;
+
+		inline bool is_leaf() const {
+			return child0 == NULL_NODE;
+		}
+	};
+
+	uint32_t allocate_node();
+	void free_node(uint32_t i);
+	void insert_leaf(uint32_t leaf);
+	void remove_leaf(uint32_t leaf);
+	uint32_t balance(uint32_t a);
+	void refit_ancestors(uint32_t i);
+
+	StdVector<Node> _nodes;
+	uint32_t _root = NULL_NODE;
+	uint32_t _free_list = NULL_NODE;
+	unsigned int _leaf_count = 0;
+};
+
+} // namespace zylann
+
+#endif // ZN_DYNAMIC_AABB_TREE_H
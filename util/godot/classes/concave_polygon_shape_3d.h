@@ -21,11 +21,9 @@ using namespace godot;
 
 namespace zylann::godot {
 
-// Combines all mesh surface arrays into one collider.
-Ref<ConcavePolygonShape3D> create_concave_polygon_shape(Span<const Array> surfaces);
-Ref<ConcavePolygonShape3D> create_concave_polygon_shape(Span<const Vector3f> positions, Span<const int> indices);
-// Create shape from a sub-region of a mesh surface (starting at 0).
-Ref<ConcavePolygonShape3D> create_concave_polygon_shape(const Array surface_arrays, unsigned int index_count);
+// Creates a shape from a list of triangles, where each triangle is 3 consecutive positions.
+// Can be called from a thread, as long as the physics server supports it.
+Ref<ConcavePolygonShape3D> create_concave_polygon_shape_from_faces(Span<const Vector3f> faces);
 
 } // namespace zylann::godot
 
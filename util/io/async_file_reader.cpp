@@ -0,0 +1,392 @@
+#include "async_file_reader.h"
+#include "../containers/std_deque.h"
+#include "../errors.h"
+#include "../math/funcs.h"
+#include "../memory/memory.h"
+#include "../profiling.h"
+#include "../string/format.h"
+#include "log.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ZN_ASYNC_FILE_READER_IO_URING
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace zylann {
+
+#ifdef ZN_ASYNC_FILE_READER_IO_URING
+
+// Minimal io_uring wrapper using system calls directly, so we don't depend on liburing.
+// See https://kernel.dk/io_uring.pdf
+struct AsyncFileReader::Ring {
+	int fd = -1;
+	unsigned int entries = 0;
+
+	uint8_t *sq_ptr = nullptr;
+	size_t sq_size = 0;
+	uint8_t *cq_ptr = nullptr;
+	size_t cq_size = 0;
+	io_uring_sqe *sqes = nullptr;
+	size_t sqes_size = 0;
+
+	unsigned int *sq_tail = nullptr;
+	unsigned int *sq_mask = nullptr;
+	unsigned int *sq_array = nullptr;
+	unsigned int *cq_head = nullptr;
+	unsigned int *cq_tail = nullptr;
+	unsigned int *cq_mask = nullptr;
+	io_uring_cqe *cqes = nullptr;
+
+	// Reads added to the submission queue that the kernel didn't consume yet
+	unsigned int unsubmitted_count = 0;
+
+	bool init(unsigned int queue_depth) {
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+		if (fd < 0) {
+			fd = -1;
+			ZN_PRINT_VERBOSE(format("Could not setup io_uring: {}", strerror(errno)));
+			return false;
+		}
+
+		// `IORING_OP_READ` is available since kernel 5.6, but has no feature flag. `IORING_FEAT_FAST_POLL` came in 5.7,
+		// so checking it excludes 5.6, which is fine.
+		if ((params.features & IORING_FEAT_FAST_POLL) == 0) {
+			ZN_PRINT_VERBOSE("io_uring is too old to support reads without vectors");
+			deinit();
+			return false;
+		}
+
+		entries = params.sq_entries;
+
+		sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap) {
+			sq_size = math::max(sq_size, cq_size);
+			cq_size = sq_size;
+		}
+
+		void *sq = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (sq == MAP_FAILED) {
+			ZN_PRINT_ERROR(format("Could not map io_uring submission queue: {}", strerror(errno)));
+			deinit();
+			return false;
+		}
+		sq_ptr = static_cast<uint8_t *>(sq);
+
+		if (single_mmap) {
+			cq_ptr = sq_ptr;
+		} else {
+			void *cq =
+					mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+			if (cq == MAP_FAILED) {
+				ZN_PRINT_ERROR(format("Could not map io_uring completion queue: {}", strerror(errno)));
+				deinit();
+				return false;
+			}
+			cq_ptr = static_cast<uint8_t *>(cq);
+		}
+
+		sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		void *s = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (s == MAP_FAILED) {
+			ZN_PRINT_ERROR(format("Could not map io_uring submission entries: {}", strerror(errno)));
+			deinit();
+			return false;
+		}
+		sqes = static_cast<io_uring_sqe *>(s);
+
+		sq_tail = reinterpret_cast<unsigned int *>(sq_ptr + params.sq_off.tail);
+		sq_mask = reinterpret_cast<unsigned int *>(sq_ptr + params.sq_off.ring_mask);
+		sq_array = reinterpret_cast<unsigned int *>(sq_ptr + params.sq_off.array);
+		cq_head = reinterpret_cast<unsigned int *>(cq_ptr + params.cq_off.head);
+		cq_tail = reinterpret_cast<unsigned int *>(cq_ptr + params.cq_off.tail);
+		cq_mask = reinterpret_cast<unsigned int *>(cq_ptr + params.cq_off.ring_mask);
+		cqes = reinterpret_cast<io_uring_cqe *>(cq_ptr + params.cq_off.cqes);
+
+		return true;
+	}
+
+	void deinit() {
+		if (sqes != nullptr) {
+			munmap(sqes, sqes_size);
+			sqes = nullptr;
+		}
+		if (cq_ptr != nullptr && cq_ptr != sq_ptr) {
+			munmap(cq_ptr, cq_size);
+		}
+		cq_ptr = nullptr;
+		if (sq_ptr != nullptr) {
+			munmap(sq_ptr, sq_size);
+			sq_ptr = nullptr;
+		}
+		if (fd != -1) {
+			::close(fd);
+			fd = -1;
+		}
+	}
+
+	// Only one thread may add reads
+	void push_read(int file_fd, uint64_t offset, uint8_t *dst, uint32_t size, uint64_t user_data) {
+		const unsigned int tail = *sq_tail;
+		const unsigned int index = tail & *sq_mask;
+
+		io_uring_sqe &sqe = sqes[index];
+		memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_READ;
+		sqe.fd = file_fd;
+		sqe.off = offset;
+		sqe.addr = reinterpret_cast<uint64_t>(dst);
+		sqe.len = size;
+		sqe.user_data = user_data;
+
+		sq_array[index] = index;
+		// Make the entry visible to the kernel
+		__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+		++unsubmitted_count;
+	}
+
+	// Submits added reads and waits until at least one read completes.
+	bool submit_and_wait() {
+		while (true) {
+			const int res =
+					syscall(__NR_io_uring_enter, fd, unsubmitted_count, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (res >= 0) {
+				unsubmitted_count -= res;
+				return true;
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			ZN_PRINT_ERROR(format("io_uring_enter failed: {}", strerror(errno)));
+			return false;
+		}
+	}
+
+	template <typename F>
+	void reap_completions(F f) {
+		unsigned int head = *cq_head;
+		const unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+		while (head != tail) {
+			const io_uring_cqe &cqe = cqes[head & *cq_mask];
+			f(cqe.user_data, cqe.res);
+			++head;
+		}
+		__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+	}
+};
+
+#else
+
+struct AsyncFileReader::Ring {
+	bool init(unsigned int queue_depth) {
+		return false;
+	}
+	void deinit() {}
+};
+
+#endif
+
+bool AsyncFileReader::is_supported() {
+#ifdef ZN_ASYNC_FILE_READER_IO_URING
+	return true;
+#else
+	return false;
+#endif
+}
+
+AsyncFileReader::~AsyncFileReader() {
+	stop();
+}
+
+bool AsyncFileReader::start(unsigned int queue_depth) {
+	ZN_ASSERT_RETURN_V(!_running, false);
+	ZN_ASSERT_RETURN_V(queue_depth > 0, false);
+
+	if (!is_supported()) {
+		return false;
+	}
+
+	_ring = ZN_NEW(Ring);
+	if (!_ring->init(queue_depth)) {
+		ZN_DELETE(_ring);
+		_ring = nullptr;
+		return false;
+	}
+
+	_stop_requested = false;
+	_running = true;
+	_thread.start(thread_func_static, this);
+	return true;
+}
+
+void AsyncFileReader::stop() {
+	if (!_running) {
+		return;
+	}
+	{
+		MutexLock lock(_incoming_requests_mutex);
+		_stop_requested = true;
+	}
+	_semaphore.post();
+	_thread.wait_to_finish();
+
+	_ring->deinit();
+	ZN_DELETE(_ring);
+	_ring = nullptr;
+	_running = false;
+}
+
+void AsyncFileReader::submit(Request request) {
+	ZN_ASSERT(request.file != nullptr);
+	ZN_ASSERT(request.callback != nullptr);
+	++_pending_count;
+	{
+		MutexLock lock(_incoming_requests_mutex);
+		if (_running && !_stop_requested) {
+			_incoming_requests.push_back(std::move(request));
+			_semaphore.post();
+			return;
+		}
+	}
+	complete(request, false);
+}
+
+void AsyncFileReader::wait_for_all_requests() const {
+	while (_pending_count > 0) {
+		Thread::sleep_usec(500);
+	}
+}
+
+void AsyncFileReader::complete(Request &request, bool success) {
+	request.callback(request.userdata, success);
+	request.file.reset();
+	--_pending_count;
+}
+
+void AsyncFileReader::thread_func_static(void *p_data) {
+	AsyncFileReader *reader = static_cast<AsyncFileReader *>(p_data);
+	reader->thread_func();
+}
+
+void AsyncFileReader::thread_func() {
+#ifdef ZN_ASYNC_FILE_READER_IO_URING
+	Thread::set_name("Voxel async file reader");
+
+	Ring &ring = *_ring;
+
+	struct Slot {
+		Request request;
+		// How many bytes were read so far. Reads of regular files are rarely partial, but it can happen.
+		uint32_t done = 0;
+	};
+
+	// Requests in flight are indexed by the user data of their io_uring entry
+	StdVector<Slot> slots;
+	slots.resize(ring.entries);
+	StdVector<uint32_t> free_slots;
+	free_slots.reserve(ring.entries);
+	for (uint32_t i = ring.entries; i-- > 0;) {
+		free_slots.push_back(i);
+	}
+
+	StdDeque<Request> queued_requests;
+	unsigned int in_flight_count = 0;
+
+	while (true) {
+		bool stop_requested;
+		{
+			MutexLock lock(_incoming_requests_mutex);
+			for (Request &request : _incoming_requests) {
+				queued_requests.push_back(std::move(request));
+			}
+			_incoming_requests.clear();
+			stop_requested = _stop_requested;
+		}
+
+		if (stop_requested) {
+			while (queued_requests.size() > 0) {
+				complete(queued_requests.front(), false);
+				queued_requests.pop_front();
+			}
+		}
+
+		while (queued_requests.size() > 0 && free_slots.size() > 0) {
+			const uint32_t slot_index = free_slots.back();
+			free_slots.pop_back();
+			Slot &slot = slots[slot_index];
+			slot.request = std::move(queued_requests.front());
+			slot.done = 0;
+			queued_requests.pop_front();
+
+			Request &r = slot.request;
+			ring.push_read(r.file->get_fd(), r.offset, r.buffer.data(), r.buffer.size(), slot_index);
+			++in_flight_count;
+		}
+
+		if (in_flight_count == 0) {
+			if (stop_requested) {
+				break;
+			}
+			_semaphore.wait();
+			continue;
+		}
+
+		if (!ring.submit_and_wait()) {
+			// Not supposed to happen. Reads in flight still use their buffers, so we can't just give up on them.
+			Thread::sleep_usec(1000);
+		}
+
+		ZN_PROFILE_SCOPE_NAMED("Read completions");
+
+		ring.reap_completions([&slots, &free_slots, &in_flight_count, &ring, this](uint64_t user_data, int res) {
+			const uint32_t slot_index = user_data;
+			Slot &slot = slots[slot_index];
+			Request &r = slot.request;
+
+			if (res == -EINTR || res == -EAGAIN) {
+				// Try again
+				ring.push_read(
+						r.file->get_fd(), r.offset + slot.done, r.buffer.data() + slot.done,
+						r.buffer.size() - slot.done, slot_index
+				);
+				return;
+			}
+
+			bool success = false;
+			if (res < 0) {
+				ZN_PRINT_ERROR(format("Asynchronous file read failed: {}", strerror(-res)));
+
+			} else if (res > 0) {
+				slot.done += res;
+				if (slot.done < r.buffer.size()) {
+					// Partial read, request the rest
+					ring.push_read(
+							r.file->get_fd(), r.offset + slot.done, r.buffer.data() + slot.done,
+							r.buffer.size() - slot.done, slot_index
+					);
+					return;
+				}
+				success = true;
+			}
+			// else end of file was reached before filling the buffer
+
+			complete(r, success);
+			free_slots.push_back(slot_index);
+			--in_flight_count;
+		});
+	}
+#endif
+}
+
+} // namespace zylann
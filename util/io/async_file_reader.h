@@ -0,0 +1,85 @@
+#ifndef ZN_ASYNC_FILE_READER_H
+#define ZN_ASYNC_FILE_READER_H
+
+#include "../containers/span.h"
+#include "../containers/std_vector.h"
+#include "../thread/mutex.h"
+#include "../thread/semaphore.h"
+#include "../thread/thread.h"
+#include "read_only_file.h"
+
+#include <atomic>
+#include <memory>
+
+namespace zylann {
+
+// Reads parts of files from a dedicated thread, keeping many reads in flight at once instead of waiting for each of
+// them to complete. This allows fast storage devices to process reads in parallel.
+// Uses io_uring, so it is only available on Linux. Where it isn't supported, files should be read with
+// `ReadOnlyFile::read` from multiple threads instead.
+class AsyncFileReader {
+public:
+	struct Request {
+		// Kept alive until the request completes
+		std::shared_ptr<const ReadOnlyFile> file;
+		uint64_t offset = 0;
+		// Must remain valid until the request completes
+		Span<uint8_t> buffer;
+		// Called from the reader's thread when the request completes. It should return quickly, typically by
+		// scheduling a task processing the data. `success` is false if the buffer could not be filled entirely.
+		void (*callback)(void *userdata, bool success) = nullptr;
+		void *userdata = nullptr;
+	};
+
+	static bool is_supported();
+
+	AsyncFileReader() {}
+	~AsyncFileReader();
+
+	AsyncFileReader(const AsyncFileReader &) = delete;
+	AsyncFileReader &operator=(const AsyncFileReader &) = delete;
+
+	// Starts the thread. `queue_depth` is the maximum number of reads in flight.
+	// Returns false if the reader is not supported or could not be initialized (io_uring can be disabled by the
+	// system).
+	bool start(unsigned int queue_depth);
+	// Waits for reads in flight to complete and stops the thread. Requests that were not submitted yet complete as
+	// failed.
+	void stop();
+
+	inline bool is_running() const {
+		return _running;
+	}
+
+	// Thread-safe.
+	void submit(Request request);
+
+	// Gets how many requests haven't completed yet (their callback didn't return).
+	inline unsigned int get_pending_count() const {
+		return _pending_count;
+	}
+
+	// Blocks until all submitted requests have completed.
+	void wait_for_all_requests() const;
+
+private:
+	struct Ring;
+
+	static void thread_func_static(void *p_data);
+	void thread_func();
+	void complete(Request &request, bool success);
+
+	Thread _thread;
+	Ring *_ring = nullptr;
+	bool _running = false;
+
+	StdVector<Request> _incoming_requests;
+	Mutex _incoming_requests_mutex;
+	Semaphore _semaphore;
+	std::atomic_bool _stop_requested = { false };
+	std::atomic_uint32_t _pending_count = { 0 };
+};
+
+} // namespace zylann
+
+#endif // ZN_ASYNC_FILE_READER_H
@@ -0,0 +1,83 @@
+#include "memory_mapped_file.h"
+#include "../errors.h"
+#include "../string/format.h"
+#include "log.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#define ZN_MEMORY_MAPPED_FILE_POSIX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zylann {
+
+bool MemoryMappedFile::is_supported() {
+#ifdef ZN_MEMORY_MAPPED_FILE_POSIX
+	return true;
+#else
+	return false;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+	close();
+}
+
+bool MemoryMappedFile::open(const char *fpath) {
+	close();
+
+#ifdef ZN_MEMORY_MAPPED_FILE_POSIX
+	const int fd = ::open(fpath, O_RDONLY);
+	if (fd == -1) {
+		ZN_PRINT_ERROR(format("Could not open file \"{}\" for mapping: {}", fpath, strerror(errno)));
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		ZN_PRINT_ERROR(format("Could not get size of file \"{}\": {}", fpath, strerror(errno)));
+		::close(fd);
+		return false;
+	}
+
+	if (st.st_size == 0) {
+		// Empty files can't be mapped
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping remains valid after the file descriptor is closed
+	::close(fd);
+
+	if (data == MAP_FAILED) {
+		ZN_PRINT_ERROR(format("Could not map file \"{}\": {}", fpath, strerror(errno)));
+		return false;
+	}
+
+	_data = static_cast<const uint8_t *>(data);
+	_size = st.st_size;
+	return true;
+
+#else
+	ZN_PRINT_ERROR("Memory-mapped files are not supported on this platform");
+	return false;
+#endif
+}
+
+void MemoryMappedFile::close() {
+	if (_data == nullptr) {
+		return;
+	}
+#ifdef ZN_MEMORY_MAPPED_FILE_POSIX
+	munmap(const_cast<uint8_t *>(_data), _size);
+#endif
+	_data = nullptr;
+	_size = 0;
+}
+
+} // namespace zylann
@@ -0,0 +1,41 @@
+#ifndef ZN_MEMORY_MAPPED_FILE_H
+#define ZN_MEMORY_MAPPED_FILE_H
+
+#include "../containers/span.h"
+#include <cstdint>
+
+namespace zylann {
+
+// Read-only view of a whole file mapped into memory. Reading from it doesn't require system calls or intermediate
+// buffers, and can be done from multiple threads without locking, as long as the file isn't modified meanwhile.
+// Only available on POSIX platforms for now.
+class MemoryMappedFile {
+public:
+	static bool is_supported();
+
+	MemoryMappedFile() {}
+	~MemoryMappedFile();
+
+	MemoryMappedFile(const MemoryMappedFile &) = delete;
+	MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+	// Expects an absolute path in the filesystem (not `res://` or `user://`).
+	bool open(const char *fpath);
+	void close();
+
+	inline bool is_open() const {
+		return _data != nullptr;
+	}
+
+	inline Span<const uint8_t> get_data() const {
+		return Span<const uint8_t>(_data, _size);
+	}
+
+private:
+	const uint8_t *_data = nullptr;
+	size_t _size = 0;
+};
+
+} // namespace zylann
+
+#endif // ZN_MEMORY_MAPPED_FILE_H
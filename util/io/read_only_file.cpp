@@ -0,0 +1,83 @@
+#include "read_only_file.h"
+#include "../string/format.h"
+#include "log.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#define ZN_READ_ONLY_FILE_POSIX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace zylann {
+
+bool ReadOnlyFile::is_supported() {
+#ifdef ZN_READ_ONLY_FILE_POSIX
+	return true;
+#else
+	return false;
+#endif
+}
+
+ReadOnlyFile::~ReadOnlyFile() {
+	close();
+}
+
+bool ReadOnlyFile::open(const char *fpath) {
+	close();
+
+#ifdef ZN_READ_ONLY_FILE_POSIX
+	const int fd = ::open(fpath, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		ZN_PRINT_ERROR(format("Could not open file \"{}\" for reading: {}", fpath, strerror(errno)));
+		return false;
+	}
+	_fd = fd;
+	return true;
+
+#else
+	ZN_PRINT_ERROR("Read-only files are not supported on this platform");
+	return false;
+#endif
+}
+
+void ReadOnlyFile::close() {
+	if (_fd == -1) {
+		return;
+	}
+#ifdef ZN_READ_ONLY_FILE_POSIX
+	::close(_fd);
+#endif
+	_fd = -1;
+}
+
+bool ReadOnlyFile::read(uint64_t offset, Span<uint8_t> dst) const {
+#ifdef ZN_READ_ONLY_FILE_POSIX
+	if (_fd == -1) {
+		return false;
+	}
+	size_t done = 0;
+	while (done < dst.size()) {
+		const ssize_t res = ::pread(_fd, dst.data() + done, dst.size() - done, offset + done);
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ZN_PRINT_ERROR(format("Could not read file: {}", strerror(errno)));
+			return false;
+		}
+		if (res == 0) {
+			// End of file reached
+			return false;
+		}
+		done += res;
+	}
+	return true;
+
+#else
+	return false;
+#endif
+}
+
+} // namespace zylann
@@ -0,0 +1,44 @@
+#ifndef ZN_READ_ONLY_FILE_H
+#define ZN_READ_ONLY_FILE_H
+
+#include "../containers/span.h"
+#include <cstdint>
+
+namespace zylann {
+
+// File opened for reading at arbitrary positions. Reads don't modify the state of the file handle, so they can be done
+// from multiple threads without locking.
+// Only available on POSIX platforms for now.
+class ReadOnlyFile {
+public:
+	static bool is_supported();
+
+	ReadOnlyFile() {}
+	~ReadOnlyFile();
+
+	ReadOnlyFile(const ReadOnlyFile &) = delete;
+	ReadOnlyFile &operator=(const ReadOnlyFile &) = delete;
+
+	// Expects an absolute path in the filesystem (not `res://` or `user://`).
+	bool open(const char *fpath);
+	void close();
+
+	inline bool is_open() const {
+		return _fd != -1;
+	}
+
+	// Reads `dst.size()` bytes starting at `offset`. Returns false if an error occurred or if the file is too short.
+	bool read(uint64_t offset, Span<uint8_t> dst) const;
+
+	// Native file descriptor, for use with system APIs
+	inline int get_fd() const {
+		return _fd;
+	}
+
+private:
+	int _fd = -1;
+};
+
+} // namespace zylann
+
+#endif // ZN_READ_ONLY_FILE_H
@@ -0,0 +1,903 @@
+#include "simd.h"
+#include "../errors.h"
+#include "funcs.h"
+#include "sdf.h"
+#include "triangle.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ZN_SIMD_X86
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows using intrinsics of any instruction set without special flags
+#define ZN_SIMD_TARGET_SSE41
+#define ZN_SIMD_TARGET_AVX2
+#else
+// Kernels are compiled for their instruction set even if the rest of the module isn't, and only run if the CPU
+// supports it.
+#define ZN_SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define ZN_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif // x86
+
+#include <cstdint>
+
+namespace zylann::math::simd {
+
+namespace {
+
+Level detect_max_supported_level() {
+#if defined(ZN_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	const int max_function_id = info[0];
+	if (max_function_id < 1) {
+		return LEVEL_SCALAR;
+	}
+
+	__cpuid(info, 1);
+	const bool has_sse41 = (info[2] & (1 << 19)) != 0;
+	const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+	const bool has_avx = (info[2] & (1 << 28)) != 0;
+	// The OS must also save AVX registers when switching threads
+	const bool os_supports_avx = has_osxsave && has_avx && (_xgetbv(0) & 0x6) == 0x6;
+
+	bool has_avx2 = false;
+	if (max_function_id >= 7) {
+		__cpuidex(info, 7, 0);
+		has_avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (os_supports_avx && has_avx2) {
+		return LEVEL_AVX2;
+	}
+	if (has_sse41) {
+		return LEVEL_SSE41;
+	}
+	return LEVEL_SCALAR;
+
+#else
+	__builtin_cpu_init();
+	// Also checks that the OS supports AVX registers
+	if (__builtin_cpu_supports("avx2")) {
+		return LEVEL_AVX2;
+	}
+	if (__builtin_cpu_supports("sse4.1")) {
+		return LEVEL_SSE41;
+	}
+	return LEVEL_SCALAR;
+#endif
+
+#else
+	return LEVEL_SCALAR;
+#endif
+}
+
+const Level g_max_supported_level = detect_max_supported_level();
+Level g_level = g_max_supported_level;
+
+inline float get_table_scale(unsigned int table_size, float min_x, float max_x) {
+	const float range = max_x - min_x;
+	// Degenerate range samples the first value
+	return range > 0.f ? float(table_size - 1) / range : 0.f;
+}
+
+} // namespace
+
+// Reference implementations. Also used to process the remainder of arrays that don't fill a whole SIMD register.
+namespace scalar {
+
+void add(const float *a, const float *b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = a[i] + b[i];
+	}
+}
+
+void add_constant(const float *a, float b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = a[i] + b;
+	}
+}
+
+void subtract(const float *a, const float *b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = a[i] - b[i];
+	}
+}
+
+void subtract_constant(const float *a, float b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = a[i] - b;
+	}
+}
+
+void subtract_from_constant(float a, const float *b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = a - b[i];
+	}
+}
+
+void multiply(const float *a, const float *b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = a[i] * b[i];
+	}
+}
+
+void multiply_constant(const float *a, float b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = a[i] * b;
+	}
+}
+
+void min(const float *a, const float *b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::min(a[i], b[i]);
+	}
+}
+
+void min_constant(const float *a, float b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::min(a[i], b);
+	}
+}
+
+void max(const float *a, const float *b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::max(a[i], b[i]);
+	}
+}
+
+void max_constant(const float *a, float b, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::max(a[i], b);
+	}
+}
+
+void clamp(const float *x, const float *min, const float *max, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::clamp(x[i], min[i], max[i]);
+	}
+}
+
+void clamp_constant(const float *x, float min, float max, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::clamp(x[i], min, max);
+	}
+}
+
+void lerp(const float *a, const float *b, const float *t, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = Math::lerp(a[i], b[i], t[i]);
+	}
+}
+
+void sdf_sphere(const float *x, const float *y, const float *z, float radius, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = Math::sqrt(squared(x[i]) + squared(y[i]) + squared(z[i])) - radius;
+	}
+}
+
+void sdf_box(
+		const float *x,
+		const float *y,
+		const float *z,
+		float size_x,
+		float size_y,
+		float size_z,
+		float *out,
+		unsigned int count
+) {
+	const Vector3 size(size_x, size_y, size_z);
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::sdf_box(Vector3(x[i], y[i], z[i]), size);
+	}
+}
+
+void sdf_smooth_union(const float *a, const float *b, float smoothness, float *out, unsigned int count) {
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = math::sdf_smooth_union(a[i], b[i], smoothness);
+	}
+}
+
+void triangle_distance_squared(
+		float px,
+		float py,
+		float pz,
+		const float *coords,
+		unsigned int stride,
+		float *out,
+		unsigned int count
+) {
+	const Vector3f p(px, py, pz);
+	for (unsigned int i = 0; i < count; ++i) {
+		const float *c = coords + i;
+		const Vector3f v1(c[0], c[stride], c[2 * stride]);
+		const Vector3f v2(c[3 * stride], c[4 * stride], c[5 * stride]);
+		const Vector3f v3(c[6 * stride], c[7 * stride], c[8 * stride]);
+		out[i] = math::get_triangle_distance_squared(p, v1, v2, v3);
+	}
+}
+
+void sample_table(
+		const float *x,
+		const float *table,
+		unsigned int table_size,
+		float min_x,
+		float max_x,
+		float *out,
+		unsigned int count
+) {
+	const float scale = get_table_scale(table_size, min_x, max_x);
+	const float last_index = float(table_size - 1);
+	const unsigned int max_index = table_size - 2;
+	for (unsigned int i = 0; i < count; ++i) {
+		const float fi = math::min(math::max((x[i] - min_x) * scale, 0.f), last_index);
+		const unsigned int index = math::min(static_cast<unsigned int>(fi), max_index);
+		const float t = fi - float(index);
+		const float v0 = table[index];
+		const float v1 = table[index + 1];
+		out[i] = v0 + (v1 - v0) * t;
+	}
+}
+
+} // namespace scalar
+
+#ifdef ZN_SIMD_X86
+
+// Generates kernels for binary operations mapping to a single instruction, with array and constant variants.
+#define ZN_SIMD_DEFINE_BINOP(m_target, m_vec, m_width, m_load, m_store, m_set1, m_op, m_name)                         \
+	m_target void m_name(const float *a, const float *b, float *out, unsigned int count) {                             \
+		unsigned int i = 0;                                                                                            \
+		for (; i + m_width <= count; i += m_width) {                                                                   \
+			m_store(out + i, m_op(m_load(a + i), m_load(b + i)));                                                      \
+		}                                                                                                              \
+		scalar::m_name(a + i, b + i, out + i, count - i);                                                              \
+	}                                                                                                                  \
+	m_target void m_name##_constant(const float *a, float b, float *out, unsigned int count) {                         \
+		const m_vec vb = m_set1(b);                                                                                    \
+		unsigned int i = 0;                                                                                            \
+		for (; i + m_width <= count; i += m_width) {                                                                   \
+			m_store(out + i, m_op(m_load(a + i), vb));                                                                 \
+		}                                                                                                              \
+		scalar::m_name##_constant(a + i, b, out + i, count - i);                                                       \
+	}
+
+namespace sse41 {
+
+#define ZN_SIMD_DEFINE_BINOP_SSE41(m_op, m_name)                                                                       \
+	ZN_SIMD_DEFINE_BINOP(ZN_SIMD_TARGET_SSE41, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, m_op, m_name)
+
+ZN_SIMD_DEFINE_BINOP_SSE41(_mm_add_ps, add)
+ZN_SIMD_DEFINE_BINOP_SSE41(_mm_sub_ps, subtract)
+ZN_SIMD_DEFINE_BINOP_SSE41(_mm_mul_ps, multiply)
+// These have the same behavior as `math::min` and `math::max`, including with NaNs
+ZN_SIMD_DEFINE_BINOP_SSE41(_mm_min_ps, min)
+ZN_SIMD_DEFINE_BINOP_SSE41(_mm_max_ps, max)
+
+ZN_SIMD_TARGET_SSE41 void subtract_from_constant(float a, const float *b, float *out, unsigned int count) {
+	const __m128 va = _mm_set1_ps(a);
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(out + i, _mm_sub_ps(va, _mm_loadu_ps(b + i)));
+	}
+	scalar::subtract_from_constant(a, b + i, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_SSE41 void clamp(const float *x, const float *min, const float *max, float *out, unsigned int count) {
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 v = _mm_max_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(min + i));
+		_mm_storeu_ps(out + i, _mm_min_ps(v, _mm_loadu_ps(max + i)));
+	}
+	scalar::clamp(x + i, min + i, max + i, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_SSE41 void clamp_constant(const float *x, float min, float max, float *out, unsigned int count) {
+	const __m128 vmin = _mm_set1_ps(min);
+	const __m128 vmax = _mm_set1_ps(max);
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(x + i), vmin), vmax));
+	}
+	scalar::clamp_constant(x + i, min, max, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_SSE41 void lerp(const float *a, const float *b, const float *t, float *out, unsigned int count) {
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 va = _mm_loadu_ps(a + i);
+		const __m128 vb = _mm_loadu_ps(b + i);
+		_mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), _mm_loadu_ps(t + i))));
+	}
+	scalar::lerp(a + i, b + i, t + i, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_SSE41 void sdf_sphere(
+		const float *x,
+		const float *y,
+		const float *z,
+		float radius,
+		float *out,
+		unsigned int count
+) {
+	const __m128 vradius = _mm_set1_ps(radius);
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+		const __m128 length_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		_mm_storeu_ps(out + i, _mm_sub_ps(_mm_sqrt_ps(length_sq), vradius));
+	}
+	scalar::sdf_sphere(x + i, y + i, z + i, radius, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_SSE41 void sdf_box(
+		const float *x,
+		const float *y,
+		const float *z,
+		float size_x,
+		float size_y,
+		float size_z,
+		float *out,
+		unsigned int count
+) {
+	const __m128 sign_mask = _mm_set1_ps(-0.f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 vsize_x = _mm_set1_ps(size_x);
+	const __m128 vsize_y = _mm_set1_ps(size_y);
+	const __m128 vsize_z = _mm_set1_ps(size_z);
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 dx = _mm_sub_ps(_mm_andnot_ps(sign_mask, _mm_loadu_ps(x + i)), vsize_x);
+		const __m128 dy = _mm_sub_ps(_mm_andnot_ps(sign_mask, _mm_loadu_ps(y + i)), vsize_y);
+		const __m128 dz = _mm_sub_ps(_mm_andnot_ps(sign_mask, _mm_loadu_ps(z + i)), vsize_z);
+		const __m128 inside = _mm_min_ps(_mm_max_ps(dx, _mm_max_ps(dy, dz)), zero);
+		const __m128 ox = _mm_max_ps(dx, zero);
+		const __m128 oy = _mm_max_ps(dy, zero);
+		const __m128 oz = _mm_max_ps(dz, zero);
+		const __m128 outside_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+		_mm_storeu_ps(out + i, _mm_add_ps(inside, _mm_sqrt_ps(outside_sq)));
+	}
+	scalar::sdf_box(x + i, y + i, z + i, size_x, size_y, size_z, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_SSE41 void sdf_smooth_union(
+		const float *a,
+		const float *b,
+		float smoothness,
+		float *out,
+		unsigned int count
+) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 s = _mm_set1_ps(smoothness);
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 va = _mm_loadu_ps(a + i);
+		const __m128 vb = _mm_loadu_ps(b + i);
+		const __m128 h_unclamped = _mm_add_ps(half, _mm_div_ps(_mm_mul_ps(half, _mm_sub_ps(vb, va)), s));
+		const __m128 h = _mm_min_ps(_mm_max_ps(h_unclamped, zero), one);
+		const __m128 mixed = _mm_add_ps(vb, _mm_mul_ps(_mm_sub_ps(va, vb), h));
+		_mm_storeu_ps(out + i, _mm_sub_ps(mixed, _mm_mul_ps(_mm_mul_ps(s, h), _mm_sub_ps(one, h))));
+	}
+	scalar::sdf_smooth_union(a + i, b + i, smoothness, out + i, count - i);
+}
+
+// 4 3D vectors
+struct Vector3x4 {
+	__m128 x;
+	__m128 y;
+	__m128 z;
+};
+
+ZN_SIMD_TARGET_SSE41 inline Vector3x4 load_vector3(const float *coords, unsigned int stride) {
+	return { _mm_loadu_ps(coords), _mm_loadu_ps(coords + stride), _mm_loadu_ps(coords + 2 * stride) };
+}
+
+ZN_SIMD_TARGET_SSE41 inline Vector3x4 sub3(const Vector3x4 &a, const Vector3x4 &b) {
+	return { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+}
+
+ZN_SIMD_TARGET_SSE41 inline Vector3x4 scale3(const Vector3x4 &a, __m128 s) {
+	return { _mm_mul_ps(a.x, s), _mm_mul_ps(a.y, s), _mm_mul_ps(a.z, s) };
+}
+
+ZN_SIMD_TARGET_SSE41 inline Vector3x4 cross3(const Vector3x4 &a, const Vector3x4 &b) {
+	Vector3x4 r;
+	r.x = _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y));
+	r.y = _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z));
+	r.z = _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x));
+	return r;
+}
+
+ZN_SIMD_TARGET_SSE41 inline __m128 dot3(const Vector3x4 &a, const Vector3x4 &b) {
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+// Squared distance from `p` to the closest point of a triangle edge, where `p` is relative to the start of the edge
+ZN_SIMD_TARGET_SSE41 inline __m128 get_edge_distance_squared(const Vector3x4 &edge, const Vector3x4 &p) {
+	const __m128 t = _mm_div_ps(dot3(edge, p), dot3(edge, edge));
+	const __m128 clamped_t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.f));
+	const Vector3x4 d = sub3(scale3(edge, clamped_t), p);
+	return dot3(d, d);
+}
+
+ZN_SIMD_TARGET_SSE41 void triangle_distance_squared(
+		float px,
+		float py,
+		float pz,
+		const float *coords,
+		unsigned int stride,
+		float *out,
+		unsigned int count
+) {
+	const Vector3x4 p = { _mm_set1_ps(px), _mm_set1_ps(py), _mm_set1_ps(pz) };
+	const __m128 zero = _mm_setzero_ps();
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const Vector3x4 v1 = load_vector3(coords + i, stride);
+		const Vector3x4 v2 = load_vector3(coords + 3 * stride + i, stride);
+		const Vector3x4 v3 = load_vector3(coords + 6 * stride + i, stride);
+
+		const Vector3x4 v21 = sub3(v2, v1);
+		const Vector3x4 v32 = sub3(v3, v2);
+		const Vector3x4 v13 = sub3(v1, v3);
+
+		const Vector3x4 p1 = sub3(p, v1);
+		const Vector3x4 p2 = sub3(p, v2);
+		const Vector3x4 p3 = sub3(p, v3);
+
+		const Vector3x4 nor = cross3(v21, v13);
+
+		// Inside the prism if on the inner side of all edges
+		const __m128 side1 = dot3(cross3(v21, nor), p1);
+		const __m128 side2 = dot3(cross3(v32, nor), p2);
+		const __m128 side3 = dot3(cross3(v13, nor), p3);
+		__m128 inside = _mm_and_ps(_mm_cmpge_ps(side1, zero), _mm_cmpge_ps(side2, zero));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(side3, zero));
+
+		const __m128 nor_p1 = dot3(nor, p1);
+		const __m128 plane_distance_sq = _mm_div_ps(_mm_mul_ps(nor_p1, nor_p1), dot3(nor, nor));
+
+		const __m128 edge_distance_sq = _mm_min_ps(
+				_mm_min_ps(get_edge_distance_squared(v21, p1), get_edge_distance_squared(v32, p2)),
+				get_edge_distance_squared(v13, p3)
+		);
+
+		_mm_storeu_ps(out + i, _mm_blendv_ps(edge_distance_sq, plane_distance_sq, inside));
+	}
+	scalar::triangle_distance_squared(px, py, pz, coords + i, stride, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_SSE41 void sample_table(
+		const float *x,
+		const float *table,
+		unsigned int table_size,
+		float min_x,
+		float max_x,
+		float *out,
+		unsigned int count
+) {
+	const __m128 vmin_x = _mm_set1_ps(min_x);
+	const __m128 vscale = _mm_set1_ps(get_table_scale(table_size, min_x, max_x));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 last_index = _mm_set1_ps(float(table_size - 1));
+	const __m128i max_index = _mm_set1_epi32(table_size - 2);
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 fi = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), vmin_x), vscale);
+		fi = _mm_min_ps(_mm_max_ps(fi, zero), last_index);
+		const __m128i index = _mm_min_epi32(_mm_cvttps_epi32(fi), max_index);
+		const __m128 t = _mm_sub_ps(fi, _mm_cvtepi32_ps(index));
+		// No gather instruction in SSE
+		alignas(16) int32_t indices[4];
+		_mm_store_si128(reinterpret_cast<__m128i *>(indices), index);
+		const __m128 v0 = _mm_setr_ps(table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]]);
+		const __m128 v1 = _mm_setr_ps(
+				table[indices[0] + 1], table[indices[1] + 1], table[indices[2] + 1], table[indices[3] + 1]
+		);
+		_mm_storeu_ps(out + i, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), t)));
+	}
+	scalar::sample_table(x + i, table, table_size, min_x, max_x, out + i, count - i);
+}
+
+} // namespace sse41
+
+namespace avx2 {
+
+#define ZN_SIMD_DEFINE_BINOP_AVX2(m_op, m_name)                                                                        \
+	ZN_SIMD_DEFINE_BINOP(                                                                                              \
+			ZN_SIMD_TARGET_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, m_op, m_name            \
+	)
+
+ZN_SIMD_DEFINE_BINOP_AVX2(_mm256_add_ps, add)
+ZN_SIMD_DEFINE_BINOP_AVX2(_mm256_sub_ps, subtract)
+ZN_SIMD_DEFINE_BINOP_AVX2(_mm256_mul_ps, multiply)
+ZN_SIMD_DEFINE_BINOP_AVX2(_mm256_min_ps, min)
+ZN_SIMD_DEFINE_BINOP_AVX2(_mm256_max_ps, max)
+
+ZN_SIMD_TARGET_AVX2 void subtract_from_constant(float a, const float *b, float *out, unsigned int count) {
+	const __m256 va = _mm256_set1_ps(a);
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(out + i, _mm256_sub_ps(va, _mm256_loadu_ps(b + i)));
+	}
+	scalar::subtract_from_constant(a, b + i, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_AVX2 void clamp(const float *x, const float *min, const float *max, float *out, unsigned int count) {
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256 v = _mm256_max_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(min + i));
+		_mm256_storeu_ps(out + i, _mm256_min_ps(v, _mm256_loadu_ps(max + i)));
+	}
+	scalar::clamp(x + i, min + i, max + i, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_AVX2 void clamp_constant(const float *x, float min, float max, float *out, unsigned int count) {
+	const __m256 vmin = _mm256_set1_ps(min);
+	const __m256 vmax = _mm256_set1_ps(max);
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(x + i), vmin), vmax));
+	}
+	scalar::clamp_constant(x + i, min, max, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_AVX2 void lerp(const float *a, const float *b, const float *t, float *out, unsigned int count) {
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256 va = _mm256_loadu_ps(a + i);
+		const __m256 vb = _mm256_loadu_ps(b + i);
+		// Not using FMA, so results are the same as other implementations
+		_mm256_storeu_ps(out + i, _mm256_add_ps(va, _mm256_mul_ps(_mm256_sub_ps(vb, va), _mm256_loadu_ps(t + i))));
+	}
+	scalar::lerp(a + i, b + i, t + i, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_AVX2 void sdf_sphere(
+		const float *x,
+		const float *y,
+		const float *z,
+		float radius,
+		float *out,
+		unsigned int count
+) {
+	const __m256 vradius = _mm256_set1_ps(radius);
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+		const __m256 length_sq =
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+		_mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_sqrt_ps(length_sq), vradius));
+	}
+	scalar::sdf_sphere(x + i, y + i, z + i, radius, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_AVX2 void sdf_box(
+		const float *x,
+		const float *y,
+		const float *z,
+		float size_x,
+		float size_y,
+		float size_z,
+		float *out,
+		unsigned int count
+) {
+	const __m256 sign_mask = _mm256_set1_ps(-0.f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 vsize_x = _mm256_set1_ps(size_x);
+	const __m256 vsize_y = _mm256_set1_ps(size_y);
+	const __m256 vsize_z = _mm256_set1_ps(size_z);
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256 dx = _mm256_sub_ps(_mm256_andnot_ps(sign_mask, _mm256_loadu_ps(x + i)), vsize_x);
+		const __m256 dy = _mm256_sub_ps(_mm256_andnot_ps(sign_mask, _mm256_loadu_ps(y + i)), vsize_y);
+		const __m256 dz = _mm256_sub_ps(_mm256_andnot_ps(sign_mask, _mm256_loadu_ps(z + i)), vsize_z);
+		const __m256 inside = _mm256_min_ps(_mm256_max_ps(dx, _mm256_max_ps(dy, dz)), zero);
+		const __m256 ox = _mm256_max_ps(dx, zero);
+		const __m256 oy = _mm256_max_ps(dy, zero);
+		const __m256 oz = _mm256_max_ps(dz, zero);
+		const __m256 outside_sq =
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(oz, oz));
+		_mm256_storeu_ps(out + i, _mm256_add_ps(inside, _mm256_sqrt_ps(outside_sq)));
+	}
+	scalar::sdf_box(x + i, y + i, z + i, size_x, size_y, size_z, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_AVX2 void sdf_smooth_union(
+		const float *a,
+		const float *b,
+		float smoothness,
+		float *out,
+		unsigned int count
+) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 s = _mm256_set1_ps(smoothness);
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256 va = _mm256_loadu_ps(a + i);
+		const __m256 vb = _mm256_loadu_ps(b + i);
+		const __m256 h_unclamped =
+				_mm256_add_ps(half, _mm256_div_ps(_mm256_mul_ps(half, _mm256_sub_ps(vb, va)), s));
+		const __m256 h = _mm256_min_ps(_mm256_max_ps(h_unclamped, zero), one);
+		const __m256 mixed = _mm256_add_ps(vb, _mm256_mul_ps(_mm256_sub_ps(va, vb), h));
+		_mm256_storeu_ps(out + i, _mm256_sub_ps(mixed, _mm256_mul_ps(_mm256_mul_ps(s, h), _mm256_sub_ps(one, h))));
+	}
+	scalar::sdf_smooth_union(a + i, b + i, smoothness, out + i, count - i);
+}
+
+// 8 3D vectors
+struct Vector3x8 {
+	__m256 x;
+	__m256 y;
+	__m256 z;
+};
+
+ZN_SIMD_TARGET_AVX2 inline Vector3x8 load_vector3(const float *coords, unsigned int stride) {
+	return { _mm256_loadu_ps(coords), _mm256_loadu_ps(coords + stride), _mm256_loadu_ps(coords + 2 * stride) };
+}
+
+ZN_SIMD_TARGET_AVX2 inline Vector3x8 sub3(const Vector3x8 &a, const Vector3x8 &b) {
+	return { _mm256_sub_ps(a.x, b.x), _mm256_sub_ps(a.y, b.y), _mm256_sub_ps(a.z, b.z) };
+}
+
+ZN_SIMD_TARGET_AVX2 inline Vector3x8 scale3(const Vector3x8 &a, __m256 s) {
+	return { _mm256_mul_ps(a.x, s), _mm256_mul_ps(a.y, s), _mm256_mul_ps(a.z, s) };
+}
+
+ZN_SIMD_TARGET_AVX2 inline Vector3x8 cross3(const Vector3x8 &a, const Vector3x8 &b) {
+	Vector3x8 r;
+	r.x = _mm256_sub_ps(_mm256_mul_ps(a.y, b.z), _mm256_mul_ps(a.z, b.y));
+	r.y = _mm256_sub_ps(_mm256_mul_ps(a.z, b.x), _mm256_mul_ps(a.x, b.z));
+	r.z = _mm256_sub_ps(_mm256_mul_ps(a.x, b.y), _mm256_mul_ps(a.y, b.x));
+	return r;
+}
+
+ZN_SIMD_TARGET_AVX2 inline __m256 dot3(const Vector3x8 &a, const Vector3x8 &b) {
+	return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+}
+
+// Squared distance from `p` to the closest point of a triangle edge, where `p` is relative to the start of the edge
+ZN_SIMD_TARGET_AVX2 inline __m256 get_edge_distance_squared(const Vector3x8 &edge, const Vector3x8 &p) {
+	const __m256 t = _mm256_div_ps(dot3(edge, p), dot3(edge, edge));
+	const __m256 clamped_t = _mm256_min_ps(_mm256_max_ps(t, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+	const Vector3x8 d = sub3(scale3(edge, clamped_t), p);
+	return dot3(d, d);
+}
+
+ZN_SIMD_TARGET_AVX2 void triangle_distance_squared(
+		float px,
+		float py,
+		float pz,
+		const float *coords,
+		unsigned int stride,
+		float *out,
+		unsigned int count
+) {
+	const Vector3x8 p = { _mm256_set1_ps(px), _mm256_set1_ps(py), _mm256_set1_ps(pz) };
+	const __m256 zero = _mm256_setzero_ps();
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const Vector3x8 v1 = load_vector3(coords + i, stride);
+		const Vector3x8 v2 = load_vector3(coords + 3 * stride + i, stride);
+		const Vector3x8 v3 = load_vector3(coords + 6 * stride + i, stride);
+
+		const Vector3x8 v21 = sub3(v2, v1);
+		const Vector3x8 v32 = sub3(v3, v2);
+		const Vector3x8 v13 = sub3(v1, v3);
+
+		const Vector3x8 p1 = sub3(p, v1);
+		const Vector3x8 p2 = sub3(p, v2);
+		const Vector3x8 p3 = sub3(p, v3);
+
+		const Vector3x8 nor = cross3(v21, v13);
+
+		// Inside the prism if on the inner side of all edges
+		const __m256 side1 = dot3(cross3(v21, nor), p1);
+		const __m256 side2 = dot3(cross3(v32, nor), p2);
+		const __m256 side3 = dot3(cross3(v13, nor), p3);
+		__m256 inside = _mm256_and_ps(_mm256_cmp_ps(side1, zero, _CMP_GE_OQ), _mm256_cmp_ps(side2, zero, _CMP_GE_OQ));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(side3, zero, _CMP_GE_OQ));
+
+		const __m256 nor_p1 = dot3(nor, p1);
+		const __m256 plane_distance_sq = _mm256_div_ps(_mm256_mul_ps(nor_p1, nor_p1), dot3(nor, nor));
+
+		const __m256 edge_distance_sq = _mm256_min_ps(
+				_mm256_min_ps(get_edge_distance_squared(v21, p1), get_edge_distance_squared(v32, p2)),
+				get_edge_distance_squared(v13, p3)
+		);
+
+		_mm256_storeu_ps(out + i, _mm256_blendv_ps(edge_distance_sq, plane_distance_sq, inside));
+	}
+	scalar::triangle_distance_squared(px, py, pz, coords + i, stride, out + i, count - i);
+}
+
+ZN_SIMD_TARGET_AVX2 void sample_table(
+		const float *x,
+		const float *table,
+		unsigned int table_size,
+		float min_x,
+		float max_x,
+		float *out,
+		unsigned int count
+) {
+	const __m256 vmin_x = _mm256_set1_ps(min_x);
+	const __m256 vscale = _mm256_set1_ps(get_table_scale(table_size, min_x, max_x));
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 last_index = _mm256_set1_ps(float(table_size - 1));
+	const __m256i max_index = _mm256_set1_epi32(table_size - 2);
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 fi = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), vmin_x), vscale);
+		fi = _mm256_min_ps(_mm256_max_ps(fi, zero), last_index);
+		const __m256i index = _mm256_min_epi32(_mm256_cvttps_epi32(fi), max_index);
+		const __m256 t = _mm256_sub_ps(fi, _mm256_cvtepi32_ps(index));
+		const __m256 v0 = _mm256_i32gather_ps(table, index, 4);
+		const __m256 v1 = _mm256_i32gather_ps(table + 1, index, 4);
+		_mm256_storeu_ps(out + i, _mm256_add_ps(v0, _mm256_mul_ps(_mm256_sub_ps(v1, v0), t)));
+	}
+	scalar::sample_table(x + i, table, table_size, min_x, max_x, out + i, count - i);
+}
+
+} // namespace avx2
+
+#define ZN_SIMD_DISPATCH(m_name, ...)                                                                                  \
+	switch (g_level) {                                                                                                 \
+		case LEVEL_AVX2:                                                                                               \
+			avx2::m_name(__VA_ARGS__);                                                                                 \
+			break;                                                                                                     \
+		case LEVEL_SSE41:                                                                                              \
+			sse41::m_name(__VA_ARGS__);                                                                                \
+			break;                                                                                                     \
+		default:                                                                                                       \
+			scalar::m_name(__VA_ARGS__);                                                                               \
+			break;                                                                                                     \
+	}
+
+#else
+
+#define ZN_SIMD_DISPATCH(m_name, ...) scalar::m_name(__VA_ARGS__);
+
+#endif // ZN_SIMD_X86
+
+Level get_max_supported_level() {
+	return g_max_supported_level;
+}
+
+Level get_level() {
+	return g_level;
+}
+
+void set_level(Level level) {
+	ZN_ASSERT_RETURN(static_cast<unsigned int>(level) < LEVEL_COUNT);
+	g_level = level <= g_max_supported_level ? level : g_max_supported_level;
+}
+
+const char *get_level_name(Level level) {
+	switch (level) {
+		case LEVEL_SCALAR:
+			return "Scalar";
+		case LEVEL_SSE41:
+			return "SSE4.1";
+		case LEVEL_AVX2:
+			return "AVX2";
+		default:
+			ZN_PRINT_ERROR("Unknown SIMD level");
+			return "<unknown>";
+	}
+}
+
+void add(const float *a, const float *b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(add, a, b, out, count);
+}
+
+void add_constant(const float *a, float b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(add_constant, a, b, out, count);
+}
+
+void subtract(const float *a, const float *b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(subtract, a, b, out, count);
+}
+
+void subtract_constant(const float *a, float b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(subtract_constant, a, b, out, count);
+}
+
+void subtract_from_constant(float a, const float *b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(subtract_from_constant, a, b, out, count);
+}
+
+void multiply(const float *a, const float *b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(multiply, a, b, out, count);
+}
+
+void multiply_constant(const float *a, float b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(multiply_constant, a, b, out, count);
+}
+
+void min(const float *a, const float *b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(min, a, b, out, count);
+}
+
+void min_constant(const float *a, float b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(min_constant, a, b, out, count);
+}
+
+void max(const float *a, const float *b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(max, a, b, out, count);
+}
+
+void max_constant(const float *a, float b, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(max_constant, a, b, out, count);
+}
+
+void clamp(const float *x, const float *min, const float *max, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(clamp, x, min, max, out, count);
+}
+
+void clamp_constant(const float *x, float min, float max, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(clamp_constant, x, min, max, out, count);
+}
+
+void lerp(const float *a, const float *b, const float *t, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(lerp, a, b, t, out, count);
+}
+
+void sdf_sphere(const float *x, const float *y, const float *z, float radius, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(sdf_sphere, x, y, z, radius, out, count);
+}
+
+void sdf_box(
+		const float *x,
+		const float *y,
+		const float *z,
+		float size_x,
+		float size_y,
+		float size_z,
+		float *out,
+		unsigned int count
+) {
+	ZN_SIMD_DISPATCH(sdf_box, x, y, z, size_x, size_y, size_z, out, count);
+}
+
+void sdf_smooth_union(const float *a, const float *b, float smoothness, float *out, unsigned int count) {
+	ZN_SIMD_DISPATCH(sdf_smooth_union, a, b, smoothness, out, count);
+}
+
+void triangle_distance_squared(
+		float px,
+		float py,
+		float pz,
+		const float *coords,
+		unsigned int stride,
+		float *out,
+		unsigned int count
+) {
+	ZN_SIMD_DISPATCH(triangle_distance_squared, px, py, pz, coords, stride, out, count);
+}
+
+void sample_table(
+		const float *x,
+		const float *table,
+		unsigned int table_size,
+		float min_x,
+		float max_x,
+		float *out,
+		unsigned int count
+) {
+	ZN_ASSERT_RETURN(table_size >= 2);
+	ZN_SIMD_DISPATCH(sample_table, x, table, table_size, min_x, max_x, out, count);
+}
+
+} // namespace zylann::math::simd
@@ -0,0 +1,93 @@
+#ifndef ZN_MATH_SIMD_H
+#define ZN_MATH_SIMD_H
+
+namespace zylann::math::simd {
+
+// Vectorized kernels processing arrays of floats. They are mainly used by graph nodes, which process buffers of values
+// at once. The best instruction set supported by the CPU is selected at runtime, so the same binary can run on CPUs
+// that don't support it.
+//
+// Unless specified otherwise, all arrays must have at least `count` elements, and `out` may be the same array as one
+// of the inputs. Arrays don't need to be aligned.
+
+enum Level {
+	LEVEL_SCALAR = 0,
+	LEVEL_SSE41,
+	LEVEL_AVX2,
+	LEVEL_COUNT
+};
+
+// Highest instruction set supported by the CPU (and the compiler).
+Level get_max_supported_level();
+// Instruction set currently used by kernels.
+Level get_level();
+// Changes the instruction set used by kernels. It will be clamped to what the CPU supports.
+// Not thread-safe, this is mostly intended for testing and benchmarking.
+void set_level(Level level);
+const char *get_level_name(Level level);
+
+// out = a + b
+void add(const float *a, const float *b, float *out, unsigned int count);
+void add_constant(const float *a, float b, float *out, unsigned int count);
+// out = a - b
+void subtract(const float *a, const float *b, float *out, unsigned int count);
+void subtract_constant(const float *a, float b, float *out, unsigned int count);
+void subtract_from_constant(float a, const float *b, float *out, unsigned int count);
+// out = a * b
+void multiply(const float *a, const float *b, float *out, unsigned int count);
+void multiply_constant(const float *a, float b, float *out, unsigned int count);
+// out = min(a, b), with the same behavior as `math::min`
+void min(const float *a, const float *b, float *out, unsigned int count);
+void min_constant(const float *a, float b, float *out, unsigned int count);
+// out = max(a, b), with the same behavior as `math::max`
+void max(const float *a, const float *b, float *out, unsigned int count);
+void max_constant(const float *a, float b, float *out, unsigned int count);
+// out = clamp(x, min, max), with the same behavior as `math::clamp`
+void clamp(const float *x, const float *min, const float *max, float *out, unsigned int count);
+void clamp_constant(const float *x, float min, float max, float *out, unsigned int count);
+// out = a + t * (b - a)
+void lerp(const float *a, const float *b, const float *t, float *out, unsigned int count);
+
+void sdf_sphere(const float *x, const float *y, const float *z, float radius, float *out, unsigned int count);
+void sdf_box(
+		const float *x,
+		const float *y,
+		const float *z,
+		float size_x,
+		float size_y,
+		float size_z,
+		float *out,
+		unsigned int count
+);
+// Smoothness must be greater than zero
+void sdf_smooth_union(const float *a, const float *b, float smoothness, float *out, unsigned int count);
+
+// Squared distances from point (px, py, pz) to triangles, with the same behavior as
+// `math::get_triangle_distance_squared`. Triangles are in structure-of-arrays layout: component `k` of triangle `i` is
+// `coords[k * stride + i]`, where components are x, y and z of the first vertex, then of the second, then of the third.
+// Triangles must not be degenerate.
+void triangle_distance_squared(
+		float px,
+		float py,
+		float pz,
+		const float *coords,
+		unsigned int stride,
+		float *out,
+		unsigned int count
+);
+
+// Samples a table of values evenly spread between `min_x` and `max_x`, with linear interpolation. Values of `x` outside
+// of that range are clamped. `table` must have at least 2 values.
+void sample_table(
+		const float *x,
+		const float *table,
+		unsigned int table_size,
+		float min_x,
+		float max_x,
+		float *out,
+		unsigned int count
+);
+
+} // namespace zylann::math::simd
+
+#endif // ZN_MATH_SIMD_H
@@ -48,6 +48,33 @@ inline float get_triangle_area(Vector3 p0, Vector3 p1, Vector3 p2) {
 	return 0.5 * c.length();
 }
 
+// Squared distance from a point to a triangle.
+// https://iquilezles.org/articles/triangledistance/
+inline float get_triangle_distance_squared(Vector3f p, Vector3f v1, Vector3f v2, Vector3f v3) {
+	const Vector3f v21 = v2 - v1;
+	const Vector3f v32 = v3 - v2;
+	const Vector3f v13 = v1 - v3;
+
+	const Vector3f p1 = p - v1;
+	const Vector3f p2 = p - v2;
+	const Vector3f p3 = p - v3;
+
+	const Vector3f nor = cross(v21, v13);
+
+	if (dot(cross(v21, nor), p1) >= 0.f && dot(cross(v32, nor), p2) >= 0.f && dot(cross(v13, nor), p3) >= 0.f) {
+		// Inside the prism: get distance to plane
+		return squared(dot(nor, p1)) / length_squared(nor);
+	}
+	// Outside of the prism: get distance to closest edge
+	return min(
+			min( //
+					length_squared(v21 * clamp(dot(v21, p1) / length_squared(v21), 0.f, 1.f) - p1),
+					length_squared(v32 * clamp(dot(v32, p2) / length_squared(v32), 0.f, 1.f) - p2)
+			),
+			length_squared(v13 * clamp(dot(v13, p3) / length_squared(v13), 0.f, 1.f) - p3)
+	);
+}
+
 struct TriangleIntersectionResult {
 	enum Case { //
 		INTERSECTION,
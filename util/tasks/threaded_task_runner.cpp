@@ -1,6 +1,7 @@
 #include "threaded_task_runner.h"
 #include "../dstack.h"
 #include "../godot/classes/time.h"
+#include "../math/funcs.h"
 #include "../profiling.h"
 #include "../string/format.h"
 
@@ -24,6 +25,9 @@ ThreadedTaskRunner::~ThreadedTaskRunner() {
 	if (_completed_tasks.size() != 0) {
 		ZN_PRINT_ERROR("There are completed tasks remaining!");
 	}
+	if (_work_stealing_task_count != 0) {
+		ZN_PRINT_ERROR("There are tasks remaining in worker queues!");
+	}
 }
 
 void ThreadedTaskRunner::create_thread(ThreadData &d, uint32_t i) {
@@ -90,24 +94,70 @@ void ThreadedTaskRunner::set_thread_count(uint32_t count) {
 		count = MAX_THREADS;
 	}
 	destroy_all_threads();
-	for (uint32_t i = _thread_count; i < count; ++i) {
+	if (count < _thread_count) {
+		// Queues past the new count would no longer be picked from, nor stolen from
+		move_tasks_from_unused_worker_queues(count);
+	}
+	// All threads have been stopped, so all of them have to start again
+	for (uint32_t i = 0; i < count; ++i) {
 		ThreadData &d = _threads[i];
 		create_thread(d, i);
 	}
 	_thread_count = count;
 }
 
+void ThreadedTaskRunner::move_tasks_from_unused_worker_queues(uint32_t thread_count) {
+	// Same as when enqueuing, there is always at least one queue
+	const uint32_t queue_count = math::max(thread_count, uint32_t(1));
+	StdVector<TaskItem> &items = get_task_items_temp_tls();
+
+	for (uint32_t src_index = queue_count; src_index < MAX_THREADS; ++src_index) {
+		WorkerQueue &src = _worker_queues[src_index];
+		if (src.task_count == 0) {
+			continue;
+		}
+		// Threads are stopped at this point, but tasks could still be getting enqueued
+		{
+			MutexLock lock(src.bands_mutex);
+			for (StdDeque<TaskItem> &band : src.bands) {
+				items.insert(items.end(), band.begin(), band.end());
+				band.clear();
+			}
+			MutexLock lock2(src.incoming_tasks_mutex);
+			append_array(items, src.incoming_tasks);
+			src.incoming_tasks.clear();
+			src.task_count -= items.size();
+		}
+		// Priorities of incoming tasks get evaluated again when they are picked
+		WorkerQueue &dst = _worker_queues[src_index % queue_count];
+		{
+			MutexLock lock(dst.incoming_tasks_mutex);
+			dst.task_count += items.size();
+			append_array(dst.incoming_tasks, items);
+		}
+		items.clear();
+	}
+}
+
 void ThreadedTaskRunner::set_priority_update_period(uint32_t milliseconds) {
 	_priority_update_period_ms = milliseconds;
 }
 
+void ThreadedTaskRunner::set_scheduler_mode(SchedulerMode mode) {
+	ZN_ASSERT_RETURN(mode == SCHEDULER_GLOBAL_QUEUE || mode == SCHEDULER_WORK_STEALING);
+	_scheduler_mode = mode;
+}
+
 void ThreadedTaskRunner::enqueue(IThreadedTask *task, bool serial) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT(task != nullptr);
-	TaskItem t;
-	t.task = task;
-	t.is_serial = serial;
-	{
+	if (_scheduler_mode == SCHEDULER_WORK_STEALING) {
+		enqueue_work_stealing(Span<IThreadedTask *>(&task, 1), serial);
+	} else {
+		TaskItem t;
+		t.task = task;
+		t.is_serial = serial;
+
 		MutexLock lock(_staged_tasks_mutex);
 		_staged_tasks.push_back(t);
 		++_debug_received_tasks;
@@ -127,7 +177,9 @@ void ThreadedTaskRunner::enqueue(Span<IThreadedTask *> new_tasks, bool serial) {
 		ZN_ASSERT(new_tasks[i] != nullptr);
 	}
 #endif
-	{
+	if (_scheduler_mode == SCHEDULER_WORK_STEALING) {
+		enqueue_work_stealing(new_tasks, serial);
+	} else {
 		MutexLock lock(_staged_tasks_mutex);
 		const size_t dst_begin = _staged_tasks.size();
 		_staged_tasks.resize(_staged_tasks.size() + new_tasks.size());
@@ -151,6 +203,281 @@ void ThreadedTaskRunner::enqueue(Span<IThreadedTask *> new_tasks, bool serial) {
 	}
 }
 
+void ThreadedTaskRunner::enqueue_work_stealing(Span<IThreadedTask *> new_tasks, bool serial) {
+	// Count tasks before they can be picked, so threads never see the count going below the actual amount
+	_work_stealing_task_count += new_tasks.size();
+	_debug_received_tasks += new_tasks.size();
+
+#ifdef ZN_THREADED_TASK_RUNNER_CHECK_DUPLICATE_TASKS
+	for (IThreadedTask *task : new_tasks) {
+		debug_add_owned_task(task);
+	}
+#endif
+
+	if (serial) {
+		MutexLock lock(_serial_tasks_mutex);
+		for (IThreadedTask *task : new_tasks) {
+			TaskItem t;
+			t.task = task;
+			t.is_serial = true;
+			_serial_tasks.push(t);
+		}
+		return;
+	}
+
+	// Spread tasks across threads in contiguous chunks, starting from a different thread each time. Tasks scheduled
+	// together are often related, so they may share data that is already in cache.
+	const uint32_t queue_count = math::max(_thread_count, uint32_t(1));
+	const size_t chunk_size = (new_tasks.size() + queue_count - 1) / queue_count;
+	uint32_t queue_index = _next_worker_queue_index.fetch_add(1) % queue_count;
+
+	for (size_t begin = 0; begin < new_tasks.size(); begin += chunk_size) {
+		const size_t end = math::min(begin + chunk_size, new_tasks.size());
+		WorkerQueue &queue = _worker_queues[queue_index];
+		{
+			MutexLock lock(queue.incoming_tasks_mutex);
+			queue.task_count += end - begin;
+			for (size_t i = begin; i < end; ++i) {
+				TaskItem t;
+				t.task = new_tasks[i];
+				queue.incoming_tasks.push_back(t);
+			}
+		}
+		queue_index = (queue_index + 1) % queue_count;
+	}
+}
+
+namespace {
+
+inline unsigned int get_priority_band_index(
+		TaskPriority priority,
+		uint32_t band_priority_min,
+		uint32_t band_priority_max,
+		unsigned int band_count
+) {
+	if (priority.whole <= band_priority_min) {
+		return 0;
+	}
+	if (priority.whole >= band_priority_max) {
+		return band_count - 1;
+	}
+	return (uint64_t(priority.whole - band_priority_min) * band_count) /
+			(uint64_t(band_priority_max - band_priority_min) + 1);
+}
+
+} // namespace
+
+void ThreadedTaskRunner::add_to_worker_queue_bands(WorkerQueue &queue, Span<TaskItem> items) {
+	for (TaskItem &item : items) {
+		item.cached_priority = item.task->get_priority();
+		const unsigned int band_index = get_priority_band_index(
+				item.cached_priority, queue.band_priority_min, queue.band_priority_max, PRIORITY_BAND_COUNT
+		);
+		queue.bands[band_index].push_back(item);
+	}
+}
+
+void ThreadedTaskRunner::update_worker_queue_priorities(
+		WorkerQueue &queue,
+		StdVector<IThreadedTask *> &cancelled_tasks
+) {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<TaskItem> &items = get_task_items_temp_tls();
+	items.clear();
+
+	{
+		MutexLock lock(queue.incoming_tasks_mutex);
+		append_array(items, queue.incoming_tasks);
+		queue.incoming_tasks.clear();
+	}
+	for (StdDeque<TaskItem> &band : queue.bands) {
+		items.insert(items.end(), band.begin(), band.end());
+		band.clear();
+	}
+
+	uint32_t priority_min = 0xffffffff;
+	uint32_t priority_max = 0;
+
+	for (unsigned int i = 0; i < items.size();) {
+		TaskItem &item = items[i];
+		item.cached_priority = item.task->get_priority();
+
+		if (item.task->is_cancelled()) {
+			cancelled_tasks.push_back(item.task);
+			items[i] = items.back();
+			items.pop_back();
+			--queue.task_count;
+			--_work_stealing_task_count;
+			continue;
+		}
+
+		priority_min = math::min(priority_min, item.cached_priority.whole);
+		priority_max = math::max(priority_max, item.cached_priority.whole);
+		++i;
+	}
+
+	if (items.size() > 0) {
+		queue.band_priority_min = priority_min;
+		queue.band_priority_max = priority_max;
+	}
+
+	for (const TaskItem &item : items) {
+		const unsigned int band_index = get_priority_band_index(
+				item.cached_priority, queue.band_priority_min, queue.band_priority_max, PRIORITY_BAND_COUNT
+		);
+		queue.bands[band_index].push_back(item);
+	}
+
+	items.clear();
+}
+
+bool ThreadedTaskRunner::pop_from_worker_queue_bands(WorkerQueue &queue, TaskItem &out_item) {
+	for (unsigned int band_index = PRIORITY_BAND_COUNT; band_index-- > 0;) {
+		StdDeque<TaskItem> &band = queue.bands[band_index];
+		if (band.size() > 0) {
+			// Oldest first, so tasks of the same band don't starve
+			out_item = band.front();
+			band.pop_front();
+			--queue.task_count;
+			--_work_stealing_task_count;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadedTaskRunner::steal_tasks(uint32_t thief_index, StdVector<TaskItem> &out_stolen_tasks) {
+	// Taking more than one task at once makes stealing less frequent
+	static const size_t MAX_STOLEN_TASKS = 32;
+
+	for (uint32_t i = 1; i < _thread_count; ++i) {
+		WorkerQueue &victim = _worker_queues[(thief_index + i) % _thread_count];
+		if (victim.task_count == 0) {
+			continue;
+		}
+
+		// Don't wait for a queue that is busy, another one may have tasks available
+		if (victim.bands_mutex.try_lock()) {
+			for (unsigned int band_index = PRIORITY_BAND_COUNT; band_index-- > 0;) {
+				StdDeque<TaskItem> &band = victim.bands[band_index];
+				if (band.size() == 0) {
+					continue;
+				}
+				// Take half of the highest band, from the end opposite to where its owner picks
+				const size_t count = math::min(math::max(band.size() / 2, size_t(1)), MAX_STOLEN_TASKS);
+				for (size_t j = 0; j < count; ++j) {
+					out_stolen_tasks.push_back(band.back());
+					band.pop_back();
+				}
+				victim.task_count -= count;
+				break;
+			}
+			victim.bands_mutex.unlock();
+
+			if (out_stolen_tasks.size() > 0) {
+				return true;
+			}
+		}
+
+		// Tasks may also be waiting in the incoming list, if the victim has been busy running a long task
+		if (victim.incoming_tasks_mutex.try_lock()) {
+			StdVector<TaskItem> &incoming = victim.incoming_tasks;
+			if (incoming.size() > 0) {
+				const size_t count = math::min(math::max(incoming.size() / 2, size_t(1)), MAX_STOLEN_TASKS);
+				out_stolen_tasks.insert(out_stolen_tasks.end(), incoming.end() - count, incoming.end());
+				incoming.resize(incoming.size() - count);
+				victim.task_count -= count;
+			}
+			victim.incoming_tasks_mutex.unlock();
+
+			if (out_stolen_tasks.size() > 0) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool ThreadedTaskRunner::pick_task_work_stealing(
+		uint32_t thread_index,
+		StdVector<TaskItem> &out_tasks,
+		StdVector<IThreadedTask *> &cancelled_tasks,
+		bool &out_is_serial
+) {
+	ZN_PROFILE_SCOPE();
+
+	// Serial tasks are picked first. Only one thread can run them at a time, so they could otherwise wait a long time
+	// behind the rest.
+	if (_is_serial_task_running == false) {
+		bool expected = false;
+		// This must be the only place it can be set to `true`
+		if (_is_serial_task_running.compare_exchange_strong(expected, true)) {
+			bool picked = false;
+			{
+				MutexLock lock(_serial_tasks_mutex);
+				if (_serial_tasks.size() > 0) {
+					out_tasks.push_back(_serial_tasks.front());
+					_serial_tasks.pop();
+					picked = true;
+				}
+			}
+			if (picked) {
+				--_work_stealing_task_count;
+				out_is_serial = true;
+				return true;
+			}
+			_is_serial_task_running = false;
+		}
+	}
+
+	WorkerQueue &queue = _worker_queues[thread_index];
+	TaskItem item;
+
+	{
+		MutexLock lock(queue.bands_mutex);
+
+		// Priorities are updated periodically like in the global queue, but each thread only does it for its own
+		// tasks, without blocking other threads.
+		const uint64_t now = Time::get_singleton()->get_ticks_msec();
+		if (now - queue.last_priority_update_time_ms > _priority_update_period_ms) {
+			update_worker_queue_priorities(queue, cancelled_tasks);
+			queue.last_priority_update_time_ms = now;
+
+		} else {
+			StdVector<TaskItem> &incoming = get_task_items_temp_tls();
+			{
+				MutexLock lock2(queue.incoming_tasks_mutex);
+				append_array(incoming, queue.incoming_tasks);
+				queue.incoming_tasks.clear();
+			}
+			add_to_worker_queue_bands(queue, to_span(incoming));
+			incoming.clear();
+		}
+
+		if (pop_from_worker_queue_bands(queue, item)) {
+			out_tasks.push_back(item);
+			return true;
+		}
+	}
+
+	StdVector<TaskItem> &stolen_tasks = get_task_items_temp_tls();
+	if (steal_tasks(thread_index, stolen_tasks)) {
+		MutexLock lock(queue.bands_mutex);
+		queue.task_count += stolen_tasks.size();
+		add_to_worker_queue_bands(queue, to_span(stolen_tasks));
+		stolen_tasks.clear();
+
+		if (pop_from_worker_queue_bands(queue, item)) {
+			out_tasks.push_back(item);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void ThreadedTaskRunner::thread_func_static(void *p_data) {
 	ThreadData &data = *static_cast<ThreadData *>(p_data);
 	ThreadedTaskRunner &pool = *data.pool;
@@ -197,7 +524,12 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 				}
 			}
 
-			{
+			if (_scheduler_mode == SCHEDULER_WORK_STEALING) {
+				if (!pick_task_work_stealing(data.index, tasks, cancelled_tasks, is_running_serial_task)) {
+					task_queue_was_empty = _work_stealing_task_count == 0;
+				}
+
+			} else {
 				// TODO When tasks are very short and there are a lot of tasks, one thread can monopolize this mutex.
 				//
 				MutexLock lock(_tasks_mutex);
@@ -421,8 +753,14 @@ void ThreadedTaskRunner::wait_for_all_tasks() {
 			any_staged_tasks = _staged_tasks.size() > 0;
 		}
 		if (!any_staged_tasks) {
-			MutexLock lock(_tasks_mutex);
-			if (_tasks.size() == 0) {
+			bool any_waiting_tasks = false;
+			if (_scheduler_mode == SCHEDULER_WORK_STEALING) {
+				any_waiting_tasks = _work_stealing_task_count > 0;
+			} else {
+				MutexLock lock(_tasks_mutex);
+				any_waiting_tasks = _tasks.size() > 0;
+			}
+			if (!any_waiting_tasks) {
 				MutexLock lock2(_spinning_tasks_mutex);
 				if (_spinning_tasks.size() == 0) {
 					break;
@@ -483,4 +821,9 @@ StdVector<IThreadedTask *> &ThreadedTaskRunner::get_completed_tasks_temp_tls() {
 	return tls_temp;
 }
 
+StdVector<ThreadedTaskRunner::TaskItem> &ThreadedTaskRunner::get_task_items_temp_tls() {
+	static thread_local StdVector<TaskItem> tls_temp;
+	return tls_temp;
+}
+
 } // namespace zylann
@@ -4,6 +4,7 @@
 #include "../containers/container_funcs.h"
 #include "../containers/fixed_array.h"
 #include "../containers/span.h"
+#include "../containers/std_deque.h"
 #include "../containers/std_queue.h"
 #include "../containers/std_vector.h"
 #include "../profiling.h"
@@ -36,6 +37,16 @@ public:
 		STATE_STOPPED
 	};
 
+	enum SchedulerMode {
+		// All threads pick tasks from a single queue, which is periodically sorted by priority. Tasks run closely in
+		// order of priority, but all threads contend on the same lock to pick them.
+		SCHEDULER_GLOBAL_QUEUE = 0,
+		// Each thread has its own queue, where tasks are grouped in a few bands of priority instead of being sorted.
+		// Threads pick tasks from their own queue, and steal from other threads when they run out. Priority order
+		// is approximate, but it scales better when there are many threads and many small tasks.
+		SCHEDULER_WORK_STEALING
+	};
+
 	ThreadedTaskRunner();
 	~ThreadedTaskRunner();
 
@@ -43,8 +54,7 @@ public:
 	// Must be called before configuring thread count.
 	void set_name(const char *name);
 
-	// TODO Add ability to change it while running without skipping tasks
-	// Can't be changed after tasks have been queued
+	// Stops all threads and starts them again, after they finish the task they were running. Queued tasks are kept.
 	void set_thread_count(uint32_t count);
 	uint32_t get_thread_count() const {
 		return _thread_count;
@@ -56,6 +66,12 @@ public:
 	// Can't be changed after tasks have been queued.
 	void set_priority_update_period(uint32_t milliseconds);
 
+	// Can't be changed after tasks have been queued.
+	void set_scheduler_mode(SchedulerMode mode);
+	SchedulerMode get_scheduler_mode() const {
+		return _scheduler_mode;
+	}
+
 	// TODO Expect tasks to be unique ptrs?
 
 	// Schedules a task.
@@ -106,6 +122,8 @@ private:
 		ThreadedTaskContext::Status status = ThreadedTaskContext::STATUS_COMPLETE;
 	};
 
+	static StdVector<TaskItem> &get_task_items_temp_tls();
+
 	struct ThreadData {
 		Thread thread;
 		ThreadedTaskRunner *pool = nullptr;
@@ -127,9 +145,44 @@ private:
 		}
 	};
 
+	// Only used in work-stealing mode.
+	// Priority is not sorted within a band. The range of priorities covered by bands adapts to the tasks in the queue
+	// each time priorities are updated.
+	static const unsigned int PRIORITY_BAND_COUNT = 8;
+
+	struct WorkerQueue {
+		// Tasks whose priority wasn't evaluated yet. This is separate so enqueuing doesn't wait for a thread updating
+		// priorities.
+		StdVector<TaskItem> incoming_tasks;
+		Mutex incoming_tasks_mutex;
+
+		// Tasks grouped by priority. The last band has the highest priority.
+		FixedArray<StdDeque<TaskItem>, PRIORITY_BAND_COUNT> bands;
+		uint32_t band_priority_min = 0;
+		uint32_t band_priority_max = 0xffffffff;
+		uint64_t last_priority_update_time_ms = 0;
+		Mutex bands_mutex;
+
+		// Number of tasks in `incoming_tasks` and `bands`. Allows other threads to skip empty queues without locking.
+		std::atomic_uint32_t task_count = { 0 };
+	};
+
 	static void thread_func_static(void *p_data);
 	void thread_func(ThreadData &data);
 
+	void enqueue_work_stealing(Span<IThreadedTask *> new_tasks, bool serial);
+	bool pick_task_work_stealing(
+			uint32_t thread_index,
+			StdVector<TaskItem> &out_tasks,
+			StdVector<IThreadedTask *> &cancelled_tasks,
+			bool &out_is_serial
+	);
+	void update_worker_queue_priorities(WorkerQueue &queue, StdVector<IThreadedTask *> &cancelled_tasks);
+	void add_to_worker_queue_bands(WorkerQueue &queue, Span<TaskItem> items);
+	bool pop_from_worker_queue_bands(WorkerQueue &queue, TaskItem &out_item);
+	bool steal_tasks(uint32_t thief_index, StdVector<TaskItem> &out_stolen_tasks);
+	void move_tasks_from_unused_worker_queues(uint32_t thread_count);
+
 	void create_thread(ThreadData &d, uint32_t i);
 	void destroy_all_threads();
 
@@ -163,15 +216,26 @@ private:
 	uint32_t _priority_update_period_ms = 32;
 	uint64_t _last_priority_update_time_ms = 0;
 
-	// This boolean is also guarded with `_tasks_mutex`.
+	// In global queue mode, this boolean is also guarded with `_tasks_mutex`.
 	// Tasks marked as "serial" must be executed by only one thread at a time.
-	bool _is_serial_task_running = false;
+	std::atomic_bool _is_serial_task_running = { false };
+
+	SchedulerMode _scheduler_mode = SCHEDULER_GLOBAL_QUEUE;
+
+	// Used in work-stealing mode instead of `_staged_tasks` and `_tasks`.
+	FixedArray<WorkerQueue, MAX_THREADS> _worker_queues;
+	std::atomic_uint32_t _next_worker_queue_index = { 0 };
+	// Serial tasks are not common, so they use a shared queue and run in the order they were scheduled.
+	StdQueue<TaskItem> _serial_tasks;
+	Mutex _serial_tasks_mutex;
+	// Tasks waiting in worker queues or the serial queue, not counting those being run or postponed
+	std::atomic_uint32_t _work_stealing_task_count = { 0 };
 
 	StdString _name;
 
-	unsigned int _debug_received_tasks = 0;
-	unsigned int _debug_completed_tasks = 0;
-	unsigned int _debug_taken_out_tasks = 0;
+	std::atomic_uint32_t _debug_received_tasks = { 0 };
+	std::atomic_uint32_t _debug_completed_tasks = { 0 };
+	std::atomic_uint32_t _debug_taken_out_tasks = { 0 };
 
 #ifdef ZN_THREADED_TASK_RUNNER_CHECK_DUPLICATE_TASKS
 	StdUnorderedMap<IThreadedTask *, StdString> _debug_owned_tasks;
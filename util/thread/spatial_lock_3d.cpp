@@ -5,29 +5,182 @@
 namespace zylann {
 
 SpatialLock3D::SpatialLock3D() {
-	_boxes.reserve(8);
+	for (Shard &shard : _shards) {
+		shard.boxes.reserve(4);
+	}
+}
+
+uint32_t SpatialLock3D::get_shards_mask(const BoxBounds3i &box) {
+	// The max position is included, so boxes that touch without overlapping still share a cell. That matches
+	// `BoxBounds3i::intersects`, which considers them intersecting.
+	const Vector3i min_cell = box.min_pos >> CELL_SIZE_PO2;
+	const Vector3i max_cell = box.max_pos >> CELL_SIZE_PO2;
+
+	// 64-bit because boxes can span the whole range of integers
+	const int64_t cell_count = (int64_t(max_cell.x) - min_cell.x + 1) * (int64_t(max_cell.y) - min_cell.y + 1) *
+			(int64_t(max_cell.z) - min_cell.z + 1);
+	if (cell_count > MAX_CELLS_PER_BOX) {
+		return ALL_SHARDS_MASK;
+	}
+
+	uint32_t mask = 0;
+	Vector3i cell;
+	for (cell.z = min_cell.z; cell.z <= max_cell.z; ++cell.z) {
+		for (cell.x = min_cell.x; cell.x <= max_cell.x; ++cell.x) {
+			for (cell.y = min_cell.y; cell.y <= max_cell.y; ++cell.y) {
+				const uint32_t h = (uint32_t(cell.x) * 73856093u) ^ (uint32_t(cell.y) * 19349663u) ^
+						(uint32_t(cell.z) * 83492791u);
+				mask |= 1u << (h % SHARD_COUNT);
+			}
+		}
+	}
+	return mask;
+}
+
+void SpatialLock3D::lock_shards(uint32_t mask) {
+	// Always in the same order, so threads locking overlapping sets of shards can't deadlock
+	for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+		if ((mask & (1u << i)) != 0) {
+			_shards[i].mutex.lock();
+		}
+	}
+}
+
+void SpatialLock3D::unlock_shards(uint32_t mask) {
+	for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+		if ((mask & (1u << i)) != 0) {
+			_shards[i].mutex.unlock();
+		}
+	}
 }
 
-void SpatialLock3D::remove_box(const BoxBounds3i &box, Mode mode) {
+bool SpatialLock3D::can_lock(const Shard &shard, const BoxBounds3i &box, Mode mode) const {
 #ifdef ZN_SPATIAL_LOCK_3D_CHECKS
 	const Thread::ID thread_id = Thread::get_caller_id();
 #endif
 
-	for (unsigned int i = 0; i < _boxes.size(); ++i) {
-		const Box &existing_box = _boxes[i];
+	for (const Box &existing_box : shard.boxes) {
+#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
+		// Each thread can lock only one box at a time, otherwise there can be deadlocks depending on the order of
+		// locks. For example:
+		// - Thread 1 locks A
+		// - Thread 2 locks B
+		// - Thread 1 locks B, but blocks because it is already locked
+		// - Thread 2 locks A, but blocks because it is already locked:
+		//   This is a deadlock.
+		// Note: this is not true if threads only lock for reading, but if we didn't ever write we'd not use locks.
+		// Note: this is also not true if threads use `try_lock` instead!
+		// Note: only boxes sharing shards with the new one are checked.
+		ZN_ASSERT_RETURN_V_MSG(
+				existing_box.thread_id != thread_id, false, "Locking two areas from the same threads is not allowed"
+		);
+#endif
+		if (existing_box.bounds.intersects(box) && (mode == MODE_WRITE || existing_box.mode == MODE_WRITE)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SpatialLock3D::try_lock(const BoxBounds3i &box, Mode mode) {
+	const uint32_t mask = get_shards_mask(box);
+
+	lock_shards(mask);
+
+	for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+		if ((mask & (1u << i)) != 0 && !can_lock(_shards[i], box, mode)) {
+			unlock_shards(mask);
+			return false;
+		}
+	}
+
+	const Box new_box{ box,
+					   mode,
+#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
+					   Thread::get_caller_id()
+#endif
+	};
+	for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+		if ((mask & (1u << i)) != 0) {
+			_shards[i].boxes.push_back(new_box);
+		}
+	}
+
+	unlock_shards(mask);
+
+	++_locked_boxes_count;
+	return true;
+}
+
+void SpatialLock3D::lock(const BoxBounds3i &box, Mode mode) {
+	while (true) {
+		// Read before trying, so an unlock happening after the attempt isn't missed
+		const uint32_t generation = _unlock_generation.load();
+
+		if (try_lock(box, mode)) {
+			return;
+		}
+
+		++_waiting_threads_count;
+		{
+			std::unique_lock<std::mutex> wlock(_wait_mutex);
+			_wait_condition.wait(wlock, [this, generation]() { return _unlock_generation.load() != generation; });
+		}
+		--_waiting_threads_count;
+	}
+}
+
+bool SpatialLock3D::remove_box(Shard &shard, const BoxBounds3i &box, Mode mode) {
+#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
+	const Thread::ID thread_id = Thread::get_caller_id();
+#endif
+
+	for (unsigned int i = 0; i < shard.boxes.size(); ++i) {
+		const Box &existing_box = shard.boxes[i];
 
 		if (existing_box.bounds == box && existing_box.mode == mode
 #ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-				&& existing_box.thread_id == thread_id
+			&& existing_box.thread_id == thread_id
 #endif
 		) {
-			_boxes[i] = _boxes[_boxes.size() - 1];
-			_boxes.pop_back();
-			return;
+			shard.boxes[i] = shard.boxes.back();
+			shard.boxes.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void SpatialLock3D::unlock(const BoxBounds3i &box, Mode mode) {
+	const uint32_t mask = get_shards_mask(box);
+
+	bool found = true;
+	lock_shards(mask);
+	for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+		if ((mask & (1u << i)) != 0) {
+			found &= remove_box(_shards[i], box, mode);
+		}
+	}
+	unlock_shards(mask);
+
+	if (!found) {
+		// Could be a bug
+		ZN_PRINT_ERROR(format("Could not find box to remove {} with mode {}", box, mode));
+		return;
+	}
+
+	--_locked_boxes_count;
+
+	// Tell eventual waiting threads that they might be able to lock their box now.
+	++_unlock_generation;
+	if (_waiting_threads_count > 0) {
+		// Locking the mutex makes sure a thread that just checked the generation is either already waiting, or will see
+		// the new one.
+		{
+			std::lock_guard<std::mutex> wlock(_wait_mutex);
 		}
+		_wait_condition.notify_all();
 	}
-	// Could be a bug
-	ZN_PRINT_ERROR(format("Could not find box to remove {} with mode {}", box, mode));
 }
 
 } // namespace zylann
@@ -1,13 +1,17 @@
 #ifndef ZN_SPATIAL_LOCK_3D_H
 #define ZN_SPATIAL_LOCK_3D_H
 
+#include "../containers/fixed_array.h"
 #include "../containers/std_vector.h"
 #include "../math/box_bounds_3i.h"
 #include "mutex.h"
-#include "semaphore.h"
 #include "short_lock.h"
 #include "thread.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 #ifdef TOOLS_ENABLED
 #define ZN_SPATIAL_LOCK_3D_CHECKS
 #endif
@@ -24,6 +28,10 @@ namespace zylann {
 //
 // Do not try to lock more than one box at the same time before doing your task. If another thread does so,
 // it could end up in a deadlock depending in the order it happens.
+//
+// Space is divided into coarse cells, which are hashed into a fixed number of shards. Each locked box is registered
+// in the shards of the cells it touches, so threads locking distant areas mostly use different shards and don't
+// contend with each other. Very large boxes are registered in all shards.
 class SpatialLock3D {
 public:
 	enum Mode { //
@@ -42,55 +50,27 @@ public:
 	SpatialLock3D();
 
 	~SpatialLock3D() {
-		ZN_ASSERT_RETURN(_boxes.size() == 0);
+		ZN_ASSERT_RETURN(_locked_boxes_count == 0);
 	}
 
-	bool try_lock_read(const BoxBounds3i &box) {
-		_boxes_mutex.lock();
-		if (can_lock_for_read(box)) {
-			_boxes.push_back(Box{ box, MODE_READ,
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-					Thread::get_caller_id()
-#endif
-			});
-			_boxes_mutex.unlock();
-			return true;
-		} else {
-			_boxes_mutex.unlock();
-			return false;
-		}
+	inline bool try_lock_read(const BoxBounds3i &box) {
+		return try_lock(box, MODE_READ);
 	}
 
-	void lock_read(const BoxBounds3i &box) {
-		while (try_lock_read(box) == false) {
-			_semaphore.wait();
-		}
+	inline void lock_read(const BoxBounds3i &box) {
+		lock(box, MODE_READ);
 	}
 
 	inline void unlock_read(const BoxBounds3i &box) {
 		unlock(box, MODE_READ);
 	}
 
-	bool try_lock_write(const BoxBounds3i &box) {
-		_boxes_mutex.lock();
-		if (can_lock_for_write(box)) {
-			_boxes.push_back(Box{ box, MODE_WRITE,
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-					Thread::get_caller_id()
-#endif
-			});
-			_boxes_mutex.unlock();
-			return true;
-		} else {
-			_boxes_mutex.unlock();
-			return false;
-		}
+	inline bool try_lock_write(const BoxBounds3i &box) {
+		return try_lock(box, MODE_WRITE);
 	}
 
-	void lock_write(const BoxBounds3i &box) {
-		while (try_lock_write(box) == false) {
-			_semaphore.wait();
-		}
+	inline void lock_write(const BoxBounds3i &box) {
+		lock(box, MODE_WRITE);
 	}
 
 	inline void unlock_write(const BoxBounds3i &box) {
@@ -98,8 +78,7 @@ public:
 	}
 
 	inline int get_locked_boxes_count() const {
-		ShortLockScope rlock(_boxes_mutex);
-		return _boxes.size();
+		return _locked_boxes_count;
 	}
 
 	// Scoped helpers
@@ -127,75 +106,48 @@ public:
 	};
 
 private:
-	bool can_lock_for_read(const BoxBounds3i &box) {
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-		const Thread::ID thread_id = Thread::get_caller_id();
-#endif
-
-		for (unsigned int i = 0; i < _boxes.size(); ++i) {
-			const Box &existing_box = _boxes[i];
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-			// Each thread can lock only one box at a time, otherwise there can be deadlocks depending on the order of
-			// locks. For example:
-			// - Thread 1 locks A
-			// - Thread 2 locks B
-			// - Thread 1 locks B, but blocks because it is already locked
-			// - Thread 2 locks A, but blocks because it is already locked:
-			//   This is a deadlock.
-			// Note: this is not true if threads only lock for reading, but if we didn't ever write we'd not use locks.
-			// Note: this is also not true if threads use `try_lock` instead!
-			ZN_ASSERT_RETURN_V_MSG(existing_box.thread_id != thread_id, false,
-					"Locking two areas from the same threads is not allowed");
-#endif
-			if (existing_box.bounds.intersects(box) && existing_box.mode == MODE_WRITE) {
-				return false;
-				break;
-			}
-		}
-		return true;
-	}
+	static const unsigned int SHARD_COUNT = 32;
+	static const uint32_t ALL_SHARDS_MASK = 0xffffffff;
+	// Cells are 4x4x4 in the coordinates of the boxes (usually blocks)
+	static const unsigned int CELL_SIZE_PO2 = 2;
+	// Boxes touching more cells than this are registered in all shards, to bound the cost of computing shards
+	static const unsigned int MAX_CELLS_PER_BOX = 64;
+
+	static_assert(SHARD_COUNT <= 32, "Shard masks are 32-bit");
+
+	// Aligned so shards used by different threads don't share cache lines
+	struct alignas(64) Shard {
+		// List of boxes currently locked in this shard.
+		// In practice, each thread can lock up to 1 box at once (maybe a few more in rare cases that would allow it),
+		// so there won't be many boxes to store.
+		StdVector<Box> boxes;
+		// This lock is supposed to be held for very small periods of time, just to lookup, add or remove boxes.
+		// So we lock it even in `try_*` methods. The long-period locking states are the boxes themselves.
+		// Also it is not recursive for performance. Do not lock it again once you successfully locked it.
+		ShortLock mutex;
+	};
 
-	bool can_lock_for_write(const BoxBounds3i &box) {
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-		const Thread::ID thread_id = Thread::get_caller_id();
-#endif
+	static uint32_t get_shards_mask(const BoxBounds3i &box);
 
-		for (unsigned int i = 0; i < _boxes.size(); ++i) {
-			const Box &existing_box = _boxes[i];
+	void lock_shards(uint32_t mask);
+	void unlock_shards(uint32_t mask);
 
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-			ZN_ASSERT_RETURN_V_MSG(existing_box.thread_id != thread_id, false,
-					"Locking two areas from the same threads is not allowed");
-#endif
-			if (existing_box.bounds.intersects(box)) {
-				return false;
-				break;
-			}
-		}
-		return true;
-	}
+	bool try_lock(const BoxBounds3i &box, Mode mode);
+	void lock(const BoxBounds3i &box, Mode mode);
+	void unlock(const BoxBounds3i &box, Mode mode);
 
-	void remove_box(const BoxBounds3i &box, Mode mode);
+	bool can_lock(const Shard &shard, const BoxBounds3i &box, Mode mode) const;
+	bool remove_box(Shard &shard, const BoxBounds3i &box, Mode mode);
 
-	void unlock(const BoxBounds3i &box, Mode mode) {
-		_boxes_mutex.lock();
-		remove_box(box, mode);
-		_boxes_mutex.unlock();
-		// Tell eventual waiting threads that they might be able to lock their box now.
-		_semaphore.post();
-	}
+	FixedArray<Shard, SHARD_COUNT> _shards;
+	std::atomic_int _locked_boxes_count = { 0 };
 
-	// List of boxes currently locked.
-	// In practice, each thread can lock up to 1 box at once (maybe a few more in rare cases that would allow it), so
-	// there won't be many boxes to store.
-	StdVector<Box> _boxes;
-	// This mutex is supposed to be locked for very small periods of time, just to lookup, add or remove boxes.
-	// So we lock it even in `try_*` methods. The long-period locking states are the boxes themselves.
-	// Also it is not a recursive mutex for performance. Do not lock it again once you successfully locked it.
-	mutable ShortLock _boxes_mutex;
-	// This semaphore is waited for when a lock fails. It is posted everytime a box is unlocked, so any thread
-	// waiting for it may retry locking their box.
-	Semaphore _semaphore;
+	// Threads failing to lock a box wait until another box gets unlocked, then retry. Waiting is done on a condition
+	// variable, and only unlocks done while threads are waiting have to notify it.
+	std::atomic_uint32_t _unlock_generation = { 0 };
+	std::atomic_uint32_t _waiting_threads_count = { 0 };
+	std::mutex _wait_mutex;
+	std::condition_variable _wait_condition;
 };
 
 } // namespace zylann
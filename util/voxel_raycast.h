@@ -201,4 +201,196 @@ bool voxel_raycast(
 	return true;
 }
 
+// Variant of `voxel_raycast` which first goes through a coarser grid, made of cells of `1 << cell_size_po2` voxels.
+// Voxels are only visited inside cells for which `cell_predicate` returns true, so regions known to be empty can be
+// skipped in a few steps. Otherwise, voxels are visited in the same order as `voxel_raycast` and get the same states.
+// Like `voxel_raycast`, the voxel containing the origin is not tested.
+template <typename Vec3f_T, typename CellPredicate_F, typename Predicate_F>
+// cell_predicate(Vector3i cell_position) -> bool, predicate(VoxelRaycastState) -> bool
+bool voxel_raycast_hierarchical(
+		Vec3f_T ray_origin,
+		Vec3f_T ray_direction,
+		const unsigned int cell_size_po2,
+		CellPredicate_F cell_predicate,
+		Predicate_F predicate,
+		real_t max_distance,
+		Vector3i &out_hit_pos,
+		Vector3i &out_prev_pos,
+		float &out_distance_along_ray,
+		float &out_distance_along_ray_prev
+) {
+	ZN_ASSERT_RETURN_V(!math::has_nan(ray_origin), false);
+	ZN_ASSERT_RETURN_V(!math::has_nan(ray_direction), false);
+	ZN_ASSERT_RETURN_V(!math::is_nan(max_distance), false);
+	ZN_ASSERT_RETURN_V(math::is_normalized(ray_direction), false);
+
+	const float g_infinite = 9999999;
+	const int cell_size = 1 << cell_size_po2;
+
+	// Same as `voxel_raycast`, with arrays so axes can be handled in loops
+	float origin[3];
+	int step[3];
+	float tdelta[3];
+	float tcross[3];
+	Vector3i hit_pos = math::floor_to_int(ray_origin);
+
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		origin[axis] = ray_origin[axis];
+		const float d = ray_direction[axis];
+		step[axis] = d > 0 ? 1 : d < 0 ? -1 : 0;
+		tdelta[axis] = step[axis] != 0 ? 1.f / Math::abs(d) : g_infinite;
+
+		if (step[axis] == 1) {
+			tcross[axis] = (Math::ceil(origin[axis]) - origin[axis]) * tdelta[axis];
+		} else if (step[axis] == -1) {
+			tcross[axis] = (origin[axis] - Math::floor(origin[axis])) * tdelta[axis];
+		} else {
+			tcross[axis] = g_infinite;
+		}
+
+		// Workaround for integer positions, see `voxel_raycast`
+		if (tcross[axis] == 0.0) {
+			tcross[axis] += tdelta[axis];
+			if (step[axis] == -1) {
+				hit_pos[axis] -= 1;
+			}
+		}
+	}
+
+	// Distance along the ray where it leaves a cell
+	auto get_cell_exit_distance = [&origin, &step, &tdelta, g_infinite, cell_size_po2](
+										  const Vector3i cell_pos, unsigned int &out_axis
+								  ) {
+		float exit_distance = g_infinite;
+		out_axis = 0;
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			float d;
+			if (step[axis] == 1) {
+				d = (float((cell_pos[axis] + 1) << cell_size_po2) - origin[axis]) * tdelta[axis];
+			} else if (step[axis] == -1) {
+				d = (origin[axis] - float(cell_pos[axis] << cell_size_po2)) * tdelta[axis];
+			} else {
+				continue;
+			}
+			if (d < exit_distance) {
+				exit_distance = d;
+				out_axis = axis;
+			}
+		}
+		return exit_distance;
+	};
+
+	// Distance along the ray where it enters a voxel
+	auto get_voxel_entry_distance = [&origin, &step, &tdelta](const Vector3i pos) {
+		float entry_distance = 0.f;
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			float d;
+			if (step[axis] == 1) {
+				d = (float(pos[axis]) - origin[axis]) * tdelta[axis];
+			} else if (step[axis] == -1) {
+				d = (origin[axis] - float(pos[axis] + 1)) * tdelta[axis];
+			} else {
+				continue;
+			}
+			entry_distance = math::max(entry_distance, d);
+		}
+		return entry_distance;
+	};
+
+	Vector3i hit_prev_pos = hit_pos;
+	float t = 0.f;
+	float t_prev = 0.f;
+	// The voxel containing the origin is not tested
+	bool test_current_voxel = false;
+
+	Vector3i cell_pos = hit_pos >> cell_size_po2;
+
+	while (true) {
+		if (!cell_predicate(cell_pos)) {
+			// Skip the whole cell, and go to the first voxel of the next one
+			unsigned int exit_axis;
+			const float exit_distance = get_cell_exit_distance(cell_pos, exit_axis);
+			if (exit_distance > max_distance) {
+				return false;
+			}
+
+			const Vector3i cell_min = cell_pos << cell_size_po2;
+			for (unsigned int axis = 0; axis < 3; ++axis) {
+				if (axis == exit_axis) {
+					hit_pos[axis] = step[axis] == 1 ? cell_min[axis] + cell_size : cell_min[axis] - 1;
+				} else {
+					// Clamped in case of precision issues
+					hit_pos[axis] = math::clamp(
+							int(Math::floor(origin[axis] + ray_direction[axis] * exit_distance)),
+							cell_min[axis],
+							cell_min[axis] + cell_size - 1
+					);
+				}
+				if (step[axis] == 1) {
+					tcross[axis] = (float(hit_pos[axis] + 1) - origin[axis]) * tdelta[axis];
+				} else if (step[axis] == -1) {
+					tcross[axis] = (origin[axis] - float(hit_pos[axis])) * tdelta[axis];
+				}
+			}
+
+			hit_prev_pos = hit_pos;
+			hit_prev_pos[exit_axis] -= step[exit_axis];
+			t_prev = get_voxel_entry_distance(hit_prev_pos);
+			t = exit_distance;
+
+			test_current_voxel = true;
+			cell_pos = hit_pos >> cell_size_po2;
+			continue;
+		}
+
+		if (test_current_voxel && predicate(VoxelRaycastState{ hit_prev_pos, t_prev, hit_pos, t })) {
+			break;
+		}
+		test_current_voxel = true;
+
+		// Step through voxels of the cell. Same as `voxel_raycast`.
+		bool hit = false;
+		while (true) {
+			unsigned int axis;
+			if (tcross[0] < tcross[1]) {
+				axis = tcross[0] < tcross[2] ? 0 : 2;
+			} else {
+				axis = tcross[1] < tcross[2] ? 1 : 2;
+			}
+			if (tcross[axis] > max_distance) {
+				return false;
+			}
+
+			hit_prev_pos = hit_pos;
+			t_prev = t;
+			hit_pos[axis] += step[axis];
+			t = tcross[axis];
+			tcross[axis] += tdelta[axis];
+
+			const Vector3i next_cell_pos = hit_pos >> cell_size_po2;
+			if (next_cell_pos != cell_pos) {
+				// The new voxel will be tested if its cell passes
+				cell_pos = next_cell_pos;
+				break;
+			}
+
+			if (predicate(VoxelRaycastState{ hit_prev_pos, t_prev, hit_pos, t })) {
+				hit = true;
+				break;
+			}
+		}
+
+		if (hit) {
+			break;
+		}
+	}
+
+	out_hit_pos = hit_pos;
+	out_prev_pos = hit_prev_pos;
+	out_distance_along_ray = t;
+	out_distance_along_ray_prev = t_prev;
+
+	return true;
+}
+
 } // namespace zylann